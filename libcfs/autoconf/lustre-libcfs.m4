@@ -388,6 +388,21 @@ shrinker_count_objects, [
 ])
 ]) # LIBCFS_SHRINKER_COUNT
 
+#
+# Kernel version 3.13 added llist_reverse_order()
+#
+AC_DEFUN([LIBCFS_LLIST_REVERSE_ORDER], [
+LB_CHECK_COMPILE([if 'llist_reverse_order' exists],
+llist_reverse_order, [
+	#include <linux/llist.h>
+],[
+	llist_reverse_order(NULL);
+],[
+	AC_DEFINE(HAVE_LLIST_REVERSE_ORDER, 1,
+		[llist_reverse_order() is available])
+])
+]) # LIBCFS_LLIST_REVERSE_ORDER
+
 #
 # Kernel version 3.17 changed hlist_add_after to
 # hlist_add_behind
@@ -777,6 +792,24 @@ get_user_pages_gup_flags, [
 ])
 ]) # LIBCFS_GET_USER_PAGES_GUP_FLAGS
 
+#
+# Kernel version 4.8 introduced rhashtable_walk_enter(), which cannot fail,
+# to replace rhashtable_walk_init()
+#
+AC_DEFUN([LIBCFS_RHASHTABLE_WALK_ENTER], [
+LB_CHECK_COMPILE([if 'rhashtable_walk_enter' exists],
+rhashtable_walk_enter, [
+	#include <linux/rhashtable.h>
+],[
+	struct rhashtable_iter iter;
+
+	rhashtable_walk_enter(NULL, &iter);
+],[
+	AC_DEFINE(HAVE_RHASHTABLE_WALK_ENTER, 1,
+		[rhashtable_walk_enter() is available])
+])
+]) # LIBCFS_RHASHTABLE_WALK_ENTER
+
 #
 # Kernel version 4.10 commit 7b737965b33188bd3dbb44e938535c4006d97fbb
 # libcfs: Convert to hotplug state machine
@@ -947,6 +980,8 @@ LIBCFS_KTIME_AFTER
 LIBCFS_KTIME_BEFORE
 LIBCFS_KTIME_COMPARE
 LIBCFS_SHRINKER_COUNT
+# 3.13
+LIBCFS_LLIST_REVERSE_ORDER
 # 3.17
 LIBCFS_HLIST_ADD_AFTER
 LIBCFS_TIMESPEC64
@@ -978,6 +1013,7 @@ LIBCFS_GET_USER_PAGES_6ARG
 LIBCFS_STRINGHASH
 # 4.8
 LIBCFS_STACKTRACE_OPS
+LIBCFS_RHASHTABLE_WALK_ENTER
 # 4.9
 LIBCFS_GET_USER_PAGES_GUP_FLAGS
 # 4.10
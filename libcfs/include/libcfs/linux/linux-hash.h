@@ -102,4 +102,12 @@ static inline void *rhashtable_lookup_get_insert_fast(
 }
 #endif /* !HAVE_RHASHTABLE_LOOKUP_GET_INSERT_FAST */
 
+#ifndef HAVE_RHASHTABLE_WALK_ENTER
+static inline void rhashtable_walk_enter(struct rhashtable *ht,
+					 struct rhashtable_iter *iter)
+{
+	rhashtable_walk_init(ht, iter);
+}
+#endif /* !HAVE_RHASHTABLE_WALK_ENTER */
+
 #endif /* __LIBCFS_LINUX_HASH_H__ */
@@ -24,6 +24,7 @@
 #define __LIBCFS_LINUX_LIST_H__
 
 #include <linux/list.h>
+#include <linux/llist.h>
 
 #ifdef HAVE_HLIST_FOR_EACH_3ARG
 #define cfs_hlist_for_each_entry(tpos, pos, head, member) \
@@ -49,4 +50,21 @@
 #define hlist_add_behind(hnode, tail)	hlist_add_after(tail, hnode)
 #endif /* HAVE_HLIST_ADD_AFTER */
 
+#ifndef HAVE_LLIST_REVERSE_ORDER
+static inline struct llist_node *llist_reverse_order(struct llist_node *head)
+{
+	struct llist_node *new_head = NULL;
+
+	while (head) {
+		struct llist_node *tmp = head;
+
+		head = head->next;
+		tmp->next = new_head;
+		new_head = tmp;
+	}
+
+	return new_head;
+}
+#endif /* !HAVE_LLIST_REVERSE_ORDER */
+
 #endif /* __LIBCFS_LINUX_LIST_H__ */
@@ -1729,6 +1729,23 @@ vfs_unlink_3args, [
 ])
 ]) # LC_VFS_UNLINK_3ARGS
 
+#
+# LC_NOTIFY_CHANGE_3ARGS
+#
+# 3.13 has notify_change with 3 args
+#
+AC_DEFUN([LC_NOTIFY_CHANGE_3ARGS], [
+LB_CHECK_COMPILE([if Linux kernel has 'notify_change' with 3 args],
+notify_change_3args, [
+	#include <linux/fs.h>
+],[
+	notify_change(NULL, NULL, NULL);
+], [
+	AC_DEFINE(HAVE_NOTIFY_CHANGE_3ARGS, 1,
+		[kernel has notify_change with 3 args])
+])
+]) # LC_NOTIFY_CHANGE_3ARGS
+
 #
 # LC_HAVE_BVEC_ITER
 #
@@ -2115,6 +2132,41 @@ iov_iter_rw, [
 ])
 ]) # LC_IOV_ITER_RW
 
+#
+# LC_HAVE_AIO_COMPLETE
+#
+# 4.1 kernel removed aio_complete(), asynchronous I/O is completed
+# through kiocb->ki_complete() instead
+#
+AC_DEFUN([LC_HAVE_AIO_COMPLETE], [
+LB_CHECK_COMPILE([if 'aio_complete()' exists],
+aio_complete, [
+	#include <linux/aio.h>
+],[
+	aio_complete(NULL, 0, 0);
+],[
+	AC_DEFINE(HAVE_AIO_COMPLETE, 1,
+		[aio_complete exist])
+])
+]) # LC_HAVE_AIO_COMPLETE
+
+#
+# LC_HAVE_INODE_DIO_BEGIN
+#
+# 4.1 kernel added inode_dio_begin() and inode_dio_end()
+#
+AC_DEFUN([LC_HAVE_INODE_DIO_BEGIN], [
+LB_CHECK_COMPILE([if 'inode_dio_begin()' exists],
+inode_dio_begin, [
+	#include <linux/fs.h>
+],[
+	inode_dio_begin(NULL);
+],[
+	AC_DEFINE(HAVE_INODE_DIO_BEGIN, 1,
+		[inode_dio_begin exist])
+])
+]) # LC_HAVE_INODE_DIO_BEGIN
+
 #
 # LC_HAVE_SYNC_READ_WRITE
 #
@@ -3150,6 +3202,7 @@ AC_DEFUN([LC_PROG_LINUX], [
 	# 3.13
 	LC_VFS_RENAME_5ARGS
 	LC_VFS_UNLINK_3ARGS
+	LC_NOTIFY_CHANGE_3ARGS
 
 	# 3.14
 	LC_HAVE_BVEC_ITER
@@ -3187,6 +3240,8 @@ AC_DEFUN([LC_PROG_LINUX], [
 
 	# 4.1.0
 	LC_IOV_ITER_RW
+	LC_HAVE_AIO_COMPLETE
+	LC_HAVE_INODE_DIO_BEGIN
 	LC_HAVE_SYNC_READ_WRITE
 	LC_HAVE___BI_CNT
 
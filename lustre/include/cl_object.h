@@ -874,6 +874,19 @@ struct cl_page_operations {
 	 */
 	void (*cpo_page_touch)(const struct lu_env *env,
 			       const struct cl_page_slice *slice, size_t to);
+	/**
+	 * Prepare a cached page for a fast write, done without a cl_io: check
+	 * that a granted write lock covers the page, up to EOF for an append,
+	 * and queue the page into the write-back cache, taking grant for it,
+	 * unless it is there already. Nothing may block on the servers here.
+	 *
+	 * \retval         0: the page can be written;
+	 * \retval -ENODATA: the page has to go through the full cl_io.
+	 *
+	 * \see cl_page_fast_write()
+	 */
+	int (*cpo_fast_write)(const struct lu_env *env,
+			      const struct cl_page_slice *slice, bool append);
         /**
          * Page destruction.
          */
@@ -1412,6 +1425,11 @@ enum cl_io_type {
 	 * To give advice about access of a file
 	 */
 	CIT_LADVISE,
+	/**
+	 * fallocate(2) handling
+	 * To preallocate space for a range of a file on the OSTs
+	 */
+	CIT_FALLOCATE,
         CIT_OP_NR
 };
 
@@ -1846,6 +1864,15 @@ struct cl_io {
 			enum lu_ladvise_type	 li_advice;
 			__u64			 li_flags;
 		} ci_ladvise;
+		struct cl_fallocate_io {
+			/** range to preallocate, end is exclusive */
+			__u64			 fa_start;
+			__u64			 fa_end;
+			/** file system level fid */
+			struct lu_fid		*fa_fid;
+			/** FALLOC_FL_* flags */
+			int			 fa_mode;
+		} ci_fallocate;
         } u;
         struct cl_2queue     ci_queue;
         size_t               ci_nob;
@@ -1898,7 +1925,12 @@ struct cl_io {
 	 * mirror is inaccessible, non-delay RPC would error out quickly so
 	 * that the upper layer can try to access the next mirror.
 	 */
-			     ci_ndelay:1;
+			     ci_ndelay:1,
+	/**
+	 * Set by the background readahead workers, the IO only populates
+	 * the page cache and is not accounted to the worker thread.
+	 */
+			     ci_async_readahead:1;
 	/**
 	 * How many times the read has retried before this one.
 	 * Set by the top level and consumed by the LOV.
@@ -2224,6 +2256,8 @@ int     cl_page_is_vmlocked(const struct lu_env *env,
 			    const struct cl_page *pg);
 void	cl_page_touch(const struct lu_env *env, const struct cl_page *pg,
 		      size_t to);
+int	cl_page_fast_write(const struct lu_env *env, struct cl_page *pg,
+			   bool append);
 void    cl_page_export(const struct lu_env *env,
 		       struct cl_page *pg, int uptodate);
 loff_t  cl_offset(const struct cl_object *obj, pgoff_t idx);
@@ -2435,6 +2469,7 @@ void cl_page_list_assume (const struct lu_env *env,
 void cl_page_list_discard(const struct lu_env *env,
                           struct cl_io *io, struct cl_page_list *plist);
 void cl_page_list_fini   (const struct lu_env *env, struct cl_page_list *plist);
+void cl_page_list_delete(const struct lu_env *env, struct cl_page_list *plist);
 
 void cl_2queue_init     (struct cl_2queue *queue);
 void cl_2queue_add      (struct cl_2queue *queue, struct cl_page *page);
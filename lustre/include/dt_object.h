@@ -1391,6 +1391,59 @@ struct dt_body_operations {
 			     __u64 start,
 			     __u64 end,
 			     enum lu_ladvise_type advice);
+
+	/**
+	 * Declare intention to preallocate space for an object.
+	 *
+	 * Notify the underlying filesystem that space may be allocated in
+	 * this transaction. This enables the layer below to prepare resources
+	 * (e.g. journal credits in ext4) and to reserve quota for the given
+	 * region. This method should be called between creating the
+	 * transaction and starting it.
+	 *
+	 * \param[in] env	execution environment for this thread
+	 * \param[in] dt	object
+	 * \param[in] start	the start of the region to preallocate
+	 * \param[in] end	the end of the region to preallocate
+	 * \param[in] mode	fallocate mode, FALLOC_FL_* flags
+	 * \param[in] th	transaction handle
+	 *
+	 * \retval 0		on success
+	 * \retval negative	negated errno on error
+	 */
+	int   (*dbo_declare_fallocate)(const struct lu_env *env,
+				       struct dt_object *dt,
+				       __u64 start,
+				       __u64 end,
+				       int mode,
+				       struct thandle *th);
+
+	/**
+	 * Preallocate specified region in an object.
+	 *
+	 * This method is used to allocate space for the given region of the
+	 * object without writing data into it, the allocated space reads back
+	 * as zeroes. The size of the object is not changed, this is left to
+	 * the caller. If the layer implementing this method is responsible
+	 * for quota, then the method should maintain space accounting for the
+	 * given credentials.
+	 *
+	 * \param[in] env	execution environment for this thread
+	 * \param[in] dt	object
+	 * \param[in] start	the start of the region to preallocate
+	 * \param[in] end	the end of the region to preallocate
+	 * \param[in] mode	fallocate mode, FALLOC_FL_* flags
+	 * \param[in] th	transaction handle
+	 *
+	 * \retval 0		on success
+	 * \retval negative	negated errno on error
+	 */
+	int   (*dbo_fallocate)(const struct lu_env *env,
+			       struct dt_object *dt,
+			       __u64 start,
+			       __u64 end,
+			       int mode,
+			       struct thandle *th);
 };
 
 /**
@@ -2497,6 +2550,31 @@ static inline int dt_ladvise(const struct lu_env *env, struct dt_object *dt,
 	return dt->do_body_ops->dbo_ladvise(env, dt, start, end, advice);
 }
 
+static inline int dt_declare_fallocate(const struct lu_env *env,
+				       struct dt_object *dt, __u64 start,
+				       __u64 end, int mode, struct thandle *th)
+{
+	LASSERT(dt);
+	if (dt->do_body_ops == NULL)
+		return -EPROTO;
+	if (dt->do_body_ops->dbo_declare_fallocate == NULL)
+		return -EOPNOTSUPP;
+	return dt->do_body_ops->dbo_declare_fallocate(env, dt, start, end,
+						      mode, th);
+}
+
+static inline int dt_fallocate(const struct lu_env *env, struct dt_object *dt,
+			       __u64 start, __u64 end, int mode,
+			       struct thandle *th)
+{
+	LASSERT(dt);
+	if (dt->do_body_ops == NULL)
+		return -EPROTO;
+	if (dt->do_body_ops->dbo_fallocate == NULL)
+		return -EOPNOTSUPP;
+	return dt->do_body_ops->dbo_fallocate(env, dt, start, end, mode, th);
+}
+
 static inline int dt_fiemap_get(const struct lu_env *env, struct dt_object *d,
 				struct fiemap *fm)
 {
@@ -352,6 +352,8 @@ enum {
         PTLRPC_REQACTIVE_CNTR,
         PTLRPC_TIMEOUT,
         PTLRPC_REQBUF_AVAIL_CNTR,
+	PTLRPC_PTLRPCD_WAIT_CNTR,
+	PTLRPC_RS_QUEUE_CNTR,
         PTLRPC_LAST_CNTR
 };
 
@@ -171,7 +171,10 @@ struct lu_target {
 	unsigned int		 lut_syncjournal:1,
 				 lut_sync_lock_cancel:2,
 				 /* e.g. OST node */
-				 lut_no_reconstruct:1;
+				 lut_no_reconstruct:1,
+				 /* commit remote sub transactions of
+				  * distribute transaction asynchronously */
+				 lut_dist_txn_async:1;
 	/** last_rcvd file */
 	struct dt_object	*lut_last_rcvd;
 	/* transaction callbacks */
@@ -399,6 +402,8 @@ static inline bool tgt_is_multimodrpcs_client(struct obd_export *exp)
 
 /* target/tgt_handler.c */
 int tgt_request_handle(struct ptlrpc_request *req);
+int tgt_sub_request_handle(struct tgt_session_info *tsi,
+			   struct ptlrpc_request *sub);
 char *tgt_name(struct lu_target *tgt);
 void tgt_counter_incr(struct obd_export *exp, int opcode);
 int tgt_connect_check_sptlrpc(struct ptlrpc_request *req,
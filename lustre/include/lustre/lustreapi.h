@@ -330,6 +330,9 @@ int llapi_find(char *path, struct find_param *param);
 int llapi_file_fget_mdtidx(int fd, int *mdtidx);
 int llapi_dir_set_default_lmv(const char *name,
 			      const struct llapi_stripe_param *param);
+int llapi_dir_set_default_lmv_placement(const char *name,
+			const struct llapi_stripe_param *param,
+			enum lmv_placement_policy placement);
 int llapi_dir_set_default_lmv_stripe(const char *name, int stripe_offset,
 				     int stripe_count, int stripe_pattern,
 				     const char *pool_name);
@@ -448,6 +451,9 @@ int llapi_changelog_clear(const char *mdtname, const char *idstr,
 			  long long endrec);
 extern int llapi_changelog_set_xflags(void *priv,
 				    enum changelog_send_extra_flag extra_flags);
+/* Only receive records matching the given types, FID and user */
+int llapi_changelog_set_filter(void *priv, __u32 type_mask,
+			       const struct lu_fid *fid, uid_t uid);
 
 /* HSM copytool interface.
  * priv is private state, managed internally by these functions
@@ -508,6 +514,16 @@ int llapi_group_unlock(int fd, int gid);
 /* Ladvise */
 int llapi_ladvise(int fd, unsigned long long flags, int num_advise,
 		  struct llapi_lu_ladvise *ladvise);
+
+/* File heat */
+int llapi_heat_get(int fd, struct lu_heat *heat);
+int llapi_heat_set(int fd, __u64 flags);
+
+/* Persistent Client Cache */
+int llapi_pcc_attach(const char *path, __u32 archive_id,
+		     enum lu_pcc_type type);
+int llapi_pcc_detach(const char *path);
+int llapi_pcc_state_get(const char *path, struct lu_pcc_state *state);
 /** @} llapi */
 
 /* llapi_layout user interface */
@@ -877,6 +893,7 @@ static const struct comp_flag_name {
 	{ LCME_FL_PREF_RW,	"prefer" },
 	{ LCME_FL_OFFLINE,	"offline" },
 	{ LCME_FL_NOSYNC,	"nosync" },
+	{ LCME_FL_COMPRESS,	"compress" },
 };
 
 /**
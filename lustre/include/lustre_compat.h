@@ -378,6 +378,12 @@ static inline struct inode *file_inode(const struct file *file)
 #define ll_vfs_unlink(a, b) vfs_unlink(a, b)
 #endif
 
+#ifdef HAVE_NOTIFY_CHANGE_3ARGS
+#define ll_notify_change(a, b) notify_change(a, b, NULL)
+#else
+#define ll_notify_change(a, b) notify_change(a, b)
+#endif
+
 #ifndef HAVE_INODE_LOCK
 # define inode_lock(inode) mutex_lock(&(inode)->i_mutex)
 # define inode_unlock(inode) mutex_unlock(&(inode)->i_mutex)
@@ -649,6 +655,22 @@ __generic_file_write_iter(struct kiocb *iocb, struct iov_iter *iter)
 }
 #endif /* HAVE_FILE_OPERATIONS_READ_WRITE_ITER */
 
+#ifndef HAVE_AIO_COMPLETE
+static inline void aio_complete(struct kiocb *iocb, ssize_t res, ssize_t res2)
+{
+	if (iocb->ki_complete)
+		iocb->ki_complete(iocb, res, res2);
+}
+#endif
+
+#ifndef HAVE_INODE_DIO_BEGIN
+static inline void inode_dio_begin(struct inode *inode)
+{
+	atomic_inc(&inode->i_dio_count);
+}
+# define inode_dio_end(inode)	inode_dio_done(inode)
+#endif
+
 static inline void __user *get_vmf_address(struct vm_fault *vmf)
 {
 #ifdef HAVE_VM_FAULT_ADDRESS
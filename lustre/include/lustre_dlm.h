@@ -44,6 +44,7 @@
 #ifndef _LUSTRE_DLM_H__
 #define _LUSTRE_DLM_H__
 
+#include <libcfs/linux/linux-hash.h>
 #include <lustre_lib.h>
 #include <lustre_net.h>
 #include <lustre_import.h>
@@ -68,6 +69,9 @@ extern struct kset *ldlm_svc_kset;
  * client shows interest in that lock, e.g. glimpse is occured. */
 #define LDLM_DIRTY_AGE_LIMIT (10)
 #define LDLM_DEFAULT_PARALLEL_AST_LIMIT 1024
+/* maximum number of locks in one blocking AST RPC */
+#define LDLM_DEFAULT_BL_AST_BATCH	32
+#define LDLM_MAX_BL_AST_BATCH		256
 
 /**
  * LDLM non-error return states
@@ -331,10 +335,6 @@ struct ldlm_ns_bucket {
 	 * fact the network or overall system load is at fault
 	 */
 	struct adaptive_timeout     nsb_at_estimate;
-	/**
-	 * Which res in the bucket should we start with the reclaim.
-	 */
-	int			    nsb_reclaim_start;
 };
 
 enum {
@@ -384,13 +384,20 @@ struct ldlm_namespace {
 	/** name of this namespace */
 	char			*ns_name;
 
-	/** Resource hash table for namespace. */
-	struct cfs_hash		*ns_rs_hash;
+	/**
+	 * Resource hash table for namespace, looked up under RCU and
+	 * resized incrementally.
+	 */
+	struct rhashtable	ns_rs_hash;
+
+	/** Buckets of resources sharing an adaptive timeout estimate. */
+	struct ldlm_ns_bucket	*ns_rs_buckets;
+	unsigned int		ns_rs_bucket_bits;
 
 	/** serialize */
 	spinlock_t		ns_lock;
 
-	/** big refcount (by bucket) */
+	/** big refcount (by resource) */
 	atomic_t		ns_bref;
 
 	/**
@@ -511,6 +518,16 @@ struct ldlm_namespace {
 	/** Limit of parallel AST RPC count. */
 	unsigned		ns_max_parallel_ast;
 
+	/**
+	 * Server only: maximum number of locks of one export whose blocking
+	 * ASTs are sent in the same RPC, 1 disables the batching.
+	 */
+	unsigned		ns_max_bl_ast_batch;
+	/** Server only: number of blocking AST RPCs sent. */
+	atomic64_t		ns_bl_ast_rpcs;
+	/** Server only: number of locks in the blocking AST RPCs sent. */
+	atomic64_t		ns_bl_ast_locks;
+
 	/**
 	 * Callback to check if a lock is good to be canceled by ELC or
 	 * during recovery.
@@ -527,7 +544,7 @@ struct ldlm_namespace {
 	unsigned		ns_stopping:1;
 
 	/**
-	 * Which bucket should we start with the lock reclaim.
+	 * Which resource should we start with the lock reclaim.
 	 */
 	int			ns_reclaim_start;
 
@@ -610,6 +627,20 @@ struct ldlm_bl_desc {
 		     bl_cos_incompat:1;
 };
 
+/**
+ * Blocking ASTs of several locks of the same export packed into one
+ * LDLM_BL_CALLBACK RPC, see ldlm_work_bl_ast_lock().
+ */
+struct ldlm_bl_batch {
+	struct ptlrpc_request	*blb_req;
+	/** number of locks added to the RPC so far */
+	int			 blb_count;
+	/** number of lock handles the RPC has room for */
+	int			 blb_max;
+	/** locks in the RPC, a reference is held on each of them */
+	struct ldlm_lock	*blb_locks[0];
+};
+
 struct ldlm_cb_set_arg {
 	struct ptlrpc_request_set	*set;
 	int				 type; /* LDLM_{CP,BL,GL}_CALLBACK */
@@ -619,11 +650,13 @@ struct ldlm_cb_set_arg {
 	ptlrpc_interpterer_t		 gl_interpret_reply;
 	void				*gl_interpret_data;
 	struct ldlm_bl_desc		*bl_desc;
+	struct ldlm_bl_batch		*bl_batch; /* blocking AST batch */
 };
 
 struct ldlm_cb_async_args {
 	struct ldlm_cb_set_arg	*ca_set_arg;
 	struct ldlm_lock	*ca_lock;
+	struct ldlm_bl_batch	*ca_batch;
 };
 
 /** The ldlm_glimpse_work was slab allocated & must be freed accordingly.*/
@@ -650,6 +683,23 @@ struct ldlm_interval_tree {
 	struct interval_node	*lit_root; /* actual ldlm_interval */
 };
 
+/* number of inode bits, see MDS_INODELOCK_* */
+#define MDS_INODELOCK_NUMBITS	(MDS_INODELOCK_MAXSHIFT + 1)
+
+/**
+ * Granted IBITS locks of a resource sorted by inode bit and lock mode, so
+ * that conflicts are looked for only among the locks sharing a bit with the
+ * new lock. A lock is linked in the lists of each of its bits.
+ */
+struct ldlm_ibits_queues {
+	struct list_head	liq_granted[MDS_INODELOCK_NUMBITS][LCK_MODE_NUM];
+};
+
+struct ldlm_ibits_node {
+	struct list_head	lin_link[MDS_INODELOCK_NUMBITS];
+	struct ldlm_lock	*lin_lock;
+};
+
 /** Whether to track references to exports by LDLM locks. */
 #define LUSTRE_TRACKS_LOCK_EXP_REFS (0)
 
@@ -749,6 +799,11 @@ struct ldlm_lock {
 	 * Tree node for ldlm_extent.
 	 */
 	struct ldlm_interval	*l_tree_node;
+	/**
+	 * Links of a granted lock in the per-bit lists of its resource,
+	 * for IBITS locks on the server only.
+	 */
+	struct ldlm_ibits_node	*l_ibits_node;
 	/**
 	 * Per export hash of locks.
 	 * Protected by per-bucket exp->exp_lock_hash locks.
@@ -978,11 +1033,11 @@ struct lustre_handle_array {
 struct ldlm_resource {
 	struct ldlm_ns_bucket	*lr_ns_bucket;
 
-	/**
-	 * List item for list in namespace hash.
-	 * protected by ns_lock
-	 */
-	struct hlist_node	lr_hash;
+	/** Linkage in the namespace hash. */
+	struct rhash_head	lr_hash;
+
+	/** Used to free the resource after the RCU grace period. */
+	struct rcu_head		lr_rcu;
 
 	/** Reference count for this resource */
 	atomic_t		lr_refcount;
@@ -1009,6 +1064,12 @@ struct ldlm_resource {
 	 */
 	struct ldlm_interval_tree *lr_itree;
 
+	/**
+	 * Granted locks by inode bit and mode (only for IBITS locks on the
+	 * server side)
+	 */
+	struct ldlm_ibits_queues *lr_ibits_queues;
+
 	union {
 		/**
 		 * When the resource was considered as contended,
@@ -1288,6 +1349,8 @@ int ldlm_resource_foreach(struct ldlm_resource *res, ldlm_iterator_t iter,
 			  void *closure);
 void ldlm_namespace_foreach(struct ldlm_namespace *ns, ldlm_iterator_t iter,
 			    void *closure);
+int ldlm_namespace_res_foreach(struct ldlm_namespace *ns,
+			       ldlm_res_iterator_t iter, void *closure);
 int ldlm_resource_iterate(struct ldlm_namespace *, const struct ldlm_res_id *,
 			  ldlm_iterator_t iter, void *data);
 /** @} ldlm_iterator */
@@ -1299,6 +1362,10 @@ int ldlm_flock_completion_ast(struct ldlm_lock *lock, __u64 flags, void *data);
 
 /* ldlm_extent.c */
 __u64 ldlm_extent_shift_kms(struct ldlm_lock *lock, __u64 old_kms);
+__u64 ldlm_extent_shrink_kms(struct ldlm_lock *lock, __u64 old_kms);
+bool ldlm_extent_shrink_range(struct ldlm_lock *lock,
+			      const struct ldlm_lock_desc *ld,
+			      struct ldlm_extent *new_ex);
 
 struct ldlm_prolong_args {
 	struct obd_export	*lpa_export;
@@ -1662,6 +1729,7 @@ int ldlm_cli_cancel_list(struct list_head *head, int count,
 int ldlm_inodebits_drop(struct ldlm_lock *lock, __u64 to_drop);
 int ldlm_cli_dropbits(struct ldlm_lock *lock, __u64 drop_bits);
 int ldlm_cli_dropbits_list(struct list_head *converts, __u64 drop_bits);
+int ldlm_cli_shrink(struct ldlm_lock *lock, const struct ldlm_extent *new_ex);
 
 /** @} ldlm_cli_api */
 
@@ -240,6 +240,11 @@ struct obd_export {
 	struct list_head	exp_outstanding_replies;
 	struct list_head	exp_uncommitted_replies;
 	spinlock_t		exp_uncommitted_replies_lock;
+	/**
+	 * Linkage on the queue of a reply handler thread, which releases
+	 * the replies committed since the export was queued in one go.
+	 */
+	struct list_head	exp_commit_list;
 	/** Last committed transno for this export */
 	__u64			exp_last_committed;
 	/** When was last request received */
@@ -455,6 +460,36 @@ static inline int exp_connect_lock_convert(struct obd_export *exp)
 	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_LOCK_CONVERT);
 }
 
+static inline int exp_connect_compress(struct obd_export *exp)
+{
+	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_COMPRESS);
+}
+
+static inline int exp_connect_batch_rpc(struct obd_export *exp)
+{
+	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_BATCH_RPC);
+}
+
+static inline int exp_connect_batch_bl_ast(struct obd_export *exp)
+{
+	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_BATCH_BL_AST);
+}
+
+static inline int exp_connect_extent_shrink(struct obd_export *exp)
+{
+	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_EXTENT_SHRINK);
+}
+
+static inline int exp_connect_dir_placement(struct obd_export *exp)
+{
+	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_DIR_PLACEMENT);
+}
+
+static inline int exp_connect_jump_hash(struct obd_export *exp)
+{
+	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_JUMP_HASH);
+}
+
 extern struct obd_export *class_conn2export(struct lustre_handle *conn);
 
 static inline int exp_connect_archive_id_array(struct obd_export *exp)
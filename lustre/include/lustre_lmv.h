@@ -156,6 +156,33 @@ lmv_hash_fnv1a(unsigned int count, const char *name, int namelen)
 	return do_div(hash, count);
 }
 
+/*
+ * Jump consistent hash (Lamping and Veach, "A Fast, Minimal Memory,
+ * Consistent Hash Algorithm") of FNV-1a name hash. When stripe count grows
+ * from N to N + 1, only 1/(N + 1) of the names move, and they all move to the
+ * new last stripe, while "hash % count" moves almost all of them.
+ *
+ * The floating point division of the original algorithm is replaced by an
+ * integer one, so the result is not the same as that of the reference code,
+ * but it has the same properties.
+ */
+static inline unsigned int
+lmv_hash_jump(unsigned int count, const char *name, int namelen)
+{
+	__u64 key = lustre_hash_fnv_1a_64(name, namelen);
+	__u64 b = 0;
+	__u64 j = 0;
+
+	while (j < count) {
+		b = j;
+		key = key * 2862933555777941757ULL + 1;
+		j = (b + 1) << 31;
+		do_div(j, (__u32)((key >> 33) + 1));
+	}
+
+	return b;
+}
+
 static inline int lmv_name_to_stripe_index(__u32 lmv_hash_type,
 					   unsigned int stripe_count,
 					   const char *name, int namelen)
@@ -174,6 +201,9 @@ static inline int lmv_name_to_stripe_index(__u32 lmv_hash_type,
 	case LMV_HASH_TYPE_FNV_1A_64:
 		idx = lmv_hash_fnv1a(stripe_count, name, namelen);
 		break;
+	case LMV_HASH_TYPE_JUMP:
+		idx = lmv_hash_jump(stripe_count, name, namelen);
+		break;
 	default:
 		idx = -EBADFD;
 		break;
@@ -188,7 +218,8 @@ static inline int lmv_name_to_stripe_index(__u32 lmv_hash_type,
 static inline bool lmv_is_known_hash_type(__u32 type)
 {
 	return (type & LMV_HASH_TYPE_MASK) == LMV_HASH_TYPE_FNV_1A_64 ||
-	       (type & LMV_HASH_TYPE_MASK) == LMV_HASH_TYPE_ALL_CHARS;
+	       (type & LMV_HASH_TYPE_MASK) == LMV_HASH_TYPE_ALL_CHARS ||
+	       (type & LMV_HASH_TYPE_MASK) == LMV_HASH_TYPE_JUMP;
 }
 
 #endif
@@ -76,6 +76,10 @@ struct cat_handle_data {
 	struct list_head	chd_head;
 	struct llog_handle     *chd_current_log;/* currently open log */
 	struct llog_handle     *chd_next_log;	/* llog to be used next */
+	/* client only: changelog filter sent with the requests reading the
+	 * plain logs, see llog_client_next_block() */
+	spinlock_t		chd_chlg_lock;
+	struct llogd_chlg_filter chd_chlg_filter;
 };
 
 struct llog_handle;
@@ -109,6 +113,14 @@ int llog_backup(const struct lu_env *env, struct obd_device *obd,
 int llog_read_header(const struct lu_env *env, struct llog_handle *handle,
 		     const struct obd_uuid *uuid);
 __u64 llog_size(const struct lu_env *env, struct llog_handle *llh);
+bool llog_chlg_filter_match(const struct llogd_chlg_filter *lcf,
+			    const struct changelog_rec *cr);
+
+static inline bool llog_chlg_filter_empty(const struct llogd_chlg_filter *lcf)
+{
+	return lcf->lcf_type_mask == 0 && !(lcf->lcf_flags & LCF_UID) &&
+	       fid_is_zero(&lcf->lcf_fid);
+}
 
 /* llog_process flags */
 #define LLOG_FLAG_NODEAMON 0x0001
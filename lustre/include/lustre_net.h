@@ -51,6 +51,7 @@
  * @{
  */
 #include <linux/kobject.h>
+#include <linux/llist.h>
 #include <linux/uio.h>
 #include <libcfs/libcfs.h>
 #include <lnet/api.h>
@@ -124,6 +125,10 @@
 #endif
 
 #define PTLRPC_NTHRS_INIT	2
+/* default # seconds a thread above the initial count may stay idle */
+#define PTLRPC_THR_IDLE_TIME	300
+/* start a thread for requests waiting longer than this for one, in usec */
+#define PTLRPC_THR_WAIT_USEC	10000
 
 /**
  * Buffer Constants
@@ -580,7 +585,10 @@ typedef int (*set_producer_func)(struct ptlrpc_request_set *, void *);
  */
 struct ptlrpc_request_set {
 	atomic_t		set_refcount;
-	/** number of in queue requests */
+	/**
+	 * number of in queue requests, only used for statistics and to
+	 * balance the load of the ptlrpcd threads
+	 */
 	atomic_t		set_new_count;
 	/** number of uncompleted requests */
 	atomic_t		set_remaining;
@@ -589,13 +597,11 @@ struct ptlrpc_request_set {
 	/** List of requests in the set */
 	struct list_head	set_requests;
 	/**
-	 * Lock for \a set_new_requests manipulations
-	 * locked so that any old caller can communicate requests to
-	 * the set holder who can then fold them into the lock-free set
+	 * Lock-free list of new yet unsent requests, any caller can add
+	 * requests to it and the set holder, or another thread stealing
+	 * them, folds them into the set. Only used with ptlrpcd now.
 	 */
-	spinlock_t		set_new_req_lock;
-	/** List of new yet unsent requests. Only used with ptlrpcd now. */
-	struct list_head	set_new_requests;
+	struct llist_head	set_new_requests;
 
 	/** rq_status of requests that have been freed already */
 	int			set_rc;
@@ -691,6 +697,8 @@ struct ptlrpc_reply_state {
 	 * of no network encryption we jus set \a rs_repbuf to \a rs_msg
 	 */
 	struct lustre_msg	*rs_msg;	/* reply message */
+	/** When the reply was queued for a reply handler thread */
+	ktime_t			rs_queued;
 
 	/** Handles of locks awaiting client reply ACK */
 	struct lustre_handle	rs_locks[RS_MAX_LOCKS];
@@ -776,6 +784,8 @@ struct ptlrpc_cli_req {
 	time64_t			 cr_delay_limit;
 	/** time request was first queued */
 	time64_t			 cr_queued_time;
+	/** time request was added to a ptlrpcd queue in nanoseconds */
+	ktime_t				 cr_queued_ns;
 	/** request sent in nanoseconds */
 	ktime_t				 cr_sent_ns;
 	/** time for request really sent out */
@@ -799,6 +809,8 @@ struct ptlrpc_cli_req {
 	wait_queue_head_t		 cr_set_waitq;
 	/** Link item for request set lists */
 	struct list_head		 cr_set_chain;
+	/** Link item for the new requests list of a ptlrpcd set */
+	struct llist_node		 cr_new_node;
 	/** link to waited ctx */
 	struct list_head		 cr_ctx_chain;
 
@@ -840,6 +852,7 @@ struct ptlrpc_cli_req {
 #define rq_bulk			rq_cli.cr_bulk
 #define rq_delay_limit		rq_cli.cr_delay_limit
 #define rq_queued_time		rq_cli.cr_queued_time
+#define rq_queued_ns		rq_cli.cr_queued_ns
 #define rq_sent_ns		rq_cli.cr_sent_ns
 #define rq_real_sent		rq_cli.cr_sent_out
 #define rq_reply_deadline	rq_cli.cr_reply_deadline
@@ -851,6 +864,7 @@ struct ptlrpc_cli_req {
 #define rq_import_generation	rq_cli.cr_imp_gen
 #define rq_send_state		rq_cli.cr_send_state
 #define rq_set_chain		rq_cli.cr_set_chain
+#define rq_new_node		rq_cli.cr_new_node
 #define rq_ctx_chain		rq_cli.cr_ctx_chain
 #define rq_set			rq_cli.cr_set
 #define rq_set_waitq		rq_cli.cr_set_waitq
@@ -1693,6 +1707,11 @@ struct ptlrpc_service {
 	int				srv_nthrs_cpt_init;
 	/** limit of threads number for each partition */
 	int				srv_nthrs_cpt_limit;
+	/**
+	 * # seconds after which an idle thread beyond srv_nthrs_cpt_init
+	 * stops, 0 to keep all started threads
+	 */
+	int				srv_thread_idle_time;
 	/** Root of debugfs dir tree for this service */
 	struct dentry		       *srv_debugfs_entry;
         /** Pointer to statistic data for this service */
@@ -1776,6 +1795,10 @@ struct ptlrpc_service_part {
 	int				scp_nthrs_stopping;
 	/** # running threads */
 	int				scp_nthrs_running;
+	/** # threads started since the service was set up */
+	__u64				scp_nthrs_started_total;
+	/** # threads stopped because they were idle */
+	__u64				scp_nthrs_stopped_total;
 	/** service threads list */
 	struct list_head		scp_threads;
 
@@ -1832,6 +1855,8 @@ struct ptlrpc_service_part {
 	int				scp_nhreqs_active;
 	/** # hp requests handled */
 	int				scp_hreq_count;
+	/** average time requests waited for a thread, in usec */
+	s64				scp_req_wait_usec;
 
 	/** NRS head for regular requests */
 	struct ptlrpc_nrs		scp_nrs_reg;
@@ -2165,6 +2190,9 @@ int ptlrpc_request_bufs_pack(struct ptlrpc_request *request,
                              __u32 version, int opcode, char **bufs,
                              struct ptlrpc_cli_ctx *ctx);
 void ptlrpc_req_finished(struct ptlrpc_request *request);
+void ptlrpc_sub_req_prep(struct ptlrpc_request *req);
+int ptlrpc_sub_req_reply(struct ptlrpc_request *req, struct lustre_msg *msg,
+			 int len);
 void ptlrpc_req_finished_with_imp_lock(struct ptlrpc_request *request);
 struct ptlrpc_request *ptlrpc_request_addref(struct ptlrpc_request *req);
 struct ptlrpc_bulk_desc *ptlrpc_prep_bulk_imp(struct ptlrpc_request *req,
@@ -2292,6 +2320,11 @@ struct ptlrpc_service_conf {
  */
 void ptlrpc_save_lock(struct ptlrpc_request *req, struct lustre_handle *lock,
 		      int mode, bool no_ack, bool convert_lock);
+struct ptlrpc_request *ptlrpc_sub_req_init(struct ptlrpc_request *req,
+					   struct lustre_msg *msg, int len);
+int ptlrpc_sub_req_reply_copy(struct ptlrpc_request *sub, void *buf,
+			      int buflen);
+void ptlrpc_sub_req_fini(struct ptlrpc_request *sub);
 void ptlrpc_commit_replies(struct obd_export *exp);
 void ptlrpc_dispatch_difficult_reply(struct ptlrpc_reply_state *rs);
 void ptlrpc_schedule_difficult_reply(struct ptlrpc_reply_state *rs);
@@ -2717,6 +2750,8 @@ int llog_origin_handle_read_header(struct ptlrpc_request *req);
 
 /* ptlrpc/llog_client.c */
 extern struct llog_operations llog_client_ops;
+void llog_cat_chlg_filter_set(struct llog_handle *cathandle,
+			      const struct llogd_chlg_filter *lcf);
 /** @} net */
 
 #endif
@@ -565,6 +565,14 @@ struct ptlrpc_nrs_pol_info {
 	 * # RPCs started for dispatch by the policy
 	 */
 	long				pi_req_started;
+	/**
+	 * # RPCs handled by the policy so far
+	 */
+	__u64				pi_req_handled;
+	/**
+	 * # of the handled RPCs which missed their deadline or were shed
+	 */
+	__u64				pi_req_missed;
 	/**
 	 * Is this a fallback policy?
 	 */
@@ -604,6 +612,14 @@ struct ptlrpc_nrs_policy {
 	 * # RPCs started for dispatch by the policy
 	 */
 	long				pol_req_started;
+	/**
+	 * # RPCs handled by the policy so far
+	 */
+	__u64				pol_req_handled;
+	/**
+	 * # of the handled RPCs which missed their deadline or were shed
+	 */
+	__u64				pol_req_missed;
 	/**
 	 * Usage Reference count taken on the policy instance
 	 */
@@ -676,6 +692,7 @@ enum {
 #include <lustre_nrs_crr.h>
 #include <lustre_nrs_orr.h>
 #include <lustre_nrs_delay.h>
+#include <lustre_nrs_deadline.h>
 
 /**
  * NRS request
@@ -701,6 +718,11 @@ struct ptlrpc_nrs_request {
 	unsigned			nr_enqueued:1;
 	unsigned			nr_started:1;
 	unsigned			nr_finalized:1;
+	/**
+	 * Set by the policy when the request cannot meet its deadline, so
+	 * that it is dropped instead of being handled.
+	 */
+	unsigned			nr_shed:1;
 	struct cfs_binheap_node		nr_node;
 
 	/**
@@ -726,6 +748,10 @@ struct ptlrpc_nrs_request {
 		 * Fields for the delay policy
 		 */
 		struct nrs_delay_req	delay;
+		/**
+		 * Fields for the deadline policy
+		 */
+		struct nrs_deadline_req	deadline;
 	} nr_u;
 	/**
 	 * Externally-registering policies may want to use this to allocate
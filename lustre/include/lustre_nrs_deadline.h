@@ -0,0 +1,77 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ *
+ * Network Request Scheduler (NRS) Deadline policy
+ *
+ */
+
+#ifndef _LUSTRE_NRS_DEADLINE_H
+#define _LUSTRE_NRS_DEADLINE_H
+
+/* \name deadline
+ *
+ * Deadline policy
+ * @{
+ */
+
+/**
+ * Private data structure for the deadline policy
+ */
+struct nrs_deadline_data {
+	struct ptlrpc_nrs_resource	 dl_res;
+
+	/**
+	 * Requests are stored in this binheap, sorted by deadline, until they
+	 * are removed for handling.
+	 */
+	struct cfs_binheap		*dl_binheap;
+
+	/**
+	 * Sequence number handed to the next enqueued request, used to keep
+	 * requests with the same deadline in arrival order.
+	 */
+	__u64				 dl_sequence;
+
+	/**
+	 * Whether requests which are not expected to meet their deadline,
+	 * given the queue depth and the service time estimate, are shed
+	 * instead of being handled.
+	 */
+	__u32				 dl_shed;
+};
+
+struct nrs_deadline_req {
+	/**
+	 * Deadline of the request when it was enqueued
+	 */
+	time64_t	dr_deadline;
+	__u64		dr_sequence;
+};
+
+enum nrs_ctl_deadline {
+	NRS_CTL_DEADLINE_RD_SHED = PTLRPC_NRS_CTL_1ST_POL_SPEC,
+	NRS_CTL_DEADLINE_WR_SHED,
+};
+
+/** @} deadline */
+
+#endif
@@ -138,6 +138,11 @@ struct osc_io {
 			   oi_is_active:1;
 	/** how many LRU pages are reserved for this IO */
 	unsigned long	   oi_lru_reserved;
+	/** reserved grant consumed by the pages added to the active extent,
+	 * and grant the active extent saved, not yet moved to the dirty grant
+	 * of the client, see osc_io_extent_release() */
+	unsigned int	   oi_grant_used;
+	unsigned int	   oi_grant_lost;
 
 	/** active extents, we know how many bytes is going to be written,
 	 * so having an active extent will prevent it from being fragmented */
@@ -559,6 +564,8 @@ struct osc_brw_async_args {
 	struct client_obd	*aa_cli;
 	struct list_head	 aa_oaps;
 	struct list_head	 aa_exts;
+	/* bulk pool pages holding the compressed stream, if any */
+	struct page		**aa_compr_pages;
 };
 
 extern struct kmem_cache *osc_lock_kmem;
@@ -594,6 +601,8 @@ int osc_prep_async_page(struct osc_object *osc, struct osc_page *ops,
 			struct page *page, loff_t offset);
 int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 		       struct osc_page *ops);
+int osc_queue_fast_io(const struct lu_env *env, struct osc_page *ops,
+		      struct ldlm_lock *dlmlock);
 int osc_page_cache_add(const struct lu_env *env,
 		       const struct cl_page_slice *slice, struct cl_io *io);
 int osc_teardown_async_page(const struct lu_env *env, struct osc_object *obj,
@@ -672,8 +681,7 @@ int osc_cleanup_common(struct obd_device *obd);
 int osc_set_info_async(const struct lu_env *env, struct obd_export *exp,
 		       u32 keylen, void *key, u32 vallen, void *val,
 		       struct ptlrpc_request_set *set);
-int osc_ldlm_resource_invalidate(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-				 struct hlist_node *hnode, void *arg);
+int osc_ldlm_resource_invalidate(struct ldlm_resource *res, void *arg);
 int osc_reconnect(const struct lu_env *env, struct obd_export *exp,
 		  struct obd_device *obd, struct obd_uuid *cluuid,
 		  struct obd_connect_data *data, void *localdata);
@@ -313,7 +313,9 @@ struct top_multiple_thandle {
 	int			tmt_result;
 	__u32			tmt_magic;
 	size_t			tmt_record_size;
-	__u32			tmt_committed:1;
+	__u32			tmt_committed:1,
+				/* only master sub trans follows th_sync */
+				tmt_async_commit:1;
 };
 
 /* {top,sub}_thandle are used to manage distributed transactions which
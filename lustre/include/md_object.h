@@ -161,7 +161,9 @@ struct md_op_spec {
 		     sp_cr_lookup:1, /* do lookup sanity check or not. */
 		     sp_rm_entry:1,  /* only remove name entry */
 		     sp_permitted:1, /* do not check permission */
-		     sp_migrate_close:1; /* close the file during migrate */
+		     sp_migrate_close:1, /* close the file during migrate */
+		     sp_migrate_nsonly:1, /* migrate dirent only */
+		     sp_dir_split:1; /* dir needs or is being auto split */
 	/** Current lock mode for parent dir where create is performing. */
 	mdl_mode_t sp_cr_mode;
 
@@ -66,7 +66,8 @@ struct lov_oinfo {                 /* per-stripe data structure */
 	int loi_ost_idx;           /* OST stripe index in lov_tgt_desc->tgts */
 	int loi_ost_gen;           /* generation of this loi_ost_idx */
 
-	unsigned long loi_kms_valid:1;
+	unsigned long loi_kms_valid:1,
+		      loi_compress:1; /* compress bulk data on the wire */
 	__u64 loi_kms;             /* known minimum size */
 	struct ost_lvb loi_lvb;
 	struct osc_async_rc     loi_ar;
@@ -159,6 +160,38 @@ enum obd_cl_sem_lock_class {
 	OBD_CLI_SEM_MDCOSC,
 };
 
+/* Bulk compression statistics of a client, see osc compress_stats */
+struct obd_compr_stats {
+	atomic64_t	ocs_rpcs;	/* RPCs compression was tried for */
+	atomic64_t	ocs_raw_bytes;	/* bytes of their niobuf data */
+	atomic64_t	ocs_wire_bytes;	/* bytes of their bulk */
+	atomic64_t	ocs_usecs;	/* time spent (de)compressing */
+};
+
+/* Latency-driven window of the BRW RPCs of a client, see
+ * osc_rpc_window_update(). Protected by cl_loi_list_lock. */
+struct client_rpc_window {
+	u32		rw_rpcs;	/* RPCs in flight allowed */
+	u32		rw_pages;	/* pages per write RPC */
+	u32		rw_samples;	/* RPCs completed in this round */
+	u32		rw_rounds;	/* rounds since the base was measured */
+	u64		rw_round_us;	/* sum of the service times per MB */
+	u64		rw_round_min_us; /* lowest service time in this round */
+	u64		rw_base_us;	/* lowest service time per MB */
+	u64		rw_last_us;	/* average of the last round */
+	unsigned int	rw_enabled:1;
+};
+
+/* Grant and dirty page credits of a client cached on a CPU. They are
+ * already accounted in cl_reserved_grant and cl_dirty_pages, so that pages
+ * can be added to the cache without taking cl_loi_list_lock, see
+ * osc_enter_cache_fast(). */
+struct client_obd_credits {
+	spinlock_t		cc_lock;
+	unsigned int		cc_grant;	/* bytes of reserved grant */
+	unsigned int		cc_dirty;	/* dirty pages */
+};
+
 struct mdc_rpc_lock;
 struct obd_import;
 struct client_obd {
@@ -216,6 +249,8 @@ struct client_obd {
 	 * grant before trying to dirty a page and unreserve the rest.
 	 * See osc_{reserve|unreserve}_grant for details. */
 	long			cl_reserved_grant;
+	/* per-CPU caches of the reserved grant and of the dirty pages */
+	struct client_obd_credits __percpu *cl_credits;
 	struct list_head	cl_cache_waiters; /* waiting for cache/grant */
 	time64_t		cl_next_shrink_grant;	/* seconds */
 	struct list_head	cl_grant_chain;
@@ -260,6 +295,7 @@ struct client_obd {
 	u32			cl_max_pages_per_rpc;
 	u32			cl_max_rpcs_in_flight;
 	u32			cl_max_short_io_bytes;
+	struct client_rpc_window cl_rpc_window;
 	struct obd_histogram	cl_read_rpc_hist;
 	struct obd_histogram	cl_write_rpc_hist;
 	struct obd_histogram	cl_read_page_hist;
@@ -316,6 +352,13 @@ struct client_obd {
 	unsigned long		*cl_mod_tag_bitmap;
 	struct obd_histogram	 cl_mod_rpcs_hist;
 
+	/* getattr intents of statahead waiting to be sent together in a
+	 * MDS_BATCH RPC, see mdc_batch_flush() */
+	spinlock_t		 cl_batch_lock;
+	struct list_head	 cl_batch_list;
+	__u32			 cl_batch_count;
+	__u32			 cl_batch_size;
+
         /* mgc datastruct */
 	struct mutex		  cl_mgc_mutex;
 	struct local_oid_storage *cl_mgc_los;
@@ -333,6 +376,10 @@ struct client_obd {
         __u32                    cl_supp_cksum_types;
         /* checksum algorithm to be used */
 	enum cksum_types	 cl_cksum_type;
+	/* bulk compression types worked out at connect time */
+	enum obd_compr_types	 cl_supp_compr_types;
+	/* bulk compression statistics of reads and writes */
+	struct obd_compr_stats	 cl_compr_stats[2];
 
         /* also protected by the poorly named _loi_list_lock lock above */
         struct osc_async_rc      cl_ar;
@@ -423,15 +470,41 @@ struct lov_obd {
 	struct kobject		*lov_tgts_kobj;
 };
 
+/* MDT selection data for new subdirectories, see lmv_qos.c */
+struct lmv_tgt_qos {
+	__u64			ltq_avail;	/* space/inode availability */
+	__u64			ltq_penalty;	/* current penalty */
+	__u64			ltq_penalty_per_obj; /* penalty decrease
+						      * every dir */
+	__u64			ltq_weight;	/* net weighting */
+	time64_t		ltq_used;	/* last used time, seconds */
+	bool			ltq_usable;	/* statfs data is valid */
+};
+
 struct lmv_tgt_desc {
 	struct obd_uuid		ltd_uuid;
 	struct obd_device	*ltd_obd;
 	struct obd_export	*ltd_exp;
 	__u32			ltd_idx;
 	struct mutex		ltd_fid_mutex;
+	struct lmv_tgt_qos	ltd_qos;
 	unsigned long		ltd_active:1; /* target up for requests */
 };
 
+struct lmv_qos {
+	spinlock_t		lq_lock;	/* protect fields below */
+	time64_t		lq_statfs_age;	/* last statfs refresh */
+	unsigned int		lq_maxage;	/* statfs refresh interval */
+	unsigned int		lq_prio_free;	/* priority for free space */
+	unsigned int		lq_threshold_rr;/* priority for rr */
+	__u32			lq_rr_index;	/* next MDT for round-robin */
+	__u32			lq_usable_count;/* MDTs with statfs data */
+	bool			lq_dirty;	/* recalc qos data */
+	bool			lq_same_space;	/* the MDTs all have approx.
+						 * the same space avail */
+	bool			lq_reset;	/* zero current penalties */
+};
+
 struct lmv_obd {
 	struct lu_client_fld	lmv_fld;
 	spinlock_t		lmv_lock;
@@ -448,6 +521,8 @@ struct lmv_obd {
 
 	struct obd_connect_data	conn_data;
 	struct kobject		*lmv_tgts_kobj;
+
+	struct lmv_qos		lmv_qos;
 };
 
 /* Minimum sector size is 512 */
@@ -887,6 +962,9 @@ struct md_op_data {
 	/* default stripe offset */
 	__u32			op_default_stripe_offset;
 
+	/* default subdirectory placement, enum lmv_placement_policy */
+	__u32			op_default_placement;
+
 	__u32			op_projid;
 
 	/* Used by readdir */
@@ -1105,6 +1183,8 @@ struct md_ops {
 	int (*m_intent_getattr_async)(struct obd_export *,
 				      struct md_enqueue_info *);
 
+	int (*m_batch_flush)(struct obd_export *);
+
         int (*m_revalidate_lock)(struct obd_export *, struct lookup_intent *,
                                  struct lu_fid *, __u64 *bits);
 
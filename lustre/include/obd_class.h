@@ -1729,6 +1729,21 @@ static inline int md_intent_getattr_async(struct obd_export *exp,
 	return MDP(exp->exp_obd, intent_getattr_async)(exp, minfo);
 }
 
+/*
+ * Send the getattr intents queued by md_intent_getattr_async() which have
+ * not been sent yet, they may be held back to batch them in one RPC.
+ */
+static inline int md_batch_flush(struct obd_export *exp)
+{
+	int rc;
+
+	rc = exp_check_ops(exp);
+	if (rc)
+		return rc;
+
+	return MDP(exp->exp_obd, batch_flush)(exp);
+}
+
 static inline int md_revalidate_lock(struct obd_export *exp,
                                      struct lookup_intent *it,
                                      struct lu_fid *fid, __u64 *bits)
@@ -1851,6 +1866,25 @@ struct root_squash_info {
 
 int server_name2index(const char *svname, __u32 *idx, const char **endptr);
 
+/* file heat, decayed exponentially every period */
+struct obd_heat_instance {
+	__u64 ohi_heat;		/* heat decayed up to ohi_time_second */
+	__u64 ohi_time_second;	/* start of the current period */
+	__u64 ohi_count;	/* samples added in the current period */
+};
+
+/* class_obd.c */
+void obd_heat_add(struct obd_heat_instance *instance,
+		  __u64 time_second, __u64 count,
+		  unsigned int weight, unsigned int period_second);
+void obd_heat_decay(struct obd_heat_instance *instance,
+		    __u64 time_second, unsigned int weight,
+		    unsigned int period_second);
+__u64 obd_heat_get(struct obd_heat_instance *instance,
+		   __u64 time_second, unsigned int weight,
+		   unsigned int period_second);
+void obd_heat_clear(struct obd_heat_instance *instance, int count);
+
 /* linux-module.c */
 extern struct miscdevice obd_psdev;
 int obd_ioctl_getdata(char **buf, int *len, void __user *arg);
@@ -0,0 +1,87 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * Compression of the bulk data of BRW RPCs between OSC and OST.
+ *
+ * Only the data on the wire is compressed, it is stored uncompressed on
+ * both sides. The niobuf data of an RPC is cut into chunks of
+ * OBD_COMPR_CHUNK_SIZE bytes that are compressed independently, each of
+ * them prefixed by a struct brw_compr_chunk, into a stream of full pages.
+ */
+
+#ifndef __OBD_COMPR_H
+#define __OBD_COMPR_H
+
+#include <libcfs/libcfs.h>
+#include <uapi/linux/lustre/lustre_idl.h>
+
+#define OBD_COMPR_CHUNK_SIZE	(64 * 1024)
+
+/* Compression algorithm names, also the names of the kernel crypto
+ * algorithms. Must be defined in the same order as the OBD_COMPR_* flags. */
+#define DECLARE_COMPR_NAME const char *compr_name[] = {"lz4", "lzo", \
+	"deflate"}
+
+int obd_compr_init(void);
+void obd_compr_fini(void);
+
+enum obd_compr_types obd_compr_types_supported(void);
+u32 obd_compr_type_pack(enum obd_compr_types compr_types);
+
+static inline enum obd_compr_types obd_compr_type_unpack(u32 o_flags)
+{
+	switch (o_flags & OBD_FL_COMPR_ALL) {
+	case OBD_FL_COMPR_LZ4:
+		return OBD_COMPR_LZ4;
+	case OBD_FL_COMPR_LZO:
+		return OBD_COMPR_LZO;
+	case OBD_FL_COMPR_DEFLATE:
+		return OBD_COMPR_DEFLATE;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+/*
+ * Return the page \a idx of the niobuf data in \a array, with the offset
+ * and length of the data it holds. This lets the OSC brw_page and the OFD
+ * niobuf_local arrays be used without building a page list first.
+ */
+typedef struct page *(*obd_compr_page_f)(void *array, int idx,
+					 unsigned int *offset,
+					 unsigned int *len);
+
+int obd_compress_pages(enum obd_compr_types compr_type, void *array,
+		       int count, obd_compr_page_f page_from,
+		       struct page **stream, int stream_pages);
+int obd_decompress_pages(enum obd_compr_types compr_type,
+			 struct page **stream, int stream_len, void *array,
+			 int count, obd_compr_page_f page_from);
+int obd_compr_copy_pages(struct page **stream, int stream_len, void *array,
+			 int count, obd_compr_page_f page_from,
+			 bool to_stream);
+
+#endif /* __OBD_COMPR_H */
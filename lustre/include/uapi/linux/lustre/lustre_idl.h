@@ -834,6 +834,13 @@ struct ptlrpc_body_v2 {
 #define OBD_CONNECT2_LOCK_CONVERT	0x80ULL /* IBITS lock convert support */
 #define OBD_CONNECT2_ARCHIVE_ID_ARRAY	0x100ULL /* store HSM archive_id in array */
 #define OBD_CONNECT2_SELINUX_POLICY	0x400ULL /* has client SELinux policy */
+#define OBD_CONNECT2_COMPRESS		0x800ULL /* bulk data compression */
+#define OBD_CONNECT2_BATCH_RPC		0x1000ULL /* MDS_BATCH RPC support */
+#define OBD_CONNECT2_BATCH_BL_AST	0x2000ULL /* several locks per BL AST */
+#define OBD_CONNECT2_EXTENT_SHRINK	0x4000ULL /* extent lock shrinking */
+#define OBD_CONNECT2_DIR_PLACEMENT	0x8000ULL /* subdir MDT placement policy */
+#define OBD_CONNECT2_JUMP_HASH		0x10000ULL /* jump hash dir stripes */
+#define OBD_CONNECT2_CHLG_FILTER	0x20000ULL /* MDT filters changelog */
 
 /* XXX README XXX:
  * Please DO NOT add flag values here before first ensuring that this same
@@ -888,7 +895,12 @@ struct ptlrpc_body_v2 {
                                 OBD_CONNECT2_SUM_STATFS | \
 				OBD_CONNECT2_LOCK_CONVERT | \
 				OBD_CONNECT2_DIR_MIGRATE | \
-				OBD_CONNECT2_ARCHIVE_ID_ARRAY)
+				OBD_CONNECT2_ARCHIVE_ID_ARRAY | \
+				OBD_CONNECT2_BATCH_RPC | \
+				OBD_CONNECT2_BATCH_BL_AST | \
+				OBD_CONNECT2_DIR_PLACEMENT | \
+				OBD_CONNECT2_JUMP_HASH | \
+				OBD_CONNECT2_CHLG_FILTER)
 
 #define OST_CONNECT_SUPPORTED  (OBD_CONNECT_SRVLOCK | OBD_CONNECT_GRANT | \
 				OBD_CONNECT_REQPORTAL | OBD_CONNECT_VERSION | \
@@ -909,7 +921,9 @@ struct ptlrpc_body_v2 {
 				OBD_CONNECT_GRANT_PARAM | \
 				OBD_CONNECT_SHORTIO | OBD_CONNECT_FLAGS2)
 
-#define OST_CONNECT_SUPPORTED2 OBD_CONNECT2_LOCKAHEAD
+#define OST_CONNECT_SUPPORTED2 (OBD_CONNECT2_LOCKAHEAD | OBD_CONNECT2_COMPRESS | \
+				OBD_CONNECT2_BATCH_BL_AST | \
+				OBD_CONNECT2_EXTENT_SHRINK)
 
 #define ECHO_CONNECT_SUPPORTED (OBD_CONNECT_FID)
 #define ECHO_CONNECT_SUPPORTED2 0
@@ -952,7 +966,7 @@ struct obd_connect_data {
          * any field after ocd_maxbytes on the receiver without a valid flag
          * may result in out-of-bound memory access and kernel oops. */
 	__u16 ocd_maxmodrpcs;    /* Maximum modify RPCs in parallel */
-	__u16 padding0;          /* added 2.1.0. also fix lustre_swab_connect */
+	__u16 ocd_compr_types;   /* supported bulk compression algorithms */
 	__u32 padding1;          /* added 2.1.0. also fix lustre_swab_connect */
 	__u64 ocd_connect_flags2;
         __u64 padding3;          /* added 2.1.0. also fix lustre_swab_connect */
@@ -998,6 +1012,20 @@ enum cksum_types {
 #define OBD_CKSUM_T10_ALL (OBD_CKSUM_T10IP512 | OBD_CKSUM_T10IP4K | \
 	OBD_CKSUM_T10CRC512 | OBD_CKSUM_T10CRC4K)
 
+/*
+ * Supported bulk compression algorithms.
+ * (16-bit mask stored in obd_connect_data::ocd_compr_types)
+ * Please update DECLARE_COMPR_NAME in obd_compr.h when adding a new
+ * algorithm and also the OBD_FL_COMPR_* flags and OBD_FL_COMPR_ALL.
+ */
+enum obd_compr_types {
+	OBD_COMPR_LZ4		= 0x0001,
+	OBD_COMPR_LZO		= 0x0002,
+	OBD_COMPR_DEFLATE	= 0x0004,
+};
+
+#define OBD_COMPR_ALL (OBD_COMPR_LZ4 | OBD_COMPR_LZO | OBD_COMPR_DEFLATE)
+
 #define OBD_CKSUM_ALL (OBD_CKSUM_CRC32 | OBD_CKSUM_ADLER | OBD_CKSUM_CRC32C | \
 		       OBD_CKSUM_T10_ALL)
 
@@ -1037,6 +1065,7 @@ enum ost_cmd {
         OST_QUOTACTL   = 19,
 	OST_QUOTA_ADJUST_QUNIT = 20, /* not used since 2.4 */
 	OST_LADVISE    = 21,
+	OST_FALLOCATE  = 22,
 	OST_LAST_OPC /* must be < 33 to avoid MDS_GETATTR */
 };
 #define OST_FIRST_OPC  OST_REPLY
@@ -1071,6 +1100,9 @@ enum obdo_flags {
         OBD_FL_NOSPC_BLK    = 0x00100000, /* no more block space on OST */
 	OBD_FL_FLUSH	    = 0x00200000, /* flush pages on the OST */
 	OBD_FL_SHORT_IO	    = 0x00400000, /* short io request */
+	OBD_FL_COMPR_LZ4    = 0x00800000, /* bulk data is LZ4 compressed */
+	OBD_FL_COMPR_LZO    = 0x01000000, /* bulk data is LZO compressed */
+	OBD_FL_COMPR_DEFLATE = 0x01800000, /* bulk data is DEFLATE compressed */
 	/* OBD_FL_LOCAL_MASK = 0xF0000000, was local-only flags until 2.10 */
 
 	/*
@@ -1082,6 +1114,10 @@ enum obdo_flags {
 			      OBD_FL_CKSUM_CRC32C | OBD_FL_CKSUM_T10IP512 |
 			      OBD_FL_CKSUM_T10IP4K | OBD_FL_CKSUM_T10CRC512 |
 			      OBD_FL_CKSUM_T10CRC4K,
+
+	/* Only one compression type per RPC, packed like the checksum type */
+	OBD_FL_COMPR_ALL    = OBD_FL_COMPR_LZ4 | OBD_FL_COMPR_LZO |
+			      OBD_FL_COMPR_DEFLATE,
 };
 
 /*
@@ -1389,6 +1425,19 @@ struct niobuf_remote {
 	__u32	rnb_flags;
 };
 
+/* A compressed bulk (OBD_FL_COMPR_* set in o_flags) is a sequence of
+ * chunks, each of them holding up to OBD_COMPR_CHUNK_SIZE bytes of the
+ * niobuf data and starting with this header, little-endian on the wire. */
+#define BRW_COMPR_MAGIC		0x0BDC0001
+
+struct brw_compr_chunk {
+	__u32	bcc_magic;	/* BRW_COMPR_MAGIC */
+	__u32	bcc_raw_len;	/* bytes of niobuf data in this chunk */
+	__u32	bcc_len;	/* bytes following the header, the data is
+				 * stored uncompressed if equal to bcc_raw_len */
+	__u32	bcc_padding;
+};
+
 /* lock value block communicated between the filter and llite */
 
 /* OST_LVB_ERR_INIT is needed because the return code in rc is
@@ -1625,6 +1674,7 @@ enum mds_cmd {
 	MDS_HSM_CT_REGISTER	= 59,
 	MDS_HSM_CT_UNREGISTER	= 60,
 	MDS_SWAP_LAYOUTS	= 61,
+	MDS_BATCH		= 62,
 	MDS_LAST_OPC
 };
 
@@ -3001,6 +3051,25 @@ struct llogd_body {
         __u64 lgd_cur_offset;
 } __attribute__((packed));
 
+/* Changelog record filter of a reader, sent with LLOG_ORIGIN_HANDLE_NEXT_BLOCK
+ * requests for the plain changelogs when the MDT has OBD_CONNECT2_CHLG_FILTER.
+ * The MDT then replaces each run of records not matching the filter, and of
+ * padding records, by a bare llog_rec_hdr of type LLOG_PAD_MAGIC, where
+ * lrh_index is the first index of the run, lrh_id the number of indexes and
+ * lrh_len the length of the run in the llog chunk. Several full chunks may be
+ * packed in one reply, the reply body describes the first one. */
+struct llogd_chlg_filter {
+	__u32		lcf_type_mask;	/* accepted types (1 << CL_*), 0: all */
+	__u32		lcf_flags;	/* enum llogd_chlg_filter_flags */
+	__u32		lcf_uid;	/* issuer of the records, with LCF_UID */
+	__u32		lcf_padding;
+	struct lu_fid	lcf_fid;	/* target or reference, unless zero */
+};
+
+enum llogd_chlg_filter_flags {
+	LCF_UID		= 0x00000001,
+};
+
 struct llogd_conn_body {
         struct llog_gen         lgdc_gen;
         struct llog_logid       lgdc_logid;
@@ -3051,9 +3120,14 @@ struct obdo {
 						 * brw: grant space consumed on
 						 * the client for the write */
 	__u32			o_projid;
-	__u32			o_padding_4;	/* also fix
+	__u32			o_falloc_mode;	/* fallocate: FALLOC_FL_*
+						 * mode, also fix
+						 * lustre_swab_obdo() */
+	__u32			o_compr_size;	/* brw: bytes of compressed
+						 * bulk data if OBD_FL_COMPR_*
+						 * is set, also fix
 						 * lustre_swab_obdo() */
-	__u64			o_padding_5;
+	__u32			o_padding_5;
 	__u64			o_padding_6;
 };
 
@@ -3497,6 +3571,23 @@ struct out_read_reply {
 	char	orr_data[0];
 };
 
+#define BATCH_UPDATE_REQUEST_MAGIC	0xBADE0001
+#define BATCH_UPDATE_REPLY_MAGIC	0xBADE0002
+/* Header of the sub-requests carried by a MDS_BATCH RPC, or of their
+ * replies. Each of them is a complete lustre_msg following a
+ * batch_update_buffer, padded to 8 bytes. */
+struct batch_update_header {
+	__u32	buh_magic;
+	__u32	buh_count;	/* number of sub-requests */
+	__u32	buh_reply_size;	/* reply size needed by all sub-replies */
+	__u32	buh_padding;
+};
+
+struct batch_update_buffer {
+	__u32	bub_size;	/* size of the lustre_msg that follows */
+	__s32	bub_rc;		/* sub-request status, in replies only */
+};
+
 /** layout swap request structure
  * fid1 and fid2 are in mdt_body
  */
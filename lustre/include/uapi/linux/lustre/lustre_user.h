@@ -477,6 +477,11 @@ struct ll_ioc_lease_id {
 #define LL_IOC_FID2MDTIDX		_IOWR('f', 248, struct lu_fid)
 #define LL_IOC_GETPARENT		_IOWR('f', 249, struct getparent)
 #define LL_IOC_LADVISE			_IOR('f', 250, struct llapi_lu_ladvise)
+#define LL_IOC_HEAT_GET			_IOWR('f', 251, struct lu_heat)
+#define LL_IOC_HEAT_SET			_IOW('f', 252, __u64)
+#define LL_IOC_PCC_ATTACH		_IOW('f', 253, struct lu_pcc_attach)
+#define LL_IOC_PCC_DETACH		_IO('f', 254)
+#define LL_IOC_PCC_STATE		_IOR('f', 255, struct lu_pcc_state)
 
 #ifndef	FS_IOC_FSGETXATTR
 /*
@@ -648,14 +653,16 @@ enum lov_comp_md_entry_flags {
 	LCME_FL_OFFLINE	= 0x00000008,	/* Not used */
 	LCME_FL_INIT	= 0x00000010,	/* instantiated */
 	LCME_FL_NOSYNC	= 0x00000020,	/* FLR: no sync for the mirror */
+	LCME_FL_COMPRESS = 0x00000040,	/* compress bulk data on the wire */
 	LCME_FL_NEG	= 0x80000000	/* used to indicate a negative flag,
 					   won't be stored on disk */
 };
 
 #define LCME_KNOWN_FLAGS	(LCME_FL_NEG | LCME_FL_INIT | LCME_FL_STALE | \
-				 LCME_FL_PREF_RW | LCME_FL_NOSYNC)
+				 LCME_FL_PREF_RW | LCME_FL_NOSYNC | \
+				 LCME_FL_COMPRESS)
 /* The flags can be set by users at mirror creation time. */
-#define LCME_USER_FLAGS		(LCME_FL_PREF_RW)
+#define LCME_USER_FLAGS		(LCME_FL_PREF_RW | LCME_FL_COMPRESS)
 
 /* The flags are for mirrors */
 #define LCME_MIRROR_FLAGS	(LCME_FL_NOSYNC)
@@ -663,7 +670,8 @@ enum lov_comp_md_entry_flags {
 /* These flags have meaning when set in a default layout and will be inherited
  * from the default/template layout set on a directory.
  */
-#define LCME_TEMPLATE_FLAGS	(LCME_FL_PREF_RW | LCME_FL_NOSYNC)
+#define LCME_TEMPLATE_FLAGS	(LCME_FL_PREF_RW | LCME_FL_NOSYNC | \
+				 LCME_FL_COMPRESS)
 
 /* the highest bit in obdo::o_layout_version is used to mark if the file is
  * being resynced. */
@@ -769,14 +777,31 @@ enum lmv_hash_type {
 	LMV_HASH_TYPE_UNKNOWN	= 0,	/* 0 is reserved for testing purpose */
 	LMV_HASH_TYPE_ALL_CHARS = 1,
 	LMV_HASH_TYPE_FNV_1A_64 = 2,
+	LMV_HASH_TYPE_JUMP = 3,		/* jump consistent hash of FNV-1a */
 	LMV_HASH_TYPE_MAX,
 };
 
 #define LMV_HASH_NAME_ALL_CHARS	"all_char"
 #define LMV_HASH_NAME_FNV_1A_64	"fnv_1a_64"
+#define LMV_HASH_NAME_JUMP	"jump"
 
 extern char *mdt_hash_name[LMV_HASH_TYPE_MAX];
 
+/* How a client picks the MDT of a new subdirectory when the default LMV of
+ * its parent doesn't specify a stripe offset. */
+enum lmv_placement_policy {
+	LMV_PLACEMENT_PARENT	= 0,	/* same MDT as the parent */
+	LMV_PLACEMENT_RR	= 1,	/* round-robin over all MDTs */
+	LMV_PLACEMENT_SPACE	= 2,	/* weighted by MDT free space/inodes */
+	LMV_PLACEMENT_MAX,
+};
+
+#define LMV_PLACEMENT_NAME_PARENT	"parent"
+#define LMV_PLACEMENT_NAME_RR		"roundrobin"
+#define LMV_PLACEMENT_NAME_SPACE	"space"
+
+extern char *lmv_placement_name[LMV_PLACEMENT_MAX];
+
 /* Got this according to how get LOV_MAX_STRIPE_COUNT, see above,
  * (max buffer size - lmv+rpc header) / sizeof(struct lmv_user_mds_data) */
 #define LMV_MAX_STRIPE_COUNT 2000  /* ((12 * 4096 - 256) / 24) */
@@ -787,7 +812,7 @@ struct lmv_user_md_v1 {
 	__u32	lum_stripe_offset; /* MDT idx for default dirstripe */
 	__u32	lum_hash_type;     /* Dir stripe policy */
 	__u32	lum_type;	  /* LMV type: default or normal */
-	__u32	lum_padding1;
+	__u32	lum_placement;	  /* default LMV: enum lmv_placement_policy */
 	__u32	lum_padding2;
 	__u32	lum_padding3;
 	char	lum_pool_name[LOV_MAXPOOLNAME + 1];
@@ -2144,6 +2169,74 @@ struct llapi_ladvise_hdr {
 
 #define LAH_COUNT_MAX	(1024)
 
+enum lu_heat_flag_bit {
+	LU_HEAT_FLAG_BIT_INVALID = 0,
+	LU_HEAT_FLAG_BIT_OFF,
+	LU_HEAT_FLAG_BIT_CLEAR,
+};
+
+enum lu_heat_flag {
+	LU_HEAT_FLAG_OFF	= 1ULL << LU_HEAT_FLAG_BIT_OFF,
+	LU_HEAT_FLAG_CLEAR	= 1ULL << LU_HEAT_FLAG_BIT_CLEAR,
+};
+
+enum obd_heat_type {
+	OBD_HEAT_READSAMPLE	= 0,
+	OBD_HEAT_WRITESAMPLE	= 1,
+	OBD_HEAT_READBYTE	= 2,
+	OBD_HEAT_WRITEBYTE	= 3,
+	OBD_HEAT_COUNT
+};
+
+#define LU_HEAT_NAMES {					\
+	[OBD_HEAT_READSAMPLE]	= "readsample",		\
+	[OBD_HEAT_WRITESAMPLE]	= "writesample",	\
+	[OBD_HEAT_READBYTE]	= "readbyte",		\
+	[OBD_HEAT_WRITEBYTE]	= "writebyte",		\
+}
+
+/* File heat returned by LL_IOC_HEAT_GET, lh_count is set by the caller to
+ * the number of lh_heat[] slots it has room for, and is updated to the
+ * number of values actually returned. */
+struct lu_heat {
+	__u32 lh_count;
+	__u32 lh_flags;
+	__u64 lh_heat[0];
+};
+
+/* Persistent Client Cache: a copy of the file data kept on a client-local
+ * file system, which serves the I/O instead of the OSTs while attached. */
+enum lu_pcc_type {
+	LU_PCC_NONE		= 0,
+	LU_PCC_READWRITE	= 1,
+	LU_PCC_MAX
+};
+
+static inline const char *pcc_type2string(enum lu_pcc_type type)
+{
+	switch (type) {
+	case LU_PCC_NONE:
+		return "none";
+	case LU_PCC_READWRITE:
+		return "readwrite";
+	default:
+		return "fault";
+	}
+}
+
+struct lu_pcc_attach {
+	__u32 pcca_type;	/* enum lu_pcc_type */
+	__u32 pcca_id;		/* HSM archive ID of the PCC dataset */
+};
+
+struct lu_pcc_state {
+	__u32	pccs_type;		/* enum lu_pcc_type */
+	__u32	pccs_open_count;	/* opens going to the cached copy */
+	__u32	pccs_id;		/* HSM archive ID of the PCC dataset */
+	__u32	pccs_padding;
+	char	pccs_path[PATH_MAX];	/* path of the cached copy */
+};
+
 /* Shared key */
 enum sk_crypt_alg {
 	SK_CRYPT_INVALID	= -1,
@@ -911,16 +911,10 @@ static enum interval_iter ldlm_kms_shift_cb(struct interval_node *n,
 		RETURN(INTERVAL_ITER_CONT);
 }
 
-/* When a lock is cancelled by a client, the KMS may undergo change if this
- * is the "highest lock".  This function returns the new KMS value, updating
- * it only if we were the highest lock.
- *
- * Caller must hold lr_lock already.
- *
- * NB: A lock on [x,y] protects a KMS of up to y + 1 bytes! */
-__u64 ldlm_extent_shift_kms(struct ldlm_lock *lock, __u64 old_kms)
+/* Find the largest KMS not greater than \a old_kms that the granted locks of
+ * \a res without kms_ignore set still protect. */
+static __u64 ldlm_extent_res_kms(struct ldlm_resource *res, __u64 old_kms)
 {
-	struct ldlm_resource *res = lock->l_resource;
 	struct ldlm_interval_tree *tree;
 	struct ldlm_kms_shift_args args;
 	int idx = 0;
@@ -931,11 +925,6 @@ __u64 ldlm_extent_shift_kms(struct ldlm_lock *lock, __u64 old_kms)
 	args.kms = 0;
 	args.complete = false;
 
-	/* don't let another thread in ldlm_extent_shift_kms race in
-	 * just after we finish and take our lock into account in its
-	 * calculation of the kms */
-	ldlm_set_kms_ignore(lock);
-
 	/* We iterate over the lock trees, looking for the largest kms smaller
 	 * than the current one. */
 	for (idx = 0; idx < LCK_MODE_NUM; idx++) {
@@ -962,8 +951,35 @@ __u64 ldlm_extent_shift_kms(struct ldlm_lock *lock, __u64 old_kms)
 
 	RETURN(args.kms);
 }
+
+/* When a lock is cancelled by a client, the KMS may undergo change if this
+ * is the "highest lock".  This function returns the new KMS value, updating
+ * it only if we were the highest lock.
+ *
+ * Caller must hold lr_lock already.
+ *
+ * NB: A lock on [x,y] protects a KMS of up to y + 1 bytes! */
+__u64 ldlm_extent_shift_kms(struct ldlm_lock *lock, __u64 old_kms)
+{
+	/* don't let another thread in ldlm_extent_shift_kms race in
+	 * just after we finish and take our lock into account in its
+	 * calculation of the kms */
+	ldlm_set_kms_ignore(lock);
+
+	return ldlm_extent_res_kms(lock->l_resource, old_kms);
+}
 EXPORT_SYMBOL(ldlm_extent_shift_kms);
 
+/* Same as ldlm_extent_shift_kms() for a lock shrunk by ldlm_cli_shrink(),
+ * which is still taken into account with its new extent.
+ *
+ * Caller must hold lr_lock already. */
+__u64 ldlm_extent_shrink_kms(struct ldlm_lock *lock, __u64 old_kms)
+{
+	return ldlm_extent_res_kms(lock->l_resource, old_kms);
+}
+EXPORT_SYMBOL(ldlm_extent_shrink_kms);
+
 struct kmem_cache *ldlm_interval_slab;
 struct ldlm_interval *ldlm_interval_alloc(struct ldlm_lock *lock)
 {
@@ -1014,18 +1030,6 @@ struct ldlm_interval *ldlm_interval_detach(struct ldlm_lock *l)
 	return list_empty(&n->li_group) ? n : NULL;
 }
 
-static inline int ldlm_mode_to_index(enum ldlm_mode mode)
-{
-	int index;
-
-	LASSERT(mode != 0);
-	LASSERT(is_power_of_2(mode));
-	for (index = -1; mode != 0; index++, mode >>= 1)
-		/* do nothing */;
-	LASSERT(index < LCK_MODE_NUM);
-	return index;
-}
-
 /** Add newly granted lock into interval tree for the resource. */
 void ldlm_extent_add_lock(struct ldlm_resource *res,
                           struct ldlm_lock *lock)
@@ -1111,6 +1115,183 @@ void ldlm_extent_unlink_lock(struct ldlm_lock *lock)
 	}
 }
 
+/**
+ * Shrink the extent of the granted \a lock to \a new_ex.
+ *
+ * The new extent must be within the current one and still cover the extent
+ * which was requested for the lock. The lock is moved to its new place in
+ * the interval tree, the caller is responsible for reprocessing the locks
+ * which were waiting for the released range.
+ *
+ * Must be called with the resource locked.
+ */
+int ldlm_extent_shrink(struct ldlm_lock *lock, const struct ldlm_extent *new_ex)
+{
+	struct ldlm_resource *res = lock->l_resource;
+	struct ldlm_extent *extent = &lock->l_policy_data.l_extent;
+	struct ldlm_interval *node;
+
+	ENTRY;
+
+	check_res_locked(res);
+	LASSERT(res->lr_type == LDLM_EXTENT);
+
+	if (lock->l_granted_mode != lock->l_req_mode ||
+	    ldlm_is_destroyed(lock))
+		RETURN(-EINVAL);
+
+	if (new_ex->start > new_ex->end ||
+	    !ldlm_extent_contain(extent, new_ex) ||
+	    !ldlm_extent_contain(new_ex, &lock->l_req_extent))
+		RETURN(-EINVAL);
+
+	if (extent->start == new_ex->start && extent->end == new_ex->end)
+		RETURN(0);
+
+	/* the current node of the lock is freed on unlink if the lock is alone
+	 * in its policy group, so allocate the new one first */
+	OBD_SLAB_ALLOC_PTR_GFP(node, ldlm_interval_slab, GFP_ATOMIC);
+	if (node == NULL)
+		RETURN(-ENOMEM);
+	INIT_LIST_HEAD(&node->li_group);
+
+	ldlm_resource_unlink_lock(lock);
+	LASSERT(lock->l_tree_node == NULL);
+
+	extent->start = new_ex->start;
+	extent->end = new_ex->end;
+	ldlm_interval_attach(node, lock);
+	ldlm_extent_add_lock(res, lock);
+
+	LDLM_DEBUG(lock, "extent lock shrunk");
+	RETURN(0);
+}
+
+/**
+ * Find the part of the granted \a lock that can be kept when it conflicts
+ * with the lock described by \a ld, instead of cancelling the whole lock.
+ *
+ * This is the largest range of the lock extent which covers what was
+ * requested for the lock and does not overlap the extent of the blocking
+ * lock, with its page-aligned boundaries, as the pages out of it have to be
+ * flushed.
+ *
+ * \retval true if the lock can be shrunk to \a new_ex
+ * \retval false if the lock has to be cancelled
+ */
+bool ldlm_extent_shrink_range(struct ldlm_lock *lock,
+			      const struct ldlm_lock_desc *ld,
+			      struct ldlm_extent *new_ex)
+{
+	const struct ldlm_extent *extent = &lock->l_policy_data.l_extent;
+	const struct ldlm_extent *req = &lock->l_req_extent;
+	struct ldlm_extent blocking;
+
+	/* ld can be zeroed if passed from ldlm_bl_thread_blwi() */
+	if (ld == NULL || ld->l_req_mode == 0 ||
+	    ld->l_resource.lr_type != LDLM_EXTENT)
+		return false;
+
+	if (lock->l_resource->lr_type != LDLM_EXTENT ||
+	    lock->l_conn_export == NULL ||
+	    !exp_connect_extent_shrink(lock->l_conn_export) ||
+	    lock->l_granted_mode != lock->l_req_mode ||
+	    lock->l_granted_mode == LCK_GROUP ||
+	    ld->l_req_mode == LCK_GROUP)
+		return false;
+
+	blocking.start = ld->l_policy_data.l_extent.start;
+	blocking.end = ld->l_policy_data.l_extent.end;
+	if (ldlm_extent_overlap(&blocking, req) ||
+	    !ldlm_extent_overlap(&blocking, extent))
+		return false;
+
+	*new_ex = *extent;
+	if (blocking.end < req->start) {
+		/* the next page after the blocking extent */
+		new_ex->start = (blocking.end | ~PAGE_MASK) + 1;
+		if (new_ex->start > req->start)
+			return false;
+	} else {
+		/* the last page before the blocking extent */
+		if ((blocking.start & PAGE_MASK) == 0)
+			return false;
+		new_ex->end = (blocking.start & PAGE_MASK) - 1;
+		if (new_ex->end < req->end)
+			return false;
+	}
+
+	return true;
+}
+EXPORT_SYMBOL(ldlm_extent_shrink_range);
+
+/**
+ * Client-side extent lock shrinking.
+ *
+ * Shrink the unused \a lock to \a new_ex locally, let the owner of the
+ * lock flush what it caches out of the new extent and inform the server
+ * with a lock convert, so that the conflicting lock can be granted while
+ * this lock is kept. This is for extent locks what ldlm_cli_dropbits() is
+ * for IBITS locks.
+ *
+ * The l_blocking_ast() is called with LDLM_CB_CANCELING while the lock is
+ * converting, and with the description of the lock before shrinking.
+ */
+int ldlm_cli_shrink(struct ldlm_lock *lock, const struct ldlm_extent *new_ex)
+{
+	struct ldlm_lock_desc old;
+	__u32 flags = 0;
+	int rc;
+
+	ENTRY;
+
+	LDLM_DEBUG(lock, "client lock shrink START");
+
+	lock_res_and_lock(lock);
+	/* the lock may be used again or be cancelled meanwhile, return error
+	 * to continue with cancel */
+	if (lock->l_readers || lock->l_writers || ldlm_is_canceling(lock) ||
+	    ldlm_is_cancel(lock) || ldlm_is_converting(lock)) {
+		unlock_res_and_lock(lock);
+		GOTO(exit, rc = -EINVAL);
+	}
+
+	ldlm_lock2desc(lock, &old);
+	rc = ldlm_extent_shrink(lock, new_ex);
+	if (rc) {
+		unlock_res_and_lock(lock);
+		GOTO(exit, rc);
+	}
+
+	/* it is safe to match the lock right away, it only covers less */
+	ldlm_clear_cbpending(lock);
+	ldlm_clear_bl_ast(lock);
+	ldlm_set_converting(lock);
+	unlock_res_and_lock(lock);
+
+	if (lock->l_blocking_ast)
+		lock->l_blocking_ast(lock, &old, lock->l_ast_data,
+				     LDLM_CB_CANCELING);
+
+	/* now notify server about convert */
+	rc = ldlm_cli_convert(lock, &flags);
+	if (rc) {
+		lock_res_and_lock(lock);
+		if (ldlm_is_converting(lock)) {
+			ldlm_clear_converting(lock);
+			ldlm_set_cbpending(lock);
+			ldlm_set_bl_ast(lock);
+		}
+		unlock_res_and_lock(lock);
+		GOTO(exit, rc);
+	}
+	EXIT;
+exit:
+	LDLM_DEBUG(lock, "client lock shrink END, rc = %d", rc);
+	return rc;
+}
+EXPORT_SYMBOL(ldlm_cli_shrink);
+
 void ldlm_extent_policy_wire_to_local(const union ldlm_wire_policy_data *wpolicy,
 				      union ldlm_policy_data *lpolicy)
 {
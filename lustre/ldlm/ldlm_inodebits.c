@@ -190,6 +190,106 @@ not_conflicting:
 	RETURN(compat);
 }
 
+/**
+ * Determine if the lock is compatible with all granted locks of \a res.
+ *
+ * Same as ldlm_inodebits_compat_queue() for the granted queue, but only the
+ * granted locks sharing a bit with \a req are looked at, using the lists of
+ * res->lr_ibits_queues. Locks with several bits are found once per common
+ * bit, that is harmless because ldlm_add_ast_work_item() adds a lock to the
+ * \a work_list only once.
+ *
+ * \retval 0 if there are conflicting granted locks
+ * \retval 1 if the lock is compatible to all granted locks
+ */
+static int
+ldlm_inodebits_compat_granted(struct ldlm_resource *res, struct ldlm_lock *req,
+			      struct list_head *work_list)
+{
+	struct ldlm_ibits_queues *queues = res->lr_ibits_queues;
+	struct ldlm_ibits_node *node;
+	struct ldlm_lock *lock;
+	__u64 req_bits = req->l_policy_data.l_inodebits.bits;
+	__u64 *try_bits = &req->l_policy_data.l_inodebits.try_bits;
+	__u64 bits = req_bits | *try_bits;
+	int compat = 1;
+	int bit;
+	int idx;
+
+	ENTRY;
+
+	if (bits == 0)
+		RETURN(0);
+
+	for (bit = 0; bit < MDS_INODELOCK_NUMBITS; bit++) {
+		if (!(bits & (1ULL << bit)))
+			continue;
+
+		for (idx = 0; idx < LCK_MODE_NUM; idx++) {
+			struct list_head *head = &queues->liq_granted[bit][idx];
+			enum ldlm_mode mode = 1 << idx;
+
+			if (list_empty(head))
+				continue;
+
+			/* see ldlm_inodebits_compat_queue() for COS rules */
+			if (mode == LCK_COS && !ldlm_is_cos_incompat(req) &&
+			    !ldlm_is_cos_enabled(req))
+				continue;
+
+			if (lockmode_compat(mode, req->l_req_mode))
+				continue;
+
+			/* try_bits of granted locks are zero */
+			*try_bits &= ~(1ULL << bit);
+			if ((req_bits | *try_bits) == 0)
+				RETURN(0);
+
+			if (!(req_bits & (1ULL << bit)))
+				continue;
+
+			list_for_each_entry(node, head, lin_link[bit]) {
+				lock = node->lin_lock;
+
+				if (lock->l_req_mode == LCK_COS &&
+				    !ldlm_is_cos_incompat(req) &&
+				    ldlm_is_cos_enabled(req) &&
+				    lock->l_client_cookie == req->l_client_cookie)
+					continue;
+
+				if (!work_list)
+					RETURN(0);
+
+				compat = 0;
+				if (lock->l_blocking_ast)
+					ldlm_add_ast_work_item(lock, req,
+							       work_list);
+			}
+		}
+	}
+
+	RETURN(compat);
+}
+
+/**
+ * Check \a req against the granted locks of its resource, through the per-bit
+ * lists if the resource has them.
+ */
+static int
+ldlm_inodebits_compat_res(struct ldlm_resource *res, struct ldlm_lock *req,
+			  struct list_head *work_list)
+{
+	__u64 bits = req->l_policy_data.l_inodebits.bits |
+		     req->l_policy_data.l_inodebits.try_bits;
+
+	/* unknown bits are not indexed, walk the whole queue then */
+	if (res->lr_ibits_queues == NULL || (bits & ~MDS_INODELOCK_FULL))
+		return ldlm_inodebits_compat_queue(&res->lr_granted, req,
+						   work_list);
+
+	return ldlm_inodebits_compat_granted(res, req, work_list);
+}
+
 /**
  * Process a granting attempt for IBITS lock.
  * Must be called with ns lock held
@@ -245,8 +345,7 @@ int ldlm_process_inodebits_lock(struct ldlm_lock *lock, __u64 *flags,
 		 * any blocked locks from granted queue during every reprocess
 		 * and bl_ast will be sent if needed.
 		 */
-		rc = ldlm_inodebits_compat_queue(&res->lr_granted, lock,
-						 bl_list);
+		rc = ldlm_inodebits_compat_res(res, lock, bl_list);
 		if (!rc)
 			RETURN(LDLM_ITER_STOP);
 		rc = ldlm_inodebits_compat_queue(&res->lr_waiting, lock, NULL);
@@ -267,7 +366,7 @@ int ldlm_process_inodebits_lock(struct ldlm_lock *lock, __u64 *flags,
 		RETURN(LDLM_ITER_CONTINUE);
 	}
 
-	rc = ldlm_inodebits_compat_queue(&res->lr_granted, lock, work_list);
+	rc = ldlm_inodebits_compat_res(res, lock, work_list);
 	rc += ldlm_inodebits_compat_queue(&res->lr_waiting, lock, work_list);
 
 	if (rc != 2) {
@@ -296,6 +395,104 @@ int ldlm_process_inodebits_lock(struct ldlm_lock *lock, __u64 *flags,
 }
 #endif /* HAVE_SERVER_SUPPORT */
 
+struct kmem_cache *ldlm_inodebits_slab;
+struct kmem_cache *ldlm_ibits_queues_slab;
+
+/**
+ * Allocate the node linking IBITS \a lock into the per-bit lists of its
+ * resource. Only server namespaces index their granted IBITS locks.
+ */
+int ldlm_inodebits_alloc_lock(struct ldlm_lock *lock)
+{
+	struct ldlm_ibits_node *node;
+	int bit;
+
+	OBD_SLAB_ALLOC_PTR_GFP(node, ldlm_inodebits_slab, GFP_NOFS);
+	if (node == NULL)
+		return -ENOMEM;
+
+	for (bit = 0; bit < MDS_INODELOCK_NUMBITS; bit++)
+		INIT_LIST_HEAD(&node->lin_link[bit]);
+	node->lin_lock = lock;
+	lock->l_ibits_node = node;
+
+	return 0;
+}
+
+void ldlm_inodebits_free_lock(struct ldlm_lock *lock)
+{
+	struct ldlm_ibits_node *node = lock->l_ibits_node;
+	int bit;
+
+	if (node == NULL)
+		return;
+
+	for (bit = 0; bit < MDS_INODELOCK_NUMBITS; bit++)
+		LASSERT(list_empty(&node->lin_link[bit]));
+
+	lock->l_ibits_node = NULL;
+	OBD_SLAB_FREE_PTR(node, ldlm_inodebits_slab);
+}
+
+struct ldlm_ibits_queues *ldlm_ibits_queues_alloc(void)
+{
+	struct ldlm_ibits_queues *queues;
+	int bit;
+	int idx;
+
+	OBD_SLAB_ALLOC_PTR_GFP(queues, ldlm_ibits_queues_slab, GFP_NOFS);
+	if (queues == NULL)
+		return NULL;
+
+	for (bit = 0; bit < MDS_INODELOCK_NUMBITS; bit++)
+		for (idx = 0; idx < LCK_MODE_NUM; idx++)
+			INIT_LIST_HEAD(&queues->liq_granted[bit][idx]);
+
+	return queues;
+}
+
+void ldlm_ibits_queues_free(struct ldlm_ibits_queues *queues)
+{
+	OBD_SLAB_FREE_PTR(queues, ldlm_ibits_queues_slab);
+}
+
+/** Add newly granted lock into the per-bit lists of the resource. */
+void ldlm_inodebits_add_lock(struct ldlm_resource *res, struct ldlm_lock *lock)
+{
+	struct ldlm_ibits_node *node = lock->l_ibits_node;
+	__u64 bits = lock->l_policy_data.l_inodebits.bits;
+	int bit;
+	int idx;
+
+	if (res->lr_ibits_queues == NULL || node == NULL)
+		return;
+
+	LASSERT(lock->l_granted_mode == lock->l_req_mode);
+	idx = ldlm_mode_to_index(lock->l_granted_mode);
+
+	for (bit = 0; bit < MDS_INODELOCK_NUMBITS; bit++) {
+		if (!(bits & (1ULL << bit)))
+			continue;
+
+		LASSERT(list_empty(&node->lin_link[bit]));
+		list_add_tail(&node->lin_link[bit],
+			      &res->lr_ibits_queues->liq_granted[bit][idx]);
+	}
+}
+
+/** Remove cancelled lock from the per-bit lists of the resource. */
+void ldlm_inodebits_unlink_lock(struct ldlm_lock *lock)
+{
+	struct ldlm_ibits_node *node = lock->l_ibits_node;
+	int bit;
+
+	if (node == NULL)
+		return;
+
+	for (bit = 0; bit < MDS_INODELOCK_NUMBITS; bit++)
+		list_del_init(&node->lin_link[bit]);
+}
+
 void ldlm_ibits_policy_wire_to_local(const union ldlm_wire_policy_data *wpolicy,
 				     union ldlm_policy_data *lpolicy)
 {
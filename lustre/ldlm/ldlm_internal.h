@@ -118,6 +118,7 @@ int ldlm_cancel_lru_local(struct ldlm_namespace *ns,
 			  struct list_head *cancels, int count, int max,
 			  enum ldlm_cancel_flags cancel_flags,
 			  enum ldlm_lru_flags lru_flags);
+int ldlm_request_bufsize(int count, int type);
 extern unsigned int ldlm_enqueue_min;
 /* ldlm_resource.c */
 extern struct kmem_cache *ldlm_resource_slab;
@@ -189,6 +190,12 @@ int ldlm_bl_to_thread_list(struct ldlm_namespace *ns,
 			   struct list_head *cancels, int count,
 			   enum ldlm_cancel_flags cancel_flags);
 int ldlm_bl_thread_wakeup(void);
+#ifdef HAVE_SERVER_SUPPORT
+struct ldlm_bl_batch *ldlm_bl_batch_alloc(struct ldlm_lock *lock);
+void ldlm_bl_batch_free(struct ldlm_bl_batch *batch);
+int ldlm_bl_batch_send(struct ldlm_cb_set_arg *arg,
+		       struct ldlm_bl_batch *batch);
+#endif
 
 void ldlm_handle_bl_callback(struct ldlm_namespace *ns,
                              struct ldlm_lock_desc *ld, struct ldlm_lock *lock);
@@ -209,8 +216,33 @@ int ldlm_process_extent_lock(struct ldlm_lock *lock, __u64 *flags,
 			     enum ldlm_process_intention intention,
 			     enum ldlm_error *err, struct list_head *work_list);
 #endif
+
+static inline int ldlm_mode_to_index(enum ldlm_mode mode)
+{
+	int index;
+
+	LASSERT(mode != 0);
+	LASSERT(is_power_of_2(mode));
+	for (index = -1; mode != 0; index++, mode >>= 1)
+		/* do nothing */;
+	LASSERT(index < LCK_MODE_NUM);
+	return index;
+}
+
 void ldlm_extent_add_lock(struct ldlm_resource *res, struct ldlm_lock *lock);
 void ldlm_extent_unlink_lock(struct ldlm_lock *lock);
+int ldlm_extent_shrink(struct ldlm_lock *lock,
+		       const struct ldlm_extent *new_ex);
+
+/* ldlm_inodebits.c */
+extern struct kmem_cache *ldlm_inodebits_slab;
+extern struct kmem_cache *ldlm_ibits_queues_slab;
+int ldlm_inodebits_alloc_lock(struct ldlm_lock *lock);
+void ldlm_inodebits_free_lock(struct ldlm_lock *lock);
+struct ldlm_ibits_queues *ldlm_ibits_queues_alloc(void);
+void ldlm_ibits_queues_free(struct ldlm_ibits_queues *queues);
+void ldlm_inodebits_add_lock(struct ldlm_resource *res, struct ldlm_lock *lock);
+void ldlm_inodebits_unlink_lock(struct ldlm_lock *lock);
 
 /* ldlm_flock.c */
 int ldlm_process_flock_lock(struct ldlm_lock *req, __u64 *flags,
@@ -446,6 +446,11 @@ int client_obd_setup(struct obd_device *obddev, struct lustre_cfg *lcfg)
 	init_waitqueue_head(&cli->cl_mod_rpcs_waitq);
 	cli->cl_mod_tag_bitmap = NULL;
 
+	spin_lock_init(&cli->cl_batch_lock);
+	INIT_LIST_HEAD(&cli->cl_batch_list);
+	cli->cl_batch_count = 0;
+	cli->cl_batch_size = 0;
+
 	INIT_LIST_HEAD(&cli->cl_chg_dev_linkage);
 
 	if (connect_op == MDS_CONNECT) {
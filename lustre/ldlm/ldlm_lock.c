@@ -216,6 +216,7 @@ void ldlm_lock_put(struct ldlm_lock *lock)
                         OBD_FREE_LARGE(lock->l_lvb_data, lock->l_lvb_len);
 
                 ldlm_interval_free(ldlm_interval_detach(lock));
+		ldlm_inodebits_free_lock(lock);
                 lu_ref_fini(&lock->l_reference);
 		OBD_FREE_RCU(lock, sizeof(*lock), &lock->l_handle);
         }
@@ -1088,6 +1089,8 @@ void ldlm_grant_lock_with_skiplist(struct ldlm_lock *lock)
 
 	search_granted_lock(&lock->l_resource->lr_granted, lock, &prev);
 	ldlm_granted_list_add_lock(lock, &prev);
+	if (lock->l_resource->lr_type == LDLM_IBITS)
+		ldlm_inodebits_add_lock(lock->l_resource, lock);
 }
 
 /**
@@ -1686,6 +1689,13 @@ struct ldlm_lock *ldlm_lock_create(struct ldlm_namespace *ns,
 		if (ldlm_interval_alloc(lock) == NULL)
 			GOTO(out, rc = -ENOMEM);
 
+	/* server IBITS locks are also indexed by inode bit */
+	if (type == LDLM_IBITS && ns_is_server(ns)) {
+		rc = ldlm_inodebits_alloc_lock(lock);
+		if (rc)
+			GOTO(out, rc);
+	}
+
 	if (lvb_len) {
 		lock->l_lvb_len = lvb_len;
 		OBD_ALLOC_LARGE(lock->l_lvb_data, lvb_len);
@@ -2046,16 +2056,61 @@ void ldlm_discard_bl_list(struct list_head *bl_list)
 	EXIT;
 }
 
+/**
+ * Move to \a batch_list the locks of \a list whose blocking AST can be sent
+ * in the same RPC as the one of \a lock, i.e. the other locks of the same
+ * export on the same resource which conflict with the same blocking lock.
+ * Only the first entries of \a list are looked at, to keep the scan cheap.
+ *
+ * Called with the resource of \a lock locked.
+ */
+static int ldlm_bl_batch_collect(struct ldlm_lock *lock, struct list_head *list,
+				 struct list_head *batch_list, int max)
+{
+	struct ldlm_lock *next, *tmp;
+	int scan = max * 4;
+	int count = 0;
+
+	list_for_each_entry_safe(next, tmp, list, l_bl_ast) {
+		if (count >= max || scan-- == 0)
+			break;
+
+		if (next->l_export != lock->l_export ||
+		    next->l_resource != lock->l_resource ||
+		    next->l_blocking_lock != lock->l_blocking_lock ||
+		    next->l_blocking_ast != lock->l_blocking_ast ||
+		    !ldlm_is_ast_sent(next) || ldlm_is_cancel_on_block(next) ||
+		    (next->l_flags & LDLM_FL_AST_MASK) !=
+		    (lock->l_flags & LDLM_FL_AST_MASK))
+			continue;
+
+		LASSERT(next->l_bl_ast_run == 0);
+		next->l_bl_ast_run++;
+		/* the blocking lock is still referenced by \a lock */
+		ldlm_clear_blocking_lock(next);
+		list_move_tail(&next->l_bl_ast, batch_list);
+		count++;
+	}
+
+	return count;
+}
+
 /**
  * Process a call to blocking AST callback for a lock in ast_work list
+ *
+ * If the client supports it, the blocking ASTs of the following locks of
+ * the same export conflicting with the same lock are sent in the same RPC.
  */
 static int
 ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 {
 	struct ldlm_cb_set_arg *arg = opaq;
 	struct ldlm_lock *lock;
+	struct ldlm_lock *next;
 	struct ldlm_lock_desc d;
 	struct ldlm_bl_desc bld;
+	struct ldlm_bl_batch *batch;
+	struct list_head batch_list;
 	int rc;
 
 	ENTRY;
@@ -2063,8 +2118,13 @@ ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 	if (list_empty(arg->list))
 		RETURN(-ENOENT);
 
+	INIT_LIST_HEAD(&batch_list);
 	lock = list_entry(arg->list->next, struct ldlm_lock, l_bl_ast);
 
+	/* allocated before taking the resource lock, NULL if the blocking
+	 * AST of this lock cannot be batched */
+	batch = ldlm_bl_batch_alloc(lock);
+
 	/* nobody should touch l_bl_ast but some locks in the list may become
 	 * granted after lock convert or COS downgrade, these locks should be
 	 * just skipped here and removed from the list.
@@ -2078,6 +2138,8 @@ ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 	if (!ldlm_is_ast_sent(lock)) {
 		unlock_res_and_lock(lock);
 		LDLM_LOCK_RELEASE(lock);
+		if (batch != NULL)
+			ldlm_bl_batch_free(batch);
 		RETURN(0);
 	}
 
@@ -2103,13 +2165,35 @@ ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 	LASSERT(ldlm_is_ast_sent(lock));
 	LASSERT(lock->l_bl_ast_run == 0);
 	lock->l_bl_ast_run++;
+	if (batch != NULL && (ldlm_is_cancel_on_block(lock) ||
+	    ldlm_bl_batch_collect(lock, arg->list, &batch_list,
+				  batch->blb_max - 1) == 0)) {
+		ldlm_bl_batch_free(batch);
+		batch = NULL;
+	}
 	ldlm_clear_blocking_lock(lock);
 	unlock_res_and_lock(lock);
 
+	arg->bl_batch = batch;
 	rc = lock->l_blocking_ast(lock, &d, (void *)arg, LDLM_CB_BLOCKING);
 
 	LDLM_LOCK_RELEASE(lock);
 
+	while (!list_empty(&batch_list)) {
+		next = list_entry(batch_list.next, struct ldlm_lock, l_bl_ast);
+		lock_res_and_lock(next);
+		list_del_init(&next->l_bl_ast);
+		unlock_res_and_lock(next);
+
+		next->l_blocking_ast(next, &d, (void *)arg, LDLM_CB_BLOCKING);
+		LDLM_LOCK_RELEASE(next);
+	}
+
+	if (batch != NULL) {
+		arg->bl_batch = NULL;
+		rc = ldlm_bl_batch_send(arg, batch);
+	}
+
 	RETURN(rc);
 }
 
@@ -2353,11 +2437,8 @@ void ldlm_reprocess_all(struct ldlm_resource *res)
 }
 EXPORT_SYMBOL(ldlm_reprocess_all);
 
-static int ldlm_reprocess_res(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-			      struct hlist_node *hnode, void *arg)
+static int ldlm_reprocess_res(struct ldlm_resource *res, void *arg)
 {
-	struct ldlm_resource *res = cfs_hash_object(hs, hnode);
-
 	/* This is only called once after recovery done. LU-8306. */
 	__ldlm_reprocess_all(res, LDLM_PROCESS_RECOVERY);
 	return 0;
@@ -2372,8 +2453,7 @@ void ldlm_reprocess_recovery_done(struct ldlm_namespace *ns)
 	ENTRY;
 
 	if (ns != NULL) {
-		cfs_hash_for_each_nolock(ns->ns_rs_hash,
-					 ldlm_reprocess_res, NULL, 0);
+		ldlm_namespace_res_foreach(ns, ldlm_reprocess_res, NULL);
 	}
 	EXIT;
 }
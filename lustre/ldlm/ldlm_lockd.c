@@ -708,6 +708,61 @@ static int ldlm_handle_ast_error(const struct lu_env *env,
 	return rc;
 }
 
+/**
+ * Handle the reply to a blocking AST RPC sent for several locks. The reply
+ * lists the handles of the locks the client does not have anymore, these
+ * are cancelled as for a single blocking AST the client returned -EINVAL to.
+ */
+static int ldlm_bl_batch_interpret(const struct lu_env *env,
+				   struct ptlrpc_request *req,
+				   struct ldlm_bl_batch *batch, int rc)
+{
+	struct ldlm_request *reply = NULL;
+	struct ldlm_lock *lock;
+	int restart = 0;
+	int lock_rc;
+	int i, j;
+
+	ENTRY;
+
+	/* a batch of a single lock may be answered as a single blocking AST */
+	if (rc == 0 && req_capsule_field_present(&req->rq_pill, &RMF_DLM_REQ,
+						 RCL_SERVER)) {
+		reply = req_capsule_server_get(&req->rq_pill, &RMF_DLM_REQ);
+		if (reply == NULL ||
+		    ldlm_request_bufsize(reply->lock_count, LDLM_BL_CALLBACK) >
+		    req_capsule_get_size(&req->rq_pill, &RMF_DLM_REQ,
+					 RCL_SERVER))
+			rc = -EPROTO;
+	}
+
+	for (i = 0; i < batch->blb_count; i++) {
+		lock = batch->blb_locks[i];
+		lock_rc = rc;
+		for (j = 0; rc == 0 && reply != NULL &&
+			    j < reply->lock_count; j++) {
+			if (reply->lock_handle[j].cookie ==
+			    lock->l_remote_handle.cookie) {
+				lock_rc = -EINVAL;
+				break;
+			}
+		}
+
+		if (lock_rc != 0)
+			lock_rc = ldlm_handle_ast_error(env, lock, req, lock_rc,
+							"blocking");
+		if (lock_rc == -ERESTART)
+			restart = 1;
+
+		/* release reference taken in ldlm_bl_batch_add() */
+		LDLM_LOCK_RELEASE(lock);
+	}
+
+	ldlm_bl_batch_free(batch);
+
+	RETURN(restart ? -ERESTART : 0);
+}
+
 static int ldlm_cb_interpret(const struct lu_env *env,
 			     struct ptlrpc_request *req, void *args, int rc)
 {
@@ -744,7 +799,10 @@ static int ldlm_cb_interpret(const struct lu_env *env,
 		}
 		break;
 	case LDLM_BL_CALLBACK:
-		if (rc != 0)
+		if (ca->ca_batch != NULL)
+			rc = ldlm_bl_batch_interpret(env, req, ca->ca_batch,
+						     rc);
+		else if (rc != 0)
 			rc = ldlm_handle_ast_error(env, lock, req,
 						   rc, "blocking");
 		break;
@@ -760,7 +818,8 @@ static int ldlm_cb_interpret(const struct lu_env *env,
 	}
 
 	/* release extra reference taken in ldlm_ast_fini() */
-        LDLM_LOCK_RELEASE(lock);
+	if (ca->ca_batch == NULL)
+		LDLM_LOCK_RELEASE(lock);
 
 	if (rc == -ERESTART)
 		atomic_inc(&arg->restart);
@@ -772,6 +831,15 @@ static void ldlm_update_resend(struct ptlrpc_request *req, void *data)
 {
 	struct ldlm_cb_async_args *ca = data;
 	struct ldlm_lock *lock = ca->ca_lock;
+	int i;
+
+	if (ca->ca_batch != NULL) {
+		for (i = 0; i < ca->ca_batch->blb_count; i++) {
+			lock = ca->ca_batch->blb_locks[i];
+			ldlm_refresh_waiting_lock(lock, ldlm_bl_timeout(lock));
+		}
+		return;
+	}
 
 	ldlm_refresh_waiting_lock(lock, ldlm_bl_timeout(lock));
 }
@@ -829,6 +897,165 @@ static void ldlm_lock_reorder_req(struct ldlm_lock *lock)
 	EXIT;
 }
 
+/**
+ * Allocate a batch for the blocking ASTs of \a lock and of the other locks of
+ * its export, see ldlm_work_bl_ast_lock(). Return NULL if the client cannot
+ * handle several locks in one blocking AST RPC.
+ */
+struct ldlm_bl_batch *ldlm_bl_batch_alloc(struct ldlm_lock *lock)
+{
+	struct ldlm_bl_batch *batch;
+	int max = ldlm_lock_to_ns(lock)->ns_max_bl_ast_batch;
+
+	if (max < 2 || lock->l_export == NULL ||
+	    !exp_connect_batch_bl_ast(lock->l_export))
+		return NULL;
+
+	OBD_ALLOC(batch, offsetof(struct ldlm_bl_batch, blb_locks[max]));
+	if (batch != NULL)
+		batch->blb_max = max;
+
+	return batch;
+}
+
+void ldlm_bl_batch_free(struct ldlm_bl_batch *batch)
+{
+	OBD_FREE(batch, offsetof(struct ldlm_bl_batch,
+				 blb_locks[batch->blb_max]));
+}
+
+/**
+ * Add the blocking AST of \a lock to the RPC of \a arg->bl_batch. The RPC is
+ * sent by ldlm_bl_batch_send() once all the locks of the batch are added.
+ */
+static int ldlm_bl_batch_add(struct ldlm_lock *lock,
+			     struct ldlm_lock_desc *desc,
+			     struct ldlm_cb_set_arg *arg)
+{
+	struct ldlm_bl_batch *batch = arg->bl_batch;
+	struct ptlrpc_request *req = batch->blb_req;
+	struct ldlm_request *body;
+	int rc;
+
+	ENTRY;
+
+	LASSERT(batch->blb_count < batch->blb_max);
+
+	if (req == NULL) {
+		req = ptlrpc_request_alloc(lock->l_export->exp_imp_reverse,
+					   &RQF_LDLM_BL_CALLBACK_BATCH);
+		if (req == NULL)
+			RETURN(-ENOMEM);
+
+		req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_CLIENT,
+				     ldlm_request_bufsize(batch->blb_max,
+							  LDLM_BL_CALLBACK));
+		rc = ptlrpc_request_pack(req, LUSTRE_DLM_VERSION,
+					 LDLM_BL_CALLBACK);
+		if (rc) {
+			ptlrpc_request_free(req);
+			RETURN(rc);
+		}
+		batch->blb_req = req;
+	}
+
+	lock_res_and_lock(lock);
+	if (ldlm_is_destroyed(lock)) {
+		unlock_res_and_lock(lock);
+		RETURN(0);
+	}
+
+	if (lock->l_granted_mode != lock->l_req_mode) {
+		/* this blocking AST will be communicated as part of the
+		 * completion AST instead */
+		ldlm_add_blocked_lock(lock);
+		ldlm_set_waited(lock);
+		unlock_res_and_lock(lock);
+
+		LDLM_DEBUG(lock, "lock not granted, not sending blocking AST");
+		RETURN(0);
+	}
+
+	/* all the locks of the batch conflict with the same lock and have
+	 * the same AST flags */
+	body = req_capsule_client_get(&req->rq_pill, &RMF_DLM_REQ);
+	if (batch->blb_count == 0) {
+		body->lock_desc = *desc;
+		body->lock_flags |= ldlm_flags_to_wire(lock->l_flags &
+						       LDLM_FL_AST_MASK);
+	}
+	body->lock_handle[batch->blb_count] = lock->l_remote_handle;
+	batch->blb_locks[batch->blb_count++] = LDLM_LOCK_GET(lock);
+	body->lock_count = batch->blb_count;
+
+	LDLM_DEBUG(lock, "server adding blocking AST to batch of %d",
+		   batch->blb_count);
+
+	ldlm_set_cbpending(lock);
+	ldlm_add_waiting_lock(lock, ldlm_bl_timeout(lock));
+	unlock_res_and_lock(lock);
+
+	if (lock->l_export->exp_nid_stats &&
+	    lock->l_export->exp_nid_stats->nid_ldlm_stats)
+		lprocfs_counter_incr(lock->l_export->exp_nid_stats->nid_ldlm_stats,
+				     LDLM_BL_CALLBACK - LDLM_FIRST_OPC);
+
+	RETURN(0);
+}
+
+/**
+ * Send the blocking AST RPC of \a batch, or drop it if none of its locks
+ * needed a blocking AST after all. The batch is freed by ldlm_cb_interpret().
+ */
+int ldlm_bl_batch_send(struct ldlm_cb_set_arg *arg,
+		       struct ldlm_bl_batch *batch)
+{
+	struct ptlrpc_request *req = batch->blb_req;
+	struct ldlm_cb_async_args *ca;
+	struct ldlm_namespace *ns;
+	struct ldlm_lock *lock;
+	int size;
+
+	ENTRY;
+
+	if (batch->blb_count == 0) {
+		if (req != NULL)
+			ptlrpc_req_finished(req);
+		ldlm_bl_batch_free(batch);
+		RETURN(0);
+	}
+
+	lock = batch->blb_locks[0];
+	ns = ldlm_lock_to_ns(lock);
+
+	size = ldlm_request_bufsize(batch->blb_count, LDLM_BL_CALLBACK);
+	req_capsule_shrink(&req->rq_pill, &RMF_DLM_REQ, size, RCL_CLIENT);
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_SERVER, size);
+	ptlrpc_request_set_replen(req);
+
+	CLASSERT(sizeof(*ca) <= sizeof(req->rq_async_args));
+	ca = ptlrpc_req_async_args(req);
+	ca->ca_set_arg = arg;
+	ca->ca_lock = lock;
+	ca->ca_batch = batch;
+
+	req->rq_interpret_reply = ldlm_cb_interpret;
+	/* Do not resend after lock callback timeout */
+	req->rq_delay_limit = ldlm_bl_timeout(lock);
+	req->rq_resend_cb = ldlm_update_resend;
+	req->rq_send_state = LUSTRE_IMP_FULL;
+	/* ptlrpc_request_pack already set timeout */
+	if (AT_OFF)
+		req->rq_timeout = ldlm_get_rq_timeout();
+
+	atomic64_inc(&ns->ns_bl_ast_rpcs);
+	atomic64_add(batch->blb_count, &ns->ns_bl_ast_locks);
+
+	ptlrpc_set_add_req(arg->set, req);
+
+	RETURN(0);
+}
+
 /**
  * ->l_blocking_ast() method for server-side locks. This is invoked when newly
  * enqueued server lock conflicts with given one.
@@ -864,6 +1091,9 @@ int ldlm_server_blocking_ast(struct ldlm_lock *lock,
 
         ldlm_lock_reorder_req(lock);
 
+	if (arg->bl_batch != NULL)
+		RETURN(ldlm_bl_batch_add(lock, desc, arg));
+
 	req = ptlrpc_request_alloc_pack(lock->l_export->exp_imp_reverse,
 					&RQF_LDLM_BL_CALLBACK,
 					LUSTRE_DLM_VERSION, LDLM_BL_CALLBACK);
@@ -934,6 +1164,9 @@ int ldlm_server_blocking_ast(struct ldlm_lock *lock,
                 lprocfs_counter_incr(lock->l_export->exp_nid_stats->nid_ldlm_stats,
                                      LDLM_BL_CALLBACK - LDLM_FIRST_OPC);
 
+	atomic64_inc(&ldlm_lock_to_ns(lock)->ns_bl_ast_rpcs);
+	atomic64_inc(&ldlm_lock_to_ns(lock)->ns_bl_ast_locks);
+
 	rc = ldlm_ast_fini(req, arg, lock, instant_cancel);
 
         RETURN(rc);
@@ -1518,6 +1751,46 @@ void ldlm_clear_blocking_data(struct ldlm_lock *lock)
 	ldlm_clear_blocking_lock(lock);
 }
 
+/**
+ * Shrink the extent of \a lock to \a new_ex as requested by the client, which
+ * has already flushed its cache out of it, and grant the locks which are
+ * not blocked by this lock anymore.
+ */
+static int ldlm_handle_shrink(struct ldlm_lock *lock,
+			      const struct ldlm_extent *new_ex)
+{
+	int rc;
+
+	lock_res_and_lock(lock);
+	if (lock->l_policy_data.l_extent.start == new_ex->start &&
+	    lock->l_policy_data.l_extent.end == new_ex->end) {
+		/* This can be valid situation if CONVERT RPCs are
+		 * re-ordered. Just finish silently */
+		unlock_res_and_lock(lock);
+		LDLM_DEBUG(lock, "lock is shrunk already!");
+		return ELDLM_OK;
+	}
+
+	rc = ldlm_extent_shrink(lock, new_ex);
+	if (rc) {
+		unlock_res_and_lock(lock);
+		LDLM_ERROR(lock, "cannot shrink lock to [%llu->%llu]: rc = %d",
+			   new_ex->start, new_ex->end, rc);
+		/* the client cancels the lock then */
+		return rc;
+	}
+
+	if (ldlm_is_waited(lock))
+		ldlm_del_waiting_lock(lock);
+
+	ldlm_clear_cbpending(lock);
+	ldlm_clear_blocking_data(lock);
+	unlock_res_and_lock(lock);
+
+	ldlm_reprocess_all(lock->l_resource);
+	return ELDLM_OK;
+}
+
 /**
  * Main LDLM entry point for server code to process lock conversion requests.
  */
@@ -1558,6 +1831,9 @@ int ldlm_handle_convert0(struct ptlrpc_request *req,
 			   lock->l_granted_mode) {
 			LDLM_ERROR(lock, "lock mode differs!");
 			rc = ELDLM_NO_LOCK_DATA;
+		} else if (lock->l_resource->lr_type == LDLM_EXTENT) {
+			rc = ldlm_handle_shrink(lock,
+				&dlm_req->lock_desc.l_policy_data.l_extent);
 		} else if (bits == new) {
 			/* This can be valid situation if CONVERT RPCs are
 			 * re-ordered. Just finish silently */
@@ -1581,7 +1857,8 @@ int ldlm_handle_convert0(struct ptlrpc_request *req,
 
 		if (rc == ELDLM_OK) {
 			dlm_rep->lock_handle = lock->l_remote_handle;
-			ldlm_ibits_policy_local_to_wire(&lock->l_policy_data,
+			ldlm_convert_policy_to_wire(lock->l_resource->lr_type,
+					&lock->l_policy_data,
 					&dlm_rep->lock_desc.l_policy_data);
 		}
 
@@ -2135,6 +2412,150 @@ static inline void ldlm_callback_errmsg(struct ptlrpc_request *req,
                 CWARN("Send reply failed, maybe cause bug 21636.\n");
 }
 
+/**
+ * Check whether \a lock, which got a blocking AST, can be cancelled together
+ * with other locks from a blocking thread, as done for the LRU. This is the
+ * case if the lock is unused and is cancelled as a whole, i.e. no bits or
+ * range of it can be kept by a lock convert.
+ *
+ * Called with the resource of \a lock locked.
+ */
+static bool ldlm_bl_batch_can_cancel(struct ldlm_lock *lock,
+				     struct ldlm_lock_desc *ld)
+{
+	struct ldlm_extent extent;
+
+	if (lock->l_readers || lock->l_writers ||
+	    ldlm_is_canceling(lock) || ldlm_is_cancel_on_block(lock) ||
+	    ldlm_is_converting(lock))
+		return false;
+
+	if (lock->l_resource->lr_type == LDLM_IBITS &&
+	    lock->l_policy_data.l_inodebits.bits &
+	    ~ld->l_policy_data.l_inodebits.cancel_bits)
+		return false;
+
+	if (lock->l_resource->lr_type == LDLM_EXTENT &&
+	    ldlm_extent_shrink_range(lock, ld, &extent))
+		return false;
+
+	return true;
+}
+
+/**
+ * Handle a blocking AST RPC carrying several locks, see ldlm_bl_batch_add().
+ *
+ * The handles of the locks which are gone already are returned in the reply.
+ * The locks which can be cancelled right away are handed all together to a
+ * blocking thread, so their cancels are sent in as few RPCs as possible, the
+ * other ones are handled one by one as for a single blocking AST.
+ */
+static void ldlm_handle_bl_callback_batch(struct ptlrpc_request *req,
+					  struct ldlm_namespace *ns,
+					  struct ldlm_request *dlm_req)
+{
+	struct list_head cancels = LIST_HEAD_INIT(cancels);
+	struct ldlm_lock_desc *ld = &dlm_req->lock_desc;
+	struct ldlm_request *reply;
+	struct ldlm_lock **locks = NULL;
+	struct ldlm_lock *lock;
+	int count = dlm_req->lock_count;
+	int ncancels = 0;
+	int nlocks = 0;
+	int rc;
+	int i;
+
+	ENTRY;
+
+	if (count > LDLM_MAX_BL_AST_BATCH ||
+	    req_capsule_get_size(&req->rq_pill, &RMF_DLM_REQ, RCL_CLIENT) <
+	    ldlm_request_bufsize(count, LDLM_BL_CALLBACK)) {
+		rc = ldlm_callback_reply(req, -EPROTO);
+		ldlm_callback_errmsg(req, "Operate with short handle list", rc,
+				     &dlm_req->lock_handle[0]);
+		RETURN_EXIT;
+	}
+
+	req_capsule_extend(&req->rq_pill, &RQF_LDLM_BL_CALLBACK_BATCH);
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_SERVER,
+			     ldlm_request_bufsize(count, LDLM_BL_CALLBACK));
+	rc = req_capsule_server_pack(&req->rq_pill);
+	if (rc == 0)
+		OBD_ALLOC(locks, count * sizeof(*locks));
+	if (rc != 0 || locks == NULL) {
+		rc = ldlm_callback_reply(req, rc ? : -ENOMEM);
+		ldlm_callback_errmsg(req, "Operate without memory", rc,
+				     &dlm_req->lock_handle[0]);
+		RETURN_EXIT;
+	}
+
+	reply = req_capsule_server_get(&req->rq_pill, &RMF_DLM_REQ);
+	reply->lock_count = 0;
+
+	for (i = 0; i < count; i++) {
+		lock = ldlm_handle2lock_long(&dlm_req->lock_handle[i], 0);
+		if (lock == NULL) {
+			CDEBUG(D_DLMTRACE, "callback on lock %#llx - lock "
+			       "disappeared\n", dlm_req->lock_handle[i].cookie);
+			reply->lock_handle[reply->lock_count++] =
+				dlm_req->lock_handle[i];
+			continue;
+		}
+
+		lock_res_and_lock(lock);
+		lock->l_flags |= ldlm_flags_from_wire(dlm_req->lock_flags &
+						      LDLM_FL_AST_MASK);
+		if ((ldlm_is_canceling(lock) && ldlm_is_bl_done(lock)) ||
+		    ldlm_is_failed(lock)) {
+			LDLM_DEBUG(lock, "callback on lock %llx - lock disappeared",
+				   dlm_req->lock_handle[i].cookie);
+			unlock_res_and_lock(lock);
+			LDLM_LOCK_RELEASE(lock);
+			reply->lock_handle[reply->lock_count++] =
+				dlm_req->lock_handle[i];
+			continue;
+		}
+
+		/* BL_AST locks are not needed in LRU */
+		ldlm_lock_remove_from_lru(lock);
+		ldlm_set_bl_ast(lock);
+		if (ldlm_bl_batch_can_cancel(lock, ld)) {
+			/* see ldlm_prepare_lru_list(), the reference of the
+			 * lock is kept by the cancel list */
+			lock->l_flags |= LDLM_FL_CBPENDING | LDLM_FL_CANCELING;
+			LASSERT(list_empty(&lock->l_bl_ast));
+			list_add_tail(&lock->l_bl_ast, &cancels);
+			ncancels++;
+		} else {
+			locks[nlocks++] = lock;
+		}
+		unlock_res_and_lock(lock);
+	}
+
+	req_capsule_shrink(&req->rq_pill, &RMF_DLM_REQ,
+			   ldlm_request_bufsize(reply->lock_count,
+						LDLM_BL_CALLBACK), RCL_SERVER);
+	LDLM_DEBUG_NOLOCK("blocking ast for %d locks, %d gone, %d to cancel",
+			  count, reply->lock_count, ncancels);
+
+	rc = ldlm_callback_reply(req, 0);
+	if (req->rq_no_reply || rc)
+		ldlm_callback_errmsg(req, "Normal process", rc,
+				     &dlm_req->lock_handle[0]);
+
+	if (ncancels > 0 &&
+	    ldlm_bl_to_thread_list(ns, NULL, &cancels, ncancels, LCF_ASYNC))
+		ldlm_bl_to_thread_list(ns, NULL, &cancels, ncancels, 0);
+
+	for (i = 0; i < nlocks; i++) {
+		if (ldlm_bl_to_thread_lock(ns, ld, locks[i]))
+			ldlm_handle_bl_callback(ns, ld, locks[i]);
+	}
+
+	OBD_FREE(locks, count * sizeof(*locks));
+	EXIT;
+}
+
 /* TODO: handle requests in a similar way as MDT: see mdt_handle_common() */
 static int ldlm_callback_handler(struct ptlrpc_request *req)
 {
@@ -2205,6 +2626,13 @@ static int ldlm_callback_handler(struct ptlrpc_request *req)
                 RETURN(0);
         }
 
+	/* several locks in one blocking AST, see ldlm_bl_batch_add() */
+	if (lustre_msg_get_opc(req->rq_reqmsg) == LDLM_BL_CALLBACK &&
+	    dlm_req->lock_count > 1) {
+		ldlm_handle_bl_callback_batch(req, ns, dlm_req);
+		RETURN(0);
+	}
+
         /* Force a known safe race, send a cancel to the server for a lock
          * which the server has already started a blocking callback on. */
         if (OBD_FAIL_CHECK(OBD_FAIL_LDLM_CANCEL_BL_CB_RACE) &&
@@ -3209,12 +3637,24 @@ int ldlm_init(void)
 	if (ldlm_interval_tree_slab == NULL)
 		goto out_interval;
 
+	ldlm_inodebits_slab = kmem_cache_create("ldlm_ibits_node",
+					sizeof(struct ldlm_ibits_node),
+					0, SLAB_HWCACHE_ALIGN, NULL);
+	if (ldlm_inodebits_slab == NULL)
+		goto out_interval_tree;
+
+	ldlm_ibits_queues_slab = kmem_cache_create("ldlm_ibits_queues",
+					sizeof(struct ldlm_ibits_queues),
+					0, SLAB_HWCACHE_ALIGN, NULL);
+	if (ldlm_ibits_queues_slab == NULL)
+		goto out_ibits_node;
+
 #ifdef HAVE_SERVER_SUPPORT
 	ldlm_glimpse_work_kmem = kmem_cache_create("ldlm_glimpse_work_kmem",
 					sizeof(struct ldlm_glimpse_work),
 					0, 0, NULL);
 	if (ldlm_glimpse_work_kmem == NULL)
-		goto out_interval_tree;
+		goto out_ibits_queues;
 #endif
 
 #if LUSTRE_TRACKS_LOCK_EXP_REFS
@@ -3222,9 +3662,13 @@ int ldlm_init(void)
 #endif
 	return 0;
 #ifdef HAVE_SERVER_SUPPORT
+out_ibits_queues:
+	kmem_cache_destroy(ldlm_ibits_queues_slab);
+#endif
+out_ibits_node:
+	kmem_cache_destroy(ldlm_inodebits_slab);
 out_interval_tree:
 	kmem_cache_destroy(ldlm_interval_tree_slab);
-#endif
 out_interval:
 	kmem_cache_destroy(ldlm_interval_slab);
 out_lock:
@@ -3239,6 +3683,9 @@ void ldlm_exit(void)
 {
 	if (ldlm_refcount)
 		CERROR("ldlm_refcount is %d in ldlm_exit!\n", ldlm_refcount);
+	/* ldlm_resource_putref() frees resources through call_rcu(), wait
+	 * for the pending callbacks before destroying the slabs. */
+	rcu_barrier();
 	kmem_cache_destroy(ldlm_resource_slab);
 	/* ldlm_lock_put() use RCU to call ldlm_lock_free, so need call
 	 * synchronize_rcu() to wait a grace period elapsed, so that
@@ -3247,6 +3694,8 @@ void ldlm_exit(void)
 	kmem_cache_destroy(ldlm_lock_slab);
 	kmem_cache_destroy(ldlm_interval_slab);
 	kmem_cache_destroy(ldlm_interval_tree_slab);
+	kmem_cache_destroy(ldlm_inodebits_slab);
+	kmem_cache_destroy(ldlm_ibits_queues_slab);
 #ifdef HAVE_SERVER_SUPPORT
 	kmem_cache_destroy(ldlm_glimpse_work_kmem);
 #endif
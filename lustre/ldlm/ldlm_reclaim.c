@@ -74,7 +74,6 @@ struct ldlm_reclaim_cb_data {
 	int			 rcd_start;
 	bool			 rcd_skip;
 	s64			 rcd_age_ns;
-	struct cfs_hash_bd	*rcd_prev_bd;
 };
 
 static inline bool ldlm_lock_reclaimable(struct ldlm_lock *lock)
@@ -95,22 +94,16 @@ static inline bool ldlm_lock_reclaimable(struct ldlm_lock *lock)
 /**
  * Callback function for revoking locks from certain resource.
  *
- * \param [in] hs	ns_rs_hash
- * \param [in] bd	current bucket of ns_rsh_hash
- * \param [in] hnode	hnode of the resource
+ * \param [in] res	the resource
  * \param [in] arg	opaque data
  *
  * \retval 0		continue the scan
  * \retval 1		stop the iteration
  */
-static int ldlm_reclaim_lock_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-				struct hlist_node *hnode, void *arg)
-
+static int ldlm_reclaim_lock_cb(struct ldlm_resource *res, void *arg)
 {
-	struct ldlm_resource		*res;
 	struct ldlm_reclaim_cb_data	*data;
 	struct ldlm_lock		*lock;
-	struct ldlm_ns_bucket		*nsb;
 	int				 rc = 0;
 
 	data = (struct ldlm_reclaim_cb_data *)arg;
@@ -118,24 +111,12 @@ static int ldlm_reclaim_lock_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 	LASSERTF(data->rcd_added < data->rcd_total, "added:%d >= total:%d\n",
 		 data->rcd_added, data->rcd_total);
 
-	nsb = cfs_hash_bd_extra_get(hs, bd);
-	res = cfs_hash_object(hs, hnode);
-
-	if (data->rcd_prev_bd != bd) {
-		if (data->rcd_prev_bd != NULL)
-			ldlm_res_to_ns(res)->ns_reclaim_start++;
-		data->rcd_prev_bd = bd;
-		data->rcd_cursor = 0;
-		data->rcd_start = nsb->nsb_reclaim_start %
-				  cfs_hash_bd_count_get(bd);
-	}
-
 	if (data->rcd_skip && data->rcd_cursor < data->rcd_start) {
 		data->rcd_cursor++;
 		return 0;
 	}
 
-	nsb->nsb_reclaim_start++;
+	ldlm_res_to_ns(res)->ns_reclaim_start++;
 
 	lock_res(res);
 	list_for_each_entry(lock, &res->lr_granted, l_res_link) {
@@ -180,7 +161,7 @@ static void ldlm_reclaim_res(struct ldlm_namespace *ns, int *count,
 			     s64 age_ns, bool skip)
 {
 	struct ldlm_reclaim_cb_data	data;
-	int				idx, type, start;
+	int				idx, type;
 	ENTRY;
 
 	LASSERT(*count != 0);
@@ -203,11 +184,13 @@ static void ldlm_reclaim_res(struct ldlm_namespace *ns, int *count,
 	data.rcd_total = *count;
 	data.rcd_age_ns = age_ns;
 	data.rcd_skip = skip;
-	data.rcd_prev_bd = NULL;
-	start = ns->ns_reclaim_start % CFS_HASH_NBKT(ns->ns_rs_hash);
+	data.rcd_cursor = 0;
+	/* resources have no stable position in the hash, so resume the
+	 * scan after the number of resources scanned by the last one */
+	data.rcd_start = ns->ns_reclaim_start %
+			 max(atomic_read(&ns->ns_rs_hash.nelems), 1);
 
-	cfs_hash_for_each_nolock(ns->ns_rs_hash, ldlm_reclaim_lock_cb, &data,
-				 start);
+	ldlm_namespace_res_foreach(ns, ldlm_reclaim_lock_cb, &data);
 
 	CDEBUG(D_DLMTRACE, "NS(%s): %d locks to be reclaimed, found %d/%d "
 	       "locks.\n", ldlm_ns_name(ns), *count, data.rcd_added,
@@ -1041,6 +1041,23 @@ int ldlm_cli_enqueue(struct obd_export *exp, struct ptlrpc_request **reqp,
 }
 EXPORT_SYMBOL(ldlm_cli_enqueue);
 
+/**
+ * Whether the lock policy \a policy returned in a convert reply is the local
+ * one of \a lock, i.e. there is no later convert of the lock in flight.
+ */
+static bool ldlm_convert_is_done(struct ldlm_lock *lock,
+				 const union ldlm_wire_policy_data *policy)
+{
+	if (lock->l_resource->lr_type == LDLM_EXTENT)
+		return policy->l_extent.start ==
+			lock->l_policy_data.l_extent.start &&
+		       policy->l_extent.end ==
+			lock->l_policy_data.l_extent.end;
+
+	return policy->l_inodebits.bits ==
+		lock->l_policy_data.l_inodebits.bits;
+}
+
 /**
  * Client-side lock convert reply handling.
  *
@@ -1092,8 +1109,8 @@ static int lock_convert_interpret(const struct lu_env *env,
 		LDLM_DEBUG(lock, "convert ACK for lock without converting flag,"
 			   " reply ibits %#llx",
 			   reply->lock_desc.l_policy_data.l_inodebits.bits);
-	} else if (reply->lock_desc.l_policy_data.l_inodebits.bits !=
-		   lock->l_policy_data.l_inodebits.bits) {
+	} else if (!ldlm_convert_is_done(lock,
+					 &reply->lock_desc.l_policy_data)) {
 		/* Compare server returned lock ibits and local lock ibits
 		 * if they are the same we consider convertion is done,
 		 * otherwise we have more converts inflight and keep
@@ -1115,7 +1132,8 @@ static int lock_convert_interpret(const struct lu_env *env,
 			 * and put lock into LRU if it is still not used and
 			 * is not there yet.
 			 */
-			lock->l_policy_data.l_inodebits.cancel_bits = 0;
+			if (lock->l_resource->lr_type == LDLM_IBITS)
+				lock->l_policy_data.l_inodebits.cancel_bits = 0;
 			if (!lock->l_readers && !lock->l_writers &&
 			    !ldlm_is_canceling(lock)) {
 				spin_lock(&ns->ns_lock);
@@ -1136,7 +1154,8 @@ out:
 			ldlm_clear_converting(lock);
 			ldlm_set_cbpending(lock);
 			ldlm_set_bl_ast(lock);
-			lock->l_policy_data.l_inodebits.cancel_bits = 0;
+			if (lock->l_resource->lr_type == LDLM_IBITS)
+				lock->l_policy_data.l_inodebits.cancel_bits = 0;
 		}
 		unlock_res_and_lock(lock);
 
@@ -1157,15 +1176,15 @@ out:
 }
 
 /**
- * Client-side IBITS lock convert.
+ * Client-side IBITS lock convert or EXTENT lock shrink.
  *
  * Inform server that lock has been converted instead of canceling.
  * Server finishes convert on own side and does reprocess to grant
  * all related waiting locks.
  *
- * Since convert means only ibits downgrading, client doesn't need to
- * wait for server reply to finish local converting process so this request
- * is made asynchronous.
+ * Since convert means only ibits downgrading or extent shrinking, client
+ * doesn't need to wait for server reply to finish local converting process
+ * so this request is made asynchronous.
  *
  */
 int ldlm_cli_convert(struct ldlm_lock *lock, __u32 *flags)
@@ -1186,13 +1205,18 @@ int ldlm_cli_convert(struct ldlm_lock *lock, __u32 *flags)
 	 * but this check is kept too as final one to issue an error
 	 * if any new code will miss such check.
 	 */
-	if (!exp_connect_lock_convert(exp)) {
-		LDLM_ERROR(lock, "server doesn't support lock convert\n");
-		RETURN(-EPROTO);
-	}
-
-	if (lock->l_resource->lr_type != LDLM_IBITS) {
-		LDLM_ERROR(lock, "convert works with IBITS locks only.");
+	if (lock->l_resource->lr_type == LDLM_IBITS) {
+		if (!exp_connect_lock_convert(exp)) {
+			LDLM_ERROR(lock, "server doesn't support lock convert\n");
+			RETURN(-EPROTO);
+		}
+	} else if (lock->l_resource->lr_type == LDLM_EXTENT) {
+		if (!exp_connect_extent_shrink(exp)) {
+			LDLM_ERROR(lock, "server doesn't support lock shrink\n");
+			RETURN(-EPROTO);
+		}
+	} else {
+		LDLM_ERROR(lock, "convert works with IBITS and EXTENT locks only.");
 		RETURN(-EINVAL);
 	}
 
@@ -1210,9 +1234,18 @@ int ldlm_cli_convert(struct ldlm_lock *lock, __u32 *flags)
 	body->lock_desc.l_req_mode = lock->l_req_mode;
 	body->lock_desc.l_granted_mode = lock->l_granted_mode;
 
-	body->lock_desc.l_policy_data.l_inodebits.bits =
+	if (lock->l_resource->lr_type == LDLM_EXTENT) {
+		body->lock_desc.l_policy_data.l_extent.start =
+					lock->l_policy_data.l_extent.start;
+		body->lock_desc.l_policy_data.l_extent.end =
+					lock->l_policy_data.l_extent.end;
+		body->lock_desc.l_policy_data.l_extent.gid =
+					lock->l_policy_data.l_extent.gid;
+	} else {
+		body->lock_desc.l_policy_data.l_inodebits.bits =
 					lock->l_policy_data.l_inodebits.bits;
-	body->lock_desc.l_policy_data.l_inodebits.cancel_bits = 0;
+		body->lock_desc.l_policy_data.l_inodebits.cancel_bits = 0;
+	}
 
 	body->lock_flags = ldlm_flags_to_wire(*flags);
 	body->lock_count = 1;
@@ -2201,10 +2234,8 @@ struct ldlm_cli_cancel_arg {
 };
 
 static int
-ldlm_cli_hash_cancel_unused(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-			    struct hlist_node *hnode, void *arg)
+ldlm_cli_hash_cancel_unused(struct ldlm_resource *res, void *arg)
 {
-	struct ldlm_resource           *res = cfs_hash_object(hs, hnode);
 	struct ldlm_cli_cancel_arg     *lc = arg;
 
 	ldlm_cli_cancel_unused_resource(ldlm_res_to_ns(res), &res->lr_name,
@@ -2239,8 +2270,8 @@ int ldlm_cli_cancel_unused(struct ldlm_namespace *ns,
                                                        LCK_MINMODE, flags,
                                                        opaque));
 	} else {
-		cfs_hash_for_each_nolock(ns->ns_rs_hash,
-					 ldlm_cli_hash_cancel_unused, &arg, 0);
+		ldlm_namespace_res_foreach(ns, ldlm_cli_hash_cancel_unused,
+					   &arg);
 		RETURN(ELDLM_OK);
 	}
 }
@@ -2289,12 +2320,8 @@ static int ldlm_iter_helper(struct ldlm_lock *lock, void *closure)
         return helper->iter(lock, helper->closure);
 }
 
-static int ldlm_res_iter_helper(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-				struct hlist_node *hnode, void *arg)
-
+static int ldlm_res_iter_helper(struct ldlm_resource *res, void *arg)
 {
-        struct ldlm_resource *res = cfs_hash_object(hs, hnode);
-
         return ldlm_resource_foreach(res, ldlm_iter_helper, arg) ==
                LDLM_ITER_STOP;
 }
@@ -2305,8 +2332,7 @@ void ldlm_namespace_foreach(struct ldlm_namespace *ns,
 {
 	struct iter_helper_data helper = { .iter = iter, .closure = closure };
 
-	cfs_hash_for_each_nolock(ns->ns_rs_hash,
-				 ldlm_res_iter_helper, &helper, 0);
+	ldlm_namespace_res_foreach(ns, ldlm_res_iter_helper, &helper);
 
 }
 
@@ -294,14 +294,8 @@ static ssize_t resource_count_show(struct kobject *kobj, struct attribute *attr,
 {
 	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
 						 ns_kobj);
-	__u64			res = 0;
-	struct cfs_hash_bd		bd;
-	int			i;
 
-	/* result is not strictly consistant */
-	cfs_hash_for_each_bucket(ns->ns_rs_hash, &bd, i)
-		res += cfs_hash_bd_count_get(&bd);
-	return sprintf(buf, "%lld\n", res);
+	return sprintf(buf, "%d\n", atomic_read(&ns->ns_rs_hash.nelems));
 }
 LUSTRE_RO_ATTR(resource_count);
 
@@ -663,6 +657,59 @@ static ssize_t max_parallel_ast_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(max_parallel_ast);
 
+static ssize_t max_bl_ast_batch_show(struct kobject *kobj,
+				     struct attribute *attr, char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+
+	return sprintf(buf, "%u\n", ns->ns_max_bl_ast_batch);
+}
+
+static ssize_t max_bl_ast_batch_store(struct kobject *kobj,
+				      struct attribute *attr,
+				      const char *buffer, size_t count)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+	unsigned long tmp;
+	int err;
+
+	err = kstrtoul(buffer, 10, &tmp);
+	if (err != 0)
+		return -EINVAL;
+
+	if (tmp < 1 || tmp > LDLM_MAX_BL_AST_BATCH)
+		return -ERANGE;
+
+	ns->ns_max_bl_ast_batch = tmp;
+
+	return count;
+}
+LUSTRE_RW_ATTR(max_bl_ast_batch);
+
+static ssize_t bl_ast_rpcs_show(struct kobject *kobj, struct attribute *attr,
+				char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+
+	return sprintf(buf, "%lld\n",
+		       (long long)atomic64_read(&ns->ns_bl_ast_rpcs));
+}
+LUSTRE_RO_ATTR(bl_ast_rpcs);
+
+static ssize_t bl_ast_locks_show(struct kobject *kobj, struct attribute *attr,
+				 char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+
+	return sprintf(buf, "%lld\n",
+		       (long long)atomic64_read(&ns->ns_bl_ast_locks));
+}
+LUSTRE_RO_ATTR(bl_ast_locks);
+
 #endif /* HAVE_SERVER_SUPPORT */
 
 /* These are for namespaces in /sys/fs/lustre/ldlm/namespaces/ */
@@ -681,6 +728,9 @@ static struct attribute *ldlm_ns_attrs[] = {
 	&lustre_attr_contention_seconds.attr,
 	&lustre_attr_contended_locks.attr,
 	&lustre_attr_max_parallel_ast.attr,
+	&lustre_attr_max_bl_ast_batch.attr,
+	&lustre_attr_bl_ast_rpcs.attr,
+	&lustre_attr_bl_ast_locks.attr,
 #endif
 	NULL,
 };
@@ -755,158 +805,58 @@ static int ldlm_namespace_debugfs_register(struct ldlm_namespace *ns)
 }
 #undef MAX_STRING_SIZE
 
-static unsigned ldlm_res_hop_hash(struct cfs_hash *hs,
-                                  const void *key, unsigned mask)
-{
-        const struct ldlm_res_id     *id  = key;
-        unsigned                val = 0;
-        unsigned                i;
-
-        for (i = 0; i < RES_NAME_SIZE; i++)
-                val += id->name[i];
-        return val & mask;
-}
-
-static unsigned ldlm_res_hop_fid_hash(struct cfs_hash *hs,
-                                      const void *key, unsigned mask)
-{
-        const struct ldlm_res_id *id = key;
-        struct lu_fid       fid;
-        __u32               hash;
-        __u32               val;
-
-        fid.f_seq = id->name[LUSTRE_RES_ID_SEQ_OFF];
-        fid.f_oid = (__u32)id->name[LUSTRE_RES_ID_VER_OID_OFF];
-        fid.f_ver = (__u32)(id->name[LUSTRE_RES_ID_VER_OID_OFF] >> 32);
-
-	hash = fid_flatten32(&fid);
-	hash += (hash >> 4) + (hash << 12); /* mixing oid and seq */
-	if (id->name[LUSTRE_RES_ID_HSH_OFF] != 0) {
-		val = id->name[LUSTRE_RES_ID_HSH_OFF];
-		hash += (val >> 5) + (val << 11);
-	} else {
-		val = fid_oid(&fid);
-	}
-	hash = hash_long(hash, hs->hs_bkt_bits);
-	/* give me another random factor */
-	hash -= hash_long((unsigned long)hs, val % 11 + 3);
-
-	hash <<= hs->hs_cur_bits - hs->hs_bkt_bits;
-	hash |= ldlm_res_hop_hash(hs, key, CFS_HASH_NBKT(hs) - 1);
-
-	return hash & mask;
-}
-
-static void *ldlm_res_hop_key(struct hlist_node *hnode)
-{
-        struct ldlm_resource   *res;
-
-	res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
-        return &res->lr_name;
-}
-
-static int ldlm_res_hop_keycmp(const void *key, struct hlist_node *hnode)
-{
-        struct ldlm_resource   *res;
-
-	res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
-        return ldlm_res_eq((const struct ldlm_res_id *)key,
-                           (const struct ldlm_res_id *)&res->lr_name);
-}
-
-static void *ldlm_res_hop_object(struct hlist_node *hnode)
-{
-	return hlist_entry(hnode, struct ldlm_resource, lr_hash);
-}
-
-static void
-ldlm_res_hop_get_locked(struct cfs_hash *hs, struct hlist_node *hnode)
-{
-        struct ldlm_resource *res;
-
-	res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
-        ldlm_resource_getref(res);
-}
+static const struct rhashtable_params ldlm_res_hash_params = {
+	.key_len		= sizeof(struct ldlm_res_id),
+	.key_offset		= offsetof(struct ldlm_resource, lr_name),
+	.head_offset		= offsetof(struct ldlm_resource, lr_hash),
+	.automatic_shrinking	= true,
+};
 
-static void ldlm_res_hop_put(struct cfs_hash *hs, struct hlist_node *hnode)
+/** Bucket of the adaptive timeout estimate for resource \a name. */
+static struct ldlm_ns_bucket *
+ldlm_ns_bucket(struct ldlm_namespace *ns, const struct ldlm_res_id *name)
 {
-        struct ldlm_resource *res;
+	u32 hash;
 
-	res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
-        ldlm_resource_putref(res);
+	hash = jhash2((const u32 *)name->name, sizeof(*name) / sizeof(u32), 0);
+	return &ns->ns_rs_buckets[cfs_hash_32(hash, ns->ns_rs_bucket_bits)];
 }
 
-static struct cfs_hash_ops ldlm_ns_hash_ops = {
-        .hs_hash        = ldlm_res_hop_hash,
-        .hs_key         = ldlm_res_hop_key,
-        .hs_keycmp      = ldlm_res_hop_keycmp,
-        .hs_keycpy      = NULL,
-        .hs_object      = ldlm_res_hop_object,
-        .hs_get         = ldlm_res_hop_get_locked,
-        .hs_put         = ldlm_res_hop_put
-};
-
-static struct cfs_hash_ops ldlm_ns_fid_hash_ops = {
-        .hs_hash        = ldlm_res_hop_fid_hash,
-        .hs_key         = ldlm_res_hop_key,
-        .hs_keycmp      = ldlm_res_hop_keycmp,
-        .hs_keycpy      = NULL,
-        .hs_object      = ldlm_res_hop_object,
-        .hs_get         = ldlm_res_hop_get_locked,
-        .hs_put         = ldlm_res_hop_put
-};
-
 typedef struct ldlm_ns_hash_def {
 	enum ldlm_ns_type	nsd_type;
 	/** hash bucket bits */
 	unsigned		nsd_bkt_bits;
-	/** hash bits */
-	unsigned		nsd_all_bits;
-	/** hash operations */
-	struct cfs_hash_ops *nsd_hops;
 } ldlm_ns_hash_def_t;
 
 static struct ldlm_ns_hash_def ldlm_ns_hash_defs[] =
 {
-        {
-                .nsd_type       = LDLM_NS_TYPE_MDC,
-                .nsd_bkt_bits   = 11,
-                .nsd_all_bits   = 16,
-                .nsd_hops       = &ldlm_ns_fid_hash_ops,
-        },
-        {
-                .nsd_type       = LDLM_NS_TYPE_MDT,
-                .nsd_bkt_bits   = 14,
-                .nsd_all_bits   = 21,
-                .nsd_hops       = &ldlm_ns_fid_hash_ops,
-        },
-        {
-                .nsd_type       = LDLM_NS_TYPE_OSC,
-                .nsd_bkt_bits   = 8,
-                .nsd_all_bits   = 12,
-                .nsd_hops       = &ldlm_ns_hash_ops,
-        },
-        {
-                .nsd_type       = LDLM_NS_TYPE_OST,
-                .nsd_bkt_bits   = 11,
-                .nsd_all_bits   = 17,
-                .nsd_hops       = &ldlm_ns_hash_ops,
-        },
-        {
-                .nsd_type       = LDLM_NS_TYPE_MGC,
-                .nsd_bkt_bits   = 4,
-                .nsd_all_bits   = 4,
-                .nsd_hops       = &ldlm_ns_hash_ops,
-        },
-        {
-                .nsd_type       = LDLM_NS_TYPE_MGT,
-                .nsd_bkt_bits   = 4,
-                .nsd_all_bits   = 4,
-                .nsd_hops       = &ldlm_ns_hash_ops,
-        },
-        {
-                .nsd_type       = LDLM_NS_TYPE_UNKNOWN,
-        },
+	{
+		.nsd_type	= LDLM_NS_TYPE_MDC,
+		.nsd_bkt_bits	= 11,
+	},
+	{
+		.nsd_type	= LDLM_NS_TYPE_MDT,
+		.nsd_bkt_bits	= 14,
+	},
+	{
+		.nsd_type	= LDLM_NS_TYPE_OSC,
+		.nsd_bkt_bits	= 8,
+	},
+	{
+		.nsd_type	= LDLM_NS_TYPE_OST,
+		.nsd_bkt_bits	= 11,
+	},
+	{
+		.nsd_type	= LDLM_NS_TYPE_MGC,
+		.nsd_bkt_bits	= 4,
+	},
+	{
+		.nsd_type	= LDLM_NS_TYPE_MGT,
+		.nsd_bkt_bits	= 4,
+	},
+	{
+		.nsd_type	= LDLM_NS_TYPE_UNKNOWN,
+	},
 };
 
 /**
@@ -920,7 +870,6 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 	struct ldlm_namespace *ns = NULL;
 	struct ldlm_ns_bucket *nsb;
 	struct ldlm_ns_hash_def *nsd;
-	struct cfs_hash_bd bd;
 	int idx;
 	int rc;
 	ENTRY;
@@ -948,25 +897,21 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
         if (!ns)
                 GOTO(out_ref, NULL);
 
-        ns->ns_rs_hash = cfs_hash_create(name,
-                                         nsd->nsd_all_bits, nsd->nsd_all_bits,
-                                         nsd->nsd_bkt_bits, sizeof(*nsb),
-                                         CFS_HASH_MIN_THETA,
-                                         CFS_HASH_MAX_THETA,
-                                         nsd->nsd_hops,
-                                         CFS_HASH_DEPTH |
-                                         CFS_HASH_BIGNAME |
-                                         CFS_HASH_SPIN_BKTLOCK |
-                                         CFS_HASH_NO_ITEMREF);
-        if (ns->ns_rs_hash == NULL)
-                GOTO(out_ns, NULL);
-
-        cfs_hash_for_each_bucket(ns->ns_rs_hash, &bd, idx) {
-                nsb = cfs_hash_bd_extra_get(ns->ns_rs_hash, &bd);
-                at_init(&nsb->nsb_at_estimate, ldlm_enqueue_min, 0);
-                nsb->nsb_namespace = ns;
-		nsb->nsb_reclaim_start = 0;
-        }
+	rc = rhashtable_init(&ns->ns_rs_hash, &ldlm_res_hash_params);
+	if (rc)
+		GOTO(out_ns, NULL);
+
+	ns->ns_rs_bucket_bits = nsd->nsd_bkt_bits;
+	OBD_ALLOC_LARGE(ns->ns_rs_buckets,
+			sizeof(*nsb) << ns->ns_rs_bucket_bits);
+	if (ns->ns_rs_buckets == NULL)
+		GOTO(out_rhash, NULL);
+
+	for (idx = 0; idx < (1 << ns->ns_rs_bucket_bits); idx++) {
+		nsb = &ns->ns_rs_buckets[idx];
+		at_init(&nsb->nsb_at_estimate, ldlm_enqueue_min, 0);
+		nsb->nsb_namespace = ns;
+	}
 
 	ns->ns_obd = obd;
 	ns->ns_appetite = apt;
@@ -986,6 +931,9 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 	ns->ns_contended_locks    = NS_DEFAULT_CONTENDED_LOCKS;
 
         ns->ns_max_parallel_ast   = LDLM_DEFAULT_PARALLEL_AST_LIMIT;
+	ns->ns_max_bl_ast_batch   = LDLM_DEFAULT_BL_AST_BATCH;
+	atomic64_set(&ns->ns_bl_ast_rpcs, 0);
+	atomic64_set(&ns->ns_bl_ast_locks, 0);
         ns->ns_nr_unused          = 0;
         ns->ns_max_unused         = LDLM_DEFAULT_LRU_SIZE;
 	ns->ns_max_age            = ktime_set(LDLM_DEFAULT_MAX_ALIVE, 0);
@@ -1026,7 +974,10 @@ out_sysfs:
 	ldlm_namespace_cleanup(ns, 0);
 out_hash:
 	kfree(ns->ns_name);
-	cfs_hash_putref(ns->ns_rs_hash);
+	OBD_FREE_LARGE(ns->ns_rs_buckets,
+		       sizeof(*ns->ns_rs_buckets) << ns->ns_rs_bucket_bits);
+out_rhash:
+	rhashtable_destroy(&ns->ns_rs_hash);
 out_ns:
         OBD_FREE_PTR(ns);
 out_ref:
@@ -1122,10 +1073,8 @@ static void cleanup_resource(struct ldlm_resource *res, struct list_head *q,
         } while (1);
 }
 
-static int ldlm_resource_clean(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-			       struct hlist_node *hnode, void *arg)
+static int ldlm_resource_clean(struct ldlm_resource *res, void *arg)
 {
-	struct ldlm_resource *res = cfs_hash_object(hs, hnode);
 	__u64 flags = *(__u64 *)arg;
 
 	cleanup_resource(res, &res->lr_granted, flags);
@@ -1134,11 +1083,8 @@ static int ldlm_resource_clean(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 	return 0;
 }
 
-static int ldlm_resource_complain(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-				  struct hlist_node *hnode, void *arg)
+static int ldlm_resource_complain(struct ldlm_resource *res, void *arg)
 {
-	struct ldlm_resource  *res = cfs_hash_object(hs, hnode);
-
 	lock_res(res);
 	CERROR("%s: namespace resource "DLDLMRES" (%p) refcount nonzero "
 	       "(%d) after lock cleanup; forcing cleanup.\n",
@@ -1165,10 +1111,8 @@ int ldlm_namespace_cleanup(struct ldlm_namespace *ns, __u64 flags)
                 return ELDLM_OK;
         }
 
-	cfs_hash_for_each_nolock(ns->ns_rs_hash, ldlm_resource_clean,
-				 &flags, 0);
-	cfs_hash_for_each_nolock(ns->ns_rs_hash, ldlm_resource_complain,
-				 NULL, 0);
+	ldlm_namespace_res_foreach(ns, ldlm_resource_clean, &flags);
+	ldlm_namespace_res_foreach(ns, ldlm_resource_complain, NULL);
 	return ELDLM_OK;
 }
 EXPORT_SYMBOL(ldlm_namespace_cleanup);
@@ -1290,7 +1234,9 @@ void ldlm_namespace_free_post(struct ldlm_namespace *ns)
 
 	ldlm_namespace_debugfs_unregister(ns);
 	ldlm_namespace_sysfs_unregister(ns);
-	cfs_hash_putref(ns->ns_rs_hash);
+	rhashtable_destroy(&ns->ns_rs_hash);
+	OBD_FREE_LARGE(ns->ns_rs_buckets,
+		       sizeof(*ns->ns_rs_buckets) << ns->ns_rs_bucket_bits);
 	kfree(ns->ns_name);
 	/* Namespace \a ns should be not on list at this time, otherwise
 	 * this will cause issues related to using freed \a ns in poold
@@ -1401,7 +1347,8 @@ struct ldlm_namespace *ldlm_namespace_first_locked(enum ldlm_side client)
 }
 
 /** Create and initialize new resource. */
-static struct ldlm_resource *ldlm_resource_new(enum ldlm_type ldlm_type)
+static struct ldlm_resource *ldlm_resource_new(struct ldlm_namespace *ns,
+					       enum ldlm_type ldlm_type)
 {
 	struct ldlm_resource *res;
 	int idx;
@@ -1425,6 +1372,15 @@ static struct ldlm_resource *ldlm_resource_new(enum ldlm_type ldlm_type)
 		}
 	}
 
+	/* Granted IBITS locks of servers are indexed by inode bit. */
+	if (ldlm_type == LDLM_IBITS && ns_is_server(ns)) {
+		res->lr_ibits_queues = ldlm_ibits_queues_alloc();
+		if (res->lr_ibits_queues == NULL) {
+			OBD_SLAB_FREE_PTR(res, ldlm_resource_slab);
+			return NULL;
+		}
+	}
+
 	INIT_LIST_HEAD(&res->lr_granted);
 	INIT_LIST_HEAD(&res->lr_waiting);
 
@@ -1440,10 +1396,45 @@ static struct ldlm_resource *ldlm_resource_new(enum ldlm_type ldlm_type)
 	return res;
 }
 
+/** Free a resource which is not, or no longer, in the namespace hash. */
+static void ldlm_resource_free(struct ldlm_resource *res)
+{
+	if (res->lr_itree != NULL)
+		OBD_SLAB_FREE(res->lr_itree, ldlm_interval_tree_slab,
+			      sizeof(*res->lr_itree) * LCK_MODE_NUM);
+	if (res->lr_ibits_queues != NULL)
+		ldlm_ibits_queues_free(res->lr_ibits_queues);
+	OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+}
+
+static void ldlm_resource_free_rcu(struct rcu_head *head)
+{
+	ldlm_resource_free(container_of(head, struct ldlm_resource, lr_rcu));
+}
+
+/**
+ * Look up resource \a name in the hash of \a ns without taking any lock.
+ * Resources whose last reference is being dropped are not returned.
+ */
+static struct ldlm_resource *
+ldlm_resource_lookup(struct ldlm_namespace *ns, const struct ldlm_res_id *name)
+{
+	struct ldlm_resource *res;
+
+	rcu_read_lock();
+	res = rhashtable_lookup_fast(&ns->ns_rs_hash, name,
+				     ldlm_res_hash_params);
+	if (res != NULL && !atomic_inc_not_zero(&res->lr_refcount))
+		res = NULL;
+	rcu_read_unlock();
+
+	return res;
+}
+
 /**
  * Return a reference to resource with given name, creating it if necessary.
  * Args: namespace with ns_lock unlocked
- * Locks: takes and releases NS hash-lock and res->lr_lock
+ * Locks: takes and releases res->lr_lock, lookups are done under RCU only
  * Returns: referenced, unlocked ldlm_resource or NULL
  */
 struct ldlm_resource *
@@ -1451,63 +1442,58 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
 		  const struct ldlm_res_id *name, enum ldlm_type type,
 		  int create)
 {
-	struct hlist_node	*hnode;
-	struct ldlm_resource	*res = NULL;
-	struct cfs_hash_bd		bd;
-	__u64			version;
+	struct ldlm_resource	*res;
+	struct ldlm_resource	*old;
 	int			ns_refcount = 0;
 
-        LASSERT(ns != NULL);
-        LASSERT(parent == NULL);
-        LASSERT(ns->ns_rs_hash != NULL);
-        LASSERT(name->name[0] != 0);
+	LASSERT(ns != NULL);
+	LASSERT(parent == NULL);
+	LASSERT(name->name[0] != 0);
 
-        cfs_hash_bd_get_and_lock(ns->ns_rs_hash, (void *)name, &bd, 0);
-        hnode = cfs_hash_bd_lookup_locked(ns->ns_rs_hash, &bd, (void *)name);
-        if (hnode != NULL) {
-                cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 0);
-		GOTO(found, res);
-	}
-
-	version = cfs_hash_bd_version_get(&bd);
-	cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 0);
+	res = ldlm_resource_lookup(ns, name);
+	if (res != NULL)
+		return res;
 
 	if (create == 0)
 		return ERR_PTR(-ENOENT);
 
 	LASSERTF(type >= LDLM_MIN_TYPE && type < LDLM_MAX_TYPE,
 		 "type: %d\n", type);
-	res = ldlm_resource_new(type);
+	res = ldlm_resource_new(ns, type);
 	if (res == NULL)
 		return ERR_PTR(-ENOMEM);
 
-	res->lr_ns_bucket = cfs_hash_bd_extra_get(ns->ns_rs_hash, &bd);
+	res->lr_ns_bucket = ldlm_ns_bucket(ns, name);
 	res->lr_name = *name;
 	res->lr_type = type;
 
-	cfs_hash_bd_lock(ns->ns_rs_hash, &bd, 1);
-	hnode = (version == cfs_hash_bd_version_get(&bd)) ? NULL :
-		cfs_hash_bd_lookup_locked(ns->ns_rs_hash, &bd, (void *)name);
-
-	if (hnode != NULL) {
-		/* Someone won the race and already added the resource. */
-		cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
-		/* Clean lu_ref for failed resource. */
-		lu_ref_fini(&res->lr_reference);
-		if (res->lr_itree != NULL)
-			OBD_SLAB_FREE(res->lr_itree, ldlm_interval_tree_slab,
-				      sizeof(*res->lr_itree) * LCK_MODE_NUM);
-		OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
-found:
-		res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
-		return res;
+	for (;;) {
+		rcu_read_lock();
+		old = rhashtable_lookup_get_insert_fast(&ns->ns_rs_hash,
+							&res->lr_hash,
+							ldlm_res_hash_params);
+		if (old == NULL) {
+			rcu_read_unlock();
+			break;
+		}
+
+		if (IS_ERR(old) || atomic_inc_not_zero(&old->lr_refcount)) {
+			/* Someone won the race and already added the
+			 * resource, or the insertion failed. */
+			rcu_read_unlock();
+			lu_ref_fini(&res->lr_reference);
+			ldlm_resource_free(res);
+			return old;
+		}
+		rcu_read_unlock();
+
+		/* The resource found is being freed, wait for it to leave
+		 * the hash. */
+		cond_resched();
 	}
-	/* We won! Let's add the resource. */
-        cfs_hash_bd_add_locked(ns->ns_rs_hash, &bd, &res->lr_hash);
-	if (cfs_hash_bd_count_get(&bd) == 1)
-		ns_refcount = ldlm_namespace_get_return(ns);
 
-        cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
+	/* We won! The resource is added. */
+	ns_refcount = ldlm_namespace_get_return(ns);
 
 	OBD_FAIL_TIMEOUT(OBD_FAIL_LDLM_CREATE_RESOURCE, 2);
 
@@ -1535,11 +1521,9 @@ struct ldlm_resource *ldlm_resource_getref(struct ldlm_resource *res)
 	return res;
 }
 
-static void __ldlm_resource_putref_final(struct cfs_hash_bd *bd,
-                                         struct ldlm_resource *res)
+static void __ldlm_resource_putref_final(struct ldlm_namespace *ns,
+					 struct ldlm_resource *res)
 {
-	struct ldlm_ns_bucket *nsb = res->lr_ns_bucket;
-
 	if (!list_empty(&res->lr_granted)) {
 		ldlm_resource_dump(D_ERROR, res);
 		LBUG();
@@ -1550,39 +1534,76 @@ static void __ldlm_resource_putref_final(struct cfs_hash_bd *bd,
 		LBUG();
 	}
 
-	cfs_hash_bd_del_locked(nsb->nsb_namespace->ns_rs_hash,
-			       bd, &res->lr_hash);
+	rhashtable_remove_fast(&ns->ns_rs_hash, &res->lr_hash,
+			       ldlm_res_hash_params);
 	lu_ref_fini(&res->lr_reference);
-	if (cfs_hash_bd_count_get(bd) == 0)
-		ldlm_namespace_put(nsb->nsb_namespace);
 }
 
 /* Returns 1 if the resource was freed, 0 if it remains. */
 int ldlm_resource_putref(struct ldlm_resource *res)
 {
 	struct ldlm_namespace *ns = ldlm_res_to_ns(res);
-	struct cfs_hash_bd   bd;
 
 	LASSERT_ATOMIC_GT_LT(&res->lr_refcount, 0, LI_POISON);
 	CDEBUG(D_INFO, "putref res: %p count: %d\n",
 	       res, atomic_read(&res->lr_refcount) - 1);
 
-	cfs_hash_bd_get(ns->ns_rs_hash, &res->lr_name, &bd);
-	if (cfs_hash_bd_dec_and_lock(ns->ns_rs_hash, &bd, &res->lr_refcount)) {
-		__ldlm_resource_putref_final(&bd, res);
-		cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
-		if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
-			ns->ns_lvbo->lvbo_free(res);
-		if (res->lr_itree != NULL)
-			OBD_SLAB_FREE(res->lr_itree, ldlm_interval_tree_slab,
-				      sizeof(*res->lr_itree) * LCK_MODE_NUM);
-		OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
-		return 1;
-	}
-	return 0;
+	if (!atomic_dec_and_test(&res->lr_refcount))
+		return 0;
+
+	/* Lookups racing with us see a zero refcount and ignore the
+	 * resource, RCU readers may still see it until the grace period
+	 * ends. */
+	__ldlm_resource_putref_final(ns, res);
+	if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
+		ns->ns_lvbo->lvbo_free(res);
+	call_rcu(&res->lr_rcu, ldlm_resource_free_rcu);
+	ldlm_namespace_put(ns);
+	return 1;
 }
 EXPORT_SYMBOL(ldlm_resource_putref);
 
+/**
+ * Call \a iter for each resource of \a ns until it returns non-zero.
+ *
+ * \a iter is called with a reference held on the resource but not under
+ * RCU read lock, so it may block. Resources added or removed during the
+ * walk may be missed, and a concurrent resize of the hash may make the walk
+ * see some resources twice.
+ *
+ * \retval the last value returned by \a iter
+ */
+int ldlm_namespace_res_foreach(struct ldlm_namespace *ns,
+			       ldlm_res_iterator_t iter, void *closure)
+{
+	struct rhashtable_iter hti;
+	struct ldlm_resource *res;
+	int rc = 0;
+
+	rhashtable_walk_enter(&ns->ns_rs_hash, &hti);
+	rhashtable_walk_start(&hti);
+	while ((res = rhashtable_walk_next(&hti)) != NULL) {
+		/* -EAGAIN: the hash is being resized, carry on */
+		if (IS_ERR(res))
+			continue;
+
+		if (!atomic_inc_not_zero(&res->lr_refcount))
+			continue;
+
+		rhashtable_walk_stop(&hti);
+		rc = iter(res, closure);
+		ldlm_resource_putref(res);
+		rhashtable_walk_start(&hti);
+		if (rc)
+			break;
+	}
+	rhashtable_walk_stop(&hti);
+	rhashtable_walk_exit(&hti);
+
+	return rc;
+}
+EXPORT_SYMBOL(ldlm_namespace_res_foreach);
+
 /**
  * Add a lock into a given resource into specified lock list.
  */
@@ -1638,6 +1659,8 @@ void ldlm_resource_unlink_lock(struct ldlm_lock *lock)
                 ldlm_unlink_lock_skiplist(lock);
         else if (type == LDLM_EXTENT)
                 ldlm_extent_unlink_lock(lock);
+	if (type == LDLM_IBITS)
+		ldlm_inodebits_unlink_lock(lock);
 	list_del_init(&lock->l_res_link);
 }
 EXPORT_SYMBOL(ldlm_resource_unlink_lock);
@@ -1671,10 +1694,8 @@ void ldlm_dump_all_namespaces(enum ldlm_side client, int level)
 	mutex_unlock(ldlm_namespace_lock(client));
 }
 
-static int ldlm_res_hash_dump(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-			      struct hlist_node *hnode, void *arg)
+static int ldlm_res_hash_dump(struct ldlm_resource *res, void *arg)
 {
-        struct ldlm_resource *res = cfs_hash_object(hs, hnode);
         int    level = (int)(unsigned long)arg;
 
         lock_res(res);
@@ -1700,9 +1721,8 @@ void ldlm_namespace_dump(int level, struct ldlm_namespace *ns)
 	if (ktime_get_seconds() < ns->ns_next_dump)
 		return;
 
-	cfs_hash_for_each_nolock(ns->ns_rs_hash,
-				 ldlm_res_hash_dump,
-				 (void *)(unsigned long)level, 0);
+	ldlm_namespace_res_foreach(ns, ldlm_res_hash_dump,
+				   (void *)(unsigned long)level);
 	spin_lock(&ns->ns_lock);
 	ns->ns_next_dump = ktime_get_seconds() + 10;
 	spin_unlock(&ns->ns_lock);
@@ -43,8 +43,9 @@
  *    it stores index in both slave LMV EA and in linkEA, if the two copies
  *    match, then trust them.
  *
- * 3) lmv_hash_type: The valid hash type should be LMV_HASH_TYPE_ALL_CHARS or
- *    LMV_HASH_TYPE_FNV_1A_64. If the LFSCK instance on some slave finds that
+ * 3) lmv_hash_type: The valid hash type should be LMV_HASH_TYPE_ALL_CHARS,
+ *    LMV_HASH_TYPE_FNV_1A_64 or LMV_HASH_TYPE_JUMP, as checked by
+ *    lmv_is_known_hash_type(). If the LFSCK instance on some slave finds that
  *    the name hash against the hash function does not match the MDT, then it
  *    will change the master LMV EA hash type as LMV_HASH_TYPE_UNKNOWN. With
  *    such hash type, the whole striped directory still can be accessed via
@@ -423,6 +423,19 @@ static int ll_send_mgc_param(struct obd_export *mgc, char *string)
 }
 #endif
 
+/*
+ * Old servers don't check hash type, and would create a directory in which
+ * no name can be created, so jump hash is only used if server supports it.
+ */
+static int ll_dir_hash_type_check(struct inode *inode, __u32 hash_type)
+{
+	if ((hash_type & LMV_HASH_TYPE_MASK) == LMV_HASH_TYPE_JUMP &&
+	    !exp_connect_jump_hash(ll_i2mdexp(inode)))
+		return -EOPNOTSUPP;
+
+	return 0;
+}
+
 /**
  * Create striped directory with specified stripe(@lump)
  *
@@ -475,6 +488,10 @@ static int ll_dir_setdirstripe(struct dentry *dparent, struct lmv_user_md *lump,
 	    lump->lum_magic != cpu_to_le32(LMV_USER_MAGIC_SPECIFIC))
 		lustre_swab_lmv_user_md(lump);
 
+	err = ll_dir_hash_type_check(parent, lump->lum_hash_type);
+	if (err)
+		RETURN(err);
+
 	if (!IS_POSIXACL(parent) || !exp_connect_umask(ll_i2mdexp(parent)))
 		mode &= ~current_umask();
 	mode = (mode & (S_IRWXUGO | S_ISVTX)) | S_IFDIR;
@@ -1393,7 +1410,16 @@ lmv_out_free:
 		if (lum.lum_magic != LMV_USER_MAGIC)
 			RETURN(-EINVAL);
 
+		rc = ll_dir_hash_type_check(inode, lum.lum_hash_type);
+		if (rc)
+			RETURN(rc);
+
 		rc = ll_dir_setstripe(inode, (struct lov_user_md *)&lum, 0);
+		if (rc == 0) {
+			/* fetch the new default LMV on next mkdir */
+			ll_i2info(inode)->lli_def_stripe_offset = -1;
+			ll_i2info(inode)->lli_def_placement = -1;
+		}
 
 		RETURN(rc);
 	}
@@ -1784,7 +1810,7 @@ out_rmdir:
 					break;
 				}
 
-				rc = ll_hsm_release(f);
+				rc = ll_hsm_release(f, NULL);
 				iput(f);
 				if (rc != 0)
 					break;
@@ -1899,6 +1925,10 @@ out_hur:
 			GOTO(migrate_free, rc);
 		}
 
+		rc = ll_dir_hash_type_check(inode, lum->lum_hash_type);
+		if (rc)
+			GOTO(migrate_free, rc);
+
 		rc = ll_migrate(inode, file, lum, filename);
 migrate_free:
 		OBD_FREE_LARGE(buf, len);
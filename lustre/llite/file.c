@@ -39,6 +39,7 @@
 #define DEBUG_SUBSYSTEM S_LLITE
 #include <lustre_dlm.h>
 #include <linux/pagemap.h>
+#include <linux/falloc.h>
 #include <linux/file.h>
 #include <linux/sched.h>
 #include <linux/user_namespace.h>
@@ -379,6 +380,8 @@ int ll_file_release(struct inode *inode, struct file *file)
 		lli->lli_async_rc = 0;
 	}
 
+	pcc_file_release(inode, file);
+
 	rc = ll_md_close(inode, file);
 
 	if (CFS_FAIL_TIMEOUT_MS(OBD_FAIL_PTLRPC_DUMP_LOG, cfs_fail_val))
@@ -796,6 +799,16 @@ restart:
                 GOTO(out_och_free, rc);
 
 	cl_lov_delay_create_clear(&file->f_flags);
+
+	/* If the cached copy cannot be opened, I/O goes to Lustre instead,
+	 * which restores the file. */
+	rc = pcc_file_open(inode, file);
+	if (rc) {
+		CDEBUG(D_INODE, "%s: cannot open PCC copy of "DFID": rc = %d\n",
+		       ll_get_fsname(inode->i_sb, NULL, 0),
+		       PFID(ll_inode2fid(inode)), rc);
+		rc = 0;
+	}
 	GOTO(out_och_free, rc);
 
 out_och_free:
@@ -1318,7 +1331,7 @@ static bool file_is_noatime(const struct file *file)
 	return false;
 }
 
-static void ll_io_init(struct cl_io *io, struct file *file, enum cl_io_type iot)
+void ll_io_init(struct cl_io *io, struct file *file, enum cl_io_type iot)
 {
 	struct inode *inode = file_inode(file);
 	struct ll_file_data *fd  = LUSTRE_FPRIVATE(file);
@@ -1360,8 +1373,10 @@ ll_file_io_generic(const struct lu_env *env, struct vvp_io_args *args,
 	struct ll_file_data	*fd  = LUSTRE_FPRIVATE(file);
 	struct range_lock	range;
 	struct cl_io		*io;
+	struct ll_dio_aio	*aio = NULL;
 	ssize_t			result = 0;
 	int			rc = 0;
+	int			rc2 = 0;
 	unsigned		retried = 0;
 	bool			restarted = false;
 
@@ -1371,6 +1386,14 @@ ll_file_io_generic(const struct lu_env *env, struct vvp_io_args *args,
 		file_dentry(file)->d_name.name,
 		iot == CIT_READ ? "read" : "write", *ppos, count);
 
+	/* all the pages of a direct I/O are tracked together, across
+	 * stripes and restarts, so that it can complete asynchronously */
+	if (args->via_io_subtype == IO_NORMAL && file->f_flags & O_DIRECT) {
+		aio = ll_dio_aio_alloc(args->u.normal.via_iocb);
+		if (aio == NULL)
+			RETURN(-ENOMEM);
+	}
+
 restart:
 	io = vvp_env_thread_io(env);
 	ll_io_init(io, file, iot);
@@ -1391,12 +1414,14 @@ restart:
 		case IO_NORMAL:
 			vio->vui_iter = args->u.normal.via_iter;
 			vio->vui_iocb = args->u.normal.via_iocb;
+			vio->vui_aio = aio;
 			/* Direct IO reads must also take range lock,
 			 * or multiple reads will try to work on the same pages
 			 * See LU-6227 for details. */
 			if (((iot == CIT_WRITE) ||
 			    (iot == CIT_READ && (file->f_flags & O_DIRECT))) &&
-			    !(vio->vui_fd->fd_flags & LL_FILE_GROUP_LOCKED)) {
+			    !(vio->vui_fd->fd_flags & LL_FILE_GROUP_LOCKED) &&
+			    !args->via_range_locked) {
 				CDEBUG(D_VFSTRACE, "Range lock "RL_FMT"\n",
 				       RL_PARA(&range));
 				rc = range_lock(&lli->lli_write_tree, &range);
@@ -1458,6 +1483,17 @@ out:
 		goto restart;
 	}
 
+	if (aio != NULL) {
+		rc2 = ll_dio_aio_finish(env, aio, result);
+		if (rc2 < 0 && rc2 != -EIOCBQUEUED) {
+			result = 0;
+			rc = rc2;
+		}
+	}
+
+	if (result > 0)
+		ll_heat_add(inode, iot, result);
+
 	if (iot == CIT_READ) {
 		if (result > 0)
 			ll_stats_ops_tally(ll_i2sbi(inode),
@@ -1480,6 +1516,9 @@ out:
 
 	CDEBUG(D_VFSTRACE, "iot: %d, result: %zd\n", iot, result);
 
+	if (rc2 == -EIOCBQUEUED)
+		RETURN(rc2);
+
 	RETURN(result > 0 ? result : rc);
 }
 
@@ -1539,9 +1578,11 @@ ll_do_fast_read(struct kiocb *iocb, struct iov_iter *iter)
 	if (result == -ENODATA)
 		result = 0;
 
-	if (result > 0)
+	if (result > 0) {
+		ll_heat_add(file_inode(iocb->ki_filp), CIT_READ, result);
 		ll_stats_ops_tally(ll_i2sbi(file_inode(iocb->ki_filp)),
 				LPROC_LL_READ_BYTES, result);
+	}
 
 	return result;
 }
@@ -1556,6 +1597,11 @@ static ssize_t ll_file_read_iter(struct kiocb *iocb, struct iov_iter *to)
 	ssize_t result;
 	ssize_t rc2;
 	__u16 refcheck;
+	bool cached;
+
+	result = pcc_file_read_iter(iocb, to, &cached);
+	if (cached)
+		return result;
 
 	result = ll_do_fast_read(iocb, to);
 	if (result < 0 || iov_iter_count(to) == 0)
@@ -1581,51 +1627,92 @@ out:
 	return result;
 }
 
+/*
+ * Check whether the page at \a index can take a fast write: it has to be in
+ * the page cache, up to date and not under writeback. A dirty page is covered
+ * by a granted DLM lock and has been charged grant by the OSC already, a clean
+ * one needs its cl_page to be queued into the write-back cache.
+ * ll_tiny_write_begin() checks it again under the page lock.
+ */
+static bool ll_fast_write_page(struct address_space *mapping, pgoff_t index)
+{
+	struct page *vmpage;
+	bool rc;
+
+	vmpage = find_get_page(mapping, index);
+	if (vmpage == NULL)
+		return false;
+
+	rc = PageUptodate(vmpage) && !PageWriteback(vmpage) &&
+	     (PageDirty(vmpage) || PagePrivate(vmpage));
+	put_page(vmpage);
+
+	return rc;
+}
+
 /**
- * Similar trick to ll_do_fast_read, this improves write speed for tiny writes.
- * If a page is already in the page cache and dirty (and some other things -
- * See ll_tiny_write_begin for the instantiation of these rules), then we can
- * write to it without doing a full I/O, because Lustre already knows about it
- * and will write it out.  This saves a lot of processing time.
+ * Similar trick to ll_do_fast_read, this improves write speed for writes to
+ * cached pages. If a page is already in the page cache and up to date (and
+ * some other things - See ll_tiny_write_begin for the instantiation of these
+ * rules), then we can write to it without doing a full I/O. A dirty page is
+ * known to Lustre already, which will write it out. A clean page is queued
+ * into the OSC write-back cache directly, when a granted write lock covers
+ * it and the OSC has grant for it. This saves a lot of processing time, as no
+ * cl_io is set up, and neither the layout is walked nor the lock is enqueued.
  *
- * All writes here are within one page, so exclusion is handled by the page
- * lock on the vm page.  We do not do tiny writes for writes which touch
- * multiple pages because it's very unlikely multiple sequential pages are
- * are already dirty.
+ * The write goes page by page and stops at the first page that can't take a
+ * fast write, the rest of it is done by the normal write path. The first page
+ * is checked before starting, so that writes to new pages do not pay for
+ * the attempt.
  *
- * We limit these to < PAGE_SIZE because PAGE_SIZE writes are relatively common
- * and are unlikely to be to already dirty pages.
+ * An append starts from the cached file size, ll_tiny_write_begin checks it
+ * is right once it knows a lock covers the page up to EOF.
  *
- * Attribute updates are important here, we do them in ll_tiny_write_end.
+ * The caller holds the range lock of the write. Attribute updates are
+ * important here, we do them in ll_tiny_write_end.
  */
-static ssize_t ll_do_tiny_write(struct kiocb *iocb, struct iov_iter *iter)
+static ssize_t ll_do_fast_write(struct kiocb *iocb, struct iov_iter *iter)
 {
 	ssize_t count = iov_iter_count(iter);
 	struct file *file = iocb->ki_filp;
 	struct inode *inode = file_inode(file);
+	struct ll_inode_info *lli = ll_i2info(inode);
+	bool lock_inode = !IS_NOSEC(inode);
 	ssize_t result = 0;
 
 	ENTRY;
 
-	/* Restrict writes to single page and < PAGE_SIZE.  See comment at top
-	 * of function for why.
-	 */
-	if (count >= PAGE_SIZE ||
-	    (iocb->ki_pos & (PAGE_SIZE-1)) + count > PAGE_SIZE)
+	if (count == 0)
 		RETURN(0);
 
+	if (file->f_flags & O_APPEND)
+		iocb->ki_pos = i_size_read(inode);
+
+	if (!ll_fast_write_page(inode->i_mapping, iocb->ki_pos >> PAGE_SHIFT))
+		RETURN(0);
+
+	down_read(&lli->lli_trunc_sem);
+	if (lock_inode)
+		inode_lock(inode);
 	result = __generic_file_write_iter(iocb, iter);
+	if (lock_inode)
+		inode_unlock(inode);
+	up_read(&lli->lli_trunc_sem);
 
-	/* If the page is not already dirty, ll_tiny_write_begin returns
-	 * -ENODATA.  We continue on to normal write.
+	/* If the first page can't take a fast write any more,
+	 * ll_tiny_write_begin returns -ENODATA.  We continue on to normal
+	 * write.
 	 */
 	if (result == -ENODATA)
 		result = 0;
 
 	if (result > 0) {
+		ll_heat_add(inode, CIT_WRITE, result);
 		ll_stats_ops_tally(ll_i2sbi(inode), LPROC_LL_WRITE_BYTES,
 				   result);
-		ll_file_set_flag(ll_i2info(inode), LLIF_DATA_MODIFIED);
+		ll_stats_ops_tally(ll_i2sbi(inode), LPROC_LL_FAST_WRITE,
+				   result);
+		ll_file_set_flag(lli, LLIF_DATA_MODIFIED);
 	}
 
 	CDEBUG(D_VFSTRACE, "result: %zu, original count %zu\n", result, count);
@@ -1638,50 +1725,81 @@ static ssize_t ll_do_tiny_write(struct kiocb *iocb, struct iov_iter *iter)
  */
 static ssize_t ll_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 {
+	struct file *file = iocb->ki_filp;
+	struct ll_inode_info *lli = ll_i2info(file_inode(file));
 	struct vvp_io_args *args;
 	struct lu_env *env;
-	ssize_t rc_tiny = 0, rc_normal;
+	struct range_lock range;
+	bool range_locked = false;
+	ssize_t rc_fast = 0, rc_normal;
 	__u16 refcheck;
+	bool cached;
 
 	ENTRY;
 
-	/* NB: we can't do direct IO for tiny writes because they use the page
-	 * cache, we can't do sync writes because tiny writes can't flush
-	 * pages, and we can't do append writes because we can't guarantee the
-	 * required DLM locks are held to protect file size.
+	rc_normal = pcc_file_write_iter(iocb, from, &cached);
+	if (cached)
+		RETURN(rc_normal);
+
+	/* NB: we can't do direct IO for fast writes because they use the page
+	 * cache, and we can't do sync writes because fast writes can't flush
+	 * pages.
 	 */
-	if (ll_sbi_has_tiny_write(ll_i2sbi(file_inode(iocb->ki_filp))) &&
-	    !(iocb->ki_filp->f_flags & (O_DIRECT | O_SYNC | O_APPEND)))
-		rc_tiny = ll_do_tiny_write(iocb, from);
+	if (ll_sbi_has_tiny_write(ll_i2sbi(file_inode(file))) &&
+	    !(file->f_flags & (O_DIRECT | O_SYNC)) &&
+	    iov_iter_count(from) > 0) {
+		/* The range lock covers both the fast write and the rest of
+		 * the write done by the normal path, so that they are not
+		 * mixed with other writes to the range.
+		 */
+		if (!(LUSTRE_FPRIVATE(file)->fd_flags & LL_FILE_GROUP_LOCKED)) {
+			if (file->f_flags & O_APPEND)
+				range_lock_init(&range, 0, LUSTRE_EOF);
+			else
+				range_lock_init(&range, iocb->ki_pos,
+						iocb->ki_pos +
+						iov_iter_count(from) - 1);
+			rc_normal = range_lock(&lli->lli_write_tree, &range);
+			if (rc_normal < 0)
+				RETURN(rc_normal);
+			range_locked = true;
+		}
 
-	/* In case of error, go on and try normal write - Only stop if tiny
+		rc_fast = ll_do_fast_write(iocb, from);
+	}
+
+	/* In case of error, go on and try normal write - Only stop if fast
 	 * write completed I/O.
 	 */
 	if (iov_iter_count(from) == 0)
-		GOTO(out, rc_normal = rc_tiny);
+		GOTO(out, rc_normal = rc_fast);
 
 	env = cl_env_get(&refcheck);
 	if (IS_ERR(env))
-		return PTR_ERR(env);
+		GOTO(out, rc_normal = rc_fast > 0 ? rc_fast : PTR_ERR(env));
 
 	args = ll_env_args(env, IO_NORMAL);
 	args->u.normal.via_iter = from;
 	args->u.normal.via_iocb = iocb;
+	args->via_range_locked = range_locked;
 
-	rc_normal = ll_file_io_generic(env, args, iocb->ki_filp, CIT_WRITE,
-				    &iocb->ki_pos, iov_iter_count(from));
+	rc_normal = ll_file_io_generic(env, args, file, CIT_WRITE,
+				       &iocb->ki_pos, iov_iter_count(from));
 
 	/* On success, combine bytes written. */
-	if (rc_tiny >= 0 && rc_normal > 0)
-		rc_normal += rc_tiny;
-	/* On error, only return error from normal write if tiny write did not
-	 * write any bytes.  Otherwise return bytes written by tiny write.
+	if (rc_fast >= 0 && rc_normal > 0)
+		rc_normal += rc_fast;
+	/* On error, only return error from normal write if fast write did not
+	 * write any bytes.  Otherwise return bytes written by fast write.
 	 */
-	else if (rc_tiny > 0)
-		rc_normal = rc_tiny;
+	else if (rc_fast > 0)
+		rc_normal = rc_fast;
 
 	cl_env_put(env, &refcheck);
 out:
+	if (range_locked)
+		range_unlock(&lli->lli_write_tree, &range);
+
 	RETURN(rc_normal);
 }
 
@@ -2372,8 +2490,11 @@ int ll_data_version(struct inode *inode, __u64 *data_version, int flags)
 
 /*
  * Trigger a HSM release request for the provided inode.
+ *
+ * If \a file is not NULL, the release lease is taken on behalf of its open
+ * handle, so that the file itself being open does not make the lease fail.
  */
-int ll_hsm_release(struct inode *inode)
+int ll_hsm_release(struct inode *inode, struct file *file)
 {
 	struct lu_env *env;
 	struct obd_client_handle *och = NULL;
@@ -2386,9 +2507,9 @@ int ll_hsm_release(struct inode *inode)
 	       ll_get_fsname(inode->i_sb, NULL, 0),
 	       PFID(&ll_i2info(inode)->lli_fid));
 
-	och = ll_lease_open(inode, NULL, FMODE_WRITE, MDS_OPEN_RELEASE);
+	och = ll_lease_open(inode, file, FMODE_WRITE, MDS_OPEN_RELEASE);
 	if (IS_ERR(och))
-		GOTO(out, rc = PTR_ERR(och));
+		RETURN(PTR_ERR(och));
 
 	/* Grab latest data_version and [am]time values */
 	rc = ll_data_version(inode, &data_version, LL_DV_WR_FLUSH);
@@ -2417,9 +2538,17 @@ int ll_hsm_release(struct inode *inode)
 
 	EXIT;
 out:
-	if (och != NULL && !IS_ERR(och)) /* close the file */
+	if (och != NULL) /* close the file */
 		ll_lease_close(och, inode, NULL);
 
+	if (file != NULL) {
+		int rc2;
+
+		rc2 = ll_lease_och_release(inode, file);
+		if (rc == 0)
+			rc = rc2;
+	}
+
 	return rc;
 }
 
@@ -2538,6 +2667,25 @@ free:
 	RETURN(rc);
 }
 
+int ll_hsm_state_get(struct inode *inode, struct hsm_user_state *hus)
+{
+	struct md_op_data *op_data;
+	int rc;
+	ENTRY;
+
+	op_data = ll_prep_md_op_data(NULL, inode, NULL, NULL, 0, 0,
+				     LUSTRE_OPC_ANY, hus);
+	if (IS_ERR(op_data))
+		RETURN(PTR_ERR(op_data));
+
+	rc = obd_iocontrol(LL_IOC_HSM_STATE_GET, ll_i2mdexp(inode),
+			   sizeof(*op_data), op_data, NULL);
+
+	ll_finish_md_op_data(op_data);
+
+	RETURN(rc);
+}
+
 int ll_hsm_state_set(struct inode *inode, struct hsm_state_set *hss)
 {
 	struct obd_export *exp = ll_i2mdexp(inode);
@@ -3212,6 +3360,72 @@ static long ll_file_set_lease(struct file *file, struct ll_ioc_lease *ioc,
 	RETURN(rc);
 }
 
+void ll_heat_add(struct inode *inode, enum cl_io_type iot, __u64 count)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	enum obd_heat_type sample_type;
+	enum obd_heat_type iobyte_type;
+	__u64 now = ktime_get_real_seconds();
+
+	if (!ll_sbi_has_file_heat(sbi) ||
+	    lli->lli_heat_flags & LU_HEAT_FLAG_OFF)
+		return;
+
+	if (iot == CIT_READ) {
+		sample_type = OBD_HEAT_READSAMPLE;
+		iobyte_type = OBD_HEAT_READBYTE;
+	} else if (iot == CIT_WRITE) {
+		sample_type = OBD_HEAT_WRITESAMPLE;
+		iobyte_type = OBD_HEAT_WRITEBYTE;
+	} else {
+		return;
+	}
+
+	spin_lock(&lli->lli_heat_lock);
+	obd_heat_add(&lli->lli_heat_instances[sample_type], now, 1,
+		     sbi->ll_heat_decay_weight, sbi->ll_heat_period_second);
+	obd_heat_add(&lli->lli_heat_instances[iobyte_type], now, count,
+		     sbi->ll_heat_decay_weight, sbi->ll_heat_period_second);
+	spin_unlock(&lli->lli_heat_lock);
+}
+
+static int ll_heat_get(struct inode *inode, struct lu_heat *heat)
+{
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	struct ll_inode_info *lli = ll_i2info(inode);
+	__u64 now = ktime_get_real_seconds();
+	int i;
+
+	spin_lock(&lli->lli_heat_lock);
+	heat->lh_flags = lli->lli_heat_flags;
+	for (i = 0; i < heat->lh_count; i++)
+		heat->lh_heat[i] = obd_heat_get(&lli->lli_heat_instances[i],
+						now, sbi->ll_heat_decay_weight,
+						sbi->ll_heat_period_second);
+	spin_unlock(&lli->lli_heat_lock);
+
+	return 0;
+}
+
+static int ll_heat_set(struct inode *inode, enum lu_heat_flag flags)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+
+	spin_lock(&lli->lli_heat_lock);
+	if (flags & LU_HEAT_FLAG_CLEAR)
+		obd_heat_clear(lli->lli_heat_instances, OBD_HEAT_COUNT);
+
+	if (flags & LU_HEAT_FLAG_OFF)
+		lli->lli_heat_flags |= LU_HEAT_FLAG_OFF;
+	else
+		lli->lli_heat_flags &= ~LU_HEAT_FLAG_OFF;
+
+	spin_unlock(&lli->lli_heat_lock);
+
+	return 0;
+}
+
 static long
 ll_file_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
@@ -3370,7 +3584,6 @@ out:
 	case OBD_IOC_GETMDNAME:
 		RETURN(ll_get_obd_name(inode, cmd, arg));
 	case LL_IOC_HSM_STATE_GET: {
-		struct md_op_data	*op_data;
 		struct hsm_user_state	*hus;
 		int			 rc;
 
@@ -3378,20 +3591,10 @@ out:
 		if (hus == NULL)
 			RETURN(-ENOMEM);
 
-		op_data = ll_prep_md_op_data(NULL, inode, NULL, NULL, 0, 0,
-					     LUSTRE_OPC_ANY, hus);
-		if (IS_ERR(op_data)) {
-			OBD_FREE_PTR(hus);
-			RETURN(PTR_ERR(op_data));
-		}
-
-		rc = obd_iocontrol(cmd, ll_i2mdexp(inode), sizeof(*op_data),
-				   op_data, NULL);
-
+		rc = ll_hsm_state_get(inode, hus);
 		if (copy_to_user((void __user *)arg, hus, sizeof(*hus)))
 			rc = -EFAULT;
 
-		ll_finish_md_op_data(op_data);
 		OBD_FREE_PTR(hus);
 		RETURN(rc);
 	}
@@ -3595,6 +3798,69 @@ out_ladvise:
 		RETURN(ll_ioctl_fssetxattr(inode, cmd, arg));
 	case BLKSSZGET:
 		RETURN(put_user(PAGE_SIZE, (int __user *)arg));
+	case LL_IOC_HEAT_GET: {
+		struct lu_heat uheat;
+		struct lu_heat *heat;
+		int size;
+
+		if (copy_from_user(&uheat, (void __user *)arg, sizeof(uheat)))
+			RETURN(-EFAULT);
+
+		if (uheat.lh_count > OBD_HEAT_COUNT)
+			uheat.lh_count = OBD_HEAT_COUNT;
+
+		size = offsetof(typeof(uheat), lh_heat[uheat.lh_count]);
+		OBD_ALLOC(heat, size);
+		if (heat == NULL)
+			RETURN(-ENOMEM);
+
+		heat->lh_count = uheat.lh_count;
+		ll_heat_get(inode, heat);
+		rc = copy_to_user((char __user *)arg, heat, size);
+		OBD_FREE(heat, size);
+		RETURN(rc ? -EFAULT : 0);
+	}
+	case LL_IOC_HEAT_SET: {
+		__u64 flags;
+
+		if (copy_from_user(&flags, (void __user *)arg, sizeof(flags)))
+			RETURN(-EFAULT);
+
+		rc = ll_heat_set(inode, flags);
+		RETURN(rc);
+	}
+	case LL_IOC_PCC_ATTACH: {
+		struct lu_pcc_attach attach;
+
+		if (copy_from_user(&attach, (void __user *)arg,
+				   sizeof(attach)))
+			RETURN(-EFAULT);
+
+		/* The release lease needs the file open for write */
+		if (!(file->f_mode & FMODE_WRITE))
+			RETURN(-EBADF);
+
+		rc = pcc_ioctl_attach(file, &attach);
+		RETURN(rc);
+	}
+	case LL_IOC_PCC_DETACH:
+		rc = pcc_ioctl_detach(inode);
+		RETURN(rc);
+	case LL_IOC_PCC_STATE: {
+		struct lu_pcc_state *state;
+
+		OBD_ALLOC_PTR(state);
+		if (state == NULL)
+			RETURN(-ENOMEM);
+
+		rc = pcc_ioctl_state(inode, state);
+		if (rc == 0 &&
+		    copy_to_user((void __user *)arg, state, sizeof(*state)))
+			rc = -EFAULT;
+
+		OBD_FREE_PTR(state);
+		RETURN(rc);
+	}
 	default:
 		RETURN(obd_iocontrol(cmd, ll_i2dtexp(inode), 0, NULL,
 				     (void __user *)arg));
@@ -3767,6 +4033,79 @@ int cl_sync_file_range(struct inode *inode, loff_t start, loff_t end,
 	RETURN(result);
 }
 
+/*
+ * Preallocate blocks for the range [offset, offset + len) of a file.
+ *
+ * The request goes through a CIT_FALLOCATE io down to the OSTs, where the
+ * blocks are allocated as unwritten extents, so that reading them back still
+ * returns zeroes. Only the default mode, which extends the file size, and
+ * FALLOC_FL_KEEP_SIZE are supported.
+ */
+static long ll_fallocate(struct file *file, int mode, loff_t offset,
+			 loff_t len)
+{
+	struct inode *inode = file_inode(file);
+	struct lu_env *env;
+	struct cl_io *io;
+	struct cl_fallocate_io *fio;
+	bool cached;
+	__u16 refcheck;
+	int rc;
+	ENTRY;
+
+	CDEBUG(D_VFSTRACE, "VFS Op:inode="DFID"(%p), mode %#x, "
+	       "offset %lld, len %lld\n", PFID(ll_inode2fid(inode)), inode,
+	       mode, offset, len);
+	ll_stats_ops_tally(ll_i2sbi(inode), LPROC_LL_FALLOCATE, 1);
+
+	if (mode & ~FALLOC_FL_KEEP_SIZE)
+		RETURN(-EOPNOTSUPP);
+
+	rc = pcc_fallocate(file, mode, offset, len, &cached);
+	if (cached)
+		RETURN(rc);
+
+	if (!(mode & FALLOC_FL_KEEP_SIZE)) {
+		rc = inode_newsize_ok(inode, offset + len);
+		if (rc < 0)
+			RETURN(rc);
+	}
+
+	env = cl_env_get(&refcheck);
+	if (IS_ERR(env))
+		RETURN(PTR_ERR(env));
+
+	io = vvp_env_thread_io(env);
+	io->ci_obj = ll_i2info(inode)->lli_clob;
+	io->ci_verify_layout = 1;
+
+	fio = &io->u.ci_fallocate;
+	fio->fa_start = offset;
+	fio->fa_end = offset + len;
+	fio->fa_fid = ll_inode2fid(inode);
+	fio->fa_mode = mode;
+
+again:
+	ll_io_set_mirror(io, file);
+	if (cl_io_init(env, io, CIT_FALLOCATE, io->ci_obj) == 0) {
+		/* honor the group lock of the file descriptor */
+		vvp_env_io(env)->vui_fd = LUSTRE_FPRIVATE(file);
+		rc = cl_io_loop(env, io);
+	} else {
+		rc = io->ci_result;
+	}
+	cl_io_fini(env, io);
+	if (unlikely(io->ci_need_restart))
+		goto again;
+
+	cl_env_put(env, &refcheck);
+
+	if (rc == 0 && !(mode & FALLOC_FL_KEEP_SIZE))
+		ll_file_set_flag(ll_i2info(inode), LLIF_DATA_MODIFIED);
+
+	RETURN(rc);
+}
+
 /*
  * When dentry is provided (the 'else' case), file_dentry() may be
  * null and dentry must be used directly rather than pulled from
@@ -3830,8 +4169,13 @@ int ll_fsync(struct file *file, struct dentry *dentry, int datasync)
 
 	if (S_ISREG(inode->i_mode)) {
 		struct ll_file_data *fd = LUSTRE_FPRIVATE(file);
+		bool cached;
 
-		err = cl_sync_file_range(inode, start, end, CL_FSYNC_ALL, 0);
+		/* Sync the cached copy instead of the OST objects */
+		err = pcc_fsync(file, start, end, datasync, &cached);
+		if (!cached)
+			err = cl_sync_file_range(inode, start, end,
+						 CL_FSYNC_ALL, 0);
 		if (rc == 0 && err < 0)
 			rc = err;
 		if (rc < 0)
@@ -4376,6 +4720,7 @@ int ll_getattr(struct vfsmount *mnt, struct dentry *de, struct kstat *stat)
 	struct inode *inode = de->d_inode;
 	struct ll_sb_info *sbi = ll_i2sbi(inode);
 	struct ll_inode_info *lli = ll_i2info(inode);
+	bool cached;
 	int rc;
 
 	ll_stats_ops_tally(sbi, LPROC_LL_GETATTR, 1);
@@ -4385,6 +4730,12 @@ int ll_getattr(struct vfsmount *mnt, struct dentry *de, struct kstat *stat)
 		RETURN(rc);
 
 	if (S_ISREG(inode->i_mode)) {
+		/* The size and times of a file attached to PCC are those of
+		 * its cached copy, no need to glimpse the OSTs. */
+		rc = pcc_inode_getattr(inode, &cached);
+		if (rc < 0)
+			RETURN(rc);
+
 		/* In case of restore, the MDT has the right size and has
 		 * already send it back without granting the layout lock,
 		 * inode is up-to-date so glimpse is useless.
@@ -4392,7 +4743,7 @@ int ll_getattr(struct vfsmount *mnt, struct dentry *de, struct kstat *stat)
 		 * restore the MDT holds the layout lock so the glimpse will
 		 * block up to the end of restore (getattr will block)
 		 */
-		if (!ll_file_test_flag(lli, LLIF_FILE_RESTORING)) {
+		if (!cached && !ll_file_test_flag(lli, LLIF_FILE_RESTORING)) {
 			rc = ll_glimpse_size(inode);
 			if (rc < 0)
 				RETURN(rc);
@@ -4682,6 +5033,7 @@ struct file_operations ll_file_operations = {
 	.llseek		= ll_file_seek,
 	.splice_read	= ll_file_splice_read,
 	.fsync		= ll_fsync,
+	.fallocate	= ll_fallocate,
 	.flush		= ll_flush
 };
 
@@ -4706,6 +5058,7 @@ struct file_operations ll_file_operations_flock = {
 	.llseek		= ll_file_seek,
 	.splice_read	= ll_file_splice_read,
 	.fsync		= ll_fsync,
+	.fallocate	= ll_fallocate,
 	.flush		= ll_flush,
 	.flock		= ll_file_flock,
 	.lock		= ll_file_flock
@@ -4733,6 +5086,7 @@ struct file_operations ll_file_operations_noflock = {
 	.llseek		= ll_file_seek,
 	.splice_read	= ll_file_splice_read,
 	.fsync		= ll_fsync,
+	.fallocate	= ll_fallocate,
 	.flush		= ll_flush,
 	.flock		= ll_file_noflock,
 	.lock		= ll_file_noflock
@@ -48,6 +48,7 @@
 
 #include "vvp_internal.h"
 #include "range_lock.h"
+#include "pcc.h"
 
 #ifndef FMODE_EXEC
 #define FMODE_EXEC 0
@@ -175,6 +176,9 @@ struct ll_inode_info {
 			 * "dmv" and gets the rest of the default layout itself
 			 * (count, hash, etc). */
 			__u32				lli_def_stripe_offset;
+			/* placement policy from the "dmv" xattr, -1 if it is
+			 * not known yet, see ll_new_node() */
+			__u32				lli_def_placement;
 		};
 
 		/* for non-directory */
@@ -208,6 +212,15 @@ struct ll_inode_info {
 			 * accurate if the file is shared by different jobs.
 			 */
 			char                    lli_jobid[LUSTRE_JOBID_SIZE];
+
+			spinlock_t		lli_heat_lock;
+			__u32			lli_heat_flags;
+			struct obd_heat_instance lli_heat_instances[OBD_HEAT_COUNT];
+
+			/* serializes PCC attach, detach and open */
+			struct mutex		lli_pcc_lock;
+			/* PCC copy this file is attached to, if any */
+			struct pcc_inode	*lli_pcc_inode;
 		};
 	};
 
@@ -343,6 +356,19 @@ static inline struct ll_inode_info *ll_i2info(struct inode *inode)
 /* default to read-ahead full files smaller than 2MB on the second read */
 #define SBI_DEFAULT_READAHEAD_WHOLE_MAX	(2UL << (20 - PAGE_SHIFT))
 
+/* hand the readahead window over to the async workers once it reaches 4MB */
+#define SBI_DEFAULT_RA_ASYNC_THRESHOLD	(4UL << (20 - PAGE_SHIFT))
+
+/* max number of async readahead works running at once, per CPU */
+#define SBI_DEFAULT_RA_ASYNC_ACTIVE_PER_CPU	1
+
+/* file heat is decayed by 80% every 60 seconds */
+#define SBI_DEFAULT_HEAT_DECAY_WEIGHT	((80 * 256 + 50) / 100)
+#define SBI_DEFAULT_HEAT_PERIOD_SECOND	(60)
+
+/* number of independent readahead stream detectors of an open file */
+#define LL_RA_STREAMS_MAX		4
+
 enum ra_stat {
         RA_STAT_HIT = 0,
         RA_STAT_MISS,
@@ -357,7 +383,14 @@ enum ra_stat {
         RA_STAT_MAX_IN_FLIGHT,
         RA_STAT_WRONG_GRAB_PAGE,
 	RA_STAT_FAILED_REACH_END,
-	_NR_RA_STAT,
+	RA_STAT_ASYNC,
+	RA_STAT_SYNC,
+	RA_STAT_STREAM_NEW,
+	RA_STAT_STREAM_REPLACED,
+	/* per-stream hit and miss counters, LL_RA_STREAMS_MAX of each */
+	RA_STAT_STREAM_HIT,
+	RA_STAT_STREAM_MISS = RA_STAT_STREAM_HIT + LL_RA_STREAMS_MAX,
+	_NR_RA_STAT = RA_STAT_STREAM_MISS + LL_RA_STREAMS_MAX,
 };
 
 struct ll_ra_info {
@@ -365,6 +398,26 @@ struct ll_ra_info {
 	unsigned long	ra_max_pages;
 	unsigned long	ra_max_pages_per_file;
 	unsigned long	ra_max_read_ahead_whole_pages;
+	/* workers reading ahead on behalf of the application threads */
+	struct workqueue_struct	*ra_async_wq;
+	/* max number of async readahead works running at the same time */
+	unsigned int	ra_async_max_active;
+	/* number of async readahead works queued or running */
+	atomic_t	ra_async_inflight;
+	/* readahead window size (in pages) from which on the window is
+	 * filled by the async workers, 0 disables async readahead */
+	unsigned long	ra_async_pages_per_file_threshold;
+};
+
+/* async readahead request, queued to ll_ra_info::ra_async_wq */
+struct ll_readahead_work {
+	/* file to read ahead, a reference is held until the work is done */
+	struct file		*lrw_file;
+	/* readahead stream of lrw_file the window belongs to */
+	struct ll_readahead_state *lrw_ras;
+	pgoff_t			 lrw_start;
+	pgoff_t			 lrw_end;
+	struct work_struct	 lrw_work;
 };
 
 /* ra_io_arg will be filled in the beginning of ll_readahead with
@@ -453,6 +506,7 @@ enum stats_track_type {
 /*	LL_SBI_PIO	    0x1000000    parallel IO support, introduced in
 					 2.10, abandoned */
 #define LL_SBI_TINY_WRITE   0x2000000 /* tiny write support */
+#define LL_SBI_FILE_HEAT    0x4000000 /* file heat support */
 
 #define LL_SBI_FLAGS { 	\
 	"nolck",	\
@@ -481,6 +535,7 @@ enum stats_track_type {
 	"file_secctx",	\
 	"pio",		\
 	"tiny_write",	\
+	"file_heat",	\
 }
 
 /* This is embedded into llite super-blocks to keep track of connect
@@ -569,6 +624,13 @@ struct ll_sb_info {
 
 	struct kset		  ll_kset;	/* sysfs object */
 	struct completion	  ll_kobj_unregister;
+
+	/* File heat */
+	unsigned int		  ll_heat_decay_weight;
+	unsigned int		  ll_heat_period_second;
+
+	/* Persistent Client Cache */
+	struct pcc_super	  ll_pcc_super;
 };
 
 /*
@@ -654,12 +716,39 @@ struct ll_readahead_state {
          * stride read-ahead will be enable
          */
         unsigned long   ras_consecutive_stride_requests;
+	/*
+	 * Page index the current read request started at, and the number
+	 * of consecutive requests each of which ended right before the
+	 * start of the previous one. Only more than 1 consecutive backward
+	 * request enables backward read-ahead.
+	 */
+	unsigned long	ras_request_start;
+	unsigned long	ras_consecutive_backward_requests;
+	/*
+	 * Slot of this stream in ll_readahead_streams::lrs_ras, and the
+	 * value of lrs_clock at its last use. 0 means the slot is free.
+	 */
+	unsigned int	ras_stream;
+	__u64		ras_lru;
+};
+
+/*
+ * per file-descriptor table of read-ahead streams. Reads are assigned to the
+ * stream whose window or last read page they continue, so several threads
+ * (or interleaved record streams) reading through the same file descriptor
+ * don't reset each other's read-ahead window.
+ */
+struct ll_readahead_streams {
+	/* protects stream selection and lrs_clock */
+	spinlock_t			lrs_lock;
+	__u64				lrs_clock;
+	struct ll_readahead_state	lrs_ras[LL_RA_STREAMS_MAX];
 };
 
 extern struct kmem_cache *ll_file_data_slab;
 struct lustre_handle;
 struct ll_file_data {
-	struct ll_readahead_state fd_ras;
+	struct ll_readahead_streams fd_ras;
 	struct ll_grouplock fd_grouplock;
 	__u64 lfd_pos;
 	__u32 fd_flags;
@@ -682,6 +771,7 @@ struct ll_file_data {
 	/* The layout version when resync starts. Resync I/O should carry this
 	 * layout version for verification to OST objects */
 	__u32 fd_layout_version;
+	struct pcc_file fd_pcc_file;
 };
 
 void llite_tunables_unregister(void);
@@ -728,7 +818,14 @@ static inline bool ll_sbi_has_tiny_write(struct ll_sb_info *sbi)
 	return !!(sbi->ll_flags & LL_SBI_TINY_WRITE);
 }
 
-void ll_ras_enter(struct file *f);
+static inline bool ll_sbi_has_file_heat(struct ll_sb_info *sbi)
+{
+	return !!(sbi->ll_flags & LL_SBI_FILE_HEAT);
+}
+
+void ll_heat_add(struct inode *inode, enum cl_io_type iot, __u64 count);
+
+struct ll_readahead_state *ll_ras_enter(struct file *f, pgoff_t index);
 
 /* llite/lcommon_misc.c */
 int cl_ocd_update(struct obd_device *host, struct obd_device *watched,
@@ -747,6 +844,7 @@ enum {
 	LPROC_LL_DIRTY_MISSES,
 	LPROC_LL_READ_BYTES,
 	LPROC_LL_WRITE_BYTES,
+	LPROC_LL_FAST_WRITE,
 	LPROC_LL_BRW_READ,
 	LPROC_LL_BRW_WRITE,
 	LPROC_LL_IOCTL,
@@ -757,6 +855,7 @@ enum {
 	LPROC_LL_MKWRITE,
 	LPROC_LL_LLSEEK,
 	LPROC_LL_FSYNC,
+	LPROC_LL_FALLOCATE,
 	LPROC_LL_READDIR,
 	LPROC_LL_SETATTR,
 	LPROC_LL_TRUNC,
@@ -826,7 +925,9 @@ int ll_writepages(struct address_space *, struct writeback_control *wbc);
 int ll_readpage(struct file *file, struct page *page);
 int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 			   struct cl_page *page, struct file *file);
-void ll_readahead_init(struct inode *inode, struct ll_readahead_state *ras);
+void ll_readahead_init(struct inode *inode, struct ll_readahead_streams *lrs);
+int ll_readahead_async_init(struct ll_sb_info *sbi);
+void ll_readahead_async_fini(struct ll_sb_info *sbi);
 int vvp_io_write_commit(const struct lu_env *env, struct cl_io *io);
 
 enum lcc_type;
@@ -836,6 +937,9 @@ void ll_cl_remove(struct file *file, const struct lu_env *env);
 struct ll_cl_context *ll_cl_find(struct file *file);
 
 extern const struct address_space_operations ll_aops;
+struct ll_dio_aio *ll_dio_aio_alloc(struct kiocb *iocb);
+int ll_dio_aio_finish(const struct lu_env *env, struct ll_dio_aio *aio,
+		      ssize_t bytes);
 
 /* llite/file.c */
 extern struct file_operations ll_file_operations;
@@ -848,6 +952,7 @@ extern enum ldlm_mode ll_take_md_lock(struct inode *inode, __u64 bits,
 				      struct lustre_handle *lockh, __u64 flags,
 				      enum ldlm_mode mode);
 
+void ll_io_init(struct cl_io *io, struct file *file, enum cl_io_type iot);
 int ll_file_open(struct inode *inode, struct file *file);
 int ll_file_release(struct inode *inode, struct file *file);
 int ll_release_openhandle(struct dentry *, struct lookup_intent *);
@@ -910,7 +1015,8 @@ int ll_fsync(struct file *file, struct dentry *dentry, int data);
 int ll_merge_attr(const struct lu_env *env, struct inode *inode);
 int ll_fid2path(struct inode *inode, void __user *arg);
 int ll_data_version(struct inode *inode, __u64 *data_version, int flags);
-int ll_hsm_release(struct inode *inode);
+int ll_hsm_release(struct inode *inode, struct file *file);
+int ll_hsm_state_get(struct inode *inode, struct hsm_user_state *hus);
 int ll_hsm_state_set(struct inode *inode, struct hsm_state_set *hss);
 void ll_io_set_mirror(struct cl_io *io, const struct file *file);
 
@@ -1024,6 +1130,8 @@ extern struct inode_operations ll_fast_symlink_inode_operations;
 struct vvp_io_args {
         /** normal/sendfile/splice */
         enum vvp_io_subtype via_io_subtype;
+	/** the caller holds the range lock of the write already */
+	bool			via_range_locked;
 
         union {
                 struct {
@@ -1051,6 +1159,29 @@ struct ll_cl_context {
 	enum lcc_type		 lcc_type;
 };
 
+/*
+ * Direct I/O in flight. Each page sent holds a reference on lda_sync, and
+ * the submitter one more until the whole read or write has been sent, so
+ * that an asynchronous request is completed from the callback of its last
+ * RPC, whichever stripe that is on.
+ */
+struct ll_dio_aio {
+	struct cl_sync_io	 lda_sync;
+	/* transient pages sent, deleted once they are all transferred */
+	struct cl_page_list	 lda_pages;
+	/* user pages of aligned I/O, released once they are transferred */
+	struct list_head	 lda_user_pages;
+	/* bounce pages of unaligned writes, see ll_direct_IO_bounce() */
+	struct list_head	 lda_bounces;
+	struct inode		*lda_inode;
+	/* asynchronous request to complete, NULL if waited for */
+	struct kiocb		*lda_iocb;
+	/* bytes to complete lda_iocb with */
+	ssize_t			 lda_bytes;
+};
+
+extern struct kmem_cache *ll_dio_aio_kmem;
+
 struct ll_thread_info {
 	struct iov_iter		lti_iter;
 	struct vvp_io_args	lti_args;
@@ -1076,6 +1207,7 @@ static inline struct vvp_io_args *ll_env_args(const struct lu_env *env,
 	struct vvp_io_args *via = &ll_env_info(env)->lti_args;
 
 	via->via_io_subtype = type;
+	via->via_range_locked = false;
 
 	return via;
 }
@@ -57,6 +57,7 @@
 #include <lustre_log.h>
 #include <cl_object.h>
 #include <obd_cksum.h>
+#include <obd_compr.h>
 #include "llite_internal.h"
 
 struct kmem_cache *ll_file_data_slab;
@@ -100,6 +101,11 @@ static struct ll_sb_info *ll_init_sbi(void)
 					   SBI_DEFAULT_READAHEAD_MAX);
 	sbi->ll_ra_info.ra_max_pages = sbi->ll_ra_info.ra_max_pages_per_file;
 	sbi->ll_ra_info.ra_max_read_ahead_whole_pages = -1;
+	if (ll_readahead_async_init(sbi) != 0) {
+		cl_cache_decref(sbi->ll_cache);
+		OBD_FREE(sbi, sizeof(*sbi));
+		RETURN(NULL);
+	}
 
         ll_generate_random_uuid(uuid);
         class_uuid_unparse(uuid, &sbi->ll_sb_uuid);
@@ -136,6 +142,13 @@ static struct ll_sb_info *ll_init_sbi(void)
 	sbi->ll_flags |= LL_SBI_FAST_READ;
 	sbi->ll_flags |= LL_SBI_TINY_WRITE;
 
+	/* file heat is enabled by default */
+	sbi->ll_flags |= LL_SBI_FILE_HEAT;
+	sbi->ll_heat_decay_weight = SBI_DEFAULT_HEAT_DECAY_WEIGHT;
+	sbi->ll_heat_period_second = SBI_DEFAULT_HEAT_PERIOD_SECOND;
+
+	pcc_super_init(&sbi->ll_pcc_super);
+
 	/* root squash */
 	sbi->ll_squash.rsi_uid = 0;
 	sbi->ll_squash.rsi_gid = 0;
@@ -153,6 +166,8 @@ static void ll_free_sbi(struct super_block *sb)
 	if (sbi != NULL) {
 		if (!list_empty(&sbi->ll_squash.rsi_nosquash_nids))
 			cfs_free_nidlist(&sbi->ll_squash.rsi_nosquash_nids);
+		ll_readahead_async_fini(sbi);
+		pcc_super_fini(&sbi->ll_pcc_super);
 		if (sbi->ll_cache != NULL) {
 			cl_cache_decref(sbi->ll_cache);
 			sbi->ll_cache = NULL;
@@ -225,7 +240,12 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt,
 				   OBD_CONNECT2_LOCK_CONVERT |
 				   OBD_CONNECT2_DIR_MIGRATE |
 				   OBD_CONNECT2_SUM_STATFS |
-				   OBD_CONNECT2_ARCHIVE_ID_ARRAY;
+				   OBD_CONNECT2_ARCHIVE_ID_ARRAY |
+				   OBD_CONNECT2_BATCH_RPC |
+				   OBD_CONNECT2_BATCH_BL_AST |
+				   OBD_CONNECT2_DIR_PLACEMENT |
+				   OBD_CONNECT2_JUMP_HASH |
+				   OBD_CONNECT2_CHLG_FILTER;
 
 #ifdef HAVE_LRU_RESIZE_SUPPORT
         if (sbi->ll_flags & LL_SBI_LRU_RESIZE)
@@ -428,7 +448,15 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt,
 	data->ocd_connect_flags |= OBD_CONNECT_LOCKAHEAD_OLD;
 #endif
 
-	data->ocd_connect_flags2 = OBD_CONNECT2_LOCKAHEAD;
+	data->ocd_connect_flags2 = OBD_CONNECT2_LOCKAHEAD |
+				   OBD_CONNECT2_BATCH_BL_AST |
+				   OBD_CONNECT2_EXTENT_SHRINK;
+
+	/* Compression is only used for components with LCME_FL_COMPRESS,
+	 * but the algorithms are agreed on at connect time like checksums */
+	data->ocd_compr_types = obd_compr_types_supported();
+	if (data->ocd_compr_types != 0)
+		data->ocd_connect_flags2 |= OBD_CONNECT2_COMPRESS;
 
 	if (!OBD_FAIL_CHECK(OBD_FAIL_OSC_CONNECT_GRANT_PARAM))
 		data->ocd_connect_flags |= OBD_CONNECT_GRANT_PARAM;
@@ -958,6 +986,7 @@ void ll_lli_init(struct ll_inode_info *lli)
 		lli->lli_opendir_pid = 0;
 		lli->lli_sa_enabled = 0;
 		lli->lli_def_stripe_offset = -1;
+		lli->lli_def_placement = -1;
 		init_rwsem(&lli->lli_lsm_sem);
 	} else {
 		mutex_init(&lli->lli_size_mutex);
@@ -969,6 +998,10 @@ void ll_lli_init(struct ll_inode_info *lli)
 		INIT_LIST_HEAD(&lli->lli_agl_list);
 		lli->lli_agl_index = 0;
 		lli->lli_async_rc = 0;
+		spin_lock_init(&lli->lli_heat_lock);
+		obd_heat_clear(lli->lli_heat_instances, OBD_HEAT_COUNT);
+		lli->lli_heat_flags = 0;
+		pcc_inode_init(lli);
 	}
 	mutex_init(&lli->lli_layout_mutex);
 	memset(lli->lli_jobid, 0, sizeof(lli->lli_jobid));
@@ -1194,6 +1227,10 @@ void ll_put_super(struct super_block *sb)
                 }
         }
 
+	/* async readahead works hold references on the OSC devices */
+	if (sbi->ll_ra_info.ra_async_wq != NULL)
+		flush_workqueue(sbi->ll_ra_info.ra_async_wq);
+
 	if (sbi->ll_client_common_fill_super_succeeded) {
 		/* Only if client_common_fill_super succeeded */
 		client_common_put_super(sb);
@@ -1513,6 +1550,9 @@ void ll_clear_inode(struct inode *inode)
 	else if (S_ISREG(inode->i_mode) && !is_bad_inode(inode))
 		LASSERT(list_empty(&lli->lli_agl_list));
 
+	if (S_ISREG(inode->i_mode))
+		pcc_inode_free(inode);
+
 	/*
 	 * XXX This has to be done before lsm is freed below, because
 	 * cl_object still uses inode lsm.
@@ -1700,14 +1740,19 @@ int ll_setattr_raw(struct dentry *dentry, struct iattr *attr,
 	if (attr->ia_valid & (ATTR_SIZE | ATTR_ATIME | ATTR_ATIME_SET |
 			      ATTR_MTIME | ATTR_MTIME_SET | ATTR_CTIME) ||
 	    xvalid & OP_XVALID_CTIME_SET) {
+		bool cached;
+
 		/* For truncate and utimes sending attributes to OSTs, setting
 		 * mtime/atime to the past will be performed under PW [0:EOF]
 		 * extent lock (new_size:EOF for truncate).  It may seem
 		 * excessive to send mtime/atime updates to OSTs when not
 		 * setting times to past, but it is necessary due to possible
-		 * time de-synchronization between MDT inode and OST objects
+		 * time de-synchronization between MDT inode and OST objects.
+		 * A file attached to PCC has its data in the cached copy.
 		 */
-		rc = cl_setattr_ost(lli->lli_clob, attr, xvalid, 0);
+		rc = pcc_inode_setattr(inode, attr, &cached);
+		if (!cached)
+			rc = cl_setattr_ost(lli->lli_clob, attr, xvalid, 0);
 	}
 
 	/* If the file was restored, it needs to set dirty flag.
@@ -2548,14 +2593,20 @@ struct md_op_data *ll_prep_md_op_data(struct md_op_data *op_data,
 	ll_i2gids(op_data->op_suppgids, i1, i2);
 	op_data->op_fid1 = *ll_inode2fid(i1);
 	op_data->op_default_stripe_offset = -1;
+	op_data->op_default_placement = LMV_PLACEMENT_PARENT;
 
 	if (S_ISDIR(i1->i_mode)) {
 		down_read(&ll_i2info(i1)->lli_lsm_sem);
 		op_data->op_mea1_sem = &ll_i2info(i1)->lli_lsm_sem;
 		op_data->op_mea1 = ll_i2info(i1)->lli_lsm_md;
-		if (opc == LUSTRE_OPC_MKDIR)
+		if (opc == LUSTRE_OPC_MKDIR) {
 			op_data->op_default_stripe_offset =
 				   ll_i2info(i1)->lli_def_stripe_offset;
+			if (ll_i2info(i1)->lli_def_placement <
+			    LMV_PLACEMENT_MAX)
+				op_data->op_default_placement =
+					ll_i2info(i1)->lli_def_placement;
+		}
 	}
 
 	if (i2) {
@@ -388,6 +388,11 @@ restart:
                 result |= VM_FAULT_LOCKED;
         }
 	cfs_restore_sigs(set);
+
+	if (vmf->page && result & VM_FAULT_LOCKED &&
+	    !(result & VM_FAULT_ERROR))
+		ll_heat_add(file_inode(vma->vm_file), CIT_READ, PAGE_SIZE);
+
         return result;
 }
 
@@ -427,6 +432,7 @@ static int ll_page_mkwrite(struct vm_area_struct *vma, struct vm_fault *vmf)
         case 0:
                 LASSERT(PageLocked(vmf->page));
                 result = VM_FAULT_LOCKED;
+		ll_heat_add(file_inode(vma->vm_file), CIT_WRITE, PAGE_SIZE);
                 break;
         case -ENODATA:
         case -EFAULT:
@@ -502,6 +508,7 @@ static const struct vm_operations_struct ll_file_vm_ops = {
 int ll_file_mmap(struct file *file, struct vm_area_struct * vma)
 {
 	struct inode *inode = file_inode(file);
+	bool cached;
         int rc;
         ENTRY;
 
@@ -509,6 +516,11 @@ int ll_file_mmap(struct file *file, struct vm_area_struct * vma)
                 RETURN(-EOPNOTSUPP);
 
         ll_stats_ops_tally(ll_i2sbi(inode), LPROC_LL_MAP, 1);
+
+	rc = pcc_file_mmap(file, vma, &cached);
+	if (cached)
+		RETURN(rc);
+
         rc = generic_file_mmap(file, vma);
         if (rc == 0) {
                 vma->vm_ops = &ll_file_vm_ops;
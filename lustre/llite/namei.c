@@ -244,8 +244,10 @@ void ll_lock_cancel_bits(struct ldlm_lock *lock, __u64 to_cancel)
 	}
 
 	if (bits & MDS_INODELOCK_XATTR) {
-		if (S_ISDIR(inode->i_mode))
+		if (S_ISDIR(inode->i_mode)) {
 			ll_i2info(inode)->lli_def_stripe_offset = -1;
+			ll_i2info(inode)->lli_def_placement = -1;
+		}
 		ll_xattr_cache_destroy(inode);
 		bits &= ~MDS_INODELOCK_XATTR;
 	}
@@ -305,6 +307,14 @@ void ll_lock_cancel_bits(struct ldlm_lock *lock, __u64 to_cancel)
 			CDEBUG(D_INODE, "cannot invalidate layout of "
 			       DFID": rc = %d\n",
 			       PFID(ll_inode2fid(inode)), rc);
+
+		/* The layout changes when the file gets restored, the
+		 * cached copy is not authoritative anymore then. Only a
+		 * blocking AST means the layout is changing, LRU and local
+		 * cancels leave the cached copy attached. */
+		if (S_ISREG(inode->i_mode) && ldlm_is_bl_ast(lock) &&
+		    !ldlm_is_local_only(lock))
+			pcc_layout_invalidate(inode);
 	}
 
 	if (bits & MDS_INODELOCK_UPDATE) {
@@ -1157,6 +1167,33 @@ void ll_update_times(struct ptlrpc_request *request, struct inode *inode)
 		inode->i_ctime.tv_sec = body->mbo_ctime;
 }
 
+/* Fetch the default LMV of \a dir from the MDT and cache the stripe offset
+ * and placement policy which decide where its subdirectories are created. */
+static int ll_dir_get_default_lmv(struct inode *dir)
+{
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ptlrpc_request *request = NULL;
+	struct lmv_user_md *lum;
+	int lumsize;
+	int rc;
+
+	rc = ll_dir_getstripe(dir, (void **)&lum, &lumsize, &request,
+			      OBD_MD_DEFAULT_MEA);
+	if (rc == 0) {
+		lli->lli_def_stripe_offset = lum->lum_stripe_offset;
+		if (lum->lum_placement < LMV_PLACEMENT_MAX)
+			lli->lli_def_placement = lum->lum_placement;
+		else
+			lli->lli_def_placement = LMV_PLACEMENT_PARENT;
+	} else if (rc == -ENODATA) {
+		lli->lli_def_stripe_offset = -1;
+		lli->lli_def_placement = LMV_PLACEMENT_PARENT;
+	}
+	ptlrpc_req_finished(request);
+
+	return rc;
+}
+
 static int ll_new_node(struct inode *dir, struct dentry *dchild,
 		       const char *tgt, umode_t mode, int rdev, __u32 opc)
 {
@@ -1172,6 +1209,18 @@ static int ll_new_node(struct inode *dir, struct dentry *dchild,
         if (unlikely(tgt != NULL))
                 tgt_len = strlen(tgt) + 1;
 
+	/* The placement policy of the parent default LMV is only known to
+	 * the MDT, fetch it once so LMV can place the new subdirectory. The
+	 * default LMV of ROOT isn't inherited by its subdirectories. */
+	if (opc == LUSTRE_OPC_MKDIR &&
+	    ll_i2info(dir)->lli_def_placement == (__u32)-1 &&
+	    !fid_is_root(ll_inode2fid(dir)) &&
+	    exp_connect_dir_placement(sbi->ll_md_exp)) {
+		err = ll_dir_get_default_lmv(dir);
+		if (err < 0 && err != -ENODATA)
+			RETURN(err);
+	}
+
 again:
 	op_data = ll_prep_md_op_data(NULL, dir, NULL, name->name,
 				     name->len, 0, opc, NULL);
@@ -1200,30 +1249,22 @@ again:
 	 * of the directory, then create the directory on the right MDT. */
 	if (unlikely(err == -EREMOTE)) {
 		struct ll_inode_info	*lli = ll_i2info(dir);
-		struct lmv_user_md	*lum;
-		int			lumsize;
+		bool			had_default;
 		int			err2;
 
 		ptlrpc_req_finished(request);
 		request = NULL;
 
-		err2 = ll_dir_getstripe(dir, (void **)&lum, &lumsize, &request,
-					OBD_MD_DEFAULT_MEA);
-		if (err2 == 0) {
-			/* Update stripe_offset and retry */
-			lli->lli_def_stripe_offset = lum->lum_stripe_offset;
-		} else if (err2 == -ENODATA &&
-			   lli->lli_def_stripe_offset != -1) {
-			/* If there are no default stripe EA on the MDT, but the
-			 * client has default stripe, then it probably means
-			 * default stripe EA has just been deleted. */
-			lli->lli_def_stripe_offset = -1;
-		} else {
+		had_default = lli->lli_def_stripe_offset != -1 ||
+			      lli->lli_def_placement != LMV_PLACEMENT_PARENT;
+		/* Update stripe_offset and placement, and retry. If there
+		 * are no default stripe EA on the MDT, but the client has
+		 * default stripe, then it probably means default stripe EA
+		 * has just been deleted. */
+		err2 = ll_dir_get_default_lmv(dir);
+		if (err2 != 0 && !(err2 == -ENODATA && had_default))
 			GOTO(err_exit, err);
-		}
 
-		ptlrpc_req_finished(request);
-		request = NULL;
 		ll_finish_md_op_data(op_data);
 		goto again;
 	}
@@ -0,0 +1,801 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * Persistent Client Cache
+ *
+ * A PCC dataset is a directory on a client-local file system, registered
+ * with an HSM archive ID through "lctl set_param llite.*.pcc". The dataset
+ * uses the same layout as the archive of lhsmtool_posix, so that a copytool
+ * running on the client with the dataset as its HSM root archives files
+ * into it and restores files from it.
+ *
+ * Attaching a file requires it to be archived to the dataset already. The
+ * file is then HSM-released, and from then on its reads, writes, truncates,
+ * mmaps and fsyncs on this client go to the archived copy, which becomes
+ * the authoritative one. Detaching the file, or any access that needs the
+ * data in Lustre (including a restore triggered from another client, which
+ * changes the layout), makes I/O go back to Lustre, where the copytool
+ * restores the data from the cached copy.
+ */
+
+#define DEBUG_SUBSYSTEM S_LLITE
+
+#include <linux/namei.h>
+#include <linux/file.h>
+#include <lustre_compat.h>
+#include "llite_internal.h"
+
+int pcc_super_init(struct pcc_super *super)
+{
+	init_rwsem(&super->pccs_rw_sem);
+	INIT_LIST_HEAD(&super->pccs_datasets);
+
+	return 0;
+}
+
+static void pcc_dataset_put(struct pcc_dataset *dataset)
+{
+	if (atomic_dec_and_test(&dataset->pccd_refcount)) {
+		path_put(&dataset->pccd_path);
+		OBD_FREE_PTR(dataset);
+	}
+}
+
+static struct pcc_dataset *pcc_dataset_get(struct pcc_super *super, __u32 id)
+{
+	struct pcc_dataset *dataset;
+	struct pcc_dataset *found = NULL;
+
+	down_read(&super->pccs_rw_sem);
+	list_for_each_entry(dataset, &super->pccs_datasets, pccd_linkage) {
+		if (dataset->pccd_id == id) {
+			atomic_inc(&dataset->pccd_refcount);
+			found = dataset;
+			break;
+		}
+	}
+	up_read(&super->pccs_rw_sem);
+
+	return found;
+}
+
+static int pcc_dataset_add(struct pcc_super *super, const char *pathname,
+			   __u32 id)
+{
+	struct pcc_dataset *dataset;
+	struct pcc_dataset *tmp;
+	int rc;
+
+	if (strlen(pathname) >= sizeof(dataset->pccd_pathname))
+		return -ENAMETOOLONG;
+
+	OBD_ALLOC_PTR(dataset);
+	if (dataset == NULL)
+		return -ENOMEM;
+
+	rc = kern_path(pathname, LOOKUP_DIRECTORY, &dataset->pccd_path);
+	if (rc) {
+		OBD_FREE_PTR(dataset);
+		return rc;
+	}
+
+	strncpy(dataset->pccd_pathname, pathname,
+		sizeof(dataset->pccd_pathname));
+	dataset->pccd_id = id;
+	atomic_set(&dataset->pccd_refcount, 1);
+
+	down_write(&super->pccs_rw_sem);
+	list_for_each_entry(tmp, &super->pccs_datasets, pccd_linkage) {
+		if (tmp->pccd_id == id ||
+		    strcmp(tmp->pccd_pathname, pathname) == 0) {
+			up_write(&super->pccs_rw_sem);
+			pcc_dataset_put(dataset);
+			return -EEXIST;
+		}
+	}
+	list_add_tail(&dataset->pccd_linkage, &super->pccs_datasets);
+	up_write(&super->pccs_rw_sem);
+
+	return 0;
+}
+
+static int pcc_dataset_del(struct pcc_super *super, const char *pathname)
+{
+	struct pcc_dataset *dataset;
+	struct pcc_dataset *tmp;
+	int rc = -ENOENT;
+
+	down_write(&super->pccs_rw_sem);
+	list_for_each_entry_safe(dataset, tmp, &super->pccs_datasets,
+				 pccd_linkage) {
+		if (pathname == NULL ||
+		    strcmp(dataset->pccd_pathname, pathname) == 0) {
+			list_del_init(&dataset->pccd_linkage);
+			pcc_dataset_put(dataset);
+			rc = 0;
+		}
+	}
+	up_write(&super->pccs_rw_sem);
+
+	return pathname == NULL ? 0 : rc;
+}
+
+void pcc_super_fini(struct pcc_super *super)
+{
+	pcc_dataset_del(super, NULL);
+}
+
+/**
+ * Handle a command written to llite.*.pcc, one of
+ *
+ *	add <dataset path> <archive ID>
+ *	del <dataset path>
+ *	clear
+ */
+int pcc_cmd_handle(char *buffer, unsigned long count,
+		   struct pcc_super *super)
+{
+	char *token;
+	char *pathname;
+	unsigned int id;
+	int rc;
+
+	buffer[count] = '\0';
+	if (count > 0 && buffer[count - 1] == '\n')
+		buffer[count - 1] = '\0';
+
+	token = strsep(&buffer, " ");
+	if (token == NULL)
+		return -EINVAL;
+
+	if (strcmp(token, "clear") == 0)
+		return pcc_dataset_del(super, NULL);
+
+	pathname = strsep(&buffer, " ");
+	if (pathname == NULL || *pathname != '/')
+		return -EINVAL;
+
+	if (strcmp(token, "del") == 0)
+		return pcc_dataset_del(super, pathname);
+
+	if (strcmp(token, "add") != 0 || buffer == NULL)
+		return -EINVAL;
+
+	rc = kstrtouint(buffer, 10, &id);
+	if (rc)
+		return rc;
+	if (id == 0)
+		return -EINVAL;
+
+	return pcc_dataset_add(super, pathname, id);
+}
+
+int pcc_super_dump(struct pcc_super *super, struct seq_file *m)
+{
+	struct pcc_dataset *dataset;
+
+	down_read(&super->pccs_rw_sem);
+	list_for_each_entry(dataset, &super->pccs_datasets, pccd_linkage)
+		seq_printf(m, "%s archive_id: %u\n", dataset->pccd_pathname,
+			   dataset->pccd_id);
+	up_read(&super->pccs_rw_sem);
+
+	return 0;
+}
+
+/* Same layout as ct_path_archive() of lhsmtool_posix */
+static int pcc_fid2dataset_path(char *buf, int sz, struct pcc_dataset *dataset,
+				const struct lu_fid *fid)
+{
+	return snprintf(buf, sz, "%s/%04x/%04x/%04x/%04x/%04x/%04x/"
+			DFID_NOBRACE, dataset->pccd_pathname,
+			fid->f_oid & 0xFFFF,
+			fid->f_oid >> 16 & 0xFFFF,
+			(unsigned int)(fid->f_seq & 0xFFFF),
+			(unsigned int)(fid->f_seq >> 16 & 0xFFFF),
+			(unsigned int)(fid->f_seq >> 32 & 0xFFFF),
+			(unsigned int)(fid->f_seq >> 48 & 0xFFFF),
+			PFID(fid));
+}
+
+void pcc_inode_init(struct ll_inode_info *lli)
+{
+	mutex_init(&lli->lli_pcc_lock);
+	lli->lli_pcc_inode = NULL;
+}
+
+static void pcc_inode_put(struct pcc_inode *pcci)
+{
+	if (atomic_dec_and_test(&pcci->pcci_refcount)) {
+		path_put(&pcci->pcci_path);
+		OBD_FREE_PTR(pcci);
+	}
+}
+
+/* Get the attached PCC inode of @inode, if any */
+static struct pcc_inode *pcc_inode_get(struct inode *inode)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct pcc_inode *pcci;
+
+	spin_lock(&lli->lli_lock);
+	pcci = lli->lli_pcc_inode;
+	if (pcci != NULL)
+		atomic_inc(&pcci->pcci_refcount);
+	spin_unlock(&lli->lli_lock);
+
+	return pcci;
+}
+
+/*
+ * Stop serving I/O of @inode from its cached copy, and wait for the I/Os
+ * already in flight on it. The cached copy itself is left in place, for the
+ * copytool to restore the file from.
+ */
+static bool pcc_inode_detach(struct inode *inode)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct pcc_inode *pcci;
+
+	spin_lock(&lli->lli_lock);
+	pcci = lli->lli_pcc_inode;
+	lli->lli_pcc_inode = NULL;
+	spin_unlock(&lli->lli_lock);
+
+	if (pcci == NULL)
+		return false;
+
+	CDEBUG(D_INODE, "%s: detach "DFID" from PCC archive %u\n",
+	       ll_get_fsname(inode->i_sb, NULL, 0), PFID(&lli->lli_fid),
+	       pcci->pcci_id);
+
+	wait_event(pcci->pcci_waitq, atomic_read(&pcci->pcci_active_ios) == 0);
+	pcc_inode_put(pcci);
+
+	return true;
+}
+
+void pcc_inode_free(struct inode *inode)
+{
+	pcc_inode_detach(inode);
+}
+
+/*
+ * Called when the layout lock of @inode is cancelled. This happens when a
+ * restore of the file starts, from this or another client, after which the
+ * cached copy must not be modified anymore.
+ */
+void pcc_layout_invalidate(struct inode *inode)
+{
+	pcc_inode_detach(inode);
+}
+
+int pcc_file_open(struct inode *inode, struct file *file)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_file_data *fd = LUSTRE_FPRIVATE(file);
+	struct pcc_file *pccf = &fd->fd_pcc_file;
+	struct pcc_inode *pcci;
+	struct file *pcc_file;
+	int rc = 0;
+
+	ENTRY;
+
+	if (!S_ISREG(inode->i_mode))
+		RETURN(0);
+
+	mutex_lock(&lli->lli_pcc_lock);
+	pcci = pcc_inode_get(inode);
+	if (pcci == NULL)
+		GOTO(out_unlock, rc = 0);
+
+	/* O_TRUNC is handled by the setattr that follows the open */
+	pcc_file = dentry_open(&pcci->pcci_path,
+			       file->f_flags & ~(O_CREAT | O_EXCL | O_TRUNC |
+						 O_NOCTTY),
+			       current_cred());
+	if (IS_ERR(pcc_file))
+		GOTO(out_put, rc = PTR_ERR(pcc_file));
+
+	pccf->pccf_file = pcc_file;
+	pccf->pccf_type = pcci->pcci_type;
+	atomic_inc(&pcci->pcci_open_count);
+
+	EXIT;
+out_put:
+	pcc_inode_put(pcci);
+out_unlock:
+	mutex_unlock(&lli->lli_pcc_lock);
+
+	return rc;
+}
+
+void pcc_file_release(struct inode *inode, struct file *file)
+{
+	struct ll_file_data *fd = LUSTRE_FPRIVATE(file);
+	struct pcc_file *pccf = &fd->fd_pcc_file;
+	struct pcc_inode *pcci;
+
+	if (pccf->pccf_file == NULL)
+		return;
+
+	pcci = pcc_inode_get(inode);
+	if (pcci != NULL) {
+		atomic_dec(&pcci->pcci_open_count);
+		pcc_inode_put(pcci);
+	}
+
+	fput(pccf->pccf_file);
+	pccf->pccf_file = NULL;
+	pccf->pccf_type = LU_PCC_NONE;
+}
+
+/*
+ * Start an I/O on the cached copy of @file. Returns NULL if the file has no
+ * cached copy open, or was detached in the meantime, and I/O has to go to
+ * Lustre.
+ */
+static struct pcc_inode *pcc_inode_io_init(struct inode *inode)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct pcc_inode *pcci;
+
+	spin_lock(&lli->lli_lock);
+	pcci = lli->lli_pcc_inode;
+	if (pcci != NULL) {
+		atomic_inc(&pcci->pcci_refcount);
+		atomic_inc(&pcci->pcci_active_ios);
+	}
+	spin_unlock(&lli->lli_lock);
+
+	return pcci;
+}
+
+static struct pcc_inode *pcc_io_init(struct file *file)
+{
+	struct ll_file_data *fd = LUSTRE_FPRIVATE(file);
+
+	if (fd == NULL || fd->fd_pcc_file.pccf_file == NULL)
+		return NULL;
+
+	return pcc_inode_io_init(file_inode(file));
+}
+
+static void pcc_io_fini(struct pcc_inode *pcci)
+{
+	if (atomic_dec_and_test(&pcci->pcci_active_ios))
+		wake_up_all(&pcci->pcci_waitq);
+	pcc_inode_put(pcci);
+}
+
+/* Keep the size of the Lustre inode in sync with the cached copy */
+static void pcc_inode_size_update(struct inode *inode, struct file *pcc_file)
+{
+	loff_t size = i_size_read(file_inode(pcc_file));
+
+	ll_inode_size_lock(inode);
+	if (i_size_read(inode) != size)
+		i_size_write(inode, size);
+	ll_inode_size_unlock(inode);
+}
+
+ssize_t pcc_file_read_iter(struct kiocb *iocb, struct iov_iter *iter,
+			   bool *cached)
+{
+	ssize_t result = 0;
+#ifdef HAVE_FILE_OPERATIONS_READ_WRITE_ITER
+	struct file *file = iocb->ki_filp;
+	struct file *pcc_file;
+	struct pcc_inode *pcci;
+#endif
+
+	ENTRY;
+
+	*cached = false;
+#ifdef HAVE_FILE_OPERATIONS_READ_WRITE_ITER
+	pcci = pcc_io_init(file);
+	if (pcci == NULL)
+		RETURN(0);
+
+	pcc_file = LUSTRE_FPRIVATE(file)->fd_pcc_file.pccf_file;
+	if (pcc_file->f_op->read_iter != NULL) {
+		*cached = true;
+		iocb->ki_filp = pcc_file;
+		result = pcc_file->f_op->read_iter(iocb, iter);
+		iocb->ki_filp = file;
+	}
+	pcc_io_fini(pcci);
+#endif
+
+	RETURN(result);
+}
+
+ssize_t pcc_file_write_iter(struct kiocb *iocb, struct iov_iter *iter,
+			    bool *cached)
+{
+	ssize_t result = 0;
+#ifdef HAVE_FILE_OPERATIONS_READ_WRITE_ITER
+	struct file *file = iocb->ki_filp;
+	struct file *pcc_file;
+	struct pcc_inode *pcci;
+#endif
+
+	ENTRY;
+
+	*cached = false;
+#ifdef HAVE_FILE_OPERATIONS_READ_WRITE_ITER
+	pcci = pcc_io_init(file);
+	if (pcci == NULL)
+		RETURN(0);
+
+	pcc_file = LUSTRE_FPRIVATE(file)->fd_pcc_file.pccf_file;
+	if (pcc_file->f_op->write_iter != NULL) {
+		*cached = true;
+		iocb->ki_filp = pcc_file;
+		file_start_write(pcc_file);
+		result = pcc_file->f_op->write_iter(iocb, iter);
+		file_end_write(pcc_file);
+		iocb->ki_filp = file;
+		if (result > 0)
+			pcc_inode_size_update(file_inode(file), pcc_file);
+	}
+	pcc_io_fini(pcci);
+#endif
+
+	RETURN(result);
+}
+
+int pcc_inode_getattr(struct inode *inode, bool *cached)
+{
+	struct pcc_inode *pcci;
+	struct kstat stat;
+	int rc;
+
+	ENTRY;
+
+	*cached = false;
+	if (!S_ISREG(inode->i_mode))
+		RETURN(0);
+
+	pcci = pcc_inode_io_init(inode);
+	if (pcci == NULL)
+		RETURN(0);
+
+#ifdef HAVE_INODEOPS_ENHANCED_GETATTR
+	rc = vfs_getattr(&pcci->pcci_path, &stat, STATX_BASIC_STATS,
+			 AT_STATX_SYNC_AS_STAT);
+#else
+	rc = vfs_getattr(&pcci->pcci_path, &stat);
+#endif
+	if (rc == 0) {
+		*cached = true;
+		ll_inode_size_lock(inode);
+		i_size_write(inode, stat.size);
+		inode->i_blocks = stat.blocks;
+		inode->i_atime = stat.atime;
+		inode->i_mtime = stat.mtime;
+		inode->i_ctime = stat.ctime;
+		ll_inode_size_unlock(inode);
+	}
+	pcc_io_fini(pcci);
+
+	RETURN(rc);
+}
+
+/*
+ * Apply the size and time changes of @attr to the cached copy of @inode.
+ * The caller still sends them to the MDT, but not to the OSTs.
+ */
+int pcc_inode_setattr(struct inode *inode, struct iattr *attr, bool *cached)
+{
+	struct pcc_inode *pcci;
+	struct dentry *pcc_dentry;
+	struct iattr pcc_attr;
+	int rc;
+
+	ENTRY;
+
+	*cached = false;
+	pcci = pcc_inode_io_init(inode);
+	if (pcci == NULL)
+		RETURN(0);
+
+	pcc_attr = *attr;
+	pcc_attr.ia_valid &= ATTR_SIZE | ATTR_ATIME | ATTR_ATIME_SET |
+			     ATTR_MTIME | ATTR_MTIME_SET | ATTR_CTIME;
+	pcc_attr.ia_valid |= ATTR_FORCE;
+
+	pcc_dentry = pcci->pcci_path.dentry;
+	inode_lock(pcc_dentry->d_inode);
+	rc = ll_notify_change(pcc_dentry, &pcc_attr);
+	inode_unlock(pcc_dentry->d_inode);
+	if (rc == 0) {
+		*cached = true;
+		if (attr->ia_valid & ATTR_SIZE) {
+			ll_inode_size_lock(inode);
+			i_size_write(inode, i_size_read(pcc_dentry->d_inode));
+			ll_inode_size_unlock(inode);
+		}
+	}
+	pcc_io_fini(pcci);
+
+	RETURN(rc);
+}
+
+int pcc_fsync(struct file *file, loff_t start, loff_t end, int datasync,
+	      bool *cached)
+{
+	struct pcc_inode *pcci;
+	int rc;
+
+	ENTRY;
+
+	*cached = false;
+	pcci = pcc_io_init(file);
+	if (pcci == NULL)
+		RETURN(0);
+
+	*cached = true;
+	rc = ll_vfs_fsync_range(LUSTRE_FPRIVATE(file)->fd_pcc_file.pccf_file,
+				start, end, datasync);
+	pcc_io_fini(pcci);
+
+	RETURN(rc);
+}
+
+int pcc_fallocate(struct file *file, int mode, loff_t offset, loff_t len,
+		  bool *cached)
+{
+	struct file *pcc_file;
+	struct pcc_inode *pcci;
+	int rc = 0;
+
+	ENTRY;
+
+	*cached = false;
+	pcci = pcc_io_init(file);
+	if (pcci == NULL)
+		RETURN(0);
+
+	pcc_file = LUSTRE_FPRIVATE(file)->fd_pcc_file.pccf_file;
+	*cached = true;
+	if (pcc_file->f_op->fallocate == NULL)
+		GOTO(out, rc = -EOPNOTSUPP);
+
+	file_start_write(pcc_file);
+	rc = pcc_file->f_op->fallocate(pcc_file, mode, offset, len);
+	file_end_write(pcc_file);
+	if (rc == 0)
+		pcc_inode_size_update(file_inode(file), pcc_file);
+out:
+	pcc_io_fini(pcci);
+
+	RETURN(rc);
+}
+
+/*
+ * Map the cached copy instead of the Lustre file. The mapping stays on the
+ * cached copy until it is unmapped, even if the file is detached meanwhile.
+ */
+int pcc_file_mmap(struct file *file, struct vm_area_struct *vma,
+		  bool *cached)
+{
+	struct file *pcc_file;
+	struct pcc_inode *pcci;
+	int rc = 0;
+
+	ENTRY;
+
+	*cached = false;
+	pcci = pcc_io_init(file);
+	if (pcci == NULL)
+		RETURN(0);
+
+	pcc_file = LUSTRE_FPRIVATE(file)->fd_pcc_file.pccf_file;
+	if (pcc_file->f_op->mmap != NULL) {
+		*cached = true;
+		get_file(pcc_file);
+		vma->vm_file = pcc_file;
+		rc = pcc_file->f_op->mmap(pcc_file, vma);
+		if (rc) {
+			vma->vm_file = file;
+			fput(pcc_file);
+		} else {
+			fput(file);
+		}
+	}
+	pcc_io_fini(pcci);
+
+	RETURN(rc);
+}
+
+int pcc_ioctl_attach(struct file *file, struct lu_pcc_attach *attach)
+{
+	struct inode *inode = file_inode(file);
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	struct pcc_dataset *dataset;
+	struct pcc_inode *pcci;
+	struct hsm_user_state *hus = NULL;
+	char *pathname = NULL;
+	struct path path;
+	__u32 gen;
+	int rc;
+
+	ENTRY;
+
+	if (!S_ISREG(inode->i_mode))
+		RETURN(-EINVAL);
+
+	if (attach->pcca_type != LU_PCC_READWRITE)
+		RETURN(-EOPNOTSUPP);
+
+	dataset = pcc_dataset_get(&sbi->ll_pcc_super, attach->pcca_id);
+	if (dataset == NULL)
+		RETURN(-ENOENT);
+
+	OBD_ALLOC(pathname, PATH_MAX);
+	if (pathname == NULL)
+		GOTO(out_dataset, rc = -ENOMEM);
+
+	if (pcc_fid2dataset_path(pathname, PATH_MAX, dataset,
+				 &lli->lli_fid) >= PATH_MAX)
+		GOTO(out_dataset, rc = -ENAMETOOLONG);
+
+	/* The file has to be archived into the dataset already */
+	rc = kern_path(pathname, 0, &path);
+	if (rc) {
+		CDEBUG(D_INODE, "%s: no archived copy of "DFID" at %s: "
+		       "rc = %d\n", ll_get_fsname(inode->i_sb, NULL, 0),
+		       PFID(&lli->lli_fid), pathname, rc);
+		GOTO(out_dataset, rc);
+	}
+
+	if (!S_ISREG(path.dentry->d_inode->i_mode))
+		GOTO(out_path, rc = -EINVAL);
+
+	OBD_ALLOC_PTR(hus);
+	if (hus == NULL)
+		GOTO(out_path, rc = -ENOMEM);
+
+	rc = ll_hsm_state_get(inode, hus);
+	if (rc)
+		GOTO(out_path, rc);
+
+	if (!(hus->hus_states & HS_ARCHIVED) ||
+	    hus->hus_states & (HS_DIRTY | HS_LOST) ||
+	    hus->hus_archive_id != attach->pcca_id)
+		GOTO(out_path, rc = -EPERM);
+
+	mutex_lock(&lli->lli_pcc_lock);
+	if (lli->lli_pcc_inode != NULL)
+		GOTO(out_unlock, rc = -EEXIST);
+
+	if (!(hus->hus_states & HS_RELEASED)) {
+		rc = ll_hsm_release(inode, file);
+		if (rc)
+			GOTO(out_unlock, rc);
+	}
+
+	/* Keep the layout lock, to learn about a restore from elsewhere */
+	rc = ll_layout_refresh(inode, &gen);
+	if (rc)
+		GOTO(out_unlock, rc);
+
+	OBD_ALLOC_PTR(pcci);
+	if (pcci == NULL)
+		GOTO(out_unlock, rc = -ENOMEM);
+
+	pcci->pcci_lli = lli;
+	pcci->pcci_path = path;
+	path.dentry = NULL;
+	atomic_set(&pcci->pcci_refcount, 1);
+	atomic_set(&pcci->pcci_open_count, 0);
+	atomic_set(&pcci->pcci_active_ios, 0);
+	init_waitqueue_head(&pcci->pcci_waitq);
+	pcci->pcci_type = attach->pcca_type;
+	pcci->pcci_id = attach->pcca_id;
+
+	spin_lock(&lli->lli_lock);
+	lli->lli_pcc_inode = pcci;
+	spin_unlock(&lli->lli_lock);
+
+	CDEBUG(D_INODE, "%s: attached "DFID" to PCC archive %u at %s\n",
+	       ll_get_fsname(inode->i_sb, NULL, 0), PFID(&lli->lli_fid),
+	       attach->pcca_id, pathname);
+
+	EXIT;
+out_unlock:
+	mutex_unlock(&lli->lli_pcc_lock);
+	/* Serve the I/O of the attaching file descriptor from the cache */
+	if (rc == 0 && LUSTRE_FPRIVATE(file)->fd_pcc_file.pccf_file == NULL)
+		rc = pcc_file_open(inode, file);
+out_path:
+	if (path.dentry != NULL)
+		path_put(&path);
+out_dataset:
+	if (hus != NULL)
+		OBD_FREE_PTR(hus);
+	if (pathname != NULL)
+		OBD_FREE(pathname, PATH_MAX);
+	pcc_dataset_put(dataset);
+
+	return rc;
+}
+
+int pcc_ioctl_detach(struct inode *inode)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	bool detached;
+
+	ENTRY;
+
+	if (!S_ISREG(inode->i_mode))
+		RETURN(-EINVAL);
+
+	mutex_lock(&lli->lli_pcc_lock);
+	detached = pcc_inode_detach(inode);
+	mutex_unlock(&lli->lli_pcc_lock);
+
+	RETURN(detached ? 0 : -ENODATA);
+}
+
+int pcc_ioctl_state(struct inode *inode, struct lu_pcc_state *state)
+{
+	struct pcc_inode *pcci;
+	char *buf;
+	char *path;
+	int rc = 0;
+
+	ENTRY;
+
+	if (!S_ISREG(inode->i_mode))
+		RETURN(-EINVAL);
+
+	memset(state, 0, sizeof(*state));
+	state->pccs_type = LU_PCC_NONE;
+
+	pcci = pcc_inode_get(inode);
+	if (pcci == NULL)
+		RETURN(0);
+
+	OBD_ALLOC(buf, PATH_MAX);
+	if (buf == NULL)
+		GOTO(out_put, rc = -ENOMEM);
+
+	path = d_path(&pcci->pcci_path, buf, PATH_MAX);
+	if (IS_ERR(path))
+		GOTO(out_free, rc = PTR_ERR(path));
+
+	state->pccs_type = pcci->pcci_type;
+	state->pccs_id = pcci->pcci_id;
+	state->pccs_open_count = atomic_read(&pcci->pcci_open_count);
+	strncpy(state->pccs_path, path, sizeof(state->pccs_path) - 1);
+
+	EXIT;
+out_free:
+	OBD_FREE(buf, PATH_MAX);
+out_put:
+	pcc_inode_put(pcci);
+
+	return rc;
+}
@@ -0,0 +1,106 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * Persistent Client Cache
+ *
+ * A regular file can be attached to a copy on a client-local file system
+ * (a PCC dataset), after which its data I/O is served from that copy
+ * instead of the OSTs. The Lustre file is HSM-released on attach with the
+ * archive ID of the dataset, so that the HSM copytool can restore the data
+ * back into Lustre from the cached copy when it is detached, or when it is
+ * accessed from another client.
+ */
+#ifndef LLITE_PCC_H
+#define LLITE_PCC_H
+
+#include <linux/types.h>
+#include <linux/fs.h>
+#include <linux/mutex.h>
+#include <linux/seq_file.h>
+#include <uapi/linux/lustre/lustre_user.h>
+
+struct ll_inode_info;
+
+struct pcc_dataset {
+	__u32			pccd_id;	 /* HSM archive ID */
+	char			pccd_pathname[PATH_MAX]; /* root path */
+	struct path		pccd_path;	 /* root of the dataset */
+	struct list_head	pccd_linkage;	 /* on pccs_datasets */
+	atomic_t		pccd_refcount;
+};
+
+struct pcc_super {
+	/* protects pccs_datasets */
+	struct rw_semaphore	pccs_rw_sem;
+	struct list_head	pccs_datasets;
+};
+
+struct pcc_inode {
+	struct ll_inode_info	*pcci_lli;
+	/* path of the cached copy */
+	struct path		 pcci_path;
+	atomic_t		 pcci_refcount;
+	/* number of opens of the cached copy */
+	atomic_t		 pcci_open_count;
+	/* number of I/Os in flight on the cached copy */
+	atomic_t		 pcci_active_ios;
+	wait_queue_head_t	 pcci_waitq;
+	enum lu_pcc_type	 pcci_type;
+	__u32			 pcci_id;
+};
+
+struct pcc_file {
+	/* opened cached copy, NULL if I/O goes to Lustre */
+	struct file		*pccf_file;
+	enum lu_pcc_type	 pccf_type;
+};
+
+int pcc_super_init(struct pcc_super *super);
+void pcc_super_fini(struct pcc_super *super);
+int pcc_cmd_handle(char *buffer, unsigned long count,
+		   struct pcc_super *super);
+int pcc_super_dump(struct pcc_super *super, struct seq_file *m);
+
+void pcc_inode_init(struct ll_inode_info *lli);
+void pcc_inode_free(struct inode *inode);
+void pcc_layout_invalidate(struct inode *inode);
+
+int pcc_file_open(struct inode *inode, struct file *file);
+void pcc_file_release(struct inode *inode, struct file *file);
+ssize_t pcc_file_read_iter(struct kiocb *iocb, struct iov_iter *iter,
+			   bool *cached);
+ssize_t pcc_file_write_iter(struct kiocb *iocb, struct iov_iter *iter,
+			    bool *cached);
+int pcc_inode_getattr(struct inode *inode, bool *cached);
+int pcc_inode_setattr(struct inode *inode, struct iattr *attr, bool *cached);
+int pcc_fsync(struct file *file, loff_t start, loff_t end, int datasync,
+	      bool *cached);
+int pcc_file_mmap(struct file *file, struct vm_area_struct *vma,
+		  bool *cached);
+int pcc_fallocate(struct file *file, int mode, loff_t offset, loff_t len,
+		  bool *cached);
+
+int pcc_ioctl_attach(struct file *file, struct lu_pcc_attach *attach);
+int pcc_ioctl_detach(struct inode *inode);
+int pcc_ioctl_state(struct inode *inode, struct lu_pcc_state *state);
+
+#endif /* LLITE_PCC_H */
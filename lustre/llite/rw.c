@@ -127,6 +127,15 @@ void ll_ra_stats_inc(struct inode *inode, enum ra_stat which)
 	ll_ra_stats_inc_sbi(sbi, which);
 }
 
+static void ll_ra_stats_add(struct inode *inode, enum ra_stat which,
+			    long amount)
+{
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+
+	LASSERTF(which < _NR_RA_STAT, "which: %u\n", which);
+	lprocfs_counter_add(sbi->ll_ra_stats, which, amount);
+}
+
 #define RAS_CDEBUG(ras) \
 	CDEBUG(D_READA,                                                      \
 	       "lrp %lu cr %lu cp %lu ws %lu wl %lu nra %lu rpc %lu "        \
@@ -152,18 +161,6 @@ static int index_in_window(unsigned long index, unsigned long point,
         return start <= index && index <= end;
 }
 
-void ll_ras_enter(struct file *f)
-{
-	struct ll_file_data *fd = LUSTRE_FPRIVATE(f);
-	struct ll_readahead_state *ras = &fd->fd_ras;
-
-	spin_lock(&ras->ras_lock);
-	ras->ras_requests++;
-	ras->ras_request_index = 0;
-	ras->ras_consecutive_requests++;
-	spin_unlock(&ras->ras_lock);
-}
-
 /**
  * Initiates read-ahead of a page with given index.
  *
@@ -339,7 +336,7 @@ static int ras_inside_ra_window(unsigned long idx, struct ra_io_arg *ria)
 static unsigned long
 ll_read_ahead_pages(const struct lu_env *env, struct cl_io *io,
 		    struct cl_page_list *queue, struct ll_readahead_state *ras,
-		    struct ra_io_arg *ria, pgoff_t *ra_end)
+		    struct ra_io_arg *ria, pgoff_t *ra_end, pgoff_t skip_index)
 {
 	struct cl_read_ahead ra = { 0 };
 	int rc = 0, count = 0;
@@ -384,6 +381,12 @@ ll_read_ahead_pages(const struct lu_env *env, struct cl_io *io,
 			if (page_idx > ria->ria_end)
 				break;
 
+			/* the page being read by the caller is locked and
+			 * already queued, e.g. inside a backward window,
+			 * CL_PAGE_EOF if there is no such page */
+			if (page_idx == skip_index)
+				continue;
+
 			/* If the page is inside the read-ahead window */
 			rc = ll_read_ahead_page(env, io, queue, page_idx);
 			if (rc < 0)
@@ -425,9 +428,251 @@ ll_read_ahead_pages(const struct lu_env *env, struct cl_io *io,
 	return count;
 }
 
+static void ll_readahead_handle_work(struct work_struct *work)
+{
+	struct ll_readahead_work *lrw;
+	struct file *file;
+	struct inode *inode;
+	struct ll_sb_info *sbi;
+	struct ll_file_data *fd;
+	struct lu_env *env;
+	struct cl_io *io;
+	struct cl_2queue *queue;
+	struct cl_attr *attr;
+	struct ra_io_arg *ria;
+	pgoff_t ra_end = 0;
+	pgoff_t eof_index;
+	unsigned long len;
+	__u16 refcheck;
+	int count = 0;
+	int rc;
+	ENTRY;
+
+	lrw = container_of(work, struct ll_readahead_work, lrw_work);
+	file = lrw->lrw_file;
+	inode = file_inode(file);
+	sbi = ll_i2sbi(inode);
+	fd = LUSTRE_FPRIVATE(file);
+
+	env = cl_env_get(&refcheck);
+	if (IS_ERR(env))
+		GOTO(out_free, rc = PTR_ERR(env));
+
+	io = vvp_env_thread_io(env);
+	ll_io_init(io, file, CIT_READ);
+	io->ci_async_readahead = 1;
+
+	attr = vvp_env_thread_attr(env);
+	cl_object_attr_lock(io->ci_obj);
+	rc = cl_object_attr_get(env, io->ci_obj, attr);
+	cl_object_attr_unlock(io->ci_obj);
+	if (rc != 0)
+		GOTO(out_env, rc);
+
+	if (attr->cat_kms == 0) {
+		ll_ra_stats_inc(inode, RA_STAT_ZERO_LEN);
+		GOTO(out_env, rc = 0);
+	}
+
+	ria = &ll_env_info(env)->lti_ria;
+	memset(ria, 0, sizeof(*ria));
+	ria->ria_start = lrw->lrw_start;
+	ria->ria_end = lrw->lrw_end;
+	/* Truncate RA window to end of file */
+	eof_index = (pgoff_t)((attr->cat_kms - 1) >> PAGE_SHIFT);
+	if (eof_index <= ria->ria_end) {
+		ria->ria_end = eof_index;
+		ria->ria_eof = true;
+	}
+	if (ria->ria_end < ria->ria_start)
+		GOTO(out_env, rc = 0);
+	/* the window was already RPC aligned by the reader, don't let
+	 * ll_read_ahead_pages() trim it once more */
+	ria->ria_end_min = ria->ria_end;
+
+	len = ria->ria_end - ria->ria_start + 1;
+	rc = cl_io_rw_init(env, io, CIT_READ, cl_offset(io->ci_obj,
+			   ria->ria_start), len << PAGE_SHIFT);
+	if (rc != 0)
+		GOTO(out_io_fini, rc);
+
+	vvp_env_io(env)->vui_io_subtype = IO_NORMAL;
+	vvp_env_io(env)->vui_fd = fd;
+	/* don't wait behind conflicting locks, the reader fetches the pages
+	 * itself if they could not be read ahead */
+	io->u.ci_rd.rd.crw_nonblock = 1;
+
+	rc = cl_io_iter_init(env, io);
+	if (rc != 0)
+		GOTO(out_iter_fini, rc);
+
+	rc = cl_io_lock(env, io);
+	if (rc != 0)
+		GOTO(out_iter_fini, rc);
+
+	rc = cl_io_start(env, io);
+	if (rc != 0)
+		GOTO(out_io_end, rc);
+
+	ria->ria_reserved = ll_ra_count_get(sbi, ria, len, 0);
+	if (ria->ria_reserved < len)
+		ll_ra_stats_inc(inode, RA_STAT_MAX_IN_FLIGHT);
+	if (ria->ria_reserved == 0)
+		GOTO(out_io_end, rc = 0);
+
+	CDEBUG(D_READA, DFID": async ria: %lu/%lu, reserved %lu/%lu\n",
+	       PFID(ll_inode2fid(inode)), ria->ria_start, ria->ria_end,
+	       ria->ria_reserved, len);
+
+	queue = &io->ci_queue;
+	cl_2queue_init(queue);
+
+	count = ll_read_ahead_pages(env, io, &queue->c2_qin, lrw->lrw_ras, ria,
+				    &ra_end, CL_PAGE_EOF);
+	if (ria->ria_reserved != 0)
+		ll_ra_count_put(sbi, ria->ria_reserved);
+
+	if (queue->c2_qin.pl_nr > 0) {
+		int nr = queue->c2_qin.pl_nr;
+
+		rc = cl_io_submit_rw(env, io, CRT_READ, queue);
+		if (rc == 0)
+			task_io_account_read(PAGE_SIZE * nr);
+	}
+
+	if (ra_end == ria->ria_end && ria->ria_eof)
+		ll_ra_stats_inc(inode, RA_STAT_EOF);
+	if (ra_end != ria->ria_end)
+		ll_ra_stats_inc(inode, RA_STAT_FAILED_REACH_END);
+
+	cl_page_list_discard(env, io, &queue->c2_qin);
+
+	/* Unlock unsent read pages in case of error. */
+	cl_page_list_disown(env, io, &queue->c2_qin);
+
+	cl_2queue_fini(env, queue);
+out_io_end:
+	cl_io_end(env, io);
+	cl_io_unlock(env, io);
+out_iter_fini:
+	cl_io_iter_fini(env, io);
+out_io_fini:
+	cl_io_fini(env, io);
+out_env:
+	cl_env_put(env, &refcheck);
+out_free:
+	if (count > 0)
+		ll_ra_stats_add(inode, RA_STAT_ASYNC, count);
+	if (rc < 0)
+		CDEBUG(D_READA, DFID": async readahead [%lu, %lu] failed: "
+		       "rc = %d\n", PFID(ll_inode2fid(inode)), lrw->lrw_start,
+		       lrw->lrw_end, rc);
+	atomic_dec(&sbi->ll_ra_info.ra_async_inflight);
+	fput(file);
+	OBD_FREE_PTR(lrw);
+	EXIT;
+}
+
+/**
+ * Hand the rest of the readahead window of \a ras, from page \a start on,
+ * over to the async readahead workers.
+ *
+ * This can be called with preemption disabled from the fast read path, so
+ * it must not sleep.
+ *
+ * \retval 1 window was queued, ras_next_readahead is moved past it
+ * \retval 0 the caller has to read ahead by itself
+ */
+static int ll_readahead_async(struct file *file, struct ll_readahead_state *ras,
+			      pgoff_t start)
+{
+	struct inode *inode = file_inode(file);
+	struct ll_ra_info *ra = &ll_i2sbi(inode)->ll_ra_info;
+	struct ll_readahead_work *lrw;
+	unsigned long threshold;
+	pgoff_t end;
+
+	threshold = min(ra->ra_async_pages_per_file_threshold,
+			ra->ra_max_pages_per_file);
+	if (ra->ra_async_wq == NULL || threshold == 0)
+		return 0;
+
+	/* keep queued works bounded, each one reserves pages from
+	 * ra_cur_pages only once it runs */
+	if (atomic_read(&ra->ra_async_inflight) >= 2 * ra->ra_async_max_active)
+		return 0;
+
+	OBD_ALLOC_GFP(lrw, sizeof(*lrw), GFP_ATOMIC);
+	if (lrw == NULL)
+		return 0;
+
+	spin_lock(&ras->ras_lock);
+	/* stride readahead reads holes of the window, leave it to the
+	 * reader which keeps the stride detector in sync */
+	if (stride_io_mode(ras) || ras->ras_window_len < threshold)
+		GOTO(out_unlock, 0);
+
+	start = max(start, ras->ras_next_readahead);
+	end = ras->ras_window_start + ras->ras_window_len - 1;
+	if (start > end ||
+	    atomic_read(&ra->ra_cur_pages) + end - start + 1 > ra->ra_max_pages)
+		GOTO(out_unlock, 0);
+
+	ras->ras_next_readahead = end + 1;
+	spin_unlock(&ras->ras_lock);
+
+	lrw->lrw_file = get_file(file);
+	lrw->lrw_ras = ras;
+	lrw->lrw_start = start;
+	lrw->lrw_end = end;
+	INIT_WORK(&lrw->lrw_work, ll_readahead_handle_work);
+
+	CDEBUG(D_READA, DFID": queue async readahead [%lu, %lu]\n",
+	       PFID(ll_inode2fid(inode)), start, end);
+
+	atomic_inc(&ra->ra_async_inflight);
+	queue_work(ra->ra_async_wq, &lrw->lrw_work);
+
+	return 1;
+
+out_unlock:
+	spin_unlock(&ras->ras_lock);
+	OBD_FREE_PTR(lrw);
+	return 0;
+}
+
+int ll_readahead_async_init(struct ll_sb_info *sbi)
+{
+	struct ll_ra_info *ra = &sbi->ll_ra_info;
+
+	atomic_set(&ra->ra_async_inflight, 0);
+	ra->ra_async_pages_per_file_threshold = SBI_DEFAULT_RA_ASYNC_THRESHOLD;
+	ra->ra_async_max_active = num_online_cpus() *
+				  SBI_DEFAULT_RA_ASYNC_ACTIVE_PER_CPU;
+	/* unbound workers are pooled per NUMA node, so readahead pages are
+	 * allocated on the node of the reader's CPT by default */
+	ra->ra_async_wq = alloc_workqueue("ll_readahead", WQ_UNBOUND,
+					  ra->ra_async_max_active);
+	if (ra->ra_async_wq == NULL)
+		return -ENOMEM;
+
+	return 0;
+}
+
+void ll_readahead_async_fini(struct ll_sb_info *sbi)
+{
+	struct ll_ra_info *ra = &sbi->ll_ra_info;
+
+	if (ra->ra_async_wq != NULL) {
+		destroy_workqueue(ra->ra_async_wq);
+		ra->ra_async_wq = NULL;
+	}
+}
+
 static int ll_readahead(const struct lu_env *env, struct cl_io *io,
 			struct cl_page_list *queue,
-			struct ll_readahead_state *ras, bool hit)
+			struct ll_readahead_state *ras, bool hit,
+			struct file *file, pgoff_t skip_index)
 {
 	struct vvp_io *vio = vvp_env_io(env);
 	struct ll_thread_info *lti = ll_env_info(env);
@@ -437,6 +682,7 @@ static int ll_readahead(const struct lu_env *env, struct cl_io *io,
 	struct inode *inode;
 	struct ra_io_arg *ria = &lti->lti_ria;
 	struct cl_object *clob;
+	bool async = false;
 	int ret = 0;
 	__u64 kms;
 	ENTRY;
@@ -531,6 +777,22 @@ static int ll_readahead(const struct lu_env *env, struct cl_io *io,
 		ria->ria_end_min = ria->ria_start + mlen;
 	}
 
+	/* Only read the pages needed by the current read here, the rest of
+	 * the window is filled by the async readahead workers. */
+	if (file != NULL) {
+		pgoff_t async_start = mlen > 0 ? ria->ria_end_min + 1 :
+						 ria->ria_start;
+
+		if (async_start <= ria->ria_end &&
+		    ll_readahead_async(file, ras, async_start) > 0) {
+			async = true;
+			if (mlen == 0)
+				RETURN(0);
+			ria->ria_end = ria->ria_end_min;
+			len = ria_page_count(ria);
+		}
+	}
+
 	ria->ria_reserved = ll_ra_count_get(ll_i2sbi(inode), ria, len, mlen);
 	if (ria->ria_reserved < len)
 		ll_ra_stats_inc(inode, RA_STAT_MAX_IN_FLIGHT);
@@ -540,7 +802,7 @@ static int ll_readahead(const struct lu_env *env, struct cl_io *io,
 	       atomic_read(&ll_i2sbi(inode)->ll_ra_info.ra_cur_pages),
 	       ll_i2sbi(inode)->ll_ra_info.ra_max_pages);
 
-	ret = ll_read_ahead_pages(env, io, queue, ras, ria, &ra_end);
+	ret = ll_read_ahead_pages(env, io, queue, ras, ria, &ra_end, skip_index);
 
 	if (ria->ria_reserved != 0)
 		ll_ra_count_put(ll_i2sbi(inode), ria->ria_reserved);
@@ -551,9 +813,13 @@ static int ll_readahead(const struct lu_env *env, struct cl_io *io,
 	CDEBUG(D_READA, "ra_end = %lu end = %lu stride end = %lu pages = %d\n",
 	       ra_end, end, ria->ria_end, ret);
 
-	if (ra_end != end)
+	if (ret > 0)
+		ll_ra_stats_add(inode, RA_STAT_SYNC, ret);
+	if (ra_end != end && !async)
 		ll_ra_stats_inc(inode, RA_STAT_FAILED_REACH_END);
-	if (ra_end > 0) {
+	/* the async readahead has already moved ras_next_readahead forward,
+	 * don't roll it back */
+	if (ra_end > 0 && !async) {
 		/* update the ras so that the next read-ahead tries from
 		 * where we left off. */
 		spin_lock(&ras->ras_lock);
@@ -594,12 +860,33 @@ static void ras_stride_reset(struct ll_readahead_state *ras)
         RAS_CDEBUG(ras);
 }
 
-void ll_readahead_init(struct inode *inode, struct ll_readahead_state *ras)
+/* called with the ras_lock held or from places where it doesn't matter */
+static void ras_stream_init(struct inode *inode, struct ll_readahead_state *ras,
+			    unsigned long index)
 {
-	spin_lock_init(&ras->ras_lock);
 	ras->ras_rpc_size = PTLRPC_MAX_BRW_PAGES;
-	ras_reset(inode, ras, 0);
+	ras_reset(inode, ras, index);
+	ras_stride_reset(ras);
 	ras->ras_requests = 0;
+	ras->ras_request_index = 0;
+	ras->ras_request_start = index;
+	ras->ras_consecutive_backward_requests = 0;
+}
+
+void ll_readahead_init(struct inode *inode, struct ll_readahead_streams *lrs)
+{
+	int i;
+
+	spin_lock_init(&lrs->lrs_lock);
+	lrs->lrs_clock = 0;
+	for (i = 0; i < LL_RA_STREAMS_MAX; i++) {
+		struct ll_readahead_state *ras = &lrs->lrs_ras[i];
+
+		spin_lock_init(&ras->ras_lock);
+		ras_stream_init(inode, ras, 0);
+		ras->ras_stream = i;
+		ras->ras_lru = 0;
+	}
 }
 
 /*
@@ -626,6 +913,156 @@ static int index_in_stride_window(struct ll_readahead_state *ras,
 		ras->ras_consecutive_pages == ras->ras_stride_pages;
 }
 
+static inline bool backward_io_mode(struct ll_readahead_state *ras)
+{
+	return ras->ras_consecutive_backward_requests > 1;
+}
+
+/*
+ * Check whether a request starting at \a index ends right before the start
+ * of the previous request, which was [ras_request_start, ras_last_readpage].
+ */
+static bool ras_backward_step(struct ll_readahead_state *ras,
+			      unsigned long index)
+{
+	unsigned long pages;
+
+	if (index >= ras->ras_request_start ||
+	    ras->ras_last_readpage < ras->ras_request_start)
+		return false;
+
+	pages = ras->ras_last_readpage - ras->ras_request_start + 1;
+
+	return index_in_window(index + pages, ras->ras_request_start, 8, 8);
+}
+
+/* called with the ras_lock held */
+static bool ras_stream_match(struct ll_readahead_state *ras,
+			     unsigned long index)
+{
+	if (index_in_window(index, ras->ras_last_readpage, 8, 8))
+		return true;
+
+	if (ras->ras_window_len > 0 &&
+	    index_in_window(index, ras->ras_window_start, 0,
+			    ras->ras_window_len))
+		return true;
+
+	if (stride_io_mode(ras) && index_in_stride_window(ras, index))
+		return true;
+
+	return ras_backward_step(ras, index);
+}
+
+/**
+ * Find the read-ahead stream of \a fd that an access to page \a index
+ * continues, or set up a new stream for it in a free slot, replacing the
+ * least recently used stream if there is none.
+ */
+static struct ll_readahead_state *
+ll_ras_stream_get(struct inode *inode, struct ll_file_data *fd, pgoff_t index)
+{
+	struct ll_readahead_streams *lrs = &fd->fd_ras;
+	struct ll_ra_info *ra = &ll_i2sbi(inode)->ll_ra_info;
+	struct ll_readahead_state *found = NULL;
+	struct ll_readahead_state *mru = NULL;
+	struct ll_readahead_state *lru = NULL;
+	struct ll_readahead_state *ras;
+	int i;
+
+	spin_lock(&lrs->lrs_lock);
+	for (i = 0; i < LL_RA_STREAMS_MAX; i++) {
+		ras = &lrs->lrs_ras[i];
+
+		/* free slots are used first for a new stream */
+		if (ras->ras_lru == 0) {
+			if (lru == NULL || lru->ras_lru != 0)
+				lru = ras;
+			continue;
+		}
+		if (lru == NULL ||
+		    (lru->ras_lru != 0 && ras->ras_lru < lru->ras_lru))
+			lru = ras;
+		if (mru == NULL || ras->ras_lru > mru->ras_lru)
+			mru = ras;
+
+		spin_lock(&ras->ras_lock);
+		if ((found == NULL || ras->ras_lru > found->ras_lru) &&
+		    ras_stream_match(ras, index))
+			found = ras;
+		spin_unlock(&ras->ras_lock);
+	}
+
+	/* A forward seek not far away from the most recently used stream may
+	 * be the next chunk of a stride pattern, leave it to the stride
+	 * detector of that stream. */
+	if (found == NULL && mru != NULL) {
+		spin_lock(&mru->ras_lock);
+		if (index > mru->ras_last_readpage &&
+		    index - mru->ras_last_readpage <= ra->ra_max_pages_per_file)
+			found = mru;
+		spin_unlock(&mru->ras_lock);
+	}
+
+	if (found == NULL) {
+		found = lru;
+		if (found->ras_lru != 0)
+			ll_ra_stats_inc(inode, RA_STAT_STREAM_REPLACED);
+		ll_ra_stats_inc(inode, RA_STAT_STREAM_NEW);
+
+		spin_lock(&found->ras_lock);
+		ras_stream_init(inode, found, index);
+		spin_unlock(&found->ras_lock);
+
+		CDEBUG(D_READA, DFID": new read-ahead stream %u at %lu\n",
+		       PFID(ll_inode2fid(inode)), found->ras_stream, index);
+	}
+	found->ras_lru = ++lrs->lrs_clock;
+	spin_unlock(&lrs->lrs_lock);
+
+	return found;
+}
+
+struct ll_readahead_state *ll_ras_enter(struct file *f, pgoff_t index)
+{
+	struct ll_file_data *fd = LUSTRE_FPRIVATE(f);
+	struct ll_readahead_state *ras;
+
+	ras = ll_ras_stream_get(file_inode(f), fd, index);
+
+	spin_lock(&ras->ras_lock);
+	ras->ras_requests++;
+	ras->ras_request_index = 0;
+	ras->ras_consecutive_requests++;
+	spin_unlock(&ras->ras_lock);
+
+	return ras;
+}
+
+/*
+ * Set up the read-ahead window below page \a index, where the next request
+ * of a backward reader is expected. Called with the ras_lock held.
+ */
+static void ras_backward_window(struct ll_readahead_state *ras,
+				struct ll_ra_info *ra, unsigned long index)
+{
+	unsigned long wlen;
+
+	wlen = min(ras->ras_window_len + ras->ras_rpc_size,
+		   ra->ra_max_pages_per_file);
+	if (index > wlen)
+		ras->ras_window_start = ras_align(ras, index - wlen, NULL);
+	else
+		ras->ras_window_start = 0;
+	ras->ras_window_len = index - ras->ras_window_start;
+	ras->ras_next_readahead = ras->ras_window_start;
+	ras->ras_last_readpage = index;
+	ras->ras_consecutive_pages = 1;
+	ras_stride_reset(ras);
+
+	RAS_CDEBUG(ras);
+}
+
 static void ras_update_stride_detector(struct ll_readahead_state *ras,
                                        unsigned long index)
 {
@@ -736,6 +1173,29 @@ static void ras_update(struct ll_sb_info *sbi, struct inode *inode,
 		CDEBUG(D_READA, DFID " pages at %lu miss.\n",
 		       PFID(ll_inode2fid(inode)), index);
         ll_ra_stats_inc_sbi(sbi, hit ? RA_STAT_HIT : RA_STAT_MISS);
+	ll_ra_stats_inc_sbi(sbi, (hit ? RA_STAT_STREAM_HIT :
+				  RA_STAT_STREAM_MISS) + ras->ras_stream);
+
+	/* Backward read-ahead: each request is read forward, but starts right
+	 * before the previous one. The mmap case never resets
+	 * ras_request_index, so it is not detected there. */
+	if (!(flags & LL_RAS_MMAP) && ras->ras_request_index == 0) {
+		if (ras_backward_step(ras, index))
+			ras->ras_consecutive_backward_requests++;
+		else
+			ras->ras_consecutive_backward_requests = 0;
+		ras->ras_request_start = index;
+
+		if (backward_io_mode(ras)) {
+			ras_backward_window(ras, ra, index);
+			GOTO(out_unlock, 0);
+		}
+	} else if (backward_io_mode(ras)) {
+		/* keep the window below the request */
+		ras->ras_consecutive_pages++;
+		ras->ras_last_readpage = index;
+		GOTO(out_unlock, 0);
+	}
 
         /* reset the read-ahead window in two cases.  First when the app seeks
          * or reads to some other part of the file.  Secondly if we get a
@@ -1083,7 +1543,8 @@ int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 	struct inode              *inode  = vvp_object_inode(page->cp_obj);
 	struct ll_sb_info         *sbi    = ll_i2sbi(inode);
 	struct ll_file_data       *fd     = LUSTRE_FPRIVATE(file);
-	struct ll_readahead_state *ras    = &fd->fd_ras;
+	struct vvp_io             *vio    = vvp_env_io(env);
+	struct ll_readahead_state *ras    = vio->vui_ras;
 	struct cl_2queue          *queue  = &io->ci_queue;
 	struct cl_sync_io	  *anchor = NULL;
 	struct vvp_page           *vpg;
@@ -1094,10 +1555,13 @@ int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 	vpg = cl2vvp_page(cl_object_page_slice(page->cp_obj, page));
 	uptodate = vpg->vpg_defer_uptodate;
 
+	/* not a read(2), e.g. a partial page write or a page fault */
+	if (ras == NULL)
+		ras = ll_ras_stream_get(inode, fd, vvp_index(vpg));
+
 	if (sbi->ll_ra_info.ra_max_pages_per_file > 0 &&
 	    sbi->ll_ra_info.ra_max_pages > 0 &&
 	    !vpg->vpg_ra_updated) {
-		struct vvp_io *vio = vvp_env_io(env);
 		enum ras_update_flags flags = 0;
 
 		if (uptodate)
@@ -1125,7 +1589,8 @@ int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 		int rc2;
 
 		rc2 = ll_readahead(env, io, &queue->c2_qin, ras,
-				   uptodate);
+				   uptodate, file,
+				   uptodate ? CL_PAGE_EOF : vvp_index(vpg));
 		CDEBUG(D_READA, DFID "%d pages read ahead at %lu\n",
 		       PFID(ll_inode2fid(inode)), rc2, vvp_index(vpg));
 	}
@@ -1186,7 +1651,7 @@ int ll_readpage(struct file *file, struct page *vmpage)
 	if (io == NULL) { /* fast read */
 		struct inode *inode = file_inode(file);
 		struct ll_file_data *fd = LUSTRE_FPRIVATE(file);
-		struct ll_readahead_state *ras = &fd->fd_ras;
+		struct ll_readahead_state *ras;
 		struct lu_env  *local_env = NULL;
 		struct vvp_page *vpg;
 
@@ -1212,6 +1677,8 @@ int ll_readpage(struct file *file, struct page *vmpage)
 			if (lcc && lcc->lcc_type == LCC_MMAP)
 				flags |= LL_RAS_MMAP;
 
+			ras = ll_ras_stream_get(inode, fd, vvp_index(vpg));
+
 			/* For fast read, it updates read ahead state only
 			 * if the page is hit in cache because non cache page
 			 * case will be handled by slow read later. */
@@ -1222,9 +1689,11 @@ int ll_readpage(struct file *file, struct page *vmpage)
 
 			/* Check if we can issue a readahead RPC, if that is
 			 * the case, we can't do fast IO because we will need
-			 * a cl_io to issue the RPC. */
+			 * a cl_io to issue the RPC, unless the readahead can
+			 * be handed over to the async readahead workers. */
 			if (ras->ras_window_start + ras->ras_window_len <
-			    ras->ras_next_readahead + PTLRPC_MAX_BRW_PAGES) {
+			    ras->ras_next_readahead + PTLRPC_MAX_BRW_PAGES ||
+			    ll_readahead_async(file, ras, 0) > 0) {
 				/* export the page and skip io stack */
 				vpg->vpg_ra_used = 1;
 				cl_page_export(env, page, 1);
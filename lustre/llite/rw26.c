@@ -174,14 +174,198 @@ static int ll_releasepage(struct page *vmpage, RELEASEPAGE_ARG_TYPE gfp_mask)
 
 #define MAX_DIRECTIO_SIZE 2*1024*1024*1024UL
 
+/*  ll_free_user_pages - tear down page struct array
+ *  @pages: array of page struct pointers underlying target buffer */
+static void ll_free_user_pages(struct page **pages, int npages, int do_dirty)
+{
+	int i;
+
+	for (i = 0; i < npages; i++) {
+		if (pages[i] == NULL)
+			break;
+		if (do_dirty)
+			set_page_dirty_lock(pages[i]);
+		put_page(pages[i]);
+	}
+
+#if defined(HAVE_DIRECTIO_ITER) || defined(HAVE_IOV_ITER_RW)
+	kvfree(pages);
+#else
+	OBD_FREE_LARGE(pages, npages * sizeof(*pages));
+#endif
+}
+
+/* user pages of an aligned asynchronous direct I/O, released once the I/O
+ * completes in ll_dio_aio_end() */
+struct ll_dio_user_pages {
+	struct list_head	 ldu_linkage;
+	struct page		**ldu_pages;
+	int			 ldu_count;
+	/* the pages were read into, dirty them when releasing */
+	bool			 ldu_dirty;
+};
+
+/* bounce pages of an unaligned direct I/O, from the bulk page pool */
+struct ll_dio_bounce {
+	struct list_head	 ldb_linkage;
+	unsigned int		 ldb_count;
+	struct page		*ldb_pages[0];
+};
+
+static struct ll_dio_bounce *ll_dio_bounce_alloc(unsigned int count)
+{
+	struct ll_dio_bounce *ldb;
+	int rc;
+
+	OBD_ALLOC(ldb, offsetof(struct ll_dio_bounce, ldb_pages[count]));
+	if (ldb == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	rc = sptlrpc_enc_pool_get_pages_array(ldb->ldb_pages, count);
+	if (rc) {
+		OBD_FREE(ldb, offsetof(struct ll_dio_bounce, ldb_pages[count]));
+		return ERR_PTR(rc);
+	}
+	INIT_LIST_HEAD(&ldb->ldb_linkage);
+	ldb->ldb_count = count;
+
+	return ldb;
+}
+
+static void ll_dio_bounce_free(struct ll_dio_bounce *ldb)
+{
+	unsigned int count = ldb->ldb_count;
+
+	sptlrpc_enc_pool_put_pages_array(ldb->ldb_pages, count);
+	OBD_FREE(ldb, offsetof(struct ll_dio_bounce, ldb_pages[count]));
+}
+
+/*
+ * Completion of the last page of a direct I/O, or of the submitter if that
+ * comes later. A synchronous request is handed back to the submitter that
+ * waits for it in ll_dio_aio_finish().
+ */
+static void ll_dio_aio_end(const struct lu_env *env, struct cl_sync_io *anchor)
+{
+	struct ll_dio_aio *aio = container_of(anchor, struct ll_dio_aio,
+					      lda_sync);
+	struct ll_dio_user_pages *ldu;
+	struct ll_dio_user_pages *ldu_tmp;
+	struct ll_dio_bounce *ldb;
+	struct ll_dio_bounce *tmp;
+	struct kiocb *iocb = aio->lda_iocb;
+	ENTRY;
+
+	cl_page_list_delete(env, &aio->lda_pages);
+
+	list_for_each_entry_safe(ldu, ldu_tmp, &aio->lda_user_pages,
+				 ldu_linkage) {
+		list_del(&ldu->ldu_linkage);
+		ll_free_user_pages(ldu->ldu_pages, ldu->ldu_count,
+				   ldu->ldu_dirty);
+		OBD_FREE_PTR(ldu);
+	}
+
+	list_for_each_entry_safe(ldb, tmp, &aio->lda_bounces, ldb_linkage) {
+		list_del(&ldb->ldb_linkage);
+		ll_dio_bounce_free(ldb);
+	}
+
+	inode_dio_end(aio->lda_inode);
+
+	if (iocb == NULL) {
+		cl_sync_io_end(env, anchor);
+		RETURN_EXIT;
+	}
+
+	CDEBUG(D_VFSTRACE, "inode %lu: AIO %p completed: bytes %zd, rc = %d\n",
+	       aio->lda_inode->i_ino, iocb, aio->lda_bytes,
+	       anchor->csi_sync_rc);
+	aio_complete(iocb, anchor->csi_sync_rc ? : aio->lda_bytes, 0);
+	OBD_SLAB_FREE_PTR(aio, ll_dio_aio_kmem);
+	EXIT;
+}
+
+/**
+ * Allocate the tracking of a direct read or write through \a iocb.
+ *
+ * The submitter holds a reference on it until ll_dio_aio_finish(), so that
+ * it is not completed while pages are still being sent.
+ */
+struct ll_dio_aio *ll_dio_aio_alloc(struct kiocb *iocb)
+{
+	struct ll_dio_aio *aio;
+
+	OBD_SLAB_ALLOC_PTR_GFP(aio, ll_dio_aio_kmem, GFP_NOFS);
+	if (aio == NULL)
+		return NULL;
+
+	cl_sync_io_init(&aio->lda_sync, 1, ll_dio_aio_end);
+	cl_page_list_init(&aio->lda_pages);
+	INIT_LIST_HEAD(&aio->lda_user_pages);
+	INIT_LIST_HEAD(&aio->lda_bounces);
+	aio->lda_inode = file_inode(iocb->ki_filp);
+	aio->lda_iocb = is_sync_kiocb(iocb) ? NULL : iocb;
+
+	/* truncate waits for the I/O in flight in inode_dio_wait() */
+	inode_dio_begin(aio->lda_inode);
+
+	return aio;
+}
+
+/**
+ * Drop the reference of the submitter on \a aio once all of the direct I/O
+ * has been sent.
+ *
+ * A synchronous request is waited for and freed here. An asynchronous one
+ * that sent anything is completed with \a bytes, or the first transfer
+ * error, when its last page is transferred.
+ *
+ * \retval -EIOCBQUEUED if the request is completed asynchronously
+ * \retval 0 if all pages were transferred
+ * \retval negative errno of the first failed transfer
+ */
+int ll_dio_aio_finish(const struct lu_env *env, struct ll_dio_aio *aio,
+		      ssize_t bytes)
+{
+	struct cl_sync_io *anchor = &aio->lda_sync;
+	int rc;
+
+	/* nothing was sent, return the error directly */
+	if (bytes <= 0)
+		aio->lda_iocb = NULL;
+
+	if (aio->lda_iocb != NULL) {
+		aio->lda_bytes = bytes;
+		/* @aio may be freed once this reference is dropped */
+		cl_sync_io_note(env, anchor, 0);
+		return -EIOCBQUEUED;
+	}
+
+	cl_sync_io_note(env, anchor, 0);
+	rc = cl_sync_io_wait(env, anchor, 0);
+	OBD_SLAB_FREE_PTR(aio, ll_dio_aio_kmem);
+
+	return rc;
+}
+
+/*
+ * Send @size bytes at @file_offset from or to @pages as transient pages.
+ * The data is at the same offset in the first page as in the file page,
+ * so only part of the first and last pages may be transferred.
+ *
+ * With @aio the pages are left in flight, to be released on its completion,
+ * otherwise they are waited for here.
+ */
 static ssize_t
 ll_direct_IO_seg(const struct lu_env *env, struct cl_io *io, int rw,
 		 struct inode *inode, size_t size, loff_t file_offset,
-		 struct page **pages, int page_count)
+		 struct page **pages, int page_count, struct ll_dio_aio *aio)
 {
 	struct cl_page *clp;
 	struct cl_2queue *queue;
 	struct cl_object *obj = io->ci_obj;
+	enum cl_req_type crt = rw == READ ? CRT_READ : CRT_WRITE;
 	int i;
 	ssize_t rc = 0;
 	size_t page_size = cl_page_size(obj);
@@ -192,8 +376,10 @@ ll_direct_IO_seg(const struct lu_env *env, struct cl_io *io, int rw,
 	ENTRY;
 	queue = &io->ci_queue;
 	cl_2queue_init(queue);
-	for (i = 0; i < page_count; i++) {
-		LASSERT(!(file_offset & (page_size - 1)));
+	for (i = 0; i < page_count && size > 0; i++) {
+		size_t from = file_offset & (page_size - 1);
+		size_t to = min(from + size, page_size);
+
 		clp = cl_page_find(env, obj, cl_index(obj, file_offset),
 				   pages[i], CPT_TRANSIENT);
 		if (IS_ERR(clp)) {
@@ -225,7 +411,7 @@ ll_direct_IO_seg(const struct lu_env *env, struct cl_io *io, int rw,
 
 			src = ll_kmap_atomic(src_page, KM_USER0);
 			dst = ll_kmap_atomic(dst_page, KM_USER1);
-			memcpy(dst, src, min(page_size, size));
+			memcpy(dst + from, src + from, to - from);
 			ll_kunmap_atomic(dst, KM_USER1);
 			ll_kunmap_atomic(src, KM_USER0);
 
@@ -252,21 +438,42 @@ ll_direct_IO_seg(const struct lu_env *env, struct cl_io *io, int rw,
 			 * Set page clip to tell transfer formation engine
 			 * that page has to be sent even if it is beyond KMS.
 			 */
-			cl_page_clip(env, clp, 0, min(size, page_size));
+			cl_page_clip(env, clp, from, to);
 
 			++io_pages;
 		}
 
 		/* drop the reference count for cl_page_find */
 		cl_page_put(env, clp);
-		size -= page_size;
-		file_offset += page_size;
+		size -= to - from;
+		file_offset += to - from;
 	}
 
-	if (rc == 0 && io_pages) {
-		rc = cl_io_submit_sync(env, io,
-				       rw == READ ? CRT_READ : CRT_WRITE,
-				       queue, 0);
+	if (rc == 0 && io_pages && aio == NULL) {
+		rc = cl_io_submit_sync(env, io, crt, queue, 0);
+	} else if (rc == 0 && io_pages) {
+		struct cl_sync_io *anchor = &aio->lda_sync;
+
+		cl_page_list_for_each(clp, &queue->c2_qin) {
+			LASSERT(clp->cp_sync_io == NULL);
+			clp->cp_sync_io = anchor;
+		}
+		atomic_add(io_pages, &anchor->csi_sync_nr);
+
+		rc = cl_io_submit_rw(env, io, crt, queue);
+		if (rc == 0) {
+			/* pages not sent, e.g. clean ones, are complete */
+			cl_page_list_for_each(clp, &queue->c2_qin) {
+				clp->cp_sync_io = NULL;
+				cl_sync_io_note(env, anchor, 0);
+			}
+			cl_page_list_splice(&queue->c2_qout, &aio->lda_pages);
+		} else {
+			LASSERT(list_empty(&queue->c2_qout.pl_pages));
+			cl_page_list_for_each(clp, &queue->c2_qin)
+				clp->cp_sync_io = NULL;
+			atomic_sub(io_pages, &anchor->csi_sync_nr);
+		}
 	}
 	if (rc == 0)
 		rc = orig_size;
@@ -277,27 +484,6 @@ ll_direct_IO_seg(const struct lu_env *env, struct cl_io *io, int rw,
 	RETURN(rc);
 }
 
-/*  ll_free_user_pages - tear down page struct array
- *  @pages: array of page struct pointers underlying target buffer */
-static void ll_free_user_pages(struct page **pages, int npages, int do_dirty)
-{
-	int i;
-
-	for (i = 0; i < npages; i++) {
-		if (pages[i] == NULL)
-			break;
-		if (do_dirty)
-			set_page_dirty_lock(pages[i]);
-		put_page(pages[i]);
-	}
-
-#if defined(HAVE_DIRECTIO_ITER) || defined(HAVE_IOV_ITER_RW)
-	kvfree(pages);
-#else
-	OBD_FREE_LARGE(pages, npages * sizeof(*pages));
-#endif
-}
-
 #ifdef KMALLOC_MAX_SIZE
 #define MAX_MALLOC KMALLOC_MAX_SIZE
 #else
@@ -317,6 +503,71 @@ static void ll_free_user_pages(struct page **pages, int npages, int do_dirty)
 #endif
 
 #if defined(HAVE_DIRECTIO_ITER) || defined(HAVE_IOV_ITER_RW)
+/*
+ * Direct I/O not aligned to pages, in the file or in memory, goes through
+ * bounce pages laid out like the file pages they are sent for. Writes are
+ * copied in before the pages are sent and can be left in flight with @aio,
+ * reads are waited for so that the data can be copied out to the caller.
+ *
+ * @iter is not advanced here.
+ */
+static ssize_t
+ll_direct_IO_bounce(const struct lu_env *env, struct cl_io *io, int rw,
+		    struct inode *inode, struct iov_iter *iter, size_t size,
+		    loff_t file_offset, struct ll_dio_aio *aio)
+{
+	struct ll_dio_bounce *ldb;
+	struct iov_iter i = *iter;
+	size_t offs = file_offset & ~PAGE_MASK;
+	size_t done;
+	size_t len;
+	ssize_t rc;
+	int n;
+	ENTRY;
+
+	size = min_t(size_t, size, PTLRPC_MAX_BRW_SIZE - offs);
+	ldb = ll_dio_bounce_alloc(DIV_ROUND_UP(offs + size, PAGE_SIZE));
+	if (IS_ERR(ldb))
+		RETURN(PTR_ERR(ldb));
+
+	if (rw == WRITE) {
+		for (n = 0, done = 0; done < size; n++, offs = 0) {
+			len = min_t(size_t, PAGE_SIZE - offs, size - done);
+			if (copy_page_from_iter(ldb->ldb_pages[n], offs, len,
+						&i) != len)
+				GOTO(out, rc = -EFAULT);
+			done += len;
+		}
+	} else {
+		aio = NULL;
+	}
+
+	rc = ll_direct_IO_seg(env, io, rw, inode, size, file_offset,
+			      ldb->ldb_pages, ldb->ldb_count, aio);
+	if (rc <= 0)
+		GOTO(out, rc);
+
+	if (aio != NULL) {
+		/* given back to the pool once the pages are transferred */
+		list_add_tail(&ldb->ldb_linkage, &aio->lda_bounces);
+		RETURN(rc);
+	}
+
+	if (rw == READ) {
+		offs = file_offset & ~PAGE_MASK;
+		for (n = 0, done = 0; done < (size_t)rc; n++, offs = 0) {
+			len = min_t(size_t, PAGE_SIZE - offs, rc - done);
+			if (copy_page_to_iter(ldb->ldb_pages[n], offs, len,
+					      &i) != len)
+				GOTO(out, rc = done ? : -EFAULT);
+			done += len;
+		}
+	}
+out:
+	ll_dio_bounce_free(ldb);
+	RETURN(rc);
+}
+
 static ssize_t
 ll_direct_IO(
 # ifndef HAVE_IOV_ITER_RW
@@ -334,18 +585,18 @@ ll_direct_IO(
 	struct ll_cl_context *lcc;
 	const struct lu_env *env;
 	struct cl_io *io;
+	struct vvp_io *vio;
+	struct ll_dio_aio *aio;
 	struct file *file = iocb->ki_filp;
 	struct inode *inode = file->f_mapping->host;
 	ssize_t count = iov_iter_count(iter);
 	ssize_t tot_bytes = 0, result = 0;
 	size_t size = MAX_DIO_SIZE;
+	bool unaligned;
 
 	/* Check EOF by ourselves */
 	if (iov_iter_rw(iter) == READ && file_offset >= i_size_read(inode))
 		return 0;
-	/* FIXME: io smaller than PAGE_SIZE is broken on ia64 ??? */
-	if ((file_offset & ~PAGE_MASK) || (count & ~PAGE_MASK))
-		return -EINVAL;
 
 	CDEBUG(D_VFSTRACE, "VFS Op:inode="DFID"(%p), size=%zd (max %lu), "
 	       "offset=%lld=%llx, pages %zd (max %lu)\n",
@@ -353,9 +604,10 @@ ll_direct_IO(
 	       file_offset, file_offset, count >> PAGE_SHIFT,
 	       MAX_DIO_SIZE >> PAGE_SHIFT);
 
-	/* Check that all user buffers are aligned as well */
-	if (iov_iter_alignment(iter) & ~PAGE_MASK)
-		return -EINVAL;
+	/* the file range and user buffers must all be page aligned to be
+	 * transferred in place */
+	unaligned = (file_offset & ~PAGE_MASK) || (count & ~PAGE_MASK) ||
+		    (iov_iter_alignment(iter) & ~PAGE_MASK);
 
 	lcc = ll_cl_find(file);
 	if (lcc == NULL)
@@ -365,6 +617,18 @@ ll_direct_IO(
 	LASSERT(!IS_ERR(env));
 	io = lcc->lcc_io;
 	LASSERT(io != NULL);
+	vio = vvp_env_io(env);
+
+	/* O_SYNC writes are flushed by generic_write_sync() once this returns,
+	 * so they have to be transferred by then */
+	aio = vio->vui_aio;
+	if (iov_iter_rw(iter) == WRITE &&
+	    (IS_SYNC(inode) || (file->f_flags & O_DSYNC)))
+		aio = NULL;
+#ifdef IOCB_DSYNC
+	if (iov_iter_rw(iter) == WRITE && (iocb->ki_flags & IOCB_DSYNC))
+		aio = NULL;
+#endif
 
 	/* 0. Need locking between buffered and direct access. and race with
 	 *    size changing by concurrent truncates and writes.
@@ -386,16 +650,43 @@ ll_direct_IO(
 				count = i_size_read(inode) - file_offset;
 		}
 
-		result = iov_iter_get_pages_alloc(iter, &pages, count, &offs);
-		if (likely(result > 0)) {
-			int n = DIV_ROUND_UP(result + offs, PAGE_SIZE);
-
-			result = ll_direct_IO_seg(env, io, iov_iter_rw(iter),
-						  inode, result, file_offset,
-						  pages, n);
-			ll_free_user_pages(pages, n,
-					   iov_iter_rw(iter) == READ);
-
+		if (unaligned) {
+			result = ll_direct_IO_bounce(env, io, iov_iter_rw(iter),
+						     inode, iter, count,
+						     file_offset, aio);
+		} else {
+			result = iov_iter_get_pages_alloc(iter, &pages, count,
+							  &offs);
+			if (likely(result > 0)) {
+				int n = DIV_ROUND_UP(result + offs, PAGE_SIZE);
+				bool dirty = iov_iter_rw(iter) == READ;
+				struct ll_dio_user_pages *ldu = NULL;
+
+				/* pages of an asynchronous I/O are still being
+				 * transferred when ll_direct_IO_seg() returns */
+				if (aio != NULL) {
+					OBD_ALLOC_PTR(ldu);
+					if (ldu == NULL) {
+						ll_free_user_pages(pages, n, 0);
+						GOTO(out, result = -ENOMEM);
+					}
+				}
+
+				result = ll_direct_IO_seg(env, io,
+							  iov_iter_rw(iter),
+							  inode, result,
+							  file_offset, pages,
+							  n, aio);
+				if (ldu != NULL) {
+					ldu->ldu_pages = pages;
+					ldu->ldu_count = n;
+					ldu->ldu_dirty = dirty;
+					list_add_tail(&ldu->ldu_linkage,
+						      &aio->lda_user_pages);
+				} else {
+					ll_free_user_pages(pages, n, dirty);
+				}
+			}
 		}
 		if (unlikely(result <= 0)) {
 			/* If we can't allocate a large enough buffer
@@ -425,8 +716,6 @@ out:
 		inode_unlock(inode);
 
 	if (tot_bytes > 0) {
-		struct vvp_io *vio = vvp_env_io(env);
-
 		/* no commit async for direct IO */
 		vio->u.write.vui_written += tot_bytes;
 	}
@@ -530,7 +819,8 @@ ll_direct_IO(int rw, struct kiocb *iocb, const struct iovec *iov,
 					bytes = page_count << PAGE_SHIFT;
 				result = ll_direct_IO_seg(env, io, rw, inode,
 							  bytes, file_offset,
-							  pages, page_count);
+							  pages, page_count,
+							  NULL);
                                 ll_free_user_pages(pages, max_pages, rw==READ);
                         } else if (page_count == 0) {
                                 GOTO(out, result = -EFAULT);
@@ -637,14 +927,58 @@ out:
 	return result;
 }
 
-static int ll_tiny_write_begin(struct page *vmpage)
+/*
+ * The page of a tiny write must be present, up to date and not in writeback.
+ * A dirty page is in the write-back cache under a write lock already. A clean
+ * one is queued there first, which needs a granted write lock covering it and
+ * grant, see cl_page_fast_write(). An append always checks the lock, it has
+ * to reach EOF so that the file size the append starts from can be trusted.
+ */
+static int ll_tiny_write_begin(struct file *file, struct page *vmpage,
+			       loff_t pos)
 {
-	/* Page must be present, up to date, dirty, and not in writeback. */
-	if (!vmpage || !PageUptodate(vmpage) || !PageDirty(vmpage) ||
-	    PageWriteback(vmpage))
+	struct inode *inode = file_inode(file);
+	struct cl_object *clob = ll_i2info(inode)->lli_clob;
+	bool append = file->f_flags & O_APPEND;
+	struct cl_page *page;
+	struct lu_env *env;
+	__u16 refcheck;
+	int rc = -ENODATA;
+
+	if (!vmpage || !PageUptodate(vmpage) || PageWriteback(vmpage))
+		return -ENODATA;
+
+	if (PageDirty(vmpage) && !append)
+		return 0;
+
+	if (clob == NULL)
 		return -ENODATA;
 
-	return 0;
+	env = cl_env_get(&refcheck);
+	if (IS_ERR(env))
+		return -ENODATA;
+
+	/* vmpage is locked, its cl_page can't go away */
+	page = cl_vmpage_page(vmpage, clob);
+	if (page == NULL)
+		goto out_env;
+
+	if (cl_page_fast_write(env, page, append) == 0) {
+		set_page_dirty(vmpage);
+		rc = 0;
+
+		if (append) {
+			ll_merge_attr(env, inode);
+			if (pos != i_size_read(inode))
+				rc = -ENODATA;
+		}
+	}
+	cl_page_put(env, page);
+
+out_env:
+	cl_env_put(env, &refcheck);
+
+	return rc;
 }
 
 static int ll_write_begin(struct file *file, struct address_space *mapping,
@@ -669,7 +1003,7 @@ static int ll_write_begin(struct file *file, struct address_space *mapping,
 	lcc = ll_cl_find(file);
 	if (lcc == NULL) {
 		vmpage = grab_cache_page_nowait(mapping, index);
-		result = ll_tiny_write_begin(vmpage);
+		result = ll_tiny_write_begin(file, vmpage, pos);
 		GOTO(out, result);
 	}
 
@@ -801,6 +1135,10 @@ static int ll_tiny_write_end(struct file *file, struct address_space *mapping,
 	 */
 	cl_page_touch(env, clpage, to);
 
+	/* An append starts from i_size, keep it up to date for the next one */
+	if (kms > i_size_read(mapping->host))
+		ll_merge_attr(env, mapping->host);
+
 out_env:
 	cl_env_put(env, &refcheck);
 
@@ -1102,8 +1102,13 @@ static int ll_statahead_thread(void *arg)
 
 			fid_le_to_cpu(&fid, &ent->lde_fid);
 
-			/* wait for spare statahead window */
+			/* wait for spare statahead window, the getattr
+			 * intents held back to be batched have to be sent
+			 * before waiting for their replies */
 			do {
+				if (sa_sent_full(sai))
+					md_batch_flush(ll_i2mdexp(dir));
+
 				l_wait_event(sa_thread->t_ctl_waitq,
 					     !sa_sent_full(sai) ||
 					     sa_has_callback(sai) ||
@@ -1133,6 +1138,7 @@ static int ll_statahead_thread(void *arg)
 
 			sa_statahead(parent, name, namelen, &fid);
 		}
+		md_batch_flush(ll_i2mdexp(dir));
 
 		pos = le64_to_cpu(dp->ldp_hash_end);
 		ll_release_page(dir, page,
@@ -1192,6 +1198,7 @@ out:
 
 	/* wait for inflight statahead RPCs to finish, and then we can free sai
 	 * safely because statahead RPC will access sai data */
+	md_batch_flush(ll_i2mdexp(dir));
 	while (sai->sai_sent != sai->sai_replied) {
 		/* in case we're not woken up, timeout wait */
 		lwi = LWI_TIMEOUT(msecs_to_jiffies(MSEC_PER_SEC >> 3),
@@ -56,6 +56,7 @@ static struct kmem_cache *ll_thread_kmem;
 struct kmem_cache *vvp_object_kmem;
 static struct kmem_cache *vvp_session_kmem;
 static struct kmem_cache *vvp_thread_kmem;
+struct kmem_cache *ll_dio_aio_kmem;
 
 static struct lu_kmem_descr vvp_caches[] = {
 	{
@@ -78,6 +79,11 @@ static struct lu_kmem_descr vvp_caches[] = {
 		.ckd_name  = "vvp_thread_kmem",
 		.ckd_size  = sizeof(struct vvp_thread_info),
 	},
+	{
+		.ckd_cache = &ll_dio_aio_kmem,
+		.ckd_name  = "ll_dio_aio_kmem",
+		.ckd_size  = sizeof(struct ll_dio_aio),
+	},
         {
                 .ckd_cache = NULL
         }
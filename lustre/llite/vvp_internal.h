@@ -117,12 +117,16 @@ struct vvp_io {
 	*/
 	struct ll_file_data	*vui_fd;
 	struct kiocb		*vui_iocb;
+	/* tracks the pages of a direct I/O until they are transferred */
+	struct ll_dio_aio	*vui_aio;
 
 	/* Readahead state. */
 	pgoff_t	vui_ra_start;
 	pgoff_t	vui_ra_count;
 	/* Set when vui_ra_{start,count} have been initialized. */
 	bool		vui_ra_valid;
+	/* Readahead stream of the file this read was assigned to. */
+	struct ll_readahead_state *vui_ras;
 };
 
 extern struct lu_device_type vvp_device_type;
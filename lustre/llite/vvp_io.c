@@ -37,7 +37,7 @@
 
 #define DEBUG_SUBSYSTEM S_LLITE
 
-
+#include <linux/falloc.h>
 #include <obd.h>
 #include "llite_internal.h"
 #include "vvp_internal.h"
@@ -367,8 +367,8 @@ static void vvp_io_fini(const struct lu_env *env, const struct cl_io_slice *ios)
 
 		io->ci_need_write_intent = 0;
 
-		LASSERT(io->ci_type == CIT_WRITE ||
-			cl_io_is_trunc(io) || cl_io_is_mkwrite(io));
+		LASSERT(io->ci_type == CIT_WRITE || cl_io_is_trunc(io) ||
+			cl_io_is_mkwrite(io) || io->ci_type == CIT_FALLOCATE);
 
 		CDEBUG(D_VFSTRACE, DFID" write layout, type %u "DEXT"\n",
 		       PFID(lu_object_fid(&obj->co_lu)), io->ci_type,
@@ -755,6 +755,51 @@ static void vvp_io_setattr_fini(const struct lu_env *env,
 	}
 }
 
+/**
+ * Implementation of cl_io_operations::cio_lock() method for CIT_FALLOCATE io.
+ *
+ * Takes a write lock over the preallocated range, so that cached pages and
+ * the known minimum size of the stripes are kept consistent with the OSTs.
+ */
+static int vvp_io_fallocate_lock(const struct lu_env *env,
+				 const struct cl_io_slice *ios)
+{
+	struct cl_io *io = ios->cis_io;
+	struct cl_fallocate_io *fio = &io->u.ci_fallocate;
+
+	return vvp_io_one_lock(env, io, 0, CLM_WRITE, fio->fa_start,
+			       fio->fa_end - 1);
+}
+
+static int vvp_io_fallocate_start(const struct lu_env *env,
+				  const struct cl_io_slice *ios)
+{
+	struct inode *inode = vvp_object_inode(ios->cis_obj);
+
+	inode_lock(inode);
+	inode_dio_wait(inode);
+
+	return 0;
+}
+
+static void vvp_io_fallocate_end(const struct lu_env *env,
+				 const struct cl_io_slice *ios)
+{
+	struct cl_io *io = ios->cis_io;
+	struct cl_fallocate_io *fio = &io->u.ci_fallocate;
+	struct inode *inode = vvp_object_inode(io->ci_obj);
+
+	/* the OST objects were extended, the stripe KMS has been updated
+	 * by osc already, only the size of the inode is left to do */
+	if (io->ci_result == 0 && !(fio->fa_mode & FALLOC_FL_KEEP_SIZE)) {
+		ll_inode_size_lock(inode);
+		if (fio->fa_end > i_size_read(inode))
+			i_size_write(inode, fio->fa_end);
+		ll_inode_size_unlock(inode);
+	}
+	inode_unlock(inode);
+}
+
 static int vvp_io_read_start(const struct lu_env *env,
 			     const struct cl_io_slice *ios)
 {
@@ -780,6 +825,11 @@ static int vvp_io_read_start(const struct lu_env *env,
 	if (vio->vui_io_subtype == IO_NORMAL)
 		down_read(&lli->lli_trunc_sem);
 
+	if (io->ci_async_readahead) {
+		file_accessed(file);
+		RETURN(0);
+	}
+
 	if (!can_populate_pages(env, io, inode))
 		RETURN(0);
 
@@ -803,7 +853,7 @@ static int vvp_io_read_start(const struct lu_env *env,
 		vio->vui_ra_valid = true;
 		vio->vui_ra_start = cl_index(obj, pos);
 		vio->vui_ra_count = cl_index(obj, tot + PAGE_SIZE - 1);
-		ll_ras_enter(file);
+		vio->vui_ras = ll_ras_enter(file, vio->vui_ra_start);
 	}
 
 	/* BUG: 5972 */
@@ -1439,6 +1489,12 @@ static const struct cl_io_operations vvp_io_ops = {
 		[CIT_LADVISE] = {
 			.cio_fini	= vvp_io_fini
 		},
+		[CIT_FALLOCATE] = {
+			.cio_fini	= vvp_io_fini,
+			.cio_lock	= vvp_io_fallocate_lock,
+			.cio_start	= vvp_io_fallocate_start,
+			.cio_end	= vvp_io_fallocate_end,
+		},
 	},
 	.cio_read_ahead = vvp_io_read_ahead
 };
@@ -1462,6 +1518,7 @@ int vvp_io_init(const struct lu_env *env, struct cl_object *obj,
 	CL_IO_SLICE_CLEAN(vio, vui_cl);
 	cl_io_slice_add(io, &vio->vui_cl, obj, &vvp_io_ops);
 	vio->vui_ra_valid = false;
+	vio->vui_ras = NULL;
 	result = 0;
 	if (io->ci_type == CIT_READ || io->ci_type == CIT_WRITE) {
 		size_t count;
@@ -1480,8 +1537,13 @@ int vvp_io_init(const struct lu_env *env, struct cl_object *obj,
 		 *
 		 * it's not accurate if the file is shared by different
 		 * jobs.
+		 *
+		 * Background readahead keeps the jobid of the reader which
+		 * queued it instead of the one of the readahead worker.
 		 */
-		lustre_get_jobid(lli->lli_jobid, sizeof(lli->lli_jobid));
+		if (!io->ci_async_readahead)
+			lustre_get_jobid(lli->lli_jobid,
+					 sizeof(lli->lli_jobid));
 	} else if (io->ci_type == CIT_SETATTR) {
 		if (!cl_io_is_trunc(io))
 			io->ci_lockreq = CILR_MANDATORY;
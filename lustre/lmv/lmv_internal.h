@@ -211,4 +211,8 @@ struct lmv_tgt_desc *lmv_locate_tgt(struct lmv_obd *lmv,
 /* lproc_lmv.c */
 int lmv_tunables_init(struct obd_device *obd);
 
+/* lmv_qos.c */
+void lmv_qos_init(struct lmv_obd *lmv);
+int lmv_qos_placement(struct lmv_obd *lmv, __u32 policy, u32 *mdt);
+
 #endif
@@ -69,6 +69,7 @@ static void lmv_activate_target(struct lmv_obd *lmv,
 
         tgt->ltd_active = activate;
         lmv->desc.ld_active_tgt_count += (activate ? 1 : -1);
+	lmv->lmv_qos.lq_dirty = true;
 
 	tgt->ltd_exp->exp_obd->obd_inactive = !activate;
 }
@@ -1174,7 +1175,9 @@ static int lmv_placement_policy(struct obd_device *obd,
 	/* Choose MDS by
 	 * 1. See if the stripe offset is specified by lum.
 	 * 2. Then check if there is default stripe offset.
-	 * 3. Finally choose MDS by name hash if the parent
+	 * 3. Then check if the default placement policy of the parent
+	 *    spreads subdirectories over MDTs (see lmv_qos_placement()).
+	 * 4. Finally choose MDS by name hash if the parent
 	 *    is striped directory. (see lmv_locate_tgt()). */
 	if (op_data->op_cli_flags & CLI_SET_MEA && lum != NULL &&
 	    le32_to_cpu(lum->lum_stripe_offset) != (__u32)-1) {
@@ -1185,6 +1188,12 @@ static int lmv_placement_policy(struct obd_device *obd,
 		/* Correct the stripe offset in lum */
 		if (lum != NULL)
 			lum->lum_stripe_offset = cpu_to_le32(*mds);
+	} else if (op_data->op_default_placement != LMV_PLACEMENT_PARENT &&
+		   !(op_data->op_cli_flags & CLI_SET_MEA) &&
+		   exp_connect_dir_placement(obd->obd_self_export) &&
+		   lmv_qos_placement(lmv, op_data->op_default_placement,
+				     mds) == 0) {
+		op_data->op_mds = *mds;
 	} else {
 		*mds = op_data->op_mds;
 	}
@@ -1286,6 +1295,7 @@ static int lmv_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 
 	spin_lock_init(&lmv->lmv_lock);
 	mutex_init(&lmv->lmv_init_mutex);
+	lmv_qos_init(lmv);
 
 	rc = lmv_tunables_init(obd);
 	if (rc)
@@ -3249,6 +3259,27 @@ int lmv_intent_getattr_async(struct obd_export *exp,
 	RETURN(rc);
 }
 
+static int lmv_batch_flush(struct obd_export *exp)
+{
+	struct lmv_obd *lmv = &exp->exp_obd->u.lmv;
+	__u32 i;
+	int rc = 0;
+	ENTRY;
+
+	for (i = 0; i < lmv->desc.ld_tgt_count; i++) {
+		int rc2;
+
+		if (lmv->tgts[i] == NULL || lmv->tgts[i]->ltd_exp == NULL)
+			continue;
+
+		rc2 = md_batch_flush(lmv->tgts[i]->ltd_exp);
+		if (rc2 != 0 && rc == 0)
+			rc = rc2;
+	}
+
+	RETURN(rc);
+}
+
 int lmv_revalidate_lock(struct obd_export *exp, struct lookup_intent *it,
                         struct lu_fid *fid, __u64 *bits)
 {
@@ -3423,6 +3454,7 @@ struct md_ops lmv_md_ops = {
         .m_set_open_replay_data = lmv_set_open_replay_data,
         .m_clear_open_replay_data = lmv_clear_open_replay_data,
         .m_intent_getattr_async = lmv_intent_getattr_async,
+	.m_batch_flush		= lmv_batch_flush,
 	.m_revalidate_lock      = lmv_revalidate_lock,
 	.m_get_fid_from_lsm	= lmv_get_fid_from_lsm,
 	.m_unpackmd		= lmv_unpackmd,
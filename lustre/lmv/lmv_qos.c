@@ -0,0 +1,417 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/lmv/lmv_qos.c
+ *
+ * MDT selection for new subdirectories whose parent default LMV asks for
+ * round-robin or space balanced placement.
+ *
+ * The space balanced allocator works like the OST QoS allocator of LOD, see
+ * lod_alloc_qos(): every MDT is weighted by its free space and free inodes,
+ * minus a penalty which is added each time the MDT is chosen and which decays
+ * over time, and the MDT is picked by weighted random selection. When all the
+ * MDTs have about the same space available, round-robin is used instead. The
+ * statfs data come from the MDC statfs cache and are refreshed at most every
+ * lq_maxage seconds.
+ */
+
+#define DEBUG_SUBSYSTEM S_LMV
+
+#include <linux/math64.h>
+
+#include <obd_support.h>
+#include <obd_class.h>
+#include <lustre_lmv.h>
+
+#include "lmv_internal.h"
+
+/* default statfs refresh interval, in seconds */
+#define LMV_QOS_MAXAGE		5
+
+#define QOS_DEBUG(fmt, ...)	CDEBUG(D_OTHER, fmt, ## __VA_ARGS__)
+
+void lmv_qos_init(struct lmv_obd *lmv)
+{
+	struct lmv_qos *qos = &lmv->lmv_qos;
+
+	spin_lock_init(&qos->lq_lock);
+	qos->lq_maxage = LMV_QOS_MAXAGE;
+	qos->lq_dirty = true;
+	qos->lq_reset = true;
+	/* Default priority is toward free space balance */
+	qos->lq_prio_free = 232;
+	/* Default threshold for rr (roughly 17%) */
+	qos->lq_threshold_rr = 43;
+}
+
+/**
+ * Availability of an MDT for new directories.
+ *
+ * Both free space and free inodes matter for an MDT, so the product of the
+ * two is used, in MiB and Kinodes to keep the penalty arithmetic of
+ * lmv_qos_calc_ppo() below 64 bits.
+ */
+static inline __u64 lmv_qos_tgt_avail(const struct obd_statfs *sfs)
+{
+	return ((sfs->os_bavail * sfs->os_bsize) >> 20) * (sfs->os_ffree >> 10);
+}
+
+static inline bool lmv_qos_tgt_usable(struct lmv_tgt_desc *tgt)
+{
+	return tgt != NULL && tgt->ltd_exp != NULL && tgt->ltd_active &&
+	       tgt->ltd_qos.ltq_usable;
+}
+
+/**
+ * Refresh the statfs data of all the MDTs.
+ *
+ * Only one thread refreshes the data every lq_maxage seconds, the others go
+ * on with the previous data meanwhile.
+ *
+ * \param[in] lmv	LMV device
+ */
+static void lmv_qos_statfs_update(struct lmv_obd *lmv)
+{
+	struct lmv_qos *qos = &lmv->lmv_qos;
+	struct obd_statfs *sfs;
+	time64_t now = ktime_get_seconds();
+	time64_t max_age = now - qos->lq_maxage;
+	__u32 i;
+	int rc;
+
+	spin_lock(&qos->lq_lock);
+	if (qos->lq_statfs_age > max_age) {
+		spin_unlock(&qos->lq_lock);
+		return;
+	}
+	qos->lq_statfs_age = now;
+	spin_unlock(&qos->lq_lock);
+
+	OBD_ALLOC_PTR(sfs);
+	if (sfs == NULL)
+		return;
+
+	for (i = 0; i < lmv->desc.ld_tgt_count; i++) {
+		struct lmv_tgt_desc *tgt = lmv->tgts[i];
+		__u64 avail = 0;
+
+		if (tgt == NULL || tgt->ltd_exp == NULL)
+			continue;
+
+		rc = obd_statfs(NULL, tgt->ltd_exp, sfs, max_age,
+				OBD_STATFS_NODELAY);
+		if (rc == 0 && !(sfs->os_state & OS_STATE_DEGRADED))
+			avail = lmv_qos_tgt_avail(sfs);
+
+		spin_lock(&qos->lq_lock);
+		if (tgt->ltd_qos.ltq_avail != avail ||
+		    tgt->ltd_qos.ltq_usable != (rc == 0))
+			qos->lq_dirty = true;
+		tgt->ltd_qos.ltq_avail = avail;
+		tgt->ltd_qos.ltq_usable = rc == 0;
+		spin_unlock(&qos->lq_lock);
+
+		QOS_DEBUG("MDT%04x: rc = %d, avail %llu\n",
+			  tgt->ltd_idx, rc, avail);
+	}
+
+	OBD_FREE_PTR(sfs);
+}
+
+/**
+ * Calculate per-MDT penalties
+ *
+ * Re-calculate penalties when the active targets change and after statfs
+ * refresh (all these are reflected by lq_dirty flag). On every MDT decay
+ * the penalty by half for every 8x the update interval that the device has
+ * been idle. See lod_qos_calc_ppo() for the details.
+ *
+ * \param[in] lmv	LMV device
+ *
+ * \retval 0		on success
+ * \retval -EAGAIN	not enough MDTs, or all of them have about the same
+ *			space available and round-robin should be used
+ */
+static int lmv_qos_calc_ppo(struct lmv_obd *lmv)
+{
+	struct lmv_qos *qos = &lmv->lmv_qos;
+	struct lmv_tgt_desc *tgt;
+	__u64 ba_max, ba_min, temp;
+	__u32 num_active = 0;
+	time64_t now, age;
+	int prio_wide;
+	__u32 i;
+
+	if (!qos->lq_dirty)
+		goto out;
+
+	for (i = 0; i < lmv->desc.ld_tgt_count; i++)
+		if (lmv_qos_tgt_usable(lmv->tgts[i]))
+			num_active++;
+	qos->lq_usable_count = num_active;
+	if (num_active < 2)
+		return -EAGAIN;
+	num_active--;
+
+	/*
+	 * How badly user wants to select MDTs "widely" (not recently chosen)
+	 * as opposed to "freely" (free space avail.) 0-256
+	 */
+	prio_wide = 256 - qos->lq_prio_free;
+
+	ba_min = (__u64)(-1);
+	ba_max = 0;
+	now = ktime_get_seconds();
+	for (i = 0; i < lmv->desc.ld_tgt_count; i++) {
+		tgt = lmv->tgts[i];
+		if (!lmv_qos_tgt_usable(tgt))
+			continue;
+
+		temp = tgt->ltd_qos.ltq_avail;
+		ba_min = min(temp, ba_min);
+		ba_max = max(temp, ba_max);
+
+		/* per-MDT penalty is prio * avail / (num_mdt - 1) / 2 */
+		temp >>= 1;
+		do_div(temp, num_active);
+		tgt->ltd_qos.ltq_penalty_per_obj = (temp * prio_wide) >> 8;
+
+		age = (now - tgt->ltd_qos.ltq_used) >> 3;
+		if (qos->lq_reset || age > 32 * qos->lq_maxage)
+			tgt->ltd_qos.ltq_penalty = 0;
+		else if (age > qos->lq_maxage)
+			/* Decay MDT penalty. */
+			tgt->ltd_qos.ltq_penalty >>= age / qos->lq_maxage;
+	}
+
+	qos->lq_dirty = false;
+	qos->lq_reset = false;
+
+	/* If each MDT has almost same free space,
+	 * do rr allocation for better creation performance */
+	qos->lq_same_space = false;
+	if ((ba_max >> 8) * (256 - qos->lq_threshold_rr) < ba_min) {
+		qos->lq_same_space = true;
+		/* Reset weights for the next time we enter qos mode */
+		qos->lq_reset = true;
+	}
+
+out:
+	return qos->lq_same_space ? -EAGAIN : 0;
+}
+
+/**
+ * Calculate weight for a given MDT, which is its availability minus its
+ * penalty.
+ */
+static void lmv_qos_calc_weight(struct lmv_tgt_desc *tgt)
+{
+	struct lmv_tgt_qos *ltq = &tgt->ltd_qos;
+
+	if (ltq->ltq_avail < ltq->ltq_penalty)
+		ltq->ltq_weight = 0;
+	else
+		ltq->ltq_weight = ltq->ltq_avail - ltq->ltq_penalty;
+}
+
+/**
+ * Re-calculate weights after a directory was placed on \a index.
+ *
+ * \param[in] lmv	LMV device
+ * \param[in] used	MDT target where a new directory was placed
+ * \param[out] total_wt	new total weight
+ */
+static void lmv_qos_used(struct lmv_obd *lmv, struct lmv_tgt_desc *used,
+			 __u64 *total_wt)
+{
+	struct lmv_tgt_qos *ltq = &used->ltd_qos;
+	struct lmv_tgt_desc *tgt;
+	__u32 i;
+
+	/* Decay old penalty by half (we're adding max penalty, and don't
+	 * want it to run away.) */
+	ltq->ltq_penalty >>= 1;
+	ltq->ltq_used = ktime_get_seconds();
+	ltq->ltq_penalty += ltq->ltq_penalty_per_obj *
+			    lmv->lmv_qos.lq_usable_count;
+
+	/* Decrease all MDT penalties */
+	*total_wt = 0;
+	for (i = 0; i < lmv->desc.ld_tgt_count; i++) {
+		tgt = lmv->tgts[i];
+		if (!lmv_qos_tgt_usable(tgt))
+			continue;
+
+		ltq = &tgt->ltd_qos;
+		if (ltq->ltq_penalty < ltq->ltq_penalty_per_obj)
+			ltq->ltq_penalty = 0;
+		else
+			ltq->ltq_penalty -= ltq->ltq_penalty_per_obj;
+
+		lmv_qos_calc_weight(tgt);
+		*total_wt += ltq->ltq_weight;
+
+		QOS_DEBUG("recalc tgt %d avail=%llu mdtppo=%llu mdtp=%llu "
+			  "wt=%llu\n", tgt->ltd_idx, ltq->ltq_avail,
+			  ltq->ltq_penalty_per_obj, ltq->ltq_penalty,
+			  ltq->ltq_weight);
+	}
+}
+
+/**
+ * Pick an MDT by weighted random selection.
+ *
+ * \param[in] lmv	LMV device
+ * \param[out] mdt	index of the MDT chosen
+ *
+ * \retval 0		on success
+ * \retval -EAGAIN	round-robin should be used instead
+ */
+static int lmv_alloc_qos(struct lmv_obd *lmv, u32 *mdt)
+{
+	struct lmv_qos *qos = &lmv->lmv_qos;
+	struct lmv_tgt_desc *tgt;
+	__u64 total_weight = 0;
+	__u64 cur_weight = 0;
+	__u64 rand;
+	__u32 i;
+	int rc;
+	ENTRY;
+
+	spin_lock(&qos->lq_lock);
+	rc = lmv_qos_calc_ppo(lmv);
+	if (rc)
+		GOTO(out, rc);
+
+	for (i = 0; i < lmv->desc.ld_tgt_count; i++) {
+		tgt = lmv->tgts[i];
+		if (!lmv_qos_tgt_usable(tgt))
+			continue;
+
+		lmv_qos_calc_weight(tgt);
+		total_weight += tgt->ltd_qos.ltq_weight;
+	}
+
+	if (total_weight) {
+#if BITS_PER_LONG == 32
+		/* If total_weight > 32-bit, first generate the high
+		 * 32 bits of the random number, then add in the low
+		 * 32 bits (truncated to the upper limit, if needed) */
+		if (total_weight > 0xffffffffULL)
+			rand = (__u64)(cfs_rand() %
+				(unsigned)(total_weight >> 32)) << 32;
+		else
+			rand = 0;
+
+		if (rand == (total_weight & 0xffffffff00000000ULL))
+			rand |= cfs_rand() % (unsigned)total_weight;
+		else
+			rand |= cfs_rand();
+#else
+		rand = ((__u64)cfs_rand() << 32 | cfs_rand()) % total_weight;
+#endif
+	} else {
+		rand = 0;
+	}
+
+	/* On average, this will hit larger-weighted MDTs more often.
+	 * 0-weight MDTs will only be used when rand=0 */
+	rc = -EAGAIN;
+	for (i = 0; i < lmv->desc.ld_tgt_count; i++) {
+		tgt = lmv->tgts[i];
+		if (!lmv_qos_tgt_usable(tgt))
+			continue;
+
+		cur_weight += tgt->ltd_qos.ltq_weight;
+		if (cur_weight < rand)
+			continue;
+
+		*mdt = tgt->ltd_idx;
+		lmv_qos_used(lmv, tgt, &total_weight);
+		rc = 0;
+		break;
+	}
+	EXIT;
+out:
+	spin_unlock(&qos->lq_lock);
+
+	return rc;
+}
+
+/**
+ * Pick the next active MDT in round-robin order.
+ */
+static int lmv_alloc_rr(struct lmv_obd *lmv, u32 *mdt)
+{
+	struct lmv_qos *qos = &lmv->lmv_qos;
+	struct lmv_tgt_desc *tgt;
+	__u32 count = lmv->desc.ld_tgt_count;
+	__u32 i;
+	int rc = -ENODEV;
+
+	if (count == 0)
+		return rc;
+
+	spin_lock(&qos->lq_lock);
+	for (i = 0; i < count; i++) {
+		tgt = lmv->tgts[(qos->lq_rr_index + i) % count];
+		if (tgt == NULL || tgt->ltd_exp == NULL || !tgt->ltd_active)
+			continue;
+
+		*mdt = tgt->ltd_idx;
+		qos->lq_rr_index = (qos->lq_rr_index + i + 1) % count;
+		rc = 0;
+		break;
+	}
+	spin_unlock(&qos->lq_lock);
+
+	return rc;
+}
+
+/**
+ * Choose the MDT of a new subdirectory by \a policy.
+ *
+ * \param[in] lmv	LMV device
+ * \param[in] policy	LMV_PLACEMENT_RR or LMV_PLACEMENT_SPACE
+ * \param[out] mdt	index of the MDT chosen
+ *
+ * \retval 0		on success
+ * \retval negative	if no MDT is available
+ */
+int lmv_qos_placement(struct lmv_obd *lmv, __u32 policy, u32 *mdt)
+{
+	int rc = -EAGAIN;
+
+	if (policy == LMV_PLACEMENT_SPACE) {
+		lmv_qos_statfs_update(lmv);
+		rc = lmv_alloc_qos(lmv, mdt);
+	}
+	if (rc == -EAGAIN)
+		rc = lmv_alloc_rr(lmv, mdt);
+	if (rc == 0)
+		CDEBUG(D_INODE, "placement %s: MDT%04x\n",
+		       policy == LMV_PLACEMENT_SPACE ? "space" : "rr", *mdt);
+
+	return rc;
+}
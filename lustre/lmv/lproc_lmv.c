@@ -75,6 +75,112 @@ static ssize_t desc_uuid_show(struct kobject *kobj, struct attribute *attr,
 }
 LUSTRE_RO_ATTR(desc_uuid);
 
+/* priority of MDT free space over MDT load for subdirectory placement */
+static ssize_t qos_prio_free_show(struct kobject *kobj, struct attribute *attr,
+				  char *buf)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct lmv_qos *qos = &dev->u.lmv.lmv_qos;
+
+	return sprintf(buf, "%u%%\n", (qos->lq_prio_free * 100 + 255) >> 8);
+}
+
+static ssize_t qos_prio_free_store(struct kobject *kobj, struct attribute *attr,
+				   const char *buffer, size_t count)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct lmv_qos *qos = &dev->u.lmv.lmv_qos;
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > 100)
+		return -EINVAL;
+
+	spin_lock(&qos->lq_lock);
+	qos->lq_prio_free = (val << 8) / 100;
+	qos->lq_dirty = true;
+	qos->lq_reset = true;
+	spin_unlock(&qos->lq_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(qos_prio_free);
+
+/* max free space difference between MDTs to still use round-robin */
+static ssize_t qos_threshold_rr_show(struct kobject *kobj,
+				     struct attribute *attr, char *buf)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct lmv_qos *qos = &dev->u.lmv.lmv_qos;
+
+	return sprintf(buf, "%u%%\n",
+		       (qos->lq_threshold_rr * 100 + 255) >> 8);
+}
+
+static ssize_t qos_threshold_rr_store(struct kobject *kobj,
+				      struct attribute *attr,
+				      const char *buffer, size_t count)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct lmv_qos *qos = &dev->u.lmv.lmv_qos;
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > 100)
+		return -EINVAL;
+
+	spin_lock(&qos->lq_lock);
+	qos->lq_threshold_rr = (val << 8) / 100;
+	qos->lq_dirty = true;
+	spin_unlock(&qos->lq_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(qos_threshold_rr);
+
+/* max age of the MDT statfs data used for subdirectory placement */
+static ssize_t qos_maxage_show(struct kobject *kobj, struct attribute *attr,
+			       char *buf)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+
+	return sprintf(buf, "%u Sec\n", dev->u.lmv.lmv_qos.lq_maxage);
+}
+
+static ssize_t qos_maxage_store(struct kobject *kobj, struct attribute *attr,
+				const char *buffer, size_t count)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val == 0)
+		return -EINVAL;
+
+	dev->u.lmv.lmv_qos.lq_maxage = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(qos_maxage);
+
 #ifdef CONFIG_PROC_FS
 static void *lmv_tgt_seq_start(struct seq_file *p, loff_t *pos)
 {
@@ -156,6 +262,9 @@ static struct attribute *lmv_attrs[] = {
 	&lustre_attr_activeobd.attr,
 	&lustre_attr_desc_uuid.attr,
 	&lustre_attr_numobd.attr,
+	&lustre_attr_qos_maxage.attr,
+	&lustre_attr_qos_prio_free.attr,
+	&lustre_attr_qos_threshold_rr.attr,
 	NULL,
 };
 
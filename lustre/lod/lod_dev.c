@@ -2137,6 +2137,18 @@ static int lod_obd_get_info(const struct lu_env *env, struct obd_export *exp,
 		lod_putref(d, &d->lod_mdt_descs);
 
 		RETURN(rc);
+	} else if (KEY_IS(KEY_TGT_COUNT)) {
+		struct obd_device *obd = exp->exp_obd;
+		struct lod_device *d;
+
+		if (!obd->obd_set_up || obd->obd_stopping)
+			RETURN(-EAGAIN);
+
+		/* all MDTs, including the local one */
+		d = lu2lod_dev(obd->obd_lu_dev);
+		*((int *)val) = d->lod_remote_mdt_count + 1;
+		*vallen = sizeof(int);
+		rc = 0;
 	}
 
 	RETURN(rc);
@@ -274,6 +274,8 @@ struct lod_default_striping {
 	__u32				lds_dir_def_stripe_count;
 	__u32				lds_dir_def_stripe_offset;
 	__u32				lds_dir_def_hash_type;
+	/* enum lmv_placement_policy */
+	__u32				lds_dir_def_placement;
 					/* default file striping flags (LOV) */
 	__u32				lds_def_striping_set:1,
 					lds_def_striping_is_composite:1,
@@ -320,6 +322,8 @@ struct lod_object {
 			__u32		ldo_dir_hash_type;
 			__u32		ldo_dir_migrate_offset;
 			__u32		ldo_dir_migrate_hash;
+			/* placement policy of the parent default LMV */
+			__u32		ldo_dir_placement;
 			/* Is a slave stripe of striped directory? */
 			__u32		ldo_dir_slave_stripe:1,
 					ldo_dir_striped:1,
@@ -1529,10 +1529,21 @@ static int lod_xattr_get(const struct lu_env *env, struct dt_object *dt,
 	RETURN(rc);
 }
 
+/*
+ * hash type 0 of a default LMV means the default hash type, which
+ * lod_ah_init() gives to new directories, otherwise it should be known to
+ * this server
+ */
+static inline bool lod_dir_hash_type_valid(__u32 hash_type)
+{
+	return (hash_type & LMV_HASH_TYPE_MASK) == LMV_HASH_TYPE_UNKNOWN ||
+	       lmv_is_known_hash_type(hash_type);
+}
+
 /**
  * Verify LVM EA.
  *
- * Checks that the magic of the stripe is sane.
+ * Checks that the magic and the hash type of the stripe are sane.
  *
  * \param[in] lod	lod device
  * \param[in] lum	a buffer storing LMV EA to verify
@@ -1552,6 +1563,14 @@ static int lod_verify_md_striping(struct lod_device *lod,
 		return -EINVAL;
 	}
 
+	if (unlikely(!lod_dir_hash_type_valid(
+				le32_to_cpu(lum->lum_hash_type)))) {
+		CERROR("%s: invalid lmv_user_md: hash_type = %#x: rc = %d\n",
+		       lod2obd(lod)->obd_name, le32_to_cpu(lum->lum_hash_type),
+		       -EINVAL);
+		return -EINVAL;
+	}
+
 	return 0;
 }
 
@@ -2089,6 +2108,13 @@ static int lod_declare_xattr_set_lmv(const struct lu_env *env,
 	if (lo->ldo_dir_stripe_count == 0)
 		GOTO(out, rc = 0);
 
+	if (!lod_dir_hash_type_valid(lo->ldo_dir_hash_type)) {
+		CERROR("%s: unsupported dir hash type %#x: rc = %d\n",
+		       lod2obd(lu2lod_dev(dt->do_lu.lo_dev))->obd_name,
+		       lo->ldo_dir_hash_type, -EINVAL);
+		GOTO(out, rc = -EINVAL);
+	}
+
 	/* prepare dir striped objects */
 	rc = lod_prep_md_striped_create(env, dt, attr, lum, dof, th);
 	if (rc != 0) {
@@ -3572,6 +3598,7 @@ static int lod_xattr_set_default_lmv_on_dir(const struct lu_env *env,
 
 	if (LMVEA_DELETE_VALUES((le32_to_cpu(lum->lum_stripe_count)),
 				 le32_to_cpu(lum->lum_stripe_offset)) &&
+	    le32_to_cpu(lum->lum_placement) == LMV_PLACEMENT_PARENT &&
 				le32_to_cpu(lum->lum_magic) == LMV_USER_MAGIC) {
 		rc = lod_xattr_del_internal(env, dt, name, th);
 		if (rc == -ENODATA)
@@ -3823,8 +3850,9 @@ static int lod_dir_striping_create_internal(const struct lu_env *env,
 
 	/* Transfer default LMV striping from the parent */
 	if (lds != NULL && lds->lds_dir_def_striping_set &&
-	    !LMVEA_DELETE_VALUES(lds->lds_dir_def_stripe_count,
-				 lds->lds_dir_def_stripe_offset)) {
+	    (!LMVEA_DELETE_VALUES(lds->lds_dir_def_stripe_count,
+				  lds->lds_dir_def_stripe_offset) ||
+	     lds->lds_dir_def_placement != LMV_PLACEMENT_PARENT)) {
 		struct lmv_user_md_v1 *v1 = info->lti_ea_store;
 
 		if (info->lti_ea_store_size < sizeof(*v1)) {
@@ -3842,6 +3870,8 @@ static int lod_dir_striping_create_internal(const struct lu_env *env,
 			cpu_to_le32(lds->lds_dir_def_stripe_offset);
 		v1->lum_hash_type =
 			cpu_to_le32(lds->lds_dir_def_hash_type);
+		v1->lum_placement =
+			cpu_to_le32(lds->lds_dir_def_placement);
 
 		info->lti_buf.lb_buf = v1;
 		info->lti_buf.lb_len = sizeof(*v1);
@@ -4560,6 +4590,9 @@ static int lod_get_default_lmv_striping(const struct lu_env *env,
 	lds->lds_dir_def_stripe_count = le32_to_cpu(v1->lum_stripe_count);
 	lds->lds_dir_def_stripe_offset = le32_to_cpu(v1->lum_stripe_offset);
 	lds->lds_dir_def_hash_type = le32_to_cpu(v1->lum_hash_type);
+	lds->lds_dir_def_placement = le32_to_cpu(v1->lum_placement);
+	if (lds->lds_dir_def_placement >= LMV_PLACEMENT_MAX)
+		lds->lds_dir_def_placement = LMV_PLACEMENT_PARENT;
 	lds->lds_dir_def_striping_set = 1;
 
 	RETURN(0);
@@ -4677,6 +4710,7 @@ static void lod_striping_from_default(struct lod_object *lo,
 				lds->lds_dir_def_stripe_offset;
 		if (lo->ldo_dir_hash_type == 0)
 			lo->ldo_dir_hash_type = lds->lds_dir_def_hash_type;
+		lo->ldo_dir_placement = lds->lds_dir_def_placement;
 
 		CDEBUG(D_LAYOUT, "striping from default dir: count:%hu, "
 		       "offset:%u, hash_type:%u\n",
@@ -4761,6 +4795,7 @@ static void lod_ah_init(const struct lu_env *env,
 
 		/* other default values are 0 */
 		lc->ldo_dir_stripe_offset = -1;
+		lc->ldo_dir_placement = LMV_PLACEMENT_PARENT;
 
 		/*
 		 * If parent object is not root directory,
@@ -4801,6 +4836,12 @@ static void lod_ah_init(const struct lu_env *env,
 				lc->ldo_dir_stripe_count = 0;
 		}
 
+		/* hash type 0 means default, no name could be created in a
+		 * striped directory with it */
+		if ((lc->ldo_dir_hash_type & LMV_HASH_TYPE_MASK) ==
+		    LMV_HASH_TYPE_UNKNOWN)
+			lc->ldo_dir_hash_type |= LMV_HASH_TYPE_FNV_1A_64;
+
 		/* shrink the stripe_count to the avaible MDT count */
 		if (lc->ldo_dir_stripe_count > d->lod_remote_mdt_count + 1 &&
 		    !OBD_FAIL_CHECK(OBD_FAIL_LARGE_STRIPE)) {
@@ -5130,9 +5171,13 @@ static int lod_declare_create(const struct lu_env *env, struct dt_object *dt,
 				GOTO(out, rc = -EREMOTE);
 
 			if (lo->ldo_dir_stripe_offset == -1) {
-				/* child and parent should be in the same MDT */
+				/* child and parent should be in the same MDT,
+				 * unless the client placed the child by the
+				 * policy of the parent default LMV */
 				if (hint->dah_parent != NULL &&
-				    dt_object_remote(hint->dah_parent))
+				    dt_object_remote(hint->dah_parent) &&
+				    lo->ldo_dir_placement ==
+				    LMV_PLACEMENT_PARENT)
 					GOTO(out, rc = -EREMOTE);
 			} else if (lo->ldo_dir_stripe_offset !=
 				   ss->ss_node_id) {
@@ -417,6 +417,19 @@ lsme_unpack_comp(struct lov_obd *lov, struct lov_mds_md *lmm,
 	}
 }
 
+/* Let the OSCs compress the bulk data of the objects of \a lsme */
+static void lsme_set_compress(struct lov_stripe_md_entry *lsme)
+{
+	unsigned int i;
+
+	if (!lsme_inited(lsme) || lsme_is_dom(lsme) ||
+	    lsme->lsme_pattern & LOV_PATTERN_F_RELEASED)
+		return;
+
+	for (i = 0; i < lsme->lsme_stripe_count; i++)
+		lsme->lsme_oinfo[i]->loi_compress = 1;
+}
+
 static struct lov_stripe_md *
 lsm_unpackmd_comp_md_v1(struct lov_obd *lov, void *buf, size_t buf_size)
 {
@@ -477,6 +490,8 @@ lsm_unpackmd_comp_md_v1(struct lov_obd *lov, void *buf, size_t buf_size)
 		if (lsme->lsme_flags & LCME_FL_NOSYNC)
 			lsme->lsme_timestamp =
 				le64_to_cpu(lcme->lcme_timestamp);
+		if (lsme->lsme_flags & LCME_FL_COMPRESS)
+			lsme_set_compress(lsme);
 		lu_extent_le_to_cpu(&lsme->lsme_extent, &lcme->lcme_extent);
 
 		if (i == entry_count - 1) {
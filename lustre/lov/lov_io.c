@@ -233,7 +233,7 @@ static int lov_io_mirror_write_intent(struct lov_io *lio,
 	io->ci_need_write_intent = 0;
 
 	if (!(io->ci_type == CIT_WRITE || cl_io_is_trunc(io) ||
-	      cl_io_is_mkwrite(io)))
+	      cl_io_is_mkwrite(io) || io->ci_type == CIT_FALLOCATE))
 		RETURN(0);
 
 	/*
@@ -529,6 +529,12 @@ static int lov_io_slice_init(struct lov_io *lio,
 		break;
 	}
 
+	case CIT_FALLOCATE: {
+		lio->lis_pos = io->u.ci_fallocate.fa_start;
+		lio->lis_endpos = io->u.ci_fallocate.fa_end;
+		break;
+	}
+
 	case CIT_GLIMPSE:
 		lio->lis_pos = 0;
 		lio->lis_endpos = OBD_OBJECT_EOF;
@@ -700,6 +706,13 @@ static void lov_io_sub_inherit(struct lov_io_sub *sub, struct lov_io *lio,
 		io->u.ci_ladvise.li_flags = parent->u.ci_ladvise.li_flags;
 		break;
 	}
+	case CIT_FALLOCATE: {
+		io->u.ci_fallocate.fa_start = start;
+		io->u.ci_fallocate.fa_end = end;
+		io->u.ci_fallocate.fa_fid = parent->u.ci_fallocate.fa_fid;
+		io->u.ci_fallocate.fa_mode = parent->u.ci_fallocate.fa_mode;
+		break;
+	}
 	case CIT_GLIMPSE:
 	case CIT_MISC:
 	default:
@@ -1332,6 +1345,15 @@ static const struct cl_io_operations lov_io_ops = {
 			.cio_start     = lov_io_start,
 			.cio_end       = lov_io_end
 		},
+		[CIT_FALLOCATE] = {
+			.cio_fini      = lov_io_fini,
+			.cio_iter_init = lov_io_iter_init,
+			.cio_iter_fini = lov_io_iter_fini,
+			.cio_lock      = lov_io_lock,
+			.cio_unlock    = lov_io_unlock,
+			.cio_start     = lov_io_start,
+			.cio_end       = lov_io_end
+		},
 		[CIT_GLIMPSE] = {
 			.cio_fini      = lov_io_fini,
 		},
@@ -1417,6 +1439,13 @@ static const struct cl_io_operations lov_empty_io_ops = {
 		[CIT_LADVISE] = {
 			.cio_fini   = lov_empty_io_fini
 		},
+		[CIT_FALLOCATE] = {
+			.cio_fini      = lov_empty_io_fini,
+			.cio_iter_init = LOV_EMPTY_IMPOSSIBLE,
+			.cio_lock      = LOV_EMPTY_IMPOSSIBLE,
+			.cio_start     = LOV_EMPTY_IMPOSSIBLE,
+			.cio_end       = LOV_EMPTY_IMPOSSIBLE
+		},
 		[CIT_GLIMPSE] = {
 			.cio_fini      = lov_empty_io_fini
 		},
@@ -1477,6 +1506,7 @@ int lov_io_init_empty(const struct lu_env *env, struct cl_object *obj,
 		result = +1;
 		break;
 	case CIT_WRITE:
+	case CIT_FALLOCATE:
 		result = -EBADF;
 		break;
 	case CIT_FAULT:
@@ -1533,6 +1563,7 @@ int lov_io_init_released(const struct lu_env *env, struct cl_object *obj,
 	case CIT_READ:
 	case CIT_WRITE:
 	case CIT_FAULT:
+	case CIT_FALLOCATE:
 		io->ci_restore_needed = 1;
 		result = -ENODATA;
 		break;
@@ -60,8 +60,36 @@ static int lov_comp_page_print(const struct lu_env *env,
 			  lp, lp->lps_index, lp->lps_layout_gen);
 }
 
+/**
+ * A fast write skips the mirror handling and the layout checks of lov_io, so
+ * it is only allowed when the page still belongs to the current layout and
+ * the file is not mirrored. Data on MDT is left to the full IO, its pages are
+ * covered by IBITS locks. An append also needs the file size to be decided
+ * by the lock on this very stripe, that is, a plain file with one stripe.
+ */
+static int lov_comp_page_fast_write(const struct lu_env *env,
+				    const struct cl_page_slice *slice,
+				    bool append)
+{
+	struct lov_object *loo = cl2lov(slice->cpl_obj);
+	struct lov_page *lp = cl2lov_page(slice);
+	struct lov_stripe_md *lsm = loo->lo_lsm;
+
+	if (lsm == NULL || lp->lps_layout_gen != lsm->lsm_layout_gen ||
+	    lov_is_flr(loo) ||
+	    lsme_is_dom(lsm->lsm_entries[lov_comp_entry(lp->lps_index)]))
+		return -ENODATA;
+
+	if (append && (lsm->lsm_entry_count != 1 ||
+		       lsm->lsm_entries[0]->lsme_stripe_count != 1))
+		return -ENODATA;
+
+	return 0;
+}
+
 static const struct cl_page_operations lov_comp_page_ops = {
-	.cpo_print = lov_comp_page_print
+	.cpo_print	= lov_comp_page_print,
+	.cpo_fast_write	= lov_comp_page_fast_write
 };
 
 int lov_page_init_composite(const struct lu_env *env, struct cl_object *obj,
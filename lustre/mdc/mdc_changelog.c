@@ -83,12 +83,22 @@ struct chlg_reader_state {
 	wait_queue_head_t	 crs_waitq_prod;
 	/* Wait queue for the record copy threads */
 	wait_queue_head_t	 crs_waitq_cons;
-	/* Mutex protecting crs_rec_count and crs_rec_queue */
+	/* Mutex protecting crs_rec_count, crs_rec_queue, crs_filter,
+	 * crs_filtered and crs_llh */
 	struct mutex		 crs_lock;
 	/* Number of item in the list */
 	__u64			 crs_rec_count;
 	/* List of prefetched enqueued_record::enq_linkage_items */
 	struct list_head	 crs_rec_queue;
+	/* Records not matching this filter are skipped by the MDT if it
+	 * supports it, and by the catalog processing callback. A zeroed
+	 * filter lets every record through. */
+	struct llogd_chlg_filter crs_filter;
+	/* Some records may have been skipped by the filter, it can only be
+	 * narrowed */
+	bool			 crs_filtered;
+	/* Catalog handle of the producer thread, while it runs */
+	struct llog_handle	*crs_llh;
 };
 
 struct chlg_rec_entry {
@@ -125,6 +135,7 @@ static int chlg_read_cat_process_cb(const struct lu_env *env,
 	struct chlg_reader_state *crs = data;
 	struct chlg_rec_entry *enq;
 	size_t len;
+	bool match;
 	int rc;
 	ENTRY;
 
@@ -133,6 +144,10 @@ static int chlg_read_cat_process_cb(const struct lu_env *env,
 
 	rec = container_of(hdr, struct llog_changelog_rec, cr_hdr);
 
+	/* records skipped by the MDT filter, see llogd_chlg_filter */
+	if (rec->cr_hdr.lrh_type == LLOG_PAD_MAGIC)
+		RETURN(0);
+
 	if (rec->cr_hdr.lrh_type != CHANGELOG_REC) {
 		rc = -EINVAL;
 		CERROR("%s: not a changelog rec %x/%d in llog "DFID" rc = %d\n",
@@ -146,6 +161,14 @@ static int chlg_read_cat_process_cb(const struct lu_env *env,
 	if (rec->cr.cr_index < crs->crs_start_offset)
 		RETURN(0);
 
+	mutex_lock(&crs->crs_lock);
+	match = llog_chlg_filter_match(&crs->crs_filter, &rec->cr);
+	if (!match)
+		crs->crs_filtered = true;
+	mutex_unlock(&crs->crs_lock);
+	if (!match)
+		RETURN(0);
+
 	CDEBUG(D_HSM, "%llu %02d%-5s %llu 0x%x t="DFID" p="DFID" %.*s\n",
 	       rec->cr.cr_index, rec->cr.cr_type,
 	       changelog_type2str(rec->cr.cr_type), rec->cr.cr_time,
@@ -231,6 +254,14 @@ static int chlg_load(void *args)
 		GOTO(err_out, rc);
 	}
 
+	/* let the MDT skip the records which do not match the filter */
+	mutex_lock(&crs->crs_lock);
+	crs->crs_llh = llh;
+	llog_cat_chlg_filter_set(llh, &crs->crs_filter);
+	if (!llog_chlg_filter_empty(&crs->crs_filter))
+		crs->crs_filtered = true;
+	mutex_unlock(&crs->crs_lock);
+
 	rc = llog_cat_process(NULL, llh, chlg_read_cat_process_cb, crs, 0, 0);
 	if (rc < 0) {
 		CERROR("%s: fail to process llog: rc = %d\n", obd->obd_name, rc);
@@ -245,8 +276,12 @@ err_out:
 
 	wake_up_all(&crs->crs_waitq_cons);
 
-	if (llh != NULL)
+	if (llh != NULL) {
+		mutex_lock(&crs->crs_lock);
+		crs->crs_llh = NULL;
+		mutex_unlock(&crs->crs_lock);
 		llog_cat_close(NULL, llh);
+	}
 
 	if (ctx != NULL)
 		llog_ctxt_put(ctx);
@@ -419,6 +454,99 @@ static int chlg_clear(struct chlg_reader_state *crs, __u32 reader, __u64 record)
 				  KEY_CHANGELOG_CLEAR, sizeof(cs), &cs, NULL);
 }
 
+/**
+ * Check whether filter \a new only lets through records which \a old lets
+ * through.
+ */
+static bool chlg_filter_narrows(const struct llogd_chlg_filter *old,
+				const struct llogd_chlg_filter *new)
+{
+	if (old->lcf_type_mask != 0 &&
+	    (new->lcf_type_mask == 0 ||
+	     new->lcf_type_mask & ~old->lcf_type_mask))
+		return false;
+
+	if (old->lcf_flags & LCF_UID &&
+	    (!(new->lcf_flags & LCF_UID) || new->lcf_uid != old->lcf_uid))
+		return false;
+
+	if (!fid_is_zero(&old->lcf_fid) &&
+	    !lu_fid_eq(&new->lcf_fid, &old->lcf_fid))
+		return false;
+
+	return true;
+}
+
+/**
+ * Update the record filter of a changelog reader. Records already prefetched
+ * which do not match the new filter are dropped.
+ *
+ * The catalog is only walked once, so the records which have been skipped by
+ * the filter cannot be delivered anymore. Once this may have happened, the
+ * filter can only be narrowed. The MDT gets the new filter with its next
+ * request for records.
+ *
+ * @param[in,out]  crs  Internal reader state.
+ * @param[in]      cmd  Filter command, without the "filter:" prefix.
+ * @return 0 on success, -EBUSY if the filter would be widened after records
+ *	   were skipped, other negated error code on failure.
+ */
+static int chlg_set_filter(struct chlg_reader_state *crs, const char *cmd)
+{
+	struct llogd_chlg_filter *cf = &crs->crs_filter;
+	struct llogd_chlg_filter new;
+	struct chlg_rec_entry *rec;
+	struct chlg_rec_entry *tmp;
+	struct lu_fid fid;
+	__u32 val;
+	int rc = 0;
+
+	mutex_lock(&crs->crs_lock);
+	new = *cf;
+	if (strcmp(cmd, "clear") == 0 || strcmp(cmd, "clear\n") == 0) {
+		memset(&new, 0, sizeof(new));
+	} else if (sscanf(cmd, "mask:%x", &val) == 1) {
+		new.lcf_type_mask = val;
+	} else if (sscanf(cmd, "uid:%u", &val) == 1) {
+		new.lcf_flags |= LCF_UID;
+		new.lcf_uid = val;
+	} else if (sscanf(cmd, "fid:"SFID, RFID(&fid)) == 3) {
+		new.lcf_fid = fid;
+	} else {
+		rc = -EINVAL;
+	}
+
+	if (rc == 0 && crs->crs_filtered && !chlg_filter_narrows(cf, &new))
+		rc = -EBUSY;
+
+	if (rc == 0) {
+		*cf = new;
+		if (crs->crs_llh != NULL) {
+			llog_cat_chlg_filter_set(crs->crs_llh, cf);
+			if (!llog_chlg_filter_empty(cf))
+				crs->crs_filtered = true;
+		}
+		list_for_each_entry_safe(rec, tmp, &crs->crs_rec_queue,
+					 enq_linkage) {
+			if (llog_chlg_filter_match(cf, rec->enq_record))
+				continue;
+
+			crs->crs_filtered = true;
+			crs->crs_rec_count--;
+			enq_record_delete(rec);
+		}
+	}
+	mutex_unlock(&crs->crs_lock);
+
+	if (rc == 0) {
+		CDEBUG(D_HSM, "%s: changelog filter '%s'\n",
+		       crs->crs_obd->obd_name, cmd);
+		wake_up_all(&crs->crs_waitq_prod);
+	}
+
+	return rc;
+}
+
 /** Maximum changelog control command size */
 #define CHLG_CONTROL_CMD_MAX	64
 
@@ -456,6 +584,8 @@ static ssize_t chlg_write(struct file *file, const char __user *buff,
 
 	if (sscanf(kbuf, "clear:cl%u:%llu", &reader, &record) == 2)
 		rc = chlg_clear(crs, reader, record);
+	else if (strncmp(kbuf, "filter:", 7) == 0)
+		rc = chlg_set_filter(crs, kbuf + 7);
 	else
 		rc = -EINVAL;
 
@@ -1103,6 +1103,14 @@ static int mdc_io_read_ahead(const struct lu_env *env,
 	RETURN(0);
 }
 
+/* the MDT has no OST_FALLOCATE handler, preallocation of the Data-on-MDT
+ * component is not supported */
+static int mdc_io_fallocate_start(const struct lu_env *env,
+				  const struct cl_io_slice *slice)
+{
+	return -EOPNOTSUPP;
+}
+
 int mdc_io_fsync_start(const struct lu_env *env,
 		       const struct cl_io_slice *slice)
 {
@@ -1292,6 +1300,9 @@ static struct cl_io_operations mdc_io_ops = {
 			.cio_start = mdc_io_fsync_start,
 			.cio_end   = osc_io_fsync_end,
 		},
+		[CIT_FALLOCATE] = {
+			.cio_start = mdc_io_fallocate_start,
+		},
 	},
 	.cio_read_ahead   = mdc_io_read_ahead,
 	.cio_submit	  = osc_io_submit,
@@ -1229,17 +1229,14 @@ int mdc_intent_lock(struct obd_export *exp, struct md_op_data *op_data,
         RETURN(rc);
 }
 
-static int mdc_intent_getattr_async_interpret(const struct lu_env *env,
-					      struct ptlrpc_request *req,
-					      void *args, int rc)
+static int mdc_intent_getattr_async_fini(struct ptlrpc_request *req,
+					 struct mdc_getattr_args *ga, int rc)
 {
-	struct mdc_getattr_args  *ga = args;
 	struct obd_export *exp = ga->ga_exp;
 	struct md_enqueue_info *minfo = ga->ga_minfo;
 	struct ldlm_enqueue_info *einfo = &minfo->mi_einfo;
 	struct lookup_intent *it;
 	struct lustre_handle *lockh;
-	struct obd_device *obddev;
 	struct ldlm_reply *lockrep;
 	__u64 flags = LDLM_FL_HAS_INTENT;
 	ENTRY;
@@ -1247,9 +1244,6 @@ static int mdc_intent_getattr_async_interpret(const struct lu_env *env,
         it    = &minfo->mi_it;
         lockh = &minfo->mi_lockh;
 
-        obddev = class_exp2obd(exp);
-
-	obd_put_request_slot(&obddev->u.cli);
         if (OBD_FAIL_CHECK(OBD_FAIL_MDC_GETATTR_ENQUEUE))
                 rc = -ETIMEDOUT;
 
@@ -1279,6 +1273,213 @@ out:
         return 0;
 }
 
+static int mdc_intent_getattr_async_interpret(const struct lu_env *env,
+					      struct ptlrpc_request *req,
+					      void *args, int rc)
+{
+	struct mdc_getattr_args *ga = args;
+
+	obd_put_request_slot(&class_exp2obd(ga->ga_exp)->u.cli);
+
+	return mdc_intent_getattr_async_fini(req, ga, rc);
+}
+
+/* maximum number of getattr intents sent in one MDS_BATCH RPC */
+#define MDC_BATCH_MAX_COUNT	32
+/* maximum size of the getattr intents of one MDS_BATCH RPC, well below the
+ * size of the MDT request buffers */
+#define MDC_BATCH_MAX_SIZE	(MDS_REG_MAXREQSIZE / 2)
+
+struct mdc_batch_args {
+	struct obd_export	*ba_exp;
+	struct list_head	 ba_reqs;
+};
+
+/*
+ * Complete the getattr intents of a MDS_BATCH RPC from their replies, as
+ * mdc_intent_getattr_async_interpret() does for a single one.
+ */
+static int mdc_batch_interpret(const struct lu_env *env,
+			       struct ptlrpc_request *req, void *args, int rc)
+{
+	struct mdc_batch_args *ba = args;
+	struct batch_update_header *buh;
+	struct ptlrpc_request *sub;
+	struct ptlrpc_request *tmp;
+	char *ptr = NULL;
+	char *end = NULL;
+	ENTRY;
+
+	obd_put_request_slot(&class_exp2obd(ba->ba_exp)->u.cli);
+
+	if (rc == 0) {
+		buh = req_capsule_server_get(&req->rq_pill,
+					     &RMF_BATCH_UPDATE_REPLY);
+		if (buh == NULL || buh->buh_magic != BATCH_UPDATE_REPLY_MAGIC) {
+			rc = -EPROTO;
+		} else {
+			ptr = (char *)(buh + 1);
+			end = (char *)buh +
+			      req_capsule_get_size(&req->rq_pill,
+						   &RMF_BATCH_UPDATE_REPLY,
+						   RCL_SERVER);
+		}
+	}
+
+	list_for_each_entry_safe(sub, tmp, &ba->ba_reqs, rq_list) {
+		struct batch_update_buffer *bub;
+		int sub_rc = rc;
+
+		list_del_init(&sub->rq_list);
+
+		bub = (struct batch_update_buffer *)ptr;
+		if (rc == 0 && ptr + sizeof(*bub) > end)
+			sub_rc = rc = -EPROTO;
+		if (rc == 0) {
+			if (ptlrpc_rep_need_swab(req))
+				lustre_swab_batch_update_buffer(bub);
+			if (bub->bub_size > end - ptr - sizeof(*bub))
+				sub_rc = rc = -EPROTO;
+		}
+		if (rc == 0) {
+			sub_rc = bub->bub_rc;
+			if (sub_rc == 0)
+				sub_rc = ptlrpc_sub_req_reply(sub,
+					(struct lustre_msg *)(bub + 1),
+					bub->bub_size);
+			ptr += cfs_size_round(sizeof(*bub) + bub->bub_size);
+		}
+
+		sub->rq_status = sub_rc;
+		mdc_intent_getattr_async_fini(sub, ptlrpc_req_async_args(sub),
+					      sub_rc);
+		ptlrpc_req_finished(sub);
+	}
+
+	if (rc != 0)
+		CDEBUG(D_HA, "%s: batched getattr failed: rc = %d\n",
+		       class_exp2obd(ba->ba_exp)->obd_name, rc);
+
+	RETURN(0);
+}
+
+/**
+ * Send the getattr intents queued by mdc_batch_add() in one MDS_BATCH RPC.
+ * The reply of each of them is processed as if it had been sent on its own.
+ */
+int mdc_batch_flush(struct obd_export *exp)
+{
+	struct client_obd *cli = &exp->exp_obd->u.cli;
+	struct list_head reqs = LIST_HEAD_INIT(reqs);
+	struct batch_update_header *buh;
+	struct batch_update_buffer *bub;
+	struct mdc_batch_args *ba;
+	struct ptlrpc_request *req;
+	struct ptlrpc_request *sub;
+	struct ptlrpc_request *tmp;
+	__u32 reply_size;
+	__u32 count;
+	__u32 size;
+	char *ptr;
+	int rc;
+	ENTRY;
+
+	spin_lock(&cli->cl_batch_lock);
+	list_splice_init(&cli->cl_batch_list, &reqs);
+	count = cli->cl_batch_count;
+	size = cli->cl_batch_size;
+	cli->cl_batch_count = 0;
+	cli->cl_batch_size = 0;
+	spin_unlock(&cli->cl_batch_lock);
+
+	if (count == 0)
+		RETURN(0);
+
+	req = ptlrpc_request_alloc(class_exp2cliimp(exp), &RQF_MDS_BATCH);
+	if (req == NULL)
+		GOTO(out, rc = -ENOMEM);
+
+	req_capsule_set_size(&req->rq_pill, &RMF_BATCH_UPDATE_REQUEST,
+			     RCL_CLIENT, sizeof(*buh) + size);
+	rc = ptlrpc_request_pack(req, LUSTRE_MDS_VERSION, MDS_BATCH);
+	if (rc) {
+		ptlrpc_request_free(req);
+		GOTO(out, rc);
+	}
+
+	buh = req_capsule_client_get(&req->rq_pill, &RMF_BATCH_UPDATE_REQUEST);
+	buh->buh_magic = BATCH_UPDATE_REQUEST_MAGIC;
+	buh->buh_count = count;
+	buh->buh_padding = 0;
+
+	reply_size = sizeof(*buh);
+	ptr = (char *)(buh + 1);
+	list_for_each_entry(sub, &reqs, rq_list) {
+		bub = (struct batch_update_buffer *)ptr;
+		bub->bub_size = sub->rq_reqlen;
+		bub->bub_rc = 0;
+		memcpy(bub + 1, sub->rq_reqmsg, sub->rq_reqlen);
+		ptr += cfs_size_round(sizeof(*bub) + sub->rq_reqlen);
+		reply_size += cfs_size_round(sizeof(*bub) + sub->rq_replen);
+	}
+	buh->buh_reply_size = reply_size;
+
+	req_capsule_set_size(&req->rq_pill, &RMF_BATCH_UPDATE_REPLY,
+			     RCL_SERVER, reply_size);
+	ptlrpc_request_set_replen(req);
+
+	rc = obd_get_request_slot(cli);
+	if (rc != 0) {
+		ptlrpc_req_finished(req);
+		GOTO(out, rc);
+	}
+
+	CLASSERT(sizeof(*ba) <= sizeof(req->rq_async_args));
+	ba = ptlrpc_req_async_args(req);
+	ba->ba_exp = exp;
+	INIT_LIST_HEAD(&ba->ba_reqs);
+	list_splice_init(&reqs, &ba->ba_reqs);
+
+	req->rq_interpret_reply = mdc_batch_interpret;
+	ptlrpcd_add_req(req);
+
+	RETURN(0);
+out:
+	list_for_each_entry_safe(sub, tmp, &reqs, rq_list) {
+		list_del_init(&sub->rq_list);
+		mdc_intent_getattr_async_fini(sub, ptlrpc_req_async_args(sub),
+					      rc);
+		ptlrpc_req_finished(sub);
+	}
+	RETURN(rc);
+}
+
+/*
+ * Queue the getattr intent \a req to be sent in a MDS_BATCH RPC along with
+ * the next ones. The batch is sent once full, or by mdc_batch_flush() when
+ * the caller is about to wait for the replies.
+ */
+static void mdc_batch_add(struct obd_export *exp, struct ptlrpc_request *req)
+{
+	struct client_obd *cli = &exp->exp_obd->u.cli;
+	bool full;
+
+	ptlrpc_sub_req_prep(req);
+
+	spin_lock(&cli->cl_batch_lock);
+	list_add_tail(&req->rq_list, &cli->cl_batch_list);
+	cli->cl_batch_count++;
+	cli->cl_batch_size += cfs_size_round(sizeof(struct batch_update_buffer) +
+					     req->rq_reqlen);
+	/* a getattr intent is never larger than MDS_MAXREQSIZE */
+	full = cli->cl_batch_count >= MDC_BATCH_MAX_COUNT ||
+	       cli->cl_batch_size + MDS_MAXREQSIZE > MDC_BATCH_MAX_SIZE;
+	spin_unlock(&cli->cl_batch_lock);
+
+	if (full)
+		mdc_batch_flush(exp);
+}
+
 int mdc_intent_getattr_async(struct obd_export *exp,
 			     struct md_enqueue_info *minfo)
 {
@@ -1291,6 +1492,7 @@ int mdc_intent_getattr_async(struct obd_export *exp,
 	union ldlm_policy_data policy = {
 				.l_inodebits = { MDS_INODELOCK_LOOKUP |
 						 MDS_INODELOCK_UPDATE } };
+	bool			 batch = exp_connect_batch_rpc(exp);
 	int			 rc = 0;
 	__u64			 flags = LDLM_FL_HAS_INTENT;
 	ENTRY;
@@ -1307,10 +1509,13 @@ int mdc_intent_getattr_async(struct obd_export *exp,
 	if (IS_ERR(req))
 		RETURN(PTR_ERR(req));
 
-	rc = obd_get_request_slot(&obddev->u.cli);
-	if (rc != 0) {
-		ptlrpc_req_finished(req);
-		RETURN(rc);
+	/* batched getattr intents share the request slot of their batch */
+	if (!batch) {
+		rc = obd_get_request_slot(&obddev->u.cli);
+		if (rc != 0) {
+			ptlrpc_req_finished(req);
+			RETURN(rc);
+		}
 	}
 
 	/* With Data-on-MDT the glimpse callback is needed too.
@@ -1323,7 +1528,8 @@ int mdc_intent_getattr_async(struct obd_export *exp,
 	rc = ldlm_cli_enqueue(exp, &req, &minfo->mi_einfo, &res_id, &policy,
 			      &flags, NULL, 0, LVB_T_NONE, &minfo->mi_lockh, 1);
 	if (rc < 0) {
-		obd_put_request_slot(&obddev->u.cli);
+		if (!batch)
+			obd_put_request_slot(&obddev->u.cli);
 		ptlrpc_req_finished(req);
 		RETURN(rc);
 	}
@@ -1333,6 +1539,11 @@ int mdc_intent_getattr_async(struct obd_export *exp,
 	ga->ga_exp = exp;
 	ga->ga_minfo = minfo;
 
+	if (batch) {
+		mdc_batch_add(exp, req);
+		RETURN(0);
+	}
+
 	req->rq_interpret_reply = mdc_intent_getattr_async_interpret;
 	ptlrpcd_add_req(req);
 
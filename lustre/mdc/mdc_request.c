@@ -2526,9 +2526,9 @@ static int mdc_import_event(struct obd_device *obd, struct obd_import *imp,
 			 */
 			osc_io_unplug(env, cli, NULL);
 
-			cfs_hash_for_each_nolock(ns->ns_rs_hash,
-						 osc_ldlm_resource_invalidate,
-						 env, 0);
+			ldlm_namespace_res_foreach(ns,
+						osc_ldlm_resource_invalidate,
+						env);
 			cl_env_put(env, &refcheck);
 			ldlm_namespace_cleanup(ns, LDLM_FL_LOCAL_ONLY);
 		} else {
@@ -2801,6 +2801,7 @@ static struct md_ops mdc_md_ops = {
         .m_set_open_replay_data = mdc_set_open_replay_data,
         .m_clear_open_replay_data = mdc_clear_open_replay_data,
         .m_intent_getattr_async = mdc_intent_getattr_async,
+	.m_batch_flush		= mdc_batch_flush,
         .m_revalidate_lock      = mdc_revalidate_lock
 };
 
@@ -154,6 +154,12 @@ static int mdd_init0(const struct lu_env *env, struct mdd_device *mdd,
 	mdd->mdd_changelog_min_gc_interval = CHLOG_MIN_GC_INTERVAL;
 	/* with a very few number of free catalog entries */
 	mdd->mdd_changelog_min_free_cat_entries = CHLOG_MIN_FREE_CAT_ENTRIES;
+	/* directory auto split is disabled by default */
+	mdd->mdd_enable_dir_auto_split = 0;
+	mdd->mdd_dir_split_count = MDD_DIR_SPLIT_COUNT;
+	mdd->mdd_dir_split_delta = MDD_DIR_SPLIT_DELTA;
+	mdd->mdd_dir_split_hash = LMV_HASH_TYPE_FNV_1A_64;
+	spin_lock_init(&mdd->mdd_dir_split.dss_lock);
 
 	dt_conf_get(env, mdd->mdd_child, &mdd->mdd_dt_conf);
 
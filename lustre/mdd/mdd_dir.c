@@ -2471,6 +2471,29 @@ stop:
  * \retval		0 on success
  * \retval		negative errno on failure
  */
+/*
+ * Directory size is used as a cheap hint of directory growth: tell MDT to
+ * check directory whenever its size crosses dir_split_count times a power of
+ * two, and the entries are counted before split, see mdd_dir_split_prep().
+ *
+ * The size is the entry count on ZFS, but it is in bytes on ldiskfs, where
+ * each entry takes at least 12 bytes. There the hint is only a byte count:
+ * MDT checks the directory well before it has dir_split_count entries, and
+ * then every time its size doubles, so the split may happen up to twice as
+ * many entries later than dir_split_count.
+ */
+static inline bool mdd_dir_split_crossed(struct mdd_device *mdd,
+					 __u64 old_size, __u64 new_size)
+{
+	__u64 count = mdd->mdd_dir_split_count;
+
+	if (new_size < count)
+		return false;
+
+	return fls64(div64_u64(old_size, count)) !=
+	       fls64(div64_u64(new_size, count));
+}
+
 static int mdd_create(const struct lu_env *env, struct md_object *pobj,
 		      const struct lu_name *lname, struct md_object *child,
 		      struct md_op_spec *spec, struct md_attr *ma)
@@ -2488,6 +2511,7 @@ static int mdd_create(const struct lu_env *env, struct md_object *pobj,
 	struct linkea_data	*ldata = &info->mti_link_data;
 	const char		*name = lname->ln_name;
 	struct dt_allocation_hint *hint = &mdd_env_info(env)->mti_hint;
+	__u64			 psize;
 	int			 rc;
 	int			 rc2;
 	ENTRY;
@@ -2495,6 +2519,7 @@ static int mdd_create(const struct lu_env *env, struct md_object *pobj,
 	rc = mdd_la_get(env, mdd_pobj, pattr);
 	if (rc != 0)
 		RETURN(rc);
+	psize = pattr->la_size;
 
 	/* Sanity checks before big job. */
 	rc = mdd_create_sanity_check(env, pobj, pattr, lname, attr, spec);
@@ -2643,6 +2668,13 @@ out_stop:
 			mdd_index_delete(env, mdd_pobj, attr, lname);
 		rc = rc2;
 	}
+
+	if (rc == 0 && mdd->mdd_enable_dir_auto_split &&
+	    !(spec->sp_cr_flags & MDS_OPEN_VOLATILE) &&
+	    !mdd_object_remote(mdd_pobj) && fid_is_norm(mdo2fid(mdd_pobj)) &&
+	    !mdd_la_get(env, mdd_pobj, &info->mti_tpattr))
+		spec->sp_dir_split = mdd_dir_split_crossed(mdd, psize,
+						info->mti_tpattr.la_size);
 out_free:
 	if (is_vmalloc_addr(ldata->ld_buf))
 		/* if we vmalloced a large buffer drop it */
@@ -3199,6 +3231,10 @@ static int mdd_migrate_sanity_check(const struct lu_env *env,
 
 	ENTRY;
 
+	/* only dirent is migrated, sobj is kept */
+	if (tobj == sobj)
+		goto check_rename;
+
 	if (!mdd_object_remote(sobj)) {
 		mdd_read_lock(env, sobj, MOR_SRC_CHILD);
 		if (sobj->mod_count > 0) {
@@ -3214,6 +3250,7 @@ static int mdd_migrate_sanity_check(const struct lu_env *env,
 	if (mdd_object_exists(tobj))
 		RETURN(-EEXIST);
 
+check_rename:
 	rc = mdd_rename_sanity_check(env, spobj, spattr, tpobj, tpattr, sobj,
 				     attr, NULL, NULL);
 	RETURN(rc);
@@ -3442,6 +3479,167 @@ static int mdd_dir_iterate_stripes(const struct lu_env *env,
 	RETURN(0);
 }
 
+/*
+ * Count entries of \a dir, including dot and dotdot, stop when \a limit is
+ * reached.
+ *
+ * \retval	1 if limit is reached
+ * \retval	0 if all entries are counted
+ * \retval	-errno on failure
+ */
+static int mdd_dir_count_entries(const struct lu_env *env,
+				 struct mdd_object *dir, __u64 *count,
+				 __u64 limit)
+{
+	struct dt_object *obj;
+	const struct dt_it_ops *iops;
+	struct dt_it *it;
+	int rc;
+
+	ENTRY;
+
+	obj = mdd_object_child(dir);
+	if (!dt_try_as_dir(env, obj))
+		RETURN(-ENOTDIR);
+
+	iops = &obj->do_index_ops->dio_it;
+	it = iops->init(env, obj, LUDA_64BITHASH);
+	if (IS_ERR(it))
+		RETURN(PTR_ERR(it));
+
+	rc = iops->get(env, it, (const struct dt_key *)"");
+	if (rc > 0) {
+		while (++(*count) < limit) {
+			rc = iops->next(env, it);
+			if (rc)
+				break;
+		}
+		/* next() returns 1 at the end of directory */
+		if (rc >= 0)
+			rc = *count >= limit;
+	} else if (rc == 0) {
+		/* index contains no zero key */
+		rc = -EIO;
+	}
+
+	iops->put(env, it);
+	iops->fini(env, it);
+
+	RETURN(rc);
+}
+
+struct mdd_dir_split_count {
+	__u64	dsc_count;
+	__u64	dsc_limit;
+};
+
+static int mdd_dir_count_stripe(const struct lu_env *env,
+				struct mdd_object *obj,
+				struct mdd_object *stripe,
+				const struct lu_buf *lmv_buf,
+				const struct lu_buf *lmu_buf,
+				int index,
+				struct thandle *handle)
+{
+	struct mdd_dir_split_count *dsc = lmu_buf->lb_buf;
+
+	return mdd_dir_count_entries(env, stripe, &dsc->dsc_count,
+				     dsc->dsc_limit);
+}
+
+/**
+ * Check whether directory \a sobj is still large enough to be split, and
+ * prepare the target layout in mti_lmu.
+ *
+ * The threshold is mdd_dir_split_count entries per stripe, and the new
+ * layout has mdd_dir_split_delta more stripes, but no more than the number
+ * of MDTs. The master stays on the MDT specified by \a lmu.
+ *
+ * \param[in] env	execution environment
+ * \param[in] sobj	directory to split
+ * \param[in] lmu	layout from MDT, only stripe offset is used
+ *
+ * \retval		0 if directory should be split
+ * \retval		-EALREADY if directory doesn't need split
+ * \retval		-errno on failure
+ */
+static int mdd_dir_split_prep(const struct lu_env *env,
+			      struct mdd_object *sobj,
+			      const struct lmv_user_md *lmu)
+{
+	struct mdd_device *mdd = mdo2mdd(&sobj->mod_obj);
+	struct mdd_thread_info *info = mdd_env_info(env);
+	struct mdd_dir_split_count dsc = { 0 };
+	struct lu_buf dsc_buf = { .lb_buf = &dsc, .lb_len = sizeof(dsc) };
+	struct lu_buf lmv_buf = { NULL };
+	struct lmv_mds_md_v1 *lmv;
+	__u32 stripe_count = 1;
+	/* for a plain directory, a striped one keeps its hash type */
+	__u32 hash_type = mdd->mdd_dir_split_hash;
+	__u32 mdt_count = 0;
+	__u32 vallen = sizeof(mdt_count);
+	int rc;
+
+	ENTRY;
+
+	rc = mdd_stripe_get(env, sobj, &lmv_buf, XATTR_NAME_LMV);
+	if (rc && rc != -ENODATA)
+		RETURN(rc);
+
+	lmv = lmv_buf.lb_buf;
+	if (lmv) {
+		if (le32_to_cpu(lmv->lmv_hash_type) & LMV_HASH_FLAG_MIGRATION)
+			GOTO(out, rc = -EALREADY);
+
+		stripe_count = le32_to_cpu(lmv->lmv_stripe_count);
+		hash_type = le32_to_cpu(lmv->lmv_hash_type) &
+			    LMV_HASH_TYPE_MASK;
+	}
+
+	rc = obd_get_info(env, mdd->mdd_child_exp, sizeof(KEY_TGT_COUNT),
+			  KEY_TGT_COUNT, &vallen, &mdt_count);
+	if (rc)
+		GOTO(out, rc);
+
+	if (stripe_count >= mdt_count)
+		GOTO(out, rc = -EALREADY);
+
+	/* dot and dotdot of each stripe are counted too */
+	dsc.dsc_limit = (__u64)(mdd->mdd_dir_split_count + 2) * stripe_count;
+	if (lmv)
+		rc = mdd_dir_iterate_stripes(env, sobj, &lmv_buf, &dsc_buf,
+					     NULL, mdd_dir_count_stripe);
+	else
+		rc = mdd_dir_count_entries(env, sobj, &dsc.dsc_count,
+					   dsc.dsc_limit);
+	if (rc < 0)
+		GOTO(out, rc);
+
+	if (dsc.dsc_count < dsc.dsc_limit)
+		GOTO(out, rc = -EALREADY);
+
+	memset(&info->mti_lmu, 0, sizeof(info->mti_lmu));
+	info->mti_lmu.lum_magic = cpu_to_le32(LMV_USER_MAGIC);
+	info->mti_lmu.lum_stripe_count =
+		cpu_to_le32(min(stripe_count + mdd->mdd_dir_split_delta,
+				mdt_count));
+	info->mti_lmu.lum_stripe_offset = lmu->lum_stripe_offset;
+	info->mti_lmu.lum_hash_type = cpu_to_le32(hash_type);
+
+	CDEBUG(D_INFO, "%s: split "DFID" from %u to %u stripes\n",
+	       mdd2obd_dev(mdd)->obd_name, PFID(mdo2fid(sobj)), stripe_count,
+	       le32_to_cpu(info->mti_lmu.lum_stripe_count));
+
+	spin_lock(&mdd->mdd_dir_split.dss_lock);
+	mdd->mdd_dir_split.dss_checked++;
+	spin_unlock(&mdd->mdd_dir_split.dss_lock);
+	rc = 0;
+	EXIT;
+out:
+	lu_buf_free(&lmv_buf);
+	return rc;
+}
+
 typedef int (*mdd_xattr_cb)(const struct lu_env *env,
 			    struct mdd_object *obj,
 			    const struct lu_buf *buf,
@@ -3757,6 +3955,7 @@ static int migrate_linkea_prepare(const struct lu_env *env,
 				  struct mdd_object *sobj,
 				  const struct lu_name *lname,
 				  const struct lu_attr *attr,
+				  bool nsonly,
 				  struct linkea_data *ldata)
 {
 	__u32 source_mdt_index;
@@ -3775,7 +3974,7 @@ static int migrate_linkea_prepare(const struct lu_env *env,
 	 * mulitple links, we only need migrate the file if all of its entries
 	 * has been migrated to the remote MDT.
 	 */
-	if (S_ISDIR(attr->la_mode) || attr->la_nlink < 2)
+	if (nsonly || S_ISDIR(attr->la_mode) || attr->la_nlink < 2)
 		RETURN(0);
 
 	/* If there are still links locally, don't migrate this file */
@@ -4128,6 +4327,17 @@ static int mdd_declare_migrate_update(const struct lu_env *env,
 			return rc;
 	}
 
+	if (S_ISDIR(attr->la_mode) && !do_create && tpobj != spobj) {
+		rc = mdo_declare_index_delete(env, sobj, dotdot, handle);
+		if (rc)
+			return rc;
+
+		rc = mdo_declare_index_insert(env, sobj, mdo2fid(tpobj),
+					      S_IFDIR, dotdot, handle);
+		if (rc)
+			return rc;
+	}
+
 	la->la_valid = LA_CTIME | LA_MTIME;
 	rc = mdo_declare_attr_set(env, spobj, la, handle);
 	if (rc)
@@ -4196,6 +4406,18 @@ static int mdd_migrate_update(const struct lu_env *env,
 	if (rc)
 		RETURN(rc);
 
+	/* dir dirent is moved to another stripe, update its ".." */
+	if (S_ISDIR(attr->la_mode) && !do_create && tpobj != spobj) {
+		mdd_write_lock(env, sobj, MOR_SRC_CHILD);
+		rc = __mdd_index_delete_only(env, sobj, dotdot, handle);
+		if (!rc)
+			rc = __mdd_index_insert_only(env, sobj, mdo2fid(tpobj),
+						     S_IFDIR, dotdot, handle);
+		mdd_write_unlock(env, sobj);
+		if (rc)
+			RETURN(rc);
+	}
+
 	la->la_ctime = la->la_mtime = ma->ma_attr.la_ctime;
 	la->la_valid = LA_CTIME | LA_MTIME;
 	mdd_write_lock(env, spobj, MOR_SRC_PARENT);
@@ -4240,6 +4462,29 @@ static int mdd_migrate_update(const struct lu_env *env,
 	RETURN(rc);
 }
 
+/* update directory auto split statistics after a successful migration */
+static void mdd_dir_split_account(struct mdd_device *mdd,
+				  const struct md_op_spec *spec,
+				  struct mdd_object *tobj)
+{
+	struct mdd_dir_split_stats *dss = &mdd->mdd_dir_split;
+
+	if (!spec->sp_migrate_nsonly && !spec->sp_dir_split)
+		return;
+
+	spin_lock(&dss->dss_lock);
+	if (spec->sp_migrate_nsonly) {
+		dss->dss_entries++;
+		dss->dss_cur_done++;
+	} else {
+		dss->dss_started++;
+		dss->dss_cur_fid = *mdo2fid(tobj);
+		dss->dss_cur_done = 0;
+		dss->dss_cur_start = ktime_get_real_seconds();
+	}
+	spin_unlock(&dss->dss_lock);
+}
+
 /**
  * Migrate directory or file.
  *
@@ -4365,11 +4610,23 @@ static int mdd_migrate(const struct lu_env *env, struct md_object *md_pobj,
 	if (rc)
 		GOTO(out, rc);
 
-	if (S_ISDIR(attr->la_mode)) {
+	if (spec->sp_migrate_nsonly) {
+		/* migrate dirent only, used by directory auto split */
+		do_create = false;
+	} else if (S_ISDIR(attr->la_mode)) {
 		struct lmv_user_md_v1 *lmu = spec->u.sp_ea.eadata;
 
 		LASSERT(lmu);
 
+		if (spec->sp_dir_split) {
+			rc = mdd_dir_split_prep(env, sobj, lmu);
+			if (rc)
+				GOTO(out, rc);
+
+			spec->u.sp_ea.eadata = &info->mti_lmu;
+			lmu = spec->u.sp_ea.eadata;
+		}
+
 		/*
 		 * if user use default value '0' for stripe_count, we need to
 		 * adjust it to '1' to create a 1-stripe directory.
@@ -4471,7 +4728,7 @@ static int mdd_migrate(const struct lu_env *env, struct md_object *md_pobj,
 	 * similar to rename.
 	 */
 	rc = migrate_linkea_prepare(env, mdd, spobj, tpobj, sobj, lname, attr,
-				    ldata);
+				    spec->sp_migrate_nsonly, ldata);
 	if (rc > 0)
 		do_create = false;
 	else if (rc)
@@ -4482,7 +4739,8 @@ static int mdd_migrate(const struct lu_env *env, struct md_object *md_pobj,
 	if (rc)
 		GOTO(out, rc);
 
-	mdd_object_make_hint(env, NULL, tobj, attr, spec, hint);
+	if (do_create)
+		mdd_object_make_hint(env, NULL, tobj, attr, spec, hint);
 
 	handle = mdd_trans_create(env, mdd);
 	if (IS_ERR(handle))
@@ -4533,6 +4791,8 @@ static int mdd_migrate(const struct lu_env *env, struct md_object *md_pobj,
 	EXIT;
 stop_trans:
 	rc = mdd_trans_stop(env, mdd, rc, handle);
+	if (!rc)
+		mdd_dir_split_account(mdd, spec, tobj);
 out:
 	if (spobj && !IS_ERR(spobj))
 		mdd_object_put(env, spobj);
@@ -4889,6 +5149,16 @@ int mdd_dir_layout_shrink(const struct lu_env *env,
 stop_trans:
 	rc = mdd_trans_stop(env, mdd, rc, handle);
 out:
+	spin_lock(&mdd->mdd_dir_split.dss_lock);
+	if (lu_fid_eq(&mdd->mdd_dir_split.dss_cur_fid, mdo2fid(obj))) {
+		if (rc)
+			mdd->mdd_dir_split.dss_failed++;
+		else
+			mdd->mdd_dir_split.dss_completed++;
+		fid_zero(&mdd->mdd_dir_split.dss_cur_fid);
+	}
+	spin_unlock(&mdd->mdd_dir_split.dss_lock);
+
 	if (pobj) {
 		mdd_object_put(env, stripe);
 		mdd_object_put(env, pobj);
@@ -68,6 +68,11 @@
  * last indexes) before starting garbage collect */
 #define CHLOG_MIN_FREE_CAT_ENTRIES 2
 
+/* default entries per stripe before a directory is split automatically */
+#define MDD_DIR_SPLIT_COUNT 50000
+/* default number of stripes added by one automatic split */
+#define MDD_DIR_SPLIT_DELTA 4
+
 /* Changelog flags */
 /** changelog is recording */
 #define CLM_ON    0x00001
@@ -130,6 +135,20 @@ struct mdd_generic_thread {
 	bool			mgt_init;
 };
 
+/** statistics of automatic directory split */
+struct mdd_dir_split_stats {
+	spinlock_t		dss_lock;
+	__u64			dss_checked;	/* dirs found over threshold */
+	__u64			dss_started;	/* splits started */
+	__u64			dss_completed;	/* splits finished */
+	__u64			dss_failed;	/* splits failed to finish */
+	__u64			dss_entries;	/* entries migrated */
+	/* the split in progress, if any */
+	struct lu_fid		dss_cur_fid;
+	__u64			dss_cur_done;
+	time64_t		dss_cur_start;
+};
+
 struct mdd_device {
         struct md_device                 mdd_md_dev;
 	struct obd_export               *mdd_child_exp;
@@ -150,6 +169,14 @@ struct mdd_device {
         struct mdd_dot_lustre_objs       mdd_dot_lustre_objs;
 	unsigned int			 mdd_sync_permission;
 	int				 mdd_connects;
+	bool				 mdd_enable_dir_auto_split;
+	/* split when entries per stripe exceed this */
+	unsigned int			 mdd_dir_split_count;
+	/* stripes added by one split */
+	unsigned int			 mdd_dir_split_delta;
+	/* hash type of a plain directory when it is split */
+	__u32				 mdd_dir_split_hash;
+	struct mdd_dir_split_stats	 mdd_dir_split;
 	struct local_oid_storage	*mdd_los;
 	struct mdd_generic_thread	 mdd_orphan_cleanup_thread;
 	struct kobject			 mdd_kobj;
@@ -457,6 +457,169 @@ static ssize_t sync_perm_store(struct kobject *kobj, struct attribute *attr,
 }
 LUSTRE_RW_ATTR(sync_perm);
 
+static ssize_t enable_dir_auto_split_show(struct kobject *kobj,
+					  struct attribute *attr, char *buf)
+{
+	struct mdd_device *mdd = container_of(kobj, struct mdd_device,
+					      mdd_kobj);
+
+	return sprintf(buf, "%d\n", mdd->mdd_enable_dir_auto_split);
+}
+
+static ssize_t enable_dir_auto_split_store(struct kobject *kobj,
+					   struct attribute *attr,
+					   const char *buffer, size_t count)
+{
+	struct mdd_device *mdd = container_of(kobj, struct mdd_device,
+					      mdd_kobj);
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	mdd->mdd_enable_dir_auto_split = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(enable_dir_auto_split);
+
+static ssize_t dir_split_count_show(struct kobject *kobj,
+				    struct attribute *attr, char *buf)
+{
+	struct mdd_device *mdd = container_of(kobj, struct mdd_device,
+					      mdd_kobj);
+
+	return sprintf(buf, "%u\n", mdd->mdd_dir_split_count);
+}
+
+static ssize_t dir_split_count_store(struct kobject *kobj,
+				     struct attribute *attr,
+				     const char *buffer, size_t count)
+{
+	struct mdd_device *mdd = container_of(kobj, struct mdd_device,
+					      mdd_kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val == 0)
+		return -ERANGE;
+
+	mdd->mdd_dir_split_count = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(dir_split_count);
+
+static ssize_t dir_split_delta_show(struct kobject *kobj,
+				    struct attribute *attr, char *buf)
+{
+	struct mdd_device *mdd = container_of(kobj, struct mdd_device,
+					      mdd_kobj);
+
+	return sprintf(buf, "%u\n", mdd->mdd_dir_split_delta);
+}
+
+static ssize_t dir_split_delta_store(struct kobject *kobj,
+				     struct attribute *attr,
+				     const char *buffer, size_t count)
+{
+	struct mdd_device *mdd = container_of(kobj, struct mdd_device,
+					      mdd_kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val == 0 || val > LMV_MAX_STRIPE_COUNT)
+		return -ERANGE;
+
+	mdd->mdd_dir_split_delta = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(dir_split_delta);
+
+static const char *const mdd_dir_split_hash_names[LMV_HASH_TYPE_MAX] = {
+	[LMV_HASH_TYPE_ALL_CHARS]	= LMV_HASH_NAME_ALL_CHARS,
+	[LMV_HASH_TYPE_FNV_1A_64]	= LMV_HASH_NAME_FNV_1A_64,
+	[LMV_HASH_TYPE_JUMP]		= LMV_HASH_NAME_JUMP,
+};
+
+static ssize_t dir_split_hash_show(struct kobject *kobj,
+				   struct attribute *attr, char *buf)
+{
+	struct mdd_device *mdd = container_of(kobj, struct mdd_device,
+					      mdd_kobj);
+
+	return sprintf(buf, "%s\n",
+		       mdd_dir_split_hash_names[mdd->mdd_dir_split_hash]);
+}
+
+/*
+ * Set the hash type given to a plain directory when it is split, by name.
+ * The jump hash moves fewer names on later splits, but clients which don't
+ * support it can't access the split directory.
+ */
+static ssize_t dir_split_hash_store(struct kobject *kobj,
+				    struct attribute *attr,
+				    const char *buffer, size_t count)
+{
+	struct mdd_device *mdd = container_of(kobj, struct mdd_device,
+					      mdd_kobj);
+	size_t len = count;
+	__u32 i;
+
+	if (len > 0 && buffer[len - 1] == '\n')
+		len--;
+
+	for (i = LMV_HASH_TYPE_ALL_CHARS; i < LMV_HASH_TYPE_MAX; i++) {
+		if (strlen(mdd_dir_split_hash_names[i]) == len &&
+		    strncmp(buffer, mdd_dir_split_hash_names[i], len) == 0) {
+			mdd->mdd_dir_split_hash = i;
+			return count;
+		}
+	}
+
+	return -EINVAL;
+}
+LUSTRE_RW_ATTR(dir_split_hash);
+
+static int mdd_dir_split_stats_seq_show(struct seq_file *m, void *data)
+{
+	struct mdd_device *mdd = m->private;
+	struct mdd_dir_split_stats *dss = &mdd->mdd_dir_split;
+	struct mdd_dir_split_stats tmp;
+
+	spin_lock(&dss->dss_lock);
+	tmp = *dss;
+	spin_unlock(&dss->dss_lock);
+
+	seq_printf(m, "checked: %llu\n"
+		   "started: %llu\n"
+		   "completed: %llu\n"
+		   "failed: %llu\n"
+		   "entries_migrated: %llu\n",
+		   tmp.dss_checked, tmp.dss_started, tmp.dss_completed,
+		   tmp.dss_failed, tmp.dss_entries);
+
+	if (fid_is_zero(&tmp.dss_cur_fid))
+		return 0;
+
+	seq_printf(m, "current: "DFID" %llu entries migrated in %llu seconds\n",
+		   PFID(&tmp.dss_cur_fid), tmp.dss_cur_done,
+		   (__u64)(ktime_get_real_seconds() - tmp.dss_cur_start));
+	return 0;
+}
+LDEBUGFS_SEQ_FOPS_RO(mdd_dir_split_stats);
+
 static ssize_t lfsck_speed_limit_show(struct kobject *kobj,
 				      struct attribute *attr, char *buf)
 {
@@ -541,6 +704,8 @@ static struct lprocfs_vars lprocfs_mdd_obd_vars[] = {
 	  .fops =	&mdd_lfsck_namespace_fops	},
 	{ .name	=	"lfsck_layout",
 	  .fops	=	&mdd_lfsck_layout_fops		},
+	{ .name =	"dir_split_stats",
+	  .fops =	&mdd_dir_split_stats_fops	},
 	{ NULL }
 };
 
@@ -557,6 +722,10 @@ static struct attribute *mdd_attrs[] = {
 	&lustre_attr_lfsck_async_windows.attr,
 	&lustre_attr_lfsck_speed_limit.attr,
 	&lustre_attr_sync_perm.attr,
+	&lustre_attr_enable_dir_auto_split.attr,
+	&lustre_attr_dir_split_count.attr,
+	&lustre_attr_dir_split_delta.attr,
+	&lustre_attr_dir_split_hash.attr,
 	NULL,
 };
 
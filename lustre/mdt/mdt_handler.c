@@ -1574,6 +1574,153 @@ out:
 	RETURN(rc);
 }
 
+/* only the getattr and lookup intents of statahead can be batched */
+static bool mdt_batch_sub_allowed(struct ptlrpc_request *sub)
+{
+	struct ldlm_intent *it;
+
+	if (lustre_msg_get_opc(sub->rq_reqmsg) != LDLM_ENQUEUE ||
+	    sub->rq_reqmsg->lm_bufcount <= DLM_INTENT_IT_OFF)
+		return false;
+
+	req_capsule_init(&sub->rq_pill, sub, RCL_SERVER);
+	req_capsule_set(&sub->rq_pill, &RQF_LDLM_INTENT_BASIC);
+	it = req_capsule_client_get(&sub->rq_pill, &RMF_LDLM_INTENT);
+	req_capsule_fini(&sub->rq_pill);
+
+	return it != NULL && !(it->opc & ~(IT_GETATTR | IT_LOOKUP));
+}
+
+/*
+ * Handler of MDS_BATCH RPCs, carrying the getattr and lookup intents of
+ * statahead. The sub-requests are executed in turn as if they were received
+ * on their own, then their replies, with the locks granted to them, are
+ * returned together in the reply.
+ *
+ * A sub-reply which does not fit in the reply size given by the client is
+ * replaced by -EOVERFLOW, the client then stats the entry on its own. The
+ * lock granted to it is reclaimed through the usual blocking AST.
+ */
+static int mdt_batch(struct tgt_session_info *tsi)
+{
+	struct ptlrpc_request		*req = tgt_ses_req(tsi);
+	struct req_capsule		*pill = tsi->tsi_pill;
+	struct batch_update_header	*buh;
+	struct batch_update_buffer	*bub;
+	struct ptlrpc_request		**subs = NULL;
+	int				*rcs = NULL;
+	char				*ptr;
+	char				*end;
+	int				 reply_size;
+	int				 count;
+	int				 len;
+	int				 i;
+	int				 rc;
+	ENTRY;
+
+	buh = req_capsule_client_get(pill, &RMF_BATCH_UPDATE_REQUEST);
+	if (buh == NULL || buh->buh_magic != BATCH_UPDATE_REQUEST_MAGIC)
+		RETURN(err_serious(-EPROTO));
+
+	len = req_capsule_get_size(pill, &RMF_BATCH_UPDATE_REQUEST,
+				   RCL_CLIENT);
+	if (len < sizeof(*buh) || buh->buh_count == 0 ||
+	    buh->buh_count > (len - sizeof(*buh)) / sizeof(*bub))
+		RETURN(err_serious(-EPROTO));
+
+	count = buh->buh_count;
+	reply_size = sizeof(*buh) + count * sizeof(*bub);
+	if (reply_size > buh->buh_reply_size)
+		RETURN(err_serious(-EPROTO));
+
+	OBD_ALLOC(subs, count * sizeof(*subs));
+	OBD_ALLOC(rcs, count * sizeof(*rcs));
+	if (subs == NULL || rcs == NULL)
+		GOTO(out, rc = err_serious(-ENOMEM));
+
+	ptr = (char *)(buh + 1);
+	end = (char *)buh + len;
+	for (i = 0; i < count; i++) {
+		struct ptlrpc_request *sub;
+
+		bub = (struct batch_update_buffer *)ptr;
+		if (ptr + sizeof(*bub) > end)
+			GOTO(out, rc = err_serious(-EPROTO));
+		if (ptlrpc_req_need_swab(req))
+			lustre_swab_batch_update_buffer(bub);
+		if (bub->bub_size > end - ptr - sizeof(*bub))
+			GOTO(out, rc = err_serious(-EPROTO));
+		ptr += cfs_size_round(sizeof(*bub) + bub->bub_size);
+
+		sub = ptlrpc_sub_req_init(req, (struct lustre_msg *)(bub + 1),
+					  bub->bub_size);
+		if (IS_ERR(sub)) {
+			rcs[i] = PTR_ERR(sub);
+			continue;
+		}
+		subs[i] = sub;
+
+		if (!mdt_batch_sub_allowed(sub)) {
+			rcs[i] = -EOPNOTSUPP;
+			continue;
+		}
+
+		rcs[i] = tgt_sub_request_handle(tsi, sub);
+		if (rcs[i] != 0)
+			continue;
+
+		len = cfs_size_round(sub->rq_replen);
+		if (reply_size + len > buh->buh_reply_size) {
+			rcs[i] = -EOVERFLOW;
+			continue;
+		}
+		reply_size += len;
+	}
+
+	req_capsule_set_size(pill, &RMF_BATCH_UPDATE_REPLY, RCL_SERVER,
+			     reply_size);
+	rc = req_capsule_server_pack(pill);
+	if (rc != 0)
+		GOTO(out, rc = err_serious(rc));
+
+	buh = req_capsule_server_get(pill, &RMF_BATCH_UPDATE_REPLY);
+	buh->buh_magic = BATCH_UPDATE_REPLY_MAGIC;
+	buh->buh_count = count;
+	buh->buh_reply_size = reply_size;
+	buh->buh_padding = 0;
+
+	ptr = (char *)(buh + 1);
+	end = (char *)buh + reply_size;
+	for (i = 0; i < count; i++) {
+		bub = (struct batch_update_buffer *)ptr;
+		bub->bub_size = 0;
+		bub->bub_rc = rcs[i];
+		if (rcs[i] == 0) {
+			len = ptlrpc_sub_req_reply_copy(subs[i], bub + 1,
+						end - (char *)(bub + 1));
+			if (len < 0)
+				bub->bub_rc = len;
+			else
+				bub->bub_size = len;
+		}
+		ptr += cfs_size_round(sizeof(*bub) + bub->bub_size);
+	}
+
+	CDEBUG(D_INFO, "%s: batch of %d sub-requests, reply size %d\n",
+	       tgt_name(tsi->tsi_tgt), count, reply_size);
+	EXIT;
+out:
+	if (subs != NULL) {
+		for (i = 0; i < count; i++)
+			if (subs[i] != NULL)
+				ptlrpc_sub_req_fini(subs[i]);
+		OBD_FREE(subs, count * sizeof(*subs));
+	}
+	if (rcs != NULL)
+		OBD_FREE(rcs, count * sizeof(*rcs));
+	return rc;
+}
+
 static int mdt_raw_lookup(struct mdt_thread_info *info,
 			  struct mdt_object *parent,
 			  const struct lu_name *lname,
@@ -3198,14 +3345,15 @@ static void mdt_save_remote_lock(struct mdt_thread_info *info,
 		     (MDS_INODELOCK_XATTR | MDS_INODELOCK_UPDATE)))
 			mo_invalidate(info->mti_env, mdt_object_child(o));
 
+		/* there is no request for MDT internal operation, e.g.
+		 * directory auto split */
 		if (decref || !info->mti_has_trans ||
-		    !(mode & (LCK_PW | LCK_EX))) {
+		    !(mode & (LCK_PW | LCK_EX)) || !mdt_info_req(info)) {
 			ldlm_lock_decref_and_cancel(h, mode);
 			LDLM_LOCK_PUT(lock);
 		} else {
 			struct ptlrpc_request *req = mdt_info_req(info);
 
-			LASSERT(req != NULL);
 			tgt_save_slc_lock(&info->mti_mdt->mdt_lut, lock,
 					  req->rq_transno);
 			ldlm_lock_decref(h, mode);
@@ -3415,6 +3563,8 @@ void mdt_thread_info_init(struct ptlrpc_request *req,
 	info->mti_spec.sp_rm_entry = 0;
 	info->mti_spec.sp_permitted = 0;
 	info->mti_spec.sp_migrate_close = 0;
+	info->mti_spec.sp_migrate_nsonly = 0;
+	info->mti_spec.sp_dir_split = 0;
 
 	info->mti_spec.u.sp_ea.eadata = NULL;
 	info->mti_spec.u.sp_ea.eadatalen = 0;
@@ -4851,6 +5001,7 @@ TGT_MDT_HDL(HABEO_CORPUS| HABEO_REFERO, MDS_HSM_REQUEST,
 TGT_MDT_HDL(HABEO_CLAVIS | HABEO_CORPUS | HABEO_REFERO | MUTABOR,
 	    MDS_SWAP_LAYOUTS,
 	    mdt_swap_layouts),
+TGT_MDT_HDL(0,				MDS_BATCH,	mdt_batch),
 };
 
 static struct tgt_handler mdt_io_ops[] = {
@@ -4954,6 +5105,7 @@ static void mdt_fini(const struct lu_env *env, struct mdt_device *m)
 	 * restarted by a user while it's shutting down. */
 	hsm_cdt_procfs_fini(m);
 	mdt_hsm_cdt_stop(m);
+	mdt_dir_split_fini(m);
 
 	mdt_llog_ctxt_unclone(env, m, LLOG_AGENT_ORIG_CTXT);
 	mdt_llog_ctxt_unclone(env, m, LLOG_CHANGELOG_ORIG_CTXT);
@@ -5188,6 +5340,10 @@ static int mdt_init0(const struct lu_env *env, struct mdt_device *m,
 		GOTO(err_los_fini, rc);
 	}
 
+	rc = mdt_dir_split_init(m);
+	if (rc != 0)
+		GOTO(err_free_hsm, rc);
+
 	tgt_adapt_sptlrpc_conf(&m->mdt_lut);
 
 	next = m->mdt_child;
@@ -5218,7 +5374,7 @@ static int mdt_init0(const struct lu_env *env, struct mdt_device *m,
 	if (IS_ERR(m->mdt_identity_cache)) {
 		rc = PTR_ERR(m->mdt_identity_cache);
 		m->mdt_identity_cache = NULL;
-		GOTO(err_free_hsm, rc);
+		GOTO(err_split_fini, rc);
 	}
 
 	rc = mdt_procfs_init(m, dev);
@@ -5254,6 +5410,8 @@ err_recovery:
 	target_recovery_fini(obd);
 	upcall_cache_cleanup(m->mdt_identity_cache);
 	m->mdt_identity_cache = NULL;
+err_split_fini:
+	mdt_dir_split_fini(m);
 err_free_hsm:
 	mdt_hsm_cdt_fini(m);
 err_los_fini:
@@ -201,6 +201,25 @@ struct mdt_statfs_cache {
 	__u64 msf_age;
 };
 
+/* directory waiting to be split */
+struct mdt_split_item {
+	struct list_head	msi_linkage;
+	struct lu_fid		msi_fid;
+};
+
+/* max directories queued for auto split */
+#define MDT_SPLIT_QUEUE_MAX	32
+
+struct mdt_split_queue {
+	spinlock_t		msq_lock;
+	struct list_head	msq_list;
+	int			msq_count;
+	wait_queue_head_t	msq_waitq;
+	struct task_struct	*msq_task;
+	/* FID client for new directory master */
+	struct lu_client_seq	*msq_seq;
+};
+
 struct mdt_device {
 	/* super-class */
 	struct lu_device	   mdt_lu_dev;
@@ -278,6 +297,9 @@ struct mdt_device {
 
 	struct coordinator	   mdt_coordinator;
 
+	/* directory auto split */
+	struct mdt_split_queue	   mdt_split;
+
 	/* inter-MDT connection count */
 	atomic_t		   mdt_mds_mds_conns;
 
@@ -802,6 +824,8 @@ int mdt_pack_size2body(struct mdt_thread_info *info,
 int mdt_getxattr(struct mdt_thread_info *info);
 int mdt_reint_setxattr(struct mdt_thread_info *info,
                        struct mdt_lock_handle *lh);
+int mdt_dir_layout_shrink(struct mdt_thread_info *info);
+int mdt_dir_split_migrate(struct mdt_thread_info *info);
 
 void mdt_lock_handle_init(struct mdt_lock_handle *lh);
 void mdt_lock_handle_fini(struct mdt_lock_handle *lh);
@@ -1029,6 +1053,11 @@ int mdt_hsm_cdt_init(struct mdt_device *mdt);
 int mdt_hsm_cdt_stop(struct mdt_device *mdt);
 int mdt_hsm_cdt_fini(struct mdt_device *mdt);
 
+/* mdt/mdt_split.c */
+int mdt_dir_split_init(struct mdt_device *mdt);
+void mdt_dir_split_fini(struct mdt_device *mdt);
+void mdt_dir_split_add(struct mdt_device *mdt, const struct lu_fid *fid);
+
 /*
  * Signal the coordinator has work to do
  * \param cdt [IN] coordinator
@@ -708,6 +708,41 @@ mdt_enable_dir_migration_seq_write(struct file *file, const char __user *buffer,
 }
 LPROC_SEQ_FOPS(mdt_enable_dir_migration);
 
+/**
+ * Whether to commit the sub transactions of a synchronous distribute
+ * transaction on other MDTs asynchronously, see top_trans_can_commit_async().
+ */
+static int mdt_dist_txn_async_commit_seq_show(struct seq_file *m, void *data)
+{
+	struct obd_device *obd = m->private;
+	struct lu_target *tgt = obd->u.obt.obt_lut;
+
+	seq_printf(m, "%u\n", tgt->lut_dist_txn_async);
+	return 0;
+}
+
+static ssize_t
+mdt_dist_txn_async_commit_seq_write(struct file *file,
+				    const char __user *buffer,
+				    size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct obd_device *obd = m->private;
+	struct lu_target *tgt = obd->u.obt.obt_lut;
+	bool val;
+	int rc;
+
+	rc = kstrtobool_from_user(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	spin_lock(&tgt->lut_flags_lock);
+	tgt->lut_dist_txn_async = val;
+	spin_unlock(&tgt->lut_flags_lock);
+	return count;
+}
+LPROC_SEQ_FOPS(mdt_dist_txn_async_commit);
+
 
 /**
  * Show MDT policy for handling dirty metadata under a lock being cancelled.
@@ -1072,6 +1107,8 @@ static struct lprocfs_vars lprocfs_mdt_obd_vars[] = {
 	  .fops =	&mdt_enable_striped_dir_fops		},
 	{ .name =	"enable_dir_migration",
 	  .fops =	&mdt_enable_dir_migration_fops		},
+	{ .name =	"dist_txn_async_commit",
+	  .fops =	&mdt_dist_txn_async_commit_fops		},
 	{ .name =	"hsm_control",
 	  .fops =	&mdt_hsm_cdt_control_fops		},
 	{ .name =	"recovery_time_hard",
@@ -1519,6 +1519,9 @@ again:
 			mdt_clear_disposition(info, ldlm_rep, DISP_OPEN_CREATE);
 			GOTO(out_child, result);
 		} else {
+			if (result == 0 && info->mti_spec.sp_dir_split)
+				mdt_dir_split_add(mdt, mdt_object_fid(parent));
+
 			mdt_prep_ma_buf_from_rep(info, child, ma);
 			/* XXX: we should call this once, see few lines below */
 			if (result == 0)
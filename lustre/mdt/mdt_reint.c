@@ -159,9 +159,12 @@ void mdt_version_get_save(struct mdt_thread_info *info,
 int mdt_version_get_check(struct mdt_thread_info *info,
                           struct mdt_object *mto, int idx)
 {
-        /* only check versions during replay */
-        if (!req_is_replay(mdt_info_req(info)))
-                return 0;
+	struct ptlrpc_request *req = mdt_info_req(info);
+
+	/* only check versions during replay, and MDT internal operation
+	 * like directory auto split has no request */
+	if (!req || !req_is_replay(req))
+		return 0;
 
         mdt_obj_version_get(info, mto, &info->mti_ver[idx]);
         return mdt_version_check(mdt_info_req(info), info->mti_ver[idx], idx);
@@ -454,6 +457,8 @@ static int mdt_create(struct mdt_thread_info *info)
 
 	rc = mdo_create(info->mti_env, mdt_object_child(parent), &rr->rr_name,
 			mdt_object_child(child), &info->mti_spec, ma);
+	if (rc == 0 && info->mti_spec.sp_dir_split)
+		mdt_dir_split_add(mdt, mdt_object_fid(parent));
 	if (rc == 0)
 		rc = mdt_attr_get_complex(info, child, ma);
 
@@ -1248,8 +1253,12 @@ static int mdt_rename_lock(struct mdt_thread_info *info,
 		struct ldlm_namespace *ns = info->mti_mdt->mdt_namespace;
 		union ldlm_policy_data *policy = &info->mti_policy;
 		struct ldlm_res_id *res_id = &info->mti_res_id;
+		__u64 *cookie = NULL;
 		__u64 flags = 0;
 
+		if (info->mti_exp)
+			cookie = &info->mti_exp->exp_handle.h_cookie;
+
 		fid_build_reg_res_name(&LUSTRE_BFL_FID, res_id);
 		memset(policy, 0, sizeof *policy);
 		policy->l_inodebits.bits = MDS_INODELOCK_UPDATE;
@@ -1258,9 +1267,7 @@ static int mdt_rename_lock(struct mdt_thread_info *info,
 					    LDLM_IBITS, policy, LCK_EX, &flags,
 					    ldlm_blocking_ast,
 					    ldlm_completion_ast, NULL, NULL, 0,
-					    LVB_T_NONE,
-					    &info->mti_exp->exp_handle.h_cookie,
-					    lh);
+					    LVB_T_NONE, cookie, lh);
 		RETURN(rc);
 	}
 	RETURN(rc);
@@ -2019,6 +2026,10 @@ static int mdt_reint_migrate_internal(struct mdt_thread_info *info)
 	 */
 	do_sync = rc;
 
+	/* only dirent is migrated, file data and layout are untouched */
+	if (info->mti_spec.sp_migrate_nsonly)
+		goto lock_source;
+
 	/* TODO: DoM migration is not supported yet */
 	if (S_ISREG(lu_object_attr(&sobj->mot_obj))) {
 		ma->ma_lmm = info->mti_big_lmm;
@@ -2060,6 +2071,7 @@ static int mdt_reint_migrate_internal(struct mdt_thread_info *info)
 		}
 	}
 
+lock_source:
 	/* lock source */
 	lhs = &info->mti_lh[MDT_LH_OLD];
 	mdt_lock_reg_init(lhs, LCK_EX);
@@ -2068,6 +2080,18 @@ static int mdt_reint_migrate_internal(struct mdt_thread_info *info)
 	if (rc)
 		GOTO(unlock_open_sem, rc);
 
+	/* Don't do lookup sanity check. We know name doesn't exist. */
+	info->mti_spec.sp_cr_lookup = 0;
+	info->mti_spec.sp_feat = &dt_directory_features;
+
+	/* no target is created if only dirent is migrated */
+	if (info->mti_spec.sp_migrate_nsonly) {
+		rc = mdo_migrate(env, mdt_object_child(pobj),
+				 mdt_object_child(sobj), &rr->rr_name,
+				 mdt_object_child(sobj), &info->mti_spec, ma);
+		GOTO(unlock_source, rc);
+	}
+
 	/* lock target */
 	tobj = mdt_object_find(env, mdt, rr->rr_fid2);
 	if (IS_ERR(tobj))
@@ -2079,10 +2103,6 @@ static int mdt_reint_migrate_internal(struct mdt_thread_info *info)
 	if (rc)
 		GOTO(put_target, rc);
 
-	/* Don't do lookup sanity check. We know name doesn't exist. */
-	info->mti_spec.sp_cr_lookup = 0;
-	info->mti_spec.sp_feat = &dt_directory_features;
-
 	rc = mdo_migrate(env, mdt_object_child(pobj),
 			 mdt_object_child(sobj), &rr->rr_name,
 			 mdt_object_child(tobj), &info->mti_spec, ma);
@@ -2628,6 +2648,32 @@ static int mdt_reint_migrate(struct mdt_thread_info *info,
 	return mdt_reint_rename_or_migrate(info, lhc, false);
 }
 
+/**
+ * Migrate a directory or a dirent for directory auto split, which is done by
+ * MDT thread without request, see mdt_split.c.
+ */
+int mdt_dir_split_migrate(struct mdt_thread_info *info)
+{
+	struct lustre_handle rename_lh = { 0 };
+	int rc;
+
+	ENTRY;
+
+	/* dirent migration inside directory doesn't change the hierarchy */
+	if (!info->mti_spec.sp_migrate_nsonly) {
+		rc = mdt_rename_lock(info, &rename_lh);
+		if (rc)
+			RETURN(rc);
+	}
+
+	rc = mdt_reint_migrate_internal(info);
+
+	if (lustre_handle_is_used(&rename_lh))
+		mdt_rename_unlock(&rename_lh);
+
+	RETURN(rc);
+}
+
 static int mdt_reint_resync(struct mdt_thread_info *info,
 			    struct mdt_lock_handle *lhc)
 {
@@ -0,0 +1,609 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * lustre/mdt/mdt_split.c
+ *
+ * Directory auto split.
+ *
+ * When a create makes a directory grow over mdd.*.dir_split_count entries per
+ * stripe, MDD sets md_op_spec::sp_dir_split, and the directory is queued here.
+ * The split thread then restripes the directory in three steps, the same as
+ * 'lfs migrate -m' does from client, but without moving any inode:
+ *  1. migrate directory to a new layout with more stripes, the old stripes
+ *     are appended after the new ones, and the directory is in migrating
+ *     state, so clients create new entries in the new stripes.
+ *  2. migrate dirents in old stripes to new stripes, the inodes are not
+ *     migrated, so they stay on current MDTs as remote entries.
+ *  3. shrink directory layout to drop the empty old stripes.
+ *
+ * If it's interrupted, the directory is left in migrating state, which can be
+ * finished by 'lfs migrate -m'.
+ */
+
+#define DEBUG_SUBSYSTEM S_MDS
+
+#include <linux/kthread.h>
+#include <lustre_fid.h>
+#include <lustre_linkea.h>
+#include "mdt_internal.h"
+
+static void mdt_split_init_ucred(struct lu_ucred *uc)
+{
+	uc->uc_valid = UCRED_OLD;
+	uc->uc_o_uid = 0;
+	uc->uc_o_gid = 0;
+	uc->uc_o_fsuid = 0;
+	uc->uc_o_fsgid = 0;
+	uc->uc_uid = 0;
+	uc->uc_gid = 0;
+	uc->uc_fsuid = 0;
+	uc->uc_fsgid = 0;
+	uc->uc_suppgids[0] = -1;
+	uc->uc_suppgids[1] = -1;
+	/* migration is allowed for admin only */
+	uc->uc_cap = CFS_CAP_FS_MASK | (1 << CFS_CAP_SYS_ADMIN);
+	uc->uc_umask = 0777;
+	uc->uc_ginfo = NULL;
+	uc->uc_identity = NULL;
+	uc->uc_enable_audit = 1;
+}
+
+/* reset thread info before each operation, like mdt_thread_info_init() */
+static void mdt_split_info_reset(struct mdt_thread_info *info)
+{
+	struct lu_attr *la = &info->mti_attr.ma_attr;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(info->mti_lh); i++)
+		mdt_lock_handle_init(&info->mti_lh[i]);
+
+	memset(&info->mti_attr, 0, sizeof(info->mti_attr));
+	memset(&info->mti_rr, 0, sizeof(info->mti_rr));
+	memset(&info->mti_spec, 0, sizeof(info->mti_spec));
+	info->mti_has_trans = 0;
+	info->mti_cross_ref = 0;
+	info->mti_opdata = 0;
+	info->mti_big_lmm_used = 0;
+
+	la->la_ctime = la->la_mtime = ktime_get_real_seconds();
+	la->la_valid = LA_CTIME | LA_MTIME;
+}
+
+/**
+ * Get master FID of \a fid if it's a directory stripe.
+ *
+ * \retval	0 on success, \a mfid is set
+ * \retval	-EREMOTE if object is on other MDT
+ * \retval	-errno on failure
+ */
+static int mdt_split_master_fid(struct mdt_thread_info *info,
+				const struct lu_fid *fid, struct lu_fid *mfid)
+{
+	const struct lu_env *env = info->mti_env;
+	struct lu_buf buf = { .lb_buf = info->mti_xattr_buf,
+			      .lb_len = sizeof(info->mti_xattr_buf) };
+	struct mdt_object *obj;
+	int rc;
+
+	obj = mdt_object_find(env, info->mti_mdt, fid);
+	if (IS_ERR(obj))
+		return PTR_ERR(obj);
+
+	if (!mdt_object_exists(obj))
+		GOTO(out, rc = -ENOENT);
+
+	if (mdt_object_remote(obj))
+		GOTO(out, rc = -EREMOTE);
+
+	*mfid = *fid;
+
+	/* LMV of master may not fit in buffer, but that of stripe does */
+	rc = mo_xattr_get(env, mdt_object_child(obj), &buf, XATTR_NAME_LMV);
+	if (rc > 0) {
+		union lmv_mds_md *lmm = buf.lb_buf;
+
+		if (le32_to_cpu(lmm->lmv_magic) == LMV_MAGIC_STRIPE)
+			GOTO(out, rc = mdt_attr_get_pfid(info, obj, mfid));
+	}
+	rc = rc == -ENODATA || rc == -ERANGE || rc > 0 ? 0 : rc;
+out:
+	mdt_object_put(env, obj);
+	return rc;
+}
+
+/* get parent master FID and name of directory \a fid from linkEA */
+static int mdt_split_parent_get(struct mdt_thread_info *info,
+				const struct lu_fid *fid, struct lu_fid *pfid,
+				struct lu_name *lname, char *name)
+{
+	const struct lu_env *env = info->mti_env;
+	struct linkea_data ldata = { NULL };
+	struct lu_name tmpname;
+	struct mdt_object *obj;
+	int rc;
+
+	obj = mdt_object_find(env, info->mti_mdt, fid);
+	if (IS_ERR(obj))
+		return PTR_ERR(obj);
+
+	ldata.ld_buf = lu_buf_check_and_alloc(&info->mti_big_buf,
+					      MAX_LINKEA_SIZE);
+	if (!ldata.ld_buf->lb_buf)
+		GOTO(out, rc = -ENOMEM);
+
+	rc = mdt_links_read(info, obj, &ldata);
+	if (rc)
+		GOTO(out, rc);
+
+	/* directory has only one name */
+	linkea_first_entry(&ldata);
+	linkea_entry_unpack(ldata.ld_lee, &ldata.ld_reclen, &tmpname, pfid);
+	snprintf(name, NAME_MAX + 1, "%.*s", tmpname.ln_namelen,
+		 tmpname.ln_name);
+	lname->ln_name = name;
+	lname->ln_namelen = tmpname.ln_namelen;
+	mdt_object_put(env, obj);
+
+	/* parent may be a stripe too */
+	return mdt_split_master_fid(info, pfid, pfid);
+out:
+	mdt_object_put(env, obj);
+	return rc;
+}
+
+/* get LMV of directory \a fid, it's copied because mti_big_lmm is reused */
+static int mdt_split_lmv_get(struct mdt_thread_info *info,
+			     const struct lu_fid *fid,
+			     struct lmv_mds_md_v1 **lmvp, int *size)
+{
+	struct md_attr *ma = &info->mti_attr;
+	struct mdt_object *obj;
+	int rc;
+
+	if (unlikely(!info->mti_big_lmm)) {
+		info->mti_big_lmmsize = lmv_mds_md_size(64, LMV_MAGIC);
+		OBD_ALLOC(info->mti_big_lmm, info->mti_big_lmmsize);
+		if (!info->mti_big_lmm)
+			return -ENOMEM;
+	}
+
+	obj = mdt_object_find(info->mti_env, info->mti_mdt, fid);
+	if (IS_ERR(obj))
+		return PTR_ERR(obj);
+
+	ma->ma_lmv = info->mti_big_lmm;
+	ma->ma_lmv_size = info->mti_big_lmmsize;
+	ma->ma_valid = 0;
+	rc = mdt_stripe_get(info, obj, ma, XATTR_NAME_LMV);
+	mdt_object_put(info->mti_env, obj);
+	if (rc)
+		return rc;
+
+	if (!(ma->ma_valid & MA_LMV) ||
+	    le32_to_cpu(ma->ma_lmv->lmv_magic) != LMV_MAGIC_V1) {
+		*lmvp = NULL;
+		return 0;
+	}
+
+	*size = lmv_mds_md_size(le32_to_cpu(ma->ma_lmv->lmv_md_v1.
+					     lmv_stripe_count), LMV_MAGIC);
+	OBD_ALLOC_LARGE(*lmvp, *size);
+	if (!*lmvp)
+		return -ENOMEM;
+
+	memcpy(*lmvp, ma->ma_lmv, *size);
+	return 0;
+}
+
+/* migrate all dirents in old stripe \a sfid to new stripes of \a mfid */
+static int mdt_split_stripe(struct mdt_thread_info *info,
+			    const struct lu_fid *mfid,
+			    const struct lu_fid *sfid, struct page *page)
+{
+	const struct lu_env *env = info->mti_env;
+	struct mdt_reint_record *rr = &info->mti_rr;
+	struct lu_rdpg rdpg = {
+		.rp_count = LU_PAGE_SIZE,
+		.rp_npages = 1,
+		.rp_attrs = LUDA_FID | LUDA_64BITHASH,
+		.rp_pages = &page,
+	};
+	struct lu_dirpage *dp;
+	struct lu_dirent *ent;
+	struct mdt_object *stripe;
+	struct lu_fid fid;
+	__u64 hash = 0;
+	int failed = 0;
+	int rc = 0;
+
+	ENTRY;
+
+	stripe = mdt_object_find(env, info->mti_mdt, sfid);
+	if (IS_ERR(stripe))
+		RETURN(PTR_ERR(stripe));
+
+	while (hash != MDS_DIR_END_OFF) {
+		if (kthread_should_stop())
+			GOTO(out, rc = -EINTR);
+
+		rdpg.rp_hash = hash;
+		rc = mo_readpage(env, mdt_object_child(stripe), &rdpg);
+		if (rc < 0)
+			GOTO(out, rc);
+
+		dp = kmap(page);
+		hash = le64_to_cpu(dp->ldp_hash_end);
+		for (ent = lu_dirent_start(dp); ent;
+		     ent = lu_dirent_next(ent)) {
+			struct lu_name lname = {
+				.ln_name = ent->lde_name,
+				.ln_namelen = le16_to_cpu(ent->lde_namelen),
+			};
+
+			if (!lname.ln_namelen ||
+			    lu_name_is_dot_or_dotdot(&lname))
+				continue;
+
+			snprintf(info->mti_filename,
+				 sizeof(info->mti_filename), "%.*s",
+				 lname.ln_namelen, lname.ln_name);
+			fid_le_to_cpu(&fid, &ent->lde_fid);
+
+			mdt_split_info_reset(info);
+			rr->rr_fid1 = mfid;
+			rr->rr_fid2 = &fid;
+			rr->rr_name.ln_name = info->mti_filename;
+			rr->rr_name.ln_namelen = lname.ln_namelen;
+			info->mti_spec.sp_migrate_nsonly = 1;
+
+			rc = mdt_dir_split_migrate(info);
+			/* migrated by others already */
+			if (rc == -EALREADY || rc == -ENOENT)
+				rc = 0;
+			if (rc) {
+				CDEBUG(D_INFO, "%s: migrate "DFID"/"DNAME
+				       " failed: rc = %d\n",
+				       mdt_obd_name(info->mti_mdt), PFID(mfid),
+				       PNAME(&rr->rr_name), rc);
+				failed++;
+			}
+		}
+		kunmap(page);
+	}
+
+	rc = failed ? -EBUSY : 0;
+	EXIT;
+out:
+	mdt_object_put(env, stripe);
+	return rc;
+}
+
+/* split directory \a fid, which may be a stripe of striped directory */
+static int mdt_split_dir(struct mdt_thread_info *info,
+			 const struct lu_fid *fid, struct page *page,
+			 char *name)
+{
+	struct mdt_device *mdt = info->mti_mdt;
+	struct mdt_split_queue *msq = &mdt->mdt_split;
+	struct mdt_reint_record *rr = &info->mti_rr;
+	struct lmv_user_md_v1 lmu = { 0 };
+	struct lmv_mds_md_v1 *lmv = NULL;
+	struct lu_name lname;
+	struct lu_fid dfid;
+	struct lu_fid pfid;
+	struct lu_fid sfid;
+	struct lu_fid tfid;
+	int size = 0;
+	int rc;
+	int i;
+
+	ENTRY;
+
+	rc = mdt_split_master_fid(info, fid, &dfid);
+	if (rc)
+		RETURN(rc);
+
+	/* master should be local */
+	rc = mdt_split_master_fid(info, &dfid, &tfid);
+	if (rc)
+		RETURN(rc);
+
+	rc = mdt_split_parent_get(info, &dfid, &pfid, &lname, name);
+	if (rc)
+		RETURN(rc);
+
+	rc = seq_client_alloc_fid(info->mti_env, msq->msq_seq, &tfid);
+	if (rc < 0)
+		RETURN(rc);
+
+	/* step 1: migrate directory to a new layout with more stripes */
+	mdt_split_info_reset(info);
+	rr->rr_fid1 = &pfid;
+	rr->rr_fid2 = &tfid;
+	rr->rr_name = lname;
+	lmu.lum_magic = cpu_to_le32(LMV_USER_MAGIC);
+	lmu.lum_stripe_offset = cpu_to_le32(mdt_seq_site(mdt)->ss_node_id);
+	info->mti_spec.u.sp_ea.eadata = &lmu;
+	info->mti_spec.u.sp_ea.eadatalen = sizeof(lmu);
+	info->mti_spec.sp_cr_flags |= MDS_OPEN_HAS_EA;
+	info->mti_spec.sp_dir_split = 1;
+
+	rc = mdt_dir_split_migrate(info);
+	if (rc == -EALREADY)
+		RETURN(0);
+	if (rc)
+		RETURN(rc);
+
+	CDEBUG(D_INFO, "%s: split "DFID"/"DNAME" to "DFID"\n",
+	       mdt_obd_name(mdt), PFID(&pfid), PNAME(&lname), PFID(&tfid));
+
+	rc = mdt_split_lmv_get(info, &tfid, &lmv, &size);
+	if (rc)
+		RETURN(rc);
+
+	if (!lmv ||
+	    !(le32_to_cpu(lmv->lmv_hash_type) & LMV_HASH_FLAG_MIGRATION))
+		GOTO(out, rc = -EINVAL);
+
+	/* step 2: migrate dirents of old stripes */
+	for (i = le32_to_cpu(lmv->lmv_migrate_offset);
+	     i < le32_to_cpu(lmv->lmv_stripe_count); i++) {
+		fid_le_to_cpu(&sfid, &lmv->lmv_stripe_fids[i]);
+		rc = mdt_split_stripe(info, &tfid, &sfid, page);
+		if (rc == -EINTR)
+			GOTO(out, rc);
+	}
+
+	/* step 3: shrink layout, which fails if old stripes are not empty */
+	mdt_split_info_reset(info);
+	memset(&lmu, 0, sizeof(lmu));
+	lmu.lum_magic = cpu_to_le32(LMV_USER_MAGIC);
+	lmu.lum_stripe_count = lmv->lmv_migrate_offset;
+	lmu.lum_stripe_offset = lmv->lmv_master_mdt_index;
+	lmu.lum_hash_type = lmv->lmv_hash_type &
+			    cpu_to_le32(LMV_HASH_TYPE_MASK);
+	rr->rr_fid1 = &tfid;
+	rr->rr_eadata = &lmu;
+	rr->rr_eadatalen = sizeof(lmu);
+	rc = mdt_dir_layout_shrink(info);
+	if (rc)
+		CWARN("%s: split "DFID"/"DNAME" is not finished, run 'lfs "
+		      "migrate -m %u -c %u "DNAME"' to finish it: rc = %d\n",
+		      mdt_obd_name(mdt), PFID(&pfid), PNAME(&lname),
+		      le32_to_cpu(lmv->lmv_master_mdt_index),
+		      le32_to_cpu(lmv->lmv_migrate_offset), PNAME(&lname), rc);
+	EXIT;
+out:
+	OBD_FREE_LARGE(lmv, size);
+	return rc;
+}
+
+static int mdt_dir_split_thread(void *data)
+{
+	struct mdt_device *mdt = data;
+	struct mdt_split_queue *msq = &mdt->mdt_split;
+	struct mdt_split_item *msi;
+	struct mdt_thread_info *info;
+	struct lu_context session;
+	struct lu_env env;
+	struct page *page = NULL;
+	char *name = NULL;
+	int rc;
+
+	ENTRY;
+
+	rc = lu_env_init(&env, LCT_MD_THREAD);
+	if (rc)
+		GOTO(out, rc);
+
+	/* for mdt_ucred(), lu_ucred stored in lu_ucred_key */
+	rc = lu_context_init(&session, LCT_SERVER_SESSION);
+	if (rc)
+		GOTO(out_env, rc);
+
+	lu_context_enter(&session);
+	env.le_ses = &session;
+
+	info = lu_context_key_get(&env.le_ctx, &mdt_thread_key);
+	LASSERT(info);
+	info->mti_env = &env;
+	info->mti_mdt = mdt;
+	info->mti_pill = NULL;
+	info->mti_exp = NULL;
+	info->mti_object = NULL;
+	info->mti_big_buf = LU_BUF_NULL;
+	mdt_split_init_ucred(mdt_ucred(info));
+
+	OBD_ALLOC(name, NAME_MAX + 1);
+	if (!name)
+		GOTO(out_session, rc = -ENOMEM);
+
+	page = alloc_page(GFP_KERNEL);
+	if (!page)
+		GOTO(out_name, rc = -ENOMEM);
+
+	while (!kthread_should_stop()) {
+		wait_event_interruptible(msq->msq_waitq,
+					 kthread_should_stop() ||
+					 !list_empty(&msq->msq_list));
+
+		msi = NULL;
+		spin_lock(&msq->msq_lock);
+		if (!list_empty(&msq->msq_list)) {
+			msi = list_entry(msq->msq_list.next,
+					 struct mdt_split_item, msi_linkage);
+			list_del(&msi->msi_linkage);
+			msq->msq_count--;
+		}
+		spin_unlock(&msq->msq_lock);
+
+		if (!msi)
+			continue;
+
+		rc = mdt_split_dir(info, &msi->msi_fid, page, name);
+		if (rc && rc != -EREMOTE && rc != -ENOENT)
+			CDEBUG(D_INFO, "%s: split "DFID" failed: rc = %d\n",
+			       mdt_obd_name(mdt), PFID(&msi->msi_fid), rc);
+		OBD_FREE_PTR(msi);
+	}
+
+	__free_page(page);
+	lu_buf_free(&info->mti_big_buf);
+	rc = 0;
+out_name:
+	OBD_FREE(name, NAME_MAX + 1);
+out_session:
+	lu_context_exit(&session);
+	lu_context_fini(&session);
+out_env:
+	lu_env_fini(&env);
+out:
+	/* kthread_stop() expects thread is still running */
+	while (!kthread_should_stop())
+		wait_event_interruptible(msq->msq_waitq,
+					 kthread_should_stop());
+
+	RETURN(rc);
+}
+
+/**
+ * Queue directory \a fid to split.
+ *
+ * It's called after create, which is not blocked, and the queue is bounded,
+ * later request is dropped if it's full, since directory will be checked
+ * again when it grows more.
+ */
+void mdt_dir_split_add(struct mdt_device *mdt, const struct lu_fid *fid)
+{
+	struct mdt_split_queue *msq = &mdt->mdt_split;
+	struct obd_device *obd = mdt2obd_dev(mdt);
+	struct mdt_split_item *msi;
+	struct mdt_split_item *tmp;
+
+	if (!msq->msq_task || obd->obd_recovering || mdt->mdt_bottom->dd_rdonly)
+		return;
+
+	OBD_ALLOC_PTR(msi);
+	if (!msi)
+		return;
+
+	INIT_LIST_HEAD(&msi->msi_linkage);
+	msi->msi_fid = *fid;
+
+	spin_lock(&msq->msq_lock);
+	if (msq->msq_count >= MDT_SPLIT_QUEUE_MAX)
+		goto unlock;
+
+	list_for_each_entry(tmp, &msq->msq_list, msi_linkage) {
+		if (lu_fid_eq(&tmp->msi_fid, fid))
+			goto unlock;
+	}
+
+	list_add_tail(&msi->msi_linkage, &msq->msq_list);
+	msq->msq_count++;
+	msi = NULL;
+unlock:
+	spin_unlock(&msq->msq_lock);
+
+	if (msi)
+		OBD_FREE_PTR(msi);
+	else
+		wake_up(&msq->msq_waitq);
+}
+
+int mdt_dir_split_init(struct mdt_device *mdt)
+{
+	struct mdt_split_queue *msq = &mdt->mdt_split;
+	struct task_struct *task;
+	char *prefix;
+	int rc;
+
+	ENTRY;
+
+	spin_lock_init(&msq->msq_lock);
+	INIT_LIST_HEAD(&msq->msq_list);
+	msq->msq_count = 0;
+	init_waitqueue_head(&msq->msq_waitq);
+	msq->msq_task = NULL;
+
+	OBD_ALLOC_PTR(msq->msq_seq);
+	if (!msq->msq_seq)
+		RETURN(-ENOMEM);
+
+	OBD_ALLOC(prefix, MAX_OBD_NAME + 7);
+	if (!prefix)
+		GOTO(out_free, rc = -ENOMEM);
+
+	snprintf(prefix, MAX_OBD_NAME + 7, "split-%s", mdt_obd_name(mdt));
+	rc = seq_client_init(msq->msq_seq, NULL, LUSTRE_SEQ_METADATA, prefix,
+			     mdt_seq_site(mdt)->ss_server_seq);
+	OBD_FREE(prefix, MAX_OBD_NAME + 7);
+	if (rc)
+		GOTO(out_free, rc);
+
+	task = kthread_run(mdt_dir_split_thread, mdt, "mdt%04x_split",
+			   mdt_seq_site(mdt)->ss_node_id);
+	if (IS_ERR(task)) {
+		rc = PTR_ERR(task);
+		CERROR("%s: cannot start directory split thread: rc = %d\n",
+		       mdt_obd_name(mdt), rc);
+		GOTO(out_seq, rc);
+	}
+
+	msq->msq_task = task;
+	RETURN(0);
+
+out_seq:
+	seq_client_fini(msq->msq_seq);
+out_free:
+	OBD_FREE_PTR(msq->msq_seq);
+	msq->msq_seq = NULL;
+	return rc;
+}
+
+void mdt_dir_split_fini(struct mdt_device *mdt)
+{
+	struct mdt_split_queue *msq = &mdt->mdt_split;
+	struct mdt_split_item *msi;
+	struct mdt_split_item *tmp;
+
+	ENTRY;
+
+	if (msq->msq_task) {
+		kthread_stop(msq->msq_task);
+		msq->msq_task = NULL;
+	}
+
+	list_for_each_entry_safe(msi, tmp, &msq->msq_list, msi_linkage) {
+		list_del(&msi->msi_linkage);
+		OBD_FREE_PTR(msi);
+	}
+	msq->msq_count = 0;
+
+	if (msq->msq_seq) {
+		seq_client_fini(msq->msq_seq);
+		OBD_FREE_PTR(msq->msq_seq);
+		msq->msq_seq = NULL;
+	}
+
+	EXIT;
+}
@@ -112,6 +112,7 @@ void cl_io_fini(const struct lu_env *env, struct cl_io *io)
 	case CIT_WRITE:
 	case CIT_DATA_VERSION:
 	case CIT_FAULT:
+	case CIT_FALLOCATE:
 		break;
 	case CIT_FSYNC:
 		LASSERT(!io->ci_need_restart);
@@ -991,6 +992,33 @@ void cl_page_list_fini(const struct lu_env *env, struct cl_page_list *plist)
 }
 EXPORT_SYMBOL(cl_page_list_fini);
 
+/**
+ * Deletes and releases pages whose transfer has completed.
+ *
+ * Unlike cl_page_list_fini() this can be called from a thread other than
+ * the one that built the list, such as ptlrpcd completing an asynchronous
+ * direct I/O, as the pages are neither owned nor VM locked at that point.
+ */
+void cl_page_list_delete(const struct lu_env *env, struct cl_page_list *plist)
+{
+	struct cl_page *page;
+	struct cl_page *temp;
+
+	ENTRY;
+	cl_page_list_for_each_safe(page, temp, plist) {
+		LASSERT(plist->pl_nr > 0);
+
+		list_del_init(&page->cp_batch);
+		--plist->pl_nr;
+		cl_page_delete(env, page);
+		lu_ref_del_at(&page->cp_reference, &page->cp_queue_ref, "queue",
+			      plist);
+		cl_page_put(env, page);
+	}
+	EXIT;
+}
+EXPORT_SYMBOL(cl_page_list_delete);
+
 /**
  * Assumes all pages in a queue.
  */
@@ -834,6 +834,38 @@ void cl_page_touch(const struct lu_env *env, const struct cl_page *pg,
 }
 EXPORT_SYMBOL(cl_page_touch);
 
+/**
+ * Prepares a cached page for a fast write, without a cl_io.
+ *
+ * The page has to be VM locked, up to date and not under writeback. Every
+ * layer implementing ->cpo_fast_write() has to agree, and one of them has
+ * to, for the page to be written without the full cl_io.
+ *
+ * \see cl_page_operations::cpo_fast_write()
+ */
+int cl_page_fast_write(const struct lu_env *env, struct cl_page *pg,
+		       bool append)
+{
+	const struct cl_page_slice *slice;
+	int result = -ENODATA;
+
+	ENTRY;
+
+	PINVRNT(env, pg, cl_page_is_vmlocked(env, pg));
+
+	list_for_each_entry(slice, &pg->cp_layers, cpl_linkage) {
+		if (slice->cpl_ops->cpo_fast_write == NULL)
+			continue;
+
+		result = (*slice->cpl_ops->cpo_fast_write)(env, slice, append);
+		if (result != 0)
+			break;
+	}
+
+	RETURN(result);
+}
+EXPORT_SYMBOL(cl_page_fast_write);
+
 static enum cl_page_state cl_req_type_state(enum cl_req_type crt)
 {
         ENTRY;
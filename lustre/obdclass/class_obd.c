@@ -47,6 +47,7 @@
 #include <lustre_kernelcomm.h>
 #include <lprocfs_status.h>
 #include <cl_object.h>
+#include <obd_compr.h>
 #ifdef HAVE_SERVER_SUPPORT
 # include <dt_object.h>
 # include <md_object.h>
@@ -704,6 +705,10 @@ static int __init obdclass_init(void)
 		goto cleanup_cl_global;
 #endif /* HAVE_SERVER_SUPPORT */
 
+	err = obd_compr_init();
+	if (err)
+		goto cleanup_llog_info;
+
 	err = lustre_register_fs();
 
 	/* simulate a late OOM situation now to require all
@@ -716,10 +721,13 @@ static int __init obdclass_init(void)
 	}
 
 	if (err)
-		goto cleanup_llog_info;
+		goto cleanup_obd_compr;
 
 	return 0;
 
+cleanup_obd_compr:
+	obd_compr_fini();
+
 cleanup_llog_info:
 	llog_info_fini();
 
@@ -773,6 +781,104 @@ void obd_update_maxusage(void)
 }
 EXPORT_SYMBOL(obd_update_maxusage);
 
+/* The heat is decayed by 1 - weight/256 each period, see obd_heat_decay() */
+#define OBD_HEAT_WEIGHT_SHIFT	8
+#define OBD_HEAT_WEIGHT_MAX	(1 << OBD_HEAT_WEIGHT_SHIFT)
+
+/*
+ * Update heat of @instance up to @time_second.
+ *
+ * For every elapsed period, the heat is recalculated as
+ *
+ *	H = H * (1 - w) + C * w
+ *
+ * where w = @weight / 256 and C is the number of samples counted during
+ * that period. Periods without samples only decay the heat, and decaying
+ * stops once it reaches zero, so a long idle time is cheap.
+ */
+void obd_heat_decay(struct obd_heat_instance *instance,
+		    __u64 time_second, unsigned int weight,
+		    unsigned int period_second)
+{
+	u64 second;
+
+	ENTRY;
+
+	if (instance->ohi_time_second > time_second) {
+		obd_heat_clear(instance, 1);
+		RETURN_EXIT;
+	}
+
+	if (instance->ohi_time_second == 0)
+		RETURN_EXIT;
+
+	if (weight > OBD_HEAT_WEIGHT_MAX)
+		weight = OBD_HEAT_WEIGHT_MAX;
+
+	for (second = instance->ohi_time_second + period_second;
+	     second < time_second;
+	     second += period_second) {
+		instance->ohi_heat = instance->ohi_heat *
+			(OBD_HEAT_WEIGHT_MAX - weight) / OBD_HEAT_WEIGHT_MAX +
+			instance->ohi_count * weight / OBD_HEAT_WEIGHT_MAX;
+		instance->ohi_count = 0;
+		instance->ohi_time_second = second;
+		if (instance->ohi_heat == 0) {
+			/* nothing left to decay, skip the idle periods */
+			second = time_second - (time_second - second) %
+				 period_second;
+			instance->ohi_time_second = second;
+			break;
+		}
+	}
+	EXIT;
+}
+EXPORT_SYMBOL(obd_heat_decay);
+
+__u64 obd_heat_get(struct obd_heat_instance *instance,
+		   __u64 time_second, unsigned int weight,
+		   unsigned int period_second)
+{
+	ENTRY;
+
+	obd_heat_decay(instance, time_second, weight, period_second);
+
+	if (instance->ohi_count == 0)
+		RETURN(instance->ohi_heat);
+
+	RETURN(instance->ohi_heat * (OBD_HEAT_WEIGHT_MAX - weight) /
+	       OBD_HEAT_WEIGHT_MAX +
+	       instance->ohi_count * weight / OBD_HEAT_WEIGHT_MAX);
+}
+EXPORT_SYMBOL(obd_heat_get);
+
+void obd_heat_add(struct obd_heat_instance *instance,
+		  __u64 time_second, __u64 count,
+		  unsigned int weight, unsigned int period_second)
+{
+	ENTRY;
+
+	obd_heat_decay(instance, time_second, weight, period_second);
+	if (instance->ohi_time_second == 0) {
+		instance->ohi_time_second = time_second;
+		instance->ohi_heat = 0;
+		instance->ohi_count = count;
+	} else {
+		instance->ohi_count += count;
+	}
+	EXIT;
+}
+EXPORT_SYMBOL(obd_heat_add);
+
+void obd_heat_clear(struct obd_heat_instance *instance, int count)
+{
+	ENTRY;
+
+	memset(instance, 0, sizeof(*instance) * count);
+	EXIT;
+}
+EXPORT_SYMBOL(obd_heat_clear);
+
 #ifdef CONFIG_PROC_FS
 __u64 obd_memory_max(void)
 {
@@ -798,6 +904,7 @@ static void __exit obdclass_exit(void)
 	lustre_unregister_fs();
 
 	misc_deregister(&obd_psdev);
+	obd_compr_fini();
 	llog_info_fini();
 #ifdef HAVE_SERVER_SUPPORT
 	lu_ucred_global_fini();
@@ -422,6 +422,9 @@ int llog_init_handle(const struct lu_env *env, struct llog_handle *handle,
 	if (flags & LLOG_F_IS_CAT) {
 		LASSERT(list_empty(&handle->u.chd.chd_head));
 		INIT_LIST_HEAD(&handle->u.chd.chd_head);
+		spin_lock_init(&handle->u.chd.chd_chlg_lock);
+		memset(&handle->u.chd.chd_chlg_filter, 0,
+		       sizeof(handle->u.chd.chd_chlg_filter));
 		llh->llh_size = sizeof(struct llog_logid_rec);
 		llh->llh_flags |= LLOG_F_IS_FIXSIZE;
 	} else if (!(flags & LLOG_F_IS_PLAIN)) {
@@ -1439,3 +1442,54 @@ __u64 llog_size(const struct lu_env *env, struct llog_handle *llh)
 }
 EXPORT_SYMBOL(llog_size);
 
+/**
+ * Check whether a changelog record targets or references a given FID.
+ */
+static bool llog_chlg_rec_has_fid(const struct changelog_rec *cr,
+				  const struct lu_fid *fid)
+{
+	struct changelog_ext_rename *rnm;
+
+	if (lu_fid_eq(fid, &cr->cr_tfid) || lu_fid_eq(fid, &cr->cr_pfid))
+		return true;
+
+	if (!(cr->cr_flags & CLF_RENAME))
+		return false;
+
+	rnm = changelog_rec_rename(cr);
+	return lu_fid_eq(fid, &rnm->cr_sfid) || lu_fid_eq(fid, &rnm->cr_spfid);
+}
+
+/**
+ * Check whether a changelog record passes a reader filter.
+ *
+ * Records without user information are always delivered to readers
+ * filtering on UID, so that nothing is silently lost on MDTs that do not
+ * log it.
+ *
+ * \param[in] lcf	reader filter
+ * \param[in] cr	changelog record to check
+ *
+ * \retval		true if the record should be delivered
+ * \retval		false otherwise
+ */
+bool llog_chlg_filter_match(const struct llogd_chlg_filter *lcf,
+			    const struct changelog_rec *cr)
+{
+	if (lcf->lcf_type_mask != 0 && cr->cr_type < CL_LAST &&
+	    !(lcf->lcf_type_mask & (1U << cr->cr_type)))
+		return false;
+
+	if (!fid_is_zero(&lcf->lcf_fid) &&
+	    !llog_chlg_rec_has_fid(cr, &lcf->lcf_fid))
+		return false;
+
+	if (lcf->lcf_flags & LCF_UID && cr->cr_flags & CLF_EXTRA_FLAGS &&
+	    changelog_rec_extra_flags(cr)->cr_extra_flags & CLFE_UIDGID &&
+	    changelog_rec_uidgid(cr)->cr_uid != lcf->lcf_uid)
+		return false;
+
+	return true;
+}
+EXPORT_SYMBOL(llog_chlg_filter_match);
+
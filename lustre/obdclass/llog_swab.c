@@ -99,6 +99,15 @@ void lustre_swab_llogd_body (struct llogd_body *d)
 }
 EXPORT_SYMBOL(lustre_swab_llogd_body);
 
+void lustre_swab_llogd_chlg_filter(struct llogd_chlg_filter *f)
+{
+	__swab32s(&f->lcf_type_mask);
+	__swab32s(&f->lcf_flags);
+	__swab32s(&f->lcf_uid);
+	lustre_swab_lu_fid(&f->lcf_fid);
+}
+EXPORT_SYMBOL(lustre_swab_llogd_chlg_filter);
+
 void lustre_swab_llogd_conn_body (struct llogd_conn_body *d)
 {
 	__swab64s(&d->lgdc_gen.mnt_cnt);
@@ -782,7 +782,15 @@ static const char *obd_connect_names[] = {
 	"wbc",		/* 0x40 */
 	"lock_convert",  /* 0x80 */
 	"archive_id_array",	/* 0x100 */
-	"selinux_policy",	/* 0x200 */
+	"unknown",	/* 0x200 */
+	"selinux_policy",	/* 0x400 */
+	"compress",	/* 0x800 */
+	"batch_rpc",	/* 0x1000 */
+	"batch_bl_ast",	/* 0x2000 */
+	"extent_shrink",	/* 0x4000 */
+	"dir_placement",	/* 0x8000 */
+	"jump_hash",	/* 0x10000 */
+	"chlg_filter",	/* 0x20000 */
 	NULL
 };
 
@@ -914,6 +922,10 @@ obd_connect_data_seqprint(struct seq_file *m, struct obd_connect_data *ocd)
 	if (flags & OBD_CONNECT_MULTIMODRPCS)
 		seq_printf(m, "       max_mod_rpcs: %hu\n",
 			   ocd->ocd_maxmodrpcs);
+	if (flags & OBD_CONNECT_FLAGS2 &&
+	    ocd->ocd_connect_flags2 & OBD_CONNECT2_COMPRESS)
+		seq_printf(m, "       compr_types: %#hx\n",
+			   ocd->ocd_compr_types);
 }
 
 int lprocfs_import_seq_show(struct seq_file *m, void *data)
@@ -0,0 +1,444 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * Bulk data compression functions, see obd_compr.h
+ */
+
+#define DEBUG_SUBSYSTEM S_CLASS
+
+#include <linux/crypto.h>
+#include <linux/highmem.h>
+#include <linux/percpu.h>
+#include <obd_class.h>
+#include <obd_compr.h>
+
+/* Entries of compr_name[] */
+#define OBD_COMPR_NR		3
+/* Room for the worst case expansion of a chunk by any of the algorithms,
+ * LZO does not check the size of its output buffer */
+#define OBD_COMPR_BUF_SIZE	(OBD_COMPR_CHUNK_SIZE + \
+				 OBD_COMPR_CHUNK_SIZE / 16 + 64 + 3)
+
+/*
+ * Compression contexts, one per CPU. The crypto transforms keep their
+ * workspace in the context, so each is used by a single thread at a time;
+ * the mutex rather than disabling preemption lets a thread sleep or be
+ * migrated while it compresses. Transforms and buffers are set up on first
+ * use, so nodes that never compress do not pay for them.
+ */
+struct obd_compr_cpu {
+	struct mutex		 occ_mutex;
+	struct crypto_comp	*occ_tfm[OBD_COMPR_NR];
+	/* one chunk of niobuf data, and its compressed copy */
+	char			*occ_raw;
+	char			*occ_buf;
+};
+
+static struct obd_compr_cpu __percpu *obd_compr_cpus;
+static enum obd_compr_types obd_compr_supported;
+
+/* Iterator over the niobuf data of an RPC */
+struct obd_compr_iter {
+	void			*oci_array;
+	int			 oci_count;
+	obd_compr_page_f	 oci_page_from;
+	int			 oci_idx;	/* current page */
+	unsigned int		 oci_done;	/* bytes done in it */
+};
+
+static inline int obd_compr_type2idx(enum obd_compr_types compr_type)
+{
+	return ffs(compr_type) - 1;
+}
+
+static struct obd_compr_cpu *
+obd_compr_cpu_get(enum obd_compr_types compr_type)
+{
+	struct obd_compr_cpu *occ;
+	struct crypto_comp *tfm;
+	int idx = obd_compr_type2idx(compr_type);
+	DECLARE_COMPR_NAME;
+
+	if (!(compr_type & obd_compr_supported) ||
+	    hweight32(compr_type) != 1)
+		return ERR_PTR(-EOPNOTSUPP);
+
+	occ = per_cpu_ptr(obd_compr_cpus, raw_smp_processor_id());
+	mutex_lock(&occ->occ_mutex);
+
+	if (occ->occ_raw == NULL) {
+		OBD_ALLOC_LARGE(occ->occ_raw, OBD_COMPR_CHUNK_SIZE);
+		if (occ->occ_raw == NULL)
+			GOTO(out_unlock, tfm = ERR_PTR(-ENOMEM));
+	}
+
+	if (occ->occ_buf == NULL) {
+		OBD_ALLOC_LARGE(occ->occ_buf, OBD_COMPR_BUF_SIZE);
+		if (occ->occ_buf == NULL)
+			GOTO(out_unlock, tfm = ERR_PTR(-ENOMEM));
+	}
+
+	if (occ->occ_tfm[idx] == NULL) {
+		tfm = crypto_alloc_comp(compr_name[idx], 0, 0);
+		if (IS_ERR(tfm)) {
+			CERROR("cannot allocate %s compression: rc = %ld\n",
+			       compr_name[idx], PTR_ERR(tfm));
+			GOTO(out_unlock, tfm);
+		}
+		occ->occ_tfm[idx] = tfm;
+	}
+
+	return occ;
+
+out_unlock:
+	mutex_unlock(&occ->occ_mutex);
+	return ERR_CAST(tfm);
+}
+
+static inline void obd_compr_cpu_put(struct obd_compr_cpu *occ)
+{
+	mutex_unlock(&occ->occ_mutex);
+}
+
+/*
+ * Copy up to \a len bytes between \a buf and the niobuf data under \a iter,
+ * from the pages if \a to_pages is false.
+ *
+ * \retval the number of bytes copied, less than \a len at the end of data
+ */
+static int obd_compr_iter_copy(struct obd_compr_iter *iter, char *buf,
+			       int len, bool to_pages)
+{
+	int done = 0;
+
+	while (done < len && iter->oci_idx < iter->oci_count) {
+		struct page *page;
+		unsigned int offset;
+		unsigned int count;
+		char *addr;
+		int n;
+
+		page = iter->oci_page_from(iter->oci_array, iter->oci_idx,
+					   &offset, &count);
+		n = min_t(int, count - iter->oci_done, len - done);
+
+		addr = ll_kmap_atomic(page, KM_USER0);
+		if (to_pages)
+			memcpy(addr + offset + iter->oci_done, buf + done, n);
+		else
+			memcpy(buf + done, addr + offset + iter->oci_done, n);
+		ll_kunmap_atomic(addr, KM_USER0);
+
+		done += n;
+		iter->oci_done += n;
+		if (iter->oci_done == count) {
+			iter->oci_idx++;
+			iter->oci_done = 0;
+		}
+	}
+
+	return done;
+}
+
+/* Copy \a len bytes between \a buf and offset \a pos of a page stream */
+static void obd_compr_stream_copy(struct page **stream, size_t pos, char *buf,
+				  size_t len, bool to_stream)
+{
+	while (len > 0) {
+		unsigned int offset = pos & ~PAGE_MASK;
+		size_t n = min_t(size_t, PAGE_SIZE - offset, len);
+		char *addr;
+
+		addr = ll_kmap_atomic(stream[pos >> PAGE_SHIFT], KM_USER0);
+		if (to_stream)
+			memcpy(addr + offset, buf, n);
+		else
+			memcpy(buf, addr + offset, n);
+		ll_kunmap_atomic(addr, KM_USER0);
+
+		buf += n;
+		pos += n;
+		len -= n;
+	}
+}
+
+/**
+ * Compress the \a count pages of niobuf data in \a array into the
+ * \a stream_pages pages of \a stream.
+ *
+ * Chunks that do not shrink are stored uncompressed in the stream.
+ *
+ * \retval the number of bytes of the stream on success
+ * \retval -EOVERFLOW if the data does not fit into the stream, the caller
+ *	   should then send the data uncompressed
+ * \retval negative errno on other errors
+ */
+int obd_compress_pages(enum obd_compr_types compr_type, void *array,
+		       int count, obd_compr_page_f page_from,
+		       struct page **stream, int stream_pages)
+{
+	struct obd_compr_iter iter = {
+		.oci_array = array,
+		.oci_count = count,
+		.oci_page_from = page_from,
+	};
+	struct obd_compr_cpu *occ;
+	size_t size = (size_t)stream_pages << PAGE_SHIFT;
+	size_t pos = 0;
+	int idx = obd_compr_type2idx(compr_type);
+	int raw_len;
+	int rc = 0;
+
+	occ = obd_compr_cpu_get(compr_type);
+	if (IS_ERR(occ))
+		return PTR_ERR(occ);
+
+	while ((raw_len = obd_compr_iter_copy(&iter, occ->occ_raw,
+					      OBD_COMPR_CHUNK_SIZE,
+					      false)) > 0) {
+		struct brw_compr_chunk bcc;
+		unsigned int len = OBD_COMPR_BUF_SIZE;
+		char *data = occ->occ_buf;
+
+		rc = crypto_comp_compress(occ->occ_tfm[idx], occ->occ_raw,
+					  raw_len, occ->occ_buf, &len);
+		if (rc != 0 || len >= raw_len) {
+			len = raw_len;
+			data = occ->occ_raw;
+		}
+
+		if (pos + sizeof(bcc) + len > size)
+			GOTO(out, rc = -EOVERFLOW);
+
+		bcc.bcc_magic = cpu_to_le32(BRW_COMPR_MAGIC);
+		bcc.bcc_raw_len = cpu_to_le32(raw_len);
+		bcc.bcc_len = cpu_to_le32(len);
+		bcc.bcc_padding = 0;
+
+		obd_compr_stream_copy(stream, pos, (char *)&bcc, sizeof(bcc),
+				      true);
+		pos += sizeof(bcc);
+		obd_compr_stream_copy(stream, pos, data, len, true);
+		pos += len;
+	}
+	rc = pos;
+out:
+	obd_compr_cpu_put(occ);
+
+	return rc;
+}
+EXPORT_SYMBOL(obd_compress_pages);
+
+/**
+ * Decompress the \a stream_len bytes of \a stream into the \a count pages
+ * of niobuf data in \a array.
+ *
+ * \retval the number of bytes of niobuf data on success
+ * \retval -EPROTO if the stream is corrupted
+ * \retval negative errno on other errors
+ */
+int obd_decompress_pages(enum obd_compr_types compr_type,
+			 struct page **stream, int stream_len, void *array,
+			 int count, obd_compr_page_f page_from)
+{
+	struct obd_compr_iter iter = {
+		.oci_array = array,
+		.oci_count = count,
+		.oci_page_from = page_from,
+	};
+	struct obd_compr_cpu *occ;
+	int idx = obd_compr_type2idx(compr_type);
+	int total = 0;
+	int pos = 0;
+	int rc;
+
+	occ = obd_compr_cpu_get(compr_type);
+	if (IS_ERR(occ))
+		return PTR_ERR(occ);
+
+	while (pos < stream_len) {
+		struct brw_compr_chunk bcc;
+		unsigned int raw_len;
+		unsigned int len;
+
+		if (stream_len - pos < sizeof(bcc))
+			GOTO(out, rc = -EPROTO);
+
+		obd_compr_stream_copy(stream, pos, (char *)&bcc, sizeof(bcc),
+				      false);
+		pos += sizeof(bcc);
+
+		raw_len = le32_to_cpu(bcc.bcc_raw_len);
+		len = le32_to_cpu(bcc.bcc_len);
+		if (le32_to_cpu(bcc.bcc_magic) != BRW_COMPR_MAGIC ||
+		    raw_len > OBD_COMPR_CHUNK_SIZE || len > raw_len ||
+		    len > stream_len - pos) {
+			CERROR("bad compressed chunk at %d: magic %#x, raw_len %u, len %u\n",
+			       pos, le32_to_cpu(bcc.bcc_magic), raw_len, len);
+			GOTO(out, rc = -EPROTO);
+		}
+
+		if (len == raw_len) {
+			obd_compr_stream_copy(stream, pos, occ->occ_raw, len,
+					      false);
+		} else {
+			unsigned int dlen = OBD_COMPR_CHUNK_SIZE;
+
+			obd_compr_stream_copy(stream, pos, occ->occ_buf, len,
+					      false);
+			rc = crypto_comp_decompress(occ->occ_tfm[idx],
+						    occ->occ_buf, len,
+						    occ->occ_raw, &dlen);
+			if (rc != 0 || dlen != raw_len) {
+				CERROR("cannot decompress chunk at %d: raw_len %u/%u: rc = %d\n",
+				       pos, dlen, raw_len, rc);
+				GOTO(out, rc = -EPROTO);
+			}
+		}
+		pos += len;
+
+		if (obd_compr_iter_copy(&iter, occ->occ_raw, raw_len,
+					true) != raw_len)
+			GOTO(out, rc = -EPROTO);
+		total += raw_len;
+	}
+	rc = total;
+out:
+	obd_compr_cpu_put(occ);
+
+	return rc;
+}
+EXPORT_SYMBOL(obd_decompress_pages);
+
+/**
+ * Copy the niobuf data in \a array to or from the first \a stream_len bytes
+ * of \a stream as it is. This is used when the data of an RPC does not
+ * compress, but the bulk has been set up for a compressed stream already.
+ *
+ * \retval the number of bytes copied
+ */
+int obd_compr_copy_pages(struct page **stream, int stream_len, void *array,
+			 int count, obd_compr_page_f page_from,
+			 bool to_stream)
+{
+	struct obd_compr_iter iter = {
+		.oci_array = array,
+		.oci_count = count,
+		.oci_page_from = page_from,
+	};
+	int pos = 0;
+
+	while (pos < stream_len) {
+		struct page *page = stream[pos >> PAGE_SHIFT];
+		int len = min_t(int, PAGE_SIZE, stream_len - pos);
+		int n;
+
+		/* not atomic, the iterator maps the niobuf pages atomically */
+		n = obd_compr_iter_copy(&iter, kmap(page), len, !to_stream);
+		kunmap(page);
+
+		pos += n;
+		if (n < len)
+			break;
+	}
+
+	return pos;
+}
+EXPORT_SYMBOL(obd_compr_copy_pages);
+
+/* Return the bitmask of the compression algorithms supported by this node */
+enum obd_compr_types obd_compr_types_supported(void)
+{
+	return obd_compr_supported;
+}
+EXPORT_SYMBOL(obd_compr_types_supported);
+
+/*
+ * The OBD_FL_COMPR_* flags are packed into 2 bits of o_flags, since there
+ * can only be a single compression type per RPC, while the OBD_COMPR_*
+ * bits passed in ocd_compr_types are a mask of the algorithms both sides
+ * understand.
+ *
+ * In case multiple algorithms are supported the fastest one is used, they
+ * are defined from the fastest to the most compact.
+ *
+ * \retval OBD_FL_COMPR_* flag, 0 if no algorithm is usable
+ */
+u32 obd_compr_type_pack(enum obd_compr_types compr_types)
+{
+	compr_types &= obd_compr_supported;
+
+	if (compr_types & OBD_COMPR_LZ4)
+		return OBD_FL_COMPR_LZ4;
+	if (compr_types & OBD_COMPR_LZO)
+		return OBD_FL_COMPR_LZO;
+	if (compr_types & OBD_COMPR_DEFLATE)
+		return OBD_FL_COMPR_DEFLATE;
+
+	return 0;
+}
+EXPORT_SYMBOL(obd_compr_type_pack);
+
+int obd_compr_init(void)
+{
+	int cpu;
+	int i;
+	DECLARE_COMPR_NAME;
+
+	obd_compr_cpus = alloc_percpu(struct obd_compr_cpu);
+	if (obd_compr_cpus == NULL)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu)
+		mutex_init(&per_cpu_ptr(obd_compr_cpus, cpu)->occ_mutex);
+
+	for (i = 0; i < ARRAY_SIZE(compr_name); i++) {
+		if (crypto_has_comp(compr_name[i], 0, 0))
+			obd_compr_supported |= 1 << i;
+	}
+	CDEBUG(D_INFO, "supported compression types: %#x\n",
+	       obd_compr_supported);
+
+	return 0;
+}
+
+void obd_compr_fini(void)
+{
+	int cpu;
+	int i;
+
+	for_each_possible_cpu(cpu) {
+		struct obd_compr_cpu *occ = per_cpu_ptr(obd_compr_cpus, cpu);
+
+		for (i = 0; i < ARRAY_SIZE(occ->occ_tfm); i++) {
+			if (occ->occ_tfm[i] != NULL)
+				crypto_free_comp(occ->occ_tfm[i]);
+		}
+		if (occ->occ_raw != NULL)
+			OBD_FREE_LARGE(occ->occ_raw, OBD_COMPR_CHUNK_SIZE);
+		if (occ->occ_buf != NULL)
+			OBD_FREE_LARGE(occ->occ_buf, OBD_COMPR_BUF_SIZE);
+	}
+	free_percpu(obd_compr_cpus);
+}
@@ -68,6 +68,7 @@
 
 #define DEBUG_SUBSYSTEM S_FILTER
 
+#include <linux/falloc.h>
 #include <obd_class.h>
 #include <obd_cksum.h>
 #include <uapi/linux/lustre/lustre_param.h>
@@ -2031,6 +2032,93 @@ out:
 	return rc;
 }
 
+/**
+ * OFD request handler for OST_FALLOCATE RPC.
+ *
+ * This is part of request processing. Validate request fields,
+ * preallocate space for the given range of the OFD object and pack reply.
+ *
+ * \param[in] tsi	target session environment for this request
+ *
+ * \retval		0 if successful
+ * \retval		negative value on error
+ */
+static int ofd_fallocate_hdl(struct tgt_session_info *tsi)
+{
+	const struct obdo	*oa = &tsi->tsi_ost_body->oa;
+	struct ost_body		*repbody;
+	struct ofd_thread_info	*info = tsi2ofd_info(tsi);
+	struct ldlm_namespace	*ns = tsi->tsi_tgt->lut_obd->obd_namespace;
+	struct ldlm_resource	*res;
+	struct ofd_object	*fo;
+	__u64			 start, end;
+	int			 mode;
+	int			 rc;
+
+	ENTRY;
+
+	if ((oa->o_valid & (OBD_MD_FLSIZE | OBD_MD_FLBLOCKS)) !=
+	    (OBD_MD_FLSIZE | OBD_MD_FLBLOCKS))
+		RETURN(err_serious(-EPROTO));
+
+	repbody = req_capsule_server_get(tsi->tsi_pill, &RMF_OST_BODY);
+	if (repbody == NULL)
+		RETURN(err_serious(-ENOMEM));
+
+	/* fallocate start,end are passed in o_size,o_blocks as for punch */
+	start = oa->o_size;
+	end = oa->o_blocks;
+	mode = oa->o_falloc_mode;
+
+	/* only plain preallocation is supported, no hole punching */
+	if (mode & ~FALLOC_FL_KEEP_SIZE)
+		RETURN(-EOPNOTSUPP);
+
+	if (end <= start || end == OBD_OBJECT_EOF)
+		RETURN(-EINVAL);
+
+	repbody->oa.o_oi = oa->o_oi;
+	repbody->oa.o_valid = OBD_MD_FLID;
+
+	CDEBUG(D_INODE, "calling fallocate for object "DFID", valid = %#llx"
+	       ", start = %lld, end = %lld, mode = %#x\n", PFID(&tsi->tsi_fid),
+	       oa->o_valid, start, end, mode);
+
+	fo = ofd_object_find_exists(tsi->tsi_env, ofd_exp(tsi->tsi_exp),
+				    &tsi->tsi_fid);
+	if (IS_ERR(fo))
+		RETURN(PTR_ERR(fo));
+
+	la_from_obdo(&info->fti_attr, oa,
+		     OBD_MD_FLUID | OBD_MD_FLGID | OBD_MD_FLPROJID);
+
+	rc = ofd_object_fallocate(tsi->tsi_env, fo, start, end, mode,
+				  &info->fti_attr, (struct obdo *)oa);
+	if (rc)
+		GOTO(out_put, rc);
+
+	ofd_counter_incr(tsi->tsi_exp, LPROC_OFD_STATS_FALLOCATE,
+			 tsi->tsi_jobid, 1);
+	EXIT;
+out_put:
+	ofd_object_put(tsi->tsi_env, fo);
+	if (rc == 0) {
+		/* as for punch, update the LVB only once the object is put */
+		res = ldlm_resource_get(ns, NULL, &tsi->tsi_resid,
+					LDLM_EXTENT, 0);
+		if (!IS_ERR(res)) {
+			struct ost_lvb *res_lvb;
+
+			ldlm_res_lvbo_update(tsi->tsi_env, res, NULL, 0);
+			res_lvb = res->lr_lvb_data;
+			repbody->oa.o_valid |= OBD_MD_FLBLOCKS;
+			repbody->oa.o_blocks = res_lvb->lvb_blocks;
+			ldlm_resource_putref(res);
+		}
+	}
+	return rc;
+}
+
 static int ofd_ladvise_prefetch(const struct lu_env *env,
 				struct ofd_object *fo,
 				struct niobuf_local *lnb,
@@ -2724,6 +2812,9 @@ TGT_OST_HDL_HP(HABEO_CORPUS| HABEO_REFERO | MUTABOR,
 TGT_OST_HDL(HABEO_CORPUS| HABEO_REFERO,	OST_SYNC,	ofd_sync_hdl),
 TGT_OST_HDL(0		| HABEO_REFERO,	OST_QUOTACTL,	ofd_quotactl),
 TGT_OST_HDL(HABEO_CORPUS | HABEO_REFERO, OST_LADVISE,	ofd_ladvise_hdl),
+TGT_OST_HDL_HP(HABEO_CORPUS| HABEO_REFERO | MUTABOR,
+					OST_FALLOCATE,	ofd_fallocate_hdl,
+							ofd_hp_punch),
 };
 
 static struct tgt_opc_slice ofd_common_slice[] = {
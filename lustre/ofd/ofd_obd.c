@@ -45,6 +45,7 @@
 
 #include "ofd_internal.h"
 #include <obd_cksum.h>
+#include <obd_compr.h>
 #include <uapi/linux/lustre/lustre_ioctl.h>
 #include <lustre_quota.h>
 #include <lustre_lfsck.h>
@@ -250,6 +251,17 @@ static int ofd_parse_connect_data(const struct lu_env *env,
 	if (data->ocd_connect_flags & OBD_CONNECT_FLAGS2)
 		data->ocd_connect_flags2 &= OST_CONNECT_SUPPORTED2;
 
+	if (OCD_HAS_FLAG(data, FLAGS2) &&
+	    data->ocd_connect_flags2 & OBD_CONNECT2_COMPRESS) {
+		data->ocd_compr_types &= obd_compr_types_supported();
+		if (data->ocd_compr_types == 0)
+			data->ocd_connect_flags2 &= ~OBD_CONNECT2_COMPRESS;
+
+		CDEBUG(D_RPCTRACE, "%s: cli %s compression types %#x\n",
+		       exp->exp_obd->obd_name, obd_export_nid2str(exp),
+		       data->ocd_compr_types);
+	}
+
 	/* Kindly make sure the SKIP_ORPHAN flag is from MDS. */
 	if (data->ocd_connect_flags & OBD_CONNECT_MDS)
 		CDEBUG(D_HA, "%s: Received MDS connection for group %u\n",
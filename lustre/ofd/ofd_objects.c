@@ -40,6 +40,7 @@
 
 #define DEBUG_SUBSYSTEM S_FILTER
 
+#include <linux/falloc.h>
 #include <dt_object.h>
 #include <lustre_lfsck.h>
 
@@ -816,6 +817,143 @@ unlock:
 	return rc;
 }
 
+/**
+ * Preallocate space for OFD object.
+ *
+ * This function allocates the object's space from the \a start offset to
+ * the \a end offset without writing any data, the space reads back as
+ * zeroes. Unless FALLOC_FL_KEEP_SIZE is set in \a mode, the object size is
+ * extended up to \a end if it is smaller.
+ *
+ * \param[in] env	execution environment
+ * \param[in] fo	OFD object
+ * \param[in] start	start offset to preallocate from
+ * \param[in] end	end of preallocation
+ * \param[in] mode	fallocate mode, FALLOC_FL_* flags
+ * \param[in] la	object attributes
+ * \param[in] oa	obdo struct from incoming request
+ *
+ * \retval		0 if successful
+ * \retval		negative value on error
+ */
+int ofd_object_fallocate(const struct lu_env *env, struct ofd_object *fo,
+			 __u64 start, __u64 end, int mode, struct lu_attr *la,
+			 struct obdo *oa)
+{
+	struct ofd_thread_info	*info = ofd_info(env);
+	struct ofd_device	*ofd = ofd_obj2dev(fo);
+	struct dt_object	*dob = ofd_object_child(fo);
+	struct filter_fid	*ff = &info->fti_mds_fid;
+	struct thandle		*th;
+	int			fl;
+	int			rc;
+	int			rc2;
+
+	ENTRY;
+
+	ofd_write_lock(env, fo);
+	if (!ofd_object_exists(fo))
+		GOTO(unlock, rc = -ENOENT);
+
+	if (ofd->ofd_lfsck_verify_pfid && oa->o_valid & OBD_MD_FLFID) {
+		rc = ofd_verify_ff(env, fo, oa);
+		if (rc != 0)
+			GOTO(unlock, rc);
+	}
+
+	/* need to verify layout version */
+	if (oa->o_valid & OBD_MD_LAYOUT_VERSION) {
+		rc = ofd_verify_layout_version(env, fo, oa);
+		if (rc)
+			GOTO(unlock, rc);
+
+		oa->o_valid &= ~OBD_MD_LAYOUT_VERSION;
+	}
+
+	/* VBR: version recovery check */
+	rc = ofd_version_get_check(info, fo);
+	if (rc)
+		GOTO(unlock, rc);
+
+	rc = ofd_attr_handle_id(env, fo, la, 0 /* !is_setattr */);
+	if (rc != 0)
+		GOTO(unlock, rc);
+
+	if (!(mode & FALLOC_FL_KEEP_SIZE)) {
+		rc = dt_attr_get(env, dob, &info->fti_attr2);
+		if (rc != 0)
+			GOTO(unlock, rc);
+
+		if (end > info->fti_attr2.la_size) {
+			la->la_size = end;
+			la->la_valid |= LA_SIZE;
+		}
+	}
+
+	fl = ofd_object_ff_update(env, fo, oa, ff);
+	if (fl < 0)
+		GOTO(unlock, rc = fl);
+
+	th = ofd_trans_create(env, ofd);
+	if (IS_ERR(th))
+		GOTO(unlock, rc = PTR_ERR(th));
+
+	if (la->la_valid) {
+		rc = dt_declare_attr_set(env, dob, la, th);
+		if (rc)
+			GOTO(stop, rc);
+	}
+
+	rc = dt_declare_fallocate(env, dob, start, end, mode, th);
+	if (rc)
+		GOTO(stop, rc);
+
+	if (fl) {
+		info->fti_buf.lb_buf = ff;
+		info->fti_buf.lb_len = sizeof(*ff);
+		rc = dt_declare_xattr_set(env, ofd_object_child(fo),
+					  &info->fti_buf, XATTR_NAME_FID, fl,
+					  th);
+		if (rc)
+			GOTO(stop, rc);
+	}
+
+	rc = ofd_trans_start(env, ofd, fo, th);
+	if (rc)
+		GOTO(stop, rc);
+
+	rc = dt_fallocate(env, dob, start, end, mode, th);
+	if (rc)
+		GOTO(stop, rc);
+
+	if (la->la_valid) {
+		rc = dt_attr_set(env, dob, la, th);
+		if (rc)
+			GOTO(stop, rc);
+	}
+
+	if (fl) {
+		rc = dt_xattr_set(env, ofd_object_child(fo), &info->fti_buf,
+				  XATTR_NAME_FID, fl, th);
+		if (!rc)
+			filter_fid_le_to_cpu(&fo->ofo_ff, ff, sizeof(*ff));
+	}
+
+	GOTO(stop, rc);
+
+stop:
+	rc2 = ofd_trans_stop(env, ofd, th, rc);
+	if (rc2 != 0)
+		CERROR("%s: failed to stop transaction: rc = %d\n",
+		       ofd_name(ofd), rc2);
+	if (!rc)
+		rc = rc2;
+unlock:
+	ofd_write_unlock(env, fo);
+
+	return rc;
+}
+
 /**
  * Destroy OFD object.
  *
@@ -35,6 +35,7 @@
 #include <asm/statfs.h>
 #include <obd_cksum.h>
 #include <obd_class.h>
+#include <obd_compr.h>
 #include <lprocfs_status.h>
 #include <linux/seq_file.h>
 #include <lustre_osc.h>
@@ -137,6 +138,47 @@ static ssize_t max_rpcs_in_flight_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(max_rpcs_in_flight);
 
+static ssize_t adaptive_rpc_show(struct kobject *kobj,
+				 struct attribute *attr,
+				 char *buf)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+
+	return sprintf(buf, "%u\n", dev->u.cli.cl_rpc_window.rw_enabled);
+}
+
+static ssize_t adaptive_rpc_store(struct kobject *kobj,
+				  struct attribute *attr,
+				  const char *buffer,
+				  size_t count)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &dev->u.cli;
+	struct client_rpc_window *rw = &cli->cl_rpc_window;
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	if (val && !rw->rw_enabled) {
+		/* start from the admin-set values, they are the upper bounds
+		 * of the window */
+		memset(rw, 0, sizeof(*rw));
+		rw->rw_rpcs = cli->cl_max_rpcs_in_flight;
+		rw->rw_pages = cli->cl_max_pages_per_rpc;
+	}
+	rw->rw_enabled = val;
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(adaptive_rpc);
+
 static ssize_t max_dirty_mb_show(struct kobject *kobj,
 				 struct attribute *attr,
 				 char *buf)
@@ -263,6 +305,9 @@ static ssize_t cur_dirty_bytes_show(struct kobject *kobj,
 	struct client_obd *cli = &dev->u.cli;
 	ssize_t len;
 
+	/* don't count the dirty page credits cached on the CPUs */
+	osc_credits_drain(cli);
+
 	spin_lock(&cli->cl_loi_list_lock);
 	len = sprintf(buf, "%lu\n", cli->cl_dirty_pages << PAGE_SHIFT);
 	spin_unlock(&cli->cl_loi_list_lock);
@@ -276,6 +321,8 @@ static int osc_cur_grant_bytes_seq_show(struct seq_file *m, void *v)
 	struct obd_device *dev = m->private;
 	struct client_obd *cli = &dev->u.cli;
 
+	osc_credits_drain(cli);
+
 	spin_lock(&cli->cl_loi_list_lock);
 	seq_printf(m, "%lu\n", cli->cl_avail_grant);
 	spin_unlock(&cli->cl_loi_list_lock);
@@ -902,6 +949,7 @@ static int osc_stats_seq_show(struct seq_file *seq, void *v)
 	struct timespec64 now;
 	struct obd_device *dev = seq->private;
 	struct osc_stats *stats = &obd2osc_dev(dev)->od_stats;
+	struct client_obd *cli = &dev->u.cli;
 
 	ktime_get_real_ts64(&now);
 
@@ -913,6 +961,17 @@ static int osc_stats_seq_show(struct seq_file *seq, void *v)
 		   stats->os_lockless_reads);
 	seq_printf(seq, "lockless_truncate\t\t%llu\n",
 		   stats->os_lockless_truncates);
+
+	spin_lock(&cli->cl_loi_list_lock);
+	seq_printf(seq, "rpcs_in_flight_window\t\t%u\n",
+		   osc_rpcs_window(cli));
+	seq_printf(seq, "pages_per_rpc_window\t\t%u\n",
+		   osc_pages_window(cli));
+	seq_printf(seq, "rpc_service_usec_per_mb\t\t%llu\n",
+		   cli->cl_rpc_window.rw_last_us);
+	seq_printf(seq, "rpc_base_usec_per_mb\t\t%llu\n",
+		   cli->cl_rpc_window.rw_base_us);
+	spin_unlock(&cli->cl_loi_list_lock);
 	return 0;
 }
 
@@ -930,6 +989,65 @@ static ssize_t osc_stats_seq_write(struct file *file,
 
 LPROC_SEQ_FOPS(osc_stats);
 
+static int osc_compress_stats_seq_show(struct seq_file *seq, void *v)
+{
+	static const char * const dir[] = { "read", "write" };
+	struct timespec64 now;
+	struct obd_device *dev = seq->private;
+	struct client_obd *cli = &dev->u.cli;
+	enum obd_compr_types compr_type;
+	DECLARE_COMPR_NAME;
+	int i;
+
+	ktime_get_real_ts64(&now);
+	compr_type = obd_compr_type_unpack(
+			obd_compr_type_pack(cli->cl_supp_compr_types));
+
+	seq_printf(seq, "snapshot_time:         %lld.%09lu (secs.nsecs)\n",
+		   (s64)now.tv_sec, now.tv_nsec);
+	seq_printf(seq, "compr_type\t\t%s\n",
+		   compr_type != 0 ? compr_name[ffs(compr_type) - 1] : "none");
+
+	for (i = 0; i < ARRAY_SIZE(dir); i++) {
+		struct obd_compr_stats *stats = &cli->cl_compr_stats[i];
+		u64 raw = atomic64_read(&stats->ocs_raw_bytes);
+		u64 wire = atomic64_read(&stats->ocs_wire_bytes);
+		u64 ratio = wire != 0 ? div64_u64(raw * 100, wire) : 100;
+
+		seq_printf(seq, "%s_rpcs\t\t%lld\n", dir[i],
+			   (s64)atomic64_read(&stats->ocs_rpcs));
+		seq_printf(seq, "%s_raw_bytes\t\t%llu\n", dir[i], raw);
+		seq_printf(seq, "%s_wire_bytes\t\t%llu\n", dir[i], wire);
+		seq_printf(seq, "%s_ratio\t\t%llu.%02llu\n", dir[i],
+			   ratio / 100, ratio % 100);
+		seq_printf(seq, "%s_usecs\t\t%lld\n", dir[i],
+			   (s64)atomic64_read(&stats->ocs_usecs));
+	}
+	return 0;
+}
+
+static ssize_t osc_compress_stats_seq_write(struct file *file,
+					    const char __user *buf,
+					    size_t len, loff_t *off)
+{
+	struct seq_file *seq = file->private_data;
+	struct obd_device *dev = seq->private;
+	struct client_obd *cli = &dev->u.cli;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cli->cl_compr_stats); i++) {
+		struct obd_compr_stats *stats = &cli->cl_compr_stats[i];
+
+		atomic64_set(&stats->ocs_rpcs, 0);
+		atomic64_set(&stats->ocs_raw_bytes, 0);
+		atomic64_set(&stats->ocs_wire_bytes, 0);
+		atomic64_set(&stats->ocs_usecs, 0);
+	}
+	return len;
+}
+
+LPROC_SEQ_FOPS(osc_compress_stats);
+
 int lprocfs_osc_attach_seqstat(struct obd_device *dev)
 {
 	int rc;
@@ -939,6 +1057,9 @@ int lprocfs_osc_attach_seqstat(struct obd_device *dev)
 	if (rc == 0)
 		rc = lprocfs_obd_seq_create(dev, "rpc_stats", 0644,
 					    &osc_rpc_stats_fops, dev);
+	if (rc == 0)
+		rc = lprocfs_obd_seq_create(dev, "compress_stats", 0644,
+					    &osc_compress_stats_fops, dev);
 
 	return rc;
 }
@@ -956,6 +1077,7 @@ static struct attribute *osc_attrs[] = {
 	&lustre_attr_lockless_truncate.attr,
 	&lustre_attr_max_dirty_mb.attr,
 	&lustre_attr_max_rpcs_in_flight.attr,
+	&lustre_attr_adaptive_rpc.attr,
 	&lustre_attr_short_io_bytes.attr,
 	&lustre_attr_resend_count.attr,
 	&lustre_attr_ost_conn_uuid.attr,
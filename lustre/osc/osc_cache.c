@@ -622,15 +622,18 @@ static inline int overlapped(struct osc_extent *ex1, struct osc_extent *ex2)
 
 /**
  * Find or create an extent which includes @index, core function to manage
- * extent tree.
+ * extent tree. The page is covered by @dlmlock, which spans the pages from
+ * @lock_start to @lock_end.
  */
-static struct osc_extent *osc_extent_find(const struct lu_env *env,
-					  struct osc_object *obj, pgoff_t index,
-					  unsigned int *grants)
+static struct osc_extent *__osc_extent_find(const struct lu_env *env,
+					    struct osc_object *obj,
+					    pgoff_t index,
+					    struct ldlm_lock *dlmlock,
+					    pgoff_t lock_start,
+					    pgoff_t lock_end,
+					    unsigned int *grants)
 {
 	struct client_obd *cli = osc_cli(obj);
-	struct osc_lock   *olck;
-	struct cl_lock_descr *descr;
 	struct osc_extent *cur;
 	struct osc_extent *ext;
 	struct osc_extent *conflict = NULL;
@@ -648,13 +651,6 @@ static struct osc_extent *osc_extent_find(const struct lu_env *env,
 	if (cur == NULL)
 		RETURN(ERR_PTR(-ENOMEM));
 
-	olck = osc_env_io(env)->oi_write_osclock;
-	LASSERTF(olck != NULL, "page %lu is not covered by lock\n", index);
-	LASSERT(olck->ols_state == OLS_GRANTED);
-
-	descr = &olck->ols_cl.cls_lock->cll_descr;
-	LASSERT(descr->cld_mode >= CLM_WRITE);
-
 	LASSERTF(cli->cl_chunkbits >= PAGE_SHIFT,
 		 "chunkbits: %u\n", cli->cl_chunkbits);
 	ppc_bits   = cli->cl_chunkbits - PAGE_SHIFT;
@@ -663,29 +659,28 @@ static struct osc_extent *osc_extent_find(const struct lu_env *env,
 	chunk      = index >> ppc_bits;
 
 	/* align end to RPC edge. */
-	max_pages = cli->cl_max_pages_per_rpc;
+	max_pages = osc_pages_window(cli);
 	if ((max_pages & ~chunk_mask) != 0) {
 		CERROR("max_pages: %#x chunkbits: %u chunk_mask: %#lx\n",
 		       max_pages, cli->cl_chunkbits, chunk_mask);
 		RETURN(ERR_PTR(-EINVAL));
 	}
 	max_end = index - (index % max_pages) + max_pages - 1;
-	max_end = min_t(pgoff_t, max_end, descr->cld_end);
+	max_end = min_t(pgoff_t, max_end, lock_end);
 
 	/* initialize new extent by parameters so far */
 	cur->oe_max_end = max_end;
 	cur->oe_start   = index & chunk_mask;
 	cur->oe_end     = ((index + ~chunk_mask + 1) & chunk_mask) - 1;
-	if (cur->oe_start < descr->cld_start)
-		cur->oe_start = descr->cld_start;
+	if (cur->oe_start < lock_start)
+		cur->oe_start = lock_start;
 	if (cur->oe_end > max_end)
 		cur->oe_end = max_end;
 	cur->oe_grants  = 0;
 	cur->oe_mppr    = max_pages;
-	if (olck->ols_dlmlock != NULL) {
-		LASSERT(olck->ols_hold);
-		cur->oe_dlmlock = LDLM_LOCK_GET(olck->ols_dlmlock);
-		lu_ref_add(&olck->ols_dlmlock->l_reference, "osc_extent", cur);
+	if (dlmlock != NULL) {
+		cur->oe_dlmlock = LDLM_LOCK_GET(dlmlock);
+		lu_ref_add(&dlmlock->l_reference, "osc_extent", cur);
 	}
 
 	/* grants has been allocated by caller */
@@ -708,7 +703,7 @@ restart:
 			break;
 
 		/* if covering by different locks, no chance to match */
-		if (olck->ols_dlmlock != ext->oe_dlmlock) {
+		if (dlmlock != ext->oe_dlmlock) {
 			EASSERTF(!overlapped(ext, cur), ext,
 				 EXTSTR"\n", EXTPARA(cur));
 
@@ -828,7 +823,7 @@ restart:
 		found = osc_extent_hold(cur);
 		osc_extent_insert(obj, cur);
 		OSC_EXTENT_DUMP(D_CACHE, cur, "add into tree %lu/%lu.\n",
-				index, descr->cld_end);
+				index, lock_end);
 	}
 	osc_object_unlock(obj);
 
@@ -852,6 +847,28 @@ out:
 	return found;
 }
 
+/**
+ * Find or create an extent which includes @index for the write lock of the
+ * current IO.
+ */
+static struct osc_extent *osc_extent_find(const struct lu_env *env,
+					  struct osc_object *obj, pgoff_t index,
+					  unsigned int *grants)
+{
+	struct osc_lock *olck = osc_env_io(env)->oi_write_osclock;
+	struct cl_lock_descr *descr;
+
+	LASSERTF(olck != NULL, "page %lu is not covered by lock\n", index);
+	LASSERT(olck->ols_state == OLS_GRANTED);
+
+	descr = &olck->ols_cl.cls_lock->cll_descr;
+	LASSERT(descr->cld_mode >= CLM_WRITE);
+	LASSERT(ergo(olck->ols_dlmlock != NULL, olck->ols_hold));
+
+	return __osc_extent_find(env, obj, index, olck->ols_dlmlock,
+				 descr->cld_start, descr->cld_end, grants);
+}
+
 /**
  * Called when IO is finished to an extent.
  */
@@ -1563,6 +1580,188 @@ static int osc_enter_cache_try(struct client_obd *cli,
 	return rc;
 }
 
+/* Most pages worth of credits a CPU takes from the client at once */
+#define OSC_CREDITS_MAX_PAGES	32
+
+/**
+ * Refill the credits cached on a CPU from the client, in batches of up to
+ * OSC_CREDITS_MAX_PAGES pages. The CPUs don't cache more than a quarter of
+ * the dirty pages allowed for the client, and nothing is taken while there
+ * are cache waiters, they need the credits to make progress.
+ *
+ * caller must hold cc_lock
+ */
+static void osc_credits_refill(struct client_obd *cli,
+			       struct client_obd_credits *cc,
+			       unsigned int bytes)
+{
+	unsigned long pages;
+	unsigned int grant;
+	long left;
+
+	pages = cli->cl_dirty_max_pages / (num_online_cpus() * 4);
+	pages = clamp_t(unsigned long, pages, 1, OSC_CREDITS_MAX_PAGES);
+
+	spin_lock(&cli->cl_loi_list_lock);
+	if (!list_empty(&cli->cl_cache_waiters))
+		goto out;
+
+	if (cc->cc_dirty == 0) {
+		if (cli->cl_dirty_pages >= cli->cl_dirty_max_pages)
+			goto out;
+		left = obd_max_dirty_pages - atomic_long_read(&obd_dirty_pages);
+		if (left <= 0)
+			goto out;
+
+		pages = min(pages,
+			    cli->cl_dirty_max_pages - cli->cl_dirty_pages);
+		pages = min_t(unsigned long, pages, left);
+		atomic_long_add(pages, &obd_dirty_pages);
+		cli->cl_dirty_pages += pages;
+		cc->cc_dirty = pages;
+	}
+
+	if (cc->cc_grant < bytes) {
+		grant = round_up(pages << PAGE_SHIFT, 1 << cli->cl_chunkbits) +
+			cli->cl_grant_extent_tax;
+		grant = max(grant, bytes) - cc->cc_grant;
+		if (osc_reserve_grant(cli, grant) == 0)
+			cc->cc_grant += grant;
+		else if (osc_reserve_grant(cli, bytes - cc->cc_grant) == 0)
+			cc->cc_grant = bytes;
+	}
+	osc_update_next_shrink(cli);
+out:
+	spin_unlock(&cli->cl_loi_list_lock);
+}
+
+/**
+ * Lockless version of osc_enter_cache_try(), it consumes the credits cached
+ * on the current CPU and takes cl_loi_list_lock only to refill them.
+ */
+static int osc_enter_cache_fast(struct client_obd *cli,
+				struct osc_async_page *oap, unsigned int bytes)
+{
+	struct client_obd_credits *cc;
+	int rc = 0;
+
+	LASSERT(!(oap->oap_brw_page.flag & OBD_BRW_FROM_GRANT));
+
+	/* don't jump the queue of cache waiters */
+	if (!list_empty(&cli->cl_cache_waiters))
+		return 0;
+
+	cc = get_cpu_ptr(cli->cl_credits);
+	spin_lock(&cc->cc_lock);
+	if (cc->cc_dirty == 0 || cc->cc_grant < bytes)
+		osc_credits_refill(cli, cc, bytes);
+
+	if (cc->cc_dirty > 0 && cc->cc_grant >= bytes) {
+		cc->cc_dirty--;
+		cc->cc_grant -= bytes;
+		oap->oap_brw_page.flag |= OBD_BRW_FROM_GRANT;
+		rc = 1;
+	}
+	spin_unlock(&cc->cc_lock);
+	put_cpu_ptr(cli->cl_credits);
+
+	return rc;
+}
+
+/**
+ * Give the credits cached on all CPUs back to the client, so that they can
+ * be used by the cache waiters, shrunk or released at cleanup.
+ *
+ * caller must not hold loi_list_lock
+ */
+void osc_credits_drain(struct client_obd *cli)
+{
+	struct client_obd_credits *cc;
+	unsigned long dirty = 0;
+	unsigned int grant = 0;
+	int cpu;
+
+	if (cli->cl_credits == NULL)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		cc = per_cpu_ptr(cli->cl_credits, cpu);
+		spin_lock(&cc->cc_lock);
+		grant += cc->cc_grant;
+		dirty += cc->cc_dirty;
+		cc->cc_grant = 0;
+		cc->cc_dirty = 0;
+		spin_unlock(&cc->cc_lock);
+	}
+
+	if (grant == 0 && dirty == 0)
+		return;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	__osc_unreserve_grant(cli, grant, grant);
+	atomic_long_sub(dirty, &obd_dirty_pages);
+	cli->cl_dirty_pages -= dirty;
+	osc_wake_cache_waiters(cli);
+	spin_unlock(&cli->cl_loi_list_lock);
+}
+
+/**
+ * Deferred version of osc_unreserve_grant(): the unused grant goes back to
+ * the credits of the current CPU, and the grant the active extent of \a oio
+ * used or saved is accounted when the extent is released.
+ */
+static void osc_io_unreserve_grant(struct client_obd *cli, struct osc_io *oio,
+				   unsigned int reserved, unsigned int unused)
+{
+	struct client_obd_credits *cc;
+
+	if (unused > reserved) {
+		oio->oi_grant_lost += unused - reserved;
+		unused = reserved;
+	} else {
+		oio->oi_grant_used += reserved - unused;
+	}
+
+	if (unused == 0)
+		return;
+
+	if (!list_empty(&cli->cl_cache_waiters)) {
+		osc_unreserve_grant(cli, unused, unused);
+		return;
+	}
+
+	cc = get_cpu_ptr(cli->cl_credits);
+	spin_lock(&cc->cc_lock);
+	cc->cc_grant += unused;
+	spin_unlock(&cc->cc_lock);
+	put_cpu_ptr(cli->cl_credits);
+}
+
+/**
+ * Release the active extent of \a oio. The grant consumed by its pages is
+ * moved from the reserved to the dirty grant of the client first, so that
+ * it is accounted by the time the extent is written out.
+ */
+void osc_io_extent_release(const struct lu_env *env, struct osc_io *oio)
+{
+	struct osc_extent *ext = oio->oi_active;
+	struct client_obd *cli = osc_cli(ext->oe_obj);
+
+	if (oio->oi_grant_used > 0 || oio->oi_grant_lost > 0) {
+		spin_lock(&cli->cl_loi_list_lock);
+		cli->cl_reserved_grant -= oio->oi_grant_used;
+		cli->cl_dirty_grant += oio->oi_grant_used;
+		cli->cl_dirty_grant -= oio->oi_grant_lost;
+		cli->cl_lost_grant += oio->oi_grant_lost;
+		spin_unlock(&cli->cl_loi_list_lock);
+		oio->oi_grant_used = 0;
+		oio->oi_grant_lost = 0;
+	}
+
+	oio->oi_active = NULL;
+	osc_extent_release(env, ext);
+}
+
 static int ocw_granted(struct client_obd *cli, struct osc_cache_waiter *ocw)
 {
 	int rc;
@@ -1594,18 +1793,25 @@ static int osc_enter_cache(const struct lu_env *env, struct client_obd *cli,
 
 	OSC_DUMP_GRANT(D_CACHE, cli, "need:%d\n", bytes);
 
-	spin_lock(&cli->cl_loi_list_lock);
-
 	/* force the caller to try sync io.  this can jump the list
 	 * of queued writes and create a discontiguous rpc stream */
 	if (OBD_FAIL_CHECK(OBD_FAIL_OSC_NO_GRANT) ||
 	    cli->cl_dirty_max_pages == 0 ||
 	    cli->cl_ar.ar_force_sync || loi->loi_ar.ar_force_sync) {
 		OSC_DUMP_GRANT(D_CACHE, cli, "forced sync i/o\n");
-		GOTO(out, rc = -EDQUOT);
+		RETURN(-EDQUOT);
 	}
 
 	/* Hopefully normal case - cache space and write credits available */
+	if (osc_enter_cache_fast(cli, oap, bytes)) {
+		OSC_DUMP_GRANT(D_CACHE, cli, "granted from CPU cache\n");
+		RETURN(0);
+	}
+
+	/* the credits cached on other CPUs may be enough for this page */
+	osc_credits_drain(cli);
+
+	spin_lock(&cli->cl_loi_list_lock);
 	if (list_empty(&cli->cl_cache_waiters) &&
 	    osc_enter_cache_try(cli, oap, bytes, 0)) {
 		OSC_DUMP_GRANT(D_CACHE, cli, "granted from cache\n");
@@ -1716,7 +1922,7 @@ EXPORT_SYMBOL(osc_wake_cache_waiters);
 static int osc_max_rpc_in_flight(struct client_obd *cli, struct osc_object *osc)
 {
 	int hprpc = !!list_empty(&osc->oo_hp_exts);
-	return rpcs_in_flight(cli) >= cli->cl_max_rpcs_in_flight + hprpc;
+	return rpcs_in_flight(cli) >= osc_rpcs_window(cli) + hprpc;
 }
 
 /* This maintains the lists of pending pages to read/write for a given object
@@ -2012,7 +2218,7 @@ static unsigned int get_write_extents(struct osc_object *obj,
 	struct extent_rpc_data data = {
 		.erd_rpc_list	= rpclist,
 		.erd_page_count	= 0,
-		.erd_max_pages	= cli->cl_max_pages_per_rpc,
+		.erd_max_pages	= osc_pages_window(cli),
 		.erd_max_chunks	= osc_max_write_chunks(cli),
 		.erd_max_extents = 256,
 	};
@@ -2346,6 +2552,30 @@ int osc_prep_async_page(struct osc_object *osc, struct osc_page *ops,
 }
 EXPORT_SYMBOL(osc_prep_async_page);
 
+/**
+ * Check if the owner, group or project of the file is over quota.
+ */
+static int osc_quota_check(const struct lu_env *env, struct client_obd *cli,
+			   struct osc_object *osc)
+{
+	struct cl_object *obj = cl_object_top(&osc->oo_cl);
+	struct cl_attr *attr = &osc_env_info(env)->oti_attr;
+	unsigned int qid[LL_MAXQUOTAS];
+	int rc;
+
+	cl_object_attr_lock(obj);
+	rc = cl_object_attr_get(env, obj, attr);
+	cl_object_attr_unlock(obj);
+
+	qid[USRQUOTA] = attr->cat_uid;
+	qid[GRPQUOTA] = attr->cat_gid;
+	qid[PRJQUOTA] = attr->cat_projid;
+	if (rc == 0 && osc_quota_chkdq(cli, qid) == NO_QUOTA)
+		rc = -EDQUOT;
+
+	return rc;
+}
+
 int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 		       struct osc_page *ops)
 {
@@ -2382,22 +2612,7 @@ int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 
 	/* check if the file's owner/group is over quota */
 	if (!(cmd & OBD_BRW_NOQUOTA)) {
-		struct cl_object *obj;
-		struct cl_attr   *attr;
-		unsigned int qid[LL_MAXQUOTAS];
-
-		obj = cl_object_top(&osc->oo_cl);
-		attr = &osc_env_info(env)->oti_attr;
-
-		cl_object_attr_lock(obj);
-		rc = cl_object_attr_get(env, obj, attr);
-		cl_object_attr_unlock(obj);
-
-		qid[USRQUOTA] = attr->cat_uid;
-		qid[GRPQUOTA] = attr->cat_gid;
-		qid[PRJQUOTA] = attr->cat_projid;
-		if (rc == 0 && osc_quota_chkdq(cli, qid) == NO_QUOTA)
-			rc = -EDQUOT;
+		rc = osc_quota_check(env, cli, osc);
 		if (rc)
 			RETURN(rc);
 	}
@@ -2430,9 +2645,7 @@ int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 			grants = 0;
 
 		/* it doesn't need any grant to dirty this page */
-		spin_lock(&cli->cl_loi_list_lock);
-		rc = osc_enter_cache_try(cli, oap, grants, 0);
-		spin_unlock(&cli->cl_loi_list_lock);
+		rc = osc_enter_cache_fast(cli, oap, grants);
 		if (rc == 0) { /* try failed */
 			grants = 0;
 			need_release = 1;
@@ -2446,7 +2659,7 @@ int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 			} else {
 				OSC_EXTENT_DUMP(D_CACHE, ext,
 						"expanded for %lu.\n", index);
-				osc_unreserve_grant(cli, grants, tmp);
+				osc_io_unreserve_grant(cli, oio, grants, tmp);
 				grants = 0;
 			}
 		}
@@ -2456,8 +2669,7 @@ int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 		need_release = 1;
 	}
 	if (need_release) {
-		osc_extent_release(env, ext);
-		oio->oi_active = NULL;
+		osc_io_extent_release(env, oio);
 		ext = NULL;
 	}
 
@@ -2491,7 +2703,7 @@ int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 			}
 		}
 		if (grants > 0)
-			osc_unreserve_grant(cli, grants, tmp);
+			osc_io_unreserve_grant(cli, oio, grants, tmp);
 	}
 
 	LASSERT(ergo(rc == 0, ext != NULL));
@@ -2516,6 +2728,89 @@ int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 	RETURN(rc);
 }
 
+/**
+ * Queue a clean cached page into the write-back cache for a fast write, that
+ * is done without a cl_io. The page is covered by @dlmlock, a granted write
+ * lock the caller holds a reference on. Only the credits cached on the CPU
+ * are used, the caller falls back to the full IO to wait for grant, and the
+ * extent is released at once, as there is no IO to keep it active.
+ */
+int osc_queue_fast_io(const struct lu_env *env, struct osc_page *ops,
+		      struct ldlm_lock *dlmlock)
+{
+	struct osc_async_page *oap = &ops->ops_oap;
+	struct client_obd *cli = oap->oap_cli;
+	struct osc_object *osc = oap->oap_obj;
+	struct ldlm_extent *extent = &dlmlock->l_policy_data.l_extent;
+	struct osc_extent *ext;
+	pgoff_t index = osc_index(ops);
+	unsigned int grants;
+	unsigned int tmp;
+	u32 brw_flags = OBD_BRW_ASYNC;
+	int cmd = OBD_BRW_WRITE;
+	int rc;
+	ENTRY;
+
+	if (oap->oap_magic != OAP_MAGIC)
+		RETURN(-EINVAL);
+
+	if (cli->cl_import == NULL || cli->cl_import->imp_invalid)
+		RETURN(-EIO);
+
+	if (!list_empty(&oap->oap_pending_item) ||
+	    !list_empty(&oap->oap_rpc_item) || ops->ops_srvlock)
+		RETURN(-EBUSY);
+
+	if (cfs_capable(CFS_CAP_SYS_RESOURCE)) {
+		brw_flags |= OBD_BRW_NOQUOTA;
+		cmd |= OBD_BRW_NOQUOTA;
+	}
+
+	if (!(cmd & OBD_BRW_NOQUOTA)) {
+		rc = osc_quota_check(env, cli, osc);
+		if (rc)
+			RETURN(rc);
+	}
+
+	oap->oap_cmd = cmd;
+	oap->oap_page_off = ops->ops_from;
+	oap->oap_count = ops->ops_to - ops->ops_from;
+	oap->oap_async_flags = 0;
+	oap->oap_brw_flags = brw_flags;
+
+	grants = (1 << cli->cl_chunkbits) + cli->cl_grant_extent_tax;
+	if (!osc_enter_cache_fast(cli, oap, grants))
+		RETURN(-EDQUOT);
+
+	tmp = grants;
+	ext = __osc_extent_find(env, osc, index, dlmlock,
+				cl_index(osc2cl(osc), extent->start),
+				cl_index(osc2cl(osc), extent->end), &tmp);
+	if (IS_ERR(ext)) {
+		LASSERT(tmp == grants);
+		osc_exit_cache(cli, oap);
+		osc_unreserve_grant(cli, grants, tmp);
+		RETURN(PTR_ERR(ext));
+	}
+	osc_unreserve_grant(cli, grants, tmp);
+
+	OSC_IO_DEBUG(osc, "oap %p page %p added for fast write\n",
+		     oap, oap->oap_page);
+
+	EASSERTF(ext->oe_end >= index && ext->oe_start <= index,
+		 ext, "index = %lu.\n", index);
+
+	osc_object_lock(osc);
+	LASSERT(!ext->oe_srvlock);
+	++ext->oe_nr_pages;
+	list_add_tail(&oap->oap_pending_item, &ext->oe_pages);
+	osc_object_unlock(osc);
+
+	osc_extent_release(env, ext);
+
+	RETURN(0);
+}
+
 int osc_teardown_async_page(const struct lu_env *env,
 			    struct osc_object *obj, struct osc_page *ops)
 {
@@ -49,6 +49,8 @@ int lru_queue_work(const struct lu_env *env, void *data);
 int osc_extent_finish(const struct lu_env *env, struct osc_extent *ext,
 		      int sent, int rc);
 int osc_extent_release(const struct lu_env *env, struct osc_extent *ext);
+void osc_io_extent_release(const struct lu_env *env, struct osc_io *oio);
+void osc_credits_drain(struct client_obd *cli);
 int osc_lock_discard_pages(const struct lu_env *env, struct osc_object *osc,
 			   pgoff_t start, pgoff_t end, bool discard);
 
@@ -77,12 +79,32 @@ int osc_ladvise_base(struct obd_export *exp, struct obdo *oa,
 		     struct ladvise_hdr *ladvise_hdr,
 		     obd_enqueue_update_f upcall, void *cookie,
 		     struct ptlrpc_request_set *rqset);
+int osc_fallocate_base(struct obd_export *exp, struct obdo *oa,
+		       obd_enqueue_update_f upcall, void *cookie);
 int osc_process_config_base(struct obd_device *obd, struct lustre_cfg *cfg);
 int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 		  struct list_head *ext_list, int cmd);
 unsigned long osc_lru_reserve(struct client_obd *cli, unsigned long npages);
 void osc_lru_unreserve(struct client_obd *cli, unsigned long npages);
 
+/* RPCs in flight currently allowed by the RPC window of \a cli */
+static inline u32 osc_rpcs_window(struct client_obd *cli)
+{
+	if (!cli->cl_rpc_window.rw_enabled)
+		return cli->cl_max_rpcs_in_flight;
+
+	return min(cli->cl_rpc_window.rw_rpcs, cli->cl_max_rpcs_in_flight);
+}
+
+/* pages per write RPC currently allowed by the RPC window of \a cli */
+static inline u32 osc_pages_window(struct client_obd *cli)
+{
+	if (!cli->cl_rpc_window.rw_enabled)
+		return cli->cl_max_pages_per_rpc;
+
+	return min(cli->cl_rpc_window.rw_pages, cli->cl_max_pages_per_rpc);
+}
+
 extern struct lu_kmem_descr osc_caches[];
 
 unsigned long osc_ldlm_weigh_ast(struct ldlm_lock *dlmlock);
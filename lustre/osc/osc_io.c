@@ -37,6 +37,7 @@
 
 #define DEBUG_SUBSYSTEM S_OSC
 
+#include <linux/falloc.h>
 #include <lustre_obdo.h>
 #include <lustre_osc.h>
 
@@ -343,10 +344,8 @@ int osc_io_commit_async(const struct lu_env *env,
 	/* for sync write, kernel will wait for this page to be flushed before
 	 * osc_io_end() is called, so release it earlier.
 	 * for mkwrite(), it's known there is no further pages. */
-	if (cl_io_is_sync_write(io) && oio->oi_active != NULL) {
-		osc_extent_release(env, oio->oi_active);
-		oio->oi_active = NULL;
-	}
+	if (cl_io_is_sync_write(io) && oio->oi_active != NULL)
+		osc_io_extent_release(env, oio);
 
 	CDEBUG(D_INFO, "%d %d\n", qin->pl_nr, result);
 	RETURN(result);
@@ -964,14 +963,104 @@ static void osc_io_ladvise_end(const struct lu_env *env,
 	slice->cis_io->ci_result = result;
 }
 
+static int osc_io_fallocate_start(const struct lu_env *env,
+				  const struct cl_io_slice *slice)
+{
+	struct cl_io		*io = slice->cis_io;
+	struct osc_io		*oio = cl2osc_io(env, slice);
+	struct cl_object	*obj = slice->cis_obj;
+	struct lov_oinfo	*loi = cl2osc(obj)->oo_oinfo;
+	struct cl_fallocate_io	*fio = &io->u.ci_fallocate;
+	struct cl_req_attr	*crattr = &osc_env_info(env)->oti_req_attr;
+	struct obdo		*oa = &oio->oi_oa;
+	struct osc_async_cbargs	*cbargs = &oio->oi_cbarg;
+	int			 result;
+	ENTRY;
+
+	memset(oa, 0, sizeof(*oa));
+	oa->o_oi = loi->loi_oi;
+	oa->o_valid = OBD_MD_FLID | OBD_MD_FLGROUP;
+
+	/* owner of the object, so that the OST charges the preallocated
+	 * blocks to the right quota even if nothing was written yet */
+	memset(crattr, 0, sizeof(*crattr));
+	crattr->cra_type = CRT_WRITE;
+	crattr->cra_flags = OBD_MD_FLUID | OBD_MD_FLGID;
+	crattr->cra_oa = oa;
+	cl_req_attr_set(env, obj, crattr);
+	obdo_set_parent_fid(oa, fio->fa_fid);
+
+	/* the range is sent in o_size/o_blocks, as for OST_PUNCH */
+	oa->o_size = fio->fa_start;
+	oa->o_blocks = fio->fa_end;
+	oa->o_falloc_mode = fio->fa_mode;
+	oa->o_valid |= OBD_MD_FLSIZE | OBD_MD_FLBLOCKS;
+
+	if (io->ci_layout_version > 0) {
+		/* verify layout version */
+		oa->o_valid |= OBD_MD_LAYOUT_VERSION;
+		oa->o_layout_version = io->ci_layout_version;
+	}
+
+	init_completion(&cbargs->opc_sync);
+	result = osc_fallocate_base(osc_export(cl2osc(obj)), oa,
+				    osc_async_upcall, cbargs);
+	cbargs->opc_rpc_sent = result == 0;
+	RETURN(result);
+}
+
+static void osc_io_fallocate_end(const struct lu_env *env,
+				 const struct cl_io_slice *slice)
+{
+	struct cl_io		*io = slice->cis_io;
+	struct osc_io		*oio = cl2osc_io(env, slice);
+	struct cl_object	*obj = slice->cis_obj;
+	struct lov_oinfo	*loi = cl2osc(obj)->oo_oinfo;
+	struct cl_fallocate_io	*fio = &io->u.ci_fallocate;
+	struct osc_async_cbargs	*cbargs = &oio->oi_cbarg;
+	struct cl_attr		*attr = &osc_env_info(env)->oti_attr;
+	struct obdo		*oa = &oio->oi_oa;
+	unsigned int		 cl_valid = 0;
+	int			 result = 0;
+
+	if (cbargs->opc_rpc_sent) {
+		wait_for_completion(&cbargs->opc_sync);
+		result = cbargs->opc_rc;
+		/* an old OST does not know about OST_FALLOCATE */
+		if (result == -ENOTSUPP)
+			result = -EOPNOTSUPP;
+	}
+	io->ci_result = result;
+	if (result != 0)
+		return;
+
+	/* the object was extended under our write lock, so the KMS can be
+	 * moved up to the end of the preallocated range */
+	cl_object_attr_lock(obj);
+	if (!(fio->fa_mode & FALLOC_FL_KEEP_SIZE)) {
+		if (fio->fa_end > loi->loi_kms) {
+			attr->cat_kms = fio->fa_end;
+			cl_valid |= CAT_KMS;
+		}
+		if (fio->fa_end > loi->loi_lvb.lvb_size) {
+			attr->cat_size = fio->fa_end;
+			cl_valid |= CAT_SIZE;
+		}
+	}
+	if (oa->o_valid & OBD_MD_FLBLOCKS) {
+		attr->cat_blocks = oa->o_blocks;
+		cl_valid |= CAT_BLOCKS;
+	}
+	cl_object_attr_update(env, obj, attr, cl_valid);
+	cl_object_attr_unlock(obj);
+}
+
 void osc_io_end(const struct lu_env *env, const struct cl_io_slice *slice)
 {
 	struct osc_io *oio = cl2osc_io(env, slice);
 
-	if (oio->oi_active) {
-		osc_extent_release(env, oio->oi_active);
-		oio->oi_active = NULL;
-	}
+	if (oio->oi_active)
+		osc_io_extent_release(env, oio);
 }
 EXPORT_SYMBOL(osc_io_end);
 
@@ -1017,6 +1106,13 @@ static const struct cl_io_operations osc_io_ops = {
 			.cio_end    = osc_io_ladvise_end,
 			.cio_fini   = osc_io_fini
 		},
+		[CIT_FALLOCATE] = {
+			.cio_iter_init = osc_io_iter_init,
+			.cio_iter_fini = osc_io_iter_fini,
+			.cio_start  = osc_io_fallocate_start,
+			.cio_end    = osc_io_fallocate_end,
+			.cio_fini   = osc_io_fini
+		},
 		[CIT_MISC] = {
 			.cio_fini   = osc_io_fini
 		}
@@ -457,6 +457,66 @@ static int osc_dlm_blocking_ast0(const struct lu_env *env,
 	RETURN(result);
 }
 
+/**
+ * Helper for osc_ldlm_blocking_ast() when \a dlmlock is shrunk by
+ * ldlm_cli_shrink() from its extent \a old, see osc_dlm_blocking_ast0().
+ * Only the pages out of the new extent are flushed.
+ */
+static int osc_dlm_shrink_ast0(const struct lu_env *env,
+			       struct ldlm_lock *dlmlock,
+			       const struct ldlm_extent *old)
+{
+	struct ldlm_extent *extent = &dlmlock->l_policy_data.l_extent;
+	struct cl_attr *attr = &osc_env_info(env)->oti_attr;
+	struct cl_object *obj = NULL;
+	enum cl_lock_mode mode = CLM_READ;
+	bool discard;
+	__u64 old_kms;
+	int result = 0;
+
+	ENTRY;
+
+	lock_res_and_lock(dlmlock);
+	discard = ldlm_is_discard_data(dlmlock);
+	if (dlmlock->l_granted_mode & (LCK_PW | LCK_GROUP))
+		mode = CLM_WRITE;
+
+	if (dlmlock->l_ast_data != NULL) {
+		obj = osc2cl(dlmlock->l_ast_data);
+		cl_object_get(obj);
+	}
+	unlock_res_and_lock(dlmlock);
+
+	if (obj == NULL)
+		RETURN(0);
+
+	if (old->start < extent->start)
+		result = osc_lock_flush(cl2osc(obj), cl_index(obj, old->start),
+					cl_index(obj, extent->start - 1),
+					mode, discard);
+	if (old->end > extent->end) {
+		int rc;
+
+		rc = osc_lock_flush(cl2osc(obj), cl_index(obj, extent->end + 1),
+				    cl_index(obj, old->end), mode, discard);
+		if (result == 0)
+			result = rc;
+	}
+
+	/* the lock does not protect its whole old extent anymore */
+	lock_res_and_lock(dlmlock);
+	cl_object_attr_lock(obj);
+	old_kms = cl2osc(obj)->oo_oinfo->loi_kms;
+	attr->cat_kms = ldlm_extent_shrink_kms(dlmlock, old_kms);
+
+	cl_object_attr_update(env, obj, attr, CAT_KMS);
+	cl_object_attr_unlock(obj);
+	unlock_res_and_lock(dlmlock);
+
+	cl_object_put(env, obj);
+	RETURN(result);
+}
+
 /**
  * Blocking ast invoked by ldlm when dlm lock is either blocking progress of
  * some other lock, or is canceled. This function is installed as a
@@ -482,7 +542,14 @@ static int osc_dlm_blocking_ast0(const struct lu_env *env,
  *
  *     - ldlm calls dlmlock->l_blocking_ast(..., LDLM_CB_BLOCKING) to notify
  *       us that dlmlock conflicts with another lock that some client is
- *       enqueuing. Lock is canceled.
+ *       enqueuing. If the server supports it and the conflicting lock does
+ *       not overlap what was requested for dlmlock, the lock is shrunk out
+ *       of the conflicting extent by ldlm_cli_shrink() which calls
+ *
+ *                  dlmlock->l_blocking_ast(..., LDLM_CB_CANCELING)
+ *
+ *       with the converting flag set, to flush pages out of the new extent.
+ *       Otherwise the lock is canceled.
  *
  *           - cl_lock_cancel() is called. osc_lock_cancel() calls
  *             ldlm_cli_cancel() that calls
@@ -509,6 +576,11 @@ static int osc_ldlm_blocking_ast(struct ldlm_lock *dlmlock,
 	switch (flag) {
 	case LDLM_CB_BLOCKING: {
 		struct lustre_handle lockh;
+		struct ldlm_extent extent;
+
+		if (ldlm_extent_shrink_range(dlmlock, new, &extent) &&
+		    ldlm_cli_shrink(dlmlock, &extent) == 0)
+			break;
 
 		ldlm_lock2handle(dlmlock, &lockh);
 		result = ldlm_cli_cancel(&lockh, LCF_ASYNC);
@@ -537,7 +609,12 @@ static int osc_ldlm_blocking_ast(struct ldlm_lock *dlmlock,
 			break;
 		}
 
-		result = osc_dlm_blocking_ast0(env, dlmlock, data, flag);
+		if (new != NULL && ldlm_is_converting(dlmlock))
+			result = osc_dlm_shrink_ast0(env, dlmlock,
+						&new->l_policy_data.l_extent);
+		else
+			result = osc_dlm_blocking_ast0(env, dlmlock, data,
+						       flag);
 		cl_env_put(env, &refcheck);
 		break;
 	}
@@ -264,6 +264,57 @@ static void osc_page_touch(const struct lu_env *env,
 	osc_page_touch_at(env, obj, osc_index(opg), to);
 }
 
+/**
+ * Only a granted PW lock which is not being canceled lets a page take a fast
+ * write. The reference taken on the lock keeps it from being canceled until
+ * the page is queued, then the cancellation has to write the page out, which
+ * waits for the page lock held by the writer.
+ */
+static int osc_page_fast_write(const struct lu_env *env,
+			       const struct cl_page_slice *slice, bool append)
+{
+	struct osc_thread_info *info = osc_env_info(env);
+	struct ldlm_res_id *resname = &info->oti_resname;
+	union ldlm_policy_data *policy = &info->oti_policy;
+	struct osc_page *opg = cl2osc_page(slice);
+	struct osc_object *osc = cl2osc(slice->cpl_obj);
+	struct ldlm_lock *dlmlock;
+	struct lustre_handle lockh;
+	enum ldlm_mode mode;
+	__u64 flags = LDLM_FL_BLOCK_GRANTED;
+	int rc = 0;
+	ENTRY;
+
+	osc_build_res_name(osc, resname);
+	osc_index2policy(policy, osc2cl(osc), osc_index(opg), osc_index(opg));
+	mode = osc_match_base(osc_export(osc), resname, LDLM_EXTENT, policy,
+			      LCK_PW, &flags, osc, &lockh, 0);
+	if (mode != LCK_PW)
+		RETURN(-ENODATA);
+
+	dlmlock = ldlm_handle2lock(&lockh);
+	LASSERT(dlmlock != NULL);
+
+	if (append && dlmlock->l_policy_data.l_extent.end != OBD_OBJECT_EOF)
+		GOTO(out, rc = -ENODATA);
+
+	/* The page may be already in dirty cache. */
+	if (list_empty(&opg->ops_oap.oap_pending_item)) {
+		osc_page_transfer_get(opg, "transfer\0cache");
+		rc = osc_queue_fast_io(env, opg, dlmlock);
+		if (rc != 0)
+			osc_page_transfer_put(env, opg);
+		else
+			osc_page_transfer_add(env, opg, CRT_WRITE);
+	}
+	EXIT;
+out:
+	ldlm_lock_decref(&lockh, mode);
+	LDLM_LOCK_PUT(dlmlock);
+
+	return rc;
+}
+
 static const struct cl_page_operations osc_page_ops = {
 	.cpo_print         = osc_page_print,
 	.cpo_delete        = osc_page_delete,
@@ -271,6 +322,7 @@ static const struct cl_page_operations osc_page_ops = {
 	.cpo_cancel         = osc_page_cancel,
 	.cpo_flush          = osc_page_flush,
 	.cpo_page_touch	   = osc_page_touch,
+	.cpo_fast_write	   = osc_page_fast_write,
 };
 
 int osc_page_init(const struct lu_env *env, struct cl_object *obj,
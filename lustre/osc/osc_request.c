@@ -45,6 +45,7 @@
 #include <obd.h>
 #include <obd_cksum.h>
 #include <obd_class.h>
+#include <obd_compr.h>
 #include <lustre_osc.h>
 
 #include "osc_internal.h"
@@ -430,6 +431,53 @@ int osc_punch_send(struct obd_export *exp, struct obdo *oa,
 }
 EXPORT_SYMBOL(osc_punch_send);
 
+/**
+ * Send an OST_FALLOCATE RPC to preallocate blocks for the object range
+ * [oa->o_size, oa->o_blocks), the reply is handled as for OST_PUNCH.
+ */
+int osc_fallocate_base(struct obd_export *exp, struct obdo *oa,
+		       obd_enqueue_update_f upcall, void *cookie)
+{
+	struct ptlrpc_request *req;
+	struct osc_setattr_args *sa;
+	struct obd_import *imp = class_exp2cliimp(exp);
+	struct ost_body *body;
+	int rc;
+
+	ENTRY;
+
+	req = ptlrpc_request_alloc(imp, &RQF_OST_FALLOCATE);
+	if (req == NULL)
+		RETURN(-ENOMEM);
+
+	rc = ptlrpc_request_pack(req, LUSTRE_OST_VERSION, OST_FALLOCATE);
+	if (rc < 0) {
+		ptlrpc_request_free(req);
+		RETURN(rc);
+	}
+
+	osc_set_io_portal(req);
+
+	ptlrpc_at_set_req_timeout(req);
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_OST_BODY);
+
+	lustre_set_wire_obdo(&imp->imp_connect_data, &body->oa, oa);
+
+	ptlrpc_request_set_replen(req);
+
+	req->rq_interpret_reply = osc_setattr_interpret;
+	CLASSERT(sizeof(*sa) <= sizeof(req->rq_async_args));
+	sa = ptlrpc_req_async_args(req);
+	sa->sa_oa = oa;
+	sa->sa_upcall = upcall;
+	sa->sa_cookie = cookie;
+
+	ptlrpcd_add_req(req);
+
+	RETURN(0);
+}
+
 static int osc_sync_interpret(const struct lu_env *env,
 			      struct ptlrpc_request *req, void *args, int rc)
 {
@@ -797,6 +845,9 @@ int osc_shrink_grant_to_target(struct client_obd *cli, __u64 target_bytes)
 	struct ost_body        *body;
 	ENTRY;
 
+	/* the grant left cached on idle CPUs can be shrunk too */
+	osc_credits_drain(cli);
+
 	spin_lock(&cli->cl_loi_list_lock);
 	/* Don't shrink if we are already above or below the desired limit
 	 * We don't want to shrink below a single RPC, as that will negatively
@@ -1282,6 +1333,130 @@ static int osc_checksum_bulk_rw(const char *obd_name,
 	RETURN(rc);
 }
 
+static struct page *osc_brw_page_from(void *array, int idx,
+				      unsigned int *offset, unsigned int *len)
+{
+	struct brw_page *pg = ((struct brw_page **)array)[idx];
+
+	*offset = pg->off & ~PAGE_MASK;
+	*len = pg->count;
+
+	return pg->pg;
+}
+
+static void osc_brw_compr_free(struct page **pages, u32 page_count)
+{
+	sptlrpc_enc_pool_put_pages_array(pages, page_count);
+	OBD_FREE_LARGE(pages, page_count * sizeof(*pages));
+}
+
+static void osc_brw_compr_stats(struct client_obd *cli, int opc, int raw_nob,
+				int wire_nob, ktime_t kstart)
+{
+	struct obd_compr_stats *stats = &cli->cl_compr_stats[opc == OST_WRITE];
+
+	atomic64_inc(&stats->ocs_rpcs);
+	atomic64_add(raw_nob, &stats->ocs_raw_bytes);
+	atomic64_add(wire_nob, &stats->ocs_wire_bytes);
+	atomic64_add(ktime_us_delta(ktime_get(), kstart), &stats->ocs_usecs);
+}
+
+/*
+ * Set up the bulk of a compressed BRW in pages of the bulk pool, the
+ * compressed stream of a write is built here, that of a read is received
+ * there and decompressed into \a pga by osc_brw_decompress().
+ *
+ * \retval the pool pages, or NULL if the data of a write does not shrink
+ *	   and has to be sent as is
+ */
+static struct page **osc_brw_compress(struct client_obd *cli, int opc,
+				      enum obd_compr_types compr_type,
+				      struct ptlrpc_bulk_desc *desc,
+				      u32 page_count, struct brw_page **pga,
+				      struct obdo *oa)
+{
+	struct page **pages;
+	ktime_t kstart = ktime_get();
+	int nob = page_count << PAGE_SHIFT;
+	int raw_nob = 0;
+	int rc;
+	int i;
+
+	OBD_ALLOC_LARGE(pages, page_count * sizeof(*pages));
+	if (pages == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	rc = sptlrpc_enc_pool_get_pages_array(pages, page_count);
+	if (rc != 0) {
+		OBD_FREE_LARGE(pages, page_count * sizeof(*pages));
+		return ERR_PTR(rc);
+	}
+
+	if (opc == OST_WRITE) {
+		for (i = 0; i < page_count; i++)
+			raw_nob += pga[i]->count;
+
+		nob = obd_compress_pages(compr_type, pga, page_count,
+					 osc_brw_page_from, pages, page_count);
+		if (nob < 0) {
+			osc_brw_compr_free(pages, page_count);
+			if (nob != -EOVERFLOW)
+				return ERR_PTR(nob);
+
+			osc_brw_compr_stats(cli, opc, raw_nob, raw_nob,
+					    kstart);
+			return NULL;
+		}
+		osc_brw_compr_stats(cli, opc, raw_nob, nob, kstart);
+		oa->o_compr_size = nob;
+	}
+
+	for (i = 0; nob > 0; i++, nob -= PAGE_SIZE)
+		desc->bd_frag_ops->add_kiov_frag(desc, pages[i], 0,
+						 min_t(int, nob, PAGE_SIZE));
+
+	return pages;
+}
+
+/*
+ * Get the \a nob bytes of data of a compressed read into the pages of the
+ * RPC, the server sends the data as is when it does not shrink.
+ *
+ * \retval \a nob on success, negative errno on failure
+ */
+static int osc_brw_decompress(struct client_obd *cli,
+			      struct osc_brw_async_args *aa,
+			      enum obd_compr_types compr_type,
+			      struct ost_body *body, int nob)
+{
+	ktime_t kstart = ktime_get();
+	int wire_nob = nob;
+	int rc;
+
+	if (compr_type == 0) {
+		rc = obd_compr_copy_pages(aa->aa_compr_pages, nob,
+					  aa->aa_ppga, aa->aa_page_count,
+					  osc_brw_page_from, false);
+	} else {
+		wire_nob = body->oa.o_compr_size;
+		rc = obd_decompress_pages(compr_type, aa->aa_compr_pages,
+					  wire_nob, aa->aa_ppga,
+					  aa->aa_page_count,
+					  osc_brw_page_from);
+	}
+	if (rc < 0)
+		return rc;
+
+	if (rc != nob) {
+		CERROR("%s: got %d bytes of compressed read, %d expected\n",
+		       cli->cl_import->imp_obd->obd_name, rc, nob);
+		return -EPROTO;
+	}
+	osc_brw_compr_stats(cli, OST_READ, nob, wire_nob, kstart);
+
+	return nob;
+}
+
 static int
 osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 		     u32 page_count, struct brw_page **pga,
@@ -1298,6 +1473,8 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
         struct brw_page *pg_prev;
 	void *short_io_buf;
 	const char *obd_name = cli->cl_import->imp_obd->obd_name;
+	enum obd_compr_types compr_type = 0;
+	struct page **compr_pages = NULL;
 
         ENTRY;
         if (OBD_FAIL_CHECK(OBD_FAIL_OSC_BRW_PREP_REQ))
@@ -1360,6 +1537,13 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 		goto no_bulk;
 	}
 
+	/* the data is compressed only on the wire, which bulk flavors of
+	 * sptlrpc do not expect */
+	if (oa->o_valid & OBD_MD_FLFLAGS &&
+	    !sptlrpc_flavor_has_bulk(&req->rq_flvr))
+		compr_type = obd_compr_type_unpack(oa->o_flags) &
+			     cli->cl_supp_compr_types;
+
 	desc = ptlrpc_prep_bulk_imp(req, page_count,
 		cli->cl_import->imp_connect_data.ocd_brw_size >> LNET_MTU_BITS,
 		(opc == OST_WRITE ? PTLRPC_BULK_GET_SOURCE :
@@ -1388,6 +1572,18 @@ no_bulk:
 	body->oa.o_uid = oa->o_uid;
 	body->oa.o_gid = oa->o_gid;
 
+	if (compr_type != 0) {
+		compr_pages = osc_brw_compress(cli, opc, compr_type, desc,
+					       page_count, pga, &body->oa);
+		if (IS_ERR(compr_pages)) {
+			rc = PTR_ERR(compr_pages);
+			compr_pages = NULL;
+			GOTO(out, rc);
+		}
+	}
+	if (compr_pages == NULL)
+		body->oa.o_flags &= ~OBD_FL_COMPR_ALL;
+
 	obdo_to_ioobj(oa, ioobj);
 	ioobj->ioo_bufcnt = niocount;
 	/* The high bits of ioo_max_brw tells server _maximum_ number of bulks
@@ -1447,7 +1643,7 @@ no_bulk:
 			       ptr + poff,
 			       pg->count);
 			ll_kunmap_atomic(ptr, KM_USER0);
-		} else if (short_io_size == 0) {
+		} else if (short_io_size == 0 && compr_pages == NULL) {
 			desc->bd_frag_ops->add_kiov_frag(desc, pg->pg, poff,
 							 pg->count);
 		}
@@ -1547,6 +1743,7 @@ no_bulk:
 	aa->aa_resends = 0;
 	aa->aa_ppga = pga;
 	aa->aa_cli = cli;
+	aa->aa_compr_pages = compr_pages;
 	INIT_LIST_HEAD(&aa->aa_oaps);
 
 	*reqp = req;
@@ -1557,6 +1754,8 @@ no_bulk:
         RETURN(0);
 
  out:
+	if (compr_pages != NULL)
+		osc_brw_compr_free(compr_pages, page_count);
         ptlrpc_req_finished(req);
         RETURN(rc);
 }
@@ -1720,6 +1919,7 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 	const struct lnet_process_id *peer =
 		&req->rq_import->imp_connection->c_peer;
 	struct ost_body *body;
+	enum obd_compr_types compr_type = 0;
 	u32 client_cksum = 0;
         ENTRY;
 
@@ -1795,12 +1995,24 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
                 RETURN(-EPROTO);
         }
 
-	if (req->rq_bulk != NULL && rc != req->rq_bulk->bd_nob_transferred) {
-                CERROR ("Unexpected rc %d (%d transferred)\n",
-                        rc, req->rq_bulk->bd_nob_transferred);
-                return (-EPROTO);
+	if (aa->aa_compr_pages != NULL && body->oa.o_valid & OBD_MD_FLFLAGS)
+		compr_type = obd_compr_type_unpack(body->oa.o_flags);
+
+	if (req->rq_bulk != NULL &&
+	    (compr_type != 0 ? body->oa.o_compr_size : rc) !=
+	    req->rq_bulk->bd_nob_transferred) {
+		CERROR("Unexpected rc %d (%d transferred, %u compressed)\n",
+		       rc, req->rq_bulk->bd_nob_transferred,
+		       compr_type != 0 ? body->oa.o_compr_size : 0);
+		return (-EPROTO);
         }
 
+	if (aa->aa_compr_pages != NULL) {
+		rc = osc_brw_decompress(cli, aa, compr_type, body, rc);
+		if (rc < 0)
+			RETURN(rc);
+	}
+
 	if (req->rq_bulk == NULL) {
 		/* short io */
 		int nob, pg_count, i = 0;
@@ -1917,6 +2129,7 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
         struct ptlrpc_request *new_req;
         struct osc_brw_async_args *new_aa;
         struct osc_async_page *oap;
+	struct page **compr_pages;
         ENTRY;
 
 	DEBUG_REQ(rc == -EINPROGRESS ? D_RPCTRACE : D_ERROR, request,
@@ -1935,6 +2148,11 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
                                  "request %p != oap_request %p\n",
                                  request, oap->oap_request);
                         if (oap->oap_interrupted) {
+				new_aa = ptlrpc_req_async_args(new_req);
+				if (new_aa->aa_compr_pages != NULL)
+					osc_brw_compr_free(
+						new_aa->aa_compr_pages,
+						aa->aa_page_count);
                                 ptlrpc_req_finished(new_req);
                                 RETURN(-EINTR);
                         }
@@ -1945,8 +2163,15 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
 	 * Note that copying a list_head doesn't work, need to move it...
 	 */
 	aa->aa_resends++;
+	new_aa = ptlrpc_req_async_args(new_req);
+	compr_pages = new_aa->aa_compr_pages;
+	if (aa->aa_compr_pages != NULL) {
+		osc_brw_compr_free(aa->aa_compr_pages, aa->aa_page_count);
+		aa->aa_compr_pages = NULL;
+	}
 	new_req->rq_interpret_reply = request->rq_interpret_reply;
 	new_req->rq_async_args = request->rq_async_args;
+	new_aa->aa_compr_pages = compr_pages;
 	new_req->rq_commit_cb = request->rq_commit_cb;
 	/* cap resend delay to the current request timeout, this is similar to
 	 * what ptlrpc does (see after_reply()) */
@@ -1957,8 +2182,6 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
         new_req->rq_generation_set = 1;
         new_req->rq_import_generation = request->rq_import_generation;
 
-        new_aa = ptlrpc_req_async_args(new_req);
-
 	INIT_LIST_HEAD(&new_aa->aa_oaps);
 	list_splice_init(&aa->aa_oaps, &new_aa->aa_oaps);
 	INIT_LIST_HEAD(&new_aa->aa_exts);
@@ -2019,6 +2242,94 @@ static void osc_release_ppga(struct brw_page **ppga, size_t count)
         OBD_FREE(ppga, sizeof(*ppga) * count);
 }
 
+/* estimated RPCs queued on the OST below which the RPC window grows */
+#define OSC_RPC_WINDOW_ALPHA	1
+/* estimated RPCs queued on the OST above which the RPC window shrinks */
+#define OSC_RPC_WINDOW_BETA	3
+/* rounds after which the base service time is measured again */
+#define OSC_RPC_WINDOW_ROUNDS	64
+/* the RPC window doesn't shrink below this number of RPCs in flight */
+#define OSC_RPC_WINDOW_MIN_RPCS	4
+/* the RPC window doesn't shrink below this RPC size, in bytes */
+#define OSC_RPC_WINDOW_MIN_SIZE	(1 << 20)
+
+/**
+ * Latency-driven congestion control of the BRW RPCs, in the spirit of TCP
+ * Vegas. The service time of each RPC, per MB of data, is compared with the
+ * lowest one seen, which estimates the service time of an idle OST. After
+ * every round of as many RPCs as the window allows in flight, the number of
+ * RPCs queued on the OST is estimated as rpcs * (1 - base / average): below
+ * OSC_RPC_WINDOW_ALPHA the window grows, first the RPC size and then the
+ * RPCs in flight, up to max_pages_per_rpc and max_rpcs_in_flight; above
+ * OSC_RPC_WINDOW_BETA it shrinks, first the RPCs in flight.
+ *
+ * caller must hold loi_list_lock
+ */
+static void osc_rpc_window_update(struct client_obd *cli, s64 usecs,
+				  unsigned long bytes)
+{
+	struct client_rpc_window *rw = &cli->cl_rpc_window;
+	u32 chunk_pages = 1 << (cli->cl_chunkbits - PAGE_SHIFT);
+	u32 max_rpcs = cli->cl_max_rpcs_in_flight;
+	u32 max_pages = cli->cl_max_pages_per_rpc;
+	u32 min_rpcs;
+	u32 min_pages;
+	u64 rtt;
+	u64 queued;
+
+	assert_spin_locked(&cli->cl_loi_list_lock);
+	if (bytes == 0 || usecs <= 0)
+		return;
+
+	rtt = max_t(u64, div64_u64((u64)usecs << 20, bytes), 1);
+	if (rw->rw_samples == 0 || rtt < rw->rw_round_min_us)
+		rw->rw_round_min_us = rtt;
+	if (rw->rw_base_us == 0 || rtt < rw->rw_base_us)
+		rw->rw_base_us = rtt;
+	rw->rw_round_us += rtt;
+
+	/* the bounds may have been changed by the administrator */
+	rw->rw_rpcs = min(rw->rw_rpcs, max_rpcs);
+	rw->rw_pages = min(rw->rw_pages, max_pages);
+	if (++rw->rw_samples < rw->rw_rpcs)
+		return;
+
+	rtt = div_u64(rw->rw_round_us, rw->rw_samples);
+	rw->rw_last_us = rtt;
+	queued = div64_u64((u64)rw->rw_rpcs * (rtt - min(rtt, rw->rw_base_us)),
+			   rtt);
+
+	min_rpcs = min_t(u32, OSC_RPC_WINDOW_MIN_RPCS, max_rpcs);
+	min_pages = min_t(u32, OSC_RPC_WINDOW_MIN_SIZE >> PAGE_SHIFT,
+			  max_pages);
+	min_pages = max(min_pages & ~(chunk_pages - 1), chunk_pages);
+
+	if (queued < OSC_RPC_WINDOW_ALPHA) {
+		if (rw->rw_pages < max_pages)
+			rw->rw_pages = min(rw->rw_pages * 2, max_pages);
+		else if (rw->rw_rpcs < max_rpcs)
+			rw->rw_rpcs++;
+	} else if (queued > OSC_RPC_WINDOW_BETA) {
+		if (rw->rw_rpcs > min_rpcs)
+			rw->rw_rpcs--;
+		else if (rw->rw_pages > min_pages)
+			rw->rw_pages = max((rw->rw_pages / 2) &
+					   ~(chunk_pages - 1), min_pages);
+	}
+	CDEBUG(D_CACHE, "%s: service time %llu/%llu usec/MB, window %u RPCs "
+	       "of %u pages\n", cli_name(cli), rtt, rw->rw_base_us,
+	       rw->rw_rpcs, rw->rw_pages);
+
+	/* the OST may be idle at a different speed by now, e.g. after its
+	 * disks were rebuilt, so measure the base again from time to time */
+	if (++rw->rw_rounds >= OSC_RPC_WINDOW_ROUNDS) {
+		rw->rw_base_us = rw->rw_round_min_us;
+		rw->rw_rounds = 0;
+	}
+	rw->rw_samples = 0;
+	rw->rw_round_us = 0;
+}
+
 static int brw_interpret(const struct lu_env *env,
 			 struct ptlrpc_request *req, void *args, int rc)
 {
@@ -2127,6 +2438,8 @@ static int brw_interpret(const struct lu_env *env,
 		       aa->aa_requested_nob :
 		       req->rq_bulk->bd_nob_transferred);
 
+	if (aa->aa_compr_pages != NULL)
+		osc_brw_compr_free(aa->aa_compr_pages, aa->aa_page_count);
 	osc_release_ppga(aa->aa_ppga, aa->aa_page_count);
 	ptlrpc_lprocfs_brw(req, transferred);
 
@@ -2138,6 +2451,11 @@ static int brw_interpret(const struct lu_env *env,
 		cli->cl_w_in_flight--;
 	else
 		cli->cl_r_in_flight--;
+	if (rc == 0 && cli->cl_rpc_window.rw_enabled)
+		osc_rpc_window_update(cli,
+				      ktime_us_delta(ktime_get_real(),
+						     req->rq_sent_ns),
+				      transferred);
 	osc_wake_cache_waiters(cli);
 	spin_unlock(&cli->cl_loi_list_lock);
 
@@ -2271,6 +2589,16 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 		}
 	}
 
+	/* ask for the bulk data to be compressed on the wire, it is up to
+	 * osc_brw_prep_request() to do it if the RPC allows */
+	if (obj->oo_oinfo->loi_compress && cli->cl_supp_compr_types != 0) {
+		if (!(oa->o_valid & OBD_MD_FLFLAGS)) {
+			oa->o_valid |= OBD_MD_FLFLAGS;
+			oa->o_flags = 0;
+		}
+		oa->o_flags |= obd_compr_type_pack(cli->cl_supp_compr_types);
+	}
+
 	sort_brw_pages(pga, page_count);
 	rc = osc_brw_prep_request(cmd, cli, oa, page_count, pga, &req, 0);
 	if (rc != 0) {
@@ -3034,11 +3362,9 @@ int osc_disconnect(struct obd_export *exp)
 }
 EXPORT_SYMBOL(osc_disconnect);
 
-int osc_ldlm_resource_invalidate(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-				 struct hlist_node *hnode, void *arg)
+int osc_ldlm_resource_invalidate(struct ldlm_resource *res, void *arg)
 {
 	struct lu_env *env = arg;
-	struct ldlm_resource *res = cfs_hash_object(hs, hnode);
 	struct ldlm_lock *lock;
 	struct osc_object *osc = NULL;
 	ENTRY;
@@ -3098,11 +3424,12 @@ static int osc_import_event(struct obd_device *obd,
 
                 env = cl_env_get(&refcheck);
                 if (!IS_ERR(env)) {
+			osc_credits_drain(&obd->u.cli);
 			osc_io_unplug(env, &obd->u.cli, NULL);
 
-			cfs_hash_for_each_nolock(ns->ns_rs_hash,
-						 osc_ldlm_resource_invalidate,
-						 env, 0);
+			ldlm_namespace_res_foreach(ns,
+						osc_ldlm_resource_invalidate,
+						env);
 			cl_env_put(env, &refcheck);
 
 			ldlm_namespace_cleanup(ns, LDLM_FL_LOCAL_ONLY);
@@ -3176,6 +3503,7 @@ int osc_setup_common(struct obd_device *obd, struct lustre_cfg *lcfg)
 {
 	struct client_obd *cli = &obd->u.cli;
 	void *handler;
+	int cpu;
 	int rc;
 
 	ENTRY;
@@ -3188,6 +3516,11 @@ int osc_setup_common(struct obd_device *obd, struct lustre_cfg *lcfg)
 	if (rc)
 		GOTO(out_ptlrpcd, rc);
 
+	cli->cl_credits = alloc_percpu(struct client_obd_credits);
+	if (cli->cl_credits == NULL)
+		GOTO(out_ptlrpcd_work, rc = -ENOMEM);
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(cli->cl_credits, cpu)->cc_lock);
 
 	handler = ptlrpcd_alloc_work(cli->cl_import, brw_queue_work, cli);
 	if (IS_ERR(handler))
@@ -3217,6 +3550,10 @@ out_ptlrpcd_work:
 		ptlrpcd_destroy_work(cli->cl_lru_work);
 		cli->cl_lru_work = NULL;
 	}
+	if (cli->cl_credits != NULL) {
+		free_percpu(cli->cl_credits);
+		cli->cl_credits = NULL;
+	}
 	client_obd_cleanup(obd);
 out_ptlrpcd:
 	ptlrpcd_decref();
@@ -3333,6 +3670,12 @@ int osc_cleanup_common(struct obd_device *obd)
 	/* free memory of osc quota cache */
 	osc_quota_cleanup(obd);
 
+	if (cli->cl_credits != NULL) {
+		osc_credits_drain(cli);
+		free_percpu(cli->cl_credits);
+		cli->cl_credits = NULL;
+	}
+
 	rc = client_obd_cleanup(obd);
 
 	ptlrpcd_decref();
@@ -2010,6 +2010,9 @@ static int osd_trans_stop(const struct lu_env *env, struct dt_device *dt,
 		osd_trans_stop_cb(oh, rc);
 		/* hook functions might modify th_sync */
 		hdl->h_sync = th->th_sync;
+		if (hdl->h_sync)
+			lprocfs_counter_incr(osd->od_stats,
+					     LPROC_OSD_SYNC_TRANS);
 
 		oh->ot_handle = NULL;
 		OSD_CHECK_SLOW_TH(oh, osd, rc2 = ldiskfs_journal_stop(hdl));
@@ -445,6 +445,7 @@ enum {
         LPROC_OSD_CACHE_ACCESS  = 4,
         LPROC_OSD_CACHE_HIT     = 5,
         LPROC_OSD_CACHE_MISS    = 6,
+        LPROC_OSD_SYNC_TRANS    = 7,
 
 #if OSD_THANDLE_STATS
         LPROC_OSD_THANDLE_STARTING,
@@ -1263,6 +1263,157 @@ cleanup:
 }
 #endif /* HAVE_LDISKFS_MAP_BLOCKS */
 
+#ifndef LDISKFS_GET_BLOCKS_CREATE_UNWRIT_EXT
+# define LDISKFS_GET_BLOCKS_CREATE_UNWRIT_EXT \
+	 LDISKFS_GET_BLOCKS_CREATE_UNINIT_EXT
+#endif
+#ifndef EXT_UNWRITTEN_MAX_LEN
+# define EXT_UNWRITTEN_MAX_LEN	EXT_UNINIT_MAX_LEN
+#endif
+
+/*
+ * Credits to allocate one unwritten extent: the extent can go into a new
+ * leaf causing a split at each level of the tree, and dirty one bitmap and
+ * one group descriptor.
+ */
+static int osd_fallocate_extent_credits(struct inode *inode)
+{
+	int depth;
+
+	/* many concurrent threads may grow tree by the time
+	 * our transaction starts. so, consider 2 is a min depth */
+	depth = max(ext_depth(inode), 1) + 1;
+
+	return depth * 2 + 2;
+}
+
+static int osd_declare_fallocate(const struct lu_env *env,
+				 struct dt_object *dt, __u64 start, __u64 end,
+				 int mode, struct thandle *th)
+{
+	struct osd_device	*osd = osd_obj2dev(osd_dt_obj(dt));
+	struct inode		*inode = osd_dt_obj(dt)->oo_inode;
+	struct osd_thandle	*oh;
+	long long		 quota_space;
+	__u64			 blocks;
+	__u64			 extents;
+	int			 credits;
+	int			 rc;
+	ENTRY;
+
+	LASSERT(th);
+	LASSERT(inode);
+	oh = container_of(th, struct osd_thandle, ot_super);
+
+	/* unwritten extents can't be described by a block map */
+	if (!(LDISKFS_I(inode)->i_flags & LDISKFS_EXTENTS_FL))
+		RETURN(-EOPNOTSUPP);
+
+	blocks = ((end + (1 << inode->i_blkbits) - 1) >> inode->i_blkbits) -
+		 (start >> inode->i_blkbits);
+	extents = (blocks + EXT_UNWRITTEN_MAX_LEN - 1) / EXT_UNWRITTEN_MAX_LEN;
+
+	/* a large range can need more credits than a single transaction may
+	 * have, osd_fallocate() extends or restarts the handle as it goes */
+	credits = min_t(__u64, osd_transaction_size(osd),
+			osd_fallocate_extent_credits(inode) * extents + 1);
+
+	osd_trans_declare_op(env, oh, OSD_OT_WRITE, credits);
+
+	/* already allocated blocks are charged again, as in
+	 * osd_declare_write_commit() for unmapped pages */
+	quota_space = (blocks + ext_depth(inode) * extents) <<
+		      inode->i_blkbits;
+	quota_space = toqb(quota_space);
+
+	rc = osd_declare_inode_qid(env, i_uid_read(inode), i_gid_read(inode),
+				   i_projid_read(inode), quota_space, oh,
+				   osd_dt_obj(dt), NULL, OSD_QID_BLK);
+	if (rc == 0)
+		rc = osd_trunc_lock(osd_dt_obj(dt), oh, true);
+
+	RETURN(rc);
+}
+
+/*
+ * Preallocate [start, end) of the object as unwritten extents, which read
+ * back as zeroes until they are written. Already allocated blocks in the
+ * range are left as they are. The object size is not changed here, the OFD
+ * sets it through ->do_attr_set() if needed.
+ */
+static int osd_fallocate(const struct lu_env *env, struct dt_object *dt,
+			 __u64 start, __u64 end, int mode, struct thandle *th)
+{
+#ifdef HAVE_LDISKFS_MAP_BLOCKS
+	struct osd_object	*obj = osd_dt_obj(dt);
+	struct inode		*inode = obj->oo_inode;
+	struct osd_thandle	*oh;
+	handle_t		*handle;
+	__u64			 blk;
+	__u64			 last;
+	int			 credits;
+	int			 rc = 0;
+	ENTRY;
+
+	LASSERT(dt_object_exists(dt));
+	LASSERT(osd_invariant(obj));
+	LASSERT(inode != NULL);
+	ll_vfs_dq_init(inode);
+
+	LASSERT(th);
+	oh = container_of(th, struct osd_thandle, ot_super);
+	handle = oh->ot_handle;
+	LASSERT(handle->h_transaction != NULL);
+
+	if (end > inode->i_sb->s_maxbytes)
+		RETURN(-EFBIG);
+
+	osd_trans_exec_op(env, th, OSD_OT_WRITE);
+
+	blk = start >> inode->i_blkbits;
+	last = (end + (1 << inode->i_blkbits) - 1) >> inode->i_blkbits;
+	credits = osd_fallocate_extent_credits(inode) + 1;
+
+	while (blk < last) {
+		struct ldiskfs_map_blocks map = { 0 };
+
+		map.m_lblk = blk;
+		map.m_len = min_t(__u64, last - blk, EXT_UNWRITTEN_MAX_LEN);
+
+		/* mballoc may return fewer blocks than asked for, so more
+		 * extents than declared may be needed */
+		if (!ldiskfs_handle_has_enough_credits(handle, credits)) {
+			rc = ldiskfs_journal_extend(handle, credits);
+			if (rc > 0)
+				rc = ldiskfs_journal_restart(handle, credits);
+			if (rc != 0)
+				break;
+		}
+
+		rc = ldiskfs_map_blocks(handle, inode, &map,
+					LDISKFS_GET_BLOCKS_CREATE_UNWRIT_EXT);
+		if (rc <= 0) {
+			CDEBUG(D_INODE, "inode %lu: cannot preallocate %u "
+			       "blocks at %u: rc = %d\n", inode->i_ino,
+			       map.m_len, map.m_lblk, rc);
+			if (rc == 0)
+				rc = -EIO;
+			break;
+		}
+		blk += rc;
+		rc = 0;
+	}
+
+	ll_dirty_inode(inode, I_DIRTY_DATASYNC);
+
+	osd_trans_exec_check(env, th, OSD_OT_WRITE);
+
+	RETURN(rc);
+#else
+	return -EOPNOTSUPP;
+#endif
+}
+
 static int osd_write_prep(const struct lu_env *env, struct dt_object *dt,
                           struct niobuf_local *lnb, int npages)
 {
@@ -2306,6 +2457,8 @@ const struct dt_body_operations osd_body_ops = {
 	.dbo_punch			= osd_punch,
 	.dbo_fiemap_get			= osd_fiemap_get,
 	.dbo_ladvise			= osd_ladvise,
+	.dbo_declare_fallocate		= osd_declare_fallocate,
+	.dbo_fallocate			= osd_fallocate,
 };
 
 /**
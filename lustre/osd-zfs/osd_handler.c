@@ -332,6 +332,7 @@ static int osd_trans_stop(const struct lu_env *env, struct dt_device *dt,
 	osd_unlinked_list_emptify(env, osd, &unlinked, true);
 
 	if (sync) {
+		lprocfs_counter_incr(osd->od_stats, LPROC_OSD_SYNC_TRANS);
 		if (osd_txg_sync_delay_us < 0)
 			txg_wait_synced(dmu_objset_pool(osd->od_os), txg);
 		else
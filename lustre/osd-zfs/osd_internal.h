@@ -593,6 +593,7 @@ enum {
 	LPROC_OSD_COPY_IO = 7,
 	LPROC_OSD_ZEROCOPY_IO = 8,
 	LPROC_OSD_TAIL_IO = 9,
+	LPROC_OSD_SYNC_TRANS = 10,
 	LPROC_OSD_LAST,
 };
 
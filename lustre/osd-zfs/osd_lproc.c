@@ -186,6 +186,9 @@ static int osd_stats_init(struct osd_device *osd)
 		lprocfs_counter_init(osd->od_stats, LPROC_OSD_TAIL_IO,
 				LPROCFS_CNTR_AVGMINMAX,
 				"tail", "pages");
+		lprocfs_counter_init(osd->od_stats, LPROC_OSD_SYNC_TRANS,
+				LPROCFS_CNTR_AVGMINMAX,
+				"sync_trans", "trans");
 #ifdef OSD_THANDLE_STATS
 		lprocfs_counter_init(osd->od_stats, LPROC_OSD_THANDLE_STARTING,
 				LPROCFS_CNTR_AVGMINMAX,
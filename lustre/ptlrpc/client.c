@@ -472,34 +472,6 @@ __must_hold(&req->rq_lock)
 	RETURN(rc);
 }
 
-static struct kmem_cache *request_cache;
-
-int ptlrpc_request_cache_init(void)
-{
-	request_cache = kmem_cache_create("ptlrpc_cache",
-					  sizeof(struct ptlrpc_request),
-					  0, SLAB_HWCACHE_ALIGN, NULL);
-	return request_cache == NULL ? -ENOMEM : 0;
-}
-
-void ptlrpc_request_cache_fini(void)
-{
-	kmem_cache_destroy(request_cache);
-}
-
-struct ptlrpc_request *ptlrpc_request_cache_alloc(gfp_t flags)
-{
-	struct ptlrpc_request *req;
-
-	OBD_SLAB_ALLOC_PTR_GFP(req, request_cache, flags);
-	return req;
-}
-
-void ptlrpc_request_cache_free(struct ptlrpc_request *req)
-{
-	OBD_SLAB_FREE_PTR(req, request_cache);
-}
-
 /**
  * Wind down request pool \a pool.
  * Frees all requests from the pool too
@@ -982,8 +954,7 @@ struct ptlrpc_request_set *ptlrpc_prep_set(void)
 	init_waitqueue_head(&set->set_waitq);
 	atomic_set(&set->set_new_count, 0);
 	atomic_set(&set->set_remaining, 0);
-	spin_lock_init(&set->set_new_req_lock);
-	INIT_LIST_HEAD(&set->set_new_requests);
+	init_llist_head(&set->set_new_requests);
 	set->set_max_inflight = UINT_MAX;
 	set->set_producer     = NULL;
 	set->set_producer_arg = NULL;
@@ -1115,32 +1086,24 @@ EXPORT_SYMBOL(ptlrpc_set_add_req);
 void ptlrpc_set_add_new_req(struct ptlrpcd_ctl *pc,
                            struct ptlrpc_request *req)
 {
-        struct ptlrpc_request_set *set = pc->pc_set;
-        int count, i;
+	struct ptlrpc_request_set *set = pc->pc_set;
 
-        LASSERT(req->rq_set == NULL);
+	LASSERT(req->rq_set == NULL);
 	LASSERT(test_bit(LIOD_STOP, &pc->pc_flags) == 0);
 
-	spin_lock(&set->set_new_req_lock);
 	/*
 	 * The set takes over the caller's request reference.
 	 */
 	req->rq_set = set;
 	req->rq_queued_time = ktime_get_seconds();
-	list_add_tail(&req->rq_set_chain, &set->set_new_requests);
-	count = atomic_inc_return(&set->set_new_count);
-	spin_unlock(&set->set_new_req_lock);
+	req->rq_queued_ns = ktime_get();
+	/* the count is raised first so it never goes below the number of
+	 * requests in the list, see ptlrpcd_fold_new() */
+	atomic_inc(&set->set_new_count);
 
 	/* Only need to call wakeup once for the first entry. */
-	if (count == 1) {
-		wake_up(&set->set_waitq);
-
-		/* XXX: It maybe unnecessary to wakeup all the partners. But to
-		 *      guarantee the async RPC can be processed ASAP, we have
-		 *      no other better choice. It maybe fixed in future. */
-		for (i = 0; i < pc->pc_npartners; i++)
-			wake_up(&pc->pc_partners[i]->pc_set->set_waitq);
-	}
+	if (llist_add(&req->rq_new_node, &set->set_new_requests))
+		ptlrpcd_wake_new(pc);
 }
 
 /**
@@ -1290,6 +1253,75 @@ static int ptlrpc_check_status(struct ptlrpc_request *req)
         RETURN(err);
 }
 
+/**
+ * Prepare the request message of \a req to be sent as a sub-request of a
+ * batched RPC, as ptl_send_rpc() would do before sending it on its own.
+ */
+void ptlrpc_sub_req_prep(struct ptlrpc_request *req)
+{
+	struct obd_import *imp = req->rq_import;
+
+	lustre_msg_set_handle(req->rq_reqmsg, &imp->imp_remote_handle);
+	lustre_msg_set_type(req->rq_reqmsg, PTL_RPC_MSG_REQUEST);
+	lustre_msg_set_conn_cnt(req->rq_reqmsg, imp->imp_conn_cnt);
+	lustre_msghdr_set_flags(req->rq_reqmsg, imp->imp_msghdr_flags);
+	lustre_msg_set_jobid(req->rq_reqmsg, NULL);
+}
+EXPORT_SYMBOL(ptlrpc_sub_req_prep);
+
+/**
+ * Attach the reply message \a msg of \a len bytes, returned for the
+ * sub-request \a req within the reply of a batched RPC, to \a req as if
+ * it was received for \a req itself.
+ *
+ * \retval the status of the sub-request, as after_reply() returns it
+ */
+int ptlrpc_sub_req_reply(struct ptlrpc_request *req, struct lustre_msg *msg,
+			 int len)
+{
+	int rc;
+	ENTRY;
+
+	LASSERT(req->rq_repbuf == NULL);
+
+	rc = sptlrpc_cli_alloc_repbuf(req, len);
+	if (rc)
+		RETURN(rc);
+
+	memcpy(req->rq_repbuf, msg, len);
+	req->rq_repdata = req->rq_repbuf;
+	req->rq_repdata_len = len;
+	req->rq_nob_received = len;
+	req->rq_repmsg = req->rq_repdata;
+	req->rq_rep_swab_mask = 0;
+
+	rc = ptlrpc_unpack_rep_msg(req, len);
+	if (rc == 0)
+		rc = lustre_unpack_rep_ptlrpc_body(req, MSG_PTLRPC_BODY_OFF);
+	if (rc != 0) {
+		DEBUG_REQ(D_ERROR, req, "unpack sub-reply failed: %d", rc);
+		RETURN(-EPROTO);
+	}
+
+	if (lustre_msg_get_type(req->rq_repmsg) != PTL_RPC_MSG_REPLY &&
+	    lustre_msg_get_type(req->rq_repmsg) != PTL_RPC_MSG_ERR) {
+		DEBUG_REQ(D_ERROR, req, "invalid sub-reply received (type=%u)",
+			  lustre_msg_get_type(req->rq_repmsg));
+		RETURN(-EPROTO);
+	}
+
+	spin_lock(&req->rq_lock);
+	req->rq_replied = 1;
+	spin_unlock(&req->rq_lock);
+
+	rc = ptlrpc_check_status(req);
+	if (rc == 0)
+		ldlm_cli_update_pool(req);
+
+	RETURN(rc);
+}
+EXPORT_SYMBOL(ptlrpc_sub_req_reply);
+
 /**
  * save pre-versions of objects into request for replay.
  * Versions are obtained from server reply.
@@ -45,6 +45,7 @@
 #include <lustre_export.h>
 #include <obd.h>
 #include <obd_cksum.h>
+#include <obd_compr.h>
 #include <obd_class.h>
 
 #include "ptlrpc_internal.h"
@@ -861,6 +862,15 @@ static int ptlrpc_connect_set_flags(struct obd_import *imp,
 	cli->cl_cksum_type = obd_cksum_type_select(imp->imp_obd->obd_name,
 						   cli->cl_supp_cksum_types);
 
+	/* The server masked off the compression types it doesn't support in
+	 * the ocd_compr_types we sent, as for checksums */
+	if (OCD_HAS_FLAG(ocd, FLAGS2) &&
+	    ocd->ocd_connect_flags2 & OBD_CONNECT2_COMPRESS)
+		cli->cl_supp_compr_types = ocd->ocd_compr_types &
+					   obd_compr_types_supported();
+	else
+		cli->cl_supp_compr_types = 0;
+
 	if (ocd->ocd_connect_flags & OBD_CONNECT_BRW_SIZE)
 		cli->cl_max_pages_per_rpc =
 			min(ocd->ocd_brw_size >> PAGE_SHIFT,
@@ -397,6 +397,12 @@ static const struct req_msg_field *ldlm_gl_callback_server[] = {
         &RMF_DLM_LVB
 };
 
+/* the reply lists the handles of the locks the client no longer has */
+static const struct req_msg_field *ldlm_bl_callback_batch_server[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_DLM_REQ
+};
+
 static const struct req_msg_field *ldlm_intent_basic_client[] = {
 	&RMF_PTLRPC_BODY,
 	&RMF_DLM_REQ,
@@ -548,6 +554,16 @@ static const struct req_msg_field *mds_update_server[] = {
 	&RMF_OUT_UPDATE_REPLY,
 };
 
+static const struct req_msg_field *mds_batch_client[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_BATCH_UPDATE_REQUEST,
+};
+
+static const struct req_msg_field *mds_batch_server[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_BATCH_UPDATE_REPLY,
+};
+
 static const struct req_msg_field *llog_origin_handle_create_client[] = {
         &RMF_PTLRPC_BODY,
         &RMF_LLOGD_BODY,
@@ -559,6 +575,12 @@ static const struct req_msg_field *llogd_body_only[] = {
         &RMF_LLOGD_BODY
 };
 
+static const struct req_msg_field *llog_origin_handle_next_block_client[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_LLOGD_BODY,
+	&RMF_LLOGD_CHLG_FILTER
+};
+
 static const struct req_msg_field *llog_log_hdr_only[] = {
         &RMF_PTLRPC_BODY,
         &RMF_LLOG_LOG_HDR
@@ -766,6 +788,7 @@ static struct req_format *req_formats[] = {
 	&RQF_MDS_HSM_ACTION,
 	&RQF_MDS_HSM_REQUEST,
 	&RQF_MDS_SWAP_LAYOUTS,
+	&RQF_MDS_BATCH,
 	&RQF_OUT_UPDATE,
 	&RQF_OST_CONNECT,
 	&RQF_OST_DISCONNECT,
@@ -786,6 +809,7 @@ static struct req_format *req_formats[] = {
 	&RQF_OST_SET_INFO_LAST_FID,
 	&RQF_OST_GET_INFO_FIEMAP,
 	&RQF_OST_LADVISE,
+	&RQF_OST_FALLOCATE,
 	&RQF_LDLM_ENQUEUE,
 	&RQF_LDLM_ENQUEUE_LVB,
 	&RQF_LDLM_CONVERT,
@@ -793,6 +817,7 @@ static struct req_format *req_formats[] = {
 	&RQF_LDLM_CALLBACK,
 	&RQF_LDLM_CP_CALLBACK,
 	&RQF_LDLM_BL_CALLBACK,
+	&RQF_LDLM_BL_CALLBACK_BATCH,
 	&RQF_LDLM_GL_CALLBACK,
 	&RQF_LDLM_GL_CALLBACK_DESC,
 	&RQF_LDLM_INTENT,
@@ -1007,6 +1032,12 @@ struct req_msg_field RMF_LLOGD_BODY =
                     sizeof(struct llogd_body), lustre_swab_llogd_body, NULL);
 EXPORT_SYMBOL(RMF_LLOGD_BODY);
 
+struct req_msg_field RMF_LLOGD_CHLG_FILTER =
+	DEFINE_MSGF("llogd_chlg_filter", 0,
+		    sizeof(struct llogd_chlg_filter),
+		    lustre_swab_llogd_chlg_filter, NULL);
+EXPORT_SYMBOL(RMF_LLOGD_CHLG_FILTER);
+
 struct req_msg_field RMF_LLOG_LOG_HDR =
         DEFINE_MSGF("llog_log_hdr", 0,
                     sizeof(struct llog_log_hdr), lustre_swab_llog_hdr, NULL);
@@ -1247,6 +1278,16 @@ struct req_msg_field RMF_OUT_UPDATE_BUF = DEFINE_MSGF("update_buf",
 			lustre_swab_out_update_buffer, NULL);
 EXPORT_SYMBOL(RMF_OUT_UPDATE_BUF);
 
+struct req_msg_field RMF_BATCH_UPDATE_REQUEST =
+	DEFINE_MSGF("batch_update_request", 0, -1,
+		    lustre_swab_batch_update_header, NULL);
+EXPORT_SYMBOL(RMF_BATCH_UPDATE_REQUEST);
+
+struct req_msg_field RMF_BATCH_UPDATE_REPLY =
+	DEFINE_MSGF("batch_update_reply", 0, -1,
+		    lustre_swab_batch_update_header, NULL);
+EXPORT_SYMBOL(RMF_BATCH_UPDATE_REPLY);
+
 /*
  * Request formats.
  */
@@ -1500,6 +1541,11 @@ struct req_format RQF_LDLM_BL_CALLBACK =
         DEFINE_REQ_FMT0("LDLM_BL_CALLBACK", ldlm_enqueue_client, empty);
 EXPORT_SYMBOL(RQF_LDLM_BL_CALLBACK);
 
+struct req_format RQF_LDLM_BL_CALLBACK_BATCH =
+	DEFINE_REQ_FMT0("LDLM_BL_CALLBACK_BATCH", ldlm_enqueue_client,
+			ldlm_bl_callback_batch_server);
+EXPORT_SYMBOL(RQF_LDLM_BL_CALLBACK_BATCH);
+
 struct req_format RQF_LDLM_GL_CALLBACK =
         DEFINE_REQ_FMT0("LDLM_GL_CALLBACK", ldlm_enqueue_client,
                         ldlm_gl_callback_server);
@@ -1595,14 +1641,19 @@ struct req_format RQF_MDS_SWAP_LAYOUTS =
 			mdt_swap_layouts, empty);
 EXPORT_SYMBOL(RQF_MDS_SWAP_LAYOUTS);
 
+struct req_format RQF_MDS_BATCH =
+	DEFINE_REQ_FMT0("MDS_BATCH", mds_batch_client, mds_batch_server);
+EXPORT_SYMBOL(RQF_MDS_BATCH);
+
 struct req_format RQF_LLOG_ORIGIN_HANDLE_CREATE =
         DEFINE_REQ_FMT0("LLOG_ORIGIN_HANDLE_CREATE",
                         llog_origin_handle_create_client, llogd_body_only);
 EXPORT_SYMBOL(RQF_LLOG_ORIGIN_HANDLE_CREATE);
 
 struct req_format RQF_LLOG_ORIGIN_HANDLE_NEXT_BLOCK =
-        DEFINE_REQ_FMT0("LLOG_ORIGIN_HANDLE_NEXT_BLOCK",
-                        llogd_body_only, llog_origin_handle_next_block_server);
+	DEFINE_REQ_FMT0("LLOG_ORIGIN_HANDLE_NEXT_BLOCK",
+			llog_origin_handle_next_block_client,
+			llog_origin_handle_next_block_server);
 EXPORT_SYMBOL(RQF_LLOG_ORIGIN_HANDLE_NEXT_BLOCK);
 
 struct req_format RQF_LLOG_ORIGIN_HANDLE_PREV_BLOCK =
@@ -1706,6 +1757,10 @@ struct req_format RQF_OST_LADVISE =
 	DEFINE_REQ_FMT0("OST_LADVISE", ost_ladvise, ost_body_only);
 EXPORT_SYMBOL(RQF_OST_LADVISE);
 
+struct req_format RQF_OST_FALLOCATE =
+	DEFINE_REQ_FMT0("OST_FALLOCATE", ost_body_capa, ost_body_only);
+EXPORT_SYMBOL(RQF_OST_FALLOCATE);
+
 /* Convenience macro */
 #define FMT_FIELD(fmt, i, j) (fmt)->rf_fields[(i)].d[(j)]
 
@@ -136,37 +136,238 @@ out:
 	return rc;
 }
 
+/**
+ * Set the changelog filter sent with the requests reading the plain logs of
+ * a catalog opened through llog_client_ops. The MDT does not send the records
+ * which do not match it, see llog_client_next_block().
+ *
+ * \param[in] cathandle	changelog catalog handle
+ * \param[in] lcf	new filter, zeroed to get every record
+ */
+void llog_cat_chlg_filter_set(struct llog_handle *cathandle,
+			      const struct llogd_chlg_filter *lcf)
+{
+	spin_lock(&cathandle->u.chd.chd_chlg_lock);
+	cathandle->u.chd.chd_chlg_filter = *lcf;
+	spin_unlock(&cathandle->u.chd.chd_chlg_lock);
+}
+EXPORT_SYMBOL(llog_cat_chlg_filter_set);
+
+/**
+ * Get the changelog filter to send with a request for \a loghandle.
+ *
+ * \retval	true if \a lcf should be sent
+ * \retval	false if the whole chunk should be read
+ */
+static bool llog_client_chlg_filter(struct llog_handle *loghandle,
+				    struct obd_import *imp,
+				    struct llogd_chlg_filter *lcf)
+{
+	struct llog_handle *cathandle;
+
+	if (loghandle->lgh_ctxt->loc_idx != LLOG_CHANGELOG_REPL_CTXT ||
+	    !(loghandle->lgh_hdr->llh_flags & LLOG_F_IS_PLAIN) ||
+	    !(imp->imp_connect_data.ocd_connect_flags2 &
+	      OBD_CONNECT2_CHLG_FILTER))
+		return false;
+
+	cathandle = loghandle->u.phd.phd_cat_handle;
+	if (cathandle == NULL)
+		return false;
+
+	spin_lock(&cathandle->u.chd.chd_chlg_lock);
+	*lcf = cathandle->u.chd.chd_chlg_filter;
+	spin_unlock(&cathandle->u.chd.chd_chlg_lock);
+
+	return !llog_chlg_filter_empty(lcf);
+}
+
+/**
+ * Rebuild a llog chunk packed by the server with a changelog filter, see
+ * struct llogd_chlg_filter. Each run of skipped records is replaced by as
+ * many padding records covering the same indices and bytes, so that the
+ * chunk is processed as if it had been read whole.
+ *
+ * \param[in] src	packed chunks
+ * \param[in] srclen	length of \a src
+ * \param[out] dst	chunk to rebuild
+ * \param[in] len	chunk size
+ * \param[out] last_idx	last index of the chunk
+ *
+ * \retval		number of bytes of \a src used by the chunk
+ * \retval		-EPROTO if \a src is malformed
+ */
+static int llog_client_unpack_chunk(const char *src, int srclen, char *dst,
+				    int len, int *last_idx)
+{
+	int in = 0;
+	int out = 0;
+
+	memset(dst, 0, len);
+	while (out < len && in + sizeof(struct llog_rec_hdr) <= srclen) {
+		struct llog_rec_hdr hdr = *(struct llog_rec_hdr *)(src + in);
+		struct llog_rec_hdr *rec;
+		struct llog_rec_tail *tail;
+		int i;
+
+		if (LLOG_REC_HDR_NEEDS_SWABBING(&hdr)) {
+			__swab32s(&hdr.lrh_len);
+			__swab32s(&hdr.lrh_index);
+			__swab32s(&hdr.lrh_type);
+			__swab32s(&hdr.lrh_id);
+		}
+
+		if (hdr.lrh_type != LLOG_PAD_MAGIC) {
+			/* a corrupted record ends the chunk, it is reported
+			 * by llog_process_thread() */
+			if (hdr.lrh_len < LLOG_MIN_REC_SIZE ||
+			    hdr.lrh_len > len - out ||
+			    hdr.lrh_len > srclen - in) {
+				i = min(len - out, srclen - in);
+				memcpy(dst + out, src + in, i);
+				return in + i;
+			}
+
+			memcpy(dst + out, src + in, hdr.lrh_len);
+			in += hdr.lrh_len;
+			out += hdr.lrh_len;
+			*last_idx = hdr.lrh_index;
+			continue;
+		}
+
+		if (hdr.lrh_id == 0 ||
+		    hdr.lrh_len < hdr.lrh_id * LLOG_MIN_REC_SIZE ||
+		    hdr.lrh_len > len - out)
+			return -EPROTO;
+
+		for (i = 0; i < hdr.lrh_id; i++) {
+			rec = (struct llog_rec_hdr *)(dst + out);
+			rec->lrh_len = i < hdr.lrh_id - 1 ? LLOG_MIN_REC_SIZE :
+				hdr.lrh_len - i * LLOG_MIN_REC_SIZE;
+			rec->lrh_index = hdr.lrh_index + i;
+			rec->lrh_type = LLOG_PAD_MAGIC;
+			out += rec->lrh_len;
+
+			tail = (struct llog_rec_tail *)(dst + out) - 1;
+			tail->lrt_len = rec->lrh_len;
+			tail->lrt_index = rec->lrh_index;
+		}
+		in += sizeof(hdr);
+		*last_idx = hdr.lrh_index + hdr.lrh_id - 1;
+	}
+
+	return in;
+}
+
+/* Full chunks packed by the server after the one which was asked for */
+struct llog_client_batch {
+	/* offset of the first chunk in the log */
+	__u64	lcb_offset;
+	/* bytes of lcb_buf used and left */
+	int	lcb_pos;
+	int	lcb_len;
+	char	lcb_buf[0];
+};
+
+static void llog_client_batch_free(struct llog_handle *loghandle)
+{
+	struct llog_client_batch *lcb = loghandle->private_data;
+
+	if (lcb == NULL)
+		return;
+
+	loghandle->private_data = NULL;
+	OBD_FREE_LARGE(lcb, sizeof(*lcb) + lcb->lcb_len);
+}
+
+/**
+ * Get the next chunk from the ones packed in the last reply, skipping the
+ * chunks which end before \a next_idx as llog_osd_next_block() does.
+ *
+ * \retval	0 if \a buf has been filled
+ * \retval	-ENOENT if a request has to be sent
+ */
+static int llog_client_batch_next(struct llog_handle *loghandle,
+				  int *cur_idx, int next_idx,
+				  __u64 *cur_offset, void *buf, int len)
+{
+	struct llog_client_batch *lcb = loghandle->private_data;
+	int last_idx = *cur_idx;
+	int rc;
+
+	while (lcb->lcb_pos < lcb->lcb_len && *cur_offset == lcb->lcb_offset) {
+		rc = llog_client_unpack_chunk(lcb->lcb_buf + lcb->lcb_pos,
+					      lcb->lcb_len - lcb->lcb_pos,
+					      buf, len, &last_idx);
+		if (rc <= 0)
+			break;
+
+		lcb->lcb_pos += rc;
+		lcb->lcb_offset += len;
+		*cur_offset = lcb->lcb_offset;
+		*cur_idx = last_idx;
+		if (last_idx >= next_idx)
+			return 0;
+	}
+
+	llog_client_batch_free(loghandle);
+	return -ENOENT;
+}
+
 static int llog_client_next_block(const struct lu_env *env,
 				  struct llog_handle *loghandle,
 				  int *cur_idx, int next_idx,
 				  __u64 *cur_offset, void *buf, int len)
 {
-        struct obd_import     *imp;
-        struct ptlrpc_request *req = NULL;
-        struct llogd_body     *body;
-        void                  *ptr;
-        int                    rc;
-        ENTRY;
-
-        LLOG_CLIENT_ENTRY(loghandle->lgh_ctxt, imp);
-        req = ptlrpc_request_alloc_pack(imp, &RQF_LLOG_ORIGIN_HANDLE_NEXT_BLOCK,
-                                        LUSTRE_LOG_VERSION,
-                                        LLOG_ORIGIN_HANDLE_NEXT_BLOCK);
-        if (req == NULL)
-                GOTO(err_exit, rc =-ENOMEM);
+	struct obd_import *imp;
+	struct ptlrpc_request *req = NULL;
+	struct llogd_chlg_filter lcf;
+	struct llogd_body *body;
+	bool filter;
+	void *ptr;
+	int last_idx;
+	int size;
+	int rc;
+	ENTRY;
+
+	if (loghandle->private_data != NULL &&
+	    llog_client_batch_next(loghandle, cur_idx, next_idx, cur_offset,
+				   buf, len) == 0)
+		RETURN(0);
+
+	LLOG_CLIENT_ENTRY(loghandle->lgh_ctxt, imp);
+	req = ptlrpc_request_alloc(imp, &RQF_LLOG_ORIGIN_HANDLE_NEXT_BLOCK);
+	if (req == NULL)
+		GOTO(err_exit, rc = -ENOMEM);
+
+	filter = llog_client_chlg_filter(loghandle, imp, &lcf);
+	req_capsule_set_size(&req->rq_pill, &RMF_LLOGD_CHLG_FILTER, RCL_CLIENT,
+			     filter ? sizeof(lcf) : 0);
+	rc = ptlrpc_request_pack(req, LUSTRE_LOG_VERSION,
+				 LLOG_ORIGIN_HANDLE_NEXT_BLOCK);
+	if (rc) {
+		ptlrpc_request_free(req);
+		GOTO(err_exit, rc);
+	}
 
-        body = req_capsule_client_get(&req->rq_pill, &RMF_LLOGD_BODY);
-        body->lgd_logid = loghandle->lgh_id;
-        body->lgd_ctxt_idx = loghandle->lgh_ctxt->loc_idx - 1;
-        body->lgd_llh_flags = loghandle->lgh_hdr->llh_flags;
-        body->lgd_index = next_idx;
-        body->lgd_saved_index = *cur_idx;
-        body->lgd_len = len;
-        body->lgd_cur_offset = *cur_offset;
+	body = req_capsule_client_get(&req->rq_pill, &RMF_LLOGD_BODY);
+	body->lgd_logid = loghandle->lgh_id;
+	body->lgd_ctxt_idx = loghandle->lgh_ctxt->loc_idx - 1;
+	body->lgd_llh_flags = loghandle->lgh_hdr->llh_flags;
+	body->lgd_index = next_idx;
+	body->lgd_saved_index = *cur_idx;
+	body->lgd_len = len;
+	body->lgd_cur_offset = *cur_offset;
+
+	if (filter) {
+		ptr = req_capsule_client_get(&req->rq_pill,
+					     &RMF_LLOGD_CHLG_FILTER);
+		memcpy(ptr, &lcf, sizeof(lcf));
+	}
 
-        req_capsule_set_size(&req->rq_pill, &RMF_EADATA, RCL_SERVER, len);
-        ptlrpc_request_set_replen(req);
-        rc = ptlrpc_queue_wait(req);
+	req_capsule_set_size(&req->rq_pill, &RMF_EADATA, RCL_SERVER, len);
+	ptlrpc_request_set_replen(req);
+	rc = ptlrpc_queue_wait(req);
 	/* -EIO has a special meaning here. If llog_osd_next_block()
 	 * reaches the end of the log without finding the desired
 	 * record then it updates *cur_offset and *cur_idx and returns
@@ -192,18 +393,41 @@ static int llog_client_next_block(const struct lu_env *env,
 	if (rc < 0)
 		GOTO(out, rc);
 
-        /* The log records are swabbed as they are processed */
-        ptr = req_capsule_server_get(&req->rq_pill, &RMF_EADATA);
-        if (ptr == NULL)
-                GOTO(out, rc =-EFAULT);
+	/* The log records are swabbed as they are processed */
+	ptr = req_capsule_server_get(&req->rq_pill, &RMF_EADATA);
+	if (ptr == NULL)
+		GOTO(out, rc = -EFAULT);
 
-        memcpy(buf, ptr, len);
-        EXIT;
+	if (!filter) {
+		memcpy(buf, ptr, len);
+		GOTO(out, rc = 0);
+	}
+
+	size = req_capsule_get_size(&req->rq_pill, &RMF_EADATA, RCL_SERVER);
+	rc = llog_client_unpack_chunk(ptr, size, buf, len, &last_idx);
+	if (rc < 0)
+		GOTO(out, rc);
+
+	/* keep the following full chunks for the next calls */
+	if (rc < size && !(*cur_offset & (len - 1))) {
+		struct llog_client_batch *lcb;
+
+		OBD_ALLOC_LARGE(lcb, sizeof(*lcb) + size - rc);
+		if (lcb != NULL) {
+			lcb->lcb_offset = *cur_offset;
+			lcb->lcb_pos = 0;
+			lcb->lcb_len = size - rc;
+			memcpy(lcb->lcb_buf, (char *)ptr + rc, size - rc);
+			loghandle->private_data = lcb;
+		}
+	}
+	rc = 0;
+	EXIT;
 out:
-        ptlrpc_req_finished(req);
+	ptlrpc_req_finished(req);
 err_exit:
-        LLOG_CLIENT_EXIT(loghandle->lgh_ctxt, imp);
-        return rc;
+	LLOG_CLIENT_EXIT(loghandle->lgh_ctxt, imp);
+	return rc;
 }
 
 static int llog_client_prev_block(const struct lu_env *env,
@@ -322,10 +546,11 @@ err_exit:
 static int llog_client_close(const struct lu_env *env,
 			     struct llog_handle *handle)
 {
-        /* this doesn't call LLOG_ORIGIN_HANDLE_CLOSE because
-           the servers all close the file at the end of every
-           other LLOG_ RPC. */
-        return(0);
+	/* this doesn't call LLOG_ORIGIN_HANDLE_CLOSE because
+	 * the servers all close the file at the end of every
+	 * other LLOG_ RPC. */
+	llog_client_batch_free(handle);
+	return 0;
 }
 
 struct llog_operations llog_client_ops = {
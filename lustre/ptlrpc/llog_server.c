@@ -111,9 +111,154 @@ out_ctxt:
 	return rc;
 }
 
+/**
+ * Pack a llog chunk read by llog_next_block() for a reader with a changelog
+ * filter, see struct llogd_chlg_filter. The records matching \a lcf are
+ * copied, and each run of other records is replaced by one bare header.
+ *
+ * \param[in] lcf	changelog filter of the reader
+ * \param[in] chunk	chunk to pack
+ * \param[in] chunk_size	size of \a chunk
+ * \param[out] out	where to pack the chunk
+ * \param[in] room	size of \a out
+ * \param[out] corrupt	a corrupted record was found and copied as is with
+ *			the rest of the chunk, for the client to report it
+ *
+ * \retval		number of bytes used in \a out
+ * \retval		-EOVERFLOW if \a room is too small
+ */
+static int llog_chlg_pack_chunk(const struct llogd_chlg_filter *lcf,
+				char *chunk, int chunk_size, char *out,
+				int room, bool *corrupt)
+{
+	struct llog_rec_hdr *run = NULL;
+	struct llog_rec_hdr *rec;
+	int used = 0;
+	int off = 0;
+
+	while (off + sizeof(*rec) <= chunk_size) {
+		rec = (struct llog_rec_hdr *)(chunk + off);
+		/* end of the last chunk of the log */
+		if (rec->lrh_len == 0)
+			break;
+
+		if (LLOG_REC_HDR_NEEDS_SWABBING(rec) ||
+		    rec->lrh_len < LLOG_MIN_REC_SIZE ||
+		    rec->lrh_len > chunk_size - off) {
+			if (chunk_size - off > room - used)
+				return -EOVERFLOW;
+
+			memcpy(out + used, rec, chunk_size - off);
+			*corrupt = true;
+			return used + chunk_size - off;
+		}
+
+		if (rec->lrh_type == LLOG_PAD_MAGIC ||
+		    (rec->lrh_type == CHANGELOG_REC &&
+		     !llog_chlg_filter_match(lcf,
+			&container_of(rec, struct llog_changelog_rec,
+				      cr_hdr)->cr))) {
+			if (run != NULL &&
+			    run->lrh_index + run->lrh_id == rec->lrh_index) {
+				run->lrh_len += rec->lrh_len;
+				run->lrh_id++;
+			} else {
+				if (sizeof(*run) > room - used)
+					return -EOVERFLOW;
+
+				run = (struct llog_rec_hdr *)(out + used);
+				run->lrh_len = rec->lrh_len;
+				run->lrh_index = rec->lrh_index;
+				run->lrh_type = LLOG_PAD_MAGIC;
+				run->lrh_id = 1;
+				used += sizeof(*run);
+			}
+		} else {
+			if (rec->lrh_len > room - used)
+				return -EOVERFLOW;
+
+			memcpy(out + used, rec, rec->lrh_len);
+			used += rec->lrh_len;
+			run = NULL;
+		}
+		off += rec->lrh_len;
+	}
+
+	return used;
+}
+
+/**
+ * Read the chunk holding record lgd_index of \a loghandle as
+ * llog_next_block() does, then the following full chunks while they fit,
+ * and pack them with the changelog filter \a lcf. \a repbody describes
+ * the first chunk, the client derives the offsets of the others.
+ *
+ * \retval		number of bytes used in \a out
+ * \retval		negative errno if the first chunk cannot be read
+ */
+static int llog_chlg_next_blocks(const struct lu_env *env,
+				 struct llog_handle *loghandle,
+				 struct llogd_body *repbody,
+				 const struct llogd_chlg_filter *lcf,
+				 char *out, int room)
+{
+	int chunk_size = LLOG_MIN_CHUNK_SIZE;
+	bool corrupt = false;
+	__u64 offset;
+	char *buf;
+	int index;
+	int used;
+	int rc;
+
+	ENTRY;
+
+	OBD_ALLOC_LARGE(buf, chunk_size);
+	if (buf == NULL)
+		RETURN(-ENOMEM);
+
+	rc = llog_next_block(env, loghandle, &repbody->lgd_saved_index,
+			     repbody->lgd_index, &repbody->lgd_cur_offset,
+			     buf, chunk_size);
+	if (rc)
+		GOTO(out_free, rc);
+
+	rc = llog_chlg_pack_chunk(lcf, buf, chunk_size, out, room, &corrupt);
+	if (rc < 0)
+		GOTO(out_free, rc);
+	used = rc;
+
+	/* a partial chunk is the end of the log */
+	offset = repbody->lgd_cur_offset;
+	index = repbody->lgd_saved_index;
+	while (!corrupt && !(offset & (chunk_size - 1))) {
+		__u64 next_offset = offset;
+		int next_index = index;
+
+		rc = llog_next_block(env, loghandle, &next_index, index + 1,
+				     &next_offset, buf, chunk_size);
+		if (rc || next_offset != offset + chunk_size)
+			break;
+
+		rc = llog_chlg_pack_chunk(lcf, buf, chunk_size, out + used,
+					  room - used, &corrupt);
+		if (rc < 0 || corrupt)
+			break;
+
+		used += rc;
+		offset = next_offset;
+		index = next_index;
+	}
+	rc = used;
+	EXIT;
+out_free:
+	OBD_FREE_LARGE(buf, chunk_size);
+	return rc;
+}
+
 int llog_origin_handle_next_block(struct ptlrpc_request *req)
 {
 	struct llog_handle	*loghandle;
+	struct llogd_chlg_filter *lcf = NULL;
 	struct llogd_body	*body;
 	struct llogd_body	*repbody;
 	struct llog_ctxt	*ctxt;
@@ -127,6 +272,17 @@ int llog_origin_handle_next_block(struct ptlrpc_request *req)
 	if (body == NULL)
 		RETURN(err_serious(-EFAULT));
 
+	/* the reader only wants the changelog records matching its filter */
+	if (req_capsule_field_present(&req->rq_pill, &RMF_LLOGD_CHLG_FILTER,
+				      RCL_CLIENT) &&
+	    req_capsule_get_size(&req->rq_pill, &RMF_LLOGD_CHLG_FILTER,
+				 RCL_CLIENT) != 0) {
+		lcf = req_capsule_client_get(&req->rq_pill,
+					     &RMF_LLOGD_CHLG_FILTER);
+		if (lcf == NULL)
+			RETURN(err_serious(-EFAULT));
+	}
+
 	req_capsule_set_size(&req->rq_pill, &RMF_EADATA, RCL_SERVER,
 			     LLOG_MIN_CHUNK_SIZE);
 	rc = req_capsule_server_pack(&req->rq_pill);
@@ -158,6 +314,18 @@ int llog_origin_handle_next_block(struct ptlrpc_request *req)
 	*repbody = *body;
 
 	ptr = req_capsule_server_get(&req->rq_pill, &RMF_EADATA);
+	if (lcf != NULL) {
+		rc = llog_chlg_next_blocks(req->rq_svc_thread->t_env,
+					   loghandle, repbody, lcf, ptr,
+					   LLOG_MIN_CHUNK_SIZE);
+		if (rc < 0)
+			GOTO(out_close, rc);
+
+		req_capsule_shrink(&req->rq_pill, &RMF_EADATA, rc,
+				   RCL_SERVER);
+		GOTO(out_close, rc = 0);
+	}
+
 	rc = llog_next_block(req->rq_svc_thread->t_env, loghandle,
 			     &repbody->lgd_saved_index, repbody->lgd_index,
 			     &repbody->lgd_cur_offset, ptr,
@@ -66,6 +66,7 @@ static struct ll_rpc_opcode {
         { OST_QUOTACTL,     "ost_quotactl" },
         { OST_QUOTA_ADJUST_QUNIT, "ost_quota_adjust_qunit" },
 	{ OST_LADVISE,      "ost_ladvise" },
+	{ OST_FALLOCATE,    "ost_fallocate" },
         { MDS_GETATTR,      "mds_getattr" },
         { MDS_GETATTR_NAME, "mds_getattr_lock" },
         { MDS_CLOSE,        "mds_close" },
@@ -95,6 +96,7 @@ static struct ll_rpc_opcode {
 	{ MDS_HSM_CT_REGISTER, "mds_hsm_ct_register" },
 	{ MDS_HSM_CT_UNREGISTER, "mds_hsm_ct_unregister" },
 	{ MDS_SWAP_LAYOUTS,	"mds_swap_layouts" },
+	{ MDS_BATCH,		"mds_batch" },
         { LDLM_ENQUEUE,     "ldlm_enqueue" },
         { LDLM_CONVERT,     "ldlm_convert" },
         { LDLM_CANCEL,      "ldlm_cancel" },
@@ -233,6 +235,10 @@ ptlrpc_ldebugfs_register(struct dentry *root, char *dir, char *name,
                              svc_counter_config, "req_timeout", "sec");
         lprocfs_counter_init(svc_stats, PTLRPC_REQBUF_AVAIL_CNTR,
                              svc_counter_config, "reqbuf_avail", "bufs");
+	lprocfs_counter_init(svc_stats, PTLRPC_PTLRPCD_WAIT_CNTR,
+			     svc_counter_config, "ptlrpcd_waittime", "usec");
+	lprocfs_counter_init(svc_stats, PTLRPC_RS_QUEUE_CNTR,
+			     svc_counter_config, "rs_queue_time", "usec");
         for (i = 0; i < EXTRA_LAST_OPC; i++) {
                 char *units;
 
@@ -476,6 +482,40 @@ static ssize_t threads_max_store(struct kobject *kobj, struct attribute *attr,
 }
 LUSTRE_RW_ATTR(threads_max);
 
+static ssize_t threads_idle_time_show(struct kobject *kobj,
+				      struct attribute *attr, char *buf)
+{
+	struct ptlrpc_service *svc = container_of(kobj, struct ptlrpc_service,
+						  srv_kobj);
+
+	return sprintf(buf, "%d\n", svc->srv_thread_idle_time);
+}
+
+/* seconds after which threads above threads_min stop if idle, 0 to never */
+static ssize_t threads_idle_time_store(struct kobject *kobj,
+				       struct attribute *attr,
+				       const char *buffer, size_t count)
+{
+	struct ptlrpc_service *svc = container_of(kobj, struct ptlrpc_service,
+						  srv_kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc < 0)
+		return rc;
+
+	if (val > INT_MAX / MSEC_PER_SEC)
+		return -ERANGE;
+
+	spin_lock(&svc->srv_lock);
+	svc->srv_thread_idle_time = val;
+	spin_unlock(&svc->srv_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(threads_idle_time);
+
 /**
  * Translates \e ptlrpc_nrs_pol_state values to human-readable strings.
  *
@@ -526,6 +566,8 @@ void nrs_policy_get_info_locked(struct ptlrpc_nrs_policy *policy,
 	 */
 	info->pi_req_queued  = policy->pol_req_queued;
 	info->pi_req_started = policy->pol_req_started;
+	info->pi_req_handled = policy->pol_req_handled;
+	info->pi_req_missed  = policy->pol_req_missed;
 }
 
 /**
@@ -615,6 +657,8 @@ again:
 
 			infos[pol_idx].pi_req_queued += tmp.pi_req_queued;
 			infos[pol_idx].pi_req_started += tmp.pi_req_started;
+			infos[pol_idx].pi_req_handled += tmp.pi_req_handled;
+			infos[pol_idx].pi_req_missed += tmp.pi_req_missed;
 
 			pol_idx++;
 		}
@@ -622,7 +666,9 @@ again:
 	}
 
 	/**
-	 * Policy status information output is in YAML format.
+	 * Policy status information output is in YAML format. "missed" counts
+	 * the handled requests which were replied to after their deadline,
+	 * or were shed by the policy.
 	 * For example:
 	 *
 	 *	regular_requests:
@@ -631,12 +677,16 @@ again:
 	 *	    fallback: yes
 	 *	    queued: 0
 	 *	    active: 0
+	 *	    handled: 1204
+	 *	    missed: 0
 	 *
 	 *	  - name: crrn
 	 *	    state: started
 	 *	    fallback: no
 	 *	    queued: 2015
 	 *	    active: 384
+	 *	    handled: 80412
+	 *	    missed: 27
 	 *
 	 *	high_priority_requests:
 	 *	  - name: fifo
@@ -644,12 +694,16 @@ again:
 	 *	    fallback: yes
 	 *	    queued: 0
 	 *	    active: 2
+	 *	    handled: 3342
+	 *	    missed: 0
 	 *
 	 *	  - name: crrn
 	 *	    state: stopped
 	 *	    fallback: no
 	 *	    queued: 0
 	 *	    active: 0
+	 *	    handled: 0
+	 *	    missed: 0
 	 */
 	seq_printf(m, "%s\n", !hp ? "\nregular_requests:" :
 		   "high_priority_requests:");
@@ -667,11 +721,15 @@ again:
 		seq_printf(m, "    state: %s\n"
 			   "    fallback: %s\n"
 			   "    queued: %-20d\n"
-			   "    active: %-20d\n\n",
+			   "    active: %-20d\n"
+			   "    handled: %-20llu\n"
+			   "    missed: %-20llu\n\n",
 			   nrs_state2str(infos[pol_idx].pi_state),
 			   infos[pol_idx].pi_fallback ? "yes" : "no",
 			   (int)infos[pol_idx].pi_req_queued,
-			   (int)infos[pol_idx].pi_req_started);
+			   (int)infos[pol_idx].pi_req_started,
+			   infos[pol_idx].pi_req_handled,
+			   infos[pol_idx].pi_req_missed);
 	}
 
 	if (!hp && nrs_svc_has_hp(svc)) {
@@ -1119,6 +1177,30 @@ static int ptlrpc_lprocfs_timeouts_seq_show(struct seq_file *m, void *n)
 
 LDEBUGFS_SEQ_FOPS_RO(ptlrpc_lprocfs_timeouts);
 
+/**
+ * Prints for each service partition the number of threads running, started
+ * and stopped for being idle since the service was set up, and the average
+ * time requests wait for a thread.
+ */
+static int ptlrpc_lprocfs_threads_churn_seq_show(struct seq_file *m, void *n)
+{
+	struct ptlrpc_service *svc = m->private;
+	struct ptlrpc_service_part *svcpt;
+	int i;
+
+	ptlrpc_service_for_each_part(svcpt, i, svc) {
+		seq_printf(m, "cpt %d: running %d started %llu stopped %llu "
+			   "wait %lldus\n", i, svcpt->scp_nthrs_running,
+			   svcpt->scp_nthrs_started_total,
+			   svcpt->scp_nthrs_stopped_total,
+			   (s64)svcpt->scp_req_wait_usec);
+	}
+
+	return 0;
+}
+
+LDEBUGFS_SEQ_FOPS_RO(ptlrpc_lprocfs_threads_churn);
+
 static ssize_t high_priority_ratio_show(struct kobject *kobj,
 					struct attribute *attr,
 					char *buf)
@@ -1155,6 +1237,7 @@ static struct attribute *ptlrpc_svc_attrs[] = {
 	&lustre_attr_threads_min.attr,
 	&lustre_attr_threads_started.attr,
 	&lustre_attr_threads_max.attr,
+	&lustre_attr_threads_idle_time.attr,
 	&lustre_attr_high_priority_ratio.attr,
 	NULL,
 };
@@ -1204,6 +1287,9 @@ void ptlrpc_ldebugfs_register_service(struct dentry *entry,
 		{ .name = "timeouts",
 		  .fops = &ptlrpc_lprocfs_timeouts_fops,
 		  .data = svc },
+		{ .name = "threads_churn",
+		  .fops = &ptlrpc_lprocfs_threads_churn_fops,
+		  .data = svc },
 		{ .name = "nrs_policies",
 		  .fops = &ptlrpc_lprocfs_nrs_fops,
 		  .data = svc },
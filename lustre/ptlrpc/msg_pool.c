@@ -0,0 +1,345 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/ptlrpc/msg_pool.c
+ *
+ * Per-CPT caches of ptlrpc_request structures and of the request and reply
+ * message buffers of the null and plain security flavors.
+ *
+ * Every RPC allocates one request structure and two message buffers, whose
+ * sizes are rounded up to a power of two. They are taken from one slab per
+ * size class, and the objects freed are kept on a small per-CPT free list of
+ * their class, so the next RPC started on that CPT reuses them without going
+ * through the slab allocator. Buffers larger than the biggest class are
+ * vmalloc'ed or kmalloc'ed as before.
+ */
+
+#define DEBUG_SUBSYSTEM S_RPC
+
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+
+#include <obd_support.h>
+#include <obd_class.h>
+#include <lustre_net.h>
+
+#include "ptlrpc_internal.h"
+
+/* smallest message buffer class, 1 << PTLRPC_POOL_MIN_SHIFT bytes */
+#define PTLRPC_POOL_MIN_SHIFT	9
+/* biggest message buffer class, 1 << PTLRPC_POOL_MAX_SHIFT bytes */
+#define PTLRPC_POOL_MAX_SHIFT	14
+/* class 0 holds the request structures, followed by the buffer classes */
+#define PTLRPC_POOL_NR		(PTLRPC_POOL_MAX_SHIFT -		\
+				 PTLRPC_POOL_MIN_SHIFT + 2)
+/* max objects cached per class and CPT */
+#define PTLRPC_POOL_MAX_CACHED	64
+/* max bytes cached per class and CPT */
+#define PTLRPC_POOL_MAX_BYTES	(256 << 10)
+
+struct ptlrpc_pool_class {
+	char			 ppl_name[24];
+	unsigned int		 ppl_size;
+	/* max objects cached on each CPT */
+	unsigned int		 ppl_max;
+	struct kmem_cache	*ppl_cache;
+};
+
+/* a cached object, the link is stored in the object itself */
+struct ptlrpc_pool_obj {
+	struct ptlrpc_pool_obj	*ppo_next;
+};
+
+struct ptlrpc_pool_cpt {
+	spinlock_t		 ppc_lock;
+	struct ptlrpc_pool_obj	*ppc_free[PTLRPC_POOL_NR];
+	unsigned int		 ppc_cached[PTLRPC_POOL_NR];
+	/* statistics */
+	unsigned long		 ppc_hits[PTLRPC_POOL_NR];
+	unsigned long		 ppc_misses[PTLRPC_POOL_NR];
+	unsigned long		 ppc_frees[PTLRPC_POOL_NR];
+} ____cacheline_aligned;
+
+static struct ptlrpc_pool_class ptlrpc_pool_classes[PTLRPC_POOL_NR];
+static struct ptlrpc_pool_cpt **ptlrpc_pool_cpts;
+static struct dentry *ptlrpc_pool_debugfs;
+
+/* the class of buffers of \a size bytes, or -1 if they are not pooled */
+static inline int ptlrpc_pool_class_idx(int size)
+{
+	int shift;
+
+	if (size <= 0 || size > (1 << PTLRPC_POOL_MAX_SHIFT))
+		return -1;
+
+	shift = max_t(int, fls(size - 1), PTLRPC_POOL_MIN_SHIFT);
+	return shift - PTLRPC_POOL_MIN_SHIFT + 1;
+}
+
+/*
+ * Take an object of class \a idx from the cache of the current CPT, or from
+ * the slab if that cache is empty. The first \a zero bytes of the object are
+ * cleared, slab objects are always returned zeroed.
+ */
+static void *ptlrpc_pool_get(int idx, gfp_t flags, int zero)
+{
+	struct ptlrpc_pool_class *ppl = &ptlrpc_pool_classes[idx];
+	struct ptlrpc_pool_cpt *ppc;
+	struct ptlrpc_pool_obj *obj;
+	int cpt;
+
+	cpt = cfs_cpt_current(cfs_cpt_table, 1);
+	ppc = ptlrpc_pool_cpts[cpt];
+
+	spin_lock(&ppc->ppc_lock);
+	obj = ppc->ppc_free[idx];
+	if (obj != NULL) {
+		ppc->ppc_free[idx] = obj->ppo_next;
+		ppc->ppc_cached[idx]--;
+		ppc->ppc_hits[idx]++;
+	} else {
+		ppc->ppc_misses[idx]++;
+	}
+	spin_unlock(&ppc->ppc_lock);
+
+	if (obj != NULL) {
+		memset(obj, 0, zero);
+		return obj;
+	}
+
+	OBD_SLAB_CPT_ALLOC_GFP(obj, ppl->ppl_cache, cfs_cpt_table, cpt,
+			       ppl->ppl_size, flags);
+	return obj;
+}
+
+static void ptlrpc_pool_put(int idx, void *ptr)
+{
+	struct ptlrpc_pool_class *ppl = &ptlrpc_pool_classes[idx];
+	struct ptlrpc_pool_cpt *ppc;
+	struct ptlrpc_pool_obj *obj = ptr;
+
+	ppc = ptlrpc_pool_cpts[cfs_cpt_current(cfs_cpt_table, 1)];
+
+	spin_lock(&ppc->ppc_lock);
+	ppc->ppc_frees[idx]++;
+	if (ppc->ppc_cached[idx] < ppl->ppl_max) {
+		obj->ppo_next = ppc->ppc_free[idx];
+		ppc->ppc_free[idx] = obj;
+		ppc->ppc_cached[idx]++;
+		obj = NULL;
+	}
+	spin_unlock(&ppc->ppc_lock);
+
+	if (obj != NULL)
+		OBD_SLAB_FREE(obj, ppl->ppl_cache, ppl->ppl_size);
+}
+
+struct ptlrpc_request *ptlrpc_request_cache_alloc(gfp_t flags)
+{
+	return ptlrpc_pool_get(0, flags, sizeof(struct ptlrpc_request));
+}
+
+void ptlrpc_request_cache_free(struct ptlrpc_request *req)
+{
+	ptlrpc_pool_put(0, req);
+}
+
+/**
+ * Allocate a zeroed message buffer of at least \a size bytes.
+ *
+ * The buffer must be released with ptlrpc_msgbuf_free() with the same
+ * \a size, which is what the security flavors store in rq_reqbuf_len and
+ * rq_repbuf_len.
+ */
+void *ptlrpc_msgbuf_alloc(int size)
+{
+	void *buf;
+	int idx;
+
+	idx = ptlrpc_pool_class_idx(size);
+	if (idx < 0) {
+		OBD_ALLOC_LARGE(buf, size);
+		return buf;
+	}
+
+	return ptlrpc_pool_get(idx, GFP_NOFS, size);
+}
+
+void ptlrpc_msgbuf_free(void *buf, int size)
+{
+	int idx;
+
+	idx = ptlrpc_pool_class_idx(size);
+	if (idx < 0) {
+		OBD_FREE_LARGE(buf, size);
+		return;
+	}
+
+	ptlrpc_pool_put(idx, buf);
+}
+
+/*
+ * /sys/kernel/debug/lustre/ptlrpc_pools
+ */
+static int ptlrpc_pool_seq_show(struct seq_file *m, void *v)
+{
+	struct ptlrpc_pool_cpt *ppc;
+	int idx;
+	int i;
+
+	seq_printf(m, "%-16s %8s %8s %12s %12s %12s\n",
+		   "pool", "size", "cached", "hits", "misses", "frees");
+
+	for (idx = 0; idx < PTLRPC_POOL_NR; idx++) {
+		unsigned long cached = 0;
+		unsigned long hits = 0;
+		unsigned long misses = 0;
+		unsigned long frees = 0;
+
+		cfs_percpt_for_each(ppc, i, ptlrpc_pool_cpts) {
+			spin_lock(&ppc->ppc_lock);
+			cached += ppc->ppc_cached[idx];
+			hits += ppc->ppc_hits[idx];
+			misses += ppc->ppc_misses[idx];
+			frees += ppc->ppc_frees[idx];
+			spin_unlock(&ppc->ppc_lock);
+		}
+
+		seq_printf(m, "%-16s %8u %8lu %12lu %12lu %12lu\n",
+			   ptlrpc_pool_classes[idx].ppl_name,
+			   ptlrpc_pool_classes[idx].ppl_size,
+			   cached, hits, misses, frees);
+	}
+
+	return 0;
+}
+
+static int ptlrpc_pool_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ptlrpc_pool_seq_show, NULL);
+}
+
+static const struct file_operations ptlrpc_pool_fops = {
+	.owner   = THIS_MODULE,
+	.open    = ptlrpc_pool_open,
+	.read    = seq_read,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
+static void ptlrpc_pool_drain(void)
+{
+	struct ptlrpc_pool_class *ppl;
+	struct ptlrpc_pool_cpt *ppc;
+	struct ptlrpc_pool_obj *obj;
+	int idx;
+	int i;
+
+	cfs_percpt_for_each(ppc, i, ptlrpc_pool_cpts) {
+		for (idx = 0; idx < PTLRPC_POOL_NR; idx++) {
+			ppl = &ptlrpc_pool_classes[idx];
+			while ((obj = ppc->ppc_free[idx]) != NULL) {
+				ppc->ppc_free[idx] = obj->ppo_next;
+				ppc->ppc_cached[idx]--;
+				OBD_SLAB_FREE(obj, ppl->ppl_cache,
+					      ppl->ppl_size);
+			}
+		}
+	}
+}
+
+void ptlrpc_request_cache_fini(void)
+{
+	int idx;
+
+	if (ptlrpc_pool_debugfs != NULL) {
+		debugfs_remove(ptlrpc_pool_debugfs);
+		ptlrpc_pool_debugfs = NULL;
+	}
+
+	if (ptlrpc_pool_cpts != NULL) {
+		ptlrpc_pool_drain();
+		cfs_percpt_free(ptlrpc_pool_cpts);
+		ptlrpc_pool_cpts = NULL;
+	}
+
+	for (idx = 0; idx < PTLRPC_POOL_NR; idx++) {
+		if (ptlrpc_pool_classes[idx].ppl_cache != NULL) {
+			kmem_cache_destroy(ptlrpc_pool_classes[idx].ppl_cache);
+			ptlrpc_pool_classes[idx].ppl_cache = NULL;
+		}
+	}
+}
+
+int ptlrpc_request_cache_init(void)
+{
+	struct ptlrpc_pool_class *ppl;
+	struct ptlrpc_pool_cpt *ppc;
+	int rc = -ENOMEM;
+	int idx;
+	int i;
+
+	for (idx = 0; idx < PTLRPC_POOL_NR; idx++) {
+		ppl = &ptlrpc_pool_classes[idx];
+		if (idx == 0) {
+			/* keep the name of the former request slab */
+			strlcpy(ppl->ppl_name, "ptlrpc_cache",
+				sizeof(ppl->ppl_name));
+			ppl->ppl_size = sizeof(struct ptlrpc_request);
+		} else {
+			ppl->ppl_size = 1 << (idx - 1 + PTLRPC_POOL_MIN_SHIFT);
+			snprintf(ppl->ppl_name, sizeof(ppl->ppl_name),
+				 "ptlrpc_msg_%u", ppl->ppl_size);
+		}
+		ppl->ppl_max = min_t(unsigned int, PTLRPC_POOL_MAX_CACHED,
+				     PTLRPC_POOL_MAX_BYTES / ppl->ppl_size);
+		ppl->ppl_cache = kmem_cache_create(ppl->ppl_name,
+						   ppl->ppl_size, 0,
+						   SLAB_HWCACHE_ALIGN, NULL);
+		if (ppl->ppl_cache == NULL)
+			GOTO(failed, rc);
+	}
+
+	ptlrpc_pool_cpts = cfs_percpt_alloc(cfs_cpt_table, sizeof(*ppc));
+	if (ptlrpc_pool_cpts == NULL)
+		GOTO(failed, rc);
+
+	cfs_percpt_for_each(ppc, i, ptlrpc_pool_cpts)
+		spin_lock_init(&ppc->ppc_lock);
+
+	/* statistics are optional, debugfs may be disabled */
+	if (debugfs_lustre_root != NULL) {
+		ptlrpc_pool_debugfs = debugfs_create_file("ptlrpc_pools", 0444,
+							  debugfs_lustre_root,
+							  NULL,
+							  &ptlrpc_pool_fops);
+		if (IS_ERR(ptlrpc_pool_debugfs))
+			ptlrpc_pool_debugfs = NULL;
+	}
+
+	return 0;
+failed:
+	ptlrpc_request_cache_fini();
+	return rc;
+}
@@ -625,10 +625,16 @@ static inline void nrs_request_enqueue(struct ptlrpc_nrs_request *nrq)
 static inline void nrs_request_stop(struct ptlrpc_nrs_request *nrq)
 {
 	struct ptlrpc_nrs_policy *policy = nrs_request_policy(nrq);
+	struct ptlrpc_request *req = container_of(nrq, struct ptlrpc_request,
+						  rq_nrq);
 
 	if (policy->pol_desc->pd_ops->op_req_stop)
 		policy->pol_desc->pd_ops->op_req_stop(policy, nrq);
 
+	policy->pol_req_handled++;
+	if (nrq->nr_shed || ktime_get_real_seconds() > req->rq_deadline)
+		policy->pol_req_missed++;
+
 	LASSERT(policy->pol_nrs->nrs_req_started > 0);
 	LASSERT(policy->pol_req_started > 0);
 
@@ -1817,6 +1823,10 @@ int ptlrpc_nrs_init(void)
 	rc = ptlrpc_nrs_policy_register(&nrs_conf_delay);
 	if (rc != 0)
 		GOTO(fail, rc);
+
+	rc = ptlrpc_nrs_policy_register(&nrs_conf_deadline);
+	if (rc != 0)
+		GOTO(fail, rc);
 #endif /* HAVE_SERVER_SUPPORT */
 
 	RETURN(rc);
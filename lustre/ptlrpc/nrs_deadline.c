@@ -0,0 +1,570 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * lustre/ptlrpc/nrs_deadline.c
+ *
+ * Network Request Scheduler (NRS) Deadline policy
+ *
+ * This policy handles requests in earliest-deadline-first order, the
+ * deadline of a request being the time by which its client expects a reply,
+ * as computed from the adaptive timeouts.
+ */
+/**
+ * \addtogoup nrs
+ * @{
+ */
+
+#define DEBUG_SUBSYSTEM S_RPC
+#include <obd_support.h>
+#include <obd_class.h>
+#include "ptlrpc_internal.h"
+
+/**
+ * \name deadline
+ *
+ * The deadline policy schedules RPCs by their ptlrpc_request::rq_deadline.
+ * Under overload, requests which can still be handled in time are served
+ * first. When shedding is enabled, requests which are not expected to be
+ * handled before their deadline are not handled; they are answered with
+ * -EINPROGRESS instead, so that clients supporting it resend them later,
+ * and are otherwise dropped, as the server already does with timed-out
+ * requests.
+ *
+ * The expected wait of a request is worked out from the depth of the queue
+ * when it arrives: the requests queued ahead of it are shared by the running
+ * service threads, and each of them takes the service time estimate of the
+ * service partition. A request which would miss its deadline after that wait
+ * is shed at once, rather than after taking its turn in the queue. A request
+ * which can't be handled within the service time estimate by the time it is
+ * dequeued is shed as well.
+ *
+ * The deadline of a request is pushed back by the early replies sent by
+ * ptlrpc_at_check_timed() while it is queued, so a request is only shed at
+ * dequeue when an early reply could not give it enough time.
+ *
+ * @{
+ */
+
+#define NRS_POL_NAME_DEADLINE	"deadline"
+
+/**
+ * Binary heap predicate.
+ *
+ * Elements are sorted according to the deadline of the requests upon
+ * enqueue, then according to their arrival order.
+ *
+ * \retval 0 e1 is handled after e2
+ * \retval 1 e1 is handled before e2
+ */
+static int deadline_req_compare(struct cfs_binheap_node *e1,
+				struct cfs_binheap_node *e2)
+{
+	struct ptlrpc_nrs_request *nrq1;
+	struct ptlrpc_nrs_request *nrq2;
+
+	nrq1 = container_of(e1, struct ptlrpc_nrs_request, nr_node);
+	nrq2 = container_of(e2, struct ptlrpc_nrs_request, nr_node);
+
+	if (nrq1->nr_u.deadline.dr_deadline < nrq2->nr_u.deadline.dr_deadline)
+		return 1;
+	if (nrq1->nr_u.deadline.dr_deadline > nrq2->nr_u.deadline.dr_deadline)
+		return 0;
+
+	return nrq1->nr_u.deadline.dr_sequence <
+	       nrq2->nr_u.deadline.dr_sequence;
+}
+
+static struct cfs_binheap_ops nrs_deadline_heap_ops = {
+	.hop_enter	= NULL,
+	.hop_exit	= NULL,
+	.hop_compare	= deadline_req_compare,
+};
+
+/**
+ * Is called before the policy transitions into
+ * ptlrpc_nrs_pol_state::NRS_POL_STATE_STARTED; allocates and initializes
+ * the deadline-specific private data structure.
+ *
+ * Shedding is disabled by default, it is enabled through the
+ * nrs_deadline_shed tunable.
+ *
+ * \param[in] policy The policy to start
+ * \param[in] Generic char buffer; unused in this policy
+ *
+ * \retval -ENOMEM OOM error
+ * \retval  0	   success
+ *
+ * \see nrs_policy_register()
+ * \see nrs_policy_ctl()
+ */
+static int nrs_deadline_start(struct ptlrpc_nrs_policy *policy, char *arg)
+{
+	struct nrs_deadline_data *dl_data;
+
+	ENTRY;
+
+	OBD_CPT_ALLOC_PTR(dl_data, nrs_pol2cptab(policy),
+			  nrs_pol2cptid(policy));
+	if (dl_data == NULL)
+		RETURN(-ENOMEM);
+
+	dl_data->dl_binheap = cfs_binheap_create(&nrs_deadline_heap_ops,
+						 CBH_FLAG_ATOMIC_GROW, 4096,
+						 NULL, nrs_pol2cptab(policy),
+						 nrs_pol2cptid(policy));
+	if (dl_data->dl_binheap == NULL) {
+		OBD_FREE_PTR(dl_data);
+		RETURN(-ENOMEM);
+	}
+
+	dl_data->dl_shed = 0;
+
+	policy->pol_private = dl_data;
+
+	RETURN(0);
+}
+
+/**
+ * Is called before the policy transitions into
+ * ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED; deallocates the
+ * deadline-specific private data structure.
+ *
+ * \param[in] policy The policy to stop
+ *
+ * \see nrs_policy_stop0()
+ */
+static void nrs_deadline_stop(struct ptlrpc_nrs_policy *policy)
+{
+	struct nrs_deadline_data *dl_data = policy->pol_private;
+
+	LASSERT(dl_data != NULL);
+	LASSERT(dl_data->dl_binheap != NULL);
+	LASSERT(cfs_binheap_is_empty(dl_data->dl_binheap));
+
+	cfs_binheap_destroy(dl_data->dl_binheap);
+
+	OBD_FREE_PTR(dl_data);
+}
+
+/**
+ * Is called for obtaining a deadline policy resource.
+ *
+ * \param[in]  policy	  The policy on which the request is being asked for
+ * \param[in]  nrq	  The request for which resources are being taken
+ * \param[in]  parent	  Parent resource, unused in this policy
+ * \param[out] resp	  Resources references are placed in this array
+ * \param[in]  moving_req Signifies limited caller context; unused in this
+ *			  policy
+ *
+ * \retval 1 The deadline policy only has a one-level resource hierarchy
+ *
+ * \see nrs_resource_get_safe()
+ */
+static int nrs_deadline_res_get(struct ptlrpc_nrs_policy *policy,
+				struct ptlrpc_nrs_request *nrq,
+				const struct ptlrpc_nrs_resource *parent,
+				struct ptlrpc_nrs_resource **resp,
+				bool moving_req)
+{
+	*resp = &((struct nrs_deadline_data *)policy->pol_private)->dl_res;
+	return 1;
+}
+
+/**
+ * Whether request \a nrq would miss its deadline after waiting for \a queued
+ * requests to be handled first, according to the number of running service
+ * threads and the service time estimate of the service partition.
+ */
+static bool nrs_deadline_req_late(struct ptlrpc_nrs_policy *policy,
+				  struct ptlrpc_nrs_request *nrq,
+				  size_t queued)
+{
+	struct ptlrpc_request *req = container_of(nrq, struct ptlrpc_request,
+						  rq_nrq);
+	struct ptlrpc_service_part *svcpt = nrs_pol2svcpt(policy);
+	int threads = max(svcpt->scp_nthrs_running, 1);
+	time64_t wait;
+
+	if (AT_OFF)
+		return false;
+
+	wait = (queued / threads + 1) * at_get(&svcpt->scp_at_estimate);
+
+	return req->rq_deadline < ktime_get_real_seconds() + wait;
+}
+
+/**
+ * Called when getting a request from the deadline policy for handling, or
+ * just peeking; removes the request from the policy when it is to be
+ * handled. The request with the earliest deadline is always returned; it is
+ * marked to be shed if it can't be handled in time anymore and shedding is
+ * enabled.
+ *
+ * \param[in] policy The policy
+ * \param[in] peek   When set, signifies that we just want to examine the
+ *		     request, and not handle it, so the request is not removed
+ *		     from the policy.
+ * \param[in] force  Force the policy to return a request; unused in this
+ *		     policy
+ *
+ * \retval The request to be handled
+ * \retval NULL no request available
+ *
+ * \see ptlrpc_nrs_req_get_nolock()
+ * \see nrs_request_get()
+ */
+static
+struct ptlrpc_nrs_request *nrs_deadline_req_get(struct ptlrpc_nrs_policy *policy,
+						bool peek, bool force)
+{
+	struct nrs_deadline_data *dl_data = policy->pol_private;
+	struct cfs_binheap_node *node;
+	struct ptlrpc_nrs_request *nrq;
+
+	node = cfs_binheap_root(dl_data->dl_binheap);
+	nrq = unlikely(node == NULL) ? NULL :
+	      container_of(node, struct ptlrpc_nrs_request, nr_node);
+
+	if (likely(nrq != NULL && !peek)) {
+		cfs_binheap_remove(dl_data->dl_binheap, &nrq->nr_node);
+
+		if (dl_data->dl_shed && !nrq->nr_shed &&
+		    nrs_deadline_req_late(policy, nrq, 0))
+			nrq->nr_shed = 1;
+	}
+
+	return nrq;
+}
+
+/**
+ * Adds request \a nrq to a deadline \a policy instance's set of queued
+ * requests. When shedding is enabled, a request which is not expected to
+ * meet its deadline behind the requests queued already is marked to be shed
+ * and is queued first, so that it is answered at once.
+ *
+ * \param[in] policy The policy
+ * \param[in] nrq    The request to add
+ *
+ * \retval 0 request added
+ * \retval != 0 error
+ */
+static int nrs_deadline_req_add(struct ptlrpc_nrs_policy *policy,
+				struct ptlrpc_nrs_request *nrq)
+{
+	struct nrs_deadline_data *dl_data = policy->pol_private;
+	struct ptlrpc_request *req = container_of(nrq, struct ptlrpc_request,
+						  rq_nrq);
+
+	/* the heap key must not change while the request is queued, so the
+	 * later deadlines set by early replies are not taken into account */
+	nrq->nr_u.deadline.dr_deadline = req->rq_deadline;
+	nrq->nr_u.deadline.dr_sequence = dl_data->dl_sequence++;
+
+	if (dl_data->dl_shed &&
+	    nrs_deadline_req_late(policy, nrq,
+				  cfs_binheap_size(dl_data->dl_binheap))) {
+		nrq->nr_shed = 1;
+		nrq->nr_u.deadline.dr_deadline = 0;
+	}
+
+	return cfs_binheap_insert(dl_data->dl_binheap, &nrq->nr_node);
+}
+
+/**
+ * Removes request \a nrq from \a policy's list of queued requests.
+ *
+ * \param[in] policy The policy
+ * \param[in] nrq    The request to remove
+ */
+static void nrs_deadline_req_del(struct ptlrpc_nrs_policy *policy,
+				 struct ptlrpc_nrs_request *nrq)
+{
+	struct nrs_deadline_data *dl_data = policy->pol_private;
+
+	cfs_binheap_remove(dl_data->dl_binheap, &nrq->nr_node);
+}
+
+/**
+ * Prints a debug statement right before the request \a nrq stops being
+ * handled.
+ *
+ * \param[in] policy The policy handling the request
+ * \param[in] nrq    The request being handled
+ *
+ * \see ptlrpc_server_finish_request()
+ * \see ptlrpc_nrs_req_stop_nolock()
+ */
+static void nrs_deadline_req_stop(struct ptlrpc_nrs_policy *policy,
+				  struct ptlrpc_nrs_request *nrq)
+{
+	struct ptlrpc_request *req = container_of(nrq, struct ptlrpc_request,
+						  rq_nrq);
+
+	DEBUG_REQ(D_RPCTRACE, req,
+		  "NRS: finished %s request from %s, deadline in %llds",
+		  nrq->nr_shed ? "shed" : "handling",
+		  libcfs_id2str(req->rq_peer),
+		  (s64)(req->rq_deadline - ktime_get_real_seconds()));
+}
+
+/**
+ * Performs ctl functions specific to deadline policy instances; similar to
+ * ioctl
+ *
+ * \param[in]     policy the policy instance
+ * \param[in]     opc    the opcode
+ * \param[in,out] arg    used for passing parameters and information
+ *
+ * \pre assert_spin_locked(&policy->pol_nrs->->nrs_lock)
+ * \post assert_spin_locked(&policy->pol_nrs->->nrs_lock)
+ *
+ * \retval 0   operation carried out successfully
+ * \retval -ve error
+ */
+static int nrs_deadline_ctl(struct ptlrpc_nrs_policy *policy,
+			    enum ptlrpc_nrs_ctl opc, void *arg)
+{
+	struct nrs_deadline_data *dl_data = policy->pol_private;
+	__u32 *val = (__u32 *)arg;
+
+	assert_spin_locked(&policy->pol_nrs->nrs_lock);
+
+	switch ((enum nrs_ctl_deadline)opc) {
+	default:
+		RETURN(-EINVAL);
+
+	case NRS_CTL_DEADLINE_RD_SHED:
+		*val = dl_data->dl_shed;
+		break;
+
+	case NRS_CTL_DEADLINE_WR_SHED:
+		if (*val > 1)
+			RETURN(-EINVAL);
+
+		dl_data->dl_shed = *val;
+		break;
+	}
+	RETURN(0);
+}
+
+/**
+ * debugfs interface
+ */
+
+#define LPROCFS_NRS_DEADLINE_SHED_NAME_REG	"reg_shed:"
+#define LPROCFS_NRS_DEADLINE_SHED_NAME_HP	"hp_shed:"
+
+/**
+ * Max size of the nrs_deadline_shed seq_write buffer. Needs to be large
+ * enough to hold the string: "reg_shed:1 hp_shed:1"
+ */
+#define LPROCFS_NRS_DEADLINE_SHED_SIZE					       \
+	sizeof(LPROCFS_NRS_DEADLINE_SHED_NAME_REG "1 "			       \
+	       LPROCFS_NRS_DEADLINE_SHED_NAME_HP "1")
+
+/**
+ * Retrieves whether requests which can't meet their deadline are shed, for
+ * deadline policy instances on both the regular and high-priority NRS head
+ * of a service, as long as a policy instance is not in the
+ * ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state;
+ */
+static int
+ptlrpc_lprocfs_nrs_deadline_shed_seq_show(struct seq_file *m, void *data)
+{
+	struct ptlrpc_service *svc = m->private;
+	__u32 shed;
+	int rc;
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+				       NRS_POL_NAME_DEADLINE,
+				       NRS_CTL_DEADLINE_RD_SHED,
+				       true, &shed);
+	if (rc == 0)
+		seq_printf(m, LPROCFS_NRS_DEADLINE_SHED_NAME_REG"%u\n", shed);
+		/**
+		 * Ignore -ENODEV as the regular NRS head's policy may be in
+		 * the ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state.
+		 */
+	else if (rc != -ENODEV)
+		return rc;
+
+	if (!nrs_svc_has_hp(svc))
+		return 0;
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+				       NRS_POL_NAME_DEADLINE,
+				       NRS_CTL_DEADLINE_RD_SHED,
+				       true, &shed);
+	if (rc == 0)
+		seq_printf(m, LPROCFS_NRS_DEADLINE_SHED_NAME_HP"%u\n", shed);
+	else if (rc == -ENODEV)
+		rc = 0;
+
+	return rc;
+}
+
+/**
+ * Enables or disables the shedding of requests which can't meet their
+ * deadline for deadline policy instances of a service; it is disabled by
+ * default. The user can set it for the regular or high-priority NRS head
+ * individually, or for both together in a single invocation.
+ *
+ * For example:
+ *
+ * lctl set_param *.*.*.nrs_deadline_shed=reg_shed:1, to shed the regular
+ * requests on all PtlRPC services which can't meet their deadline
+ *
+ * lctl set_param *.*.ost_io.nrs_deadline_shed=1, to shed both the regular
+ * and high-priority requests of the ost_io service which are too late.
+ */
+static ssize_t
+ptlrpc_lprocfs_nrs_deadline_shed_seq_write(struct file *file,
+					   const char __user *buffer,
+					   size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct ptlrpc_service *svc = m->private;
+	enum ptlrpc_nrs_queue_type queue = 0;
+	char kernbuf[LPROCFS_NRS_DEADLINE_SHED_SIZE];
+	unsigned long val_reg = 0;
+	unsigned long val_hp = 0;
+	size_t count_copy;
+	char *val_str;
+	int rc;
+
+	if (count > sizeof(kernbuf) - 1)
+		return -EINVAL;
+
+	if (copy_from_user(kernbuf, buffer, count))
+		return -EFAULT;
+	kernbuf[count] = '\0';
+
+	count_copy = count;
+	val_str = lprocfs_find_named_value(kernbuf,
+					   LPROCFS_NRS_DEADLINE_SHED_NAME_REG,
+					   &count_copy);
+	if (val_str != kernbuf) {
+		rc = kstrtoul(val_str, 10, &val_reg);
+		if (rc != 0)
+			return -EINVAL;
+		queue |= PTLRPC_NRS_QUEUE_REG;
+	}
+
+	count_copy = count;
+	val_str = lprocfs_find_named_value(kernbuf,
+					   LPROCFS_NRS_DEADLINE_SHED_NAME_HP,
+					   &count_copy);
+	if (val_str != kernbuf) {
+		if (!nrs_svc_has_hp(svc))
+			return -ENODEV;
+
+		rc = kstrtoul(val_str, 10, &val_hp);
+		if (rc != 0)
+			return -EINVAL;
+		queue |= PTLRPC_NRS_QUEUE_HP;
+	}
+
+	if (queue == 0) {
+		rc = kstrtoul(kernbuf, 10, &val_reg);
+		if (rc != 0)
+			return -EINVAL;
+
+		queue = PTLRPC_NRS_QUEUE_REG;
+		if (nrs_svc_has_hp(svc)) {
+			queue |= PTLRPC_NRS_QUEUE_HP;
+			val_hp = val_reg;
+		}
+	}
+
+	if (val_reg > 1 || val_hp > 1)
+		return -EINVAL;
+
+	if (queue & PTLRPC_NRS_QUEUE_REG) {
+		__u32 shed = val_reg;
+
+		rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+					       NRS_POL_NAME_DEADLINE,
+					       NRS_CTL_DEADLINE_WR_SHED,
+					       false, &shed);
+		if ((rc < 0 && rc != -ENODEV) ||
+		    (rc == -ENODEV && queue == PTLRPC_NRS_QUEUE_REG))
+			return rc;
+	}
+
+	if (queue & PTLRPC_NRS_QUEUE_HP) {
+		__u32 shed = val_hp;
+
+		rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+					       NRS_POL_NAME_DEADLINE,
+					       NRS_CTL_DEADLINE_WR_SHED,
+					       false, &shed);
+		if ((rc < 0 && rc != -ENODEV) ||
+		    (rc == -ENODEV && queue == PTLRPC_NRS_QUEUE_HP))
+			return rc;
+	}
+
+	return count;
+}
+LDEBUGFS_SEQ_FOPS(ptlrpc_lprocfs_nrs_deadline_shed);
+
+static int nrs_deadline_lprocfs_init(struct ptlrpc_service *svc)
+{
+	struct lprocfs_vars nrs_deadline_lprocfs_vars[] = {
+		{ .name		= "nrs_deadline_shed",
+		  .fops		= &ptlrpc_lprocfs_nrs_deadline_shed_fops,
+		  .data		= svc },
+		{ NULL }
+	};
+
+	if (IS_ERR_OR_NULL(svc->srv_debugfs_entry))
+		return 0;
+
+	return ldebugfs_add_vars(svc->srv_debugfs_entry,
+				 nrs_deadline_lprocfs_vars, NULL);
+}
+
+/**
+ * Deadline policy operations
+ */
+static const struct ptlrpc_nrs_pol_ops nrs_deadline_ops = {
+	.op_policy_start	= nrs_deadline_start,
+	.op_policy_stop		= nrs_deadline_stop,
+	.op_policy_ctl		= nrs_deadline_ctl,
+	.op_res_get		= nrs_deadline_res_get,
+	.op_req_get		= nrs_deadline_req_get,
+	.op_req_enqueue		= nrs_deadline_req_add,
+	.op_req_dequeue		= nrs_deadline_req_del,
+	.op_req_stop		= nrs_deadline_req_stop,
+	.op_lprocfs_init	= nrs_deadline_lprocfs_init,
+};
+
+/**
+ * Deadline policy configuration
+ */
+struct ptlrpc_nrs_pol_conf nrs_conf_deadline = {
+	.nc_name		= NRS_POL_NAME_DEADLINE,
+	.nc_ops			= &nrs_deadline_ops,
+	.nc_compat		= nrs_policy_compat_all,
+};
+
+/** @} deadline */
+
+/** @} nrs */
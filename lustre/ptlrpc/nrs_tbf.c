@@ -1433,6 +1433,8 @@ static struct req_format *req_fmt(__u32 opcode)
 		return &RQF_OST_SYNC;
 	case OST_LADVISE:
 		return &RQF_OST_LADVISE;
+	case OST_FALLOCATE:
+		return &RQF_OST_FALLOCATE;
 	case MDS_GETATTR:
 		return &RQF_MDS_GETATTR;
 	case MDS_GETATTR_NAME:
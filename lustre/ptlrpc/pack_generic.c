@@ -1681,10 +1681,12 @@ void lustre_swab_connect(struct obd_connect_data *ocd)
                 __swab64s(&ocd->ocd_maxbytes);
 	if (ocd->ocd_connect_flags & OBD_CONNECT_MULTIMODRPCS)
 		__swab16s(&ocd->ocd_maxmodrpcs);
-	CLASSERT(offsetof(typeof(*ocd), padding0) != 0);
 	CLASSERT(offsetof(typeof(*ocd), padding1) != 0);
-	if (ocd->ocd_connect_flags & OBD_CONNECT_FLAGS2)
+	if (ocd->ocd_connect_flags & OBD_CONNECT_FLAGS2) {
 		__swab64s(&ocd->ocd_connect_flags2);
+		if (ocd->ocd_connect_flags2 & OBD_CONNECT2_COMPRESS)
+			__swab16s(&ocd->ocd_compr_types);
+	}
         CLASSERT(offsetof(typeof(*ocd), padding3) != 0);
         CLASSERT(offsetof(typeof(*ocd), padding4) != 0);
         CLASSERT(offsetof(typeof(*ocd), padding5) != 0);
@@ -1737,7 +1739,8 @@ void lustre_swab_obdo (struct obdo  *o)
 	__swab32s(&o->o_gid_h);
 	__swab64s(&o->o_data_version);
 	__swab32s(&o->o_projid);
-	CLASSERT(offsetof(typeof(*o), o_padding_4) != 0);
+	__swab32s(&o->o_falloc_mode);
+	__swab32s(&o->o_compr_size);
 	CLASSERT(offsetof(typeof(*o), o_padding_5) != 0);
 	CLASSERT(offsetof(typeof(*o), o_padding_6) != 0);
 
@@ -2143,7 +2146,8 @@ void lustre_swab_lmv_user_md(struct lmv_user_md *lum)
 	__swab32s(&lum->lum_stripe_offset);
 	__swab32s(&lum->lum_hash_type);
 	__swab32s(&lum->lum_type);
-	CLASSERT(offsetof(typeof(*lum), lum_padding1) != 0);
+	__swab32s(&lum->lum_placement);
+	CLASSERT(offsetof(typeof(*lum), lum_padding2) != 0);
 	switch (lum->lum_magic) {
 	case LMV_USER_MAGIC_SPECIFIC:
 		count = lum->lum_stripe_count;
@@ -2770,6 +2774,22 @@ void lustre_swab_out_update_buffer(struct out_update_buffer *oub)
 }
 EXPORT_SYMBOL(lustre_swab_out_update_buffer);
 
+void lustre_swab_batch_update_header(struct batch_update_header *buh)
+{
+	__swab32s(&buh->buh_magic);
+	__swab32s(&buh->buh_count);
+	__swab32s(&buh->buh_reply_size);
+	__swab32s(&buh->buh_padding);
+}
+EXPORT_SYMBOL(lustre_swab_batch_update_header);
+
+void lustre_swab_batch_update_buffer(struct batch_update_buffer *bub)
+{
+	__swab32s(&bub->bub_size);
+	__swab32s(&bub->bub_rc);
+}
+EXPORT_SYMBOL(lustre_swab_batch_update_buffer);
+
 void lustre_swab_swap_layouts(struct mdc_swap_layouts *msl)
 {
 	__swab64s(&msl->msl_flags);
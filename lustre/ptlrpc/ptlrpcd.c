@@ -53,6 +53,7 @@
 
 #include <linux/kthread.h>
 #include <libcfs/libcfs.h>
+#include <libcfs/linux/linux-list.h>
 #include <lustre_net.h>
 #include <lustre_lib.h>
 #include <lustre_ha.h>
@@ -107,9 +108,9 @@ MODULE_PARM_DESC(ptlrpcd_per_cpt_max,
 
 /*
  * ptlrpcd_partner_group_size: The desired number of threads in each
- * ptlrpcd partner thread group. Default is 2, corresponding to the
- * old PDB_POLICY_PAIR. A negative value makes all ptlrpcd threads in
- * a CPT partners of each other.
+ * ptlrpcd partner thread group. Default is 0 or a negative value, which
+ * makes all ptlrpcd threads in a CPT partners of each other. A value of
+ * 2 corresponds to the old PDB_POLICY_PAIR.
  */
 static int ptlrpcd_partner_group_size;
 module_param(ptlrpcd_partner_group_size, int, 0644);
@@ -165,12 +166,22 @@ void ptlrpcd_wake(struct ptlrpc_request *req)
 }
 EXPORT_SYMBOL(ptlrpcd_wake);
 
+/* Number of RPCs a ptlrpcd thread has to handle, in flight or queued. */
+static inline int ptlrpcd_load(struct ptlrpcd_ctl *pc)
+{
+	struct ptlrpc_request_set *set = pc->pc_set;
+
+	return atomic_read(&set->set_remaining) +
+	       atomic_read(&set->set_new_count);
+}
+
 static struct ptlrpcd_ctl *
 ptlrpcd_select_pc(struct ptlrpc_request *req)
 {
 	struct ptlrpcd	*pd;
 	int		cpt;
 	int		idx;
+	int		next;
 
 	if (req != NULL && req->rq_send_state != LUSTRE_IMP_FULL)
 		return &ptlrpcd_rcv;
@@ -188,74 +199,118 @@ ptlrpcd_select_pc(struct ptlrpc_request *req)
 		idx = 0;
 	pd->pd_cursor = idx;
 
+	/* Of the thread at the cursor and the next one, pick the one with
+	 * fewer RPCs to handle, so that the threads busy with many RPCs get
+	 * less new ones. */
+	next = idx + 1;
+	if (next == pd->pd_nthreads)
+		next = 0;
+	if (ptlrpcd_load(&pd->pd_threads[next]) <
+	    ptlrpcd_load(&pd->pd_threads[idx]))
+		idx = next;
+
 	return &pd->pd_threads[idx];
 }
 
+/**
+ * Wake up the ptlrpcd thread \a pc for its first new request. If the thread
+ * has RPCs in flight already, it may be busy with them for a while, so also
+ * wake up one of its partners, which steals the new requests if it is idle.
+ */
+void ptlrpcd_wake_new(struct ptlrpcd_ctl *pc)
+{
+	struct ptlrpc_request_set *set = pc->pc_set;
+	struct ptlrpcd_ctl *partner;
+
+	wake_up(&set->set_waitq);
+
+	if (pc->pc_npartners == 0 || atomic_read(&set->set_remaining) == 0)
+		return;
+
+	/* the cursor is moved by the thread itself, not a problem to race */
+	partner = pc->pc_partners[READ_ONCE(pc->pc_cursor) % pc->pc_npartners];
+	wake_up(&partner->pc_set->set_waitq);
+}
+
 /**
  * Move all request from an existing request set to the ptlrpcd queue.
  * All requests from the set must be in phase RQ_PHASE_NEW.
  */
 void ptlrpcd_add_rqset(struct ptlrpc_request_set *set)
 {
-	struct list_head *tmp, *pos;
+	struct ptlrpc_request *req;
+	struct ptlrpc_request *tmp;
 	struct ptlrpcd_ctl *pc;
 	struct ptlrpc_request_set *new;
-	int count, i;
+	ktime_t now = ktime_get();
+	bool wake = false;
+	int i;
 
 	pc = ptlrpcd_select_pc(NULL);
 	new = pc->pc_set;
 
-	list_for_each_safe(pos, tmp, &set->set_requests) {
-		struct ptlrpc_request *req =
-			list_entry(pos, struct ptlrpc_request,
-				   rq_set_chain);
+	i = atomic_read(&set->set_remaining);
+	atomic_add(i, &new->set_new_count);
+	atomic_set(&set->set_remaining, 0);
 
+	list_for_each_entry_safe(req, tmp, &set->set_requests, rq_set_chain) {
 		LASSERT(req->rq_phase == RQ_PHASE_NEW);
+		list_del_init(&req->rq_set_chain);
 		req->rq_set = new;
 		req->rq_queued_time = ktime_get_seconds();
+		req->rq_queued_ns = now;
+		if (llist_add(&req->rq_new_node, &new->set_new_requests))
+			wake = true;
 	}
 
-	spin_lock(&new->set_new_req_lock);
-	list_splice_init(&set->set_requests, &new->set_new_requests);
-	i = atomic_read(&set->set_remaining);
-	count = atomic_add_return(i, &new->set_new_count);
-	atomic_set(&set->set_remaining, 0);
-	spin_unlock(&new->set_new_req_lock);
-	if (count == i) {
-		wake_up(&new->set_waitq);
-
-		/* XXX: It maybe unnecessary to wakeup all the partners. But to
-		 *      guarantee the async RPC can be processed ASAP, we have
-		 *      no other better choice. It maybe fixed in future. */
-		for (i = 0; i < pc->pc_npartners; i++)
-			wake_up(&pc->pc_partners[i]->pc_set->set_waitq);
-	}
+	if (wake)
+		ptlrpcd_wake_new(pc);
 }
 
 /**
+ * Fold the new requests of the set \a src into the set \a des, which is
+ * either \a src itself or the set of a ptlrpcd thread stealing them, and
+ * account how long they have been waiting for a ptlrpcd thread.
+ *
+ * Any number of threads can do this concurrently, and concurrently with
+ * ptlrpc_set_add_new_req(), without locking.
+ *
  * Return transferred RPCs count.
  */
-static int ptlrpcd_steal_rqset(struct ptlrpc_request_set *des,
-                               struct ptlrpc_request_set *src)
+static int ptlrpcd_fold_new(struct ptlrpc_request_set *des,
+			    struct ptlrpc_request_set *src)
 {
-	struct list_head *tmp, *pos;
 	struct ptlrpc_request *req;
+	struct ptlrpc_request *next;
+	struct llist_node *first;
+	ktime_t now;
 	int rc = 0;
 
-	spin_lock(&src->set_new_req_lock);
-	if (likely(!list_empty(&src->set_new_requests))) {
-		list_for_each_safe(pos, tmp, &src->set_new_requests) {
-			req = list_entry(pos, struct ptlrpc_request,
-					 rq_set_chain);
-			req->rq_set = des;
-		}
-		list_splice_init(&src->set_new_requests,
-				 &des->set_requests);
-		rc = atomic_read(&src->set_new_count);
-		atomic_add(rc, &des->set_remaining);
-		atomic_set(&src->set_new_count, 0);
+	first = llist_del_all(&src->set_new_requests);
+	if (first == NULL)
+		return 0;
+
+	now = ktime_get();
+	/* the list is LIFO, keep the requests in their arrival order */
+	first = llist_reverse_order(first);
+	llist_for_each_entry_safe(req, next, first, rq_new_node) {
+		struct obd_device *obd = NULL;
+
+		if (req->rq_import != NULL)
+			obd = req->rq_import->imp_obd;
+		if (obd != NULL && obd->obd_svc_stats != NULL)
+			lprocfs_counter_add(obd->obd_svc_stats,
+					    PTLRPC_PTLRPCD_WAIT_CNTR,
+					    ktime_us_delta(now,
+							   req->rq_queued_ns));
+
+		req->rq_set = des;
+		list_add_tail(&req->rq_set_chain, &des->set_requests);
+		rc++;
 	}
-	spin_unlock(&src->set_new_req_lock);
+	atomic_sub(rc, &src->set_new_count);
+	atomic_add(rc, &des->set_remaining);
+
 	return rc;
 }
 
@@ -320,20 +375,12 @@ static int ptlrpcd_check(struct lu_env *env, struct ptlrpcd_ctl *pc)
         int rc2;
         ENTRY;
 
-	if (atomic_read(&set->set_new_count)) {
-		spin_lock(&set->set_new_req_lock);
-		if (likely(!list_empty(&set->set_new_requests))) {
-			list_splice_init(&set->set_new_requests,
-					     &set->set_requests);
-			atomic_add(atomic_read(&set->set_new_count),
-				   &set->set_remaining);
-			atomic_set(&set->set_new_count, 0);
-			/*
-			 * Need to calculate its timeout.
-			 */
+	if (!llist_empty(&set->set_new_requests)) {
+		/*
+		 * Need to calculate its timeout.
+		 */
+		if (ptlrpcd_fold_new(set, set) > 0)
 			rc = 1;
-		}
-		spin_unlock(&set->set_new_req_lock);
 	}
 
 	/* We should call lu_env_refill() before handling new requests to make
@@ -374,7 +421,7 @@ static int ptlrpcd_check(struct lu_env *env, struct ptlrpcd_ctl *pc)
 		/*
 		 * If new requests have been added, make sure to wake up.
 		 */
-		rc = atomic_read(&set->set_new_count);
+		rc = !llist_empty(&set->set_new_requests);
 
                 /* If we have nothing to do, check whether we can take some
                  * work from our partner threads. */
@@ -400,8 +447,8 @@ static int ptlrpcd_check(struct lu_env *env, struct ptlrpcd_ctl *pc)
 				ptlrpc_reqset_get(ps);
 				spin_unlock(&partner->pc_lock);
 
-				if (atomic_read(&ps->set_new_count)) {
-					rc = ptlrpcd_steal_rqset(set, ps);
+				if (!llist_empty(&ps->set_new_requests)) {
+					rc = ptlrpcd_fold_new(set, ps);
 					if (rc > 0)
 						CDEBUG(D_RPCTRACE, "transfer %d"
 						       " async RPCs [%d->%d]\n",
@@ -550,15 +597,16 @@ static void ptlrpcd_ctl_init(struct ptlrpcd_ctl *pc, int index, int cpt)
  *      will be defined in a way that matches these boundaries. Within
  *      a CPT a ptlrpcd thread can be scheduled on any available core.
  *
- *      Each ptlrpcd thread has its own request queue. This can cause
- *      response delay if the thread is already busy. To help with
- *      this we define partner threads: these are other threads bound
- *      to the same CPT which will check for work in each other's
- *      request queues if they have no work to do.
+ *      Each ptlrpcd thread has its own lock-free request queue, and
+ *      new requests go to the less loaded of two threads. This can
+ *      still cause response delay if the thread is already busy. To
+ *      help with this we define partner threads: these are other
+ *      threads bound to the same CPT which will steal the work from
+ *      each other's request queues if they have no work to do.
  *
  *      The desired number of partner threads can be tuned by setting
- *      ptlrpcd_partner_group_size. The default is to create pairs of
- *      partner threads.
+ *      ptlrpcd_partner_group_size. The default is to make all the
+ *      threads of a CPT partners.
  */
 static int ptlrpcd_partners(struct ptlrpcd *pd, int index)
 {
@@ -843,9 +891,7 @@ static int ptlrpcd_init(void)
 		}
 	}
 
-	if (ptlrpcd_partner_group_size == 0)
-		ptlrpcd_partner_group_size = 2;
-	else if (ptlrpcd_partner_group_size < 0)
+	if (ptlrpcd_partner_group_size <= 0)
 		ptlrpcd_partner_group_size = -1;
 	else if (ptlrpcd_per_cpt_max > 0 &&
 		 ptlrpcd_partner_group_size > ptlrpcd_per_cpt_max)
@@ -535,10 +535,25 @@ int pool_is_at_full_capacity(void)
 }
 EXPORT_SYMBOL(pool_is_at_full_capacity);
 
+static inline void **page_from_bulkdesc(void *array, int index)
+{
+	struct ptlrpc_bulk_desc *desc = (struct ptlrpc_bulk_desc *)array;
+
+	return (void **)&BD_GET_ENC_KIOV(desc, index).kiov_page;
+}
+
+static inline void **page_from_pagearray(void *array, int index)
+{
+	struct page **pa = (struct page **)array;
+
+	return (void **)&pa[index];
+}
+
 /*
  * we allocate the requested pages atomically.
  */
-int sptlrpc_enc_pool_get_pages(struct ptlrpc_bulk_desc *desc)
+static int __sptlrpc_enc_pool_get_pages(void *array, unsigned int count,
+					void **(*page_from)(void *, int))
 {
 	wait_queue_entry_t waitlink;
 	unsigned long this_idle = -1;
@@ -547,33 +562,23 @@ int sptlrpc_enc_pool_get_pages(struct ptlrpc_bulk_desc *desc)
 	int p_idx, g_idx;
 	int i;
 
-	LASSERT(ptlrpc_is_bulk_desc_kiov(desc->bd_type));
-	LASSERT(desc->bd_iov_count > 0);
-	LASSERT(desc->bd_iov_count <= page_pools.epp_max_pages);
-
-	/* resent bulk, enc iov might have been allocated previously */
-	if (GET_ENC_KIOV(desc) != NULL)
-		return 0;
-
-	OBD_ALLOC_LARGE(GET_ENC_KIOV(desc),
-		  desc->bd_iov_count * sizeof(*GET_ENC_KIOV(desc)));
-	if (GET_ENC_KIOV(desc) == NULL)
-		return -ENOMEM;
+	if (count == 0 || count > page_pools.epp_max_pages)
+		return -EINVAL;
 
 	spin_lock(&page_pools.epp_lock);
 
 	page_pools.epp_st_access++;
 again:
-	if (unlikely(page_pools.epp_free_pages < desc->bd_iov_count)) {
+	if (unlikely(page_pools.epp_free_pages < count)) {
 		if (tick_ns == 0)
 			tick_ns = ktime_get_ns();
 
 		now = ktime_get_real_seconds();
 
 		page_pools.epp_st_missings++;
-		page_pools.epp_pages_short += desc->bd_iov_count;
+		page_pools.epp_pages_short += count;
 
-		if (enc_pools_should_grow(desc->bd_iov_count, now)) {
+		if (enc_pools_should_grow(count, now)) {
 			page_pools.epp_growing = 1;
 
 			spin_unlock(&page_pools.epp_lock);
@@ -609,16 +614,12 @@ again:
 				 * will put request back in queue. */
 				page_pools.epp_st_outofmem++;
 				spin_unlock(&page_pools.epp_lock);
-				OBD_FREE_LARGE(GET_ENC_KIOV(desc),
-					       desc->bd_iov_count *
-						sizeof(*GET_ENC_KIOV(desc)));
-				GET_ENC_KIOV(desc) = NULL;
 				return -ENOMEM;
 			}
 		}
 
-		LASSERT(page_pools.epp_pages_short >= desc->bd_iov_count);
-		page_pools.epp_pages_short -= desc->bd_iov_count;
+		LASSERT(page_pools.epp_pages_short >= count);
+		page_pools.epp_pages_short -= count;
 
 		this_idle = 0;
 		goto again;
@@ -632,16 +633,17 @@ again:
 			page_pools.epp_st_max_wait = tick;
 	}
 
-        /* proceed with rest of allocation */
-        page_pools.epp_free_pages -= desc->bd_iov_count;
+	/* proceed with rest of allocation */
+	page_pools.epp_free_pages -= count;
 
-        p_idx = page_pools.epp_free_pages / PAGES_PER_POOL;
-        g_idx = page_pools.epp_free_pages % PAGES_PER_POOL;
+	p_idx = page_pools.epp_free_pages / PAGES_PER_POOL;
+	g_idx = page_pools.epp_free_pages % PAGES_PER_POOL;
+
+	for (i = 0; i < count; i++) {
+		void **pagep = page_from(array, i);
 
-	for (i = 0; i < desc->bd_iov_count; i++) {
 		LASSERT(page_pools.epp_pools[p_idx][g_idx] != NULL);
-		BD_GET_ENC_KIOV(desc, i).kiov_page =
-		       page_pools.epp_pools[p_idx][g_idx];
+		*pagep = page_pools.epp_pools[p_idx][g_idx];
 		page_pools.epp_pools[p_idx][g_idx] = NULL;
 
 		if (++g_idx == PAGES_PER_POOL) {
@@ -650,55 +652,94 @@ again:
 		}
 	}
 
-        if (page_pools.epp_free_pages < page_pools.epp_st_lowfree)
-                page_pools.epp_st_lowfree = page_pools.epp_free_pages;
+	if (page_pools.epp_free_pages < page_pools.epp_st_lowfree)
+		page_pools.epp_st_lowfree = page_pools.epp_free_pages;
 
-        /*
-         * new idle index = (old * weight + new) / (weight + 1)
-         */
-        if (this_idle == -1) {
-                this_idle = page_pools.epp_free_pages * IDLE_IDX_MAX /
-                            page_pools.epp_total_pages;
-        }
-        page_pools.epp_idle_idx = (page_pools.epp_idle_idx * IDLE_IDX_WEIGHT +
-                                   this_idle) /
-                                  (IDLE_IDX_WEIGHT + 1);
+	/*
+	 * new idle index = (old * weight + new) / (weight + 1)
+	 */
+	if (this_idle == -1) {
+		this_idle = page_pools.epp_free_pages * IDLE_IDX_MAX /
+			    page_pools.epp_total_pages;
+	}
+	page_pools.epp_idle_idx = (page_pools.epp_idle_idx * IDLE_IDX_WEIGHT +
+				   this_idle) /
+				  (IDLE_IDX_WEIGHT + 1);
 
 	page_pools.epp_last_access = ktime_get_seconds();
 
 	spin_unlock(&page_pools.epp_lock);
 	return 0;
 }
-EXPORT_SYMBOL(sptlrpc_enc_pool_get_pages);
 
-void sptlrpc_enc_pool_put_pages(struct ptlrpc_bulk_desc *desc)
+int sptlrpc_enc_pool_get_pages(struct ptlrpc_bulk_desc *desc)
 {
-	int     p_idx, g_idx;
-	int     i;
+	int rc;
 
 	LASSERT(ptlrpc_is_bulk_desc_kiov(desc->bd_type));
+	LASSERT(desc->bd_iov_count > 0);
+	LASSERT(desc->bd_iov_count <= page_pools.epp_max_pages);
 
+	/* resent bulk, enc iov might have been allocated previously */
+	if (GET_ENC_KIOV(desc) != NULL)
+		return 0;
+
+	OBD_ALLOC_LARGE(GET_ENC_KIOV(desc),
+		  desc->bd_iov_count * sizeof(*GET_ENC_KIOV(desc)));
 	if (GET_ENC_KIOV(desc) == NULL)
-		return;
+		return -ENOMEM;
 
-	LASSERT(desc->bd_iov_count > 0);
+	rc = __sptlrpc_enc_pool_get_pages((void *)desc, desc->bd_iov_count,
+					  page_from_bulkdesc);
+	if (rc) {
+		OBD_FREE_LARGE(GET_ENC_KIOV(desc),
+			       desc->bd_iov_count *
+			       sizeof(*GET_ENC_KIOV(desc)));
+		GET_ENC_KIOV(desc) = NULL;
+	}
+	return rc;
+}
+EXPORT_SYMBOL(sptlrpc_enc_pool_get_pages);
+
+/**
+ * Take \a count pages from the pool into the array \a pa, for users other
+ * than bulk descriptors, such as the bounce buffers of unaligned direct I/O.
+ * May sleep while the pool is growing.
+ */
+int sptlrpc_enc_pool_get_pages_array(struct page **pa, unsigned int count)
+{
+	return __sptlrpc_enc_pool_get_pages((void *)pa, count,
+					    page_from_pagearray);
+}
+EXPORT_SYMBOL(sptlrpc_enc_pool_get_pages_array);
+
+static void __sptlrpc_enc_pool_put_pages(void *array, unsigned int count,
+					 void **(*page_from)(void *, int))
+{
+	int p_idx, g_idx;
+	int i;
+
+	if (count == 0)
+		return;
 
 	spin_lock(&page_pools.epp_lock);
 
 	p_idx = page_pools.epp_free_pages / PAGES_PER_POOL;
 	g_idx = page_pools.epp_free_pages % PAGES_PER_POOL;
 
-	LASSERT(page_pools.epp_free_pages + desc->bd_iov_count <=
+	LASSERT(page_pools.epp_free_pages + count <=
 		page_pools.epp_total_pages);
 	LASSERT(page_pools.epp_pools[p_idx]);
 
-	for (i = 0; i < desc->bd_iov_count; i++) {
-		LASSERT(BD_GET_ENC_KIOV(desc, i).kiov_page != NULL);
+	for (i = 0; i < count; i++) {
+		void **pagep = page_from(array, i);
+
+		LASSERT(*pagep != NULL);
 		LASSERT(g_idx != 0 || page_pools.epp_pools[p_idx]);
 		LASSERT(page_pools.epp_pools[p_idx][g_idx] == NULL);
 
-		page_pools.epp_pools[p_idx][g_idx] =
-			BD_GET_ENC_KIOV(desc, i).kiov_page;
+		page_pools.epp_pools[p_idx][g_idx] = *pagep;
+		*pagep = NULL;
 
 		if (++g_idx == PAGES_PER_POOL) {
 			p_idx++;
@@ -706,17 +747,40 @@ void sptlrpc_enc_pool_put_pages(struct ptlrpc_bulk_desc *desc)
 		}
 	}
 
-	page_pools.epp_free_pages += desc->bd_iov_count;
+	page_pools.epp_free_pages += count;
 
 	enc_pools_wakeup();
 
 	spin_unlock(&page_pools.epp_lock);
+}
+
+void sptlrpc_enc_pool_put_pages(struct ptlrpc_bulk_desc *desc)
+{
+	LASSERT(ptlrpc_is_bulk_desc_kiov(desc->bd_type));
+
+	if (GET_ENC_KIOV(desc) == NULL)
+		return;
+
+	LASSERT(desc->bd_iov_count > 0);
+
+	__sptlrpc_enc_pool_put_pages((void *)desc, desc->bd_iov_count,
+				     page_from_bulkdesc);
 
 	OBD_FREE_LARGE(GET_ENC_KIOV(desc),
 		 desc->bd_iov_count * sizeof(*GET_ENC_KIOV(desc)));
 	GET_ENC_KIOV(desc) = NULL;
 }
 
+/**
+ * Return the \a count pages of \a pa taken by
+ * sptlrpc_enc_pool_get_pages_array() to the pool.
+ */
+void sptlrpc_enc_pool_put_pages_array(struct page **pa, unsigned int count)
+{
+	__sptlrpc_enc_pool_put_pages((void *)pa, count, page_from_pagearray);
+}
+EXPORT_SYMBOL(sptlrpc_enc_pool_put_pages_array);
+
 /*
  * we don't do much stuff for add_user/del_user anymore, except adding some
  * initial pages in add_user() if current pools are empty, rest would be
@@ -32,6 +32,7 @@
 
 #define DEBUG_SUBSYSTEM S_RPC
 
+#include <linux/hash.h>
 #include <linux/kthread.h>
 #include <linux/ratelimit.h>
 
@@ -199,15 +200,145 @@ ptlrpc_save_lock(struct ptlrpc_request *req, struct lustre_handle *lock,
 }
 EXPORT_SYMBOL(ptlrpc_save_lock);
 
+/**
+ * Set up a request for the sub-request message \a msg of \a len bytes,
+ * carried by the batched RPC \a req. The sub-request shares the export,
+ * service thread and security context of \a req. Its reply is packed as
+ * usual but is never sent, see ptlrpc_sub_req_reply_copy().
+ */
+struct ptlrpc_request *ptlrpc_sub_req_init(struct ptlrpc_request *req,
+					   struct lustre_msg *msg, int len)
+{
+	struct ptlrpc_request *sub;
+	int rc;
+	ENTRY;
+
+	sub = ptlrpc_request_cache_alloc(GFP_NOFS);
+	if (sub == NULL)
+		RETURN(ERR_PTR(-ENOMEM));
+
+	/* set up like a request coming from the network, then take the
+	 * identity, security context and service thread of the carrier */
+	ptlrpc_srv_req_init(sub);
+	sub->rq_xid = req->rq_xid;
+	sub->rq_reqbuf = msg;
+	sub->rq_reqdata_len = len;
+	sub->rq_reqmsg = msg;
+	sub->rq_reqlen = len;
+	sub->rq_arrival_time = req->rq_arrival_time;
+	sub->rq_deadline = req->rq_deadline;
+	sub->rq_peer = req->rq_peer;
+	sub->rq_source = req->rq_source;
+	sub->rq_self = req->rq_self;
+	sub->rq_rqbd = req->rq_rqbd;
+	sub->rq_svc_thread = req->rq_svc_thread;
+	sub->rq_phase = RQ_PHASE_INTERPRET;
+	sub->rq_export = class_export_get(req->rq_export);
+
+	sub->rq_flvr = req->rq_flvr;
+	sub->rq_sp_from = req->rq_sp_from;
+	sub->rq_auth_gss = req->rq_auth_gss;
+	sub->rq_auth_usr_root = req->rq_auth_usr_root;
+	sub->rq_auth_usr_mdt = req->rq_auth_usr_mdt;
+	sub->rq_auth_usr_ost = req->rq_auth_usr_ost;
+	sub->rq_auth_uid = req->rq_auth_uid;
+	sub->rq_auth_mapped_uid = req->rq_auth_mapped_uid;
+	sub->rq_user_desc = req->rq_user_desc;
+	memcpy(sub->rq_sepol, req->rq_sepol, sizeof(sub->rq_sepol));
+	sub->rq_svc_ctx = req->rq_svc_ctx;
+	sptlrpc_svc_ctx_addref(sub);
+
+	rc = ptlrpc_unpack_req_msg(sub, len);
+	if (rc == 0)
+		rc = lustre_unpack_req_ptlrpc_body(sub, MSG_PTLRPC_BODY_OFF);
+	if (rc == 0 && lustre_msg_get_type(msg) != PTL_RPC_MSG_REQUEST)
+		rc = -EPROTO;
+	if (rc != 0) {
+		DEBUG_REQ(D_ERROR, req, "bad sub-request of batched RPC: "
+			  "rc = %d", rc);
+		ptlrpc_sub_req_fini(sub);
+		RETURN(ERR_PTR(-EPROTO));
+	}
+
+	/* a resent batched RPC resends its sub-requests too, let the lock
+	 * enqueued by the first one be found again */
+	if (lustre_msg_get_flags(req->rq_reqmsg) & MSG_RESENT)
+		lustre_msg_add_flags(msg, MSG_RESENT);
+
+	RETURN(sub);
+}
+EXPORT_SYMBOL(ptlrpc_sub_req_init);
+
+/**
+ * Finish the reply of the sub-request \a sub as ptlrpc_send_reply() would
+ * do, and copy it into \a buf of \a buflen bytes in the batched RPC reply.
+ *
+ * \retval size of the sub-reply on success
+ * \retval -EOVERFLOW if \a buf is too small for it
+ */
+int ptlrpc_sub_req_reply_copy(struct ptlrpc_request *sub, void *buf,
+			      int buflen)
+{
+	LASSERT(sub->rq_repmsg != NULL);
+
+	if (sub->rq_replen > buflen)
+		return -EOVERFLOW;
+
+	sub->rq_type = PTL_RPC_MSG_REPLY;
+	lustre_msg_set_type(sub->rq_repmsg, sub->rq_type);
+	lustre_msg_set_status(sub->rq_repmsg,
+			      ptlrpc_status_hton(sub->rq_status));
+	lustre_msg_set_opc(sub->rq_repmsg, lustre_msg_get_opc(sub->rq_reqmsg));
+	memcpy(buf, sub->rq_repmsg, sub->rq_replen);
+
+	return sub->rq_replen;
+}
+EXPORT_SYMBOL(ptlrpc_sub_req_reply_copy);
+
+/**
+ * Release a sub-request set up by ptlrpc_sub_req_init(). Its reply is not
+ * sent on its own, so the locks saved by ptlrpc_save_lock() are released
+ * here instead of by the reply handling threads.
+ */
+void ptlrpc_sub_req_fini(struct ptlrpc_request *sub)
+{
+	struct ptlrpc_reply_state *rs = sub->rq_reply_state;
+
+	if (rs != NULL) {
+		while (rs->rs_nlocks > 0) {
+			rs->rs_nlocks--;
+			ldlm_lock_decref(&rs->rs_locks[rs->rs_nlocks],
+					 rs->rs_modes[rs->rs_nlocks]);
+		}
+		rs->rs_difficult = 0;
+		ptlrpc_req_drop_rs(sub);
+	}
+	sptlrpc_svc_ctx_decref(sub);
+	class_export_put(sub->rq_export);
+	ptlrpc_request_cache_free(sub);
+}
+EXPORT_SYMBOL(ptlrpc_sub_req_fini);
+
 
 struct ptlrpc_hr_partition;
 
+/**
+ * maximum number of ACK locks released in one batch by a reply handler
+ */
+#define HRT_MAX_LOCKS 256
+
 struct ptlrpc_hr_thread {
 	int				hrt_id;		/* thread ID */
 	spinlock_t			hrt_lock;
 	wait_queue_head_t		hrt_waitq;
 	struct list_head		hrt_queue;
+	/* exports with committed replies, see ptlrpc_commit_replies() */
+	struct list_head		hrt_commits;
 	struct ptlrpc_hr_partition	*hrt_partition;
+	/* ACK locks of the handled replies, released once per batch */
+	int				hrt_nlocks;
+	struct lustre_handle		hrt_locks[HRT_MAX_LOCKS];
+	enum ldlm_mode			hrt_modes[HRT_MAX_LOCKS];
 };
 
 struct ptlrpc_hr_partition {
@@ -290,6 +421,25 @@ ptlrpc_hr_select(struct ptlrpc_service_part *svcpt)
 	return &hrp->hrp_thrs[rotor % hrp->hrp_nthrs];
 }
 
+/**
+ * Choose the hr thread releasing the committed replies of \a exp.
+ *
+ * The choice only depends on the export, so that an export queued by
+ * ptlrpc_commit_replies() is always found on the same thread.
+ */
+static struct ptlrpc_hr_thread *ptlrpc_hr_select_exp(struct obd_export *exp)
+{
+	struct ptlrpc_hr_partition	*hrp;
+	unsigned int			hash;
+	int				ncpts;
+
+	hash = hash_ptr(exp, 32);
+	ncpts = cfs_cpt_number(ptlrpc_hr.hr_cpt_table);
+	hrp = ptlrpc_hr.hr_partitions[hash % ncpts];
+
+	return &hrp->hrp_thrs[(hash / ncpts) % hrp->hrp_nthrs];
+}
+
 /**
  * Dispatch all replies accumulated in the batch to one from
  * dedicated reply handling threads.
@@ -336,6 +486,7 @@ static void rs_batch_add(struct rs_batch *b, struct ptlrpc_reply_state *rs)
 	if (rs->rs_scheduled == 0) {
 		list_move(&rs->rs_list, &b->rsb_replies);
 		rs->rs_scheduled = 1;
+		rs->rs_queued = ktime_get();
 		b->rsb_n_replies++;
 	}
 	rs->rs_committed = 1;
@@ -372,6 +523,7 @@ void ptlrpc_dispatch_difficult_reply(struct ptlrpc_reply_state *rs)
 	LASSERT(list_empty(&rs->rs_list));
 
 	hrt = ptlrpc_hr_select(rs->rs_svcpt);
+	rs->rs_queued = ktime_get();
 
 	spin_lock(&hrt->hrt_lock);
 	list_add_tail(&rs->rs_list, &hrt->hrt_queue);
@@ -403,7 +555,7 @@ ptlrpc_schedule_difficult_reply(struct ptlrpc_reply_state *rs)
 }
 EXPORT_SYMBOL(ptlrpc_schedule_difficult_reply);
 
-void ptlrpc_commit_replies(struct obd_export *exp)
+static void ptlrpc_commit_replies_now(struct obd_export *exp)
 {
         struct ptlrpc_reply_state *rs, *nxt;
         DECLARE_RS_BATCH(batch);
@@ -430,6 +582,42 @@ void ptlrpc_commit_replies(struct obd_export *exp)
 	EXIT;
 }
 
+/**
+ * Release the replies of \a exp committed up to exp_last_committed.
+ *
+ * The commit callback of every transaction calls this, so that a disk
+ * commit of many transactions of one export would walk its uncommitted
+ * replies as many times. Instead the export is queued once to a reply
+ * handler thread, which walks the list once for all the transactions
+ * committed in the meantime.
+ */
+void ptlrpc_commit_replies(struct obd_export *exp)
+{
+	struct ptlrpc_hr_thread *hrt;
+	bool queued = false;
+	ENTRY;
+
+	if (unlikely(ptlrpc_hr.hr_stopping)) {
+		ptlrpc_commit_replies_now(exp);
+		RETURN_EXIT;
+	}
+
+	hrt = ptlrpc_hr_select_exp(exp);
+
+	spin_lock(&hrt->hrt_lock);
+	if (list_empty(&exp->exp_commit_list)) {
+		/* released once the hr thread is done with the export */
+		class_export_get(exp);
+		list_add_tail(&exp->exp_commit_list, &hrt->hrt_commits);
+		queued = true;
+	}
+	spin_unlock(&hrt->hrt_lock);
+
+	if (queued)
+		wake_up(&hrt->hrt_waitq);
+	EXIT;
+}
+
 static int
 ptlrpc_server_post_idle_rqbds(struct ptlrpc_service_part *svcpt)
 {
@@ -767,6 +955,7 @@ ptlrpc_register_service(struct ptlrpc_service_conf *conf,
 	spin_lock_init(&service->srv_lock);
 	service->srv_name		= conf->psc_name;
 	service->srv_watchdog_factor	= conf->psc_watchdog_factor;
+	service->srv_thread_idle_time	= PTLRPC_THR_IDLE_TIME;
 	INIT_LIST_HEAD(&service->srv_list); /* for safty of cleanup */
 
 	/* buffer configuration */
@@ -2107,6 +2296,9 @@ ptlrpc_server_handle_request(struct ptlrpc_service_part *svcpt,
 	work_start = ktime_get_real();
 	arrived = timespec64_to_ktime(request->rq_arrival_time);
 	timediff_usecs = ktime_us_delta(work_start, arrived);
+	/* moving average of the wait for a thread, racy but only a hint */
+	svcpt->scp_req_wait_usec = (svcpt->scp_req_wait_usec * 7 +
+				    timediff_usecs) >> 3;
 	if (likely(svc->srv_stats != NULL)) {
                 lprocfs_counter_add(svc->srv_stats, PTLRPC_REQWAIT_CNTR,
 				    timediff_usecs);
@@ -2126,6 +2318,22 @@ ptlrpc_server_handle_request(struct ptlrpc_service_part *svcpt,
 						   USEC_PER_SEC / 2));
         }
 
+	/* The NRS policy sheds requests which are not expected to meet their
+	 * deadline, ask the clients which support it to resend them later. */
+	if (unlikely(request->rq_nrq.nr_shed)) {
+		DEBUG_REQ(D_RPCTRACE, request,
+			  "Shedding request from %s: deadline in %llds",
+			  libcfs_id2str(request->rq_peer),
+			  request->rq_deadline - ktime_get_real_seconds());
+		if (request->rq_export != NULL &&
+		    exp_connect_flags(request->rq_export) &
+		    OBD_CONNECT_EINPROGRESS) {
+			request->rq_status = -EINPROGRESS;
+			ptlrpc_error(request);
+		}
+		goto put_conn;
+	}
+
         /* Discard requests queued for longer than the deadline.
            The deadline is increased if we send an early reply. */
 	if (ktime_get_real_seconds() > request->rq_deadline) {
@@ -2218,11 +2426,26 @@ put_conn:
 	RETURN(1);
 }
 
+/**
+ * Release the ACK locks collected by ptlrpc_handle_rs() on \a hrt.
+ */
+static void ptlrpc_hr_release_locks(struct ptlrpc_hr_thread *hrt)
+{
+	while (hrt->hrt_nlocks > 0) {
+		hrt->hrt_nlocks--;
+		ldlm_lock_decref(&hrt->hrt_locks[hrt->hrt_nlocks],
+				 hrt->hrt_modes[hrt->hrt_nlocks]);
+	}
+}
+
 /**
  * An internal function to process a single reply state object.
+ *
+ * The ACK locks of the reply are not released here but added to the
+ * batch of \a hrt, see ptlrpc_hr_release_locks().
  */
 static int
-ptlrpc_handle_rs(struct ptlrpc_reply_state *rs)
+ptlrpc_handle_rs(struct ptlrpc_hr_thread *hrt, struct ptlrpc_reply_state *rs)
 {
 	struct ptlrpc_service_part *svcpt = rs->rs_svcpt;
 	struct ptlrpc_service     *svc = svcpt->scp_service;
@@ -2237,6 +2460,10 @@ ptlrpc_handle_rs(struct ptlrpc_reply_state *rs)
 	LASSERT(rs->rs_scheduled);
 	LASSERT(list_empty(&rs->rs_list));
 
+	if (svc->srv_stats != NULL)
+		lprocfs_counter_add(svc->srv_stats, PTLRPC_RS_QUEUE_CNTR,
+				    ktime_us_delta(ktime_get(), rs->rs_queued));
+
 	/* The disk commit callback holds exp_uncommitted_replies_lock while it
 	 * iterates over newly committed replies, removing them from
 	 * exp_uncommitted_replies.  It then drops this lock and schedules the
@@ -2342,9 +2569,13 @@ ptlrpc_handle_rs(struct ptlrpc_reply_state *rs)
 			/* Ignore return code; we're racing with completion */
 		}
 
-		while (nlocks-- > 0)
-			ldlm_lock_decref(&rs->rs_locks[nlocks],
-					 rs->rs_modes[nlocks]);
+		while (nlocks-- > 0) {
+			if (hrt->hrt_nlocks == HRT_MAX_LOCKS)
+				ptlrpc_hr_release_locks(hrt);
+			hrt->hrt_locks[hrt->hrt_nlocks] = rs->rs_locks[nlocks];
+			hrt->hrt_modes[hrt->hrt_nlocks] = rs->rs_modes[nlocks];
+			hrt->hrt_nlocks++;
+		}
 
 		spin_lock(&rs->rs_lock);
 	}
@@ -2425,13 +2656,41 @@ ptlrpc_threads_increasable(struct ptlrpc_service_part *svcpt)
 }
 
 /**
- * too many requests and allowed to create more threads
+ * # requests waiting for a thread, lockless
+ */
+static inline unsigned long
+ptlrpc_server_nreqs_queued(struct ptlrpc_service_part *svcpt)
+{
+	return svcpt->scp_nreqs_incoming + svcpt->scp_nrs_reg.nrs_req_queued +
+	       (svcpt->scp_nrs_hp != NULL ?
+		svcpt->scp_nrs_hp->nrs_req_queued : 0);
+}
+
+/**
+ * too many requests and allowed to create more threads: all the threads
+ * are busy, and requests are either queued or have been waiting for a
+ * thread for long recently
  */
 static inline int
 ptlrpc_threads_need_create(struct ptlrpc_service_part *svcpt)
 {
 	return !ptlrpc_threads_enough(svcpt) &&
-		ptlrpc_threads_increasable(svcpt);
+		ptlrpc_threads_increasable(svcpt) &&
+		(ptlrpc_server_nreqs_queued(svcpt) > 0 ||
+		 svcpt->scp_req_wait_usec > PTLRPC_THR_WAIT_USEC);
+}
+
+/**
+ * more threads are running than the service starts with, so idle ones may
+ * be stopped
+ * user can call it w/o any lock but need to hold
+ * ptlrpc_service_part::scp_lock to get reliable result
+ */
+static inline int
+ptlrpc_threads_shrinkable(struct ptlrpc_service_part *svcpt)
+{
+	return svcpt->scp_service->srv_thread_idle_time > 0 &&
+	       svcpt->scp_nthrs_running > svcpt->scp_service->srv_nthrs_cpt_init;
 }
 
 static inline int
@@ -2516,6 +2775,37 @@ ptlrpc_server_request_incoming(struct ptlrpc_service_part *svcpt)
 	return !list_empty(&svcpt->scp_req_incoming);
 }
 
+/**
+ * Stop \a thread which has been idle for too long, unless the partition is
+ * left with its initial number of threads. The thread is removed from
+ * ptlrpc_service_part::scp_threads and frees itself when it exits.
+ *
+ * \retval 1 the thread must exit
+ * \retval 0 the thread must keep running
+ */
+static int ptlrpc_thread_retire(struct ptlrpc_service_part *svcpt,
+				struct ptlrpc_thread *thread)
+{
+	int retire = 0;
+
+	spin_lock(&svcpt->scp_lock);
+	if (!ptlrpc_thread_stopping(thread) &&
+	    ptlrpc_threads_shrinkable(svcpt)) {
+		list_del_init(&thread->t_link);
+		thread_clear_flags(thread, SVC_RUNNING);
+		svcpt->scp_nthrs_running--;
+		svcpt->scp_nthrs_stopping++;
+		retire = 1;
+	}
+	spin_unlock(&svcpt->scp_lock);
+
+	if (retire)
+		CDEBUG(D_RPCTRACE, "%s: stopping idle thread, %d left\n",
+		       thread->t_name, svcpt->scp_nthrs_running);
+
+	return retire;
+}
+
 static __attribute__((__noinline__)) int
 ptlrpc_wait_event(struct ptlrpc_service_part *svcpt,
 		  struct ptlrpc_thread *thread)
@@ -2523,12 +2813,22 @@ ptlrpc_wait_event(struct ptlrpc_service_part *svcpt,
 	/* Don't exit while there are replies to be handled */
 	struct l_wait_info lwi = LWI_TIMEOUT(svcpt->scp_rqbd_timeout,
 					     ptlrpc_retry_rqbds, svcpt);
+	int idle_time = svcpt->scp_service->srv_thread_idle_time;
+	bool idle_wait = false;
+	int rc;
+
+	/* threads beyond the initial ones stop after being idle for long */
+	if (lwi.lwi_timeout == 0 && idle_time > 0 &&
+	    ptlrpc_threads_shrinkable(svcpt)) {
+		lwi = LWI_TIMEOUT(cfs_time_seconds(idle_time), NULL, NULL);
+		idle_wait = true;
+	}
 
 	ptlrpc_watchdog_disable(&thread->t_watchdog);
 
 	cond_resched();
 
-	l_wait_event_exclusive_head(svcpt->scp_waitq,
+	rc = l_wait_event_exclusive_head(svcpt->scp_waitq,
 				ptlrpc_thread_stopping(thread) ||
 				ptlrpc_server_request_incoming(svcpt) ||
 				ptlrpc_server_request_pending(svcpt, false) ||
@@ -2538,6 +2838,10 @@ ptlrpc_wait_event(struct ptlrpc_service_part *svcpt,
 	if (ptlrpc_thread_stopping(thread))
 		return -EINTR;
 
+	if (rc == -ETIMEDOUT && idle_wait &&
+	    ptlrpc_thread_retire(svcpt, thread))
+		return -ETIMEDOUT;
+
 	ptlrpc_watchdog_touch(&thread->t_watchdog,
 			      ptlrpc_server_get_timeout(svcpt));
 	return 0;
@@ -2557,6 +2861,7 @@ static int ptlrpc_main(void *arg)
 	struct ptlrpc_reply_state	*rs;
 	struct group_info *ginfo = NULL;
 	struct lu_env *env;
+	bool retired = false;
 	int counter = 0, rc = 0;
 	ENTRY;
 
@@ -2633,6 +2938,7 @@ static int ptlrpc_main(void *arg)
 	 * we are now running, however we will exit as soon as possible */
 	thread_add_flags(thread, SVC_RUNNING);
 	svcpt->scp_nthrs_running++;
+	svcpt->scp_nthrs_started_total++;
 	spin_unlock(&svcpt->scp_lock);
 
 	/* wake up our creator in case he's still waiting. */
@@ -2652,8 +2958,12 @@ static int ptlrpc_main(void *arg)
 
 	/* XXX maintain a list of all managed devices: insert here */
 	while (!ptlrpc_thread_stopping(thread)) {
-		if (ptlrpc_wait_event(svcpt, thread))
+		rc = ptlrpc_wait_event(svcpt, thread);
+		if (rc != 0) {
+			retired = rc == -ETIMEDOUT;
+			rc = 0;
 			break;
+		}
 
 		ptlrpc_check_rqbd_pool(svcpt);
 
@@ -2698,6 +3008,21 @@ static int ptlrpc_main(void *arg)
 
 	ptlrpc_watchdog_disable(&thread->t_watchdog);
 
+	if (retired) {
+		/* free a reply state in place of the one this thread added */
+		rs = NULL;
+		spin_lock(&svcpt->scp_rep_lock);
+		if (!list_empty(&svcpt->scp_rep_idle)) {
+			rs = list_entry(svcpt->scp_rep_idle.next,
+					struct ptlrpc_reply_state, rs_list);
+			list_del(&rs->rs_list);
+		}
+		spin_unlock(&svcpt->scp_rep_lock);
+
+		if (rs != NULL)
+			OBD_FREE_LARGE(rs, svc->srv_max_reply_size);
+	}
+
 out_srv_fini:
         /*
          * deconstruct service specific state created by ptlrpc_start_thread()
@@ -2722,6 +3047,18 @@ out:
 		svcpt->scp_nthrs_running--;
 	}
 
+	if (retired) {
+		/* not on scp_threads anymore, nobody else knows this thread */
+		svcpt->scp_nthrs_stopping--;
+		svcpt->scp_nthrs_stopped_total++;
+		if (svc->srv_is_stopping)
+			wake_up_all(&svcpt->scp_waitq);
+		spin_unlock(&svcpt->scp_lock);
+
+		OBD_FREE_PTR(thread);
+		return rc;
+	}
+
 	thread->t_id = rc;
 	thread_add_flags(thread, SVC_STOPPED);
 
@@ -2739,12 +3076,37 @@ static int hrt_dont_sleep(struct ptlrpc_hr_thread *hrt,
 	spin_lock(&hrt->hrt_lock);
 
 	list_splice_init(&hrt->hrt_queue, replies);
-	result = ptlrpc_hr.hr_stopping || !list_empty(replies);
+	result = ptlrpc_hr.hr_stopping || !list_empty(replies) ||
+		 !list_empty(&hrt->hrt_commits);
 
 	spin_unlock(&hrt->hrt_lock);
 	return result;
 }
 
+/**
+ * Release the committed replies of the exports queued on \a hrt by
+ * ptlrpc_commit_replies().
+ */
+static void ptlrpc_hr_commit_exports(struct ptlrpc_hr_thread *hrt)
+{
+	struct obd_export *exp;
+
+	spin_lock(&hrt->hrt_lock);
+	while (!list_empty(&hrt->hrt_commits)) {
+		exp = list_entry(hrt->hrt_commits.next, struct obd_export,
+				 exp_commit_list);
+		/* requeued by any commit from now on */
+		list_del_init(&exp->exp_commit_list);
+		spin_unlock(&hrt->hrt_lock);
+
+		ptlrpc_commit_replies_now(exp);
+		class_export_put(exp);
+
+		spin_lock(&hrt->hrt_lock);
+	}
+	spin_unlock(&hrt->hrt_lock);
+}
+
 /**
  * Main body of "handle reply" function.
  * It processes acked reply states
@@ -2775,6 +3137,8 @@ static int ptlrpc_hr_main(void *arg)
 	while (!ptlrpc_hr.hr_stopping) {
 		l_wait_condition(hrt->hrt_waitq, hrt_dont_sleep(hrt, &replies));
 
+		ptlrpc_hr_commit_exports(hrt);
+
 		while (!list_empty(&replies)) {
 			struct ptlrpc_reply_state *rs;
 
@@ -2782,9 +3146,12 @@ static int ptlrpc_hr_main(void *arg)
 					struct ptlrpc_reply_state,
 					rs_list);
 			list_del_init(&rs->rs_list);
-			ptlrpc_handle_rs(rs);
+			ptlrpc_handle_rs(hrt, rs);
 		}
+		ptlrpc_hr_release_locks(hrt);
 	}
+	/* exports queued while stopping */
+	ptlrpc_hr_commit_exports(hrt);
 
 	atomic_inc(&hrp->hrp_nstopped);
 	wake_up(&ptlrpc_hr.hr_waitq);
@@ -2895,6 +3262,18 @@ static void ptlrpc_svcpt_stop_threads(struct ptlrpc_service_part *svcpt)
 		spin_lock(&svcpt->scp_lock);
 	}
 
+	/* wait for the idle threads which are exiting on their own */
+	while (svcpt->scp_nthrs_stopping > 0) {
+		spin_unlock(&svcpt->scp_lock);
+
+		CDEBUG(D_INFO, "waiting for %d idle threads of %s to stop\n",
+		       svcpt->scp_nthrs_stopping,
+		       svcpt->scp_service->srv_thread_name);
+		wait_event(svcpt->scp_waitq, svcpt->scp_nthrs_stopping == 0);
+
+		spin_lock(&svcpt->scp_lock);
+	}
+
 	spin_unlock(&svcpt->scp_lock);
 
 	while (!list_empty(&zombie)) {
@@ -3109,6 +3488,7 @@ int ptlrpc_hr_init(void)
 			init_waitqueue_head(&hrt->hrt_waitq);
 			spin_lock_init(&hrt->hrt_lock);
 			INIT_LIST_HEAD(&hrt->hrt_queue);
+			INIT_LIST_HEAD(&hrt->hrt_commits);
 		}
 	}
 
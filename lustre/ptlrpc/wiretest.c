@@ -102,7 +102,9 @@ void lustre_assert_wire_constants(void)
 		 (long long)OST_QUOTA_ADJUST_QUNIT);
 	LASSERTF(OST_LADVISE == 21, "found %lld\n",
 		 (long long)OST_LADVISE);
-	LASSERTF(OST_LAST_OPC == 22, "found %lld\n",
+	LASSERTF(OST_FALLOCATE == 22, "found %lld\n",
+		 (long long)OST_FALLOCATE);
+	LASSERTF(OST_LAST_OPC == 23, "found %lld\n",
 		 (long long)OST_LAST_OPC);
 	LASSERTF(OBD_OBJECT_EOF == 0xffffffffffffffffULL, "found 0x%.16llxULL\n",
 		 OBD_OBJECT_EOF);
@@ -174,7 +176,9 @@ void lustre_assert_wire_constants(void)
 		 (long long)MDS_HSM_CT_UNREGISTER);
 	LASSERTF(MDS_SWAP_LAYOUTS == 61, "found %lld\n",
 		 (long long)MDS_SWAP_LAYOUTS);
-	LASSERTF(MDS_LAST_OPC == 62, "found %lld\n",
+	LASSERTF(MDS_BATCH == 62, "found %lld\n",
+		 (long long)MDS_BATCH);
+	LASSERTF(MDS_LAST_OPC == 63, "found %lld\n",
 		 (long long)MDS_LAST_OPC);
 	LASSERTF(REINT_SETATTR == 1, "found %lld\n",
 		 (long long)REINT_SETATTR);
@@ -1134,10 +1138,10 @@ void lustre_assert_wire_constants(void)
 		 (long long)(int)offsetof(struct obd_connect_data, ocd_maxmodrpcs));
 	LASSERTF((int)sizeof(((struct obd_connect_data *)0)->ocd_maxmodrpcs) == 2, "found %lld\n",
 		 (long long)(int)sizeof(((struct obd_connect_data *)0)->ocd_maxmodrpcs));
-	LASSERTF((int)offsetof(struct obd_connect_data, padding0) == 74, "found %lld\n",
-		 (long long)(int)offsetof(struct obd_connect_data, padding0));
-	LASSERTF((int)sizeof(((struct obd_connect_data *)0)->padding0) == 2, "found %lld\n",
-		 (long long)(int)sizeof(((struct obd_connect_data *)0)->padding0));
+	LASSERTF((int)offsetof(struct obd_connect_data, ocd_compr_types) == 74, "found %lld\n",
+		 (long long)(int)offsetof(struct obd_connect_data, ocd_compr_types));
+	LASSERTF((int)sizeof(((struct obd_connect_data *)0)->ocd_compr_types) == 2, "found %lld\n",
+		 (long long)(int)sizeof(((struct obd_connect_data *)0)->ocd_compr_types));
 	LASSERTF((int)offsetof(struct obd_connect_data, padding1) == 76, "found %lld\n",
 		 (long long)(int)offsetof(struct obd_connect_data, padding1));
 	LASSERTF((int)sizeof(((struct obd_connect_data *)0)->padding1) == 4, "found %lld\n",
@@ -1338,6 +1342,20 @@ void lustre_assert_wire_constants(void)
 		 OBD_CONNECT2_ARCHIVE_ID_ARRAY);
 	LASSERTF(OBD_CONNECT2_SELINUX_POLICY == 0x400ULL, "found 0x%.16llxULL\n",
 		 OBD_CONNECT2_SELINUX_POLICY);
+	LASSERTF(OBD_CONNECT2_COMPRESS == 0x800ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_COMPRESS);
+	LASSERTF(OBD_CONNECT2_BATCH_RPC == 0x1000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_BATCH_RPC);
+	LASSERTF(OBD_CONNECT2_BATCH_BL_AST == 0x2000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_BATCH_BL_AST);
+	LASSERTF(OBD_CONNECT2_EXTENT_SHRINK == 0x4000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_EXTENT_SHRINK);
+	LASSERTF(OBD_CONNECT2_DIR_PLACEMENT == 0x8000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_DIR_PLACEMENT);
+	LASSERTF(OBD_CONNECT2_JUMP_HASH == 0x10000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_JUMP_HASH);
+	LASSERTF(OBD_CONNECT2_CHLG_FILTER == 0x20000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_CHLG_FILTER);
 	LASSERTF(OBD_CKSUM_CRC32 == 0x00000001UL, "found 0x%.8xUL\n",
 		(unsigned)OBD_CKSUM_CRC32);
 	LASSERTF(OBD_CKSUM_ADLER == 0x00000002UL, "found 0x%.8xUL\n",
@@ -1356,6 +1374,12 @@ void lustre_assert_wire_constants(void)
 		(unsigned)OBD_CKSUM_T10CRC4K);
 	LASSERTF(OBD_CKSUM_T10_TOP == 0x00000002UL, "found 0x%.8xUL\n",
 		(unsigned)OBD_CKSUM_T10_TOP);
+	LASSERTF(OBD_COMPR_LZ4 == 0x00000001UL, "found 0x%.8xUL\n",
+		(unsigned)OBD_COMPR_LZ4);
+	LASSERTF(OBD_COMPR_LZO == 0x00000002UL, "found 0x%.8xUL\n",
+		(unsigned)OBD_COMPR_LZO);
+	LASSERTF(OBD_COMPR_DEFLATE == 0x00000004UL, "found 0x%.8xUL\n",
+		(unsigned)OBD_COMPR_DEFLATE);
 
 	/* Checks for struct ost_layout */
 	LASSERTF((int)sizeof(struct ost_layout) == 28, "found %lld\n",
@@ -1492,13 +1516,17 @@ void lustre_assert_wire_constants(void)
 		 (long long)(int)offsetof(struct obdo, o_projid));
 	LASSERTF((int)sizeof(((struct obdo *)0)->o_projid) == 4, "found %lld\n",
 		 (long long)(int)sizeof(((struct obdo *)0)->o_projid));
-	LASSERTF((int)offsetof(struct obdo, o_padding_4) == 188, "found %lld\n",
-		 (long long)(int)offsetof(struct obdo, o_padding_4));
-	LASSERTF((int)sizeof(((struct obdo *)0)->o_padding_4) == 4, "found %lld\n",
-		 (long long)(int)sizeof(((struct obdo *)0)->o_padding_4));
-	LASSERTF((int)offsetof(struct obdo, o_padding_5) == 192, "found %lld\n",
+	LASSERTF((int)offsetof(struct obdo, o_falloc_mode) == 188, "found %lld\n",
+		 (long long)(int)offsetof(struct obdo, o_falloc_mode));
+	LASSERTF((int)sizeof(((struct obdo *)0)->o_falloc_mode) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct obdo *)0)->o_falloc_mode));
+	LASSERTF((int)offsetof(struct obdo, o_compr_size) == 192, "found %lld\n",
+		 (long long)(int)offsetof(struct obdo, o_compr_size));
+	LASSERTF((int)sizeof(((struct obdo *)0)->o_compr_size) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct obdo *)0)->o_compr_size));
+	LASSERTF((int)offsetof(struct obdo, o_padding_5) == 196, "found %lld\n",
 		 (long long)(int)offsetof(struct obdo, o_padding_5));
-	LASSERTF((int)sizeof(((struct obdo *)0)->o_padding_5) == 8, "found %lld\n",
+	LASSERTF((int)sizeof(((struct obdo *)0)->o_padding_5) == 4, "found %lld\n",
 		 (long long)(int)sizeof(((struct obdo *)0)->o_padding_5));
 	LASSERTF((int)offsetof(struct obdo, o_padding_6) == 200, "found %lld\n",
 		 (long long)(int)offsetof(struct obdo, o_padding_6));
@@ -1609,6 +1637,9 @@ void lustre_assert_wire_constants(void)
 	CLASSERT(OBD_FL_NOSPC_BLK == 0x00100000);
 	CLASSERT(OBD_FL_FLUSH == 0x00200000);
 	CLASSERT(OBD_FL_SHORT_IO == 0x00400000);
+	CLASSERT(OBD_FL_COMPR_LZ4 == 0x00800000);
+	CLASSERT(OBD_FL_COMPR_LZO == 0x01000000);
+	CLASSERT(OBD_FL_COMPR_DEFLATE == 0x01800000);
 
 	/* Checks for struct lov_ost_data_v1 */
 	LASSERTF((int)sizeof(struct lov_ost_data_v1) == 24, "found %lld\n",
@@ -2238,6 +2269,28 @@ void lustre_assert_wire_constants(void)
 	LASSERTF(OBD_BRW_SOFT_SYNC == 0x4000, "found 0x%.8x\n",
 		OBD_BRW_SOFT_SYNC);
 
+	/* Checks for struct brw_compr_chunk */
+	LASSERTF((int)sizeof(struct brw_compr_chunk) == 16, "found %lld\n",
+		 (long long)(int)sizeof(struct brw_compr_chunk));
+	LASSERTF((int)offsetof(struct brw_compr_chunk, bcc_magic) == 0, "found %lld\n",
+		 (long long)(int)offsetof(struct brw_compr_chunk, bcc_magic));
+	LASSERTF((int)sizeof(((struct brw_compr_chunk *)0)->bcc_magic) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct brw_compr_chunk *)0)->bcc_magic));
+	LASSERTF((int)offsetof(struct brw_compr_chunk, bcc_raw_len) == 4, "found %lld\n",
+		 (long long)(int)offsetof(struct brw_compr_chunk, bcc_raw_len));
+	LASSERTF((int)sizeof(((struct brw_compr_chunk *)0)->bcc_raw_len) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct brw_compr_chunk *)0)->bcc_raw_len));
+	LASSERTF((int)offsetof(struct brw_compr_chunk, bcc_len) == 8, "found %lld\n",
+		 (long long)(int)offsetof(struct brw_compr_chunk, bcc_len));
+	LASSERTF((int)sizeof(((struct brw_compr_chunk *)0)->bcc_len) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct brw_compr_chunk *)0)->bcc_len));
+	LASSERTF((int)offsetof(struct brw_compr_chunk, bcc_padding) == 12, "found %lld\n",
+		 (long long)(int)offsetof(struct brw_compr_chunk, bcc_padding));
+	LASSERTF((int)sizeof(((struct brw_compr_chunk *)0)->bcc_padding) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct brw_compr_chunk *)0)->bcc_padding));
+	LASSERTF(BRW_COMPR_MAGIC == 0x0BDC0001, "found 0x%.8x\n",
+		BRW_COMPR_MAGIC);
+
 	/* Checks for struct ost_body */
 	LASSERTF((int)sizeof(struct ost_body) == 208, "found %lld\n",
 		 (long long)(int)sizeof(struct ost_body));
@@ -4226,6 +4279,32 @@ void lustre_assert_wire_constants(void)
 	CLASSERT(LLOG_UPDATELOG_REPL_CTXT == 17);
 	CLASSERT(LLOG_MAX_CTXTS == 18);
 
+	/* Checks for struct llogd_chlg_filter */
+	LASSERTF((int)sizeof(struct llogd_chlg_filter) == 32, "found %lld\n",
+		 (long long)(int)sizeof(struct llogd_chlg_filter));
+	LASSERTF((int)offsetof(struct llogd_chlg_filter, lcf_type_mask) == 0, "found %lld\n",
+		 (long long)(int)offsetof(struct llogd_chlg_filter, lcf_type_mask));
+	LASSERTF((int)sizeof(((struct llogd_chlg_filter *)0)->lcf_type_mask) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct llogd_chlg_filter *)0)->lcf_type_mask));
+	LASSERTF((int)offsetof(struct llogd_chlg_filter, lcf_flags) == 4, "found %lld\n",
+		 (long long)(int)offsetof(struct llogd_chlg_filter, lcf_flags));
+	LASSERTF((int)sizeof(((struct llogd_chlg_filter *)0)->lcf_flags) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct llogd_chlg_filter *)0)->lcf_flags));
+	LASSERTF((int)offsetof(struct llogd_chlg_filter, lcf_uid) == 8, "found %lld\n",
+		 (long long)(int)offsetof(struct llogd_chlg_filter, lcf_uid));
+	LASSERTF((int)sizeof(((struct llogd_chlg_filter *)0)->lcf_uid) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct llogd_chlg_filter *)0)->lcf_uid));
+	LASSERTF((int)offsetof(struct llogd_chlg_filter, lcf_padding) == 12, "found %lld\n",
+		 (long long)(int)offsetof(struct llogd_chlg_filter, lcf_padding));
+	LASSERTF((int)sizeof(((struct llogd_chlg_filter *)0)->lcf_padding) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct llogd_chlg_filter *)0)->lcf_padding));
+	LASSERTF((int)offsetof(struct llogd_chlg_filter, lcf_fid) == 16, "found %lld\n",
+		 (long long)(int)offsetof(struct llogd_chlg_filter, lcf_fid));
+	LASSERTF((int)sizeof(((struct llogd_chlg_filter *)0)->lcf_fid) == 16, "found %lld\n",
+		 (long long)(int)sizeof(((struct llogd_chlg_filter *)0)->lcf_fid));
+	LASSERTF(LCF_UID == 0x00000001UL, "found 0x%.8xUL\n",
+		(unsigned)LCF_UID);
+
 	/* Checks for struct llogd_conn_body */
 	LASSERTF((int)sizeof(struct llogd_conn_body) == 40, "found %lld\n",
 		 (long long)(int)sizeof(struct llogd_conn_body));
@@ -5159,6 +5238,38 @@ void lustre_assert_wire_constants(void)
 	LASSERTF((int)sizeof(((struct out_update_buffer *)0)->oub_padding) == 4, "found %lld\n",
 		 (long long)(int)sizeof(((struct out_update_buffer *)0)->oub_padding));
 
+	/* Checks for struct batch_update_header */
+	LASSERTF((int)sizeof(struct batch_update_header) == 16, "found %lld\n",
+		 (long long)(int)sizeof(struct batch_update_header));
+	LASSERTF((int)offsetof(struct batch_update_header, buh_magic) == 0, "found %lld\n",
+		 (long long)(int)offsetof(struct batch_update_header, buh_magic));
+	LASSERTF((int)sizeof(((struct batch_update_header *)0)->buh_magic) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct batch_update_header *)0)->buh_magic));
+	LASSERTF((int)offsetof(struct batch_update_header, buh_count) == 4, "found %lld\n",
+		 (long long)(int)offsetof(struct batch_update_header, buh_count));
+	LASSERTF((int)sizeof(((struct batch_update_header *)0)->buh_count) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct batch_update_header *)0)->buh_count));
+	LASSERTF((int)offsetof(struct batch_update_header, buh_reply_size) == 8, "found %lld\n",
+		 (long long)(int)offsetof(struct batch_update_header, buh_reply_size));
+	LASSERTF((int)sizeof(((struct batch_update_header *)0)->buh_reply_size) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct batch_update_header *)0)->buh_reply_size));
+	LASSERTF((int)offsetof(struct batch_update_header, buh_padding) == 12, "found %lld\n",
+		 (long long)(int)offsetof(struct batch_update_header, buh_padding));
+	LASSERTF((int)sizeof(((struct batch_update_header *)0)->buh_padding) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct batch_update_header *)0)->buh_padding));
+
+	/* Checks for struct batch_update_buffer */
+	LASSERTF((int)sizeof(struct batch_update_buffer) == 8, "found %lld\n",
+		 (long long)(int)sizeof(struct batch_update_buffer));
+	LASSERTF((int)offsetof(struct batch_update_buffer, bub_size) == 0, "found %lld\n",
+		 (long long)(int)offsetof(struct batch_update_buffer, bub_size));
+	LASSERTF((int)sizeof(((struct batch_update_buffer *)0)->bub_size) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct batch_update_buffer *)0)->bub_size));
+	LASSERTF((int)offsetof(struct batch_update_buffer, bub_rc) == 4, "found %lld\n",
+		 (long long)(int)offsetof(struct batch_update_buffer, bub_rc));
+	LASSERTF((int)sizeof(((struct batch_update_buffer *)0)->bub_rc) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct batch_update_buffer *)0)->bub_rc));
+
 	/* Checks for struct nodemap_cluster_rec */
 	LASSERTF((int)sizeof(struct nodemap_cluster_rec) == 32, "found %lld\n",
 		 (long long)(int)sizeof(struct nodemap_cluster_rec));
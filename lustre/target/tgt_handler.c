@@ -42,6 +42,7 @@
 #include <obd.h>
 #include <obd_class.h>
 #include <obd_cksum.h>
+#include <obd_compr.h>
 #include <lustre_lfsck.h>
 #include <lustre_nodemap.h>
 #include <lustre_acl.h>
@@ -370,52 +371,19 @@ static int tgt_request_preprocess(struct tgt_session_info *tsi,
 }
 
 /*
- * Invoke handler for this request opc. Also do necessary preprocessing
- * (according to handler ->th_flags), and post-processing (setting of
- * ->last_{xid,committed}).
+ * Run the handler of the request after its preprocessing, packing the reply
+ * if its format is fixed. Errors of the operation itself are placed in
+ * ->rq_status, the returned errors are serious ones.
  */
-static int tgt_handle_request0(struct tgt_session_info *tsi,
+static int tgt_request_process(struct tgt_session_info *tsi,
 			       struct tgt_handler *h,
 			       struct ptlrpc_request *req)
 {
 	int	 serious = 0;
 	int	 rc;
-	__u32    opc = lustre_msg_get_opc(req->rq_reqmsg);
 
 	ENTRY;
 
-
-	/* When dealing with sec context requests, no export is associated yet,
-	 * because these requests are sent before *_CONNECT requests.
-	 * A NULL req->rq_export means the normal *_common_slice handlers will
-	 * not be called, because there is no reference to the target.
-	 * So deal with them by hand and jump directly to target_send_reply().
-	 */
-	switch (opc) {
-	case SEC_CTX_INIT:
-	case SEC_CTX_INIT_CONT:
-	case SEC_CTX_FINI:
-		CFS_FAIL_TIMEOUT(OBD_FAIL_SEC_CTX_HDL_PAUSE, cfs_fail_val);
-		GOTO(out, rc = 0);
-	}
-
-	/*
-	 * Checking for various OBD_FAIL_$PREF_$OPC_NET codes. _Do_ not try
-	 * to put same checks into handlers like mdt_close(), mdt_reint(),
-	 * etc., without talking to mdt authors first. Checking same thing
-	 * there again is useless and returning 0 error without packing reply
-	 * is buggy! Handlers either pack reply or return error.
-	 *
-	 * We return 0 here and do not send any reply in order to emulate
-	 * network failure. Do not send any reply in case any of NET related
-	 * fail_id has occured.
-	 */
-	if (OBD_FAIL_CHECK_ORSET(h->th_fail_id, OBD_FAIL_ONCE))
-		RETURN(0);
-	if (unlikely(lustre_msg_get_opc(req->rq_reqmsg) == MDS_REINT &&
-		     OBD_FAIL_CHECK(OBD_FAIL_MDS_REINT_MULTI_NET)))
-		RETURN(0);
-
 	rc = tgt_request_preprocess(tsi, h, req);
 	/* pack reply if reply format is fixed */
 	if (rc == 0 && h->th_flags & HABEO_REFERO) {
@@ -486,6 +454,57 @@ static int tgt_handle_request0(struct tgt_session_info *tsi,
 	if (likely(rc == 0 && req->rq_export))
 		target_committed_to_req(req);
 
+	RETURN(rc);
+}
+
+/*
+ * Invoke handler for this request opc. Also do necessary preprocessing
+ * (according to handler ->th_flags), and post-processing (setting of
+ * ->last_{xid,committed}).
+ */
+static int tgt_handle_request0(struct tgt_session_info *tsi,
+			       struct tgt_handler *h,
+			       struct ptlrpc_request *req)
+{
+	int	 rc;
+	__u32    opc = lustre_msg_get_opc(req->rq_reqmsg);
+
+	ENTRY;
+
+
+	/* When dealing with sec context requests, no export is associated yet,
+	 * because these requests are sent before *_CONNECT requests.
+	 * A NULL req->rq_export means the normal *_common_slice handlers will
+	 * not be called, because there is no reference to the target.
+	 * So deal with them by hand and jump directly to target_send_reply().
+	 */
+	switch (opc) {
+	case SEC_CTX_INIT:
+	case SEC_CTX_INIT_CONT:
+	case SEC_CTX_FINI:
+		CFS_FAIL_TIMEOUT(OBD_FAIL_SEC_CTX_HDL_PAUSE, cfs_fail_val);
+		GOTO(out, rc = 0);
+	}
+
+	/*
+	 * Checking for various OBD_FAIL_$PREF_$OPC_NET codes. _Do_ not try
+	 * to put same checks into handlers like mdt_close(), mdt_reint(),
+	 * etc., without talking to mdt authors first. Checking same thing
+	 * there again is useless and returning 0 error without packing reply
+	 * is buggy! Handlers either pack reply or return error.
+	 *
+	 * We return 0 here and do not send any reply in order to emulate
+	 * network failure. Do not send any reply in case any of NET related
+	 * fail_id has occured.
+	 */
+	if (OBD_FAIL_CHECK_ORSET(h->th_fail_id, OBD_FAIL_ONCE))
+		RETURN(0);
+	if (unlikely(lustre_msg_get_opc(req->rq_reqmsg) == MDS_REINT &&
+		     OBD_FAIL_CHECK(OBD_FAIL_MDS_REINT_MULTI_NET)))
+		RETURN(0);
+
+	rc = tgt_request_process(tsi, h, req);
+
 out:
 	target_send_reply(req, rc, tsi->tsi_reply_fail_id);
 	RETURN(0);
@@ -512,6 +531,7 @@ static int tgt_filter_recovery_request(struct ptlrpc_request *req,
 	case OST_CREATE:
 	case OST_DESTROY:
 	case OST_PUNCH:
+	case OST_FALLOCATE:
 	case OST_SETATTR:
 	case OST_SYNC:
 	case OST_WRITE:
@@ -831,6 +851,61 @@ out:
 }
 EXPORT_SYMBOL(tgt_request_handle);
 
+/**
+ * Handle the sub-request \a sub of a batched RPC, in the session of the
+ * batched RPC whose tgt_session_info \a tsi is saved and restored around
+ * it. The reply of the sub-request is left in sub->rq_reply_state, it is up
+ * to the caller to copy it into the reply of the batched RPC.
+ *
+ * \retval 0 if a reply was packed, with the sub-request status in
+ *	   sub->rq_status
+ * \retval negative errno if no reply could be packed
+ */
+int tgt_sub_request_handle(struct tgt_session_info *tsi,
+			   struct ptlrpc_request *sub)
+{
+	struct tgt_session_info	 saved = *tsi;
+	struct tgt_handler	*h;
+	int			 rc;
+
+	ENTRY;
+
+	memset(tsi, 0, sizeof(*tsi));
+	req_capsule_init(&sub->rq_pill, sub, RCL_SERVER);
+	tsi->tsi_pill = &sub->rq_pill;
+	tsi->tsi_env = saved.tsi_env;
+	tsi->tsi_tgt = saved.tsi_tgt;
+	tsi->tsi_exp = sub->rq_export;
+	tsi->tsi_jobid = saved.tsi_jobid;
+	tsi->tsi_reply_fail_id = saved.tsi_reply_fail_id;
+
+	h = tgt_handler_find_check(sub);
+	if (IS_ERR(h))
+		GOTO(out, rc = PTR_ERR(h));
+
+	rc = lustre_msg_check_version(sub->rq_reqmsg, h->th_version);
+	if (unlikely(rc)) {
+		DEBUG_REQ(D_ERROR, sub, "%s: drop mal-formed sub-request, "
+			  "version %08x, expecting %08x\n",
+			  tgt_name(tsi->tsi_tgt),
+			  lustre_msg_get_version(sub->rq_reqmsg),
+			  h->th_version);
+		GOTO(out, rc = -EINVAL);
+	}
+
+	rc = tgt_request_process(tsi, h, sub);
+	if (rc == 0 && sub->rq_reply_state == NULL)
+		rc = -EPROTO;
+	EXIT;
+out:
+	req_capsule_fini(tsi->tsi_pill);
+	if (tsi->tsi_corpus != NULL)
+		lu_object_put(tsi->tsi_env, tsi->tsi_corpus);
+	*tsi = saved;
+	return rc;
+}
+EXPORT_SYMBOL(tgt_sub_request_handle);
+
 /** Assign high priority operations to the request if needed. */
 int tgt_hpreq_handler(struct ptlrpc_request *req)
 {
@@ -2130,6 +2205,116 @@ static int tgt_checksum_niobuf_rw(struct lu_target *tgt,
 	RETURN(rc);
 }
 
+static struct page *tgt_niobuf_page_from(void *array, int idx,
+					 unsigned int *offset,
+					 unsigned int *len)
+{
+	struct niobuf_local *lnb = (struct niobuf_local *)array + idx;
+
+	*offset = lnb->lnb_page_offset & ~PAGE_MASK;
+	*len = lnb->lnb_len;
+
+	return lnb->lnb_page;
+}
+
+/* Get \a count pages of the bulk pool for a compressed stream */
+static struct page **tgt_compr_pages_get(int count)
+{
+	struct page **pages;
+	int rc;
+
+	OBD_ALLOC_LARGE(pages, count * sizeof(*pages));
+	if (pages == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	rc = sptlrpc_enc_pool_get_pages_array(pages, count);
+	if (rc != 0) {
+		OBD_FREE_LARGE(pages, count * sizeof(*pages));
+		return ERR_PTR(rc);
+	}
+
+	return pages;
+}
+
+static void tgt_compr_pages_put(struct page **pages, int count)
+{
+	sptlrpc_enc_pool_put_pages_array(pages, count);
+	OBD_FREE_LARGE(pages, count * sizeof(*pages));
+}
+
+/* Add the \a len bytes of a stream in \a pages to \a desc */
+static void tgt_compr_pages_add(struct ptlrpc_bulk_desc *desc,
+				struct page **pages, int len)
+{
+	int i;
+
+	for (i = 0; len > 0; i++, len -= PAGE_SIZE)
+		desc->bd_frag_ops->add_kiov_frag(desc, pages[i], 0,
+						 min_t(int, len, PAGE_SIZE));
+}
+
+/*
+ * Compress the \a nob bytes read into \a local_nb into the \a stream_pages
+ * pool pages of \a pages to be sent to the client. The data is copied there
+ * as it is if it does not shrink, the client expects it in these pages.
+ */
+static int tgt_brw_read_compress(struct ptlrpc_bulk_desc *desc,
+				 enum obd_compr_types compr_type,
+				 struct niobuf_local *local_nb, int npages,
+				 int nob, struct page **pages,
+				 int stream_pages, struct obdo *repoa)
+{
+	int len;
+
+	len = obd_compress_pages(compr_type, local_nb, npages,
+				 tgt_niobuf_page_from, pages, stream_pages);
+	if (len >= 0) {
+		if (!(repoa->o_valid & OBD_MD_FLFLAGS)) {
+			repoa->o_valid |= OBD_MD_FLFLAGS;
+			repoa->o_flags = 0;
+		}
+		repoa->o_flags |= obd_compr_type_pack(compr_type);
+		repoa->o_compr_size = len;
+	} else if (len == -EOVERFLOW) {
+		len = obd_compr_copy_pages(pages, nob, local_nb, npages,
+					   tgt_niobuf_page_from, true);
+	} else {
+		return len;
+	}
+	tgt_compr_pages_add(desc, pages, len);
+
+	return 0;
+}
+
+/*
+ * Decompress the \a stream_len bytes of a write received into \a pages
+ * into \a local_nb. A stream that does not decompress to the data of the
+ * RPC has been damaged on the way, ask the client to send it again.
+ */
+static int tgt_brw_write_decompress(struct obd_export *exp,
+				    enum obd_compr_types compr_type,
+				    struct page **pages, int stream_len,
+				    struct niobuf_local *local_nb, int npages)
+{
+	int nob = 0;
+	int rc;
+	int i;
+
+	for (i = 0; i < npages; i++)
+		nob += local_nb[i].lnb_len;
+
+	rc = obd_decompress_pages(compr_type, pages, stream_len, local_nb,
+				  npages, tgt_niobuf_page_from);
+	if (rc != nob) {
+		CERROR("%s: bad compressed write from %s, %d of %d bytes: rc = %d\n",
+		       exp->exp_obd->obd_name, obd_export_nid2str(exp),
+		       rc < 0 ? 0 : rc, nob, rc < 0 ? rc : -EPROTO);
+		return -EAGAIN;
+	}
+
+	return 0;
+}
+
 int tgt_brw_read(struct tgt_session_info *tsi)
 {
 	struct ptlrpc_request	*req = tgt_ses_req(tsi);
@@ -2145,6 +2330,8 @@ int tgt_brw_read(struct tgt_session_info *tsi)
 				 npages_read;
 	struct tgt_thread_big_cache *tbc = req->rq_svc_thread->t_data;
 	const char *obd_name = exp->exp_obd->obd_name;
+	enum obd_compr_types	 compr_type = 0;
+	struct page		**compr_pages = NULL;
 
 	ENTRY;
 
@@ -2230,6 +2417,11 @@ int tgt_brw_read(struct tgt_session_info *tsi)
 					    &ptlrpc_bulk_kiov_nopin_ops);
 		if (desc == NULL)
 			GOTO(out_commitrw, rc = -ENOMEM);
+
+		if (body->oa.o_valid & OBD_MD_FLFLAGS &&
+		    exp_connect_compress(exp))
+			compr_type = obd_compr_type_unpack(body->oa.o_flags) &
+				     obd_compr_types_supported();
 	}
 
 	nob = 0;
@@ -2244,7 +2436,8 @@ int tgt_brw_read(struct tgt_session_info *tsi)
 		}
 
 		nob += page_rc;
-		if (page_rc != 0 && desc != NULL) { /* some data! */
+		if (page_rc != 0 && desc != NULL &&
+		    compr_type == 0) { /* some data! */
 			LASSERT(local_nb[i].lnb_page != NULL);
 			desc->bd_frag_ops->add_kiov_frag
 			  (desc, local_nb[i].lnb_page,
@@ -2296,6 +2489,21 @@ int tgt_brw_read(struct tgt_session_info *tsi)
 	}
 	/* We're finishing using body->oa as an input variable */
 
+	if (compr_type != 0 && rc == 0 && nob > 0) {
+		compr_pages = tgt_compr_pages_get(npages);
+		if (IS_ERR(compr_pages)) {
+			rc = PTR_ERR(compr_pages);
+			compr_pages = NULL;
+			GOTO(out_commitrw, rc);
+		}
+
+		rc = tgt_brw_read_compress(desc, compr_type, local_nb,
+					   npages_read, nob, compr_pages,
+					   npages, &repbody->oa);
+		if (rc < 0)
+			GOTO(out_commitrw, rc);
+	}
+
 	/* Check if client was evicted while we were doing i/o before touching
 	 * network */
 	if (rc == 0) {
@@ -2366,6 +2574,9 @@ out_lock:
 		ptlrpc_free_bulk(desc);
 	}
 
+	if (compr_pages != NULL)
+		tgt_compr_pages_put(compr_pages, npages);
+
 	RETURN(rc);
 }
 EXPORT_SYMBOL(tgt_brw_read);
@@ -2462,6 +2673,9 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 	struct tgt_thread_big_cache *tbc = req->rq_svc_thread->t_data;
 	bool wait_sync = false;
 	const char *obd_name = exp->exp_obd->obd_name;
+	enum obd_compr_types compr_type = 0;
+	struct page **compr_pages = NULL;
+	int compr_count = 0;
 
 	ENTRY;
 
@@ -2563,6 +2777,18 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 		GOTO(out_lock, rc = -ENOMEM);
 	repbody->oa = body->oa;
 
+	if (body->oa.o_valid & OBD_MD_FLFLAGS)
+		compr_type = obd_compr_type_unpack(body->oa.o_flags);
+	if (compr_type != 0) {
+		if (!exp_connect_compress(exp) ||
+		    body->oa.o_flags & OBD_FL_SHORT_IO ||
+		    body->oa.o_compr_size == 0 ||
+		    body->oa.o_compr_size > PTLRPC_MAX_BRW_SIZE)
+			GOTO(out_lock, rc = -EPROTO);
+		repbody->oa.o_flags &= ~OBD_FL_COMPR_ALL;
+		compr_count = DIV_ROUND_UP(body->oa.o_compr_size, PAGE_SIZE);
+	}
+
 	npages = PTLRPC_MAX_BRW_PAGES;
 	rc = obd_preprw(tsi->tsi_env, OBD_BRW_WRITE, exp, &repbody->oa,
 			objcount, ioo, remote_nb, &npages, local_nb);
@@ -2594,11 +2820,22 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 			GOTO(skip_transfer, rc = -ENOMEM);
 
 		/* NB Having prepped, we must commit... */
-		for (i = 0; i < npages; i++)
-			desc->bd_frag_ops->add_kiov_frag(desc,
+		if (compr_type != 0) {
+			compr_pages = tgt_compr_pages_get(compr_count);
+			if (IS_ERR(compr_pages)) {
+				rc = PTR_ERR(compr_pages);
+				compr_pages = NULL;
+				GOTO(skip_transfer, rc);
+			}
+			tgt_compr_pages_add(desc, compr_pages,
+					    body->oa.o_compr_size);
+		} else {
+			for (i = 0; i < npages; i++)
+				desc->bd_frag_ops->add_kiov_frag(desc,
 					local_nb[i].lnb_page,
 					local_nb[i].lnb_page_offset & ~PAGE_MASK,
 					local_nb[i].lnb_len);
+		}
 
 		rc = sptlrpc_svc_prep_bulk(req, desc);
 		if (rc != 0)
@@ -2609,6 +2846,11 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 
 	no_reply = rc != 0;
 
+	if (rc == 0 && compr_pages != NULL)
+		rc = tgt_brw_write_decompress(exp, compr_type, compr_pages,
+					      body->oa.o_compr_size,
+					      local_nb, npages);
+
 skip_transfer:
 	if (body->oa.o_valid & OBD_MD_FLCKSUM && rc == 0) {
 		static int cksum_counter;
@@ -2693,6 +2935,8 @@ out_lock:
 	tgt_brw_unlock(ioo, remote_nb, &lockh, LCK_PW);
 	if (desc)
 		ptlrpc_free_bulk(desc);
+	if (compr_pages != NULL)
+		tgt_compr_pages_put(compr_pages, compr_count);
 out:
 	if (unlikely(no_reply || (exp->exp_obd->obd_no_transno && wait_sync))) {
 		req->rq_no_reply = 1;
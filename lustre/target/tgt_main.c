@@ -182,6 +182,7 @@ int tgt_init(const struct lu_env *env, struct lu_target *lut,
 
 	spin_lock_init(&lut->lut_flags_lock);
 	lut->lut_sync_lock_cancel = NEVER_SYNC_ON_CANCEL;
+	lut->lut_dist_txn_async = 1;
 
 	spin_lock_init(&lut->lut_slc_locks_guard);
 	INIT_LIST_HEAD(&lut->lut_slc_locks);
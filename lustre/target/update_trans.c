@@ -72,12 +72,13 @@ static void top_multiple_thandle_dump(struct top_multiple_thandle *tmt,
 	struct sub_thandle	*st;
 
 	LASSERT(tmt->tmt_magic == TOP_THANDLE_MAGIC);
-	CDEBUG(mask, "%s tmt %p refcount %d committed %d result %d batchid %llu\n",
+	CDEBUG(mask, "%s tmt %p refcount %d committed %d async %d result %d "
+	       "batchid %llu\n",
 	       tmt->tmt_master_sub_dt ?
 	       tmt->tmt_master_sub_dt->dd_lu_dev.ld_obd->obd_name :
 	       "NULL",
 	       tmt, atomic_read(&tmt->tmt_refcount), tmt->tmt_committed,
-	       tmt->tmt_result, tmt->tmt_batchid);
+	       tmt->tmt_async_commit, tmt->tmt_result, tmt->tmt_batchid);
 
 	list_for_each_entry(st, &tmt->tmt_sub_thandle_list, st_sub_list) {
 		struct sub_thandle_cookie *stc;
@@ -770,6 +771,60 @@ static int prepare_multiple_node_trans(const struct lu_env *env,
 	RETURN(rc);
 }
 
+/**
+ * Check whether the distribute transaction can be committed asynchronously.
+ *
+ * All updates of the distribute transaction are written in the update log on
+ * master MDT together with the master sub transaction. If a sub transaction
+ * on other MDT is lost because it's not committed when that MDT fails, update
+ * recovery replays it from the update log of master MDT, and the commit order
+ * is tracked by batchid in distribute_txn_commit_thread(). So even if top
+ * transaction is synchronous, only master sub transaction needs to be
+ * committed synchronously, if it writes update log.
+ *
+ * \param[in] tmt	distribute transaction
+ *
+ * \retval		true if other sub transactions can commit asynchronously
+ * \retval		false if all sub transactions follow th_sync
+ */
+static bool top_trans_can_commit_async(struct top_multiple_thandle *tmt)
+{
+	struct thandle_update_records *tur = tmt->tmt_update_records;
+	struct lu_target *lut;
+	struct sub_thandle *master_st;
+
+	lut = dt2lu_dev(tmt->tmt_master_sub_dt)->ld_site->ls_tgt;
+	if (!lut->lut_dist_txn_async)
+		return false;
+
+	master_st = lookup_sub_thandle(tmt, tmt->tmt_master_sub_dt);
+	if (master_st == NULL || master_st->st_sub_th == NULL)
+		return false;
+
+	/* see top_check_write_updates() */
+	return tur != NULL && tur->tur_update_records != NULL &&
+	       tur->tur_update_records->lur_update_rec.ur_update_count > 1;
+}
+
+/**
+ * Set th_sync of sub transaction from top transaction.
+ *
+ * \param[in] tmt	distribute transaction
+ * \param[in] st	sub thandle
+ * \param[in] th	top thandle
+ */
+static void sub_thandle_set_sync(struct top_multiple_thandle *tmt,
+				 struct sub_thandle *st, struct thandle *th)
+{
+	if (!th->th_sync)
+		return;
+
+	if (tmt->tmt_async_commit && st->st_dt != tmt->tmt_master_sub_dt)
+		return;
+
+	st->st_sub_th->th_sync = th->th_sync;
+}
+
 /**
  * start the top transaction.
  *
@@ -807,11 +862,11 @@ int top_trans_start(const struct lu_env *env, struct dt_device *master_dev,
 	if (rc < 0)
 		RETURN(rc);
 
+	tmt->tmt_async_commit = top_trans_can_commit_async(tmt);
 	list_for_each_entry(st, &tmt->tmt_sub_thandle_list, st_sub_list) {
 		if (st->st_sub_th == NULL)
 			continue;
-		if (th->th_sync)
-			st->st_sub_th->th_sync = th->th_sync;
+		sub_thandle_set_sync(tmt, st, th);
 		if (th->th_local)
 			st->st_sub_th->th_local = th->th_local;
 		rc = dt_trans_start(env, st->st_sub_th->th_dev,
@@ -1008,8 +1063,7 @@ stop_master_trans:
 	if (master_st != NULL && master_st->st_sub_th != NULL) {
 		if (th->th_local)
 			master_st->st_sub_th->th_local = th->th_local;
-		if (th->th_sync)
-			master_st->st_sub_th->th_sync = th->th_sync;
+		sub_thandle_set_sync(tmt, master_st, th);
 		master_st->st_sub_th->th_result = th->th_result;
 		rc = dt_trans_stop(env, master_st->st_dt, master_st->st_sub_th);
 		/* If it does not write_updates, then we call submit callback
@@ -1074,8 +1128,10 @@ stop_other_trans:
 		if (st == master_st || st->st_sub_th == NULL)
 			continue;
 
-		if (th->th_sync)
-			st->st_sub_th->th_sync = th->th_sync;
+		/* update log on master is not written, commit it as is */
+		if (!write_updates)
+			tmt->tmt_async_commit = 0;
+		sub_thandle_set_sync(tmt, st, th);
 		if (th->th_local)
 			st->st_sub_th->th_local = th->th_local;
 		st->st_sub_th->th_result = th->th_result;
@@ -4910,6 +4910,65 @@ test_133() {
 }
 run_test 133 "check resend of ongoing requests for lwp during failover"
 
+# number of synchronous transactions committed by the OSD of target $2
+sync_trans_count() {
+	do_facet $1 $LCTL get_param -n osd-*.$2.stats |
+		awk '/^sync_trans / { n = $2 } END { print n + 0 }'
+}
+
+test_134() {
+	[ $MDSCOUNT -lt 2 ] && skip "needs >= 2 MDTs" && return 0
+	([ $FAILURE_MODE == "HARD" ] &&
+		[ "$(facet_host mds1)" == "$(facet_host mds2)" ]) &&
+		skip "MDTs needs to be on diff hosts for HARD fail mode" &&
+		return 0
+	[ $(do_facet mds1 $LCTL get_param -n \
+		mdt.$FSNAME-MDT0000.dist_txn_async_commit) == 1 ] ||
+		skip "distribute txn async commit is not enabled"
+
+	local striped_dir=$DIR/$tdir/striped_dir
+	local mdt1=$(facet_svc mds2)
+	local before
+	local after
+
+	mkdir -p $DIR/$tdir || error "mkdir $DIR/$tdir failed"
+	$LFS mkdir -i 0 -c 2 $striped_dir || error "create $striped_dir failed"
+	sync
+
+	# the stripe on MDT1 doesn't commit the synchronous chown itself
+	before=$(sync_trans_count mds2 $mdt1)
+	chown $RUNAS_ID $striped_dir || error "chown $RUNAS_ID failed"
+	after=$(sync_trans_count mds2 $mdt1)
+	(( after == before )) ||
+		error "$mdt1 committed $((after - before)) sync transactions"
+
+	# unless async commit is disabled
+	do_facet mds1 $LCTL set_param \
+		mdt.$FSNAME-MDT0000.dist_txn_async_commit=0
+	stack_trap "do_facet mds1 $LCTL set_param \
+		mdt.$FSNAME-MDT0000.dist_txn_async_commit=1" EXIT
+	chown 0 $striped_dir || error "chown 0 failed"
+	before=$after
+	after=$(sync_trans_count mds2 $mdt1)
+	(( after > before )) || error "$mdt1 committed no sync transaction"
+	do_facet mds1 $LCTL set_param \
+		mdt.$FSNAME-MDT0000.dist_txn_async_commit=1
+
+	# chown is synchronous, but only the master MDT0 commits it, the stripe
+	# on MDT1 is recovered from the update log on MDT0
+	replay_barrier mds2
+	chown $RUNAS_ID:$RUNAS_GID $striped_dir || error "chown failed"
+	fail mds2
+
+	$CHECKSTAT -u \#$RUNAS_ID -g \#$RUNAS_GID $striped_dir ||
+		error "chown is not recovered"
+	createmany -o $striped_dir/f 20 || error "create in $striped_dir failed"
+	rm -rf $DIR/$tdir || error "rmdir failed"
+
+	return 0
+}
+run_test 134 "DNE: sync op commits asynchronously on remote MDT"
+
 complete $SECONDS
 check_and_cleanup_lustre
 exit_status
@@ -5683,6 +5683,56 @@ test_606() {
 }
 run_test 606 "llog_reader groks changelog fields"
 
+test_700() {
+	local f=$DIR/$tdir/$tfile
+	local dataset=$(hsm_root)
+	local pcc_file
+
+	copytool setup
+
+	do_facet $SINGLEAGT $LCTL set_param \
+		llite.*.pcc="add ${dataset%/} $HSM_ARCHIVE_NUMBER" ||
+		error "cannot add PCC dataset $dataset"
+	stack_trap "do_facet $SINGLEAGT $LCTL set_param llite.*.pcc=clear" EXIT
+
+	local fid=$(create_small_file $f)
+
+	do_facet $SINGLEAGT $LFS pcc attach -i $HSM_ARCHIVE_NUMBER $f &&
+		error "attach of a file not yet archived should fail"
+
+	$LFS hsm_archive --archive $HSM_ARCHIVE_NUMBER $f ||
+		error "could not archive file"
+	wait_request_state $fid ARCHIVE SUCCEED
+
+	do_facet $SINGLEAGT $LFS pcc attach -i $HSM_ARCHIVE_NUMBER $f ||
+		error "cannot attach $f to PCC"
+	check_hsm_flags $f "0x0000000d"
+
+	do_facet $SINGLEAGT $LFS pcc state $f
+	pcc_file=$(do_facet $SINGLEAGT $LFS pcc state $f |
+		   awk -F'PCC file: ' '/type: readwrite/ { print $2 }')
+	[ -n "$pcc_file" ] || error "$f is not attached to PCC"
+
+	# I/O on the attached file goes to the cached copy, not to Lustre
+	do_facet $SINGLEAGT "echo -n pcc_data > $f" ||
+		error "cannot write to $f"
+	[ "$(do_facet $SINGLEAGT cat $pcc_file)" == "pcc_data" ] ||
+		error "write to $f did not go to $pcc_file"
+	[ "$(do_facet $SINGLEAGT cat $f)" == "pcc_data" ] ||
+		error "read from $f did not go to $pcc_file"
+	[ $(do_facet $SINGLEAGT stat -c %s $f) -eq 8 ] ||
+		error "size of $f is not the one of $pcc_file"
+	check_hsm_flags $f "0x0000000d"
+
+	# Detach restores the data written to the cache back into Lustre
+	do_facet $SINGLEAGT $LFS pcc detach $f || error "cannot detach $f"
+	wait_request_state $fid RESTORE SUCCEED
+	do_facet $SINGLEAGT $LFS pcc state $f | grep -q "type: none" ||
+		error "$f is still attached to PCC"
+	[ "$(cat $f)" == "pcc_data" ] || error "data of $f not restored"
+}
+run_test 700 "Attach, use and detach a file with PCC"
+
 complete $SECONDS
 check_and_cleanup_lustre
 exit_status
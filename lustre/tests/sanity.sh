@@ -7961,6 +7961,83 @@ test_101g() {
 }
 run_test 101g "Big bulk(4/16 MiB) readahead"
 
+test_101h() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run"
+
+	local threshold=$($LCTL get_param -n \
+		llite.*.read_ahead_async_file_threshold_mb | head -n 1)
+	local async
+	local sync
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=128 ||
+		error "dd write failed"
+	cancel_lru_locks osc
+
+	stack_trap "$LCTL set_param -n \
+		llite.*.read_ahead_async_file_threshold_mb=$threshold" EXIT
+	$LCTL set_param -n llite.*.read_ahead_async_file_threshold_mb=1
+	$LCTL set_param -n llite.*.read_ahead_stats 0
+
+	dd if=$DIR/$tfile of=/dev/null bs=1M || error "dd read failed"
+
+	$LCTL get_param llite.*.read_ahead_stats
+	async=$($LCTL get_param -n llite.*.read_ahead_stats |
+		get_named_value 'async readahead' | cut -d" " -f1 | calc_total)
+	sync=$($LCTL get_param -n llite.*.read_ahead_stats |
+		get_named_value 'sync readahead' | cut -d" " -f1 | calc_total)
+	(( async > 0 )) || error "no async readahead ($async/$sync)"
+
+	# disabling async readahead falls back to the reader doing it
+	cancel_lru_locks osc
+	$LCTL set_param -n llite.*.read_ahead_async_file_threshold_mb=0
+	$LCTL set_param -n llite.*.read_ahead_stats 0
+	dd if=$DIR/$tfile of=/dev/null bs=1M || error "dd reread failed"
+	async=$($LCTL get_param -n llite.*.read_ahead_stats |
+		get_named_value 'async readahead' | cut -d" " -f1 | calc_total)
+	(( async == 0 )) || error "async readahead when disabled ($async)"
+
+	rm -f $DIR/$tfile
+}
+run_test 101h "async readahead fills the window in the background"
+
+test_101i() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run"
+
+	local bsize=$((1024 * 1024))
+	local half=$((32 * bsize))
+	local cmd="o"
+	local hits0
+	local hits1
+	local i
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=64 ||
+		error "dd write failed"
+	cancel_lru_locks osc
+
+	# two sequential record streams interleaved through one fd
+	for ((i = 0; i < 32; i++)); do
+		cmd+="z$((i * bsize))r$bsize"
+		cmd+="z$((half + i * bsize))r$bsize"
+	done
+	cmd+="c"
+
+	$LCTL set_param -n llite.*.read_ahead_stats 0
+	$MULTIOP $DIR/$tfile $cmd || error "multiop $cmd failed"
+
+	$LCTL get_param llite.*.read_ahead_stats
+	hits0=$($LCTL get_param -n llite.*.read_ahead_stats |
+		get_named_value 'stream0 hits' | cut -d" " -f1 | calc_total)
+	hits1=$($LCTL get_param -n llite.*.read_ahead_stats |
+		get_named_value 'stream1 hits' | cut -d" " -f1 | calc_total)
+	(( hits0 > 0 && hits1 > 0 )) ||
+		error "read-ahead not working for both streams ($hits0/$hits1)"
+
+	rm -f $DIR/$tfile
+}
+run_test 101i "read-ahead for interleaved streams through one fd"
+
 setup_test102() {
 	test_mkdir $DIR/$tdir
 	chown $RUNAS_ID $DIR/$tdir
@@ -8805,7 +8882,7 @@ test_115() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 	remote_ost_nodsh && skip "remote OST with nodsh"
 
-	# Lustre does not stop service threads once they are started.
+	# Lustre only stops service threads after threads_idle_time.
 	# Reset number of running threads to default.
 	stopall
 	setupall
@@ -20262,6 +20339,781 @@ test_811() {
 }
 run_test 811 "orphan name stub can be cleaned up in startup"
 
+test_812() {
+	local heat
+	local readsample
+	local writesample
+
+	$LCTL get_param -n llite.*.file_heat > /dev/null 2>&1 ||
+		skip "no file heat support"
+
+	$LCTL set_param llite.*.file_heat=1
+	stack_trap "$LCTL set_param llite.*.file_heat=1" EXIT
+
+	dd if=/dev/zero of=$DIR/$tfile bs=4k count=100 conv=fsync ||
+		error "dd write failed"
+	dd if=$DIR/$tfile of=/dev/null bs=4k count=100 ||
+		error "dd read failed"
+
+	heat=$($LFS heat_get $DIR/$tfile) || error "heat_get failed"
+	echo "$heat"
+	readsample=$(echo "$heat" | awk '/^readsample:/ { print $2 }')
+	writesample=$(echo "$heat" | awk '/^writesample:/ { print $2 }')
+	[ "$readsample" -gt 0 ] || error "read heat $readsample not increased"
+	[ "$writesample" -gt 0 ] ||
+		error "write heat $writesample not increased"
+
+	$LFS heat_set --clear $DIR/$tfile || error "heat_set --clear failed"
+	heat=$($LFS heat_get $DIR/$tfile)
+	echo "$heat" | awk '/sample:|byte:/ { if ($2 != 0) exit 1 }' ||
+		error "heat not cleared: $heat"
+
+	$LFS heat_set --off $DIR/$tfile || error "heat_set --off failed"
+	dd if=$DIR/$tfile of=/dev/null bs=4k count=100 ||
+		error "dd read failed"
+	heat=$($LFS heat_get $DIR/$tfile)
+	echo "$heat" | awk '/sample:|byte:/ { if ($2 != 0) exit 1 }' ||
+		error "heat changed while off: $heat"
+
+	$LFS heat_set --on $DIR/$tfile || error "heat_set --on failed"
+	dd if=$DIR/$tfile of=/dev/null bs=4k count=100 ||
+		error "dd read failed"
+	readsample=$($LFS heat_get $DIR/$tfile |
+		     awk '/^readsample:/ { print $2 }')
+	[ "$readsample" -gt 0 ] || error "read heat not tracked after --on"
+
+	$LCTL set_param llite.*.file_heat=0
+	$LFS heat_set --clear $DIR/$tfile
+	dd if=$DIR/$tfile of=/dev/null bs=4k count=100 ||
+		error "dd read failed"
+	readsample=$($LFS heat_get $DIR/$tfile |
+		     awk '/^readsample:/ { print $2 }')
+	[ "$readsample" -eq 0 ] ||
+		error "read heat $readsample tracked with file_heat=0"
+}
+run_test 812 "per-file heat tracking and lfs heat_get/heat_set"
+
+test_813() {
+	[ $(lustre_version_code ost1) -lt $(version_code 2.12.51) ] &&
+		skip "Need OST version at least 2.12.51"
+	[ "$ost1_FSTYPE" != ldiskfs ] && skip "ldiskfs only test"
+	which fallocate > /dev/null 2>&1 || skip "no fallocate command"
+
+	local blocks
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	fallocate -l 1M $DIR/$tfile 2>&1 | grep -q "not supported" &&
+		skip "fallocate not supported"
+	[ $(stat -c %s $DIR/$tfile) -eq 1048576 ] ||
+		error "wrong size $(stat -c %s $DIR/$tfile) after fallocate"
+	cancel_lru_locks osc
+	blocks=$(stat -c %b $DIR/$tfile)
+	(( blocks * 512 >= 1048576 )) ||
+		error "only $blocks blocks allocated for 1MB"
+	cmp -n 1048576 $DIR/$tfile /dev/zero ||
+		error "preallocated range does not read back as zeroes"
+
+	fallocate -n -o 1M -l 1M $DIR/$tfile ||
+		error "fallocate --keep-size failed"
+	[ $(stat -c %s $DIR/$tfile) -eq 1048576 ] ||
+		error "size changed with --keep-size"
+	cancel_lru_locks osc
+	(( $(stat -c %b $DIR/$tfile) > blocks )) ||
+		error "no blocks allocated beyond EOF with --keep-size"
+
+	fallocate -p -o 0 -l 4096 $DIR/$tfile 2>/dev/null &&
+		error "punch hole mode should not be supported"
+	return 0
+}
+run_test 813 "fallocate preallocates OST blocks"
+
+test_814() {
+	local tf=$TMP/$tfile
+	local fio=${FIO:-$(which fio 2> /dev/null)}
+
+	stack_trap "rm -f $tf $tf.2" EXIT
+
+	dd if=/dev/urandom of=$tf bs=1M count=4 || error "dd to $tf failed"
+
+	# neither the file offsets nor the sizes are page aligned
+	dd if=$tf of=$DIR/$tfile bs=4000 oflag=direct ||
+		error "unaligned direct write failed"
+	cancel_lru_locks osc
+	cmp $tf $DIR/$tfile || error "data differs after unaligned write"
+	dd if=$DIR/$tfile of=$tf.2 bs=4000 iflag=direct ||
+		error "unaligned direct read failed"
+	cmp $tf $tf.2 || error "data differs after unaligned read"
+
+	[ -n "$fio" ] || skip_env "no fio for asynchronous direct I/O"
+
+	rm -f $DIR/$tfile
+	$LFS setstripe -c $OSTCOUNT -S 64k $DIR/$tfile ||
+		error "setstripe failed"
+	$fio --name=aio --filename=$DIR/$tfile --ioengine=libaio \
+		--direct=1 --iodepth=64 --rw=randwrite --bs=16k --size=32M \
+		--verify=crc32c --do_verify=1 ||
+		error "asynchronous direct I/O failed"
+	$fio --name=aio-unaligned --filename=$DIR/$tfile --ioengine=libaio \
+		--direct=1 --iodepth=32 --rw=randread --bs=3000 --size=32M ||
+		error "unaligned asynchronous direct read failed"
+}
+run_test 814 "asynchronous and unaligned direct I/O"
+
+test_815() {
+	local tf=$TMP/$tfile
+	local wire
+	local raw
+
+	$LCTL get_param -n osc.$FSNAME-OST0000*.import |
+		grep -q "connect_flags:.*compress" ||
+		skip "OST does not support bulk compression"
+
+	stack_trap "rm -f $tf $tf.2" EXIT
+
+	$LFS setstripe -E -1 -c 1 -i 0 --component-flags=compress \
+		$DIR/$tfile || error "setstripe failed"
+	$LFS getstripe $DIR/$tfile | grep -q "lcme_flags:.*compress" ||
+		error "compress flag not set on $DIR/$tfile"
+
+	# compresses well, and leaves a partial page at the end
+	yes "$tfile" | head -c 4000000 > $tf
+	$LCTL set_param -n osc.*.compress_stats=clear
+	dd if=$tf of=$DIR/$tfile bs=1M conv=fsync ||
+		error "write to $DIR/$tfile failed"
+	cancel_lru_locks osc
+	cmp $tf $DIR/$tfile || error "data differs after compressed write"
+	cat $DIR/$tfile > $tf.2 || error "read of $DIR/$tfile failed"
+	cmp $tf $tf.2 || error "data differs after compressed read"
+
+	$LCTL get_param osc.$FSNAME-OST0000*.compress_stats
+	for op in write read; do
+		raw=$($LCTL get_param -n osc.$FSNAME-OST0000*.compress_stats |
+		      awk "/^${op}_raw_bytes/ { print \$2 }")
+		wire=$($LCTL get_param -n osc.$FSNAME-OST0000*.compress_stats |
+		       awk "/^${op}_wire_bytes/ { print \$2 }")
+		(( raw > 0 && wire < raw )) ||
+			error "$op data not compressed: $wire/$raw bytes"
+	done
+
+	# random data does not compress, and is sent as is
+	dd if=/dev/urandom of=$tf bs=1M count=4 || error "dd to $tf failed"
+	dd if=$tf of=$DIR/$tfile bs=1M conv=fsync ||
+		error "write to $DIR/$tfile failed"
+	cancel_lru_locks osc
+	cmp $tf $DIR/$tfile || error "data differs after uncompressible I/O"
+}
+run_test 815 "bulk data compression on the wire"
+
+test_816() {
+	local tf=$TMP/$tfile
+	local fast
+
+	stack_trap "rm -f $tf" EXIT
+
+	$LCTL get_param -n llite.*.tiny_write | grep -q 1 ||
+		skip "fast writes are disabled"
+
+	$LFS setstripe -c $OSTCOUNT -S 64k $DIR/$tfile ||
+		error "setstripe failed"
+	dd if=/dev/urandom of=$tf bs=1M count=1 || error "dd to $tf failed"
+	# dirty the pages, then overwrite them across page and stripe
+	# boundaries while they are still in the cache
+	dd if=$tf of=$DIR/$tfile bs=1M count=1 || error "first write failed"
+	dd if=/dev/urandom of=$tf bs=5000 seek=7 count=60 conv=notrunc ||
+		error "dd to $tf failed"
+	dd if=$tf of=$DIR/$tfile bs=5000 skip=7 seek=7 count=60 \
+		conv=notrunc || error "overwrite failed"
+	# extend the file from a dirty page into new ones
+	dd if=/dev/urandom of=$tf bs=3000 seek=349 count=3 conv=notrunc ||
+		error "dd to $tf failed"
+	dd if=$tf of=$DIR/$tfile bs=3000 skip=349 seek=349 count=3 \
+		conv=notrunc || error "extending write failed"
+
+	$CHECKSTAT -s $(stat -c %s $tf) $DIR/$tfile ||
+		error "wrong size, expected $(stat -c %s $tf)"
+	cmp $tf $DIR/$tfile || error "data differs before flush"
+
+	# written back pages stay cached under the write lock, overwriting
+	# them has to take the fast path
+	sync
+	$LCTL set_param -n llite.*.stats=0
+	dd if=/dev/urandom of=$tf bs=4k seek=10 count=4 conv=notrunc ||
+		error "dd to $tf failed"
+	dd if=$tf of=$DIR/$tfile bs=4k skip=10 seek=10 count=4 \
+		conv=notrunc || error "overwrite of clean pages failed"
+	fast=$($LCTL get_param -n llite.*.stats |
+	       awk '/^fast_write / { sum += $7 } END { print sum }')
+	echo "fast write bytes to clean pages: ${fast:-0}"
+	(( ${fast:-0} == 16384 )) ||
+		error "clean pages took ${fast:-0} fast write bytes, not 16384"
+
+	cancel_lru_locks osc
+	cmp $tf $DIR/$tfile || error "data differs after flush"
+
+	# appends go on in the last page under the [0, EOF] write lock
+	rm -f $DIR/$tfile.log $tf.log
+	stack_trap "rm -f $DIR/$tfile.log $tf.log" EXIT
+	$LFS setstripe -c 1 $DIR/$tfile.log || error "setstripe log failed"
+	echo "record 0" >> $DIR/$tfile.log
+	echo "record 0" >> $tf.log
+	$LCTL set_param -n llite.*.stats=0
+	for i in {1..20}; do
+		echo "record $i" >> $DIR/$tfile.log
+		echo "record $i" >> $tf.log
+	done
+	fast=$($LCTL get_param -n llite.*.stats |
+	       awk '/^fast_write / { sum += $2 } END { print sum }')
+	echo "fast appends: ${fast:-0}"
+	(( ${fast:-0} == 20 )) ||
+		error "${fast:-0} of 20 appends took the fast path"
+	cmp $tf.log $DIR/$tfile.log || error "log differs before flush"
+	cancel_lru_locks osc
+	cmp $tf.log $DIR/$tfile.log || error "log differs after flush"
+}
+run_test 816 "fast writes to cached pages and appends"
+
+test_817() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run"
+
+	local tgt=$($LCTL dl | grep "0000-osc-[^mM]" | awk '{print $4}')
+	local osc="osc.$tgt"
+	local max_dirty=$(($($LCTL get_param -n $osc.max_dirty_mb) << 20))
+	local max_grant
+	local size_mb=32
+	local threads=$(nproc)
+	local dirty
+	local grant
+	local pids=""
+	local pid
+	local i
+
+	(( threads > 16 )) && threads=16
+	(( $($LCTL get_param -n $osc.kbytesavail) > 2 * threads *
+	   size_mb * 1024 )) || skip "not enough space on OST0000"
+	[[ $($LCTL get_param $osc.import |
+	     grep "connect_flags:.*grant_param") ]] ||
+		skip "no grant_param connect flag"
+	max_grant=$(($(want_grant $tgt) + $(grant_chunk $tgt)))
+
+	test_mkdir $DIR/$tdir
+	$LFS setstripe -c 1 -i 0 $DIR/$tdir || error "setstripe failed"
+	stack_trap "rm -rf $DIR/$tdir" EXIT
+
+	# cached writes of several threads to the same OSC, they all take
+	# their dirty page and grant credits from the same client_obd
+	for ((i = 0; i < threads; i++)); do
+		dd if=/dev/zero of=$DIR/$tdir/$tfile.$i bs=64k \
+			count=$((size_mb * 16)) 2> /dev/null &
+		pids="$pids $!"
+	done
+
+	# the credits cached on the CPUs must not let the client exceed the
+	# dirty and grant limits
+	while pgrep -f "of=$DIR/$tdir/$tfile" > /dev/null; do
+		dirty=$($LCTL get_param -n $osc.cur_dirty_bytes)
+		grant=$($LCTL get_param -n $osc.cur_grant_bytes)
+		(( dirty <= max_dirty )) ||
+			error "cur_dirty_bytes $dirty > $max_dirty"
+		(( grant <= max_grant )) ||
+			error "cur_grant_bytes $grant > $max_grant"
+		sleep 0.5
+	done
+
+	for pid in $pids; do
+		wait $pid || error "dd $pid failed"
+	done
+	sync
+
+	(( $($LCTL get_param -n $osc.cur_dirty_bytes) == 0 )) ||
+		error "dirty pages left after sync"
+	for ((i = 0; i < threads; i++)); do
+		(( $(stat -c %s $DIR/$tdir/$tfile.$i) == size_mb << 20 )) ||
+			error "$tfile.$i has wrong size"
+	done
+}
+run_test 817 "many cached writers stay within dirty and grant limits"
+
+test_818() {
+	local osc="osc.$FSNAME-OST0000-osc-[^mM]*"
+	local max_rpcs=$($LCTL get_param -n $osc.max_rpcs_in_flight)
+	local max_pages=$($LCTL get_param -n $osc.max_pages_per_rpc)
+	local rpcs
+	local pages
+	local pids=""
+	local pid
+	local i
+
+	$LCTL get_param -n $osc.adaptive_rpc > /dev/null ||
+		skip "adaptive RPC window is not supported"
+
+	$LCTL set_param $osc.adaptive_rpc=1
+	stack_trap "$LCTL set_param $osc.adaptive_rpc=0" EXIT
+	stack_trap "rm -f $TMP/$tfile" EXIT
+
+	dd if=/dev/urandom of=$TMP/$tfile bs=1M count=64 ||
+		error "dd to $TMP/$tfile failed"
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	for ((i = 0; i < 4; i++)); do
+		dd if=$TMP/$tfile of=$DIR/$tfile bs=1M count=16 \
+			skip=$((i * 16)) seek=$((i * 16)) conv=notrunc \
+			2> /dev/null &
+		pids="$pids $!"
+	done
+	for pid in $pids; do
+		wait $pid || error "dd $pid failed"
+	done
+	sync
+	$LCTL get_param $osc.osc_stats
+
+	rpcs=$($LCTL get_param -n $osc.osc_stats |
+	       awk '/rpcs_in_flight_window/ { print $2 }')
+	pages=$($LCTL get_param -n $osc.osc_stats |
+		awk '/pages_per_rpc_window/ { print $2 }')
+	(( rpcs >= 1 && rpcs <= max_rpcs )) ||
+		error "$rpcs RPCs in flight out of [1, $max_rpcs]"
+	(( pages >= 1 && pages <= max_pages )) ||
+		error "$pages pages per RPC out of [1, $max_pages]"
+
+	# the data written with a changing window must be intact
+	cancel_lru_locks osc
+	cmp $TMP/$tfile $DIR/$tfile || error "data differs"
+}
+run_test 818 "latency-driven RPC window stays within the tunables"
+
+test_819() {
+	local max=$($LCTL get_param -n llite.*.statahead_max | head -n 1)
+	local count=1000
+	local batches
+	local enqueues
+
+	$LCTL get_param -n mdc.$FSNAME-MDT0000-mdc-*.connect_flags |
+		grep -q batch_rpc || skip "MDS does not support batched RPCs"
+
+	$LCTL set_param llite.*.statahead_max=32
+	stack_trap "$LCTL set_param llite.*.statahead_max=$max" EXIT
+
+	test_mkdir -i 0 -c 1 $DIR/$tdir
+	createmany -o $DIR/$tdir/f $count || error "createmany failed"
+	cancel_lru_locks mdc
+	$LCTL set_param mdc.*.stats=clear > /dev/null
+
+	ls -l $DIR/$tdir > /dev/null || error "ls -l $DIR/$tdir failed"
+	$LCTL get_param llite.*.statahead_stats
+
+	batches=$($LCTL get_param -n mdc.*.stats |
+		  awk '/mds_batch/ { sum += $2 } END { print sum + 0 }')
+	enqueues=$($LCTL get_param -n mdc.*.stats |
+		   awk '/ldlm_enqueue/ { sum += $2 } END { print sum + 0 }')
+	echo "$batches batch RPCs, $enqueues single enqueues"
+	(( batches > 0 )) || error "no MDS_BATCH RPC was sent"
+	(( enqueues < count / 2 )) ||
+		error "$enqueues single enqueues for $count files"
+
+	unlinkmany $DIR/$tdir/f $count || error "unlinkmany failed"
+}
+run_test 819 "statahead sends getattr intents in batch RPCs"
+
+test_820() {
+	local param="ost.OSS.ost_io"
+	local idle_time
+	local started
+	local min
+	local i
+
+	idle_time=$(do_facet ost1 $LCTL get_param -n $param.threads_idle_time) ||
+		skip "idle service threads are never stopped"
+	min=$(do_facet ost1 $LCTL get_param -n $param.threads_min)
+
+	do_facet ost1 $LCTL set_param $param.threads_idle_time=2
+	stack_trap "do_facet ost1 $LCTL set_param \
+		    $param.threads_idle_time=$idle_time" EXIT
+
+	test_mkdir $DIR/$tdir
+	$LFS setstripe -c 1 -i 0 $DIR/$tdir || error "setstripe failed"
+	for ((i = 0; i < 32; i++)); do
+		dd if=/dev/zero of=$DIR/$tdir/f$i bs=1M count=16 oflag=direct \
+			2> /dev/null &
+	done
+	wait
+	started=$(do_facet ost1 $LCTL get_param -n $param.threads_started)
+	echo "$started threads started, threads_min $min"
+
+	sleep 10
+	do_facet ost1 $LCTL get_param $param.threads_churn
+	started=$(do_facet ost1 $LCTL get_param -n $param.threads_started)
+	(( started <= min )) ||
+		error "$started threads still running after being idle"
+}
+run_test 820 "idle service threads above threads_min are stopped"
+
+test_821() {
+	local ns="ldlm.namespaces.filter-$FSNAME-OST0000_UUID"
+	local rpcs
+	local locks
+	local i
+
+	$LCTL get_param -n osc.$FSNAME-OST0000-osc-[^M]*.connect_flags |
+		grep -q batch_bl_ast ||
+		skip "server does not support batched blocking ASTs"
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	cancel_lru_locks osc
+	rpcs=$(do_facet ost1 $LCTL get_param -n $ns.bl_ast_rpcs)
+	locks=$(do_facet ost1 $LCTL get_param -n $ns.bl_ast_locks)
+
+	# lockahead locks are not expanded, each 1MB gets its own lock
+	for ((i = 0; i < 16; i += 2)); do
+		$LFS ladvise -a lockahead -m WRITE -s ${i}M -l 1M $DIR/$tfile ||
+			error "lockahead of ${i}M failed"
+	done
+	sleep 1
+	$LCTL get_param ldlm.namespaces.$FSNAME-OST0000-osc-[^M]*.lock_count
+
+	# the PR lock taken by the OST conflicts with all of them
+	$LFS data_version -r $DIR/$tfile || error "data_version failed"
+
+	rpcs=$(($(do_facet ost1 $LCTL get_param -n $ns.bl_ast_rpcs) - rpcs))
+	locks=$(($(do_facet ost1 $LCTL get_param -n $ns.bl_ast_locks) - locks))
+	echo "$locks locks in $rpcs blocking AST RPCs"
+	(( rpcs > 0 )) || error "no blocking AST sent"
+	(( locks > rpcs )) || error "blocking ASTs were not batched"
+}
+run_test 821 "blocking ASTs of an export are sent in one RPC"
+
+test_822() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run"
+
+	if ! module_loaded obdecho; then
+		load_module obdecho/obdecho &&
+			stack_trap "rmmod obdecho" EXIT ||
+			error "unable to load obdecho on client"
+	fi
+
+	local osc=$($LCTL dl | grep -v mdt | awk '$3 == "osc" {print $4; exit}')
+	local host=$($LCTL get_param -n osc.$osc.import |
+		     awk '/current_connection:/ { print $2 }' )
+	local target=$($LCTL get_param -n osc.$osc.import |
+		       awk '/target:/ { print $2 }' )
+	target=${target%_UUID}
+	[ -n "$target" ] || error "there is no osc.$osc.import target"
+
+	setup_obdecho_osc $host $target &&
+		stack_trap "cleanup_obdecho_osc $target" EXIT ||
+		error "obdecho setup failed with $?"
+
+	# BRW RPCs of the echo client are all sent by ptlrpcd threads
+	$LCTL set_param osc.${target}_osc.stats=clear > /dev/null
+	obdecho_test ${target}_osc client 16 ||
+		error "obdecho_test failed on ${target}_osc"
+
+	local queued=$($LCTL get_param -n osc.${target}_osc.stats |
+		       awk '/ptlrpcd_waittime/ { print $2 }')
+	local brw=$($LCTL get_param -n osc.${target}_osc.stats |
+		    awk '/^ost_(read|write) / { n += $2 } END { print n + 0 }')
+	local inflight=$($LCTL get_param -n osc.${target}_osc.import |
+			 awk '/inflight:/ { print $2 }')
+
+	(( brw > 0 )) || error "no BRW RPC sent by the echo client"
+	# every queued RPC is picked up by a ptlrpcd thread and completes
+	(( ${queued:-0} >= brw )) ||
+		error "only ${queued:-0} of $brw BRW RPCs went through ptlrpcd"
+	(( inflight == 0 )) || error "$inflight RPCs still in flight"
+}
+run_test 822 "async RPCs through echo client are all handled by ptlrpcd"
+
+test_823() {
+	$LCTL get_param -n ptlrpc_pools > /dev/null 2>&1 ||
+		skip "no ptlrpc_pools statistics on client"
+
+	local before
+	local after
+
+	mkdir -p $DIR/$tdir || error "mkdir $DIR/$tdir failed"
+	# the first round of requests fills the caches
+	createmany -o $DIR/$tdir/f- 100 || error "createmany failed"
+	$LCTL get_param -n ptlrpc_pools
+
+	before=$($LCTL get_param -n ptlrpc_pools |
+		 awk '$1 == "ptlrpc_cache" { print $4 }')
+	unlinkmany $DIR/$tdir/f- 100 || error "unlinkmany failed"
+	after=$($LCTL get_param -n ptlrpc_pools |
+		awk '$1 == "ptlrpc_cache" { print $4 }')
+	$LCTL get_param -n ptlrpc_pools
+
+	(( after > before )) ||
+		error "requests not reused: hits $before -> $after"
+}
+run_test 823 "ptlrpc requests are reused from the per-CPT pools"
+
+test_824() {
+	[ $MDSCOUNT -lt 2 ] && skip_env "needs >= 2 MDTs"
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+
+	local stats
+	local i
+
+	test_mkdir -i 0 $DIR/$tdir
+	do_facet mds1 $LCTL set_param mds.MDS.mdt.stats=clear > /dev/null
+	# the ACK locks of remote directory creation make difficult replies
+	for ((i = 0; i < 100; i++)); do
+		$LFS mkdir -i 1 $DIR/$tdir/d$i ||
+			error "lfs mkdir -i 1 $DIR/$tdir/d$i failed"
+	done
+	sync
+
+	stats=($(do_facet mds1 $LCTL get_param -n mds.MDS.mdt.stats |
+		 awk '/^rs_queue_time / { print $2, $5, $6, $7 }'))
+	(( ${stats[0]:-0} > 0 )) || error "no difficult reply was handled"
+	echo "reply handler latency of ${stats[0]} replies:" \
+	     "min ${stats[1]}us, max ${stats[2]}us," \
+	     "avg $((stats[3] / stats[0]))us"
+}
+run_test 824 "queue latency of difficult replies"
+
+test_825() {
+	[ $MDSCOUNT -lt 2 ] && skip_env "needs >= 2 MDTs"
+	$LCTL get_param -n mdc.$FSNAME-MDT0000*.connect_flags |
+		grep -q dir_placement || skip "server has no dir_placement"
+
+	local policy
+	local count
+	local mdts
+	local i
+
+	for policy in roundrobin space; do
+		test_mkdir -i 0 $DIR/$tdir.$policy
+		$LFS setdirstripe -D -c 1 -i -1 -P $policy \
+			$DIR/$tdir.$policy ||
+			error "set $policy placement on $DIR/$tdir.$policy"
+		$LFS getdirstripe -D $DIR/$tdir.$policy |
+			grep -q "lmv_placement: $policy" ||
+			error "$policy placement not set"
+
+		count=$((MDSCOUNT * 20))
+		for ((i = 0; i < count; i++)); do
+			mkdir $DIR/$tdir.$policy/d$i ||
+				error "mkdir $DIR/$tdir.$policy/d$i failed"
+		done
+
+		mdts=$(for ((i = 0; i < count; i++)); do
+			$LFS getdirstripe -i $DIR/$tdir.$policy/d$i
+		done | sort -u | wc -l)
+		echo "$policy: $count directories on $mdts MDTs"
+		(( mdts > 1 )) || error "$policy placed all directories on 1 MDT"
+
+		# the policy is inherited by the subdirectories
+		$LFS getdirstripe -D $DIR/$tdir.$policy/d1 |
+			grep -q "lmv_placement: $policy" ||
+			error "$policy placement not inherited"
+	done
+}
+run_test 825 "placement policy of new subdirectories"
+
+test_826() {
+	[ $MDSCOUNT -lt 2 ] && skip_env "needs >= 2 MDTs"
+	local mdts=$(comma_list $(mdts_nodes))
+
+	do_facet mds1 $LCTL list_param mdd.*.enable_dir_auto_split ||
+		skip "server has no dir auto split"
+
+	local enable=$(do_facet mds1 $LCTL get_param -n \
+		mdd.$FSNAME-MDT0000.enable_dir_auto_split)
+	local count=$(do_facet mds1 $LCTL get_param -n \
+		mdd.$FSNAME-MDT0000.dir_split_count)
+
+	do_nodes $mdts "$LCTL set_param mdd.*.dir_split_count=100" ||
+		error "set dir_split_count failed"
+	stack_trap "do_nodes $mdts $LCTL set_param \
+		mdd.*.dir_split_count=$count" EXIT
+	do_nodes $mdts "$LCTL set_param mdd.*.enable_dir_auto_split=1" ||
+		error "enable dir auto split failed"
+	stack_trap "do_nodes $mdts $LCTL set_param \
+		mdd.*.enable_dir_auto_split=$enable" EXIT
+
+	test_mkdir -i 0 -c 1 $DIR/$tdir
+	createmany -o $DIR/$tdir/f 1000 || error "create files failed"
+
+	local stripes
+	local i
+
+	for ((i = 0; i < 30; i++)); do
+		stripes=$($LFS getdirstripe -c $DIR/$tdir)
+		(( stripes > 1 )) && break
+		sleep 1
+	done
+	(( stripes > 1 )) || error "$DIR/$tdir is not split"
+	echo "$DIR/$tdir is split to $stripes stripes"
+
+	do_facet mds1 $LCTL get_param -n mdd.$FSNAME-MDT0000.dir_split_stats
+	do_facet mds1 $LCTL get_param -n \
+		mdd.$FSNAME-MDT0000.dir_split_stats |
+		awk '/^started:/ { exit $2 > 0 ? 0 : 1 }' ||
+		error "split is not accounted"
+
+	# wait for split to finish, all names are kept
+	wait_update_facet mds1 "$LCTL get_param -n \
+		mdd.$FSNAME-MDT0000.dir_split_stats | grep -c '^current:'" \
+		"0" 60 || error "split doesn't finish"
+
+	local hash=$($LFS getdirstripe -H $DIR/$tdir)
+
+	[[ "$hash" == "fnv_1a_64" ]] || error "$DIR/$tdir has hash $hash"
+
+	# new names go to the new stripes and can be found again
+	createmany -o $DIR/$tdir/g 1000 || error "create after split failed"
+	cancel_lru_locks mdc
+	ls -l $DIR/$tdir > /dev/null || error "ls -l $DIR/$tdir failed"
+	(( $(ls $DIR/$tdir | wc -l) == 2000 )) ||
+		error "$DIR/$tdir doesn't have 2000 entries"
+	unlinkmany $DIR/$tdir/g 1000 || error "new files lost after split"
+	unlinkmany $DIR/$tdir/f 1000 || error "files lost after split"
+}
+run_test 826 "directory is split automatically when it grows"
+
+test_827() {
+	[ $MDSCOUNT -lt 3 ] && skip_env "needs >= 3 MDTs"
+	$LCTL get_param -n mdc.$FSNAME-MDT0000*.connect_flags |
+		grep -q jump_hash || skip "server has no jump_hash"
+
+	local count=300
+	local moved=0
+	local sa
+	local sb
+	local i
+
+	test_mkdir $DIR/$tdir
+	$LFS setdirstripe -i 0 -c 2 -H jump $DIR/$tdir/a ||
+		error "create $DIR/$tdir/a failed"
+	$LFS setdirstripe -i 0 -c 3 -H jump $DIR/$tdir/b ||
+		error "create $DIR/$tdir/b failed"
+	$LFS getdirstripe -H $DIR/$tdir/b | grep -q jump ||
+		error "hash type of $DIR/$tdir/b is not jump"
+
+	createmany -o $DIR/$tdir/a/f $count || error "create in a failed"
+	createmany -o $DIR/$tdir/b/f $count || error "create in b failed"
+
+	# stripe index of each MDT
+	local stripe_a=()
+	local stripe_b=()
+	local mdt
+
+	i=0
+	for mdt in $($LFS getdirstripe $DIR/$tdir/a |
+		     awk '$2 ~ /^\[0x/ { print $1 }'); do
+		stripe_a[$mdt]=$((i++))
+	done
+	i=0
+	for mdt in $($LFS getdirstripe $DIR/$tdir/b |
+		     awk '$2 ~ /^\[0x/ { print $1 }'); do
+		stripe_b[$mdt]=$((i++))
+	done
+
+	for ((i = 0; i < count; i++)); do
+		sa=${stripe_a[$($LFS getstripe -m $DIR/$tdir/a/f$i)]}
+		sb=${stripe_b[$($LFS getstripe -m $DIR/$tdir/b/f$i)]}
+		[ "$sa" == "$sb" ] && continue
+		# names can only move to the new stripe
+		[ "$sb" == 2 ] ||
+			error "f$i moved from stripe $sa to stripe $sb"
+		moved=$((moved + 1))
+	done
+	echo "$moved of $count names moved from 2 to 3 stripes"
+	(( moved > 0 && moved < count / 2 )) ||
+		error "$moved names moved, expect about $((count / 3))"
+}
+run_test 827 "jump hash moves few names when stripe count grows"
+
+test_828a() {
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+	# records are filtered on the client if the MDT cannot do it
+	$LFS help changelog 2>&1 | grep -q -- --type ||
+		skip "lfs changelog has no record filter"
+
+	local mdt0=$(facet_svc $SINGLEMDS)
+	local dir_fid
+	local fid
+	local n
+
+	changelog_register || error "changelog_register failed"
+
+	test_mkdir -i 0 -c 1 $DIR/$tdir
+	chmod 777 $DIR/$tdir
+	dir_fid=$($LFS path2fid $DIR/$tdir)
+
+	createmany -o $DIR/$tdir/f 10 || error "createmany failed"
+	chmod 600 $DIR/$tdir/f1 || error "chmod failed"
+	unlinkmany $DIR/$tdir/f 5 || error "unlinkmany failed"
+	$RUNAS touch $DIR/$tdir/$tfile || error "touch as $RUNAS_ID failed"
+	fid=$($LFS path2fid $DIR/$tdir/f6)
+
+	$LFS changelog --fid $dir_fid $mdt0 | tail -20
+
+	n=$($LFS changelog --type CREAT,UNLNK --fid $dir_fid $mdt0 |
+	    awk '$2 !~ /CREAT|UNLNK/' | wc -l)
+	(( n == 0 )) || error "$n records of unwanted types delivered"
+
+	n=$($LFS changelog --type creat --fid $dir_fid $mdt0 | wc -l)
+	(( n == 11 )) || error "$n CREAT records, expect 11"
+
+	n=$($LFS changelog --type UNLNK --fid $dir_fid $mdt0 | wc -l)
+	(( n == 5 )) || error "$n UNLNK records, expect 5"
+
+	$LFS changelog --fid $fid $mdt0 | grep -qF "t=$fid" ||
+		error "no record delivered for $fid"
+	n=$($LFS changelog --fid $fid $mdt0 | grep -vF "t=$fid" | wc -l)
+	(( n == 0 )) || error "$n records for other FIDs than $fid delivered"
+
+	n=$($LFS changelog --type CREAT --fid $dir_fid --uid $RUNAS_ID $mdt0 |
+	    wc -l)
+	(( n == 1 )) || error "$n CREAT records by $RUNAS_ID, expect 1"
+
+	$LFS changelog --type NOSUCHTYPE $mdt0 &&
+		error "unknown record type accepted"
+	return 0
+}
+run_test 828a "changelog records are filtered per reader"
+
+chlg_next_block_rpcs() {
+	$LCTL get_param -n mdc.$FSNAME-MDT0000-mdc-*.stats |
+		awk '/^llog_origin_handle_next_block/ { n += $2 }
+		     END { print n + 0 }'
+}
+
+test_828b() {
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+	$LCTL get_param -n mdc.$FSNAME-MDT0000-mdc-*.import |
+		grep -q chlg_filter || skip "MDT does not filter changelog"
+
+	local mdt0=$(facet_svc $SINGLEMDS)
+	local all
+	local some
+	local n
+
+	changelog_register || error "changelog_register failed"
+
+	test_mkdir -i 0 -c 1 $DIR/$tdir
+	createmany -o $DIR/$tdir/f 2000 || error "createmany failed"
+	for n in 1 2 3 4 5; do
+		mv $DIR/$tdir/f$n $DIR/$tdir/g$n || error "mv f$n failed"
+	done
+
+	$LCTL set_param -n mdc.$FSNAME-MDT0000-mdc-*.stats=clear
+	n=$($LFS changelog $mdt0 | wc -l)
+	all=$(chlg_next_block_rpcs)
+	(( n > 2000 )) || error "$n records, expect more than 2000"
+
+	$LCTL set_param -n mdc.$FSNAME-MDT0000-mdc-*.stats=clear
+	n=$($LFS changelog --type RENME $mdt0 | wc -l)
+	some=$(chlg_next_block_rpcs)
+	(( n == 5 )) || error "$n RENME records, expect 5"
+
+	# skipped records are not sent, so fewer llog blocks are needed
+	echo "$all llog block RPCs for all records, $some for RENME"
+	(( some * 4 <= all )) ||
+		error "$some RPCs for RENME records, $all for all records"
+}
+run_test 828b "MDT only sends the changelog records matching the filter"
+
 #
 # tests that do cleanup/setup should be run at the end
 #
@@ -3848,6 +3848,34 @@ test_77n() { #LU-10802
 }
 run_test 77n "check wildcard support for TBF JobID NRS policy"
 
+test_77o() {
+	local nodes=$(comma_list $(osts_nodes))
+	local handled
+	local shed
+
+	do_nodes $nodes lctl set_param ost.OSS.ost_io.nrs_policies=deadline ||
+		skip "no deadline NRS policy"
+
+	# shedding is opt-in
+	shed=$(do_facet ost1 lctl get_param -n \
+	       ost.OSS.ost_io.nrs_deadline_shed | grep reg_shed)
+	[[ "$shed" == "reg_shed:0" ]] ||
+		error "shedding enabled by default: $shed"
+	do_nodes $nodes lctl set_param ost.OSS.ost_io.nrs_deadline_shed=1 ||
+		error "failed to enable shedding"
+
+	nrs_write_read
+
+	handled=$(do_facet ost1 lctl get_param -n \
+		  ost.OSS.ost_io.nrs_policies |
+		  awk '/name: deadline/ { found = 1 }
+		       found && /handled:/ { print $2; exit }')
+	do_nodes $nodes lctl set_param ost.OSS.ost_io.nrs_policies="fifo" ||
+		error "failed to set policy back to fifo"
+	(( handled > 0 )) || error "no request handled by deadline policy"
+}
+run_test 77o "check deadline NRS policy"
+
 test_78() { #LU-6673
 	local rc
 
@@ -4500,6 +4528,104 @@ test_102() {
 }
 run_test 102 "Test open by handle of unlinked file"
 
+test_103a() {
+	local count=200
+	local i
+	local modes
+	local names
+
+	test_mkdir -i 0 -c 1 $DIR1/$tdir
+	createmany -o $DIR1/$tdir/f $count || error "createmany failed"
+
+	# the second mount holds PR locks on the directory and every file
+	cancel_lru_locks mdc
+	ls -l $DIR2/$tdir > /dev/null || error "ls -l $DIR2/$tdir failed"
+
+	# UPDATE and LOOKUP conflicts must still revoke the cached locks
+	chmod 0600 $DIR1/$tdir/f* || error "chmod $DIR1/$tdir failed"
+	modes=$(stat -c %a $DIR2/$tdir/f* | sort -u)
+	[[ "$modes" == "600" ]] || error "stale modes on $DIR2: $modes"
+
+	ls -l $DIR2/$tdir > /dev/null || error "ls -l $DIR2/$tdir failed"
+	for ((i = 0; i < count; i++)); do
+		mv $DIR1/$tdir/f$i $DIR1/$tdir/g$i ||
+			error "mv $DIR1/$tdir/f$i failed"
+	done
+	names=$(ls $DIR2/$tdir | grep -c "^g")
+	(( names == count )) || error "$DIR2 sees $names/$count new names"
+	[[ -z "$(ls $DIR2/$tdir | grep "^f")" ]] ||
+		error "$DIR2 still sees old names"
+
+	unlinkmany $DIR1/$tdir/g $count || error "unlinkmany failed"
+}
+run_test 103a "IBITS conflicts revoke locks cached by another client"
+
+# average service time in usec of the ldlm_enqueue RPCs handled by the MDT
+mdt_enqueue_avg() {
+	do_facet mds1 $LCTL get_param -n mds.MDS.mdt.stats |
+		awk '/^ldlm_enqueue / { printf "%d", $7 / $2 }'
+}
+
+test_103b() {
+	local clients=${CLIENTS:-$HOSTNAME}
+	local count=500
+	local before
+	local after
+
+	test_mkdir -i 0 -c 1 $DIR1/$tdir
+	createmany -o $DIR1/$tdir/f $count || error "createmany failed"
+
+	# open intents with no other lock holder
+	cancel_lru_locks mdc
+	do_facet mds1 $LCTL set_param mds.MDS.mdt.stats=clear > /dev/null
+	cat $DIR1/$tdir/f* > /dev/null || error "cat $DIR1/$tdir failed"
+	before=$(mdt_enqueue_avg)
+
+	# every client and mount hold PR locks on the directory and files
+	cancel_lru_locks mdc
+	do_nodes $clients "ls -l $DIR1/$tdir > /dev/null" ||
+		error "ls -l on $clients failed"
+	ls -l $DIR2/$tdir > /dev/null || error "ls -l $DIR2/$tdir failed"
+	do_facet mds1 $LCTL set_param mds.MDS.mdt.stats=clear > /dev/null
+	cat $DIR1/$tdir/f* > /dev/null || error "cat $DIR1/$tdir failed"
+	after=$(mdt_enqueue_avg)
+
+	echo "ldlm_enqueue: ${before}us alone, ${after}us with lock holders"
+	(( after <= before * 10 + 1000 )) ||
+		error "enqueue latency grew from ${before}us to ${after}us"
+
+	unlinkmany $DIR1/$tdir/f $count || error "unlinkmany failed"
+}
+run_test 103b "IBITS enqueue latency with many lock holders"
+
+test_104() {
+	$LCTL get_param -n osc.$FSNAME-OST0000-osc-*.import |
+		grep -q extent_shrink ||
+		skip "server does not support extent lock shrinking"
+
+	local converts
+
+	$LFS setstripe -c 1 -i 0 $DIR1/$tfile || error "setstripe failed"
+	# the lock of the first mount is expanded to the whole object
+	dd if=/dev/zero of=$DIR1/$tfile bs=1M count=1 conv=notrunc ||
+		error "dd on $DIR1/$tfile failed"
+	do_facet ost1 $LCTL set_param ldlm.services.ldlm_canceld.stats=clear
+
+	# the second mount writes out of what the first mount requested
+	dd if=/dev/zero of=$DIR2/$tfile bs=1M count=1 seek=4 conv=notrunc ||
+		error "dd on $DIR2/$tfile failed"
+	converts=$(do_facet ost1 $LCTL get_param -n \
+		   ldlm.services.ldlm_canceld.stats |
+		   awk '/ldlm_convert/ { print $2 }')
+	(( ${converts:-0} > 0 )) || error "extent lock was not shrunk"
+
+	$CHECKSTAT -s $((5 * 1048576)) $DIR1/$tfile ||
+		error "wrong size of $DIR1/$tfile"
+	$CHECKSTAT -s $((5 * 1048576)) $DIR2/$tfile ||
+		error "wrong size of $DIR2/$tfile"
+}
+run_test 104 "shrink conflicting extent lock instead of cancel"
+
 log "cleanup: ======================================================"
 
 # kill and wait in each test only guarentee script finish, but command in script
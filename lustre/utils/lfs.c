@@ -118,6 +118,8 @@ static int lfs_hsm_cancel(int argc, char **argv);
 static int lfs_swap_layouts(int argc, char **argv);
 static int lfs_mv(int argc, char **argv);
 static int lfs_ladvise(int argc, char **argv);
+static int lfs_heat_get(int argc, char **argv);
+static int lfs_heat_set(int argc, char **argv);
 static int lfs_getsom(int argc, char **argv);
 static int lfs_mirror(int argc, char **argv);
 static int lfs_mirror_list_commands(int argc, char **argv);
@@ -126,6 +128,11 @@ static inline int lfs_mirror_resync(int argc, char **argv);
 static inline int lfs_mirror_verify(int argc, char **argv);
 static inline int lfs_mirror_read(int argc, char **argv);
 static inline int lfs_mirror_write(int argc, char **argv);
+static int lfs_pcc(int argc, char **argv);
+static int lfs_pcc_attach(int argc, char **argv);
+static int lfs_pcc_detach(int argc, char **argv);
+static int lfs_pcc_state(int argc, char **argv);
+static int lfs_pcc_list_commands(int argc, char **argv);
 
 enum setstripe_origin {
 	SO_SETSTRIPE,
@@ -248,14 +255,20 @@ static inline int lfs_mirror_split(int argc, char **argv)
 	"		[--mdt-count|-c stripe_count>\n"		\
 	"		[--mdt-index|-i mdt_index[,mdt_index,...]\n"	\
 	"		[--mdt-hash|-H mdt_hash]\n"			\
-	"		[--default|-D] [--mode|-m mode] <dir>\n"	\
+	"		[--default|-D] [--mode|-m mode]\n"		\
+	"		[--placement|-P placement] <dir>\n"		\
 	"\tstripe_count: stripe count of the striped directory\n"	\
 	"\tmdt_index: MDT index of first stripe\n"			\
 	"\tmdt_hash:  hash type of the striped directory. mdt types:\n"	\
 	"	fnv_1a_64 FNV-1a hash algorithm (default)\n"		\
 	"	all_char  sum of characters % MDT_COUNT (not recommended)\n" \
+	"	jump      jump consistent hash of FNV-1a hash\n"		\
 	"\tdefault_stripe: set default dirstripe of the directory\n"	\
-	"\tmode: the mode of the directory\n"
+	"\tmode: the mode of the directory\n"				\
+	"\tplacement: with --default, MDT of new subdirectories:\n"	\
+	"	parent     the MDT of the parent directory (default)\n"	\
+	"	roundrobin all MDTs in turn\n"				\
+	"	space      weighted by MDT free space and inodes\n"
 
 /**
  * command_t mirror_cmdlist - lfs mirror commands.
@@ -310,6 +323,29 @@ command_t mirror_cmdlist[] = {
 	{ .pc_help = NULL }
 };
 
+/**
+ * command_t pcc_cmdlist - lfs pcc commands.
+ */
+command_t pcc_cmdlist[] = {
+	{ .pc_name = "attach", .pc_func = lfs_pcc_attach,
+	  .pc_help = "Attach file(s) to the PCC dataset of an archive ID.\n"
+		"usage: lfs pcc attach <--id|-i archive_id> <file> ...\n"
+		"\tarchive_id: HSM archive ID of the PCC dataset, the files\n"
+		"\t            must have been archived with it already.\n" },
+	{ .pc_name = "detach", .pc_func = lfs_pcc_detach,
+	  .pc_help = "Detach file(s) from PCC and restore them to Lustre.\n"
+		"usage: lfs pcc detach <file> ...\n" },
+	{ .pc_name = "state", .pc_func = lfs_pcc_state,
+	  .pc_help = "Display the PCC state of file(s).\n"
+		"usage: lfs pcc state <file> ...\n" },
+	{ .pc_name = "list-commands", .pc_func = lfs_pcc_list_commands,
+	  .pc_help = "list commands supported by lfs pcc"},
+	{ .pc_name = "help", .pc_func = Parser_help, .pc_help = "help" },
+	{ .pc_name = "exit", .pc_func = Parser_quit, .pc_help = "quit" },
+	{ .pc_name = "quit", .pc_func = Parser_quit, .pc_help = "quit" },
+	{ .pc_help = NULL }
+};
+
 /* all available commands */
 command_t cmdlist[] = {
 	{"setstripe", lfs_setstripe, 0,
@@ -406,7 +442,8 @@ command_t cmdlist[] = {
          "\t +: used before a value indicates more than requested value\n"
 	 "\thashtype:	hash type of the striped directory.\n"
 	 "\t		fnv_1a_64 FNV-1a hash algorithm\n"
-	 "\t		all_char  sum of characters % MDT_COUNT\n"},
+	 "\t		all_char  sum of characters % MDT_COUNT\n"
+	 "\t		jump      jump consistent hash of FNV-1a hash\n"},
         {"check", lfs_check, 0,
 	 "Display the status of MGTs, MDTs or OSTs (as specified in the command)\n"
 	 "or all the servers (MGTs, MDTs and OSTs).\n"
@@ -486,7 +523,8 @@ command_t cmdlist[] = {
          "usage: ls [OPTION]... [FILE]..."},
         {"changelog", lfs_changelog, 0,
          "Show the metadata changes on an MDT."
-         "\nusage: changelog <mdtname> [startrec [endrec]]"},
+         "\nusage: changelog [--follow] [--type TYPE[,...]] [--uid UID]\n"
+         "                 [--fid FID] <mdtname> [startrec [endrec]]"},
         {"changelog_clear", lfs_changelog_clear, 0,
          "Indicate that old changelog records up to <endrec> are no longer of "
          "interest to consumer <id>, allowing the system to free up space.\n"
@@ -552,6 +590,7 @@ command_t cmdlist[] = {
 	 "\tmdt_hash:	hash type of the striped directory. mdt types:\n"
 	 "			fnv_1a_64 FNV-1a hash algorithm (default)\n"
 	 "			all_char  sum of characters % MDT_COUNT\n"
+	 "			jump      jump consistent hash of FNV-1a hash\n"
 	 "\n"
 	 "migrate file objects from one OST "
 	 "layout\nto another (may be not safe with concurent writes).\n"
@@ -585,6 +624,12 @@ command_t cmdlist[] = {
 	 "               {[--end|-e END[kMGT]] | [--length|-l LENGTH[kMGT]]}\n"
 	 "               {[--mode|-m [READ,WRITE]}\n"
 	 "               <file> ...\n"},
+	{"heat_get", lfs_heat_get, 0,
+	 "Print the heat of a file.\n"
+	 "usage: heat_get <file> ...\n"},
+	{"heat_set", lfs_heat_set, 0,
+	 "Clear the heat of a file or turn heat tracking on/off.\n"
+	 "usage: heat_set [--clear|-c] [--off|-o] [--on|-O] <file> ...\n"},
 	{"mirror", lfs_mirror, mirror_cmdlist,
 	 "lfs commands used to manage files with mirrored components:\n"
 	 "lfs mirror create - create a mirrored file or directory\n"
@@ -594,6 +639,11 @@ command_t cmdlist[] = {
 	 "lfs mirror read   - read a mirror content of a mirrored file\n"
 	 "lfs mirror write  - write to a mirror of a mirrored file\n"
 	 "lfs mirror verify - verify mirrored file(s)\n"},
+	{"pcc", lfs_pcc, pcc_cmdlist,
+	 "lfs commands used to interact with the Persistent Client Cache:\n"
+	 "lfs pcc attach - attach file(s) to the cache on this client\n"
+	 "lfs pcc detach - detach file(s) from the cache\n"
+	 "lfs pcc state  - display the cache state of file(s)\n"},
 	{"getsom", lfs_getsom, 0, "To list the SOM info for a given file.\n"
 	 "usage: getsom [-s] [-b] [-f] <path>\n"
 	 "\t-s: Only show the size value of the SOM data for a given file\n"
@@ -621,6 +671,17 @@ static int check_hashtype(const char *hashtype)
 	return 0;
 }
 
+static int check_placement(const char *placement)
+{
+	int i;
+
+	for (i = LMV_PLACEMENT_PARENT; i < LMV_PLACEMENT_MAX; i++)
+		if (strcmp(placement, lmv_placement_name[i]) == 0)
+			return i;
+
+	return -1;
+}
+
 
 static const char *error_loc = "syserror";
 
@@ -4938,6 +4999,7 @@ static int lfs_setdirstripe(int argc, char **argv)
 	struct ll_statfs_buf	*lsb = NULL;
 	char			mntdir[PATH_MAX] = "";
 	bool			auto_distributed = false;
+	int			placement = -1;
 
 	struct option long_opts[] = {
 	{ .val = 'c',	.name = "count",	.has_arg = required_argument },
@@ -4951,6 +5013,7 @@ static int lfs_setdirstripe(int argc, char **argv)
 	{ .val = 'i',	.name = "index",	.has_arg = required_argument },
 #endif
 	{ .val = 'o',	.name = "mode",		.has_arg = required_argument },
+	{ .val = 'P',	.name = "placement",	.has_arg = required_argument },
 #if LUSTRE_VERSION_CODE < OBD_OCD_VERSION(3, 0, 53, 0)
 	{ .val = 't',	.name = "hash-type",	.has_arg = required_argument },
 #endif
@@ -4960,7 +5023,7 @@ static int lfs_setdirstripe(int argc, char **argv)
 
 	setstripe_args_init(&lsa);
 
-	while ((c = getopt_long(argc, argv, "c:dDi:H:m:o:t:T:", long_opts,
+	while ((c = getopt_long(argc, argv, "c:dDi:H:m:o:P:t:T:", long_opts,
 				NULL)) >= 0) {
 		switch (c) {
 		case 0:
@@ -5026,6 +5089,15 @@ static int lfs_setdirstripe(int argc, char **argv)
 		case 'o':
 			mode_opt = optarg;
 			break;
+		case 'P':
+			placement = check_placement(optarg);
+			if (placement < 0) {
+				fprintf(stderr,
+					"%s %s: bad placement policy '%s'\n",
+					progname, argv[0], optarg);
+				return CMD_HELP;
+			}
+			break;
 		default:
 			fprintf(stderr, "%s %s: unrecognized option '%s'\n",
 				progname, argv[0], argv[optind - 1]);
@@ -5039,8 +5111,15 @@ static int lfs_setdirstripe(int argc, char **argv)
 		return CMD_HELP;
 	}
 
+	if (placement >= 0 && (!default_stripe || delete)) {
+		fprintf(stderr,
+			"%s %s: placement policy is only valid with -D\n",
+			progname, argv[0]);
+		return CMD_HELP;
+	}
+
 	if (!delete && lsa.lsa_stripe_off == LLAPI_LAYOUT_DEFAULT &&
-	    lsa.lsa_stripe_count == LLAPI_LAYOUT_DEFAULT) {
+	    lsa.lsa_stripe_count == LLAPI_LAYOUT_DEFAULT && placement < 0) {
 		fprintf(stderr,
 			"%s %s: stripe offset and count must be specified\n",
 			progname, argv[0]);
@@ -5112,7 +5191,9 @@ static int lfs_setdirstripe(int argc, char **argv)
 	dname = argv[optind];
 	do {
 		if (default_stripe) {
-			result = llapi_dir_set_default_lmv(dname, param);
+			result = llapi_dir_set_default_lmv_placement(dname,
+					param, placement < 0 ?
+					LMV_PLACEMENT_PARENT : placement);
 		} else {
 			/* if current \a dname isn't under the same \a mntdir
 			 * as the last one, and the last one was
@@ -6673,6 +6754,35 @@ static int lfs_ls(int argc, char **argv)
 	return 0;
 }
 
+/**
+ * Convert a comma separated list of changelog record type names
+ * (e.g. "CREAT,UNLNK") into a bitmask of (1 << CL_*).
+ *
+ * \retval 0 on success, -EINVAL if a type name is unknown
+ */
+static int lfs_changelog_str2mask(char *types, __u32 *mask)
+{
+	char *name;
+	int type;
+
+	*mask = 0;
+	while ((name = strsep(&types, ",")) != NULL) {
+		for (type = 0; type < CL_LAST; type++)
+			if (strcasecmp(name, changelog_type2str(type)) == 0)
+				break;
+
+		if (type == CL_LAST) {
+			fprintf(stderr,
+				"%s changelog: unknown record type '%s'\n",
+				progname, name);
+			return -EINVAL;
+		}
+		*mask |= 1U << type;
+	}
+
+	return 0;
+}
+
 static int lfs_changelog(int argc, char **argv)
 {
 	void *changelog_priv;
@@ -6681,8 +6791,17 @@ static int lfs_changelog(int argc, char **argv)
 	char *mdd;
 	struct option long_opts[] = {
 		{ .val = 'f', .name = "follow", .has_arg = no_argument },
+		{ .val = 'F', .name = "fid", .has_arg = required_argument },
+		{ .val = 't', .name = "type", .has_arg = required_argument },
+		{ .val = 'u', .name = "uid", .has_arg = required_argument },
 		{ .name = NULL } };
-	char short_opts[] = "f";
+	char short_opts[] = "fF:t:u:";
+	struct lu_fid filter_fid = { 0 };
+	__u32 filter_mask = 0;
+	uid_t filter_uid = -1;
+	bool filter = false;
+	char *fid_str;
+	char *end;
 	int rc, follow = 0;
 
 	while ((rc = getopt_long(argc, argv, short_opts,
@@ -6691,6 +6810,34 @@ static int lfs_changelog(int argc, char **argv)
                 case 'f':
                         follow++;
                         break;
+		case 'F':
+			fid_str = optarg;
+			if (*fid_str == '[')
+				fid_str++;
+			if (sscanf(fid_str, SFID, RFID(&filter_fid)) != 3 ||
+			    fid_is_zero(&filter_fid)) {
+				fprintf(stderr,
+					"%s changelog: invalid FID '%s'\n",
+					progname, optarg);
+				return CMD_HELP;
+			}
+			filter = true;
+			break;
+		case 't':
+			if (lfs_changelog_str2mask(optarg, &filter_mask) < 0)
+				return CMD_HELP;
+			filter = true;
+			break;
+		case 'u':
+			filter_uid = strtoul(optarg, &end, 0);
+			if (*end != '\0') {
+				fprintf(stderr,
+					"%s changelog: invalid uid '%s'\n",
+					progname, optarg);
+				return CMD_HELP;
+			}
+			filter = true;
+			break;
                 default:
 			fprintf(stderr,
 				"%s changelog: unrecognized option '%s'\n",
@@ -6734,6 +6881,18 @@ static int lfs_changelog(int argc, char **argv)
 		return rc;
 	}
 
+	if (filter) {
+		rc = llapi_changelog_set_filter(changelog_priv, filter_mask,
+						&filter_fid, filter_uid);
+		if (rc < 0) {
+			fprintf(stderr,
+				"%s changelog: cannot set filter: %s\n",
+				progname, strerror(errno = -rc));
+			llapi_changelog_fini(&changelog_priv);
+			return rc;
+		}
+	}
+
 	while ((rc = llapi_changelog_recv(changelog_priv, &rec)) == 0) {
 		time_t secs;
 		struct tm ts;
@@ -7871,6 +8030,126 @@ next:
 	return rc;
 }
 
+static const char *const heat_names[] = LU_HEAT_NAMES;
+
+static int lfs_heat_get(int argc, char **argv)
+{
+	struct lu_heat *heat;
+	int rc = 0, rc2;
+	char *path;
+	int fd;
+	int i;
+
+	if (argc <= 1)
+		return CMD_HELP;
+
+	heat = calloc(sizeof(*heat) + sizeof(__u64) * OBD_HEAT_COUNT, 1);
+	if (!heat) {
+		fprintf(stderr, "%s: memory allocation failed\n", argv[0]);
+		return -ENOMEM;
+	}
+
+	optind = 1;
+	while (optind < argc) {
+		path = argv[optind++];
+
+		fd = open(path, O_RDONLY);
+		if (fd < 0) {
+			fprintf(stderr, "%s: cannot open file '%s': %s\n",
+				argv[0], path, strerror(errno));
+			rc2 = -errno;
+			goto next;
+		}
+
+		heat->lh_count = OBD_HEAT_COUNT;
+		rc2 = llapi_heat_get(fd, heat);
+		close(fd);
+		if (rc2 < 0) {
+			fprintf(stderr, "%s: cannot get heat of file '%s'"
+				": %s\n", argv[0], path, strerror(-rc2));
+			goto next;
+		}
+
+		printf("flags: %x\n", heat->lh_flags);
+		for (i = 0; i < heat->lh_count; i++)
+			printf("%s: %llu\n", heat_names[i],
+			       (unsigned long long)heat->lh_heat[i]);
+next:
+		if (rc == 0 && rc2 < 0)
+			rc = rc2;
+	}
+
+	free(heat);
+	return rc;
+}
+
+static int lfs_heat_set(int argc, char **argv)
+{
+	struct option long_opts[] = {
+	{ .val = 'c',	.name = "clear",	.has_arg = no_argument },
+	{ .val = 'o',	.name = "off",		.has_arg = no_argument },
+	{ .val = 'O',	.name = "on",		.has_arg = no_argument },
+	{ .name = NULL } };
+	enum lu_heat_flag flags = 0;
+	int rc = 0, rc2;
+	char *path;
+	int fd;
+	int c;
+
+	if (argc <= 1)
+		return CMD_HELP;
+
+	optind = 0;
+	while ((c = getopt_long(argc, argv, "coO", long_opts, NULL)) != -1) {
+		switch (c) {
+		case 'c':
+			flags |= LU_HEAT_FLAG_CLEAR;
+			break;
+		case 'o':
+			flags |= LU_HEAT_FLAG_CLEAR;
+			flags |= LU_HEAT_FLAG_OFF;
+			break;
+		case 'O':
+			flags &= ~LU_HEAT_FLAG_OFF;
+			break;
+		default:
+			fprintf(stderr, "%s: unrecognized option '%s'\n",
+				argv[0], argv[optind - 1]);
+			return CMD_HELP;
+		}
+	}
+
+	if (optind >= argc) {
+		fprintf(stderr, "%s: please give one or more file names\n",
+			argv[0]);
+		return CMD_HELP;
+	}
+
+	while (optind < argc) {
+		path = argv[optind++];
+
+		fd = open(path, O_RDONLY);
+		if (fd < 0) {
+			fprintf(stderr, "%s: cannot open file '%s': %s\n",
+				argv[0], path, strerror(errno));
+			rc2 = -errno;
+			goto next;
+		}
+
+		rc2 = llapi_heat_set(fd, flags);
+		close(fd);
+		if (rc2 < 0) {
+			fprintf(stderr, "%s: cannot set heat flags on file '%s'"
+				": %s\n", argv[0], path, strerror(-rc2));
+			goto next;
+		}
+next:
+		if (rc == 0 && rc2 < 0)
+			rc = rc2;
+	}
+	return rc;
+}
+
 /** The input string contains a comma delimited list of component ids and
  * ranges, for example "1,2-4,7".
  */
@@ -9408,6 +9687,150 @@ static int lfs_mirror(int argc, char **argv)
 	return rc < 0 ? -rc : rc;
 }
 
+static int lfs_pcc_attach(int argc, char **argv)
+{
+	struct option long_opts[] = {
+	{ .val = 'i',	.name = "id",	.has_arg = required_argument },
+	{ .name = NULL } };
+	__u32 archive_id = 0;
+	char *end;
+	int rc = 0, rc2;
+	char *path;
+	int c;
+
+	optind = 0;
+	while ((c = getopt_long(argc, argv, "i:", long_opts, NULL)) != -1) {
+		switch (c) {
+		case 'i':
+			errno = 0;
+			archive_id = strtoul(optarg, &end, 0);
+			if (errno != 0 || *end != '\0' || archive_id == 0) {
+				fprintf(stderr, "%s: invalid archive ID '%s'\n",
+					argv[0], optarg);
+				return CMD_HELP;
+			}
+			break;
+		default:
+			fprintf(stderr, "%s: unrecognized option '%s'\n",
+				argv[0], argv[optind - 1]);
+			return CMD_HELP;
+		}
+	}
+
+	if (archive_id == 0) {
+		fprintf(stderr, "%s: must specify an archive ID\n", argv[0]);
+		return CMD_HELP;
+	}
+
+	if (optind >= argc) {
+		fprintf(stderr, "%s: please give one or more file names\n",
+			argv[0]);
+		return CMD_HELP;
+	}
+
+	while (optind < argc) {
+		path = argv[optind++];
+
+		rc2 = llapi_pcc_attach(path, archive_id, LU_PCC_READWRITE);
+		if (rc == 0 && rc2 < 0)
+			rc = rc2;
+	}
+
+	return rc;
+}
+
+static int lfs_pcc_detach(int argc, char **argv)
+{
+	int rc = 0, rc2;
+	char *path;
+
+	if (argc <= 1)
+		return CMD_HELP;
+
+	optind = 1;
+	while (optind < argc) {
+		path = argv[optind++];
+
+		rc2 = llapi_pcc_detach(path);
+		if (rc == 0 && rc2 < 0)
+			rc = rc2;
+	}
+
+	return rc;
+}
+
+static int lfs_pcc_state(int argc, char **argv)
+{
+	struct lu_pcc_state *state;
+	int rc = 0, rc2;
+	char *path;
+
+	if (argc <= 1)
+		return CMD_HELP;
+
+	state = calloc(1, sizeof(*state));
+	if (state == NULL) {
+		fprintf(stderr, "%s: memory allocation failed\n", argv[0]);
+		return -ENOMEM;
+	}
+
+	optind = 1;
+	while (optind < argc) {
+		path = argv[optind++];
+
+		rc2 = llapi_pcc_state_get(path, state);
+		if (rc2 < 0) {
+			fprintf(stderr, "%s: cannot get PCC state of '%s': %s\n",
+				argv[0], path, strerror(-rc2));
+			if (rc == 0)
+				rc = rc2;
+			continue;
+		}
+
+		printf("file: %s", path);
+		printf(", type: %s", pcc_type2string(state->pccs_type));
+		if (state->pccs_type != LU_PCC_NONE) {
+			printf(", archive ID: %u", state->pccs_id);
+			printf(", open count: %u", state->pccs_open_count);
+			printf(", PCC file: %s", state->pccs_path);
+		}
+		printf("\n");
+	}
+
+	free(state);
+	return rc;
+}
+
+/**
+ * lfs_pcc() - Parse and execute lfs pcc commands.
+ * @argc: The count of lfs pcc command line arguments.
+ * @argv: Array of strings for lfs pcc command line arguments.
+ *
+ * This function parses lfs pcc commands and performs the
+ * corresponding functions specified in pcc_cmdlist[].
+ *
+ * Return: 0 on success or an error code on failure.
+ */
+static int lfs_pcc(int argc, char **argv)
+{
+	char cmd[PATH_MAX];
+	int rc = 0;
+
+	setlinebuf(stdout);
+
+	Parser_init("lfs-pcc > ", pcc_cmdlist);
+
+	snprintf(cmd, sizeof(cmd), "%s %s", progname, argv[0]);
+	progname = cmd;
+	program_invocation_short_name = cmd;
+	if (argc > 1)
+		rc = Parser_execarg(argc - 1, argv + 1, pcc_cmdlist);
+	else
+		rc = Parser_commands();
+
+	return rc < 0 ? -rc : rc;
+}
+
 static void lustre_som_swab(struct lustre_som_attrs *attrs)
 {
 #if __BYTE_ORDER == __BIG_ENDIAN
@@ -9515,6 +9938,25 @@ static int lfs_mirror_list_commands(int argc, char **argv)
 	return 0;
 }
 
+/**
+ * lfs_pcc_list_commands() - List lfs pcc commands.
+ * @argc: The count of command line arguments.
+ * @argv: Array of strings for command line arguments.
+ *
+ * This function lists lfs pcc commands defined in pcc_cmdlist[].
+ *
+ * Return: 0 on success.
+ */
+static int lfs_pcc_list_commands(int argc, char **argv)
+{
+	char buffer[81] = "";
+
+	Parser_list_commands(pcc_cmdlist, buffer, sizeof(buffer),
+			     NULL, 0, 4);
+
+	return 0;
+}
+
 static int lfs_list_commands(int argc, char **argv)
 {
 	char buffer[81] = ""; /* 80 printable chars + terminating NUL */
@@ -84,7 +84,12 @@ const char *liblustreapi_cmd;
 
 char *mdt_hash_name[] = { "none",
 			  LMV_HASH_NAME_ALL_CHARS,
-			  LMV_HASH_NAME_FNV_1A_64 };
+			  LMV_HASH_NAME_FNV_1A_64,
+			  LMV_HASH_NAME_JUMP };
+
+char *lmv_placement_name[] = { LMV_PLACEMENT_NAME_PARENT,
+			       LMV_PLACEMENT_NAME_RR,
+			       LMV_PLACEMENT_NAME_SPACE };
 
 void llapi_msg_set_level(int level)
 {
@@ -937,8 +942,20 @@ static inline void param2lmu(struct lmv_user_md *lmu,
 	}
 }
 
-int llapi_dir_set_default_lmv(const char *name,
-			      const struct llapi_stripe_param *param)
+/**
+ * Set the default LMV of a directory, including the MDT placement policy
+ * of the subdirectories created under it.
+ *
+ * \param name      the directory to set the default LMV on
+ * \param param     stripe pattern of the new subdirectories
+ * \param placement enum lmv_placement_policy of the new subdirectories
+ *
+ * \retval          0 on success
+ * \retval          negative errno on failure
+ */
+int llapi_dir_set_default_lmv_placement(const char *name,
+			const struct llapi_stripe_param *param,
+			enum lmv_placement_policy placement)
 {
 	struct lmv_user_md lmu = { 0 };
 	int fd;
@@ -952,7 +969,14 @@ int llapi_dir_set_default_lmv(const char *name,
 	if (param->lsp_is_specific)
 		return -EINVAL;
 
+	if (placement >= LMV_PLACEMENT_MAX) {
+		llapi_err_noerrno(LLAPI_MSG_ERROR,
+				  "invalid placement policy %d", placement);
+		return -EINVAL;
+	}
+
 	param2lmu(&lmu, param);
+	lmu.lum_placement = placement;
 
 	fd = open(name, O_DIRECTORY | O_RDONLY);
 	if (fd < 0) {
@@ -976,6 +1000,13 @@ int llapi_dir_set_default_lmv(const char *name,
 	return rc;
 }
 
+int llapi_dir_set_default_lmv(const char *name,
+			      const struct llapi_stripe_param *param)
+{
+	return llapi_dir_set_default_lmv_placement(name, param,
+						   LMV_PLACEMENT_PARENT);
+}
+
 int llapi_dir_set_default_lmv_stripe(const char *name, int stripe_offset,
 				     int stripe_count, int stripe_pattern,
 				     const char *pool_name)
@@ -2862,6 +2893,13 @@ void lmv_dump_user_lmm(struct lmv_user_md *lum, char *pool_name,
 			llapi_printf(LLAPI_MSG_NORMAL, ",bad_type");
 		if (flags & LMV_HASH_FLAG_LOST_LMV)
 			llapi_printf(LLAPI_MSG_NORMAL, ",lost_lmv");
+		if (lum->lum_magic == LMV_USER_MAGIC &&
+		    lum->lum_placement != LMV_PLACEMENT_PARENT &&
+		    lum->lum_placement < LMV_PLACEMENT_MAX &&
+		    verbose & ~VERBOSE_HASH_TYPE)
+			llapi_printf(LLAPI_MSG_NORMAL, "%slmv_placement: %s",
+				     yaml ? "\n" : " ",
+				     lmv_placement_name[lum->lum_placement]);
 		separator = "\n";
 
 	}
@@ -5611,3 +5649,45 @@ int llapi_group_unlock(int fd, int gid)
 	}
 	return rc;
 }
+
+/**
+ * Get the heat of a file.
+ *
+ * \param fd   File to get heat of.
+ * \param heat Buffer holding lh_count values, filled on return.
+ *
+ * \retval 0 on success.
+ * \retval -errno on failure.
+ */
+int llapi_heat_get(int fd, struct lu_heat *heat)
+{
+	int rc;
+
+	rc = ioctl(fd, LL_IOC_HEAT_GET, heat);
+	if (rc < 0) {
+		rc = -errno;
+		llapi_error(LLAPI_MSG_ERROR, rc, "cannot get heat");
+	}
+	return rc;
+}
+
+/**
+ * Clear the heat of a file, or turn heat tracking of it on or off.
+ *
+ * \param fd    File to set heat flags on.
+ * \param flags Flags from enum lu_heat_flag.
+ *
+ * \retval 0 on success.
+ * \retval -errno on failure.
+ */
+int llapi_heat_set(int fd, __u64 flags)
+{
+	int rc;
+
+	rc = ioctl(fd, LL_IOC_HEAT_SET, &flags);
+	if (rc < 0) {
+		rc = -errno;
+		llapi_error(LLAPI_MSG_ERROR, rc, "cannot set heat flags");
+	}
+	return rc;
+}
@@ -28,6 +28,7 @@
  */
 
 #include <fcntl.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -112,8 +113,11 @@ int llapi_changelog_start(void **priv, enum changelog_send_flag flags,
 	cp->clp_buf_len = 0;
 	cp->clp_buf_pos = cp->clp_buf;
 
-	/* Set up the receiver */
-	cp->clp_fd = open(cdev_path, O_RDONLY);
+	/* Set up the receiver, writable so that a record filter can be
+	 * installed, see llapi_changelog_set_filter() */
+	cp->clp_fd = open(cdev_path, O_RDWR);
+	if (cp->clp_fd < 0 && (errno == EACCES || errno == EPERM))
+		cp->clp_fd = open(cdev_path, O_RDONLY);
 	if (cp->clp_fd < 0) {
 		rc = -errno;
 		goto out_free_cp;
@@ -371,3 +375,65 @@ int llapi_changelog_set_xflags(void *priv,
 
 	return 0;
 }
+
+static int chlg_filter_cmd(struct changelog_private *cp, const char *fmt, ...)
+{
+	char cmd[64];
+	va_list ap;
+	int rc;
+
+	va_start(ap, fmt);
+	rc = vsnprintf(cmd, sizeof(cmd), fmt, ap);
+	va_end(ap);
+	if (rc >= sizeof(cmd))
+		return -EINVAL;
+
+	if (write(cp->clp_fd, cmd, rc + 1) < 0) {
+		rc = -errno;
+		llapi_error(LLAPI_MSG_ERROR, rc,
+			    "cannot set changelog filter '%s'", cmd);
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Only receive the changelog records matching a filter. Records are
+ * filtered by the MDT when it supports it (chlg_filter connect flag), so
+ * uninteresting records are not even transferred to the client; otherwise
+ * they are filtered by the client kernel before being copied to userspace.
+ *
+ * @param priv		Opaque private control structure
+ * @param type_mask	Accepted record types (1 << CL_*), 0 for all types
+ * @param fid		Only records targeting or referencing this FID,
+ *			NULL for all FIDs
+ * @param uid		Only records issued by this user, (uid_t)-1 for all
+ *			users
+ *
+ * Records without user information are not filtered out by \a uid.
+ * Calling this again replaces the previous filter. Records already received
+ * through llapi_changelog_recv() are not affected. Records skipped by a
+ * filter cannot be received anymore, so once the filter may have skipped
+ * records, this fails with -EBUSY.
+ */
+int llapi_changelog_set_filter(void *priv, __u32 type_mask,
+			       const struct lu_fid *fid, uid_t uid)
+{
+	struct changelog_private *cp = priv;
+	int rc;
+
+	if (!cp || cp->clp_magic != CHANGELOG_PRIV_MAGIC)
+		return -EINVAL;
+
+	rc = chlg_filter_cmd(cp, "filter:clear");
+	if (rc == 0 && type_mask != 0)
+		rc = chlg_filter_cmd(cp, "filter:mask:%x", type_mask);
+	if (rc == 0 && fid != NULL && !fid_is_zero(fid))
+		rc = chlg_filter_cmd(cp, "filter:fid:"DFID_NOBRACE,
+				     PFID(fid));
+	if (rc == 0 && uid != (uid_t)-1)
+		rc = chlg_filter_cmd(cp, "filter:uid:%u", uid);
+
+	return rc;
+}
@@ -0,0 +1,177 @@
+/*
+ * LGPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the GNU Lesser General Public License
+ * (LGPL) version 2.1 or (at your discretion) any later version.
+ * (LGPL) version 2.1 accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/lgpl-2.1.html
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * LGPL HEADER END
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/utils/liblustreapi_pcc.c
+ *
+ * lustreapi library for the Persistent Client Cache
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+
+#include <lustre/lustreapi.h>
+#include "lustreapi_internal.h"
+
+/**
+ * Attach the file \a path to the PCC dataset of HSM archive \a archive_id on
+ * this client. The file must have been archived to the dataset already.
+ *
+ * \param path		Lustre file to attach
+ * \param archive_id	archive ID of the PCC dataset
+ * \param type		PCC type, LU_PCC_READWRITE only for now
+ *
+ * \retval 0 on success.
+ * \retval -errno on error.
+ */
+int llapi_pcc_attach(const char *path, __u32 archive_id, enum lu_pcc_type type)
+{
+	struct lu_pcc_attach attach;
+	int fd;
+	int rc;
+
+	if (archive_id == 0)
+		return -EINVAL;
+
+	attach.pcca_type = type;
+	attach.pcca_id = archive_id;
+
+	/* The HSM release done on attach needs a write open */
+	fd = open(path, O_RDWR | O_NONBLOCK);
+	if (fd < 0) {
+		rc = -errno;
+		llapi_error(LLAPI_MSG_ERROR, rc, "cannot open '%s'", path);
+		return rc;
+	}
+
+	rc = ioctl(fd, LL_IOC_PCC_ATTACH, &attach);
+	if (rc < 0) {
+		rc = -errno;
+		llapi_error(LLAPI_MSG_ERROR, rc,
+			    "cannot attach '%s' to PCC archive %u",
+			    path, archive_id);
+	}
+
+	close(fd);
+	return rc;
+}
+
+/**
+ * Detach the file \a path from PCC, and restore its data back into Lustre
+ * from the cached copy if it is still released.
+ *
+ * \param path		Lustre file to detach
+ *
+ * \retval 0 on success, the restore may still be in progress then.
+ * \retval -errno on error.
+ */
+int llapi_pcc_detach(const char *path)
+{
+	struct hsm_user_request *hur;
+	struct hsm_user_state hus;
+	struct lu_fid fid;
+	int fd;
+	int rc;
+
+	fd = open(path, O_RDONLY | O_NONBLOCK);
+	if (fd < 0) {
+		rc = -errno;
+		llapi_error(LLAPI_MSG_ERROR, rc, "cannot open '%s'", path);
+		return rc;
+	}
+
+	/* The file may have been detached already, by a restore */
+	rc = ioctl(fd, LL_IOC_PCC_DETACH);
+	if (rc < 0 && errno != ENODATA) {
+		rc = -errno;
+		llapi_error(LLAPI_MSG_ERROR, rc, "cannot detach '%s'", path);
+		goto out_close;
+	}
+
+	rc = llapi_hsm_state_get_fd(fd, &hus);
+	if (rc < 0) {
+		llapi_error(LLAPI_MSG_ERROR, rc,
+			    "cannot get HSM state of '%s'", path);
+		goto out_close;
+	}
+
+	if (!(hus.hus_states & HS_RELEASED))
+		goto out_close;
+
+	rc = llapi_fd2fid(fd, &fid);
+	if (rc < 0)
+		goto out_close;
+
+	hur = llapi_hsm_user_request_alloc(1, 0);
+	if (hur == NULL) {
+		rc = -ENOMEM;
+		goto out_close;
+	}
+
+	hur->hur_request.hr_action = HUA_RESTORE;
+	hur->hur_request.hr_archive_id = hus.hus_archive_id;
+	hur->hur_request.hr_flags = 0;
+	hur->hur_request.hr_itemcount = 1;
+	hur->hur_request.hr_data_len = 0;
+	hur->hur_user_item[0].hui_extent.offset = 0;
+	hur->hur_user_item[0].hui_extent.length = -1;
+	hur->hur_user_item[0].hui_fid = fid;
+
+	rc = llapi_hsm_request(path, hur);
+	if (rc < 0)
+		llapi_error(LLAPI_MSG_ERROR, rc,
+			    "cannot restore '%s' from PCC", path);
+	free(hur);
+
+out_close:
+	close(fd);
+	return rc;
+}
+
+/**
+ * Return the PCC state of the file \a path on this client.
+ *
+ * \param path		Lustre file
+ * \param state		filled with the PCC state, pccs_type is LU_PCC_NONE
+ *			if the file is not attached
+ *
+ * \retval 0 on success.
+ * \retval -errno on error.
+ */
+int llapi_pcc_state_get(const char *path, struct lu_pcc_state *state)
+{
+	int fd;
+	int rc;
+
+	fd = open(path, O_RDONLY | O_NONBLOCK);
+	if (fd < 0)
+		return -errno;
+
+	rc = ioctl(fd, LL_IOC_PCC_STATE, state);
+	/* If error, save errno value */
+	rc = rc ? -errno : 0;
+
+	close(fd);
+	return rc;
+}
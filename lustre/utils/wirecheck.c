@@ -519,7 +519,7 @@ check_obd_connect_data(void)
 	CHECK_MEMBER(obd_connect_data, ocd_instance);
 	CHECK_MEMBER(obd_connect_data, ocd_maxbytes);
 	CHECK_MEMBER(obd_connect_data, ocd_maxmodrpcs);
-	CHECK_MEMBER(obd_connect_data, padding0);
+	CHECK_MEMBER(obd_connect_data, ocd_compr_types);
 	CHECK_MEMBER(obd_connect_data, padding1);
 	CHECK_MEMBER(obd_connect_data, ocd_connect_flags2);
 	CHECK_MEMBER(obd_connect_data, padding3);
@@ -606,6 +606,13 @@ check_obd_connect_data(void)
 	CHECK_DEFINE_64X(OBD_CONNECT2_LOCK_CONVERT);
 	CHECK_DEFINE_64X(OBD_CONNECT2_ARCHIVE_ID_ARRAY);
 	CHECK_DEFINE_64X(OBD_CONNECT2_SELINUX_POLICY);
+	CHECK_DEFINE_64X(OBD_CONNECT2_COMPRESS);
+	CHECK_DEFINE_64X(OBD_CONNECT2_BATCH_RPC);
+	CHECK_DEFINE_64X(OBD_CONNECT2_BATCH_BL_AST);
+	CHECK_DEFINE_64X(OBD_CONNECT2_EXTENT_SHRINK);
+	CHECK_DEFINE_64X(OBD_CONNECT2_DIR_PLACEMENT);
+	CHECK_DEFINE_64X(OBD_CONNECT2_JUMP_HASH);
+	CHECK_DEFINE_64X(OBD_CONNECT2_CHLG_FILTER);
 
 	CHECK_VALUE_X(OBD_CKSUM_CRC32);
 	CHECK_VALUE_X(OBD_CKSUM_ADLER);
@@ -616,6 +623,9 @@ check_obd_connect_data(void)
 	CHECK_VALUE_X(OBD_CKSUM_T10CRC512);
 	CHECK_VALUE_X(OBD_CKSUM_T10CRC4K);
 	CHECK_VALUE_X(OBD_CKSUM_T10_TOP);
+	CHECK_VALUE_X(OBD_COMPR_LZ4);
+	CHECK_VALUE_X(OBD_COMPR_LZO);
+	CHECK_VALUE_X(OBD_COMPR_DEFLATE);
 }
 
 static void
@@ -662,7 +672,8 @@ check_obdo(void)
 	CHECK_MEMBER(obdo, o_gid_h);
 	CHECK_MEMBER(obdo, o_data_version);
 	CHECK_MEMBER(obdo, o_projid);
-	CHECK_MEMBER(obdo, o_padding_4);
+	CHECK_MEMBER(obdo, o_falloc_mode);
+	CHECK_MEMBER(obdo, o_compr_size);
 	CHECK_MEMBER(obdo, o_padding_5);
 	CHECK_MEMBER(obdo, o_padding_6);
 
@@ -732,6 +743,9 @@ check_obdo(void)
 	CHECK_CVALUE_X(OBD_FL_NOSPC_BLK);
 	CHECK_CVALUE_X(OBD_FL_FLUSH);
 	CHECK_CVALUE_X(OBD_FL_SHORT_IO);
+	CHECK_CVALUE_X(OBD_FL_COMPR_LZ4);
+	CHECK_CVALUE_X(OBD_FL_COMPR_LZO);
+	CHECK_CVALUE_X(OBD_FL_COMPR_DEFLATE);
 }
 
 static void
@@ -1014,6 +1028,19 @@ check_niobuf_remote(void)
 	CHECK_DEFINE_X(OBD_BRW_SOFT_SYNC);
 }
 
+static void
+check_brw_compr_chunk(void)
+{
+	BLANK_LINE();
+	CHECK_STRUCT(brw_compr_chunk);
+	CHECK_MEMBER(brw_compr_chunk, bcc_magic);
+	CHECK_MEMBER(brw_compr_chunk, bcc_raw_len);
+	CHECK_MEMBER(brw_compr_chunk, bcc_len);
+	CHECK_MEMBER(brw_compr_chunk, bcc_padding);
+
+	CHECK_DEFINE_X(BRW_COMPR_MAGIC);
+}
+
 static void
 check_ost_body(void)
 {
@@ -1880,6 +1907,20 @@ check_llogd_body(void)
 	CHECK_CVALUE(LLOG_MAX_CTXTS);
 }
 
+static void
+check_llogd_chlg_filter(void)
+{
+	BLANK_LINE();
+	CHECK_STRUCT(llogd_chlg_filter);
+	CHECK_MEMBER(llogd_chlg_filter, lcf_type_mask);
+	CHECK_MEMBER(llogd_chlg_filter, lcf_flags);
+	CHECK_MEMBER(llogd_chlg_filter, lcf_uid);
+	CHECK_MEMBER(llogd_chlg_filter, lcf_padding);
+	CHECK_MEMBER(llogd_chlg_filter, lcf_fid);
+
+	CHECK_VALUE_X(LCF_UID);
+}
+
 static void
 check_llogd_conn_body(void)
 {
@@ -2365,6 +2406,24 @@ static void check_out_update_buffer(void)
 	CHECK_MEMBER(out_update_buffer, oub_padding);
 }
 
+static void check_batch_update_header(void)
+{
+	BLANK_LINE();
+	CHECK_STRUCT(batch_update_header);
+	CHECK_MEMBER(batch_update_header, buh_magic);
+	CHECK_MEMBER(batch_update_header, buh_count);
+	CHECK_MEMBER(batch_update_header, buh_reply_size);
+	CHECK_MEMBER(batch_update_header, buh_padding);
+}
+
+static void check_batch_update_buffer(void)
+{
+	BLANK_LINE();
+	CHECK_STRUCT(batch_update_buffer);
+	CHECK_MEMBER(batch_update_buffer, bub_size);
+	CHECK_MEMBER(batch_update_buffer, bub_rc);
+}
+
 static void check_nodemap_cluster_rec(void)
 {
 	BLANK_LINE();
@@ -2633,6 +2692,7 @@ main(int argc, char **argv)
 	CHECK_VALUE(OST_QUOTACTL);
 	CHECK_VALUE(OST_QUOTA_ADJUST_QUNIT);
 	CHECK_VALUE(OST_LADVISE);
+	CHECK_VALUE(OST_FALLOCATE);
 	CHECK_VALUE(OST_LAST_OPC);
 
 	CHECK_DEFINE_64X(OBD_OBJECT_EOF);
@@ -2673,6 +2733,7 @@ main(int argc, char **argv)
 	CHECK_VALUE(MDS_HSM_CT_REGISTER);
 	CHECK_VALUE(MDS_HSM_CT_UNREGISTER);
 	CHECK_VALUE(MDS_SWAP_LAYOUTS);
+	CHECK_VALUE(MDS_BATCH);
 	CHECK_VALUE(MDS_LAST_OPC);
 
 	CHECK_VALUE(REINT_SETATTR);
@@ -2854,6 +2915,7 @@ main(int argc, char **argv)
 	check_obd_quotactl();
 	check_obd_idx_read();
 	check_niobuf_remote();
+	check_brw_compr_chunk();
 	check_ost_body();
 	check_ll_fid();
 	check_mds_op_bias();
@@ -2907,6 +2969,7 @@ main(int argc, char **argv)
 	check_llog_gen_rec();
 	check_llog_log_hdr();
 	check_llogd_body();
+	check_llogd_chlg_filter();
 	check_llogd_conn_body();
 	check_ll_fiemap_info_key();
 	check_quota_body();
@@ -2944,6 +3007,8 @@ main(int argc, char **argv)
 	check_object_update_reply();
 	check_out_update_header();
 	check_out_update_buffer();
+	check_batch_update_header();
+	check_batch_update_buffer();
 
 	check_nodemap_cluster_rec();
 	check_nodemap_range_rec();